@@ -0,0 +1,312 @@
+/*=========================================================================
+
+  Program:   Visualization Toolkit
+  Module:    vtkNIfTIGzipIndex.cxx
+
+  Copyright (c) Ken Martin, Will Schroeder, Bill Lorensen
+  All rights reserved.
+  See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+#include "vtkNIfTIGzipIndex.h"
+
+#include "vtkSMPTools.h"
+#include "vtk_zlib.h"
+
+#include "vtksys/FStream.hxx"
+#include "vtksys/SystemTools.hxx"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+namespace
+{
+// Position a raw inflate stream on a checkpoint: the deflate block starts
+// bits bits before the byte at in, and window is the output preceding it.
+bool ResumeAt(istream& file, z_stream& strm, vtkTypeInt64 in, int bits,
+  const std::vector<unsigned char>& window)
+{
+  file.seekg(in - (bits ? 1 : 0), ios::beg);
+  if (bits)
+  {
+    const int byte = file.get();
+    if (byte == EOF)
+    {
+      return false;
+    }
+    inflatePrime(&strm, bits, byte >> (8 - bits));
+  }
+  return inflateSetDictionary(&strm, window.data(), vtkNIfTIGzipIndex::WindowSize) == Z_OK;
+}
+}
+
+//----------------------------------------------------------------------------
+bool vtkNIfTIGzipIndex::Read(
+  const std::string& fileName, vtkTypeInt64 offset, size_t size, unsigned char* buffer)
+{
+  if (!this->Matches(fileName))
+  {
+    this->Reset(fileName);
+  }
+  const vtkTypeInt64 end = offset + static_cast<vtkTypeInt64>(size);
+
+  // Extending the index inflates everything past its last checkpoint, and
+  // copies the part of the range there along the way.
+  vtkTypeInt64 indexed = end;
+  if (end > this->Decoded)
+  {
+    indexed = this->Checkpoints.empty() ? 0 : this->Checkpoints.back().Out;
+    if (this->Complete || !this->Extend(offset, end, buffer))
+    {
+      return false;
+    }
+  }
+  const vtkTypeInt64 last = std::min(end, indexed);
+  if (offset >= last)
+  {
+    return true;
+  }
+  if (this->Checkpoints.empty())
+  {
+    return false;
+  }
+
+  // The rest is decoded from the last checkpoint before offset up to the
+  // first one past the range, inflating the spans between them concurrently.
+  auto first = std::upper_bound(this->Checkpoints.begin(), this->Checkpoints.end(), offset,
+                 [](vtkTypeInt64 out, const Checkpoint& point) { return out < point.Out; }) -
+    1;
+  auto past = std::lower_bound(this->Checkpoints.begin(), this->Checkpoints.end(), last,
+    [](const Checkpoint& point, vtkTypeInt64 out) { return point.Out < out; });
+  const vtkIdType numSpans = static_cast<vtkIdType>(past - first);
+
+  std::atomic<bool> ok(true);
+  vtkSMPTools::For(0, numSpans, 1, [&](vtkIdType begin, vtkIdType spanEnd) {
+    for (vtkIdType span = begin; span < spanEnd && ok; ++span)
+    {
+      const Checkpoint& point = *(first + span);
+      const vtkTypeInt64 lo = std::max(point.Out, offset);
+      const vtkTypeInt64 hi = (first + span + 1 == this->Checkpoints.end())
+        ? last
+        : std::min((first + span + 1)->Out, last);
+      if (!this->Extract(point, lo, buffer + (lo - offset), static_cast<size_t>(hi - lo)))
+      {
+        ok = false;
+      }
+    }
+  });
+  return ok;
+}
+
+//----------------------------------------------------------------------------
+bool vtkNIfTIGzipIndex::Matches(const std::string& fileName) const
+{
+  return fileName == this->FileName &&
+    vtksys::SystemTools::FileLength(fileName) == this->FileLength &&
+    vtksys::SystemTools::ModifiedTime(fileName) == this->ModifiedTime;
+}
+
+//----------------------------------------------------------------------------
+void vtkNIfTIGzipIndex::Reset(const std::string& fileName)
+{
+  this->FileName = fileName;
+  this->FileLength = vtksys::SystemTools::FileLength(fileName);
+  this->ModifiedTime = vtksys::SystemTools::ModifiedTime(fileName);
+  this->Decoded = 0;
+  this->Complete = false;
+  this->Checkpoints.clear();
+}
+
+//----------------------------------------------------------------------------
+// Inflate from the last checkpoint, or from the start of the file, up to
+// end, recording checkpoints, and copy the uncompressed bytes of
+// [offset, end) inflated along the way into buffer.
+bool vtkNIfTIGzipIndex::Extend(vtkTypeInt64 offset, vtkTypeInt64 end, unsigned char* buffer)
+{
+  vtksys::ifstream in(this->FileName.c_str(), ios::in | ios::binary);
+  if (!in)
+  {
+    return false;
+  }
+
+  z_stream strm;
+  memset(&strm, 0, sizeof(strm));
+  const bool resume = !this->Checkpoints.empty();
+  // 47: detect gzip or zlib headers, with a 32 KiB window. A checkpoint is
+  // in the middle of the raw deflate data.
+  if (inflateInit2(&strm, resume ? -15 : 47) != Z_OK)
+  {
+    return false;
+  }
+  vtkTypeInt64 totalIn = 0;
+  vtkTypeInt64 totalOut = 0;
+  if (resume)
+  {
+    const Checkpoint& point = this->Checkpoints.back();
+    if (!ResumeAt(in, strm, point.In, point.Bits, point.Window))
+    {
+      inflateEnd(&strm);
+      return false;
+    }
+    totalIn = point.In;
+    totalOut = point.Out;
+  }
+
+  std::vector<unsigned char> input(1 << 16);
+  std::vector<unsigned char> window(WindowSize);
+  vtkTypeInt64 last = totalOut;
+  int ret = Z_OK;
+  strm.avail_out = 0;
+  do
+  {
+    in.read(reinterpret_cast<char*>(input.data()), input.size());
+    strm.avail_in = static_cast<uInt>(in.gcount());
+    strm.next_in = input.data();
+    if (strm.avail_in == 0)
+    {
+      ret = Z_DATA_ERROR; // truncated
+      break;
+    }
+    do
+    {
+      // The output goes round the window, which always holds the last
+      // 32 KiB of uncompressed data.
+      if (strm.avail_out == 0)
+      {
+        strm.avail_out = WindowSize;
+        strm.next_out = window.data();
+      }
+      unsigned char* produced = strm.next_out;
+      const vtkTypeInt64 outStart = totalOut;
+      totalIn += strm.avail_in;
+      totalOut += strm.avail_out;
+      ret = inflate(&strm, Z_BLOCK);
+      totalIn -= strm.avail_in;
+      totalOut -= strm.avail_out;
+      if (ret == Z_NEED_DICT || ret == Z_MEM_ERROR || ret == Z_DATA_ERROR)
+      {
+        ret = Z_DATA_ERROR;
+        break;
+      }
+
+      // Copy the requested part of what was just inflated.
+      const vtkTypeInt64 lo = std::max(outStart, offset);
+      const vtkTypeInt64 hi = std::min(totalOut, end);
+      if (lo < hi)
+      {
+        memcpy(buffer + (lo - offset), produced + (lo - outStart), static_cast<size_t>(hi - lo));
+      }
+
+      if (ret == Z_STREAM_END)
+      {
+        break;
+      }
+      // At the end of a deflate block (bit 7), unless it was the last
+      // one (bit 6), record a checkpoint if far enough from the last one.
+      if ((strm.data_type & 128) && !(strm.data_type & 64) &&
+        (this->Checkpoints.empty() || totalOut - last > CheckpointSpan))
+      {
+        this->AddCheckpoint(strm.data_type & 7, totalIn, totalOut, strm.avail_out, window);
+        last = totalOut;
+      }
+    } while (strm.avail_in != 0 && totalOut < end);
+  } while (ret != Z_STREAM_END && ret != Z_DATA_ERROR && totalOut < end);
+  inflateEnd(&strm);
+
+  // Anything past the end of the first member, such as concatenated gzip
+  // members, is not indexed.
+  this->Decoded = std::max(this->Decoded, totalOut);
+  this->Complete = ret == Z_STREAM_END;
+  return totalOut >= end;
+}
+
+//----------------------------------------------------------------------------
+void vtkNIfTIGzipIndex::AddCheckpoint(int bits, vtkTypeInt64 in, vtkTypeInt64 out,
+  unsigned int left, const std::vector<unsigned char>& window)
+{
+  Checkpoint point;
+  point.Out = out;
+  point.In = in;
+  point.Bits = bits;
+  // Unroll the circular window, oldest bytes first.
+  point.Window.resize(WindowSize);
+  if (left)
+  {
+    memcpy(point.Window.data(), window.data() + WindowSize - left, left);
+  }
+  if (left < WindowSize)
+  {
+    memcpy(point.Window.data() + left, window.data(), WindowSize - left);
+  }
+  this->Checkpoints.push_back(std::move(point));
+}
+
+//----------------------------------------------------------------------------
+// Inflate from point up to out + size, keeping the last size bytes.
+bool vtkNIfTIGzipIndex::Extract(
+  const Checkpoint& point, vtkTypeInt64 out, unsigned char* buffer, size_t size) const
+{
+  vtksys::ifstream in(this->FileName.c_str(), ios::in | ios::binary);
+  z_stream strm;
+  memset(&strm, 0, sizeof(strm));
+  if (!in || inflateInit2(&strm, -15) != Z_OK) // raw deflate
+  {
+    return false;
+  }
+  if (!ResumeAt(in, strm, point.In, point.Bits, point.Window))
+  {
+    inflateEnd(&strm);
+    return false;
+  }
+
+  std::vector<unsigned char> input(1 << 16);
+  std::vector<unsigned char> discard(WindowSize);
+  vtkTypeInt64 skip = out - point.Out;
+  int ret = Z_OK;
+  while (size > 0 && ret == Z_OK)
+  {
+    if (strm.avail_in == 0)
+    {
+      in.read(reinterpret_cast<char*>(input.data()), input.size());
+      strm.avail_in = static_cast<uInt>(in.gcount());
+      strm.next_in = input.data();
+      if (strm.avail_in == 0)
+      {
+        break;
+      }
+    }
+    // Skip the output before the range, then inflate straight into buffer.
+    const bool skipping = skip > 0;
+    const vtkTypeInt64 windowSize = WindowSize;
+    const size_t want = skipping ? static_cast<size_t>(std::min(skip, windowSize))
+                                 : std::min<size_t>(size, 1u << 30);
+    strm.next_out = skipping ? discard.data() : buffer;
+    strm.avail_out = static_cast<uInt>(want);
+    ret = inflate(&strm, Z_NO_FLUSH);
+    const size_t produced = want - strm.avail_out;
+    if (skipping)
+    {
+      skip -= produced;
+    }
+    else
+    {
+      buffer += produced;
+      size -= produced;
+    }
+    if (ret == Z_STREAM_END && size > 0)
+    {
+      break;
+    }
+    if (ret == Z_STREAM_END)
+    {
+      ret = Z_OK;
+    }
+  }
+  inflateEnd(&strm);
+  return size == 0;
+}
@@ -0,0 +1,86 @@
+/*=========================================================================
+
+  Program:   Visualization Toolkit
+  Module:    vtkNIfTIGzipIndex.h
+
+  Copyright (c) Ken Martin, Will Schroeder, Bill Lorensen
+  All rights reserved.
+  See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// .NAME vtkNIfTIGzipIndex - random access into a gzip compressed image
+// .SECTION Description
+// As in zlib's examples/zran.c, inflating the file records a checkpoint about
+// every CheckpointSpan bytes of output, at the start of a deflate block. A
+// checkpoint holds the position of that block in the file and the 32 KiB of
+// output preceding it, which is all inflate needs to resume there. A range
+// of the uncompressed data is then decoded from the checkpoints that cover
+// it, each independently.
+//
+// The index is built lazily: a read only inflates the file up to the end of
+// its range, and a later read past that resumes from the last checkpoint.
+// Only the first member of a gzip file is indexed; reads past it fail, as
+// do reads past the end of a truncated file.
+//
+// .SECTION See Also
+// vtkNIfTIReader
+
+#ifndef vtkNIfTIGzipIndex_h
+#define vtkNIfTIGzipIndex_h
+
+#include "vtkAnalyzeNIfTIIOModule.h"
+#include "vtkType.h"
+
+#include <string>
+#include <vector>
+
+class VTKANALYZENIFTIIO_EXPORT vtkNIfTIGzipIndex
+{
+public:
+  static const int WindowSize = 32768;
+  static const vtkTypeInt64 CheckpointSpan = 4 << 20;
+
+  // Description:
+  // Decode the uncompressed bytes [offset, offset + size) of fileName into
+  // buffer, first extending the index as far as the range needs. The index
+  // is dropped when fileName is another file, or the file changed.
+  bool Read(const std::string& fileName, vtkTypeInt64 offset, size_t size, unsigned char* buffer);
+
+  // Description:
+  // Number of checkpoints recorded so far.
+  size_t GetNumberOfCheckpoints() const { return this->Checkpoints.size(); }
+
+  // Description:
+  // Uncompressed offset of a checkpoint.
+  vtkTypeInt64 GetCheckpointOffset(size_t point) const { return this->Checkpoints[point].Out; }
+
+private:
+  struct Checkpoint
+  {
+    vtkTypeInt64 Out; // uncompressed offset
+    vtkTypeInt64 In;  // compressed offset of the first full byte
+    int Bits;         // number of bits of the block in the byte before In
+    std::vector<unsigned char> Window;
+  };
+
+  bool Matches(const std::string& fileName) const;
+  void Reset(const std::string& fileName);
+  bool Extend(vtkTypeInt64 offset, vtkTypeInt64 end, unsigned char* buffer);
+  void AddCheckpoint(int bits, vtkTypeInt64 in, vtkTypeInt64 out, unsigned int left,
+    const std::vector<unsigned char>& window);
+  bool Extract(const Checkpoint& point, vtkTypeInt64 out, unsigned char* buffer, size_t size) const;
+
+  std::string FileName;
+  unsigned long FileLength = 0;
+  long ModifiedTime = 0;
+  // Uncompressed bytes inflated so far, all of which the checkpoints cover.
+  vtkTypeInt64 Decoded = 0;
+  // Whether the end of the (first) gzip member was reached.
+  bool Complete = false;
+  std::vector<Checkpoint> Checkpoints;
+};
+#endif
@@ -18,12 +18,14 @@
 #include "vtkDoubleArray.h"
 #include "vtkImageData.h"
 #include "vtkLookupTable.h"
+#include "vtkNIfTIGzipIndex.h"
 #include "vtkObjectFactory.h"
 #include "vtkPointData.h"
 #include "vtk_zlib.h"
 #include "vtknifti1.h"
 #include "vtknifti1_io.h"
 #include "vtkznzlib.h"
+#include <algorithm>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string>
@@ -33,6 +35,7 @@
 #define DEFAULT_NAME ""
 
 #include "vtksys/FStream.hxx"
+#include "vtksys/SystemTools.hxx"
 
 vtkStandardNewMacro(vtkNIfTIReader);
 
@@ -51,6 +54,7 @@ vtkNIfTIReader::vtkNIfTIReader()
   this->niftiHeaderUnsignedCharArray = 0;
   this->niftiHeaderSize = 348;
   this->niftiType = 0;
+  this->GzipIndex = new vtkNIfTIGzipIndex;
 }
 
 //----------------------------------------------------------------------------
@@ -78,6 +82,7 @@ vtkNIfTIReader::~vtkNIfTIReader()
     delete this->niftiHeaderUnsignedCharArray;
     this->niftiHeaderUnsignedCharArray = 0;
   }
+  delete this->GzipIndex;
 }
 
 // GetExtension from uiig library.
@@ -639,56 +644,41 @@ void vtkNIfTIReader::ExecuteInformation()
 }
 
 //----------------------------------------------------------------------------
-// This function reads in one data of data.
-// templated to handle different data types.
-template <class OT>
-void vtkNIfTIReaderUpdate2(
-  vtkNIfTIReader* self, vtkImageData* vtkNotUsed(data), OT* outPtr, long offset)
+bool vtkNIfTIReader::ReadImage(const std::string& fileName, long offset, void* buffer, size_t size)
 {
-  // unsigned int dim;
-  // char * const p = static_cast<char *>(outPtr);
-  char* p = (char*)(outPtr);
-  // 4 cases to handle
-  // 1: given .hdr and image is .img
-  // 2: given .nii
-  // 3: given .nii.gz
-  // 4: given .hdr and image is .img.gz
-  //   Special processing needed for this case only
-  // NOT NEEDED const std::string fileExt = GetExtension(m_FileName);
-
-  /* Returns proper name for cases 1,2,3 */
-  std::string ImageFileName = GetImageFileName(self->GetFileName());
-  // NOTE: gzFile operations act just like FILE * operations when the files
-  // are not in gzip format.
-  // This greatly simplifies the following code, and gzFile types are used
-  // everywhere.
-  // In addition, it has the added benefit of reading gzip compressed image
-  // files that do not have a .gz ending.
-  gzFile file_p = ::gzopen(ImageFileName.c_str(), "rb");
-  if (file_p == NULL)
+  unsigned char* p = static_cast<unsigned char*>(buffer);
+
+  // Uncompressed images are read as they are.
+  vtksys::ifstream file(fileName.c_str(), ios::in | ios::binary);
+  unsigned char magic[2] = { 0, 0 };
+  if (!file.read(reinterpret_cast<char*>(magic), 2))
   {
-    /* Do a separate check to take care of case #4 */
-    ImageFileName += ".gz";
-    file_p = ::gzopen(ImageFileName.c_str(), "rb");
-    if (file_p == NULL)
-    {
-      // vtkErrorMacro( << "File cannot be read");
-    }
+    return false;
   }
+  if (magic[0] != 0x1f || magic[1] != 0x8b)
+  {
+    file.seekg(offset, ios::beg);
+    file.read(reinterpret_cast<char*>(p), size);
+    return static_cast<size_t>(file.gcount()) == size;
+  }
+  file.close();
 
-  // Seek through the file to the correct position, This is only necessary
-  // when readin in sub-volumes
-  // const long int total_offset = static_cast<long int>(tempX * tempY *
-  //                                start_slice * m_dataSize)
-  //    + static_cast<long int>(tempX * tempY * total_z * start_time *
-  //          m_dataSize);
-  // ::gzseek( file_p, total_offset, SEEK_SET );
-
-  // read image in
-  ::gzseek(file_p, offset, SEEK_SET);
-  ::gzread(file_p, p, self->getImageSizeInBytes());
+  // Compressed images only decode the range read, once indexed.
+  if (this->GzipIndex->Read(fileName, offset, size, p))
+  {
+    return true;
+  }
+
+  // Anything else the index cannot handle, such as concatenated gzip members.
+  gzFile file_p = ::gzopen(fileName.c_str(), "rb");
+  if (file_p == NULL)
+  {
+    return false;
+  }
+  const bool read = ::gzseek(file_p, offset, SEEK_SET) == offset &&
+    ::gzread(file_p, p, static_cast<unsigned int>(size)) == static_cast<int>(size);
   gzclose(file_p);
-  // SwapBytesIfNecessary( buffer, numberOfPixels );
+  return read;
 }
 
 //----------------------------------------------------------------------------
@@ -812,11 +802,22 @@ void vtkNIfTIReader::ExecuteDataWithInformation(vtkDataObject* output, vtkInform
   size_t outPtrSize = tempDataSize * tempDataTypeSize;
   nifti_1_header* niftiPointer = (nifti_1_header*)niftiHeaderUnsignedCharArray;
   offset = (long)(niftiPointer->vox_offset);
-  switch (data->GetScalarType())
+  // 4 cases to handle
+  // 1: given .hdr and image is .img
+  // 2: given .nii
+  // 3: given .nii.gz
+  // 4: given .hdr and image is .img.gz
+  std::string imageFileName = GetImageFileName(this->GetFileName());
+  if (!vtksys::SystemTools::FileExists(imageFileName, true))
   {
-    vtkTemplateMacro(vtkNIfTIReaderUpdate2(this, data, static_cast<VTK_TT*>(outPtr), offset));
-    default:
-      vtkErrorMacro(<< "Execute: Unknown data type");
+    // Case #4.
+    imageFileName += ".gz";
+  }
+  // Only the first volume of a time series fits the output.
+  const size_t imageSize = std::min(static_cast<size_t>(this->imageSizeInBytes), outPtrSize);
+  if (!this->ReadImage(imageFileName, offset, outPtr, imageSize))
+  {
+    vtkErrorMacro(<< "Could not read the image from " << imageFileName);
   }
 
   // start of variables
@@ -17,6 +17,11 @@
 // vtkNIfTIReader is a source object that reads NIfTI files.
 // It should be able to read most any NIfTI file
 //
+// Uncompressed images are read directly from the file. For gzip compressed
+// images, reads record inflate checkpoints up to the end of the range they
+// read, which later reads of the same file use to only decode the range they
+// need, concurrently.
+//
 // .SECTION See Also
 // vtkNIfTIWriter vtkAnalyzeReader vtkAnalyzeWriter
 
@@ -26,6 +31,8 @@
 #include "vtkAnalyzeNIfTIIOModule.h"
 #include "vtkImageReader.h"
 
+#include <string>
+
 #define NIFTI_HEADER_ARRAY "vtkNIfTIReaderHeaderArray"
 #define POINT_SPACE_ARRAY "vtkPointSpace"
 #define VOLUME_ORIGIN_DOUBLE_ARRAY "vtkVolumeOrigin"
@@ -34,6 +41,7 @@
 class vtkDataArray;
 class vtkUnsignedCharArray;
 class vtkFieldData;
+class vtkNIfTIGzipIndex;
 
 class VTKANALYZENIFTIIO_EXPORT vtkNIfTIReader : public vtkImageReader
 {
@@ -69,6 +77,11 @@ private:
   vtkNIfTIReader(const vtkNIfTIReader&) = delete;
   void operator=(const vtkNIfTIReader&) = delete;
 
+  // Description:
+  // Read size bytes of the image file at offset (in the uncompressed data)
+  // into buffer.
+  bool ReadImage(const std::string& fileName, long offset, void* buffer, size_t size);
+
   unsigned int imageSizeInBytes;
   unsigned int Type;
   int width;
@@ -85,5 +98,8 @@ private:
   vtkUnsignedCharArray* niftiHeader;
   unsigned char* niftiHeaderUnsignedCharArray;
   int niftiHeaderSize;
+
+  // Inflate checkpoints of the last gzip compressed image read.
+  vtkNIfTIGzipIndex* GzipIndex;
 };
 #endif
@@ -0,0 +1,301 @@
+// Writes gzip files of several checkpoint spans and checks the ranges
+// vtkNIfTIGzipIndex decodes from them: as the index grows lazily, on both
+// sides of each checkpoint, past the end of a truncated file and past the
+// first member of a concatenated one. Then checks that vtkNIfTIReader reads
+// the same image from a .nii file and from .nii.gz copies of it.
+#include "vtkDataArray.h"
+#include "vtkImageData.h"
+#include "vtkNIfTIGzipIndex.h"
+#include "vtkNIfTIReader.h"
+#include "vtkNew.h"
+#include "vtkPointData.h"
+#include "vtkTestUtilities.h"
+#include "vtkUnsignedCharArray.h"
+#include "vtk_zlib.h"
+#include "vtknifti1.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace
+{
+const vtkTypeInt64 Span = vtkNIfTIGzipIndex::CheckpointSpan;
+
+// Hardly compressible bytes, so deflate blocks stay small.
+unsigned char Value(vtkTypeInt64 position)
+{
+  return static_cast<unsigned char>((static_cast<vtkTypeUInt32>(position) * 2654435761u) >> 24);
+}
+
+std::vector<unsigned char> Values(size_t length)
+{
+  std::vector<unsigned char> values(length);
+  for (size_t cc = 0; cc < length; ++cc)
+  {
+    values[cc] = Value(static_cast<vtkTypeInt64>(cc));
+  }
+  return values;
+}
+
+// Writes data as gzip members, a new one starting at each of splits.
+bool WriteGzip(const std::string& fileName, const std::vector<unsigned char>& data,
+  const std::vector<size_t>& splits = std::vector<size_t>())
+{
+  size_t begin = 0;
+  for (size_t member = 0; member <= splits.size(); ++member)
+  {
+    const size_t end = member < splits.size() ? splits[member] : data.size();
+    gzFile file = gzopen(fileName.c_str(), member == 0 ? "wb1" : "ab1");
+    if (!file)
+    {
+      return false;
+    }
+    const unsigned int size = static_cast<unsigned int>(end - begin);
+    const bool written = gzwrite(file, data.data() + begin, size) == static_cast<int>(size);
+    if (gzclose(file) != Z_OK || !written)
+    {
+      return false;
+    }
+    begin = end;
+  }
+  return true;
+}
+
+// Reads [offset, offset + size) through the index and checks the values.
+bool CheckRead(vtkNIfTIGzipIndex& index, const std::string& fileName, vtkTypeInt64 offset,
+  size_t size)
+{
+  std::vector<unsigned char> buffer(size);
+  if (!index.Read(fileName, offset, size, buffer.data()))
+  {
+    cerr << "ERROR: could not read " << size << " bytes at " << offset << " of '" << fileName
+         << "'." << endl;
+    return false;
+  }
+  for (size_t cc = 0; cc < size; ++cc)
+  {
+    if (buffer[cc] != Value(offset + static_cast<vtkTypeInt64>(cc)))
+    {
+      cerr << "ERROR: wrong byte at " << offset + static_cast<vtkTypeInt64>(cc) << " of '"
+           << fileName << "'." << endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+// Reading [offset, offset + size) through the index must fail.
+bool CheckNoRead(vtkNIfTIGzipIndex& index, const std::string& fileName, vtkTypeInt64 offset,
+  size_t size)
+{
+  std::vector<unsigned char> buffer(size);
+  if (index.Read(fileName, offset, size, buffer.data()))
+  {
+    cerr << "ERROR: read " << size << " bytes at " << offset << " of '" << fileName
+         << "', past the data the index covers." << endl;
+    return false;
+  }
+  return true;
+}
+
+bool TestIndex(const std::string& prefix)
+{
+  const size_t length = static_cast<size_t>(4 * Span + Span / 2);
+  const std::vector<unsigned char> data = Values(length);
+  const std::string fileName = prefix + "multispan.gz";
+  if (!WriteGzip(fileName, data))
+  {
+    cerr << "ERROR: Could not write '" << fileName << "'." << endl;
+    return false;
+  }
+
+  // The index only grows as far as the reads need.
+  vtkNIfTIGzipIndex index;
+  if (!CheckRead(index, fileName, 0, 1000))
+  {
+    return false;
+  }
+  if (index.GetNumberOfCheckpoints() != 1)
+  {
+    cerr << "ERROR: " << index.GetNumberOfCheckpoints()
+         << " checkpoints after reading the first span." << endl;
+    return false;
+  }
+  if (!CheckRead(index, fileName, Span / 2, static_cast<size_t>(2 * Span)))
+  {
+    return false;
+  }
+  const size_t grown = index.GetNumberOfCheckpoints();
+  if (!CheckRead(index, fileName, static_cast<vtkTypeInt64>(length) - 1000, 1000))
+  {
+    return false;
+  }
+  if (grown < 2 || index.GetNumberOfCheckpoints() <= grown)
+  {
+    cerr << "ERROR: the index did not grow with the reads: " << grown << " then "
+         << index.GetNumberOfCheckpoints() << " checkpoints." << endl;
+    return false;
+  }
+
+  // Ranges ending at, starting at and straddling each checkpoint.
+  for (size_t point = 1; point < index.GetNumberOfCheckpoints(); ++point)
+  {
+    const vtkTypeInt64 out = index.GetCheckpointOffset(point);
+    if (!CheckRead(index, fileName, out - 100, 100) || !CheckRead(index, fileName, out, 100) ||
+      !CheckRead(index, fileName, out - 1, 2) || !CheckRead(index, fileName, out - 5000, 10000))
+    {
+      return false;
+    }
+  }
+  return CheckRead(index, fileName, 1, length - 1) &&
+    CheckNoRead(index, fileName, static_cast<vtkTypeInt64>(length) - 10, 20);
+}
+
+bool TestTruncated(const std::string& prefix)
+{
+  const size_t length = static_cast<size_t>(3 * Span);
+  const std::string fullName = prefix + "full.gz";
+  const std::string fileName = prefix + "truncated.gz";
+  if (!WriteGzip(fullName, Values(length)))
+  {
+    cerr << "ERROR: Could not write '" << fullName << "'." << endl;
+    return false;
+  }
+  // Keep the first half of the compressed file.
+  std::ifstream full(fullName.c_str(), std::ios::binary);
+  std::vector<char> compressed(
+    (std::istreambuf_iterator<char>(full)), std::istreambuf_iterator<char>());
+  std::ofstream truncated(fileName.c_str(), std::ios::binary);
+  truncated.write(compressed.data(), compressed.size() / 2);
+  truncated.close();
+
+  // What is left still reads, before and after a failed read past the end.
+  vtkNIfTIGzipIndex index;
+  return CheckRead(index, fileName, 0, 1000) &&
+    CheckNoRead(index, fileName, static_cast<vtkTypeInt64>(length) - 1000, 1000) &&
+    CheckRead(index, fileName, Span / 4, static_cast<size_t>(Span / 2)) &&
+    CheckNoRead(index, fileName, Span, static_cast<size_t>(Span));
+}
+
+bool TestMultiMember(const std::string& prefix)
+{
+  const size_t length = static_cast<size_t>(2 * Span);
+  const size_t split = static_cast<size_t>(Span + 777);
+  const std::string fileName = prefix + "multimember.gz";
+  if (!WriteGzip(fileName, Values(length), std::vector<size_t>(1, split)))
+  {
+    cerr << "ERROR: Could not write '" << fileName << "'." << endl;
+    return false;
+  }
+  // Only the first member is indexed.
+  vtkNIfTIGzipIndex index;
+  return CheckRead(index, fileName, 0, split) &&
+    CheckNoRead(index, fileName, static_cast<vtkTypeInt64>(split) - 10, 20) &&
+    CheckNoRead(index, fileName, static_cast<vtkTypeInt64>(length) - 10, 10) &&
+    CheckRead(index, fileName, Span - 10, 20);
+}
+
+// Writes a .nii image of dims bytes, compressed as gzip members starting at
+// splits when fileName ends with .gz.
+bool WriteNIfTI(const std::string& fileName, const int dims[3], const std::vector<size_t>& splits)
+{
+  nifti_1_header header;
+  memset(&header, 0, sizeof(header));
+  header.sizeof_hdr = 348;
+  header.dim[0] = 3;
+  for (int cc = 1; cc < 8; ++cc)
+  {
+    header.dim[cc] = static_cast<short>(cc <= 3 ? dims[cc - 1] : 1);
+    header.pixdim[cc] = 1.0f;
+  }
+  header.datatype = DT_UNSIGNED_CHAR;
+  header.bitpix = 8;
+  header.vox_offset = 352.0f;
+  memcpy(header.magic, "n+1", 4);
+
+  // The header, the 4 bytes of the empty extension and the image.
+  std::vector<unsigned char> data(352, 0);
+  memcpy(data.data(), &header, sizeof(header));
+  const std::vector<unsigned char> image =
+    Values(static_cast<size_t>(dims[0]) * static_cast<size_t>(dims[1]) * dims[2]);
+  data.insert(data.end(), image.begin(), image.end());
+
+  if (fileName.substr(fileName.size() - 3) == ".gz")
+  {
+    return WriteGzip(fileName, data, splits);
+  }
+  std::ofstream file(fileName.c_str(), std::ios::binary);
+  file.write(reinterpret_cast<const char*>(data.data()), data.size());
+  return file.good();
+}
+
+bool TestReader(const std::string& prefix)
+{
+  const int dims[3] = { 1024, 1024, 10 };
+  const std::string fileNames[3] = { prefix + "image.nii", prefix + "image.nii.gz",
+    prefix + "multimember.nii.gz" };
+  const std::vector<size_t> splits[3] = { std::vector<size_t>(), std::vector<size_t>(),
+    std::vector<size_t>(1, static_cast<size_t>(Span + 12345)) };
+  for (int cc = 0; cc < 3; ++cc)
+  {
+    if (!WriteNIfTI(fileNames[cc], dims, splits[cc]))
+    {
+      cerr << "ERROR: Could not write '" << fileNames[cc] << "'." << endl;
+      return false;
+    }
+  }
+
+  vtkNew<vtkNIfTIReader> reader;
+  vtkNew<vtkUnsignedCharArray> expected;
+  // The compressed image is read twice: the second time from the index.
+  const int files[4] = { 0, 1, 1, 2 };
+  for (int file : files)
+  {
+    reader->SetFileName(fileNames[file].c_str());
+    reader->Modified();
+    reader->Update();
+    vtkDataArray* scalars = reader->GetOutput()->GetPointData()->GetScalars();
+    if (!scalars || scalars->GetNumberOfValues() != dims[0] * dims[1] * dims[2])
+    {
+      cerr << "ERROR: '" << fileNames[file] << "' was not read." << endl;
+      return false;
+    }
+    if (file == 0)
+    {
+      expected->DeepCopy(scalars);
+    }
+    else if (memcmp(expected->GetVoidPointer(0), scalars->GetVoidPointer(0),
+               static_cast<size_t>(expected->GetNumberOfValues())) != 0)
+    {
+      cerr << "ERROR: '" << fileNames[file] << "' does not read as '" << fileNames[0] << "'."
+           << endl;
+      return false;
+    }
+  }
+  return true;
+}
+}
+
+int main(int argc, char* argv[])
+{
+  char* tempDir =
+    vtkTestUtilities::GetArgOrEnvOrDefault("-T", argc, argv, "VTK_TEMP_DIR", "Testing/Temporary");
+  if (!tempDir)
+  {
+    cerr << "ERROR: Could not determine temporary directory." << endl;
+    return EXIT_FAILURE;
+  }
+  const std::string prefix = std::string(tempDir) + "/TestNIfTIGzipIndex_";
+  delete[] tempDir;
+
+  if (!TestIndex(prefix) || !TestTruncated(prefix) || !TestMultiMember(prefix) ||
+    !TestReader(prefix))
+  {
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -13,14 +13,17 @@
 #include "vtkPCAStatistics.h"
 #include "vtkPSciVizPCAStats.h"
 #include "vtkPointData.h"
+#include "vtkSMPTools.h"
 #include "vtkStringArray.h"
 #include "vtkTable.h"
 #include "vtkTransposeTable.h"
 
 #include <algorithm>
+#include <cmath>
 #include <set>
 #include <sstream>
 #include <string>
+#include <vector>
 
 //----------------------------------------------------------------------------
 // Internal class that holds selected columns
@@ -52,6 +55,122 @@ public:
   std::set<std::string> Columns;
 };
 
+//----------------------------------------------------------------------------
+// Binned kernel density estimation on a regular grid: the observations are
+// linearly binned onto the grid nodes, then the bins are convolved with the
+// kernel along x, then along y. The kernel is separable since the smoothing
+// matrix of the HDR filter is diagonal, and its values at the grid offsets
+// are evaluated by the HDR filter itself, so that both the binned and the
+// exact densities use the same kernel.
+static void ComputeBinnedDensity(vtkHighestDensityRegionsStatistics* hdr, vtkDataArray* inObs,
+  const double origin[2], const double spacing[2], const int dims[2], vtkDataArray* outDens)
+{
+  const int nx = dims[0];
+  const int ny = dims[1];
+  const vtkIdType nbObservations = inObs->GetNumberOfTuples();
+
+  // Kernel of an observation at the origin, along each axis.
+  vtkNew<vtkDoubleArray> kernelObs;
+  kernelObs->SetNumberOfComponents(2);
+  kernelObs->InsertNextTuple2(0., 0.);
+  vtkNew<vtkDoubleArray> kernelPOI;
+  kernelPOI->SetNumberOfComponents(2);
+  kernelPOI->SetNumberOfTuples(nx + ny);
+  for (int i = 0; i < nx; i++)
+  {
+    kernelPOI->SetTuple2(i, i * spacing[0], 0.);
+  }
+  for (int j = 0; j < ny; j++)
+  {
+    kernelPOI->SetTuple2(nx + j, 0., j * spacing[1]);
+  }
+  vtkNew<vtkDoubleArray> kernel;
+  kernel->SetNumberOfTuples(nx + ny);
+  hdr->ComputeHDR(kernelObs, kernelPOI, kernel);
+  const double peak = kernel->GetValue(0);
+  if (nbObservations == 0 || !(peak > 0.))
+  {
+    outDens->Fill(0.);
+    return;
+  }
+  // K(i, j) = kx[i] * ky[j], truncated where it becomes negligible.
+  const double cutoff = peak * 1e-12;
+  std::vector<double> kx(1, 1.);
+  std::vector<double> ky(1, peak / nbObservations);
+  for (int i = 1; i < nx && kernel->GetValue(i) > cutoff; i++)
+  {
+    kx.push_back(kernel->GetValue(i) / peak);
+  }
+  for (int j = 1; j < ny && kernel->GetValue(nx + j) > cutoff; j++)
+  {
+    ky.push_back(kernel->GetValue(nx + j) / nbObservations);
+  }
+  const int rx = static_cast<int>(kx.size()) - 1;
+  const int ry = static_cast<int>(ky.size()) - 1;
+
+  // Share each observation between its 4 surrounding nodes.
+  std::vector<double> bins(static_cast<size_t>(nx) * ny, 0.);
+  for (vtkIdType obs = 0; obs < nbObservations; obs++)
+  {
+    const double u = (inObs->GetComponent(obs, 0) - origin[0]) / spacing[0];
+    const double v = (inObs->GetComponent(obs, 1) - origin[1]) / spacing[1];
+    const int i = static_cast<int>(std::floor(u));
+    const int j = static_cast<int>(std::floor(v));
+    const double fu = u - i;
+    const double fv = v - j;
+    const double weights[4] = { (1. - fu) * (1. - fv), fu * (1. - fv), (1. - fu) * fv, fu * fv };
+    for (int corner = 0; corner < 4; corner++)
+    {
+      const int ci = i + (corner & 1);
+      const int cj = j + (corner >> 1);
+      if (ci >= 0 && ci < nx && cj >= 0 && cj < ny)
+      {
+        bins[static_cast<size_t>(cj) * nx + ci] += weights[corner];
+      }
+    }
+  }
+
+  std::vector<double> rows(bins.size());
+  vtkSMPTools::For(0, ny, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType j = begin; j < end; j++)
+    {
+      const double* bin = &bins[j * nx];
+      for (int i = 0; i < nx; i++)
+      {
+        double sum = bin[i];
+        for (int d = 1; d <= rx; d++)
+        {
+          sum += kx[d] * ((i >= d ? bin[i - d] : 0.) + (i + d < nx ? bin[i + d] : 0.));
+        }
+        rows[j * nx + i] = sum;
+      }
+    }
+  });
+
+  std::vector<double> density(bins.size());
+  vtkSMPTools::For(0, ny, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType j = begin; j < end; j++)
+    {
+      const vtkIdType dMin = std::max<vtkIdType>(-ry, -j);
+      const vtkIdType dMax = std::min<vtkIdType>(ry, ny - 1 - j);
+      for (int i = 0; i < nx; i++)
+      {
+        double sum = 0.;
+        for (vtkIdType d = dMin; d <= dMax; d++)
+        {
+          sum += ky[d < 0 ? -d : d] * rows[(j + d) * nx + i];
+        }
+        density[j * nx + i] = sum;
+      }
+    }
+  });
+
+  for (size_t pixel = 0; pixel < density.size(); pixel++)
+  {
+    outDens->SetTuple1(static_cast<vtkIdType>(pixel), density[pixel]);
+  }
+}
+
 //----------------------------------------------------------------------------
 vtkStandardNewMacro(vtkPVExtractBagPlots);
 
@@ -62,6 +181,7 @@ vtkPVExtractBagPlots::vtkPVExtractBagPlots()
   this->RobustPCA = false;
   this->KernelWidth = 1.;
   this->UseSilvermanRule = false;
+  this->UseBinnedDensity = false;
   this->GridSize = 100;
   this->UserQuantile = 95;
   this->Internal = new PVExtractBagPlotsInternal();
@@ -112,6 +232,7 @@ void vtkPVExtractBagPlots::PrintSelf(ostream& os, vtkIndent indent)
   os << "RobustPCA: " << this->RobustPCA << std::endl;
   os << "KernelWidth: " << this->KernelWidth << std::endl;
   os << "UseSilvermanRule: " << this->UseSilvermanRule << std::endl;
+  os << "UseBinnedDensity: " << this->UseBinnedDensity << std::endl;
   os << "GridSize: " << this->GridSize << std::endl;
   os << "UserQuantile: " << this->UserQuantile << std::endl;
 }
@@ -351,6 +472,18 @@ int vtkPVExtractBagPlots::RequestData(
   inObs->CopyComponent(0, hdrArrays[0], 0);
   inObs->CopyComponent(1, hdrArrays[1], 0);
 
+  // Give a width to the axes along which all the observations are equal,
+  // e.g. when all the curves are the same, so that the grid spacing is not 0.
+  for (int axis = 0; axis < 2; axis++)
+  {
+    if (!(bounds[2 * axis + 1] > bounds[2 * axis]))
+    {
+      const double halfWidth = sigma > 0. ? sigma : 0.5;
+      bounds[2 * axis] -= halfWidth;
+      bounds[2 * axis + 1] += halfWidth;
+    }
+  }
+
   // Add border to grid
   const double borderSize = 0.15;
   bounds[0] -= (bounds[1] - bounds[0]) * borderSize;
@@ -362,27 +495,38 @@ int vtkPVExtractBagPlots::RequestData(
   const int gridHeight = this->GetGridSize();
   const double spaceX = (bounds[1] - bounds[0]) / gridWidth;
   const double spaceY = (bounds[3] - bounds[2]) / gridHeight;
-  vtkNew<vtkDoubleArray> inPOI;
-  inPOI->SetNumberOfComponents(2);
-  inPOI->SetNumberOfTuples(gridWidth * gridHeight);
-
-  vtkIdType pointId = 0;
-  for (int j = 0; j < gridHeight; j++)
-  {
-    for (int i = 0; i < gridWidth; i++)
-    {
-      double x = bounds[0] + i * spaceX;
-      double y = bounds[2] + j * spaceY;
-      inPOI->SetTuple2(pointId++, x, y);
-    }
-  }
 
   vtkDataArray* outDens = vtkDataArray::CreateDataArray(inObs->GetDataType());
   outDens->SetNumberOfComponents(1);
   outDens->SetNumberOfTuples(gridWidth * gridHeight);
 
-  // Evaluate the HDR on every pixel of the grid
-  hdr->ComputeHDR(inObs.Get(), inPOI.Get(), outDens);
+  if (this->UseBinnedDensity)
+  {
+    const double origin[2] = { bounds[0], bounds[2] };
+    const double spacing[2] = { spaceX, spaceY };
+    const int dims[2] = { gridWidth, gridHeight };
+    ComputeBinnedDensity(hdr, inObs, origin, spacing, dims, outDens);
+  }
+  else
+  {
+    vtkNew<vtkDoubleArray> inPOI;
+    inPOI->SetNumberOfComponents(2);
+    inPOI->SetNumberOfTuples(gridWidth * gridHeight);
+
+    vtkIdType pointId = 0;
+    for (int j = 0; j < gridHeight; j++)
+    {
+      for (int i = 0; i < gridWidth; i++)
+      {
+        double x = bounds[0] + i * spaceX;
+        double y = bounds[2] + j * spaceY;
+        inPOI->SetTuple2(pointId++, x, y);
+      }
+    }
+
+    // Evaluate the HDR on every pixel of the grid
+    hdr->ComputeHDR(inObs.Get(), inPOI.Get(), outDens);
+  }
 
   vtkNew<vtkImageData> grid;
   grid->SetDimensions(gridWidth, gridHeight, 1);
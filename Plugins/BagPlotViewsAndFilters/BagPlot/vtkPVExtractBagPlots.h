@@ -94,6 +94,24 @@ public:
   vtkSetMacro(GridSize, int);
   //@}
 
+  //@{
+  /**
+   * Set/get if the density on the grid is estimated by binning the
+   * observations onto the grid and convolving the bins with the kernel,
+   * on several threads, instead of evaluating the kernel of every
+   * observation at every pixel. For N observations on a GridSize G, this
+   * takes O(N + G^2 R) operations, R being the kernel radius in pixels,
+   * instead of O(N G^2).
+   * The binned density differs from the exact one by less than
+   * (dx^2 + dy^2) / (8 sigma^2) times the peak of the kernel, dx and dy
+   * being the grid spacing.
+   * Default is FALSE.
+   */
+  vtkGetMacro(UseBinnedDensity, bool);
+  vtkSetMacro(UseBinnedDensity, bool);
+  vtkBooleanMacro(UseBinnedDensity, bool);
+  //@}
+
   //@{
   /**
    * Set/get the user quantile (in percent). Beyond this threshold, input
@@ -133,6 +151,7 @@ protected:
   bool TransposeTable;
   bool RobustPCA;
   bool UseSilvermanRule;
+  bool UseBinnedDensity;
   int NumberOfProjectionAxes = 2;
 
 private:
@@ -0,0 +1,179 @@
+/*=========================================================================
+
+  Program:   ParaView
+  Module:    TestExtractBagPlotsBinnedDensity.cxx
+
+  Copyright (c) Kitware, Inc.
+  All rights reserved.
+  See Copyright.txt or http://www.paraview.org/HTML/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// Checks that the binned density of vtkPVExtractBagPlots is within its
+// documented tolerance of the exact one on synthetic functional data, and
+// that both give a finite density on a valid grid when all the curves are
+// the same.
+#include "vtkDataArray.h"
+#include "vtkDoubleArray.h"
+#include "vtkHighestDensityRegionsStatistics.h"
+#include "vtkImageData.h"
+#include "vtkMath.h"
+#include "vtkMultiBlockDataSet.h"
+#include "vtkNew.h"
+#include "vtkPVExtractBagPlots.h"
+#include "vtkPointData.h"
+#include "vtkTable.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <random>
+#include <string>
+
+namespace
+{
+const int NumberOfSamples = 40;
+
+// numCurves curves of NumberOfSamples samples, shifted and scaled sines, or
+// all the same when identical is true.
+void FillCurves(vtkTable* table, int numCurves, bool identical)
+{
+  std::mt19937 generator(0);
+  std::uniform_real_distribution<double> amplitude(0.5, 1.5);
+  std::uniform_real_distribution<double> phase(0., 0.5);
+  std::normal_distribution<double> offset(0., 0.3);
+  for (int curve = 0; curve < numCurves; curve++)
+  {
+    vtkNew<vtkDoubleArray> values;
+    values->SetName(("curve" + std::to_string(curve)).c_str());
+    values->SetNumberOfValues(NumberOfSamples);
+    const double a = amplitude(generator);
+    const double p = phase(generator);
+    const double b = offset(generator);
+    for (int t = 0; t < NumberOfSamples; t++)
+    {
+      // Integers, so that the mean of identical curves is exact.
+      values->SetValue(t,
+        identical ? t % 5 : a * std::sin(2. * vtkMath::Pi() * t / NumberOfSamples + p) + b);
+    }
+    table->AddColumn(values);
+  }
+}
+
+vtkImageData* GetGrid(vtkPVExtractBagPlots* bagPlots, vtkTable* table, bool binned)
+{
+  bagPlots->SetInputData(table);
+  bagPlots->ClearAttributeArrays();
+  for (vtkIdType col = 0; col < table->GetNumberOfColumns(); col++)
+  {
+    bagPlots->EnableAttributeArray(table->GetColumnName(col));
+  }
+  bagPlots->SetUseBinnedDensity(binned);
+  bagPlots->Update();
+  vtkMultiBlockDataSet* output = bagPlots->GetOutput();
+  vtkImageData* grid = vtkImageData::SafeDownCast(output->GetBlock(2));
+  return grid && grid->GetPointData()->GetScalars() ? grid : nullptr;
+}
+
+// The density of a single observation at its own position.
+double GetKernelPeak(double sigma)
+{
+  vtkNew<vtkHighestDensityRegionsStatistics> hdr;
+  hdr->SetSigma(sigma);
+  vtkNew<vtkDoubleArray> origin;
+  origin->SetNumberOfComponents(2);
+  origin->InsertNextTuple2(0., 0.);
+  vtkNew<vtkDoubleArray> density;
+  density->SetNumberOfTuples(1);
+  hdr->ComputeHDR(origin, origin, density);
+  return density->GetValue(0);
+}
+}
+
+int main(int, char* [])
+{
+  const double sigma = 1.;
+
+  vtkNew<vtkTable> curves;
+  FillCurves(curves, 300, false);
+  vtkNew<vtkPVExtractBagPlots> exact;
+  exact->SetKernelWidth(sigma);
+  exact->SetGridSize(100);
+  vtkNew<vtkPVExtractBagPlots> binned;
+  binned->SetKernelWidth(sigma);
+  binned->SetGridSize(100);
+  vtkImageData* exactGrid = GetGrid(exact, curves, false);
+  vtkImageData* binnedGrid = GetGrid(binned, curves, true);
+  if (!exactGrid || !binnedGrid)
+  {
+    cerr << "ERROR: Missing grid density." << endl;
+    return EXIT_FAILURE;
+  }
+
+  int exactDims[3];
+  int binnedDims[3];
+  exactGrid->GetDimensions(exactDims);
+  binnedGrid->GetDimensions(binnedDims);
+  double spacing[3];
+  exactGrid->GetSpacing(spacing);
+  if (!std::equal(exactDims, exactDims + 3, binnedDims) ||
+    vtkMath::Distance2BetweenPoints(exactGrid->GetOrigin(), binnedGrid->GetOrigin()) != 0. ||
+    vtkMath::Distance2BetweenPoints(spacing, binnedGrid->GetSpacing()) != 0.)
+  {
+    cerr << "ERROR: The binned and exact densities are not on the same grid." << endl;
+    return EXIT_FAILURE;
+  }
+
+  // The tolerance documented by vtkPVExtractBagPlots::SetUseBinnedDensity().
+  const double tolerance = GetKernelPeak(sigma) *
+    (spacing[0] * spacing[0] + spacing[1] * spacing[1]) / (8. * sigma * sigma);
+  vtkDataArray* exactDensity = exactGrid->GetPointData()->GetScalars();
+  vtkDataArray* binnedDensity = binnedGrid->GetPointData()->GetScalars();
+  double maxError = 0.;
+  for (vtkIdType pixel = 0; pixel < exactDensity->GetNumberOfTuples(); pixel++)
+  {
+    maxError = std::max(
+      maxError, std::abs(exactDensity->GetTuple1(pixel) - binnedDensity->GetTuple1(pixel)));
+  }
+  if (!(maxError <= tolerance))
+  {
+    cerr << "ERROR: Binned density differs by " << maxError << " from the exact one, more than "
+         << tolerance << "." << endl;
+    return EXIT_FAILURE;
+  }
+
+  // All the curves are the same: every PCA coordinate is 0.
+  vtkNew<vtkTable> identical;
+  FillCurves(identical, 50, true);
+  for (bool useBinned : { false, true })
+  {
+    vtkImageData* grid = GetGrid(useBinned ? binned : exact, identical, useBinned);
+    if (!grid)
+    {
+      cerr << "ERROR: Missing grid density for identical curves." << endl;
+      return EXIT_FAILURE;
+    }
+    grid->GetSpacing(spacing);
+    if (!(spacing[0] > 0.) || !(spacing[1] > 0.))
+    {
+      cerr << "ERROR: Grid spacing " << spacing[0] << ", " << spacing[1]
+           << " for identical curves." << endl;
+      return EXIT_FAILURE;
+    }
+    vtkDataArray* density = grid->GetPointData()->GetScalars();
+    for (vtkIdType pixel = 0; pixel < density->GetNumberOfTuples(); pixel++)
+    {
+      if (!std::isfinite(density->GetTuple1(pixel)))
+      {
+        cerr << "ERROR: Density " << density->GetTuple1(pixel) << " at pixel " << pixel
+             << " for identical curves, binned: " << useBinned << endl;
+        return EXIT_FAILURE;
+      }
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
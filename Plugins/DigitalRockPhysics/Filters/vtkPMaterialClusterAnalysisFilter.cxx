@@ -30,11 +30,14 @@
 #include "vtkTable.h"
 
 #define BROADCAST_VALUES_TAG 621
+#define EXCHANGE_VALUES_TAG 622
+#define GATHER_VALUES_TAG 623
 
+#include <algorithm>
 #include <array>
 #include <atomic>
 #include <map>
-#include <set>
+#include <vector>
 
 //----------------------------------------------------------------------------
 vtkStandardNewMacro(vtkPMaterialClusterAnalysisFilter);
@@ -61,8 +64,7 @@ void vtkPMaterialClusterAnalysisFilter::PrintSelf(ostream& os, vtkIndent indent)
 namespace
 {
 typedef std::map<int, std::pair<unsigned int, std::array<double, 3> > >
-  LabelValuesMap;                                    // cluster label -> { count, barycenter }
-typedef std::map<int, std::set<int> > LabelRanksMap; // cluster label -> { list of rank using it }
+  LabelValuesMap; // cluster label -> { count, barycenter }
 
 //----------------------------------------------------------------------------
 void Barycenter(unsigned int weight1, const double* point1, unsigned int weight2,
@@ -76,7 +78,7 @@ void Barycenter(unsigned int weight1, const double* point1, unsigned int weight2
 }
 
 //----------------------------------------------------------------------------
-void AppendMapToTable(LabelValuesMap& lvMap, vtkTable* table)
+void AppendMapToTable(const LabelValuesMap& lvMap, vtkTable* table)
 {
   vtkNew<vtkIntArray> labelArray;
   labelArray->SetName("Label");
@@ -145,7 +147,106 @@ bool AppendTableToMap(vtkTable* table, LabelValuesMap& lvMap, int rockfillLabel,
 }
 
 //----------------------------------------------------------------------------
-int ReduceTable(vtkAlgorithm* that, LabelValuesMap& lvMap, vtkTable* table, int rockfillLabel)
+// Number of doubles describing a cluster: label, volume and barycenter.
+const int PackedClusterSize = 5;
+
+void PackCluster(int label, const LabelValuesMap::mapped_type& values, std::vector<double>& buffer)
+{
+  buffer.push_back(label);
+  buffer.push_back(values.first);
+  buffer.insert(buffer.end(), values.second.begin(), values.second.end());
+}
+
+// Merge the packed clusters of buffer into lvMap, as AppendTableToMap does.
+void MergePackedClusters(const std::vector<double>& buffer, LabelValuesMap& lvMap)
+{
+  std::array<double, 3> barycenter;
+  for (size_t pos = 0; pos + PackedClusterSize <= buffer.size(); pos += PackedClusterSize)
+  {
+    int label = static_cast<int>(buffer[pos]);
+    double volume = buffer[pos + 1];
+    std::copy(&buffer[pos + 2], &buffer[pos + 2] + 3, barycenter.begin());
+    auto iter = lvMap.emplace(label, std::make_pair(volume, barycenter));
+    if (!iter.second)
+    {
+      Barycenter(iter.first->second.first, &iter.first->second.second[0], volume, &barycenter[0],
+        &iter.first->second.second[0]);
+      iter.first->second.first += volume;
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+// Rank merging the values of a cluster label. Fibonacci hashing spreads
+// consecutive labels over the ranks.
+int OwnerRank(int label, int nbRanks)
+{
+  vtkTypeUInt64 hash = static_cast<vtkTypeUInt64>(static_cast<unsigned int>(label));
+  hash *= 11400714819323198485ull;
+  return static_cast<int>((hash >> 32) % static_cast<vtkTypeUInt64>(nbRanks));
+}
+
+//----------------------------------------------------------------------------
+void SendBuffer(
+  vtkMultiProcessController* controller, const std::vector<double>& buffer, int remote, int tag)
+{
+  vtkIdType size = static_cast<vtkIdType>(buffer.size());
+  controller->Send(&size, 1, remote, tag);
+  if (size > 0)
+  {
+    controller->Send(buffer.data(), size, remote, tag);
+  }
+}
+
+void ReceiveBuffer(
+  vtkMultiProcessController* controller, std::vector<double>& buffer, int remote, int tag)
+{
+  vtkIdType size = 0;
+  controller->Receive(&size, 1, remote, tag);
+  buffer.resize(static_cast<size_t>(size));
+  if (size > 0)
+  {
+    controller->Receive(buffer.data(), size, remote, tag);
+  }
+}
+
+//----------------------------------------------------------------------------
+// Send send[r] to every rank r and receive recv[r] from it. In round k,
+// rank i exchanges with rank (k - i) mod n, the lower rank of the pair
+// sending first, so that blocking sends cannot deadlock.
+void AllToAll(vtkMultiProcessController* controller, std::vector<std::vector<double> >& send,
+  std::vector<std::vector<double> >& recv, int tag)
+{
+  int nbRanks = controller->GetNumberOfProcesses();
+  int rank = controller->GetLocalProcessId();
+  recv.assign(nbRanks, std::vector<double>());
+  recv[rank].swap(send[rank]);
+  for (int round = 0; round < nbRanks; round++)
+  {
+    int partner = ((round - rank) % nbRanks + nbRanks) % nbRanks;
+    if (partner == rank)
+    {
+      continue;
+    }
+    if (rank < partner)
+    {
+      SendBuffer(controller, send[partner], partner, tag);
+      ReceiveBuffer(controller, recv[partner], partner, tag);
+    }
+    else
+    {
+      ReceiveBuffer(controller, recv[partner], partner, tag);
+      SendBuffer(controller, send[partner], partner, tag);
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+// Reduce the clusters of all the ranks: every label is merged by the rank
+// that owns it, which then returns the merged values to the ranks that
+// contributed to it. The table of every rank ends up with the reduced
+// values of its own labels, and the table of rank 0 with all of them.
+int ReduceTable(vtkAlgorithm* that, const LabelValuesMap& lvMap, vtkTable* table, int rockfillLabel)
 {
   vtkMultiProcessController* controller = vtkMultiProcessController::GetGlobalController();
   if (!controller || (controller && controller->GetNumberOfProcesses() <= 1))
@@ -155,81 +256,80 @@ int ReduceTable(vtkAlgorithm* that, LabelValuesMap& lvMap, vtkTable* table, int
 
   that->SetProgressText("Reducing data");
   that->UpdateProgress(0.0);
-  std::vector<vtkSmartPointer<vtkDataObject> > recv;
-  controller->Gather(table, recv, 0);
-  while (table->GetNumberOfColumns() != 0)
-  {
-    table->RemoveColumn(0);
-  }
+  int nbRanks = controller->GetNumberOfProcesses();
+  int rank = controller->GetLocalProcessId();
 
-  if (controller->GetLocalProcessId() == 0)
+  // Send the local clusters to their owners.
+  std::vector<std::vector<double> > send(nbRanks);
+  for (const auto& it : lvMap)
   {
-    LabelRanksMap ranksMap;
-    for (size_t iRank = 1; iRank < recv.size(); iRank++)
+    if (it.first != rockfillLabel)
     {
-      vtkTable* localTable = vtkTable::SafeDownCast(recv[iRank]);
-      if (!localTable)
-      {
-        vtkErrorWithObjectMacro(controller, "Could not reduce tables from other ranks");
-        return 0;
-      }
+      PackCluster(it.first, it.second, send[OwnerRank(it.first, nbRanks)]);
+    }
+  }
+  std::vector<std::vector<double> > recv;
+  AllToAll(controller, send, recv, EXCHANGE_VALUES_TAG);
+  that->UpdateProgress(0.4);
 
-      // Create Label Values Map
-      if (!AppendTableToMap(localTable, lvMap, rockfillLabel))
-      {
-        vtkErrorWithObjectMacro(
-          controller, "Could not append table to map. This rank will be ignored.");
-        continue;
-      }
+  // Merge the owned clusters, in rank order like a merge on a single rank.
+  LabelValuesMap ownedMap;
+  for (const auto& buffer : recv)
+  {
+    MergePackedClusters(buffer, ownedMap);
+  }
 
-      // Create ranks map
-      vtkIdType nRows = localTable->GetNumberOfRows();
-      vtkIntArray* tmpLabelArray = vtkIntArray::SafeDownCast(localTable->GetColumnByName("Label"));
-      if (!tmpLabelArray)
-      {
-        vtkErrorWithObjectMacro(
-          controller, "Could not create ranks map. This rank will be ignored.");
-        continue;
-      }
-      for (vtkIdType iRow = 0; iRow < nRows; iRow++)
-      {
-        int tmpLabel = tmpLabelArray->GetValue(iRow);
-        ranksMap[tmpLabel].insert(static_cast<int>(iRank));
-      }
+  // Return the merged clusters to the ranks that sent them.
+  std::vector<std::vector<double> > replies(nbRanks);
+  for (int iRank = 0; iRank < nbRanks; iRank++)
+  {
+    for (size_t pos = 0; pos < recv[iRank].size(); pos += PackedClusterSize)
+    {
+      int label = static_cast<int>(recv[iRank][pos]);
+      PackCluster(label, ownedMap[label], replies[iRank]);
     }
-    that->UpdateProgress(0.8);
+  }
+  AllToAll(controller, replies, recv, BROADCAST_VALUES_TAG);
+  that->UpdateProgress(0.8);
 
-    // Export map to a vtkTable
-    AppendMapToTable(lvMap, table);
+  LabelValuesMap reducedMap;
+  for (const auto& buffer : recv)
+  {
+    MergePackedClusters(buffer, reducedMap);
+  }
 
-    // Broadcast it rank by rank using the ranks map
-    vtkDataSetAttributes* attr = table->GetRowData();
-    vtkIntArray* labelArray = vtkIntArray::SafeDownCast(table->GetColumnByName("Label"));
-    for (int iRank = 1; iRank < controller->GetNumberOfProcesses(); iRank++)
+  // Rank 0 also gets the clusters it does not use.
+  std::vector<double> owned;
+  for (const auto& it : ownedMap)
+  {
+    PackCluster(it.first, it.second, owned);
+  }
+  if (rank == 0)
+  {
+    for (int iRank = 0; iRank < nbRanks; iRank++)
     {
-      vtkNew<vtkTable> localTable;
-      vtkDataSetAttributes* localAttr = localTable->GetRowData();
-      localAttr->CopyAllocate(attr);
-      vtkIdType iRowLocal = 0;
-      for (vtkIdType iRow = 0; iRow < table->GetNumberOfRows(); iRow++)
+      if (iRank > 0)
       {
-        auto tmpSet = ranksMap[labelArray->GetValue(iRow)];
-        if (tmpSet.find(iRank) != tmpSet.end())
-        {
-          localAttr->CopyData(attr, iRow, iRowLocal);
-          iRowLocal++;
-        }
+        ReceiveBuffer(controller, owned, iRank, GATHER_VALUES_TAG);
+      }
+      for (size_t pos = 0; pos < owned.size(); pos += PackedClusterSize)
+      {
+        reducedMap.emplace(static_cast<int>(owned[pos]),
+          std::make_pair(static_cast<unsigned int>(owned[pos + 1]),
+            std::array<double, 3>{ { owned[pos + 2], owned[pos + 3], owned[pos + 4] } }));
       }
-      localAttr->Squeeze();
-      controller->Send(localTable, iRank, BROADCAST_VALUES_TAG);
     }
   }
   else
   {
-    // Receive our own label values map
-    controller->Receive(table, 0, BROADCAST_VALUES_TAG);
+    SendBuffer(controller, owned, 0, GATHER_VALUES_TAG);
   }
 
+  while (table->GetNumberOfColumns() != 0)
+  {
+    table->RemoveColumn(0);
+  }
+  AppendMapToTable(reducedMap, table);
   return 1;
 }
 
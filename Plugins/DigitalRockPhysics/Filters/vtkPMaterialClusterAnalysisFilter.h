@@ -27,7 +27,8 @@
  * Note that this filter has two levels of parallelization: it takes benefit of
  * data parallelism if it is enabled (eg. MPI), but it takes also benefit from
  * task parallelism using the SMP feature of VTK if enabled (OpenMP, TBB, etc.)
- * to perform faster.
+ * to perform faster. In parallel, every cluster label is reduced by the rank
+ * it hashes to, which returns the result to the ranks using that label.
  *
  * @par Thanks:
  * This class was written by Joachim Pouderoux and Mathieu Westphal, Kitware 2017
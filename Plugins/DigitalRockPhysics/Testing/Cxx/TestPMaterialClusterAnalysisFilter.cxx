@@ -0,0 +1,282 @@
+/*=========================================================================
+
+  Program:   ParaView
+  Module:    TestPMaterialClusterAnalysisFilter.cxx
+
+  Copyright (c) Kitware, Inc.
+  All rights reserved.
+  See Copyright.txt or http://www.paraview.org/HTML/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// Runs vtkPMaterialClusterAnalysisFilter on a synthetic porous medium split in
+// slabs over the ranks, with pores crossing the slabs, and checks its outputs
+// against a reduction of the clusters gathered on rank 0 and merged there in
+// rank order, as the filter used to do.
+#include "vtkCommunicator.h"
+#include "vtkDataArray.h"
+#include "vtkDoubleArray.h"
+#include "vtkFieldData.h"
+#include "vtkImageData.h"
+#include "vtkIntArray.h"
+#include "vtkMPIController.h"
+#include "vtkNew.h"
+#include "vtkPMaterialClusterAnalysisFilter.h"
+#include "vtkPointData.h"
+#include "vtkSmartPointer.h"
+#include "vtkTable.h"
+
+#include <vtk_mpi.h>
+
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <map>
+#include <set>
+#include <utility>
+#include <vector>
+
+namespace
+{
+typedef std::map<int, std::pair<double, std::array<double, 3> > >
+  LabelValuesMap; // cluster label -> { volume, barycenter }
+
+const int RockfillLabel = 0;
+const int PoreSize = 5;   // voxels, along each axis
+const int SlabHeight = 7; // voxels, not a multiple of PoreSize + 1
+const int GridSize = 24;  // voxels, along x and y
+
+// Pores of PoreSize^3 voxels separated by walls of rock, one voxel thick,
+// with their labels numbered along the global grid. Every third pore is
+// filled with rock.
+int GetLabel(int i, int j, int k)
+{
+  const int period = PoreSize + 1;
+  if (i % period == PoreSize || j % period == PoreSize || k % period == PoreSize)
+  {
+    return RockfillLabel;
+  }
+  const int pore = i / period + 10 * (j / period) + 100 * (k / period);
+  return pore % 3 == 2 ? RockfillLabel : pore + 1;
+}
+
+void Barycenter(double weight1, const double* point1, double weight2, const double* point2,
+  double* barycenter)
+{
+  double div = weight1 + weight2;
+  for (int i = 0; i < 3; i++)
+  {
+    barycenter[i] = (point1[i] * weight1 + point2[i] * weight2) / div;
+  }
+}
+
+void Merge(LabelValuesMap& lvMap, int label, double volume, const std::array<double, 3>& center)
+{
+  auto iter = lvMap.emplace(label, std::make_pair(volume, center));
+  if (!iter.second)
+  {
+    Barycenter(iter.first->second.first, &iter.first->second.second[0], volume, &center[0],
+      &iter.first->second.second[0]);
+    iter.first->second.first += volume;
+  }
+}
+
+// One tuple per cluster: label, volume and barycenter.
+void AppendValues(const LabelValuesMap& lvMap, vtkDoubleArray* values)
+{
+  for (const auto& it : lvMap)
+  {
+    const double tuple[5] = { static_cast<double>(it.first), it.second.first,
+      it.second.second[0], it.second.second[1], it.second.second[2] };
+    values->InsertNextTuple(tuple);
+  }
+}
+
+// The slab of the given rank, with its points labelled.
+void FillSlab(vtkImageData* image, int rank)
+{
+  image->SetExtent(
+    0, GridSize - 1, 0, GridSize - 1, rank * SlabHeight, (rank + 1) * SlabHeight - 1);
+  vtkNew<vtkIntArray> labels;
+  labels->SetName("Labels");
+  labels->SetNumberOfTuples(image->GetNumberOfPoints());
+  vtkIdType pointId = 0;
+  for (int k = rank * SlabHeight; k < (rank + 1) * SlabHeight; k++)
+  {
+    for (int j = 0; j < GridSize; j++)
+    {
+      for (int i = 0; i < GridSize; i++, pointId++)
+      {
+        labels->SetValue(pointId, GetLabel(i, j, k));
+      }
+    }
+  }
+  image->GetPointData()->SetScalars(labels);
+}
+
+// The reference reduction: the clusters of every rank are gathered on rank
+// 0, merged in rank order, and the result is broadcast to all the ranks.
+LabelValuesMap GatherReduce(vtkMultiProcessController* controller, vtkImageData* image)
+{
+  LabelValuesMap local;
+  vtkDataArray* labels = image->GetPointData()->GetScalars();
+  std::array<double, 3> point;
+  for (vtkIdType pointId = 0; pointId < image->GetNumberOfPoints(); pointId++)
+  {
+    int label = static_cast<int>(labels->GetTuple1(pointId));
+    if (label != RockfillLabel)
+    {
+      image->GetPoint(pointId, &point[0]);
+      Merge(local, label, 1., point);
+    }
+  }
+
+  vtkNew<vtkTable> table;
+  vtkNew<vtkDoubleArray> values;
+  values->SetName("Values");
+  values->SetNumberOfComponents(5);
+  AppendValues(local, values);
+  table->AddColumn(values);
+
+  std::vector<vtkSmartPointer<vtkDataObject> > recv;
+  controller->Gather(table, recv, 0);
+  vtkNew<vtkTable> reduced;
+  if (controller->GetLocalProcessId() == 0)
+  {
+    LabelValuesMap merged;
+    for (const auto& object : recv)
+    {
+      vtkTable* rankTable = vtkTable::SafeDownCast(object);
+      vtkDataArray* rankValues = rankTable ? rankTable->GetColumnByName("Values") : nullptr;
+      for (vtkIdType row = 0; rankValues && row < rankValues->GetNumberOfTuples(); row++)
+      {
+        double* tuple = rankValues->GetTuple(row);
+        Merge(merged, static_cast<int>(tuple[0]), tuple[1], { { tuple[2], tuple[3], tuple[4] } });
+      }
+    }
+    vtkNew<vtkDoubleArray> mergedValues;
+    mergedValues->SetName("Values");
+    mergedValues->SetNumberOfComponents(5);
+    AppendValues(merged, mergedValues);
+    reduced->AddColumn(mergedValues);
+  }
+  controller->Broadcast(reduced, 0);
+
+  LabelValuesMap result;
+  vtkDataArray* reducedValues = reduced->GetColumnByName("Values");
+  for (vtkIdType row = 0; reducedValues && row < reducedValues->GetNumberOfTuples(); row++)
+  {
+    double* tuple = reducedValues->GetTuple(row);
+    result[static_cast<int>(tuple[0])] =
+      std::make_pair(tuple[1], std::array<double, 3>{ { tuple[2], tuple[3], tuple[4] } });
+  }
+  return result;
+}
+
+bool CheckRank(vtkMultiProcessController* controller)
+{
+  const int rank = controller->GetLocalProcessId();
+  vtkNew<vtkImageData> image;
+  FillSlab(image, rank);
+  const LabelValuesMap reference = GatherReduce(controller, image);
+  if (reference.empty())
+  {
+    cerr << "ERROR: No cluster in the reference reduction." << endl;
+    return false;
+  }
+
+  vtkNew<vtkPMaterialClusterAnalysisFilter> filter;
+  filter->SetInputData(image);
+  filter->SetRockfillLabel(RockfillLabel);
+  filter->Update();
+  vtkImageData* output = vtkImageData::SafeDownCast(filter->GetOutputDataObject(0));
+  vtkDataArray* volumes = output ? output->GetPointData()->GetArray("Volume") : nullptr;
+  vtkDataArray* labels = output ? output->GetFieldData()->GetArray("Label") : nullptr;
+  vtkDataArray* tableVolumes = output ? output->GetFieldData()->GetArray("Volume") : nullptr;
+  vtkDataArray* centers = output ? output->GetFieldData()->GetArray("Center") : nullptr;
+  if (!volumes || !labels || !tableVolumes || !centers)
+  {
+    cerr << "ERROR: Missing output arrays." << endl;
+    return false;
+  }
+
+  // Every voxel gets the volume of its whole cluster.
+  vtkDataArray* voxelLabels = image->GetPointData()->GetScalars();
+  std::set<int> localLabels;
+  for (vtkIdType pointId = 0; pointId < image->GetNumberOfPoints(); pointId++)
+  {
+    int label = static_cast<int>(voxelLabels->GetTuple1(pointId));
+    double expected = 0.;
+    if (label != RockfillLabel)
+    {
+      localLabels.insert(label);
+      expected = reference.at(label).first;
+    }
+    if (volumes->GetTuple1(pointId) != expected)
+    {
+      cerr << "ERROR: Volume " << volumes->GetTuple1(pointId) << " instead of " << expected
+           << " for label " << label << "." << endl;
+      return false;
+    }
+  }
+
+  // Rank 0 lists every cluster, the other ranks the clusters they use.
+  const vtkIdType expectedRows =
+    static_cast<vtkIdType>(rank == 0 ? reference.size() : localLabels.size());
+  if (labels->GetNumberOfTuples() != expectedRows)
+  {
+    cerr << "ERROR: " << labels->GetNumberOfTuples() << " clusters instead of " << expectedRows
+         << "." << endl;
+    return false;
+  }
+  for (vtkIdType row = 0; row < labels->GetNumberOfTuples(); row++)
+  {
+    int label = static_cast<int>(labels->GetTuple1(row));
+    auto iter = reference.find(label);
+    if (iter == reference.end() || (rank != 0 && localLabels.count(label) == 0))
+    {
+      cerr << "ERROR: Unexpected cluster " << label << "." << endl;
+      return false;
+    }
+    double center[3];
+    centers->GetTuple(row, center);
+    for (int c = 0; c < 3; c++)
+    {
+      // The clusters of a rank are merged by the filter over several threads.
+      if (std::abs(center[c] - iter->second.second[c]) > 1e-9 * GridSize)
+      {
+        cerr << "ERROR: Center " << center[c] << " instead of " << iter->second.second[c]
+             << " for cluster " << label << "." << endl;
+        return false;
+      }
+    }
+    if (tableVolumes->GetTuple1(row) != iter->second.first)
+    {
+      cerr << "ERROR: Volume " << tableVolumes->GetTuple1(row) << " instead of "
+           << iter->second.first << " for cluster " << label << "." << endl;
+      return false;
+    }
+  }
+  return true;
+}
+}
+
+int main(int argc, char* argv[])
+{
+  MPI_Init(&argc, &argv);
+
+  vtkNew<vtkMPIController> controller;
+  controller->Initialize();
+  vtkMultiProcessController::SetGlobalController(controller);
+
+  // Every rank must pass.
+  int localSuccess = CheckRank(controller) ? 1 : 0;
+  int success = 0;
+  controller->AllReduce(&localSuccess, &success, 1, vtkCommunicator::MIN_OP);
+
+  controller->Finalize();
+  return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
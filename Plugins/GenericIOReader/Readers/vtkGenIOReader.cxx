@@ -48,9 +48,11 @@ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "vtkDataObject.h"
 #include "vtkDoubleArray.h"
 #include "vtkFloatArray.h"
+#include "vtkIdTypeArray.h"
 #include "vtkInformation.h"
 #include "vtkInformationVector.h"
 #include "vtkMultiProcessController.h"
+#include "vtkNew.h"
 #include "vtkObjectFactory.h"
 #include "vtkPointData.h"
 #include "vtkTypeInt16Array.h"
@@ -67,6 +69,7 @@ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "utils/timer.h"
 
 #include <algorithm>
+#include <memory>
 #include <numeric>
 #include <random>
 #include <thread>
@@ -281,6 +284,16 @@ void vtkGenIOReader::SelectValue2(const char* value2)
   }
 }
 
+void vtkGenIOReader::SetNumberOfThreads(int n)
+{
+  n = n > 0 ? n : std::max(1, (int)std::thread::hardware_concurrency());
+  if (concurentThreadsSupported != n)
+  {
+    concurentThreadsSupported = n;
+    this->Modified();
+  }
+}
+
 //
 // Utilities
 void vtkGenIOReader::SetCellArrayStatus(const char* name, int status)
@@ -410,144 +423,316 @@ bool vtkGenIOReader::doMPIDataSplitting(int numDataRanksTmp, int numMPIranks, in
   return splitReading;
 }
 
-void vtkGenIOReader::theadedParsing(int threadId, int numThreads, size_t numRowsToSample,
-  size_t numLoadingRows, vtkSmartPointer<vtkCellArray> cells, vtkSmartPointer<vtkPoints> pnts,
-  int numSelections)
+namespace
 {
-  GIOPvPlugin::Timer parseClock;
+//
+// Runs f(threadId) on numThreads threads
+template <typename F>
+void vtkGenIORunThreads(int numThreads, F f)
+{
+  std::vector<std::thread> threadPool;
+  for (int t = 1; t < numThreads; t++)
+    threadPool.push_back(std::thread(f, t));
+  f(0);
+  for (auto& th : threadPool)
+    th.join();
+}
 
-  // parseClock.start();
-  vtkIdType _idx;
+//
+// First item of part t when splitting n items in numThreads parts
+inline size_t vtkGenIOChunkStart(size_t n, int t, int numThreads)
+{
+  return static_cast<size_t>((static_cast<double>(n) * t) / numThreads);
+}
+
+//
+// Reads a row of a column as a double
+typedef double (*vtkGenIOGetter)(const void* data, size_t row);
+
+template <typename T>
+double vtkGenIOGetDouble(const void* data, size_t row)
+{
+  return static_cast<double>(static_cast<const T*>(data)[row]);
+}
+
+vtkGenIOGetter vtkGenIONewGetter(const std::string& dataType)
+{
+  if (dataType == "float")
+    return &vtkGenIOGetDouble<float>;
+  else if (dataType == "double")
+    return &vtkGenIOGetDouble<double>;
+  else if (dataType == "int8_t")
+    return &vtkGenIOGetDouble<int8_t>;
+  else if (dataType == "int16_t")
+    return &vtkGenIOGetDouble<int16_t>;
+  else if (dataType == "int32_t")
+    return &vtkGenIOGetDouble<int32_t>;
+  else if (dataType == "int64_t")
+    return &vtkGenIOGetDouble<int64_t>;
+  else if (dataType == "uint8_t")
+    return &vtkGenIOGetDouble<uint8_t>;
+  else if (dataType == "uint16_t")
+    return &vtkGenIOGetDouble<uint16_t>;
+  else if (dataType == "uint32_t")
+    return &vtkGenIOGetDouble<uint32_t>;
+  else if (dataType == "uint64_t")
+    return &vtkGenIOGetDouble<uint64_t>;
+  return nullptr;
+}
+
+//
+// Copies the kept rows of a column into an output array of the same type
+struct vtkGenIOColumnCopy
+{
+  int Size;
+  const char* Source;
+  char* Destination;
 
-  size_t rowsPerThread = floor(numLoadingRows / (float)numThreads);
-  size_t startRow = rowsPerThread * threadId;
-  size_t numRowsToSamplePerThread = floor(numRowsToSample / (float)numThreads);
-  if (threadId == numThreads - 1)
+  template <typename T>
+  void Gather(const size_t* rows, size_t count, vtkIdType offset) const
   {
-    size_t count = (numThreads - 1) * numRowsToSamplePerThread;
-    numRowsToSamplePerThread = numRowsToSample - count;
-    if (startRow + numRowsToSamplePerThread > numLoadingRows)
-      numRowsToSamplePerThread = numLoadingRows - startRow;
+    const T* source = reinterpret_cast<const T*>(this->Source);
+    T* destination = reinterpret_cast<T*>(this->Destination) + offset;
+    for (size_t j = 0; j < count; ++j)
+      destination[j] = source[rows[j]];
   }
 
-  double pnt[3];
-  for (size_t j = startRow; j < (startRow + numRowsToSamplePerThread); ++j)
+  void Gather(const size_t* rows, size_t count, vtkIdType offset) const
   {
-    // Choose random element to load
-    size_t _j = _num[j];
-    while (_j >= numLoadingRows)
-    {
-      mtx.lock();
-      size_t _nextHash = nextHash;
-      nextHash++;
-      mtx.unlock();
+    if (!this->Source)
+      std::fill_n(this->Destination + this->Size * offset, this->Size * count, 0);
+    else if (this->Size == 1)
+      this->Gather<uint8_t>(rows, count, offset);
+    else if (this->Size == 2)
+      this->Gather<uint16_t>(rows, count, offset);
+    else if (this->Size == 4)
+      this->Gather<uint32_t>(rows, count, offset);
+    else if (this->Size == 8)
+      this->Gather<uint64_t>(rows, count, offset);
+  }
+};
 
-      _j = _num[_nextHash];
-    }
+//
+// A selection resolved to its column: matches the rows whose value is
+// within [min, max], either bound being optional
+class vtkGenIOPredicate
+{
+public:
+  virtual ~vtkGenIOPredicate() = default;
+  virtual bool Matches(size_t row) const = 0;
+};
 
-    //
-    // Selection
-    if (numSelections != -1)
-    {
-      bool matchedCriteria = true;
-      for (int i = 0; i < numSelections; i++)
-      {
-        for (size_t k = 0; k < paraviewData.size(); k++)
-        {
-          ParaviewSelection __sel = selections[i];
+template <typename T>
+class vtkGenIORangePredicate : public vtkGenIOPredicate
+{
+public:
+  vtkGenIORangePredicate(const void* data, T min, T max, bool hasMin, bool hasMax)
+    : Data(static_cast<const T*>(data))
+    , Min(min)
+    , Max(max)
+    , HasMin(hasMin)
+    , HasMax(hasMax)
+  {
+  }
 
-          std::string _name = readInData[k].name;
-          if (_name == __sel.selectedScalar)
-          {
-            bool localMatchedCriteria = false;
-            std::string _dataType = readInData[k].dataType;
-
-            if (__sel.operatorType == 0)
-              localMatchedCriteria = readInData[k].equal(__sel.selectedValue[0], _dataType, _j);
-            else if (__sel.operatorType == 1)
-              localMatchedCriteria =
-                readInData[k].greaterEqual(__sel.selectedValue[0], _dataType, _j);
-            else if (__sel.operatorType == 2)
-              localMatchedCriteria = readInData[k].lessEqual(__sel.selectedValue[0], _dataType, _j);
-            else if (__sel.operatorType == 3)
-              localMatchedCriteria = readInData[k].isBetween(
-                __sel.selectedValue[0], __sel.selectedValue[1], _dataType, _j);
-
-            matchedCriteria = matchedCriteria && localMatchedCriteria;
-            if (!matchedCriteria)
-              break;
-          }
-        }
+  bool Matches(size_t row) const override
+  {
+    const T value = this->Data[row];
+    return (!this->HasMin || value >= this->Min) && (!this->HasMax || value <= this->Max);
+  }
 
-        if (!matchedCriteria)
-          break;
-      }
-      if (!matchedCriteria)
-        continue;
-    }
+private:
+  const T* Data;
+  T Min, Max;
+  bool HasMin, HasMax;
+};
 
-    mtx.lock();
-    _idx = idx;
-    idx++;
-    mtx.unlock();
+template <typename T>
+std::unique_ptr<vtkGenIOPredicate> vtkGenIOMakePredicate(
+  const void* data, const ParaviewSelection& sel, T (*parse)(std::string))
+{
+  const T value0 = parse(sel.selectedValue[0]);
+  vtkGenIOPredicate* predicate = nullptr;
+  if (sel.operatorType == 0) // is
+    predicate = new vtkGenIORangePredicate<T>(data, value0, value0, true, true);
+  else if (sel.operatorType == 1) // >=
+    predicate = new vtkGenIORangePredicate<T>(data, value0, value0, true, false);
+  else if (sel.operatorType == 2) // <=
+    predicate = new vtkGenIORangePredicate<T>(data, value0, value0, false, true);
+  else if (sel.operatorType == 3) // between
+    predicate =
+      new vtkGenIORangePredicate<T>(data, value0, parse(sel.selectedValue[1]), true, true);
+  return std::unique_ptr<vtkGenIOPredicate>(predicate);
+}
 
-    int tupleCount = 0;
-    for (size_t k = 0; k < paraviewData.size(); k++)
-    {
-      // Load the x,y,z variables
-      if (paraviewData[k].xVar)
-        pnt[0] = ((float*)readInData[k].data)[_j];
+//
+// Returns nullptr if no row can match: unknown data type or operator
+std::unique_ptr<vtkGenIOPredicate> vtkGenIONewPredicate(
+  const GIOPvPlugin::GioData& column, const ParaviewSelection& sel)
+{
+  using namespace GIOPvPlugin;
+  const std::string& dataType = column.dataType;
+  if (!column.data)
+    return nullptr;
+  else if (dataType == "float")
+    return vtkGenIOMakePredicate<float>(column.data, sel, &to_float);
+  else if (dataType == "double")
+    return vtkGenIOMakePredicate<double>(column.data, sel, &to_double);
+  else if (dataType == "int8_t")
+    return vtkGenIOMakePredicate<int8_t>(column.data, sel, &to_int8);
+  else if (dataType == "int16_t")
+    return vtkGenIOMakePredicate<int16_t>(column.data, sel, &to_int16);
+  else if (dataType == "int32_t")
+    return vtkGenIOMakePredicate<int32_t>(column.data, sel, &to_int32);
+  else if (dataType == "int64_t")
+    return vtkGenIOMakePredicate<int64_t>(column.data, sel, &to_int64);
+  else if (dataType == "uint8_t")
+    return vtkGenIOMakePredicate<uint8_t>(column.data, sel, &to_uint8);
+  else if (dataType == "uint16_t")
+    return vtkGenIOMakePredicate<uint16_t>(column.data, sel, &to_uint16);
+  else if (dataType == "uint32_t")
+    return vtkGenIOMakePredicate<uint32_t>(column.data, sel, &to_uint32);
+  else if (dataType == "uint64_t")
+    return vtkGenIOMakePredicate<uint64_t>(column.data, sel, &to_uint64);
+  return nullptr;
+}
+}
 
-      if (paraviewData[k].yVar)
-        pnt[1] = ((float*)readInData[k].data)[_j];
+void vtkGenIOReader::sampleRows(
+  size_t numRowsToSample, size_t numLoadingRows, std::vector<size_t>& rows)
+{
+  // The sample is the first numRowsToSample shuffled row numbers that exist
+  // in this rank.
+  if (numLoadingRows >= _num.size())
+  {
+    rows.assign(_num.begin(), _num.begin() + std::min(numRowsToSample, _num.size()));
+    return;
+  }
 
-      if (paraviewData[k].zVar)
-        pnt[2] = ((float*)readInData[k].data)[_j];
+  // Each thread counts these rows in its part of _num, an exclusive scan
+  // gives where they go in the sample.
+  const int numThreads = concurentThreadsSupported;
+  std::vector<size_t> offsets(numThreads + 1, 0);
+  vtkGenIORunThreads(numThreads, [&](int t) {
+    size_t count = 0;
+    const size_t end = vtkGenIOChunkStart(_num.size(), t + 1, numThreads);
+    for (size_t j = vtkGenIOChunkStart(_num.size(), t, numThreads); j < end; ++j)
+      count += (_num[j] < numLoadingRows) ? 1 : 0;
+    offsets[t + 1] = count;
+  });
+  std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+  rows.resize(std::min(numRowsToSample, offsets[numThreads]));
+  vtkGenIORunThreads(numThreads, [&](int t) {
+    size_t out = offsets[t];
+    const size_t end = vtkGenIOChunkStart(_num.size(), t + 1, numThreads);
+    for (size_t j = vtkGenIOChunkStart(_num.size(), t, numThreads); j < end && out < rows.size();
+         ++j)
+      if (_num[j] < numLoadingRows)
+        rows[out++] = _num[j];
+  });
+}
 
-      // Load the scalars that the user wants to see
-      if (paraviewData[k].show)
+void vtkGenIOReader::parseRows(const std::vector<size_t>& rows, vtkPoints* pnts, int numSelections)
+{
+  //
+  // Resolve the selections to typed comparisons on their columns
+  std::vector<std::unique_ptr<vtkGenIOPredicate> > predicates;
+  bool matchNone = false;
+  for (int i = 0; i < numSelections; i++)
+    for (size_t k = 0; k < paraviewData.size(); k++)
+      if (readInData[k].name == selections[i].selectedScalar)
       {
-        std::string _dataType = readInData[k].dataType;
-
-        mtx.lock();
-        if (_dataType == "float")
-          (tupleArray[tupleCount])->InsertTuple1(_idx, ((float*)readInData[k].data)[_j]);
-        else if (_dataType == "double")
-          (tupleArray[tupleCount])->InsertTuple1(_idx, ((double*)readInData[k].data)[_j]);
-        else if (_dataType == "int8_t")
-          (tupleArray[tupleCount])->InsertTuple1(_idx, ((int8_t*)readInData[k].data)[_j]);
-        else if (_dataType == "int16_t")
-          (tupleArray[tupleCount])->InsertTuple1(_idx, ((int16_t*)readInData[k].data)[_j]);
-        else if (_dataType == "int32_t")
-          (tupleArray[tupleCount])->InsertTuple1(_idx, ((int32_t*)readInData[k].data)[_j]);
-        else if (_dataType == "int64_t")
-          (tupleArray[tupleCount])->InsertTuple1(_idx, ((int64_t*)readInData[k].data)[_j]);
-        else if (_dataType == "uint8_t")
-          (tupleArray[tupleCount])->InsertTuple1(_idx, ((uint8_t*)readInData[k].data)[_j]);
-        else if (_dataType == "uint16_t")
-          (tupleArray[tupleCount])->InsertTuple1(_idx, ((uint16_t*)readInData[k].data)[_j]);
-        else if (_dataType == "uint32_t")
-          (tupleArray[tupleCount])->InsertTuple1(_idx, ((uint32_t*)readInData[k].data)[_j]);
-        else if (_dataType == "uint64_t")
-          (tupleArray[tupleCount])->InsertTuple1(_idx, ((uint64_t*)readInData[k].data)[_j]);
-        else
-          msgLog << _dataType << " ...data type undefined !!!";
-        mtx.unlock();
-
-        tupleCount++;
+        predicates.push_back(vtkGenIONewPredicate(readInData[k], selections[i]));
+        matchNone = matchNone || !predicates.back();
       }
+
+  //
+  // Each thread keeps the rows of its part of the sample that match the
+  // selections, an exclusive scan gives where they go in the output
+  const int numThreads = concurentThreadsSupported;
+  const bool selecting = !predicates.empty();
+  std::vector<std::vector<size_t> > keptRows(numThreads);
+  std::vector<vtkIdType> offsets(numThreads + 1, 0);
+  vtkGenIORunThreads(numThreads, [&](int t) {
+    const size_t begin = vtkGenIOChunkStart(rows.size(), t, numThreads);
+    const size_t end = vtkGenIOChunkStart(rows.size(), t + 1, numThreads);
+    if (matchNone)
+      return;
+    if (!selecting)
+    {
+      offsets[t + 1] = static_cast<vtkIdType>(end - begin);
+      return;
+    }
+    for (size_t j = begin; j < end; ++j)
+    {
+      bool matchedCriteria = true;
+      for (size_t i = 0; i < predicates.size() && matchedCriteria; i++)
+        matchedCriteria = predicates[i]->Matches(rows[j]);
+      if (matchedCriteria)
+        keptRows[t].push_back(rows[j]);
     }
+    offsets[t + 1] = static_cast<vtkIdType>(keptRows[t].size());
+  });
+  std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+  const vtkIdType numKept = offsets[numThreads];
+  if (numKept == 0)
+    return;
 
-    mtx.lock();
-    pnts->InsertPoint(_idx, pnt);
-    cells->InsertNextCell(1, &_idx);
-    totalPoints++;
-    mtx.unlock();
+  //
+  // Size the outputs, and resolve where each column goes
+  const vtkIdType start = totalPoints;
+  pnts->SetNumberOfPoints(start + numKept);
+  double* pntsData = static_cast<double*>(pnts->GetVoidPointer(0)) + 3 * start;
+
+  vtkGenIOGetter positionGetter[3] = { nullptr, nullptr, nullptr };
+  const void* positionData[3] = { nullptr, nullptr, nullptr };
+  std::vector<vtkGenIOColumnCopy> copies;
+  int tupleCount = 0;
+  for (size_t k = 0; k < paraviewData.size(); k++)
+  {
+    const bool axes[3] = { paraviewData[k].xVar, paraviewData[k].yVar, paraviewData[k].zVar };
+    for (int c = 0; c < 3; c++)
+      if (axes[c])
+      {
+        positionGetter[c] = vtkGenIONewGetter(readInData[k].dataType);
+        positionData[c] = readInData[k].data;
+      }
+
+    if (paraviewData[k].show)
+    {
+      vtkDataArray* array = tupleArray[tupleCount];
+      array->SetNumberOfTuples(start + numKept);
+      vtkGenIOColumnCopy copy;
+      copy.Size = array->GetDataTypeSize();
+      copy.Source = static_cast<const char*>(readInData[k].data);
+      copy.Destination = static_cast<char*>(array->GetVoidPointer(0)) + copy.Size * start;
+      if (copy.Size != readInData[k].size || !vtkGenIONewGetter(readInData[k].dataType))
+      {
+        msgLog << readInData[k].dataType << " ...data type undefined !!!";
+        copy.Source = nullptr;
+      }
+      copies.push_back(copy);
+      tupleCount++;
+    }
   }
 
-  // parseClock.stop();
-  // msgLog <<" time taken ~ parsing for thread id "  << threadId << " took " <<
-  // parseClock.getDuration() << " s.\n";
+  //
+  // Write the points and scalars of the kept rows in place
+  vtkGenIORunThreads(numThreads, [&](int t) {
+    const size_t* threadRows = selecting
+      ? keptRows[t].data()
+      : rows.data() + vtkGenIOChunkStart(rows.size(), t, numThreads);
+    const vtkIdType count = offsets[t + 1] - offsets[t];
+    double* pnt = pntsData + 3 * offsets[t];
+    for (vtkIdType j = 0; j < count; ++j, pnt += 3)
+      for (int c = 0; c < 3; c++)
+        pnt[c] = positionGetter[c] ? positionGetter[c](positionData[c], threadRows[j]) : 0.0;
+
+    for (const vtkGenIOColumnCopy& copy : copies)
+      copy.Gather(threadRows, static_cast<size_t>(count), offsets[t]);
+  });
+  totalPoints += numKept;
 }
 
 //
@@ -838,6 +1023,12 @@ int vtkGenIOReader::RequestData(
     if (paraviewData[i].position)
       paraviewData[i].load = 1;
 
+    // or if a selection is on it
+    if (sampleType == 3)
+      for (size_t j = 0; j < selections.size(); j++)
+        if (selections[j].selectedScalar == paraviewData[i].name)
+          paraviewData[i].load = 1;
+
     msgLog << "Var: " + std::string(_name) << " ~ show: " << paraviewData[i].show
            << " ~ load: " << paraviewData[i].load << "\n";
   }
@@ -877,7 +1068,7 @@ int vtkGenIOReader::RequestData(
 
   //
   // Generate a random number, sort of hashing really where each key is unique
-  if (!randomNumGenerated)
+  if (!randomNumGenerated || _num.size() < maxRowsInRank)
   {
     hashClock.start();
     _num.resize(maxRowsInRank);
@@ -893,12 +1084,8 @@ int vtkGenIOReader::RequestData(
 
   //
   // Initialize points and cells
-  idx = 0;
   vtkSmartPointer<vtkPoints> pnts = vtkSmartPointer<vtkPoints>::New();
-  // pnts = vtkSmartPointer<vtkPoints>::New();
   pnts->SetDataTypeToDouble();
-  // cells = vtkSmartPointer<vtkCellArray>::New();
-  vtkSmartPointer<vtkCellArray> cells = vtkSmartPointer<vtkCellArray>::New();
   tupleArray.resize(numVars);
 
   //
@@ -1051,18 +1238,13 @@ int vtkGenIOReader::RequestData(
 
         // Parse scalars
         parseClock.start();
-        nextHash = numLoadingRows;
-
-        std::vector<std::thread> threadPool;
-
-        for (int t = 0; t < concurentThreadsSupported; t++)
-          threadPool.push_back(std::thread(&vtkGenIOReader::theadedParsing, this, t,
-            concurentThreadsSupported, numRowsToSample, numLoadingRows, cells, pnts, -1));
-
-        for (auto& th : threadPool)
-          th.join();
+        std::vector<size_t> rows;
+        sampleRows(numRowsToSample, numLoadingRows, rows);
+        parseRows(rows, pnts, -1);
         parseClock.stop();
-        msgLog << " time taken ~ parsing: " << parseClock.getDuration() << " s.\n";
+        msgLog << " time taken ~ parsing: " << parseClock.getDuration() << " s, "
+               << rows.size() / std::max(parseClock.getDuration(), 1e-9) << " rows/s on "
+               << concurentThreadsSupported << " threads.\n";
 
         for (size_t j = 0; j < readInData.size(); j++)
           readInData[j].deAllocateMem();
@@ -1196,20 +1378,13 @@ int vtkGenIOReader::RequestData(
 
         // Load scalars
         parseClock.start();
-        nextHash = numLoadingRows;
-
-        std::vector<std::thread> threadPool;
-
-        for (int t = 0; t < concurentThreadsSupported; t++)
-          threadPool.push_back(
-            std::thread(&vtkGenIOReader::theadedParsing, this, t, concurentThreadsSupported,
-              numRowsToSample, numLoadingRows, cells, pnts, numSelections));
-
-        for (auto& th : threadPool)
-          th.join();
-
+        std::vector<size_t> rows;
+        sampleRows(numRowsToSample, numLoadingRows, rows);
+        parseRows(rows, pnts, numSelections);
         parseClock.stop();
-        msgLog << " time taken: " << parseClock.getDuration() << " s.\n";
+        msgLog << " time taken: " << parseClock.getDuration() << " s, "
+               << rows.size() / std::max(parseClock.getDuration(), 1e-9) << " rows/s on "
+               << concurentThreadsSupported << " threads.\n";
 
         //
         // Cleanup
@@ -1230,6 +1405,16 @@ int vtkGenIOReader::RequestData(
 
   cleanupClock.start();
 
+  // One vertex per point
+  vtkNew<vtkIdTypeArray> offsets;
+  offsets->SetNumberOfTuples(totalPoints + 1);
+  std::iota(offsets->GetPointer(0), offsets->GetPointer(0) + totalPoints + 1, vtkIdType(0));
+  vtkNew<vtkIdTypeArray> connectivity;
+  connectivity->SetNumberOfTuples(totalPoints);
+  std::iota(connectivity->GetPointer(0), connectivity->GetPointer(0) + totalPoints, vtkIdType(0));
+  vtkNew<vtkCellArray> cells;
+  cells->SetData(offsets, connectivity);
+
   output->SetPoints(pnts);
   output->SetCells(VTK_VERTEX, cells);
 
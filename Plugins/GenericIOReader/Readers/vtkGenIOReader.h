@@ -55,7 +55,6 @@ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "utils/gioData.h"
 #include "utils/log.h"
 
-#include <mutex>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -133,6 +132,11 @@ public:
   void SelectValue1(const char* value1);
   void SelectValue2(const char* value2);
 
+  //
+  // Number of threads parsing the rows read in, 0 for one per core
+  void SetNumberOfThreads(int n);
+  int GetNumberOfThreads() { return concurentThreadsSupported; }
+
   //
   // MPI Stuff
   void InitMPICommunicator();
@@ -154,8 +158,8 @@ protected:
     vtkInformationVector* outputVector) override;
   int RequestData(vtkInformation*, vtkInformationVector**, vtkInformationVector*) override;
 
-  void theadedParsing(int threadId, int numThreads, size_t numRowsToSample, size_t Np,
-    vtkSmartPointer<vtkCellArray> cells, vtkSmartPointer<vtkPoints> pnts, int numSelections = -1);
+  void sampleRows(size_t numRowsToSample, size_t numLoadingRows, std::vector<size_t>& rows);
+  void parseRows(const std::vector<size_t>& rows, vtkPoints* pnts, int numSelections = -1);
 
   void displayMsg(std::string msg);
 
@@ -165,7 +169,6 @@ private:
   int numRanks, myRank;
 
   // Threads
-  std::mutex mtx;
   int concurentThreadsSupported;
 
   // Sampling type
@@ -196,13 +199,11 @@ private:
   std::vector<vtkDataArray*> tupleArray;
   std::vector<ParaviewField> paraviewData; // data paraview shows
 
-  vtkIdType idx;
-  int totalPoints;
+  vtkIdType totalPoints;
 
   // Random numbers
   std::vector<size_t> _num;
   bool randomNumGenerated;
-  size_t nextHash;
 
   // data
   std::string dataFilename;
@@ -0,0 +1,282 @@
+/*=========================================================================
+
+  Program:   ParaView
+  Module:    TestGenIOReaderParseRate.cxx
+
+  Copyright (c) Kitware, Inc.
+  All rights reserved.
+  See Copyright.txt or http://www.paraview.org/HTML/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// Writes a synthetic GenericIO file with several data ranks, reads all its
+// rows with vtkGenIOReader on an increasing number of threads, and checks
+// that every thread count gives the same points and values. With
+// --benchmark, the rate of each thread count is reported, in rows read and
+// parsed per second. --rows and --ranks set the size of the file.
+#include "vtkDataArray.h"
+#include "vtkGenIOReader.h"
+#include "vtkMPIController.h"
+#include "vtkNew.h"
+#include "vtkPointData.h"
+#include "vtkTestUtilities.h"
+#include "vtkTimerLog.h"
+#include "vtkUnstructuredGrid.h"
+
+#include "GIO/CRC64.h"
+
+#include <vtk_mpi.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <vtksys/CommandLineArguments.hxx>
+
+namespace
+{
+// Layout of the little-endian GenericIO format, without block headers: the
+// global header, one header per variable and per rank, the CRC of the
+// headers, then for each rank the values of each variable followed by their
+// CRC.
+const std::size_t GlobalHeaderSize = 168;
+const std::size_t VariableHeaderSize = 272;
+const std::size_t RankHeaderSize = 48;
+const std::size_t CRCSize = 8;
+const std::size_t NameSize = 256;
+const std::uint64_t FloatValue = 1 << 0;
+const std::uint64_t SignedValue = 1 << 1;
+const std::uint64_t ValueIsPhysCoord[3] = { 1 << 2, 1 << 3, 1 << 4 };
+
+void Put(std::vector<char>& buffer, std::size_t offset, std::uint64_t value)
+{
+  for (int cc = 0; cc < 8; ++cc)
+  {
+    buffer[offset + cc] = static_cast<char>((value >> (8 * cc)) & 0xff);
+  }
+}
+
+// The values of one variable of one rank, and their CRC.
+void AppendBlock(std::vector<char>& file, const void* data, std::size_t size)
+{
+  const std::size_t start = file.size();
+  file.resize(start + size + CRCSize);
+  std::copy_n(static_cast<const char*>(data), size, &file[start]);
+  lanl::crc64_invert(lanl::crc64_omp(data, size), &file[start + size]);
+}
+
+// Writes numRanks ranks of numRows rows with float positions x, y and z, an
+// int64 "id" numbering all the rows and a float "mass".
+bool WriteFile(const std::string& fileName, int numRanks, std::uint64_t numRows)
+{
+  const char* names[5] = { "x", "y", "z", "id", "mass" };
+  const std::uint64_t sizes[5] = { 4, 4, 4, 8, 4 };
+  const std::uint64_t flags[5] = { FloatValue | SignedValue | ValueIsPhysCoord[0],
+    FloatValue | SignedValue | ValueIsPhysCoord[1], FloatValue | SignedValue | ValueIsPhysCoord[2],
+    SignedValue, FloatValue | SignedValue };
+  const std::uint64_t numVars = 5;
+  std::uint64_t recordSize = 0;
+  for (std::uint64_t var = 0; var < numVars; ++var)
+  {
+    recordSize += sizes[var];
+  }
+
+  const std::size_t varsStart = GlobalHeaderSize;
+  const std::size_t ranksStart = varsStart + numVars * VariableHeaderSize;
+  const std::size_t headerSize = ranksStart + numRanks * RankHeaderSize + CRCSize;
+  std::vector<char> file(headerSize, 0);
+  std::copy_n("HACC01L", 8, &file[0]);
+  Put(file, 8, headerSize - CRCSize);
+  Put(file, 16, numRanks * numRows);
+  Put(file, 24, static_cast<std::uint64_t>(numRanks));
+  Put(file, 32, 1);
+  Put(file, 40, 1);
+  Put(file, 48, numVars);
+  Put(file, 56, VariableHeaderSize);
+  Put(file, 64, varsStart);
+  Put(file, 72, static_cast<std::uint64_t>(numRanks));
+  Put(file, 80, RankHeaderSize);
+  Put(file, 88, ranksStart);
+  Put(file, 96, GlobalHeaderSize);
+  // PhysOrigin, PhysScale, BlocksSize and BlocksStart are 0.
+
+  for (std::uint64_t var = 0; var < numVars; ++var)
+  {
+    const std::size_t offset = varsStart + var * VariableHeaderSize;
+    std::copy_n(names[var], std::strlen(names[var]), &file[offset]);
+    Put(file, offset + NameSize, flags[var]);
+    Put(file, offset + NameSize + 8, sizes[var]);
+  }
+  for (int rank = 0; rank < numRanks; ++rank)
+  {
+    const std::size_t offset = ranksStart + rank * RankHeaderSize;
+    Put(file, offset, static_cast<std::uint64_t>(rank));
+    Put(file, offset + 24, numRows);
+    Put(file, offset + 32, headerSize + rank * (numRows * recordSize + numVars * CRCSize));
+    Put(file, offset + 40, static_cast<std::uint64_t>(rank));
+  }
+  lanl::crc64_invert(
+    lanl::crc64_omp(&file[0], headerSize - CRCSize), &file[headerSize - CRCSize]);
+
+  std::vector<float> positions[3];
+  std::vector<std::int64_t> ids(numRows);
+  std::vector<float> masses(numRows);
+  for (int rank = 0; rank < numRanks; ++rank)
+  {
+    for (int c = 0; c < 3; ++c)
+    {
+      positions[c].resize(numRows);
+    }
+    for (std::uint64_t row = 0; row < numRows; ++row)
+    {
+      const std::int64_t id = rank * numRows + row;
+      positions[0][row] = static_cast<float>(id % 100);
+      positions[1][row] = static_cast<float>((id / 100) % 100);
+      positions[2][row] = static_cast<float>(id / 10000);
+      ids[row] = id;
+      masses[row] = 0.5f * (id % 7);
+    }
+    for (int c = 0; c < 3; ++c)
+    {
+      AppendBlock(file, positions[c].data(), numRows * sizeof(float));
+    }
+    AppendBlock(file, ids.data(), numRows * sizeof(std::int64_t));
+    AppendBlock(file, masses.data(), numRows * sizeof(float));
+  }
+
+  std::ofstream stream(fileName.c_str(), std::ios::binary);
+  stream.write(file.data(), file.size());
+  return static_cast<bool>(stream);
+}
+
+// The sums of the ids and of the positions of all the points, which do not
+// depend on the order in which the rows were sampled.
+bool GetSums(vtkGenIOReader* reader, double sums[4])
+{
+  vtkUnstructuredGrid* output = reader->GetOutput();
+  vtkDataArray* ids = output ? output->GetPointData()->GetArray("id") : nullptr;
+  if (!ids || ids->GetNumberOfTuples() != output->GetNumberOfPoints())
+  {
+    return false;
+  }
+  std::fill(sums, sums + 4, 0.0);
+  for (vtkIdType cc = 0; cc < output->GetNumberOfPoints(); ++cc)
+  {
+    double point[3];
+    output->GetPoint(cc, point);
+    sums[0] += ids->GetTuple1(cc);
+    for (int c = 0; c < 3; ++c)
+    {
+      sums[c + 1] += point[c];
+    }
+  }
+  return true;
+}
+
+int Run(int argc, char* argv[])
+{
+  bool benchmark = false;
+  int numRows = 100000;
+  int numRanks = 8;
+  vtksys::CommandLineArguments arg;
+  arg.Initialize(argc, argv);
+  typedef vtksys::CommandLineArguments argT;
+  arg.AddBooleanArgument("--benchmark", &benchmark, "Report the parse rates.");
+  arg.AddArgument("--rows", argT::SPACE_ARGUMENT, &numRows, "Number of rows per data rank.");
+  arg.AddArgument("--ranks", argT::SPACE_ARGUMENT, &numRanks, "Number of data ranks.");
+  arg.StoreUnusedArguments(true);
+  if (!arg.Parse() || numRows <= 0 || numRanks <= 0)
+  {
+    cerr << "ERROR: Problem parsing arguments." << endl;
+    return EXIT_FAILURE;
+  }
+
+  char* tempDir =
+    vtkTestUtilities::GetArgOrEnvOrDefault("-T", argc, argv, "VTK_TEMP_DIR", "Testing/Temporary");
+  if (!tempDir)
+  {
+    cerr << "ERROR: Could not determine temporary directory." << endl;
+    return EXIT_FAILURE;
+  }
+  std::string fileName = std::string(tempDir) + "/TestGenIOReaderParseRate.gio";
+  delete[] tempDir;
+
+  if (!WriteFile(fileName, numRanks, static_cast<std::uint64_t>(numRows)))
+  {
+    cerr << "ERROR: Could not write '" << fileName << "'." << endl;
+    return EXIT_FAILURE;
+  }
+
+  const vtkIdType numPoints = static_cast<vtkIdType>(numRanks) * numRows;
+  const int maxThreads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+  std::vector<int> threadCounts;
+  for (int numThreads = 1; numThreads < maxThreads; numThreads *= 2)
+  {
+    threadCounts.push_back(numThreads);
+  }
+  threadCounts.push_back(maxThreads);
+
+  double reference[4];
+  for (size_t cc = 0; cc < threadCounts.size(); ++cc)
+  {
+    // A new reader for each thread count, so that no row is cached.
+    vtkNew<vtkGenIOReader> reader;
+    reader->SetFileName(&fileName[0]);
+    reader->SetPercentageType(0);
+    reader->SetDataPercentToShow(1.0);
+    reader->SetNumberOfThreads(threadCounts[cc]);
+
+    vtkNew<vtkTimerLog> timer;
+    timer->StartTimer();
+    reader->Update();
+    timer->StopTimer();
+
+    double sums[4];
+    if (reader->GetOutput()->GetNumberOfPoints() != numPoints || !GetSums(reader, sums))
+    {
+      cerr << "ERROR: Read " << reader->GetOutput()->GetNumberOfPoints() << " points instead of "
+           << numPoints << " on " << threadCounts[cc] << " threads." << endl;
+      return EXIT_FAILURE;
+    }
+    if (cc == 0)
+    {
+      std::copy(sums, sums + 4, reference);
+    }
+    else if (!std::equal(sums, sums + 4, reference))
+    {
+      cerr << "ERROR: Different points or ids on " << threadCounts[cc] << " threads." << endl;
+      return EXIT_FAILURE;
+    }
+
+    if (benchmark)
+    {
+      cout << threadCounts[cc] << " threads: " << numPoints / timer->GetElapsedTime()
+           << " rows/s (" << timer->GetElapsedTime() << " s)" << endl;
+    }
+  }
+  return EXIT_SUCCESS;
+}
+}
+
+int main(int argc, char* argv[])
+{
+  MPI_Init(&argc, &argv);
+
+  // vtkGenIOReader requires a global controller.
+  vtkNew<vtkMPIController> controller;
+  controller->Initialize();
+  vtkMultiProcessController::SetGlobalController(controller);
+
+  const int retVal = Run(argc, argv);
+
+  controller->Finalize();
+  return retVal;
+}
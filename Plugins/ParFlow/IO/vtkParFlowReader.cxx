@@ -9,14 +9,25 @@
 #include "vtkMultiProcessController.h"
 #include "vtkObjectFactory.h"
 #include "vtkPointData.h"
+#include "vtkSMPTools.h"
 #include "vtkVector.h"
 #include "vtkVectorOperators.h"
 
 #include "vtksys/FStream.hxx"
 
+#include <algorithm>
 #include <cctype>
+#include <cstring>
 #include <sstream>
 
+#if defined(_WIN32)
+#include <mutex>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 static constexpr std::streamoff headerSize = 6 * sizeof(double) + 4 * sizeof(int);
 static constexpr std::streamoff subgridHeaderSize = 9 * sizeof(int);
 static constexpr std::streamoff pfbEntrySize = sizeof(double);
@@ -45,6 +56,107 @@ static std::streamoff computeEntrySize(bool isCLM, int nz)
   return sz;
 }
 
+// Decode big-endian values. Composing each value from its bytes does not
+// depend on the host byte order, and compilers turn these loops into plain
+// (vectorized) loads and byte shuffles.
+static void decodeBigEndian(const unsigned char* src, double* dst, std::size_t n)
+{
+  for (std::size_t ii = 0; ii < n; ++ii, src += sizeof(double))
+  {
+    const vtkTypeUInt64 bits = (static_cast<vtkTypeUInt64>(src[0]) << 56) |
+      (static_cast<vtkTypeUInt64>(src[1]) << 48) | (static_cast<vtkTypeUInt64>(src[2]) << 40) |
+      (static_cast<vtkTypeUInt64>(src[3]) << 32) | (static_cast<vtkTypeUInt64>(src[4]) << 24) |
+      (static_cast<vtkTypeUInt64>(src[5]) << 16) | (static_cast<vtkTypeUInt64>(src[6]) << 8) |
+      static_cast<vtkTypeUInt64>(src[7]);
+    std::memcpy(dst + ii, &bits, sizeof(double));
+  }
+}
+
+static void decodeBigEndian(const unsigned char* src, int* dst, std::size_t n)
+{
+  for (std::size_t ii = 0; ii < n; ++ii, src += sizeof(int))
+  {
+    const vtkTypeUInt32 bits = (static_cast<vtkTypeUInt32>(src[0]) << 24) |
+      (static_cast<vtkTypeUInt32>(src[1]) << 16) | (static_cast<vtkTypeUInt32>(src[2]) << 8) |
+      static_cast<vtkTypeUInt32>(src[3]);
+    std::memcpy(dst + ii, &bits, sizeof(int));
+  }
+}
+
+class vtkParFlowReader::vtkBlockFile
+{
+public:
+  explicit vtkBlockFile(const char* filename)
+  {
+#if defined(_WIN32)
+    this->Stream.open(filename, std::ios::binary);
+#else
+    this->Descriptor = open(filename, O_RDONLY);
+#endif
+  }
+
+  ~vtkBlockFile()
+  {
+#if !defined(_WIN32)
+    if (this->Descriptor >= 0)
+    {
+      close(this->Descriptor);
+    }
+#endif
+  }
+
+  vtkBlockFile(const vtkBlockFile&) = delete;
+  void operator=(const vtkBlockFile&) = delete;
+
+  bool IsOpen() const
+  {
+#if defined(_WIN32)
+    return this->Stream.good();
+#else
+    return this->Descriptor >= 0;
+#endif
+  }
+
+  /// Read \a size bytes at \a offset; returns false unless all of them were read.
+  bool ReadAt(std::streamoff offset, void* buffer, std::size_t size)
+  {
+    char* data = static_cast<char*>(buffer);
+#if defined(_WIN32)
+    // No positioned reads: serialize the seek and read.
+    std::lock_guard<std::mutex> lock(this->Mutex);
+    this->Stream.clear();
+    this->Stream.seekg(offset, std::ios::beg);
+    this->Stream.read(data, size);
+    return static_cast<std::size_t>(this->Stream.gcount()) == size;
+#else
+    while (size > 0)
+    {
+      const ssize_t count = pread(this->Descriptor, data, size, static_cast<off_t>(offset));
+      if (count < 0 && errno == EINTR)
+      {
+        continue;
+      }
+      if (count <= 0)
+      {
+        return false;
+      }
+      data += count;
+      offset += count;
+      size -= static_cast<std::size_t>(count);
+    }
+    return true;
+#endif
+  }
+
+private:
+#if defined(_WIN32)
+  std::mutex Mutex;
+  vtksys::ifstream Stream;
+#else
+  int Descriptor;
+#endif
+};
+
 vtkStandardNewMacro(vtkParFlowReader);
 
 vtkParFlowReader::vtkParFlowReader()
@@ -53,6 +165,9 @@ vtkParFlowReader::vtkParFlowReader()
   , CLMIrrType(0)
   , NZ(0)
   , InferredAsCLM(-1)
+  , ScannedResolution(0, 0, 0)
+  , ScannedSubGrids(0)
+  , ScannedAsCLM(-1)
 {
   this->SetNumberOfInputPorts(0);
 }
@@ -98,8 +213,8 @@ int vtkParFlowReader::RequestData(vtkInformation* vtkNotUsed(request),
     return 0;
   }
 
-  vtksys::ifstream pfb(this->FileName, std::ios::binary);
-  if (!pfb.good())
+  vtkBlockFile pfb(this->FileName);
+  if (!pfb.IsOpen())
   {
     vtkErrorMacro("Unable to open file.");
     return 0;
@@ -148,8 +263,9 @@ int vtkParFlowReader::RequestData(vtkInformation* vtkNotUsed(request),
   }
 
   // When run in parallel, we choose a range of blocks
-  // to load from those available.
-  int rank = 1;
+  // to load from those available. Without a controller, this process reads
+  // all of them, as rank 0 of 1.
+  int rank = 0;
   int jbsz = 1;
   auto mpc = vtkMultiProcessController::GetGlobalController();
   if (mpc)
@@ -163,26 +279,19 @@ int vtkParFlowReader::RequestData(vtkInformation* vtkNotUsed(request),
   vtkVector3d dx;
   int numSubGrids;
 
-  pfb.seekg(0);
-  pfb.read(reinterpret_cast<char*>(xx.GetData()), 3 * sizeof(double));
-  pfb.read(reinterpret_cast<char*>(nn.GetData()), 3 * sizeof(int));
-  pfb.read(reinterpret_cast<char*>(dx.GetData()), 3 * sizeof(double));
-  pfb.read(reinterpret_cast<char*>(&numSubGrids), sizeof(int));
-
-  // Swap bytes as required knowing that we started with big-endian data:
-  vtkByteSwap::SwapBERange(xx.GetData(), 3);
-  vtkByteSwap::SwapBERange(nn.GetData(), 3);
-  vtkByteSwap::SwapBERange(dx.GetData(), 3);
-  vtkByteSwap::SwapBE(&numSubGrids);
-
-  this->NZ = nn[2]; // For computing size of CLM state.
-
-  std::streamoff measuredHeaderSize = pfb.tellg();
-  if (measuredHeaderSize != headerSize)
+  unsigned char header[headerSize];
+  if (!pfb.ReadAt(0, header, sizeof(header)))
   {
     vtkErrorMacro("Header size mismatch");
     return 0;
   }
+  // The data is big-endian:
+  decodeBigEndian(header, xx.GetData(), 3);
+  decodeBigEndian(header + 3 * sizeof(double), nn.GetData(), 3);
+  decodeBigEndian(header + 3 * sizeof(double) + 3 * sizeof(int), dx.GetData(), 3);
+  decodeBigEndian(header + 6 * sizeof(double) + 3 * sizeof(int), &numSubGrids, 1);
+
+  this->NZ = nn[2]; // For computing size of CLM state.
 
 #if 0
   std::cout
@@ -193,19 +302,62 @@ int vtkParFlowReader::RequestData(vtkInformation* vtkNotUsed(request),
     << "  subgrids   " << numSubGrids << "\n";
 #endif
 
-  // Update {I,J,K}Divs on rank 0 by reading file:
-  this->ScanBlocks(pfb, numSubGrids);
-  // Update {I,J,K}Divs on ranks > 0 via network:
-  this->BroadcastBlocks();
-
   int gridLo = (rank * numSubGrids) / jbsz;
   int gridHi = ((rank + 1) * numSubGrids) / jbsz;
   // std::cout << "Rank " << rank << " owns subgrids " << gridLo << " -- " << gridHi << "\n";
+  std::vector<vtkSmartPointer<vtkImageData> > blocks(gridHi > gridLo ? gridHi - gridLo : 0);
+
+  // Blocks are not read when their header does not match {I,J,K}Divs. When
+  // {I,J,K}Divs was reused from a previous file, the file is scanned and its
+  // blocks read again.
+  bool rescan = false;
+  for (int attempt = 0; attempt < 2; ++attempt)
+  {
+    // Update {I,J,K}Divs on rank 0 by reading file, unless those of the previous file still hold:
+    if (rank == 0 && (rescan || !this->CheckBlocks(pfb, nn, numSubGrids)))
+    {
+      vtksys::ifstream scan(this->FileName, std::ios::binary);
+      this->ScanBlocks(scan, numSubGrids);
+      this->ScannedResolution = nn;
+      this->ScannedSubGrids = numSubGrids;
+      this->ScannedAsCLM = this->InferredAsCLM;
+      rescan = false;
+    }
+    // Update {I,J,K}Divs on ranks > 0 via network:
+    this->BroadcastBlocks();
+
+    // Read this rank's blocks concurrently:
+    vtkSMPTools::For(gridLo, gridHi, 1, [&](vtkIdType begin, vtkIdType end) {
+      for (vtkIdType ni = begin; ni < end; ++ni)
+      {
+        blocks[ni - gridLo] = this->ReadBlock(pfb, xx, dx, arrayName, static_cast<int>(ni));
+      }
+    });
+
+    int failed = std::any_of(blocks.begin(), blocks.end(),
+      [](const vtkSmartPointer<vtkImageData>& block) { return !block; });
+    if (mpc)
+    {
+      int anyFailed = 0;
+      mpc->AllReduce(&failed, &anyFailed, 1, vtkCommunicator::MAX_OP);
+      failed = anyFailed;
+    }
+    if (!failed)
+    {
+      break;
+    }
+    rescan = true;
+  }
 
   output->SetNumberOfBlocks(numSubGrids);
   for (int ni = gridLo; ni < gridHi; ++ni)
   {
-    this->ReadBlock(pfb, output, xx, dx, arrayName, ni);
+    if (!blocks[ni - gridLo])
+    {
+      vtkErrorMacro("Unable to read subgrid " << ni);
+      continue;
+    }
+    output->SetBlock(ni, blocks[ni - gridLo]);
   }
 
   // Prevent accidents; don't preserve across calls to RequestData:
@@ -230,6 +382,49 @@ bool vtkParFlowReader::ReadSubgridHeader(
   return pfb.good() && !pfb.eof();
 }
 
+bool vtkParFlowReader::ReadSubgridHeader(
+  vtkBlockFile& pfb, std::streamoff offset, vtkVector3i& si, vtkVector3i& sn, vtkVector3i& sr)
+{
+  unsigned char header[subgridHeaderSize];
+  if (!pfb.ReadAt(offset, header, sizeof(header)))
+  {
+    return false;
+  }
+  decodeBigEndian(header, si.GetData(), 3);
+  decodeBigEndian(header + 3 * sizeof(int), sn.GetData(), 3);
+  decodeBigEndian(header + 6 * sizeof(int), sr.GetData(), 3);
+  return true;
+}
+
+bool vtkParFlowReader::CheckBlocks(
+  vtkBlockFile& pfb, const vtkVector3i& resolution, int numSubGrids) const
+{
+  // Subgrid divisions are only reused for files with the same layout as the
+  // last one scanned...
+  if (this->ScannedSubGrids != numSubGrids || this->ScannedResolution != resolution ||
+    this->ScannedAsCLM != this->InferredAsCLM)
+  {
+    return false;
+  }
+  // ... and when the header of the last subgrid is where the divisions put it:
+  vtkVector3i si;
+  vtkVector3i sn;
+  vtkVector3i sr;
+  if (!this->ReadSubgridHeader(pfb, this->GetBlockOffset(numSubGrids - 1), si, sn, sr))
+  {
+    return false;
+  }
+  for (int ijk = 0; ijk < 3; ++ijk)
+  {
+    const auto& divs = this->IJKDivs[ijk];
+    if (divs.size() < 2 || si[ijk] != divs[divs.size() - 2] || si[ijk] + sn[ijk] != divs.back())
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
 void vtkParFlowReader::ScanBlocks(istream& pfb, int vtkNotUsed(numSubGrids))
 {
   auto mpc = vtkMultiProcessController::GetGlobalController();
@@ -350,81 +545,93 @@ std::streamoff vtkParFlowReader::GetEndOffset() const
   return offset;
 }
 
-void vtkParFlowReader::ReadBlock(istream& pfb, vtkMultiBlockDataSet* output, vtkVector3d& origin,
-  vtkVector3d& spacing, const std::string& arrayName, int blockId)
+vtkSmartPointer<vtkImageData> vtkParFlowReader::ReadBlock(vtkBlockFile& pfb,
+  const vtkVector3d& origin, const vtkVector3d& spacing, const std::string& arrayName,
+  int blockId) const
 {
   vtkVector3i si;
   vtkVector3i sn;
   vtkVector3i sr;
 
-  // Move file cursor to start of block.
   std::streamoff blockOffset = this->GetBlockOffset(blockId);
-  pfb.seekg(blockOffset);
+  if (!this->ReadSubgridHeader(pfb, blockOffset, si, sn, sr))
+  {
+    return nullptr;
+  }
+  // The block must be where {I,J,K}Divs puts it, or the offset was wrong:
+  int gridTopo[2] = { static_cast<int>(this->IJKDivs[0].size() - 1),
+    static_cast<int>(this->IJKDivs[1].size() - 1) };
+  vtkVector3i blockIJK(blockId % gridTopo[0], (blockId / gridTopo[0]) % gridTopo[1],
+    blockId / gridTopo[0] / gridTopo[1]);
+  for (int ijk = 0; ijk < 3; ++ijk)
+  {
+    const auto& divs = this->IJKDivs[ijk];
+    if (blockIJK[ijk] + 1 >= static_cast<int>(divs.size()) || si[ijk] != divs[blockIJK[ijk]] ||
+      si[ijk] + sn[ijk] != divs[blockIJK[ijk] + 1])
+    {
+      return nullptr;
+    }
+  }
+
+  auto image = vtkSmartPointer<vtkImageData>::New();
+  image->SetOrigin(origin.GetData());
+  image->SetSpacing(spacing.GetData());
 
-  if (this->ReadSubgridHeader(pfb, si, sn, sr))
+  std::vector<std::string> names;
+  if (this->InferredAsCLM)
   {
-    vtkNew<vtkImageData> image;
-    image->SetOrigin(origin.GetData());
-    image->SetSpacing(spacing.GetData());
+    // The CLM files have the full simulation extent listed but only
+    // provide data on the top 2-d surface:
+    image->SetExtent(si[0], si[0] + sn[0], si[1], si[1] + sn[1], si[2], si[2]);
 
-    if (this->InferredAsCLM)
+    const int numCLMVars = sn[2] - si[2];
+    for (int cc = 0; cc < clmBaseComponents && cc < numCLMVars; ++cc)
     {
-      // The CLM files have the full simulation extent listed but only
-      // provide data on the top 2-d surface:
-      image->SetExtent(si[0], si[0] + sn[0], si[1], si[1] + sn[1], si[2], si[2]);
-
-      const int numCLMVars = sn[2] - si[2];
-      int numComponents = 0;
-      for (int cc = 0; cc < clmBaseComponents && cc < numCLMVars; ++cc, ++numComponents)
-      {
-        vtkNew<vtkDoubleArray> field;
-        field->SetName(clmBaseComponentNames[cc]);
-        this->ReadBlockIntoArray(pfb, image, field);
-      }
-      switch (this->CLMIrrType)
-      {
-        case 1:
-        {
-          vtkNew<vtkDoubleArray> field;
-          field->SetName("qflx_qirr");
-          this->ReadBlockIntoArray(pfb, image, field);
-          ++numComponents;
-        }
+      names.push_back(clmBaseComponentNames[cc]);
+    }
+    switch (this->CLMIrrType)
+    {
+      case 1:
+        names.push_back("qflx_qirr");
         break;
-        case 3:
-        {
-          vtkNew<vtkDoubleArray> field;
-          field->SetName("qflx_qirr_inst");
-          this->ReadBlockIntoArray(pfb, image, field);
-          ++numComponents;
-        }
+      case 3:
+        names.push_back("qflx_qirr_inst");
+        break;
+      default:
         break;
-        default:
-          break;
-      }
-      for (int cz = 0; numComponents < numCLMVars; ++cz, ++numComponents)
-      {
-        vtkNew<vtkDoubleArray> field;
-        std::ostringstream name;
-        name << "tsoil_" << cz;
-        field->SetName(name.str().c_str());
-        this->ReadBlockIntoArray(pfb, image, field);
-      }
     }
-    else
+    for (int cz = 0; static_cast<int>(names.size()) < numCLMVars; ++cz)
     {
-      // Read a single PFB state variable:
-      vtkNew<vtkDoubleArray> field;
-      image->SetExtent(si[0], si[0] + sn[0], si[1], si[1] + sn[1], si[2], si[2] + sn[2]);
-      field->SetName(arrayName.c_str());
-      this->ReadBlockIntoArray(pfb, image, field);
+      std::ostringstream name;
+      name << "tsoil_" << cz;
+      names.push_back(name.str());
     }
+  }
+  else
+  {
+    // Read a single PFB state variable:
+    image->SetExtent(si[0], si[0] + sn[0], si[1], si[1] + sn[1], si[2], si[2] + sn[2]);
+    names.push_back(arrayName);
+  }
 
-    output->SetBlock(blockId, image);
+  // Fetch the values of all the block's arrays with a single read:
+  std::vector<unsigned char> buffer(sizeof(double) * names.size() * image->GetNumberOfCells());
+  if (!pfb.ReadAt(blockOffset + subgridHeaderSize, buffer.data(), buffer.size()))
+  {
+    return nullptr;
+  }
+  const unsigned char* data = buffer.data();
+  for (const auto& name : names)
+  {
+    vtkNew<vtkDoubleArray> field;
+    field->SetName(name.c_str());
+    vtkParFlowReader::ReadBlockIntoArray(data, image, field);
   }
+  return image;
 }
 
-void vtkParFlowReader::ReadBlockIntoArray(istream& file, vtkImageData* img, vtkDoubleArray* arr)
+void vtkParFlowReader::ReadBlockIntoArray(
+  const unsigned char*& data, vtkImageData* img, vtkDoubleArray* arr)
 {
   arr->SetNumberOfTuples(img->GetNumberOfCells());
   auto cellData = img->GetCellData();
@@ -437,8 +644,6 @@ void vtkParFlowReader::ReadBlockIntoArray(istream& file, vtkImageData* img, vtkD
   }
 
   vtkIdType numValues = arr->GetNumberOfTuples() * arr->GetNumberOfComponents();
-  file.read(reinterpret_cast<char*>(arr->GetVoidPointer(0)), sizeof(double) * numValues);
-  vtkByteSwap::SwapBERange(reinterpret_cast<double*>(arr->GetVoidPointer(0)), numValues);
-  // std::cout << arr->GetNumberOfComponents() << " " << numValues << "Read to byte " << pfb.tellg()
-  // << "\n";
+  decodeBigEndian(data, arr->GetPointer(0), static_cast<std::size_t>(numValues));
+  data += sizeof(double) * numValues;
 }
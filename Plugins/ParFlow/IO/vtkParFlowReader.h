@@ -5,6 +5,7 @@
 #include "vtkMultiBlockDataSetAlgorithm.h"
 #include "vtkParFlowIOModule.h"
 
+#include "vtkSmartPointer.h"
 #include "vtkVector.h"
 
 #include <vector>
@@ -20,6 +21,7 @@ class vtkMultiBlockDataSet;
   * This reader will work in parallel settings by
   * splitting existing blocks among ranks.
   * If there are fewer blocks than ranks, some processes will do no work.
+  * Each rank reads its blocks concurrently, with positioned reads.
   * You may use "pftools dist" to repartition the data into a different
   * number of blocks (known in ParFlow as subgrids).
   *
@@ -79,6 +81,20 @@ protected:
   /// This sets IJKDivs on all ranks.
   void BroadcastBlocks();
 
+  /// Positioned reads of a file, which threads may issue concurrently.
+  class vtkBlockFile;
+
+  /// Check on rank 0 that the grid topology scanned for a previous file
+  /// holds for this one.
+  ///
+  /// Files with the same header as the previously scanned one (such as the
+  /// other time steps of a run) usually share its subgrids, in which case
+  /// IJKDivs is reused instead of scanned again. The header of the last
+  /// subgrid is read to confirm it. Reading every header here would cost
+  /// more than scanning; instead, ReadBlock() checks the header of each block
+  /// it reads, and the file is scanned again if one does not match.
+  bool CheckBlocks(vtkBlockFile& file, const vtkVector3i& resolution, int numSubGrids) const;
+
   /// Use grid topology to compute a block (subgrid) offset.
   ///
   /// Only call this after IJKDivs has been set.
@@ -93,27 +109,38 @@ protected:
   std::streamoff GetEndOffset() const;
 
   static bool ReadSubgridHeader(istream& pfb, vtkVector3i& si, vtkVector3i& sn, vtkVector3i& sr);
+  static bool ReadSubgridHeader(vtkBlockFile& pfb, std::streamoff offset, vtkVector3i& si,
+    vtkVector3i& sn, vtkVector3i& sr);
 
-  /// Read a single block from the file
-  void ReadBlock(istream& file, vtkMultiBlockDataSet* output, vtkVector3d& origin,
-    vtkVector3d& spacing, const std::string& arrayName, int block);
+  /// Read a single block from the file.
+  ///
+  /// This is called concurrently for the blocks of a rank and returns null
+  /// if the block could not be read or if its header does not match IJKDivs.
+  vtkSmartPointer<vtkImageData> ReadBlock(vtkBlockFile& file, const vtkVector3d& origin,
+    const vtkVector3d& spacing, const std::string& arrayName, int block) const;
 
   /// Given the size of the whole grid, the number of subgrids on each axis, and a block IJK
   /// return the min and max node coordinates for that block.
   static void GetBlockExtent(const vtkVector3i& wholeExtentIn, const vtkVector3i& numberOfBlocksIn,
     const vtkVector3i& blockIJKIn, vtkVector3i& blockExtentMinOut, vtkVector3i& blockExtentMaxOut);
 
-  static void ReadBlockIntoArray(istream& file, vtkImageData* img, vtkDoubleArray* arr);
+  /// Add an array to the image and fill it from big-endian data, advancing \a data past it.
+  static void ReadBlockIntoArray(
+    const unsigned char*& data, vtkImageData* img, vtkDoubleArray* arr);
 
   /// The filename, which must be a valid path before RequestData is called.
   char* FileName;
   int IsCLMFile;
   int CLMIrrType;
-  /// IJKDivs, NZ, and InferredAsCLM are only valid inside RequestData; used to compute subgrid
+  /// NZ and InferredAsCLM are only valid inside RequestData; used to compute subgrid
   /// offsets.
   std::vector<int> IJKDivs[3];
   int NZ;
   int InferredAsCLM;
+  /// The file header values IJKDivs was scanned for, which lets the next files reuse it.
+  vtkVector3i ScannedResolution;
+  int ScannedSubGrids;
+  int ScannedAsCLM;
 };
 
 #endif // vtkParflowReader_h
@@ -0,0 +1,209 @@
+// See license.md for copyright information.
+// Writes .pfb files split into several subgrids and checks that
+// vtkParFlowReader reads the same values with one thread, as a serial read
+// would, and with all threads. The second file has the same header and the
+// same last subgrid as the first, but other subgrid divisions, so the
+// divisions of the first file do not hold for it.
+#include "vtkCellData.h"
+#include "vtkDataArray.h"
+#include "vtkImageData.h"
+#include "vtkMultiBlockDataSet.h"
+#include "vtkNew.h"
+#include "vtkParFlowReader.h"
+#include "vtkSMPTools.h"
+#include "vtkTestUtilities.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+const int Resolution[3] = { 10, 7, 4 };
+
+double Value(int i, int j, int k)
+{
+  return i + 100.0 * j + 10000.0 * k + 0.25;
+}
+
+void PutBigEndian(std::ofstream& file, std::uint64_t bits, int size)
+{
+  for (int cc = size - 1; cc >= 0; --cc)
+  {
+    file.put(static_cast<char>((bits >> (8 * cc)) & 0xff));
+  }
+}
+
+void PutInt(std::ofstream& file, int value)
+{
+  PutBigEndian(file, static_cast<std::uint32_t>(value), 4);
+}
+
+void PutDouble(std::ofstream& file, double value)
+{
+  std::uint64_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  PutBigEndian(file, bits, 8);
+}
+
+// Writes a .pfb file whose subgrids divide each axis at `divs`.
+bool WriteFile(const std::string& fileName, const std::vector<int> divs[3])
+{
+  std::ofstream file(fileName.c_str(), std::ios::binary);
+  const int numSubGrids = static_cast<int>(
+    (divs[0].size() - 1) * (divs[1].size() - 1) * (divs[2].size() - 1));
+  for (int ijk = 0; ijk < 3; ++ijk)
+  {
+    PutDouble(file, 0.0);
+  }
+  for (int ijk = 0; ijk < 3; ++ijk)
+  {
+    PutInt(file, Resolution[ijk]);
+  }
+  for (int ijk = 0; ijk < 3; ++ijk)
+  {
+    PutDouble(file, 1.0);
+  }
+  PutInt(file, numSubGrids);
+
+  for (size_t bk = 0; bk + 1 < divs[2].size(); ++bk)
+  {
+    for (size_t bj = 0; bj + 1 < divs[1].size(); ++bj)
+    {
+      for (size_t bi = 0; bi + 1 < divs[0].size(); ++bi)
+      {
+        const int lo[3] = { divs[0][bi], divs[1][bj], divs[2][bk] };
+        const int hi[3] = { divs[0][bi + 1], divs[1][bj + 1], divs[2][bk + 1] };
+        for (int ijk = 0; ijk < 3; ++ijk)
+        {
+          PutInt(file, lo[ijk]);
+        }
+        for (int ijk = 0; ijk < 3; ++ijk)
+        {
+          PutInt(file, hi[ijk] - lo[ijk]);
+        }
+        for (int ijk = 0; ijk < 3; ++ijk)
+        {
+          PutInt(file, 1);
+        }
+        for (int k = lo[2]; k < hi[2]; ++k)
+        {
+          for (int j = lo[1]; j < hi[1]; ++j)
+          {
+            for (int i = lo[0]; i < hi[0]; ++i)
+            {
+              PutDouble(file, Value(i, j, k));
+            }
+          }
+        }
+      }
+    }
+  }
+  return file.good();
+}
+
+// Checks that every cell of the grid is read once, with its value.
+bool CheckOutput(vtkMultiBlockDataSet* output, unsigned int numSubGrids)
+{
+  if (output->GetNumberOfBlocks() != numSubGrids)
+  {
+    cerr << "ERROR: " << output->GetNumberOfBlocks() << " blocks instead of " << numSubGrids
+         << "." << endl;
+    return false;
+  }
+  std::vector<int> reads(Resolution[0] * Resolution[1] * Resolution[2], 0);
+  for (unsigned int block = 0; block < numSubGrids; ++block)
+  {
+    vtkImageData* image = vtkImageData::SafeDownCast(output->GetBlock(block));
+    vtkDataArray* values = image ? image->GetCellData()->GetScalars() : nullptr;
+    if (!values)
+    {
+      cerr << "ERROR: block " << block << " was not read." << endl;
+      return false;
+    }
+    int extent[6];
+    image->GetExtent(extent);
+    vtkIdType cell = 0;
+    for (int k = extent[4]; k < extent[5]; ++k)
+    {
+      for (int j = extent[2]; j < extent[3]; ++j)
+      {
+        for (int i = extent[0]; i < extent[1]; ++i, ++cell)
+        {
+          if (values->GetTuple1(cell) != Value(i, j, k))
+          {
+            cerr << "ERROR: cell (" << i << ", " << j << ", " << k << ") of block " << block
+                 << " is " << values->GetTuple1(cell) << " instead of " << Value(i, j, k) << "."
+                 << endl;
+            return false;
+          }
+          ++reads[i + Resolution[0] * (j + Resolution[1] * k)];
+        }
+      }
+    }
+  }
+  for (int read : reads)
+  {
+    if (read != 1)
+    {
+      cerr << "ERROR: a cell was read " << read << " times." << endl;
+      return false;
+    }
+  }
+  return true;
+}
+}
+
+int main(int argc, char* argv[])
+{
+  char* tempDir =
+    vtkTestUtilities::GetArgOrEnvOrDefault("-T", argc, argv, "VTK_TEMP_DIR", "Testing/Temporary");
+  if (!tempDir)
+  {
+    cerr << "ERROR: Could not determine temporary directory." << endl;
+    return EXIT_FAILURE;
+  }
+  const std::string prefix = std::string(tempDir) + "/TestParFlowReader_";
+  delete[] tempDir;
+
+  // 3 x 2 x 2 subgrids; the second file only moves the first X division.
+  const std::vector<int> divs[2][3] = { { { 0, 4, 7, 10 }, { 0, 3, 7 }, { 0, 2, 4 } },
+    { { 0, 3, 7, 10 }, { 0, 3, 7 }, { 0, 2, 4 } } };
+  const unsigned int numSubGrids = 12;
+  std::string fileNames[2];
+  for (int file = 0; file < 2; ++file)
+  {
+    fileNames[file] = prefix + std::to_string(file) + ".press.pfb";
+    if (!WriteFile(fileNames[file], divs[file]))
+    {
+      cerr << "ERROR: Could not write '" << fileNames[file] << "'." << endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  const int numThreads = vtkSMPTools::GetEstimatedNumberOfThreads();
+  const int threads[2] = { 1, numThreads };
+  for (int cc = 0; cc < 2; ++cc)
+  {
+    vtkSMPTools::Initialize(threads[cc]);
+    // the same reader reads both files, as it reads the time steps of a run.
+    vtkNew<vtkParFlowReader> reader;
+    reader->SetIsCLMFile(0);
+    for (int file = 0; file < 2; ++file)
+    {
+      reader->SetFileName(fileNames[file].c_str());
+      reader->Update();
+      if (!CheckOutput(reader->GetOutput(), numSubGrids))
+      {
+        cerr << "ERROR: wrong values in file " << file << " on " << threads[cc] << " threads."
+             << endl;
+        return EXIT_FAILURE;
+      }
+    }
+  }
+  vtkSMPTools::Initialize(numThreads);
+  return EXIT_SUCCESS;
+}
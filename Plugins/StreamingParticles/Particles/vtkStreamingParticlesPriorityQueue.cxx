@@ -14,9 +14,11 @@
 =========================================================================*/
 #include "vtkStreamingParticlesPriorityQueue.h"
 
+#include "vtkBoundingBox.h"
 #include "vtkCompositeDataPipeline.h"
 #include "vtkDataObjectTreeIterator.h"
 #include "vtkInformation.h"
+#include "vtkMath.h"
 #include "vtkMultiBlockDataSet.h"
 #include "vtkMultiProcessController.h"
 #include "vtkObjectFactory.h"
@@ -25,6 +27,7 @@
 
 #include <algorithm>
 #include <assert.h>
+#include <cmath>
 #include <map>
 #include <queue>
 #include <set>
@@ -49,7 +52,34 @@ public:
     return me.Distance > other.Distance;
   }
 };
+
+// A block of the metadata, as stored in the bounding volume hierarchy.
+struct vtkParticlesBlock
+{
+  unsigned int Identifier;
+  double Refinement;
+  double AmountOfDetail;
+  double Bounds[6];
+  double Center[3];
+  double Radius;
+  bool CanLoad; // CURRENT_PROCESS_CAN_LOAD_BLOCK
+};
+
+// A node of the bounding volume hierarchy: the bounds of the centers of its
+// blocks, and the largest radius of their bounding spheres, which is what
+// vtkComputeScreenCoverage() culls.
+struct vtkParticlesNode
+{
+  double CenterBounds[6];
+  double Radius;
+  unsigned int Begin;
+  unsigned int End;
+  int Children[2];
+};
+
+const unsigned int vtkParticlesLeafSize = 16;
 }
+
 class vtkStreamingParticlesPriorityQueue::vtkInternals
 {
 public:
@@ -58,9 +88,32 @@ public:
   std::set<unsigned int> BlocksRequested;
   std::set<unsigned int> BlocksToPurge;
 
+  // Blocks with valid bounds, in the order of the hierarchy leaves.
+  std::vector<vtkParticlesBlock> Blocks;
+  std::vector<vtkParticlesNode> Nodes;
+  // Index in Blocks of each block identifier, or -1.
+  std::vector<int> BlockIndices;
+  // Blocks of refinement 0 and 1, which may be needed even when not visible.
+  std::vector<unsigned int> CoarseBlocks;
+  // Blocks collected during the current update are stamped with Visit.
+  std::vector<unsigned int> Visits;
+  unsigned int Visit;
+
+  // The modulo of block identifiers that gives the identifier of the same
+  // block at other refinements, and whether all levels have the same number
+  // of blocks.
+  unsigned int BlocksPerLevel;
+  bool AllLevelsHaveSameBlockCount;
+
   double PreviousViewPlanes[24];
 
-  vtkInternals() { this->ResetPreviousViewPlanes(); }
+  vtkInternals()
+    : Visit(0)
+    , BlocksPerLevel(0)
+    , AllLevelsHaveSameBlockCount(true)
+  {
+    this->ResetPreviousViewPlanes();
+  }
   void ResetPreviousViewPlanes() { memset(this->PreviousViewPlanes, 0, sizeof(double) * 24); }
   bool PlanesChanged(const double view_planes[24])
   {
@@ -81,6 +134,268 @@ public:
   {
     std::copy(view_planes, view_planes + 24, this->PreviousViewPlanes);
   }
+
+  //----------------------------------------------------------------------------
+  // Reads the blocks out of the metadata and builds the bounding volume
+  // hierarchy over them.
+  void Build()
+  {
+    vtkMultiBlockDataSet* metadata = this->Metadata;
+
+    // This assumes for following structure:
+    // Root
+    //   Level 0
+    //     DS 0 (Block Idx 0)
+    //     DS 1 (Block Idx 1)
+    //   Level 1
+    //     DS 0 (Block Idx 2)
+    //     DS 1 (Block Idx 3)
+    //       .
+    //       .
+    //       .
+    // Where "Block Idx" is the key that needs to be sent up the pipeline to the
+    // reader to request a particular block and Level k is lower refinement than
+    // Level (k+1).
+    unsigned int block_index = 0;
+    unsigned int num_levels = metadata->GetNumberOfBlocks();
+    unsigned int num_block_per_level = 0;
+    bool all_levels_have_same_block_count = true;
+    for (unsigned int level = 0; level < num_levels; level++)
+    {
+      vtkMultiBlockDataSet* mb = vtkMultiBlockDataSet::SafeDownCast(metadata->GetBlock(level));
+      assert(mb != NULL);
+
+      unsigned int num_blocks = mb->GetNumberOfBlocks();
+      if (num_blocks > num_block_per_level)
+      {
+        num_block_per_level = num_blocks;
+        all_levels_have_same_block_count = level == 0;
+      }
+      for (unsigned int cc = 0; cc < num_blocks; cc++, block_index++)
+      {
+        if (!mb->HasMetaData(cc) ||
+          !mb->GetMetaData(cc)->Has(vtkStreamingDemandDrivenPipeline::BOUNDS()))
+        {
+          continue;
+        }
+
+        vtkParticlesBlock block;
+        vtkInformation* blockInfo = mb->GetMetaData(cc);
+        blockInfo->Get(vtkStreamingDemandDrivenPipeline::BOUNDS(), block.Bounds);
+        // vtkStreamingPriorityQueue::UpdatePriorities() drops the items with
+        // invalid bounds, whatever their refinement, so these blocks are never
+        // requested, not even at level 0.
+        if (!vtkBoundingBox(block.Bounds).IsValid())
+        {
+          continue;
+        }
+        block.Identifier = block_index;
+        block.Refinement = level;
+        block.AmountOfDetail = -1;
+        if (blockInfo->Has(vtkCompositeDataPipeline::BLOCK_AMOUNT_OF_DETAIL()))
+        {
+          block.AmountOfDetail = blockInfo->Get(vtkCompositeDataPipeline::BLOCK_AMOUNT_OF_DETAIL());
+        }
+        block.CanLoad = blockInfo->Has(vtkCompositeDataSet::CURRENT_PROCESS_CAN_LOAD_BLOCK()) &&
+          blockInfo->Get(vtkCompositeDataSet::CURRENT_PROCESS_CAN_LOAD_BLOCK()) != 0;
+
+        // the same center and radius as vtkComputeScreenCoverage().
+        const double* bounds = block.Bounds;
+        block.Center[0] = (bounds[0] + bounds[1]) / 2.0;
+        block.Center[1] = (bounds[2] + bounds[3]) / 2.0;
+        block.Center[2] = (bounds[4] + bounds[5]) / 2.0;
+        block.Radius = 0.5 * sqrt((bounds[1] - bounds[0]) * (bounds[1] - bounds[0]) +
+                               (bounds[3] - bounds[2]) * (bounds[3] - bounds[2]) +
+                               (bounds[5] - bounds[4]) * (bounds[5] - bounds[4]));
+        this->Blocks.push_back(block);
+      }
+    }
+    if (!all_levels_have_same_block_count)
+    {
+      num_block_per_level *= num_levels;
+    }
+    this->BlocksPerLevel = num_block_per_level;
+    this->AllLevelsHaveSameBlockCount = all_levels_have_same_block_count;
+
+    if (!this->Blocks.empty())
+    {
+      this->BuildNode(0, static_cast<unsigned int>(this->Blocks.size()));
+    }
+    this->BlockIndices.assign(block_index, -1);
+    for (size_t cc = 0; cc < this->Blocks.size(); ++cc)
+    {
+      this->BlockIndices[this->Blocks[cc].Identifier] = static_cast<int>(cc);
+      if (this->Blocks[cc].Refinement <= 1)
+      {
+        this->CoarseBlocks.push_back(static_cast<unsigned int>(cc));
+      }
+    }
+    this->Visits.assign(this->Blocks.size(), 0);
+  }
+
+  // Adds the node for Blocks[begin, end), splitting it at the median center
+  // along its longest axis, and returns its index.
+  int BuildNode(unsigned int begin, unsigned int end)
+  {
+    vtkParticlesNode node;
+    vtkMath::UninitializeBounds(node.CenterBounds);
+    vtkBoundingBox centers;
+    node.Radius = 0;
+    for (unsigned int cc = begin; cc < end; ++cc)
+    {
+      centers.AddPoint(this->Blocks[cc].Center);
+      node.Radius = std::max(node.Radius, this->Blocks[cc].Radius);
+    }
+    centers.GetBounds(node.CenterBounds);
+    node.Begin = begin;
+    node.End = end;
+    node.Children[0] = node.Children[1] = -1;
+
+    const int index = static_cast<int>(this->Nodes.size());
+    this->Nodes.push_back(node);
+    if (end - begin > vtkParticlesLeafSize)
+    {
+      const int axis = centers.GetMaxLength() == centers.GetLength(0)
+        ? 0
+        : (centers.GetMaxLength() == centers.GetLength(1) ? 1 : 2);
+      const unsigned int middle = begin + (end - begin) / 2;
+      std::nth_element(this->Blocks.begin() + begin, this->Blocks.begin() + middle,
+        this->Blocks.begin() + end, [axis](const vtkParticlesBlock& a, const vtkParticlesBlock& b) {
+          return a.Center[axis] < b.Center[axis];
+        });
+      const int left = this->BuildNode(begin, middle);
+      const int right = this->BuildNode(middle, end);
+      this->Nodes[index].Children[0] = left;
+      this->Nodes[index].Children[1] = right;
+    }
+    return index;
+  }
+
+  //----------------------------------------------------------------------------
+  // Whether all the bounding spheres of the blocks of `node` are outside one
+  // of the view planes, i.e. vtkComputeScreenCoverage() culls all of them.
+  static bool IsCulled(const vtkParticlesNode& node, const double view_planes[24])
+  {
+    const double* bounds = node.CenterBounds;
+    for (int i = 0; i < 6; i++)
+    {
+      const double* plane = view_planes + 4 * i;
+      // the largest distance of a block center to the plane.
+      const double d = plane[0] * (plane[0] > 0 ? bounds[1] : bounds[0]) +
+        plane[1] * (plane[1] > 0 ? bounds[3] : bounds[2]) +
+        plane[2] * (plane[2] > 0 ? bounds[5] : bounds[4]) + plane[3];
+      if (d < -node.Radius)
+      {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // The queue item for a block, with its screen coverage.
+  static vtkStreamingPriorityQueueItem MakeItem(
+    const vtkParticlesBlock& block, const double view_planes[24])
+  {
+    vtkStreamingPriorityQueueItem item;
+    item.Identifier = block.Identifier;
+    item.Refinement = block.Refinement;
+    item.AmountOfDetail = block.AmountOfDetail;
+    item.Bounds.SetBounds(block.Bounds);
+    item.ScreenCoverage = vtkComputeScreenCoverage(
+      view_planes, block.Bounds, item.Distance, item.Centeredness, item.ItemCoverage);
+    const double refinement2 = item.Refinement * item.Refinement;
+    item.Priority = item.ScreenCoverage > 0
+      ? item.ScreenCoverage * item.ScreenCoverage * item.Centeredness /
+        (1 + refinement2 + item.Distance)
+      : 0;
+    return item;
+  }
+
+  //----------------------------------------------------------------------------
+  // Pushes the blocks with a non-null screen coverage, visiting only the
+  // nodes of the hierarchy that are not entirely out of the view frustum.
+  void CollectVisibleBlocks(const double view_planes[24], bool anyProcessCanLoadAnyBlock,
+    vtkStreamingPriorityQueue<vtkParticlesComparator>& queue)
+  {
+    // a new stamp for this update.
+    if (++this->Visit == 0)
+    {
+      std::fill(this->Visits.begin(), this->Visits.end(), 0);
+      this->Visit = 1;
+    }
+    if (this->Nodes.empty())
+    {
+      return;
+    }
+
+    std::vector<int> stack(1, 0);
+    while (!stack.empty())
+    {
+      const vtkParticlesNode& node = this->Nodes[stack.back()];
+      stack.pop_back();
+      if (IsCulled(node, view_planes))
+      {
+        continue;
+      }
+      if (node.Children[0] >= 0)
+      {
+        stack.push_back(node.Children[0]);
+        stack.push_back(node.Children[1]);
+        continue;
+      }
+      for (unsigned int cc = node.Begin; cc < node.End; ++cc)
+      {
+        const vtkParticlesBlock& block = this->Blocks[cc];
+        if (anyProcessCanLoadAnyBlock || block.CanLoad)
+        {
+          vtkStreamingPriorityQueueItem item = MakeItem(block, view_planes);
+          if (item.ScreenCoverage > 0)
+          {
+            this->Visits[cc] = this->Visit;
+            queue.push(item);
+          }
+        }
+      }
+    }
+  }
+
+  // Pushes the blocks out of the view frustum that may still change the
+  // requests, once the visible blocks are processed: the blocks of
+  // refinement 0 and 1, which are needed whatever the view, and the blocks at
+  // a lower or equal refinement than a block requested or to request.
+  void CollectHiddenBlocks(const double view_planes[24], bool anyProcessCanLoadAnyBlock,
+    const std::map<unsigned, unsigned>& blocksRequested,
+    const std::map<unsigned, unsigned>& keepInRequest,
+    vtkStreamingPriorityQueue<vtkParticlesComparator>& queue)
+  {
+    auto collect = [&](unsigned int cc) {
+      const vtkParticlesBlock& block = this->Blocks[cc];
+      if (this->Visits[cc] != this->Visit && (anyProcessCanLoadAnyBlock || block.CanLoad))
+      {
+        this->Visits[cc] = this->Visit;
+        queue.push(MakeItem(block, view_planes));
+      }
+    };
+    for (unsigned int cc : this->CoarseBlocks)
+    {
+      collect(cc);
+    }
+    for (const auto* requests : { &blocksRequested, &keepInRequest })
+    {
+      for (const auto& request : *requests)
+      {
+        // the identifiers like request.second, but not greater.
+        for (unsigned int id = request.first; this->BlocksPerLevel > 0 &&
+             id <= request.second && id < this->BlockIndices.size(); id += this->BlocksPerLevel)
+        {
+          if (this->BlockIndices[id] >= 0)
+          {
+            collect(static_cast<unsigned int>(this->BlockIndices[id]));
+          }
+        }
+      }
+    }
+  }
 };
 
 vtkStandardNewMacro(vtkStreamingParticlesPriorityQueue);
@@ -110,6 +425,10 @@ void vtkStreamingParticlesPriorityQueue::Initialize(vtkMultiBlockDataSet* metada
   delete this->Internals;
   this->Internals = new vtkInternals();
   this->Internals->Metadata = metadata;
+  if (metadata)
+  {
+    this->Internals->Build();
+  }
 }
 
 //----------------------------------------------------------------------------
@@ -117,14 +436,11 @@ void vtkStreamingParticlesPriorityQueue::Reinitialize()
 {
   if (this->Internals->Metadata)
   {
-    std::set<unsigned int> blocksRequested;
-    blocksRequested.swap(this->Internals->BlocksRequested);
-
-    vtkSmartPointer<vtkMultiBlockDataSet> info = this->Internals->Metadata;
-    this->Initialize(info);
-
-    // restore blocks requested since data didn;t change.
-    this->Internals->BlocksRequested.swap(blocksRequested);
+    // the blocks did not change, only the queue is reset; blocks requested
+    // are kept since data didn't change.
+    std::queue<unsigned int>().swap(this->Internals->BlocksToRequest);
+    this->Internals->BlocksToPurge.clear();
+    this->Internals->ResetPreviousViewPlanes();
   }
 }
 
@@ -162,75 +478,9 @@ void vtkStreamingParticlesPriorityQueue::UpdatePriorities(const double view_plan
   assert(this->Internals && this->Internals->Metadata);
   assert(this->Internals->BlocksToRequest.empty());
 
-  vtkMultiBlockDataSet* metadata = this->Internals->Metadata;
-
-  // This assumes for following structure:
-  // Root
-  //   Level 0
-  //     DS 0 (Block Idx 0)
-  //     DS 1 (Block Idx 1)
-  //   Level 1
-  //     DS 0 (Block Idx 2)
-  //     DS 1 (Block Idx 3)
-  //       .
-  //       .
-  //       .
-  // Where "Block Idx" is the key that needs to be sent up the pipeline to the
-  // reader to request a particular block and Level k is lower refinement than
-  // Level (k+1).
-
-  vtkStreamingPriorityQueue<vtkParticlesComparator> queue;
-
-  unsigned int block_index = 0;
-  unsigned int num_levels = metadata->GetNumberOfBlocks();
-  unsigned int num_block_per_level = 0;
-  bool all_levels_have_same_block_count = true;
-  for (unsigned int level = 0; level < num_levels; level++)
-  {
-    vtkMultiBlockDataSet* mb = vtkMultiBlockDataSet::SafeDownCast(metadata->GetBlock(level));
-    assert(mb != NULL);
-
-    unsigned int num_blocks = mb->GetNumberOfBlocks();
-    if (num_blocks > num_block_per_level)
-    {
-      num_block_per_level = num_blocks;
-      all_levels_have_same_block_count = level == 0;
-    }
-    for (unsigned int cc = 0; cc < num_blocks; cc++, block_index++)
-    {
-      if (!mb->HasMetaData(cc) ||
-        !mb->GetMetaData(cc)->Has(vtkStreamingDemandDrivenPipeline::BOUNDS()))
-      {
-        continue;
-      }
-
-      vtkStreamingPriorityQueueItem item;
-      item.Identifier = block_index;
-      item.Refinement = level;
-
-      double bounds[6];
-      vtkInformation* blockInfo = mb->GetMetaData(cc);
-      blockInfo->Get(vtkStreamingDemandDrivenPipeline::BOUNDS(), bounds);
-      item.Bounds.SetBounds(bounds);
-      if (blockInfo->Has(vtkCompositeDataPipeline::BLOCK_AMOUNT_OF_DETAIL()))
-      {
-        item.AmountOfDetail = blockInfo->Get(vtkCompositeDataPipeline::BLOCK_AMOUNT_OF_DETAIL());
-      }
-      if (this->AnyProcessCanLoadAnyBlock ||
-        (blockInfo->Has(vtkCompositeDataSet::CURRENT_PROCESS_CAN_LOAD_BLOCK()) &&
-            blockInfo->Get(vtkCompositeDataSet::CURRENT_PROCESS_CAN_LOAD_BLOCK())))
-      {
-        queue.push(item);
-      }
-    }
-  }
-  if (!all_levels_have_same_block_count)
-  {
-    num_block_per_level *= num_levels;
-  }
-  double clamp_bounds[6];
-  vtkMath::UninitializeBounds(clamp_bounds);
-  queue.UpdatePriorities(view_planes, clamp_bounds);
+  vtkInternals& internals = *this->Internals;
+  const unsigned int num_block_per_level = internals.BlocksPerLevel;
+  const bool all_levels_have_same_block_count = internals.AllLevelsHaveSameBlockCount;
 
   std::map<unsigned, unsigned> blocksRequested;
   for (std::set<unsigned>::iterator itr = this->Internals->BlocksRequested.begin();
@@ -244,8 +494,22 @@ void vtkStreamingParticlesPriorityQueue::UpdatePriorities(const double view_plan
 
   std::deque<unsigned int> toRequest;
   std::map<unsigned, unsigned> keepInRequest;
-  while (!queue.empty())
+
+  // The blocks in the view frustum, by decreasing screen coverage; the blocks
+  // out of it come after them, by increasing refinement, and are collected
+  // once the visible ones have set the requests they can change.
+  vtkStreamingPriorityQueue<vtkParticlesComparator> queue;
+  internals.CollectVisibleBlocks(view_planes, this->AnyProcessCanLoadAnyBlock, queue);
+  bool hiddenBlocksCollected = false;
+  while (!queue.empty() || !hiddenBlocksCollected)
   {
+    if (queue.empty())
+    {
+      internals.CollectHiddenBlocks(
+        view_planes, this->AnyProcessCanLoadAnyBlock, blocksRequested, keepInRequest, queue);
+      hiddenBlocksCollected = true;
+      continue;
+    }
     vtkStreamingPriorityQueueItem item = queue.top();
 
     queue.pop();
@@ -58,7 +58,10 @@ public:
   // Description:
   // Initializes the queue. All information about items in the is lost. We only
   // look at the meta-data for the vtkMultiBlockDataSet i.e. none of the heavy
-  // data (or leaf nodes) will be tested or checked.
+  // data (or leaf nodes) will be tested or checked. The bounds of the blocks
+  // are read once here, into a bounding volume hierarchy that Update() culls
+  // against the view frustum. Blocks without valid BOUNDS are never requested,
+  // whatever their level.
   void Initialize(vtkMultiBlockDataSet* metadata);
 
   // Description:
@@ -118,7 +121,9 @@ public:
   ~vtkStreamingParticlesPriorityQueue();
 
   // Description:
-  // Updates priorities and builds a BlocksToPurge list.
+  // Updates priorities and builds a BlocksToPurge list. Only the blocks in the
+  // view frustum, the blocks of refinement 0 and 1, and the blocks at a lower
+  // refinement than a block already requested are visited.
   void UpdatePriorities(const double view_planes[24]);
 
   vtkMultiProcessController* Controller;
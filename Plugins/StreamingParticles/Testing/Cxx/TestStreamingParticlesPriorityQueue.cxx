@@ -0,0 +1,195 @@
+/*=========================================================================
+
+  Program:   ParaView
+  Module:    TestStreamingParticlesPriorityQueue.cxx
+
+  Copyright (c) Kitware, Inc.
+  All rights reserved.
+  See Copyright.txt or http://www.paraview.org/HTML/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// Runs vtkStreamingParticlesPriorityQueue over synthetic multi-resolution
+// metadata, with the same grid of blocks at every level and a few blocks
+// without valid bounds, along a camera path. Checks that the first update
+// requests a block of every slot with valid bounds, the blocks finer than
+// level 1 only when they cover enough of the screen, and that no update
+// requests a block without valid bounds. With --benchmark, the times taken to
+// initialize the queue and to update it are reported. --grid sets the number
+// of blocks along each axis of a level, --grid 50 giving 10^6 blocks.
+#include "vtkCamera.h"
+#include "vtkDummyController.h"
+#include "vtkInformation.h"
+#include "vtkMath.h"
+#include "vtkMultiBlockDataSet.h"
+#include "vtkNew.h"
+#include "vtkStreamingDemandDrivenPipeline.h"
+#include "vtkStreamingParticlesPriorityQueue.h"
+#include "vtkStreamingPriorityQueue.h"
+#include "vtkTimerLog.h"
+
+#include <vtksys/CommandLineArguments.hxx>
+
+#include <cmath>
+#include <cstdlib>
+#include <set>
+
+namespace
+{
+const unsigned int NumberOfLevels = 8;
+const int NumberOfUpdates = 20;
+
+// Whether the blocks of a slot, at all levels, have no valid bounds.
+bool HasInvalidBounds(unsigned int slot)
+{
+  return slot % 97 == 5;
+}
+
+// The bounds of a slot of the grid over [0, 1]^3.
+void GetSlotBounds(unsigned int slot, int grid, double bounds[6])
+{
+  const int ijk[3] = { static_cast<int>(slot % grid), static_cast<int>((slot / grid) % grid),
+    static_cast<int>(slot / (grid * grid)) };
+  for (int c = 0; c < 3; c++)
+  {
+    bounds[2 * c] = static_cast<double>(ijk[c]) / grid;
+    bounds[2 * c + 1] = static_cast<double>(ijk[c] + 1) / grid;
+  }
+}
+
+void FillMetadata(vtkMultiBlockDataSet* metadata, int grid)
+{
+  const unsigned int numSlots = static_cast<unsigned int>(grid * grid * grid);
+  metadata->SetNumberOfBlocks(NumberOfLevels);
+  for (unsigned int level = 0; level < NumberOfLevels; level++)
+  {
+    vtkNew<vtkMultiBlockDataSet> levelBlocks;
+    levelBlocks->SetNumberOfBlocks(numSlots);
+    for (unsigned int slot = 0; slot < numSlots; slot++)
+    {
+      double bounds[6];
+      GetSlotBounds(slot, grid, bounds);
+      if (HasInvalidBounds(slot))
+      {
+        vtkMath::UninitializeBounds(bounds);
+      }
+      levelBlocks->GetMetaData(slot)->Set(vtkStreamingDemandDrivenPipeline::BOUNDS(), bounds, 6);
+    }
+    metadata->SetBlock(level, levelBlocks);
+  }
+}
+
+int Run(int argc, char* argv[])
+{
+  bool benchmark = false;
+  int grid = 12;
+  vtksys::CommandLineArguments arg;
+  arg.Initialize(argc, argv);
+  typedef vtksys::CommandLineArguments argT;
+  arg.AddBooleanArgument("--benchmark", &benchmark, "Report the queue times.");
+  arg.AddArgument("--grid", argT::SPACE_ARGUMENT, &grid, "Number of blocks along each axis.");
+  arg.StoreUnusedArguments(true);
+  if (!arg.Parse() || grid <= 0)
+  {
+    cerr << "ERROR: Problem parsing arguments." << endl;
+    return EXIT_FAILURE;
+  }
+
+  const unsigned int numSlots = static_cast<unsigned int>(grid * grid * grid);
+  vtkNew<vtkMultiBlockDataSet> metadata;
+  FillMetadata(metadata, grid);
+
+  vtkNew<vtkDummyController> controller;
+  vtkNew<vtkStreamingParticlesPriorityQueue> queue;
+  queue->SetController(controller);
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  queue->Initialize(metadata);
+  timer->StopTimer();
+  const double initializeTime = timer->GetElapsedTime();
+
+  // the camera comes closer to the blocks while turning around them.
+  vtkNew<vtkCamera> camera;
+  camera->SetFocalPoint(0.5, 0.5, 0.5);
+  double updateTime = 0;
+  for (int update = 0; update < NumberOfUpdates; update++)
+  {
+    const double angle = 2. * vtkMath::Pi() * update / NumberOfUpdates;
+    const double distance = 3. - 2.4 * update / NumberOfUpdates;
+    camera->SetPosition(
+      0.5 + distance * std::cos(angle), 0.5 + 0.3 * distance, 0.5 + distance * std::sin(angle));
+    camera->SetViewUp(0, 1, 0);
+    double viewPlanes[24];
+    camera->GetFrustumPlanes(1.0, viewPlanes);
+
+    timer->StartTimer();
+    queue->Update(viewPlanes);
+    timer->StopTimer();
+    updateTime += timer->GetElapsedTime();
+
+    std::set<unsigned int> requested;
+    while (!queue->IsEmpty())
+    {
+      const unsigned int block = queue->Pop();
+      const unsigned int slot = block % numSlots;
+      if (block >= NumberOfLevels * numSlots || HasInvalidBounds(slot))
+      {
+        cerr << "ERROR: Block " << block << " requested at update " << update << "." << endl;
+        return EXIT_FAILURE;
+      }
+      requested.insert(block);
+
+      // nothing is loaded yet: finer blocks are requested when they cover
+      // enough of the screen.
+      if (update == 0 && block >= 2 * numSlots)
+      {
+        double bounds[6];
+        GetSlotBounds(slot, grid, bounds);
+        double distance, centeredness, itemCoverage;
+        const double coverage =
+          vtkComputeScreenCoverage(viewPlanes, bounds, distance, centeredness, itemCoverage);
+        if (coverage < 0.75)
+        {
+          cerr << "ERROR: Block " << block << " requested with a coverage of " << coverage << "."
+               << endl;
+          return EXIT_FAILURE;
+        }
+      }
+    }
+
+    if (update == 0)
+    {
+      // levels 0 and 1 are always needed, and only the finest level needed
+      // of a slot is requested.
+      std::set<unsigned int> requestedSlots;
+      for (unsigned int block : requested)
+      {
+        requestedSlots.insert(block % numSlots);
+      }
+      for (unsigned int slot = 0; slot < numSlots; slot++)
+      {
+        if (!HasInvalidBounds(slot) && requestedSlots.count(slot) == 0)
+        {
+          cerr << "ERROR: No block requested for slot " << slot << "." << endl;
+          return EXIT_FAILURE;
+        }
+      }
+    }
+  }
+
+  if (benchmark)
+  {
+    cout << NumberOfLevels * numSlots << " blocks: initialized in " << initializeTime << " s, "
+         << NumberOfUpdates << " updates in " << updateTime << " s" << endl;
+  }
+  return EXIT_SUCCESS;
+}
+}
+
+int main(int argc, char* argv[])
+{
+  return Run(argc, argv);
+}
@@ -0,0 +1,133 @@
+// Builds a pipeline of many sources, filters and fan-ins in a builtin
+// session, then a pqPipelineModel from it, as when a state is loaded, and
+// checks that every source is found in the model. With --benchmark, the
+// times taken to build the model and to look up all the sources are
+// reported. --chains sets the size of the pipeline.
+#include <QApplication>
+#include <QModelIndex>
+
+#include "pqApplicationCore.h"
+#include "pqObjectBuilder.h"
+#include "pqPipelineModel.h"
+#include "pqPipelineSource.h"
+#include "pqServer.h"
+#include "pqServerManagerModel.h"
+
+#include "vtkNew.h"
+#include "vtkSMParaViewPipelineController.h"
+#include "vtkSMPropertyHelper.h"
+#include "vtkSMSessionProxyManager.h"
+#include "vtkSmartPointer.h"
+#include "vtkTimerLog.h"
+
+#include <vtksys/CommandLineArguments.hxx>
+
+#include <cstdlib>
+
+namespace
+{
+vtkSMProxy* CreatePipelineProxy(vtkSMParaViewPipelineController* controller,
+  vtkSMSessionProxyManager* pxm, const char* group, const char* name, vtkSMProxy* input,
+  vtkSMProxy* input2 = nullptr)
+{
+  vtkSmartPointer<vtkSMProxy> proxy;
+  proxy.TakeReference(pxm->NewProxy(group, name));
+  if (input)
+  {
+    vtkSMPropertyHelper(proxy, "Input").Add(input, 0);
+  }
+  if (input2)
+  {
+    vtkSMPropertyHelper(proxy, "Input").Add(input2, 0);
+  }
+  controller->InitializeProxy(proxy);
+  controller->RegisterPipelineProxy(proxy);
+  return proxy;
+}
+
+int Run(int argc, char** argv)
+{
+  bool benchmark = false;
+  int numChains = 200;
+  vtksys::CommandLineArguments arg;
+  arg.Initialize(argc, argv);
+  typedef vtksys::CommandLineArguments argT;
+  arg.AddBooleanArgument("--benchmark", &benchmark, "Report the model times.");
+  arg.AddArgument("--chains", argT::SPACE_ARGUMENT, &numChains, "Number of pipeline chains.");
+  arg.StoreUnusedArguments(true);
+  if (!arg.Parse() || numChains <= 0)
+  {
+    cerr << "ERROR: Problem parsing arguments." << endl;
+    return EXIT_FAILURE;
+  }
+
+  pqApplicationCore* core = pqApplicationCore::instance();
+  pqServer* server = core->getObjectBuilder()->createServer(pqServerResource("builtin:"));
+  vtkSMSessionProxyManager* pxm = server->proxyManager();
+  vtkNew<vtkSMParaViewPipelineController> controller;
+
+  // Chains of a source and two filters, the last filters of every two chains
+  // appended together, so that the model has links.
+  int numAppends = 0;
+  vtkSMProxy* previous = nullptr;
+  for (int chain = 0; chain < numChains; chain++)
+  {
+    vtkSMProxy* source = CreatePipelineProxy(controller, pxm, "sources", "SphereSource", nullptr);
+    vtkSMProxy* shrink1 = CreatePipelineProxy(controller, pxm, "filters", "ShrinkFilter", source);
+    vtkSMProxy* shrink2 = CreatePipelineProxy(controller, pxm, "filters", "ShrinkFilter", shrink1);
+    if (chain % 2 == 1)
+    {
+      CreatePipelineProxy(controller, pxm, "filters", "Append", previous, shrink2);
+      numAppends++;
+    }
+    previous = shrink2;
+  }
+
+  pqServerManagerModel* smModel = core->getServerManagerModel();
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  pqPipelineModel model(*smModel);
+  timer->StopTimer();
+  const double buildTime = timer->GetElapsedTime();
+
+  // The sources and the fan-ins are under the server, the other filters
+  // under their input.
+  QModelIndex serverIndex = model.getIndexFor(server);
+  if (!serverIndex.isValid() || model.rowCount(serverIndex) != numChains + numAppends)
+  {
+    cerr << "ERROR: " << model.rowCount(serverIndex) << " items under the server instead of "
+         << numChains + numAppends << "." << endl;
+    return EXIT_FAILURE;
+  }
+
+  QList<pqPipelineSource*> sources = smModel->findItems<pqPipelineSource*>(server);
+  timer->StartTimer();
+  foreach (pqPipelineSource* source, sources)
+  {
+    QModelIndex index = model.getIndexFor(source);
+    if (!index.isValid() || model.getItemFor(index) != source)
+    {
+      cerr << "ERROR: Source " << source->getSMName().toLocal8Bit().data() << " not found." << endl;
+      return EXIT_FAILURE;
+    }
+  }
+  timer->StopTimer();
+
+  if (benchmark)
+  {
+    cout << sources.size() << " sources: model built in " << buildTime << " s, sources found in "
+         << timer->GetElapsedTime() << " s" << endl;
+  }
+  return EXIT_SUCCESS;
+}
+}
+
+int main(int argc, char** argv)
+{
+  QApplication app(argc, argv);
+
+  // the options of this benchmark are not ParaView options.
+  int coreArgc = 1;
+  pqApplicationCore appCore(coreArgc, argv);
+  return Run(argc, argv);
+}
@@ -58,6 +58,8 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <QApplication>
 #include <QFont>
+#include <QHash>
+#include <QSet>
 #include <QString>
 #include <QStyle>
 #include <QtDebug>
@@ -125,6 +127,9 @@ public:
   QString VisibilityIcon;
   bool Selectable;
 
+  // true when the item is in the tree of the model, under its Root.
+  bool Attached;
+
   // This is a terrible iVar, agreed. But it makes my life easier.
   // This is valid only for elements of Type==Proxy. These refer to the link
   // items present for this item, if any. This list is automatically kept
@@ -137,6 +142,7 @@ public:
   {
     this->InConstructor = true;
     this->Selectable = true;
+    this->Attached = false;
     this->Model = model;
     this->Parent = nullptr;
     this->Object = object;
@@ -149,6 +155,7 @@ public:
       assert(proxyItem != 0);
       proxyItem->Links.push_back(this);
     }
+    this->registerItem();
     if (this->Object)
     {
       this->updateVisibilityIcon(this->Model->view(), false);
@@ -157,6 +164,7 @@ public:
   }
   ~pqPipelineModelDataItem() override
   {
+    this->unregisterItem();
     if (this->Type == pqPipelineModel::Link && this->Model->Internal)
     {
       pqPipelineModelDataItem* proxyItem =
@@ -170,9 +178,11 @@ public:
 
   pqPipelineModelDataItem& operator=(const pqPipelineModelDataItem& other)
   {
+    this->unregisterItem();
     this->Object = other.Object;
     this->Type = other.Type;
     this->VisibilityIcon = other.VisibilityIcon;
+    this->registerItem();
     foreach (pqPipelineModelDataItem* otherChild, other.Children)
     {
       pqPipelineModelDataItem* child =
@@ -199,6 +209,11 @@ public:
     }
   }
 
+  // Server, Proxy and Port items are indexed by their object in the model,
+  // Link items are found through the Links of their Proxy item.
+  void registerItem();
+  void unregisterItem();
+
   pqPipelineModel::ItemType getType() { return this->Type; }
   int getIndexInParent()
   {
@@ -264,6 +279,7 @@ public:
     child->setParent(this);
     child->Parent = this;
     this->Children.push_back(child);
+    child->setAttached(this->Attached);
   }
 
   void removeChild(pqPipelineModelDataItem* child)
@@ -276,6 +292,19 @@ public:
     child->setParent(nullptr);
     child->Parent = nullptr;
     this->Children.removeAll(child);
+    child->setAttached(false);
+  }
+
+  void setAttached(bool attached)
+  {
+    if (this->Attached != attached)
+    {
+      this->Attached = attached;
+      foreach (pqPipelineModelDataItem* child, this->Children)
+      {
+        child->setAttached(attached);
+      }
+    }
   }
 
   // returns true when the icon has changed.
@@ -425,6 +454,7 @@ public:
   pqPipelineModelInternal(pqPipelineModel* parent)
     : Root(parent, nullptr, pqPipelineModel::Invalid, parent)
   {
+    this->Root.Attached = true;
     this->ModifiedFont.setBold(true);
     this->DelayedUpdateVisibilityTimer.setSingleShot(true);
   }
@@ -433,8 +463,39 @@ public:
   pqPipelineModelDataItem Root;
   pqTimer DelayedUpdateVisibilityTimer;
   QList<QPointer<pqPipelineSource> > DelayedUpdateVisibilityItems;
+
+  // The Server, Proxy and Port items by object, kept updated by the items.
+  QHash<pqServerManagerModelItem*, pqPipelineModelDataItem*> Items;
+
+  // Items whose data changed while dataChanged() signals are batched.
+  bool BatchDataChanged = false;
+  QSet<pqPipelineModelDataItem*> ChangedItems;
 };
 
+//-----------------------------------------------------------------------------
+void pqPipelineModelDataItem::registerItem()
+{
+  if (this->Object && this->Type != pqPipelineModel::Link &&
+    this->Type != pqPipelineModel::Invalid && this->Model->Internal)
+  {
+    this->Model->Internal->Items.insert(this->Object, this);
+  }
+}
+
+//-----------------------------------------------------------------------------
+void pqPipelineModelDataItem::unregisterItem()
+{
+  if (this->Object && this->Model->Internal)
+  {
+    auto iter = this->Model->Internal->Items.find(this->Object);
+    if (iter != this->Model->Internal->Items.end() && iter.value() == this)
+    {
+      this->Model->Internal->Items.erase(iter);
+    }
+    this->Model->Internal->ChangedItems.remove(this);
+  }
+}
+
 //-----------------------------------------------------------------------------
 void pqPipelineModel::constructor()
 {
@@ -938,17 +999,41 @@ pqPipelineModelDataItem* pqPipelineModel::getDataItem(
     return 0;
   }
 
-  if (_parent->Object == item && (type == pqPipelineModel::Invalid || type == _parent->Type))
+  // only items attached under _parent are found, as with a walk of its subtree.
+  pqPipelineModelDataItem* root = &this->Internal->Root;
+  auto inSubtree = [_parent, root](pqPipelineModelDataItem* dataItem) {
+    if (_parent == root)
+    {
+      return dataItem->Attached;
+    }
+    for (; dataItem; dataItem = dataItem->Parent)
+    {
+      if (dataItem == _parent)
+      {
+        return true;
+      }
+    }
+    return false;
+  };
+
+  pqPipelineModelDataItem* retVal = this->Internal->Items.value(item, nullptr);
+  if (retVal && type != pqPipelineModel::Link &&
+    (type == pqPipelineModel::Invalid || type == retVal->Type) && inSubtree(retVal))
   {
-    return _parent;
+    return retVal;
   }
 
-  foreach (pqPipelineModelDataItem* child, _parent->Children)
+  if (type == pqPipelineModel::Link || type == pqPipelineModel::Invalid)
   {
-    pqPipelineModelDataItem* retVal = this->getDataItem(item, child, type);
-    if (retVal && (type == pqPipelineModel::Invalid || type == retVal->Type))
+    if (retVal && retVal->Type == pqPipelineModel::Proxy)
     {
-      return retVal;
+      foreach (pqPipelineModelDataItem* link, retVal->Links)
+      {
+        if (inSubtree(link))
+        {
+          return link;
+        }
+      }
     }
   }
   return 0;
@@ -1040,10 +1125,57 @@ void pqPipelineModel::serverDataChanged()
 //-----------------------------------------------------------------------------
 void pqPipelineModel::itemDataChanged(pqPipelineModelDataItem* item)
 {
+  if (this->Internal->BatchDataChanged)
+  {
+    this->Internal->ChangedItems.insert(item);
+    return;
+  }
   QModelIndex idx = this->getIndex(item);
   Q_EMIT this->dataChanged(idx, idx);
 }
 
+//-----------------------------------------------------------------------------
+void pqPipelineModel::beginDataChangedBatch()
+{
+  this->Internal->BatchDataChanged = true;
+}
+
+//-----------------------------------------------------------------------------
+void pqPipelineModel::endDataChangedBatch()
+{
+  this->Internal->BatchDataChanged = false;
+  QSet<pqPipelineModelDataItem*> parents;
+  foreach (pqPipelineModelDataItem* item, this->Internal->ChangedItems)
+  {
+    if (item->Parent)
+    {
+      parents.insert(item->Parent);
+    }
+  }
+
+  // a dataChanged() range cannot span several parents, so the changed rows
+  // are signalled as one range per parent.
+  foreach (pqPipelineModelDataItem* _parent, parents)
+  {
+    int first = -1;
+    int last = -1;
+    for (int row = 0; row < _parent->Children.size(); row++)
+    {
+      if (this->Internal->ChangedItems.contains(_parent->Children[row]))
+      {
+        first = first < 0 ? row : first;
+        last = row;
+      }
+    }
+    if (first >= 0)
+    {
+      Q_EMIT this->dataChanged(this->createIndex(first, 0, _parent->Children[first]),
+        this->createIndex(last, this->columnCount() - 1, _parent->Children[last]));
+    }
+  }
+  this->Internal->ChangedItems.clear();
+}
+
 //-----------------------------------------------------------------------------
 void pqPipelineModel::addServer(pqServer* server)
 {
@@ -1334,7 +1466,9 @@ void pqPipelineModel::setView(pqView* newview)
   }
   this->View = newview;
   // update all VisibilityIcons.
+  this->beginDataChangedBatch();
   this->Internal->Root.updateVisibilityIcon(newview, true);
+  this->endDataChangedBatch();
 }
 
 //-----------------------------------------------------------------------------
@@ -1348,6 +1482,7 @@ void pqPipelineModel::delayedUpdateVisibility(pqPipelineSource* source)
 //-----------------------------------------------------------------------------
 void pqPipelineModel::delayedUpdateVisibilityTimeout()
 {
+  this->beginDataChangedBatch();
   foreach (pqPipelineSource* source, this->Internal->DelayedUpdateVisibilityItems)
   {
     if (source)
@@ -1356,6 +1491,7 @@ void pqPipelineModel::delayedUpdateVisibilityTimeout()
     }
   }
   this->Internal->DelayedUpdateVisibilityItems.clear();
+  this->endDataChangedBatch();
 }
 
 //-----------------------------------------------------------------------------
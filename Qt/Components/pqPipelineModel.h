@@ -416,6 +416,12 @@ private:
   // called by pqPipelineModelDataItem to indicate that the data for the item
   // may have changed.
   void itemDataChanged(pqPipelineModelDataItem*);
+
+  // between these calls, itemDataChanged() collects the changed items, which
+  // are then signalled with one dataChanged() range per parent.
+  void beginDataChangedBatch();
+  void endDataChangedBatch();
+
   /**
   * used by the variant of setSubtreeSelectable() for recursion.
   */
@@ -0,0 +1,323 @@
+/*=========================================================================
+
+  Program:   ParaView
+  Module:    TestCinemaDatabaseIndex.cxx
+
+  Copyright (c) Kitware, Inc.
+  All rights reserved.
+  See Copyright.txt or http://www.paraview.org/HTML/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// Checks that vtkCinemaDatabase reads small Spec-C and Spec-D stores without
+// Python, that decoded layers are served from its cache, that the
+// neighbouring poses and time steps are prefetched, and that a cache of size
+// 0 reads the files again.
+#include "vtkCamera.h"
+#include "vtkCinemaDatabase.h"
+#include "vtkDataArray.h"
+#include "vtkImageData.h"
+#include "vtkNew.h"
+#include "vtkPNGWriter.h"
+#include "vtkPointData.h"
+#include "vtkSmartPointer.h"
+#include "vtkTestUtilities.h"
+#include "vtkUnsignedCharArray.h"
+
+#include <vtk_zlib.h>
+#include <vtksys/SystemTools.hxx>
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+const int Width = 64;
+const int Height = 32;
+
+// A Spec-C store with 2 poses and 2 time steps of a "Source", with its
+// depth and "Temp" values, and a "Contour" of it with 2 iso-values.
+const char* SpecCInfo = R"({
+  "metadata": {
+    "type": "composite-image-stack", "version": "0.2",
+    "camera_model": "azimuth-elevation-roll", "value_mode": 2, "image_size": [32, 64],
+    "camera_eye": [[0, 0, 10], [0, 0, 10]], "camera_at": [[0, 0, 0], [0, 0, 0]],
+    "camera_up": [[0, 1, 0], [0, 1, 0]], "camera_nearfar": [[1, 20], [1, 20]],
+    "camera_angle": [30, 30],
+    "pipeline": [
+      { "id": "2", "name": "Contour", "parents": ["1"], "visibility": 0 },
+      { "id": "1", "name": "Source", "parents": [], "visibility": 1 } ] },
+  "name_pattern": "{pose}_{time}_{vis}_{image}.png",
+  "parameter_list": {
+    "time": { "type": "range", "values": ["0.0", "1.0"], "default": "0.0" },
+    "pose": { "type": "range",
+      "values": [[[1, 0, 0], [0, 1, 0], [0, 0, 1]], [[0, 0, 1], [0, 1, 0], [-1, 0, 0]]],
+      "default": [[1, 0, 0], [0, 1, 0], [0, 0, 1]] },
+    "vis": { "type": "option", "role": "layer", "values": ["Contour", "Source"],
+      "default": "Source" },
+    "Contour": { "type": "range", "role": "control", "values": [0.5, 1.5], "default": 0.5 },
+    "image": { "type": "hidden", "role": "field", "values": ["depth", "Temp"],
+      "types": ["depth", "value"], "valueRanges": { "Temp": [0, 10] }, "default": "depth" } },
+  "constraints": { "image": { "vis": ["Contour", "Source"] }, "Contour": { "vis": ["Contour"] } }
+})";
+
+// Writes a `.Z` raster filled with `value`.
+bool WriteRaster(const std::string& fname, float value)
+{
+  const std::vector<float> values(Width * Height, value);
+  const uLong size = static_cast<uLong>(values.size() * sizeof(float));
+  std::vector<Bytef> compressed(compressBound(size));
+  uLongf length = static_cast<uLongf>(compressed.size());
+  if (compress(compressed.data(), &length, reinterpret_cast<const Bytef*>(values.data()), size) !=
+      Z_OK ||
+    !vtksys::SystemTools::MakeDirectory(vtksys::SystemTools::GetFilenamePath(fname)))
+  {
+    return false;
+  }
+  std::ofstream file(fname.c_str(), ios::out | ios::binary);
+  file.write(reinterpret_cast<const char*>(compressed.data()), length);
+  return file.good();
+}
+
+// Writes an RGB image whose red component is `value`.
+void WriteImage(const std::string& fname, unsigned char value)
+{
+  vtkNew<vtkImageData> image;
+  image->SetDimensions(Width, Height, 1);
+  image->AllocateScalars(VTK_UNSIGNED_CHAR, 3);
+  vtkUnsignedCharArray* colors =
+    vtkUnsignedCharArray::SafeDownCast(image->GetPointData()->GetScalars());
+  for (vtkIdType cc = 0; cc < colors->GetNumberOfTuples(); ++cc)
+  {
+    colors->SetTypedTuple(cc, std::vector<unsigned char>{ value, 0, 255 }.data());
+  }
+  vtkNew<vtkPNGWriter> writer;
+  writer->SetInputData(image);
+  writer->SetFileName(fname.c_str());
+  writer->Write();
+}
+
+double GetValue(
+  const std::vector<vtkSmartPointer<vtkImageData> >& layers, size_t layer, const char* name)
+{
+  vtkDataArray* array =
+    layer < layers.size() ? layers[layer]->GetPointData()->GetArray(name) : nullptr;
+  return array && array->GetNumberOfTuples() == Width * Height ? array->GetComponent(0, 0) : -1.0;
+}
+
+std::string SourceQuery(int pose, const char* time)
+{
+  return "{'vis': ['Source'], 'pose': " + std::to_string(pose) + ", 'time': ['" + time +
+    "'], 'image': ['Temp']}";
+}
+}
+
+int TestCinemaDatabaseIndex(int argc, char* argv[])
+{
+  char* tempDir =
+    vtkTestUtilities::GetArgOrEnvOrDefault("-T", argc, argv, "VTK_TEMP_DIR", "Testing/Temporary");
+  if (!tempDir)
+  {
+    cerr << "ERROR: Could not determine temporary directory." << endl;
+    return EXIT_FAILURE;
+  }
+  const std::string dir =
+    vtksys::SystemTools::CollapseFullPath(std::string(tempDir) + "/TestCinemaDatabaseIndex");
+  delete[] tempDir;
+
+  // the Spec-C store; the values of a raster tell which one it is.
+  const std::string specC = dir + "/specC.cdb";
+  vtksys::SystemTools::RemoveADirectory(dir);
+  if (!vtksys::SystemTools::MakeDirectory(specC))
+  {
+    cerr << "ERROR: cannot create " << specC << endl;
+    return EXIT_FAILURE;
+  }
+  std::ofstream(specC + "/info.json") << SpecCInfo;
+  for (int pose = 0; pose < 2; ++pose)
+  {
+    for (int time = 0; time < 2; ++time)
+    {
+      const std::string base =
+        specC + "/pose=" + std::to_string(pose) + "/time=" + std::to_string(time);
+      const float value = 100.f * pose + 10.f * time;
+      if (!WriteRaster(base + "/vis=1/image=0.Z", value) ||
+        !WriteRaster(base + "/vis=1/image=1.Z", value + 1) ||
+        !WriteRaster(base + "/vis=0/Contour=0/image=0.Z", 1000 + value) ||
+        !WriteRaster(base + "/vis=0/Contour=0/image=1.Z", 1001 + value) ||
+        !WriteRaster(base + "/vis=0/Contour=1/image=0.Z", 2000 + value) ||
+        !WriteRaster(base + "/vis=0/Contour=1/image=1.Z", 2001 + value))
+      {
+        cerr << "ERROR: cannot write the rasters of " << base << endl;
+        return EXIT_FAILURE;
+      }
+    }
+  }
+
+  vtkNew<vtkCinemaDatabase> database;
+  if (!database->Load(specC.c_str()))
+  {
+    cerr << "ERROR: cannot load " << specC << endl;
+    return EXIT_FAILURE;
+  }
+  if (database->GetSpec() != vtkCinemaDatabase::CINEMA_SPEC_C)
+  {
+    cerr << "ERROR: wrong spec." << endl;
+    return EXIT_FAILURE;
+  }
+  const std::vector<std::string> objects = database->GetPipelineObjects();
+  if (objects.size() != 2 || objects[0] != "Source" || objects[1] != "Contour")
+  {
+    cerr << "ERROR: wrong pipeline objects." << endl;
+    return EXIT_FAILURE;
+  }
+  if (database->GetPipelineObjectParents("Contour") != std::vector<std::string>{ "Source"})
+  {
+    cerr << "ERROR: wrong parents." << endl;
+    return EXIT_FAILURE;
+  }
+  if (!database->GetPipelineObjectVisibility("Source") ||
+    database->GetPipelineObjectVisibility("Contour"))
+  {
+    cerr << "ERROR: wrong visibility." << endl;
+    return EXIT_FAILURE;
+  }
+  if (database->GetControlParameters("Contour") != std::vector<std::string>{ "Contour"} ||
+    !database->GetControlParameters("Source").empty())
+  {
+    cerr << "ERROR: wrong control parameters." << endl;
+    return EXIT_FAILURE;
+  }
+  if (database->GetControlParameterValues("Contour") != (std::vector<std::string>{ "0.5", "1.5"}))
+  {
+    cerr << "ERROR: wrong control parameter values." << endl;
+    return EXIT_FAILURE;
+  }
+  if (database->GetFieldValues("Source", "value") != std::vector<std::string>{ "Temp"})
+  {
+    cerr << "ERROR: wrong field values." << endl;
+    return EXIT_FAILURE;
+  }
+  double range[2];
+  if (!database->GetFieldValueRange("Source", "Temp", range) || range[0] != 0 || range[1] != 10)
+  {
+    cerr << "ERROR: wrong field value range." << endl;
+    return EXIT_FAILURE;
+  }
+  if (database->GetTimeSteps() != (std::vector<std::string>{ "0.0", "1.0"}))
+  {
+    cerr << "ERROR: wrong time steps." << endl;
+    return EXIT_FAILURE;
+  }
+  if (database->Cameras("1.0").size() != 2)
+  {
+    cerr << "ERROR: wrong number of cameras." << endl;
+    return EXIT_FAILURE;
+  }
+
+  std::vector<vtkSmartPointer<vtkImageData> > layers =
+    database->TranslateQuery(SourceQuery(1, "1.0"));
+  if (layers.size() != 1 || GetValue(layers, 0, "Values") != 111 ||
+    GetValue(layers, 0, "Depth") != 110)
+  {
+    cerr << "ERROR: wrong layer for pose 1, time 1.0." << endl;
+    return EXIT_FAILURE;
+  }
+
+  layers = database->TranslateQuery(
+    "{'vis': ['Contour', 'Source'], 'Contour': [0.5, 1.5], 'pose': 0, 'image': ['Temp']}");
+  if (layers.size() != 3 || GetValue(layers, 0, "Values") != 1001 ||
+    GetValue(layers, 1, "Values") != 2001 || GetValue(layers, 2, "Values") != 1)
+  {
+    cerr << "ERROR: wrong layers for 2 contours and their source." << endl;
+    return EXIT_FAILURE;
+  }
+
+  // decoded layers and the prefetched neighbours of the last query are used
+  // once the files are gone.
+  database->TranslateQuery(SourceQuery(0, "0.0"));
+  std::this_thread::sleep_for(std::chrono::milliseconds(500));
+  vtksys::SystemTools::RemoveADirectory(specC + "/pose=1");
+  vtksys::SystemTools::RemoveADirectory(specC + "/pose=0/time=1");
+  layers = database->TranslateQuery(SourceQuery(1, "1.0"));
+  if (GetValue(layers, 0, "Values") != 111)
+  {
+    cerr << "ERROR: cached layer not used." << endl;
+    return EXIT_FAILURE;
+  }
+  layers = database->TranslateQuery(SourceQuery(1, "0.0"));
+  if (GetValue(layers, 0, "Values") != 101)
+  {
+    cerr << "ERROR: neighbouring pose not prefetched." << endl;
+    return EXIT_FAILURE;
+  }
+  layers = database->TranslateQuery(SourceQuery(0, "1.0"));
+  if (GetValue(layers, 0, "Values") != 11)
+  {
+    cerr << "ERROR: neighbouring time step not prefetched." << endl;
+    return EXIT_FAILURE;
+  }
+
+  // a Spec-D store, reported as Spec-A.
+  const std::string specD = dir + "/specD.cdb";
+  if (!vtksys::SystemTools::MakeDirectory(specD))
+  {
+    cerr << "ERROR: cannot create " << specD << endl;
+    return EXIT_FAILURE;
+  }
+  std::ofstream(specD + "/data.csv") << "phi,theta,FILE\n"
+                                     << "0,0,a.png\n0,45,b.png\n90,0,c.png\n90,45,d.png\n";
+  WriteImage(specD + "/a.png", 10);
+  WriteImage(specD + "/b.png", 20);
+  WriteImage(specD + "/c.png", 30);
+  WriteImage(specD + "/d.png", 40);
+
+  vtkNew<vtkCinemaDatabase> table;
+  table->SetPrefetchNeighbors(false);
+  if (!table->Load((specD + "/data.csv").c_str()))
+  {
+    cerr << "ERROR: cannot load " << specD << endl;
+    return EXIT_FAILURE;
+  }
+  if (table->GetSpec() != vtkCinemaDatabase::CINEMA_SPEC_A)
+  {
+    cerr << "ERROR: wrong spec for Spec-D." << endl;
+    return EXIT_FAILURE;
+  }
+  if (table->GetControlParameterValues("theta") != (std::vector<std::string>{ "0.0", "45.0"}))
+  {
+    cerr << "ERROR: wrong Spec-D parameter values." << endl;
+    return EXIT_FAILURE;
+  }
+  layers = table->TranslateQuery("{'phi': [90], 'theta': [45]}");
+  if (layers.size() != 1 || GetValue(layers, 0, "Colors") != 40)
+  {
+    cerr << "ERROR: wrong Spec-D layer." << endl;
+    return EXIT_FAILURE;
+  }
+
+  // without a cache, the files are read again.
+  table->SetLayerCacheSize(0);
+  if (table->GetLayerCacheSize() != 0)
+  {
+    cerr << "ERROR: cache size not set." << endl;
+    return EXIT_FAILURE;
+  }
+  WriteImage(specD + "/d.png", 50);
+  layers = table->TranslateQuery("{'phi': [90], 'theta': [45]}");
+  if (GetValue(layers, 0, "Colors") != 50)
+  {
+    cerr << "ERROR: layer not read again without a cache." << endl;
+    return EXIT_FAILURE;
+  }
+
+  vtksys::SystemTools::RemoveADirectory(dir);
+  return EXIT_SUCCESS;
+}
@@ -16,6 +16,7 @@
 
 #include "vtkCamera.h"
 #include "vtkCinemaDatabase.h"
+#include "vtkCinemaDatabaseIndex.h"
 #include "vtkImageData.h"
 #include "vtkObjectFactory.h"
 #include "vtkPythonInterpreter.h"
@@ -110,12 +111,41 @@ class vtkCinemaDatabase::vtkInternals
   vtkSmartPyObject FileStore;
 
 public:
+  // Used instead of FileStore when the store could be read in C++.
+  vtkCinemaDatabaseIndex Index;
+  bool UseIndex;
+
   vtkInternals()
     : Initialized(false)
+    , UseIndex(false)
   {
   }
 
-  bool IsLoaded() const { return this->FileStore; }
+  bool IsLoaded() const { return this->UseIndex || this->FileStore; }
+
+  // Reads the store in C++ if possible, otherwise with Python.
+  bool Load(const char* filename)
+  {
+    switch (this->Index.Load(filename))
+    {
+      case vtkCinemaDatabaseIndex::LOADED:
+        this->UseIndex = true;
+        return true;
+
+      case vtkCinemaDatabaseIndex::FAILED:
+        this->UseIndex = false;
+        if (this->FileStore)
+        {
+          vtkPythonScopeGilEnsurer gilEnsurer;
+          this->FileStore = nullptr;
+        }
+        return false;
+
+      default:
+        this->UseIndex = false;
+        return this->LoadDatabase(filename);
+    }
+  }
 
   // Will import necessary Python modules and return true if all's ready.
   bool InitializePython()
@@ -181,6 +211,10 @@ public:
 
   std::vector<std::string> GetPipelineObjects() const
   {
+    if (this->UseIndex)
+    {
+      return this->Index.GetPipelineObjects();
+    }
     vtkPythonScopeGilEnsurer gilEnsurer;
     vtkSmartPyObject retVal(
       PyObject_CallMethod(this->FileStore, const_cast<char*>("get_objects"), NULL));
@@ -198,6 +232,10 @@ public:
 
   std::vector<std::string> GetPipelineObjectParents(const std::string& name) const
   {
+    if (this->UseIndex)
+    {
+      return this->Index.GetPipelineObjectParents(name);
+    }
     vtkPythonScopeGilEnsurer gilEnsurer;
     vtkSmartPyObject retVal(PyObject_CallMethod(
       this->FileStore, const_cast<char*>("get_parents"), const_cast<char*>("s"), name.c_str()));
@@ -215,6 +253,10 @@ public:
 
   bool GetPipelineObjectVisibility(const std::string& name) const
   {
+    if (this->UseIndex)
+    {
+      return this->Index.GetPipelineObjectVisibility(name);
+    }
     vtkPythonScopeGilEnsurer gilEnsurer;
     vtkSmartPyObject retVal(PyObject_CallMethod(
       this->FileStore, const_cast<char*>("get_visibility"), const_cast<char*>("s"), name.c_str()));
@@ -232,6 +274,10 @@ public:
 
   std::vector<std::string> GetControlParameters(const std::string& name) const
   {
+    if (this->UseIndex)
+    {
+      return this->Index.GetControlParameters(name);
+    }
     vtkPythonScopeGilEnsurer gilEnsurer;
     vtkSmartPyObject retVal(PyObject_CallMethod(this->FileStore,
       const_cast<char*>("get_control_parameters"), const_cast<char*>("s"), name.c_str()));
@@ -249,6 +295,10 @@ public:
 
   std::string GetFieldName(const std::string& objectname) const
   {
+    if (this->UseIndex)
+    {
+      return this->Index.GetFieldName(objectname);
+    }
     vtkPythonScopeGilEnsurer gilEnsurer;
     vtkSmartPyObject retVal(PyObject_CallMethod(this->FileStore,
       const_cast<char*>("get_field_name"), const_cast<char*>("s"), objectname.c_str()));
@@ -274,6 +324,10 @@ public:
   std::vector<std::string> GetFieldValues(
     const std::string& name, const std::string& valuetype) const
   {
+    if (this->UseIndex)
+    {
+      return this->Index.GetFieldValues(name, valuetype);
+    }
     vtkPythonScopeGilEnsurer gilEnsurer;
     vtkSmartPyObject retVal(
       PyObject_CallMethod(this->FileStore, const_cast<char*>("get_field_values"),
@@ -292,6 +346,10 @@ public:
   bool GetFieldValueRange(
     const std::string& object, const std::string& field, double range[2]) const
   {
+    if (this->UseIndex)
+    {
+      return this->Index.GetFieldValueRange(object, field, range);
+    }
     vtkPythonScopeGilEnsurer gilEnsurer;
     vtkSmartPyObject retVal(
       PyObject_CallMethod(this->FileStore, const_cast<char*>("get_field_valuerange"),
@@ -316,6 +374,10 @@ public:
 
   std::vector<std::string> GetControlParameterValues(const std::string& name) const
   {
+    if (this->UseIndex)
+    {
+      return this->Index.GetControlParameterValues(name);
+    }
     vtkPythonScopeGilEnsurer gilEnsurer;
     vtkSmartPyObject retVal(PyObject_CallMethod(this->FileStore,
       const_cast<char*>("get_control_values_as_strings"), const_cast<char*>("s"), name.c_str()));
@@ -333,6 +395,10 @@ public:
 
   std::vector<double> GetControlParameterValuesAsDouble(const std::string& name) const
   {
+    if (this->UseIndex)
+    {
+      return this->Index.GetControlParameterValuesAsDouble(name);
+    }
     vtkPythonScopeGilEnsurer gilEnsurer;
     vtkSmartPyObject retVal(PyObject_CallMethod(this->FileStore,
       const_cast<char*>("get_control_values"), const_cast<char*>("s"), name.c_str()));
@@ -350,6 +416,10 @@ public:
 
   std::vector<std::string> GetTimeSteps() const
   {
+    if (this->UseIndex)
+    {
+      return this->Index.GetTimeSteps();
+    }
     vtkPythonScopeGilEnsurer gilEnsurer;
     vtkSmartPyObject retVal(
       PyObject_CallMethod(this->FileStore, const_cast<char*>("get_timesteps"), NULL));
@@ -365,8 +435,20 @@ public:
     return std::vector<std::string>();
   }
 
-  std::vector<vtkSmartPointer<vtkImageData> > TranslateQuery(const std::string& query) const
+  std::vector<vtkSmartPointer<vtkImageData> > TranslateQuery(const std::string& query)
   {
+    if (this->UseIndex)
+    {
+      std::vector<vtkSmartPointer<vtkImageData> > layers;
+      // queries the index cannot answer are left to Python, which loads the
+      // store on demand.
+      if (this->Index.TranslateQuery(query, layers) ||
+        !this->LoadDatabase(this->Index.GetFileName().c_str()))
+      {
+        return layers;
+      }
+    }
+
     vtkPythonScopeGilEnsurer gilEnsurer;
     vtkSmartPyObject retVal(PyObject_CallMethod(this->FileStore,
       const_cast<char*>("translate_query"), const_cast<char*>("s"), query.c_str()));
@@ -382,8 +464,12 @@ public:
     }
   }
 
-  std::vector<vtkSmartPointer<vtkCamera> > Cameras(const std::string& ts) const
+  std::vector<vtkSmartPointer<vtkCamera> > Cameras(const std::string& ts)
   {
+    if (this->UseIndex)
+    {
+      return this->Index.Cameras(ts);
+    }
     vtkPythonScopeGilEnsurer gilEnsurer;
     vtkSmartPyObject retVal(PyObject_CallMethod(
       this->FileStore, const_cast<char*>("get_cameras"), const_cast<char*>("s"), ts.c_str()));
@@ -401,6 +487,10 @@ public:
 
   std::string GetSpec() const
   {
+    if (this->UseIndex)
+    {
+      return this->Index.GetSpec();
+    }
     vtkPythonScopeGilEnsurer gilEnsurer;
     vtkSmartPyObject retVal(
       PyObject_CallMethod(this->FileStore, const_cast<char*>("get_spec"), NULL));
@@ -441,7 +531,7 @@ bool vtkCinemaDatabase::Load(const char* fname)
 {
   if (fname && fname[0] != 0)
   {
-    return this->Internals->LoadDatabase(fname);
+    return this->Internals->Load(fname);
   }
 
   return false;
@@ -594,8 +684,34 @@ std::string vtkCinemaDatabase::GetNearestParameterValue(
   return ostr.str();
 }
 
+//----------------------------------------------------------------------------
+void vtkCinemaDatabase::SetLayerCacheSize(int size)
+{
+  this->Internals->Index.SetCacheSize(size);
+}
+
+//----------------------------------------------------------------------------
+int vtkCinemaDatabase::GetLayerCacheSize() const
+{
+  return this->Internals->Index.GetCacheSize();
+}
+
+//----------------------------------------------------------------------------
+void vtkCinemaDatabase::SetPrefetchNeighbors(bool prefetch)
+{
+  this->Internals->Index.SetPrefetch(prefetch);
+}
+
+//----------------------------------------------------------------------------
+bool vtkCinemaDatabase::GetPrefetchNeighbors() const
+{
+  return this->Internals->Index.GetPrefetch();
+}
+
 //----------------------------------------------------------------------------
 void vtkCinemaDatabase::PrintSelf(ostream& os, vtkIndent indent)
 {
   this->Superclass::PrintSelf(os, indent);
+  os << indent << "LayerCacheSize: " << this->GetLayerCacheSize() << endl;
+  os << indent << "PrefetchNeighbors: " << this->GetPrefetchNeighbors() << endl;
 }
@@ -21,6 +21,12 @@
  * `cinema_python.database.file_store.FileStore` instance. The API is
  * limited to the functionality needed for the rendering Cinema layers in
  *  ParaView.
+ *
+ * Spec-C stores, and Spec-D stores described by a `data.csv` file, are read
+ * in C++ without taking the Python GIL. Their decoded layer rasters are
+ * cached, and the rasters of the camera poses and time steps next to the last
+ * query are decoded in the background. Other stores, and the queries needing
+ * rasters only Python can decode, go through `cinema_python`.
  */
 
 #ifndef vtkCinemaDatabase_h
@@ -52,7 +58,8 @@ public:
 
   /**
    * Loads the cinema database.
-   * @param[in] fname path to the `info.json` file corresponding to a Cinema store.
+   * @param[in] fname path to the `info.json` or `data.csv` file corresponding
+   * to a Cinema store, or to its directory.
    * @returns true on success
    */
   bool Load(const char* fname);
@@ -133,6 +140,25 @@ public:
    */
   std::string GetNearestParameterValue(const std::string& param, double value) const;
 
+  //@{
+  /**
+   * Maximum number of decoded rasters (colors, values, depth or luminance)
+   * kept in memory for the stores read in C++. Defaults to 64.
+   */
+  void SetLayerCacheSize(int size);
+  int GetLayerCacheSize() const;
+  //@}
+
+  //@{
+  /**
+   * When true (default), the rasters of the camera poses and time steps
+   * neighbouring the last query are decoded in the background, for the stores
+   * read in C++.
+   */
+  void SetPrefetchNeighbors(bool prefetch);
+  bool GetPrefetchNeighbors() const;
+  //@}
+
 protected:
   vtkCinemaDatabase();
   ~vtkCinemaDatabase() override;
@@ -0,0 +1,2012 @@
+/*=========================================================================
+
+  Program:   Visualization Toolkit
+  Module:    vtkCinemaDatabaseIndex.cxx
+
+  Copyright (c) Ken Martin, Will Schroeder, Bill Lorensen
+  All rights reserved.
+  See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+#include "vtkCinemaDatabaseIndex.h"
+
+#include "vtkBMPReader.h"
+#include "vtkCamera.h"
+#include "vtkDataArray.h"
+#include "vtkFloatArray.h"
+#include "vtkImageData.h"
+#include "vtkImageReader2.h"
+#include "vtkJPEGReader.h"
+#include "vtkMath.h"
+#include "vtkNew.h"
+#include "vtkPNGReader.h"
+#include "vtkPNMReader.h"
+#include "vtkPointData.h"
+#include "vtkTIFFReader.h"
+
+#include "vtk_jsoncpp.h"
+#include "vtk_zlib.h"
+#include <vtksys/SystemTools.hxx>
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <list>
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+namespace
+{
+typedef std::map<std::string, Json::Value> Descriptor;
+
+enum Status
+{
+  STATUS_OK,
+  STATUS_FAILED,
+  STATUS_UNSUPPORTED
+};
+
+//----------------------------------------------------------------------------
+const Json::Value& None()
+{
+  static const Json::Value none;
+  return none;
+}
+
+const Json::Value& Member(const Json::Value& value, const char* key)
+{
+  return value.isObject() ? value[key] : None();
+}
+
+bool IsInteger(const Json::Value& value)
+{
+  return value.type() == Json::intValue || value.type() == Json::uintValue;
+}
+
+// Python's repr() of a float: the shortest string that reads back as `value`.
+std::string PythonFloat(double value)
+{
+  if (std::isnan(value))
+  {
+    return "nan";
+  }
+  if (std::isinf(value))
+  {
+    return value > 0 ? "inf" : "-inf";
+  }
+  char buffer[64];
+  int precision = 1;
+  for (; precision < 17; ++precision)
+  {
+    snprintf(buffer, sizeof(buffer), "%.*e", precision - 1, value);
+    if (std::strtod(buffer, nullptr) == value)
+    {
+      break;
+    }
+  }
+  snprintf(buffer, sizeof(buffer), "%.*e", precision - 1, value);
+  const int exponent = std::atoi(std::strchr(buffer, 'e') + 1);
+  if (exponent < -4 || exponent >= 16)
+  {
+    return buffer;
+  }
+  snprintf(buffer, sizeof(buffer), "%.*f", std::max(precision - 1 - exponent, 0), value);
+  std::string str(buffer);
+  if (str.find('.') == std::string::npos)
+  {
+    str += ".0";
+  }
+  return str;
+}
+
+// Python's str() of a JSON value.
+std::string PythonStr(const Json::Value& value)
+{
+  switch (value.type())
+  {
+    case Json::stringValue:
+      return value.asString();
+    case Json::intValue:
+      return std::to_string(value.asLargestInt());
+    case Json::uintValue:
+      return std::to_string(value.asLargestUInt());
+    case Json::realValue:
+      return PythonFloat(value.asDouble());
+    case Json::booleanValue:
+      return value.asBool() ? "True" : "False";
+    case Json::arrayValue:
+    {
+      std::string str = "[";
+      for (Json::ArrayIndex cc = 0; cc < value.size(); ++cc)
+      {
+        str += cc > 0 ? ", " : "";
+        str += value[cc].isString() ? "'" + value[cc].asString() + "'" : PythonStr(value[cc]);
+      }
+      return str + "]";
+    }
+    default:
+      return "None";
+  }
+}
+
+// Python's == on JSON values, which compares numbers by value.
+bool SameValue(const Json::Value& a, const Json::Value& b)
+{
+  if (a.isNumeric() && b.isNumeric())
+  {
+    return a.asDouble() == b.asDouble();
+  }
+  if (a.isArray() && b.isArray())
+  {
+    if (a.size() != b.size())
+    {
+      return false;
+    }
+    for (Json::ArrayIndex cc = 0; cc < a.size(); ++cc)
+    {
+      if (!SameValue(a[cc], b[cc]))
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+  return a.type() == b.type() && a == b;
+}
+
+int IndexOf(const Json::Value& list, const Json::Value& value)
+{
+  for (Json::ArrayIndex cc = 0; list.isArray() && cc < list.size(); ++cc)
+  {
+    if (SameValue(list[cc], value))
+    {
+      return static_cast<int>(cc);
+    }
+  }
+  return -1;
+}
+
+bool Contains(const Json::Value& list, const Json::Value& value)
+{
+  return IndexOf(list, value) >= 0;
+}
+
+// The single value of a query entry: the first item of a list.
+Json::Value Single(const Json::Value& value)
+{
+  if (value.isArray())
+  {
+    return value.empty() ? Json::Value() : value[0];
+  }
+  return value;
+}
+
+bool IsNumber(const std::string& str)
+{
+  char* end = nullptr;
+  const char* begin = str.c_str();
+  std::strtod(begin, &end);
+  return !str.empty() && end == begin + str.size();
+}
+
+// Numbers written as strings, integers or floats compare the same.
+std::string Canonical(const Json::Value& value)
+{
+  if (value.isNumeric())
+  {
+    return PythonFloat(value.asDouble());
+  }
+  if (value.isString() && IsNumber(value.asString()))
+  {
+    return PythonFloat(std::strtod(value.asString().c_str(), nullptr));
+  }
+  return PythonStr(value);
+}
+
+// Python's os.path.splitext()[1].
+std::string Extension(const std::string& path)
+{
+  const size_t slash = path.find_last_of("/\\");
+  size_t start = slash == std::string::npos ? 0 : slash + 1;
+  while (start < path.size() && path[start] == '.')
+  {
+    ++start;
+  }
+  const size_t dot = path.rfind('.');
+  return dot == std::string::npos || dot < start ? std::string() : path.substr(dot);
+}
+
+std::string Join(const std::string& dir, const std::string& name)
+{
+  return dir.empty() ? name : dir + "/" + name;
+}
+
+bool EndsWith(const std::string& str, const std::string& suffix)
+{
+  return str.size() >= suffix.size() &&
+    str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+//----------------------------------------------------------------------------
+// Parses the Python dictionary literal of a query, e.g.
+// "{'vis': ['Contour1'], 'pose': 3, 'Contour1': [0.5, 1.0]}".
+class QueryParser
+{
+public:
+  QueryParser(const std::string& text)
+    : Text(text)
+    , Position(0)
+  {
+  }
+
+  bool Parse(Descriptor& query)
+  {
+    if (!this->Accept('{'))
+    {
+      return false;
+    }
+    while (!this->Accept('}'))
+    {
+      Json::Value key, value;
+      if (!this->ParseScalar(key) || !key.isString() || !this->Accept(':') ||
+        !this->ParseValue(value))
+      {
+        return false;
+      }
+      query[key.asString()] = value;
+      if (!this->Accept(',') && this->Peek() != '}')
+      {
+        return false;
+      }
+    }
+    return this->Peek() == '\0';
+  }
+
+private:
+  char Peek()
+  {
+    while (this->Position < this->Text.size() && std::isspace(this->Text[this->Position]))
+    {
+      ++this->Position;
+    }
+    return this->Position < this->Text.size() ? this->Text[this->Position] : '\0';
+  }
+
+  bool Accept(char c)
+  {
+    if (this->Peek() == c)
+    {
+      ++this->Position;
+      return true;
+    }
+    return false;
+  }
+
+  bool ParseValue(Json::Value& value)
+  {
+    const char close = this->Accept('[') ? ']' : (this->Accept('(') ? ')' : '\0');
+    if (close == '\0')
+    {
+      return this->ParseScalar(value);
+    }
+    value = Json::Value(Json::arrayValue);
+    while (!this->Accept(close))
+    {
+      Json::Value item;
+      if (!this->ParseValue(item))
+      {
+        return false;
+      }
+      value.append(item);
+      if (!this->Accept(',') && this->Peek() != close)
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool ParseScalar(Json::Value& value)
+  {
+    const char quote = this->Peek();
+    if (quote == '\'' || quote == '"')
+    {
+      std::string str;
+      for (++this->Position; this->Position < this->Text.size(); ++this->Position)
+      {
+        char c = this->Text[this->Position];
+        if (c == quote)
+        {
+          ++this->Position;
+          value = str;
+          return true;
+        }
+        if (c == '\\' && this->Position + 1 < this->Text.size())
+        {
+          c = this->Text[++this->Position];
+          c = c == 'n' ? '\n' : (c == 't' ? '\t' : c);
+        }
+        str += c;
+      }
+      return false;
+    }
+    const size_t end = this->Text.find_first_of(",:]}) \t\r\n", this->Position);
+    const std::string token = this->Text.substr(this->Position, end - this->Position);
+    if (token.empty())
+    {
+      return false;
+    }
+    this->Position += token.size();
+    if (token == "True" || token == "False")
+    {
+      value = token == "True";
+    }
+    else if (token == "None")
+    {
+      value = Json::Value();
+    }
+    else if (token.find_first_not_of("+-0123456789") == std::string::npos && IsNumber(token))
+    {
+      value = static_cast<Json::Int64>(std::strtoll(token.c_str(), nullptr, 10));
+    }
+    else if (IsNumber(token))
+    {
+      value = std::strtod(token.c_str(), nullptr);
+    }
+    else
+    {
+      return false;
+    }
+    return true;
+  }
+
+  const std::string& Text;
+  size_t Position;
+};
+
+//----------------------------------------------------------------------------
+enum RasterRole
+{
+  COLORS,
+  VALUES,
+  DEPTH,
+  LUMINANCE,
+  NUMBER_OF_ROLES
+};
+const char* const RoleNames[NUMBER_OF_ROLES] = { "Colors", "Values", "Depth", "Luminance" };
+
+// A file holding one raster of a layer.
+struct RasterRequest
+{
+  std::string FileName; // empty when the layer has no raster for the role
+  bool Float = false;   // zlib compressed float32 values, otherwise an image
+  bool RGB = false;     // the image must have 3 components
+  int Width = -1;       // shape of float rasters, -1 when unknown
+  int Height = -1;
+};
+typedef std::array<RasterRequest, NUMBER_OF_ROLES> LayerRequest;
+
+std::string RasterKey(int role, const RasterRequest& request)
+{
+  return std::string(RoleNames[role]) + ":" + request.FileName;
+}
+
+struct Raster
+{
+  vtkSmartPointer<vtkDataArray> Array;
+  int Width = -1;
+  int Height = -1;
+};
+
+// Reads a float raster: `<name>.Z`, the zlib compressed float32 values.
+Status ReadFloatRaster(const RasterRequest& request, Raster& raster)
+{
+  const std::string& fname = request.FileName;
+  const std::string base = fname.substr(0, fname.size() - Extension(fname).size());
+  std::ifstream file((base + ".Z").c_str(), ios::in | ios::binary);
+  if (!file)
+  {
+    // numpy archives are left to Python.
+    return vtksys::SystemTools::FileExists(base + ".npz") ? STATUS_UNSUPPORTED : STATUS_FAILED;
+  }
+  const std::string compressed(
+    (std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+  const bool shaped = request.Width >= 0 && request.Height >= 0;
+  std::vector<unsigned char> buffer(
+    shaped ? 4 * static_cast<size_t>(request.Width) * request.Height : 4 * compressed.size());
+  const size_t maximumSize = 1032 * compressed.size() + 1024;
+  while (true)
+  {
+    uLongf length = static_cast<uLongf>(std::max<size_t>(buffer.size(), 1));
+    buffer.resize(length);
+    const int result = uncompress(buffer.data(), &length,
+      reinterpret_cast<const Bytef*>(compressed.data()), static_cast<uLong>(compressed.size()));
+    if (result == Z_OK)
+    {
+      buffer.resize(length);
+      break;
+    }
+    if (result != Z_BUF_ERROR || buffer.size() > maximumSize)
+    {
+      return STATUS_FAILED;
+    }
+    buffer.resize(2 * buffer.size());
+  }
+
+  const vtkIdType count = static_cast<vtkIdType>(buffer.size() / 4);
+  if (buffer.size() % 4 != 0 ||
+    (shaped && count != static_cast<vtkIdType>(request.Width) * request.Height))
+  {
+    return STATUS_FAILED;
+  }
+  vtkNew<vtkFloatArray> values;
+  values->SetNumberOfTuples(count);
+  std::memcpy(values->GetPointer(0), buffer.data(), buffer.size());
+  raster.Array = values;
+  raster.Width = request.Width;
+  raster.Height = request.Height;
+  return STATUS_OK;
+}
+
+// Reads an image, with its rows ordered from top to bottom.
+Status ReadImageRaster(const RasterRequest& request, Raster& raster)
+{
+  const std::string& fname = request.FileName;
+  const std::string extension = Extension(fname);
+  vtkSmartPointer<vtkImageReader2> reader;
+  if (extension == ".png")
+  {
+    reader = vtkSmartPointer<vtkPNGReader>::New();
+  }
+  else if (extension == ".bmp")
+  {
+    reader = vtkSmartPointer<vtkBMPReader>::New();
+  }
+  else if (extension == ".ppm")
+  {
+    reader = vtkSmartPointer<vtkPNMReader>::New();
+  }
+  else if (extension == ".tif" || extension == ".tiff")
+  {
+    reader = vtkSmartPointer<vtkTIFFReader>::New();
+  }
+  else if (extension == ".jpg" || extension == ".jpeg")
+  {
+    reader = vtkSmartPointer<vtkJPEGReader>::New();
+  }
+  else
+  {
+    return STATUS_UNSUPPORTED;
+  }
+  if (!vtksys::SystemTools::FileExists(fname) || !reader->CanReadFile(fname.c_str()))
+  {
+    return STATUS_FAILED;
+  }
+  reader->SetFileName(fname.c_str());
+  reader->Update();
+
+  vtkImageData* image = reader->GetOutput();
+  vtkDataArray* scalars = image->GetPointData()->GetScalars();
+  int dims[3];
+  image->GetDimensions(dims);
+  if (!scalars || dims[2] != 1 || (request.RGB && scalars->GetNumberOfComponents() != 3))
+  {
+    return STATUS_FAILED;
+  }
+  vtkSmartPointer<vtkDataArray> flipped;
+  flipped.TakeReference(scalars->NewInstance());
+  flipped->SetNumberOfComponents(scalars->GetNumberOfComponents());
+  flipped->SetNumberOfTuples(static_cast<vtkIdType>(dims[0]) * dims[1]);
+  for (int row = 0; row < dims[1]; ++row)
+  {
+    flipped->InsertTuples(static_cast<vtkIdType>(row) * dims[0], dims[0],
+      static_cast<vtkIdType>(dims[1] - 1 - row) * dims[0], scalars);
+  }
+  raster.Array = flipped;
+  raster.Width = dims[0];
+  raster.Height = dims[1];
+  return STATUS_OK;
+}
+
+Status ReadRaster(int role, const RasterRequest& request, Raster& raster)
+{
+  const Status status =
+    request.Float ? ReadFloatRaster(request, raster) : ReadImageRaster(request, raster);
+  if (status == STATUS_OK)
+  {
+    raster.Array->SetName(RoleNames[role]);
+  }
+  return status;
+}
+
+//----------------------------------------------------------------------------
+// The least recently used decoded rasters, shared with the prefetching thread.
+class RasterCache
+{
+public:
+  bool Find(const std::string& key, Raster& raster)
+  {
+    std::lock_guard<std::mutex> lock(this->Mutex);
+    auto iter = this->Lookup.find(key);
+    if (iter == this->Lookup.end())
+    {
+      return false;
+    }
+    this->Entries.splice(this->Entries.begin(), this->Entries, iter->second);
+    raster = iter->second->second;
+    return true;
+  }
+
+  bool Contains(const std::string& key) const
+  {
+    std::lock_guard<std::mutex> lock(this->Mutex);
+    return this->Lookup.find(key) != this->Lookup.end();
+  }
+
+  void Insert(const std::string& key, const Raster& raster)
+  {
+    std::lock_guard<std::mutex> lock(this->Mutex);
+    auto iter = this->Lookup.find(key);
+    if (iter != this->Lookup.end())
+    {
+      iter->second->second = raster;
+      this->Entries.splice(this->Entries.begin(), this->Entries, iter->second);
+      return;
+    }
+    if (this->Capacity > 0)
+    {
+      this->Entries.emplace_front(key, raster);
+      this->Lookup[key] = this->Entries.begin();
+      this->Trim();
+    }
+  }
+
+  void Clear()
+  {
+    std::lock_guard<std::mutex> lock(this->Mutex);
+    this->Entries.clear();
+    this->Lookup.clear();
+  }
+
+  void SetCapacity(size_t capacity)
+  {
+    std::lock_guard<std::mutex> lock(this->Mutex);
+    this->Capacity = capacity;
+    this->Trim();
+  }
+
+  size_t GetCapacity() const
+  {
+    std::lock_guard<std::mutex> lock(this->Mutex);
+    return this->Capacity;
+  }
+
+private:
+  void Trim()
+  {
+    while (this->Entries.size() > this->Capacity)
+    {
+      this->Lookup.erase(this->Entries.back().first);
+      this->Entries.pop_back();
+    }
+  }
+
+  typedef std::list<std::pair<std::string, Raster> > EntriesT;
+  mutable std::mutex Mutex;
+  size_t Capacity = 64;
+  EntriesT Entries;
+  std::unordered_map<std::string, EntriesT::iterator> Lookup;
+};
+
+//----------------------------------------------------------------------------
+// Decodes rasters into a RasterCache on a background thread. Each Schedule()
+// replaces the rasters still waiting to be decoded.
+class RasterPrefetcher
+{
+public:
+  struct Job
+  {
+    int Role;
+    RasterRequest Request;
+  };
+
+  RasterPrefetcher(RasterCache& cache)
+    : Cache(cache)
+  {
+  }
+
+  ~RasterPrefetcher()
+  {
+    {
+      std::lock_guard<std::mutex> lock(this->Mutex);
+      this->Stop = true;
+    }
+    this->Condition.notify_all();
+    if (this->Thread.joinable())
+    {
+      this->Thread.join();
+    }
+  }
+
+  void Schedule(const std::vector<Job>& jobs)
+  {
+    {
+      std::lock_guard<std::mutex> lock(this->Mutex);
+      this->Pending.assign(jobs.begin(), jobs.end());
+      if (!jobs.empty() && !this->Thread.joinable())
+      {
+        this->Thread = std::thread(&RasterPrefetcher::Run, this);
+      }
+    }
+    this->Condition.notify_one();
+  }
+
+  // Drops the pending rasters, and the one being decoded.
+  void Cancel()
+  {
+    std::lock_guard<std::mutex> lock(this->Mutex);
+    this->Pending.clear();
+    ++this->Generation;
+  }
+
+private:
+  void Run()
+  {
+    std::unique_lock<std::mutex> lock(this->Mutex);
+    while (true)
+    {
+      this->Condition.wait(lock, [this]() { return this->Stop || !this->Pending.empty(); });
+      if (this->Stop)
+      {
+        return;
+      }
+      const Job job = this->Pending.front();
+      this->Pending.pop_front();
+      const unsigned int generation = this->Generation;
+      lock.unlock();
+
+      const std::string key = RasterKey(job.Role, job.Request);
+      Raster raster;
+      const bool decoded =
+        !this->Cache.Contains(key) && ReadRaster(job.Role, job.Request, raster) == STATUS_OK;
+
+      lock.lock();
+      if (decoded && generation == this->Generation)
+      {
+        this->Cache.Insert(key, raster);
+      }
+    }
+  }
+
+  RasterCache& Cache;
+  std::mutex Mutex;
+  std::condition_variable Condition;
+  std::deque<Job> Pending;
+  std::thread Thread;
+  unsigned int Generation = 0;
+  bool Stop = false;
+};
+
+// Stores already warned about, to warn once per store like cinemareader.
+std::set<std::string> ValueModeWarnings;
+}
+
+//----------------------------------------------------------------------------
+class vtkCinemaDatabaseIndex::vtkInternals
+{
+public:
+  vtkInternals()
+    : Prefetcher(Cache)
+  {
+  }
+
+  std::string FileName;
+  std::string Spec; // "specC", "specA" for Spec-D stores, empty when not loaded.
+  std::string Directory;
+  Json::Value Parameters;
+  Json::Value Metadata;
+  Json::Value Associations;
+  std::string Extension;
+  std::string DefaultType;
+  int ImageWidth = -1;
+  int ImageHeight = -1;
+
+  // Spec-D stores: the columns, and the file of each row keyed by its values.
+  std::vector<std::string> Columns;
+  std::map<std::string, std::string> Files;
+
+  std::map<int, std::vector<vtkSmartPointer<vtkCamera> > > CameraCache;
+  bool PrefetchEnabled = true;
+  RasterCache Cache;
+  RasterPrefetcher Prefetcher;
+
+  bool IsLoaded() const { return !this->Spec.empty(); }
+  bool IsComposite() const { return this->Spec == "specC"; }
+
+  void Reset()
+  {
+    this->Prefetcher.Cancel();
+    this->Cache.Clear();
+    this->FileName.clear();
+    this->Spec.clear();
+    this->Directory.clear();
+    this->Parameters = Json::Value(Json::objectValue);
+    this->Metadata = Json::Value(Json::objectValue);
+    this->Associations = Json::Value(Json::objectValue);
+    this->Extension.clear();
+    this->DefaultType = "RGB";
+    this->ImageWidth = this->ImageHeight = -1;
+    this->Columns.clear();
+    this->Files.clear();
+    this->CameraCache.clear();
+  }
+
+  //----------------------------------------------------------------------------
+  // Reads the `info.json` of a Spec-C store, as cinema_python's FileStore
+  // does. Anything else is left to Python, which reports the errors.
+  LoadStatus LoadComposite(const std::string& path)
+  {
+    std::ifstream file(path.c_str());
+    Json::Value root;
+    Json::CharReaderBuilder builder;
+    if (!file || !Json::parseFromStream(builder, file, &root, nullptr) || !root.isObject())
+    {
+      return UNSUPPORTED;
+    }
+    const Json::Value& parameters =
+      root.isMember("arguments") ? root["arguments"] : root["parameter_list"];
+    const Json::Value& associations =
+      root.isMember("associations") ? root["associations"] : root["constraints"];
+    const Json::Value& metadata = root["metadata"];
+    const Json::Value& pattern = root["name_pattern"];
+    if (!parameters.isObject() || !metadata.isObject() || !pattern.isString() ||
+      !(associations.isObject() || associations.isNull()))
+    {
+      return UNSUPPORTED;
+    }
+    if (Member(metadata, "type") != "composite-image-stack" ||
+      Member(metadata, "camera_model") != "azimuth-elevation-roll")
+    {
+      return UNSUPPORTED;
+    }
+
+    // only the layout that names the files after the parameter value indices.
+    const Json::Value& version = metadata["version"];
+    const std::string versionStr = version.isString() ? version.asString() : std::string();
+    const size_t dot = versionStr.find('.');
+    if (dot == std::string::npos || (std::atoi(versionStr.c_str()) == 0 &&
+                                      std::atoi(versionStr.c_str() + dot + 1) == 0))
+    {
+      return UNSUPPORTED;
+    }
+
+    for (const std::string& name : parameters.getMemberNames())
+    {
+      const Json::Value& param = parameters[name];
+      if (!param.isObject() || !(param["values"].isArray() || param["values"].isNull()) ||
+        !(param["types"].isArray() || param["types"].isNull()))
+      {
+        return UNSUPPORTED;
+      }
+    }
+    for (const std::string& name : associations.getMemberNames())
+    {
+      if (!associations[name].isObject())
+      {
+        return UNSUPPORTED;
+      }
+    }
+
+    this->Parameters = parameters;
+    this->Associations = associations.isNull() ? Json::Value(Json::objectValue) : associations;
+    this->Metadata = metadata;
+    this->AddMagnitudes();
+
+    const std::string namePattern = pattern.asString();
+    this->Extension = ::Extension(namePattern);
+    this->DefaultType = EndsWith(namePattern, ".txt") ? "TXT" : "RGB";
+    const Json::Value& size = this->Metadata["image_size"];
+    if (size.isArray() && size.size() >= 2 && size[0].isNumeric() && size[1].isNumeric())
+    {
+      this->ImageHeight = size[0].asInt();
+      this->ImageWidth = size[1].asInt();
+    }
+
+    const Json::Value& mode = this->Metadata["value_mode"];
+    if (!(mode.isNumeric() && mode.asDouble() == 2) &&
+      ValueModeWarnings.insert(this->FileName).second)
+    {
+      vtkGenericWarningMacro("Warning: the cinema store '"
+        << this->FileName << "', encodes data values as RGB arrays which is known to "
+        << "have issues in current implementation. Scalar "
+        << "coloring may produce unexpected results.");
+    }
+    this->Spec = "specC";
+    return LOADED;
+  }
+
+  // Adds the "<vector>_magnitude" field values of the vector fields whose
+  // components are stored as "<vector>_x", "<vector>_y"..., like Store does.
+  void AddMagnitudes()
+  {
+    for (const std::string& name : this->Parameters.getMemberNames())
+    {
+      Json::Value& param = this->Parameters[name];
+      if (!param.isMember("values") || !param.isMember("types"))
+      {
+        continue;
+      }
+      Json::Value& values = param["values"];
+      Json::Value& types = param["types"];
+      if (!types.isArray() || !values.isArray())
+      {
+        continue;
+      }
+      std::map<std::string, int> vectors;
+      for (Json::ArrayIndex cc = 0; cc < types.size() && cc < values.size(); ++cc)
+      {
+        if (types[cc] != "value" || !values[cc].isString())
+        {
+          continue;
+        }
+        const std::string value = values[cc].asString();
+        const size_t last = value.rfind('_');
+        if (last != std::string::npos && last + 2 == value.size() &&
+          std::strchr("0123456789xyzXYZ", value[last + 1]))
+        {
+          ++vectors[value.substr(0, value.find('_'))];
+        }
+      }
+      for (const auto& vector : vectors)
+      {
+        const Json::Value magnitude = vector.first + "_magnitude";
+        if (vector.second > 1 && !Contains(values, magnitude))
+        {
+          values.append(magnitude);
+          types.append("magnitude");
+        }
+      }
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  // Reads the `data.csv` of a Spec-D store: one column per parameter, and a
+  // FILE column with the image for the values of the row.
+  LoadStatus LoadTable(const std::string& path)
+  {
+    std::ifstream file(path.c_str());
+    std::string line;
+    if (!file || !std::getline(file, line))
+    {
+      vtkGenericWarningMacro("Failed to read the Cinema store index '" << path << "'.");
+      return FAILED;
+    }
+    const std::vector<std::string> header = SplitCSVLine(line);
+    const auto fileColumn = std::find(header.begin(), header.end(), "FILE");
+    if (fileColumn == header.end())
+    {
+      vtkGenericWarningMacro("No FILE column in the Cinema store index '" << path << "'.");
+      return FAILED;
+    }
+    const size_t fileIndex = fileColumn - header.begin();
+
+    std::vector<std::vector<std::string> > rows;
+    while (std::getline(file, line))
+    {
+      if (!line.empty() && line.back() == '\r')
+      {
+        line.pop_back();
+      }
+      if (line.empty())
+      {
+        continue;
+      }
+      rows.push_back(SplitCSVLine(line));
+      if (rows.back().size() != header.size())
+      {
+        vtkGenericWarningMacro("Row " << rows.size() << " of the Cinema store index '" << path
+                                      << "' does not match its header.");
+        return FAILED;
+      }
+    }
+
+    this->Parameters = Json::Value(Json::objectValue);
+    for (size_t col = 0; col < header.size(); ++col)
+    {
+      if (col == fileIndex)
+      {
+        continue;
+      }
+      bool numeric = true;
+      for (const auto& row : rows)
+      {
+        numeric = numeric && IsNumber(row[col]);
+      }
+      std::map<std::string, Json::Value> distinct;
+      for (const auto& row : rows)
+      {
+        const Json::Value value =
+          numeric ? Json::Value(std::strtod(row[col].c_str(), nullptr)) : Json::Value(row[col]);
+        distinct.insert(std::make_pair(Canonical(value), value));
+      }
+      std::vector<Json::Value> sorted;
+      for (const auto& item : distinct)
+      {
+        sorted.push_back(item.second);
+      }
+      std::sort(sorted.begin(), sorted.end(), LessValue);
+      Json::Value& param = this->Parameters[header[col]];
+      param["type"] = "range";
+      param["values"] = Json::Value(Json::arrayValue);
+      for (const Json::Value& value : sorted)
+      {
+        param["values"].append(value);
+      }
+      param["default"] = sorted.empty() ? Json::Value() : sorted.front();
+      this->Columns.push_back(header[col]);
+    }
+    for (const auto& row : rows)
+    {
+      std::string key;
+      for (size_t col = 0; col < header.size(); ++col)
+      {
+        if (col != fileIndex)
+        {
+          key += Canonical(Json::Value(row[col])) + '\x1f';
+        }
+      }
+      this->Files[key] = Join(this->Directory, row[fileIndex]);
+    }
+    this->Spec = "specA";
+    return LOADED;
+  }
+
+  static std::vector<std::string> SplitCSVLine(const std::string& line)
+  {
+    std::vector<std::string> cells(1);
+    bool quoted = false;
+    for (size_t cc = 0; cc < line.size(); ++cc)
+    {
+      const char c = line[cc];
+      if (c == '"' && quoted && cc + 1 < line.size() && line[cc + 1] == '"')
+      {
+        cells.back() += '"';
+        ++cc;
+      }
+      else if (c == '"')
+      {
+        quoted = !quoted;
+      }
+      else if (c == ',' && !quoted)
+      {
+        cells.emplace_back();
+      }
+      else
+      {
+        cells.back() += c;
+      }
+    }
+    return cells;
+  }
+
+  // Python's ordering of numbers and strings; numbers come first.
+  static bool LessValue(const Json::Value& a, const Json::Value& b)
+  {
+    if (a.isNumeric() && b.isNumeric())
+    {
+      return a.asDouble() < b.asDouble();
+    }
+    if (a.isNumeric() != b.isNumeric())
+    {
+      return a.isNumeric();
+    }
+    return PythonStr(a) < PythonStr(b);
+  }
+
+  //----------------------------------------------------------------------------
+  std::string Role(const std::string& name) const
+  {
+    const Json::Value& role = Member(Member(this->Parameters, name.c_str()), "role");
+    return role.isString() ? role.asString() : std::string();
+  }
+
+  // The field and the control parameters associated with a `vis` value, as
+  // Store.parameters_for_object().
+  void ObjectParameters(
+    const Json::Value& object, std::string& field, std::vector<std::string>& controls) const
+  {
+    field.clear();
+    controls.clear();
+    for (const std::string& name : this->Associations.getMemberNames())
+    {
+      if (!Contains(this->Associations[name]["vis"], object))
+      {
+        continue;
+      }
+      const std::string role = this->Role(name);
+      if (role == "field" && field.empty())
+      {
+        field = name;
+      }
+      else if (role == "control")
+      {
+        controls.push_back(name);
+      }
+    }
+  }
+
+  std::map<std::string, std::vector<std::string> > AllParents() const
+  {
+    std::map<std::string, std::vector<std::string> > parents;
+    const Json::Value& pipeline = this->Metadata["pipeline"];
+    if (!pipeline.isArray())
+    {
+      return parents;
+    }
+    std::map<std::string, std::string> names;
+    for (const Json::Value& item : pipeline)
+    {
+      names[PythonStr(Member(item, "id"))] = PythonStr(Member(item, "name"));
+    }
+    for (const Json::Value& item : pipeline)
+    {
+      std::vector<std::string>& itemParents = parents[PythonStr(Member(item, "name"))];
+      const Json::Value& ids = Member(item, "parents");
+      for (Json::ArrayIndex cc = 0; ids.isArray() && cc < ids.size(); ++cc)
+      {
+        auto iter = names.find(PythonStr(ids[cc]));
+        if (iter != names.end())
+        {
+          itemParents.push_back(iter->second);
+        }
+      }
+    }
+    return parents;
+  }
+
+  std::vector<Json::Value> SortedValues(const std::string& parameter) const
+  {
+    const Json::Value& values = Member(Member(this->Parameters, parameter.c_str()), "values");
+    std::vector<Json::Value> sorted;
+    for (Json::ArrayIndex cc = 0; values.isArray() && cc < values.size(); ++cc)
+    {
+      sorted.push_back(values[cc]);
+    }
+    std::stable_sort(sorted.begin(), sorted.end(), LessValue);
+    return sorted;
+  }
+
+  //----------------------------------------------------------------------------
+  // The rasters of the layers for a query, as QueryMaker_SpecB does.
+  Status Plan(const Descriptor& query, std::vector<LayerRequest>& layers) const
+  {
+    layers.clear();
+    return this->IsComposite() ? this->PlanComposite(query, layers)
+                               : this->PlanTable(query, layers);
+  }
+
+  Status PlanTable(const Descriptor& query, std::vector<LayerRequest>& layers) const
+  {
+    std::string key;
+    for (const std::string& name : this->Columns)
+    {
+      auto iter = query.find(name);
+      const Json::Value value =
+        iter != query.end() ? Single(iter->second) : this->Parameters[name]["default"];
+      if (value.isNull())
+      {
+        return STATUS_FAILED;
+      }
+      key += Canonical(value) + '\x1f';
+    }
+    auto file = this->Files.find(key);
+    if (file == this->Files.end())
+    {
+      return STATUS_FAILED;
+    }
+    LayerRequest layer;
+    layer[COLORS] = this->Request(file->second, false);
+    layers.push_back(layer);
+    return STATUS_OK;
+  }
+
+  Status PlanComposite(const Descriptor& request, std::vector<LayerRequest>& layers) const
+  {
+    // every parameter has a value, the default one when not requested.
+    Descriptor query;
+    for (const std::string& name : this->Parameters.getMemberNames())
+    {
+      auto iter = request.find(name);
+      if (iter != request.end())
+      {
+        query[name] = iter->second;
+      }
+      else if (this->Parameters[name].isMember("default"))
+      {
+        query[name].append(this->Parameters[name]["default"]);
+      }
+      else
+      {
+        return STATUS_FAILED;
+      }
+    }
+
+    // the pose is requested by index, -1 for no layers.
+    auto pose = query.find("pose");
+    if (pose == query.end())
+    {
+      return STATUS_OK;
+    }
+    if (IsInteger(pose->second))
+    {
+      const Json::Value& poses = this->Parameters["pose"]["values"];
+      const int count = static_cast<int>(poses.size());
+      int index = pose->second.asInt();
+      if (index == -1)
+      {
+        return STATUS_OK;
+      }
+      index = index < 0 ? index + count : index;
+      if (index < 0 || index >= count)
+      {
+        return STATUS_FAILED;
+      }
+      pose->second = poses[index];
+    }
+
+    // values shared by all layers (time, camera...)
+    Descriptor base;
+    for (const auto& item : query)
+    {
+      if (!this->Parameters[item.first].isMember("role"))
+      {
+        base[item.first] = item.first == "pose" ? item.second : Single(item.second);
+        if (base[item.first].isNull() || (item.first != "pose" && !item.second.isArray()))
+        {
+          return STATUS_FAILED;
+        }
+      }
+    }
+
+    auto vis = query.find("vis");
+    if (vis == query.end())
+    {
+      return STATUS_OK;
+    }
+    for (Json::ArrayIndex cc = 0; vis->second.isArray() && cc < vis->second.size(); ++cc)
+    {
+      const Json::Value& object = vis->second[cc];
+      std::string field;
+      std::vector<std::string> controls;
+      this->ObjectParameters(object, field, controls);
+
+      // the object's own control values, or else its field values, vary
+      // fastest; then the control values of the upstream objects.
+      std::vector<std::pair<std::string, Json::Value> > own;
+      const std::string name = object.isString() ? object.asString() : std::string();
+      auto self = std::find(controls.begin(), controls.end(), name);
+      if (!name.empty() && self != controls.end())
+      {
+        controls.erase(self);
+        own = SpecificQueries(query, name);
+      }
+      if (own.empty() && !field.empty())
+      {
+        own = SpecificQueries(query, field);
+      }
+      std::vector<std::vector<std::pair<std::string, Json::Value> > > combinations(1);
+      for (const std::string& control : controls)
+      {
+        combinations = Product(combinations, SpecificQueries(query, control));
+      }
+      combinations = Product(combinations, own);
+
+      for (const auto& combination : combinations)
+      {
+        Descriptor descriptor = base;
+        descriptor["vis"] = object;
+        for (const auto& item : combination)
+        {
+          descriptor[item.first] = item.second;
+        }
+        LayerRequest layer;
+        const Status status = this->PlanLayer(query, descriptor, field, layer);
+        if (status != STATUS_OK)
+        {
+          return status;
+        }
+        layers.push_back(layer);
+      }
+    }
+    return STATUS_OK;
+  }
+
+  static std::vector<std::pair<std::string, Json::Value> > SpecificQueries(
+    const Descriptor& query, const std::string& name)
+  {
+    std::vector<std::pair<std::string, Json::Value> > queries;
+    auto iter = query.find(name);
+    if (iter != query.end())
+    {
+      const Json::Value& values = iter->second;
+      for (Json::ArrayIndex cc = 0; values.isArray() && cc < values.size(); ++cc)
+      {
+        queries.push_back(std::make_pair(name, values[cc]));
+      }
+      if (!values.isArray())
+      {
+        queries.push_back(std::make_pair(name, values));
+      }
+    }
+    return queries;
+  }
+
+  static std::vector<std::vector<std::pair<std::string, Json::Value> > > Product(
+    const std::vector<std::vector<std::pair<std::string, Json::Value> > >& current,
+    const std::vector<std::pair<std::string, Json::Value> >& next)
+  {
+    std::vector<std::vector<std::pair<std::string, Json::Value> > > product;
+    for (const auto& combination : current)
+    {
+      for (const auto& item : next)
+      {
+        product.push_back(combination);
+        product.back().push_back(item);
+      }
+    }
+    return product;
+  }
+
+  // The image type of a field value: "Z", "LUMINANCE", "VALUE", "MAGNITUDE",
+  // or the default type of the store.
+  std::string DocumentType(const std::string& field, const Json::Value& value) const
+  {
+    const Json::Value& param = this->Parameters[field];
+    const int index = IndexOf(param["values"], value);
+    const Json::Value& types = param["types"];
+    if (index >= 0 && types.isArray() && index < static_cast<int>(types.size()))
+    {
+      const std::string type = PythonStr(types[index]);
+      if (type == "depth")
+      {
+        return "Z";
+      }
+      if (type == "luminance" || type == "value" || type == "magnitude")
+      {
+        return vtksys::SystemTools::UpperCase(type);
+      }
+    }
+    return this->DefaultType;
+  }
+
+  Status PlanLayer(const Descriptor& query, const Descriptor& descriptor,
+    const std::string& field, LayerRequest& layer) const
+  {
+    if (field.empty() || !this->Parameters.isMember(field))
+    {
+      return STATUS_FAILED;
+    }
+    const Json::Value& values = this->Parameters[field]["values"];
+    const Json::Value& types = this->Parameters[field]["types"];
+    auto requested = query.find(field);
+
+    // the depth, luminance and rgb rasters, and the requested values; one
+    // field value per image type.
+    std::vector<std::pair<std::string, Json::Value> > fields;
+    for (Json::ArrayIndex cc = 0; values.isArray() && cc < values.size(); ++cc)
+    {
+      if (!types.isArray() || cc >= types.size())
+      {
+        return STATUS_FAILED;
+      }
+      const std::string type = PythonStr(types[cc]);
+      if (type == "depth" || type == "luminance" || type == "rgb" ||
+        (requested != query.end() && Contains(requested->second, values[cc])))
+      {
+        const std::string doctype = this->DocumentType(field, values[cc]);
+        auto iter = std::find_if(fields.begin(), fields.end(),
+          [&doctype](const std::pair<std::string, Json::Value>& item) {
+            return item.first == doctype;
+          });
+        if (iter != fields.end())
+        {
+          iter->second = values[cc];
+        }
+        else
+        {
+          fields.push_back(std::make_pair(doctype, values[cc]));
+        }
+      }
+    }
+
+    if (fields.empty())
+    {
+      std::string path;
+      if (this->DefaultType != "RGB" ||
+        this->DocumentFileName(descriptor, this->DefaultType, path) != STATUS_OK)
+      {
+        return STATUS_FAILED;
+      }
+      layer[COLORS] = this->Request(path, false);
+      return STATUS_OK;
+    }
+    for (const auto& item : fields)
+    {
+      Descriptor fieldDescriptor = descriptor;
+      fieldDescriptor[field] = item.second;
+      std::string path;
+      if (item.first == "MAGNITUDE")
+      {
+        return STATUS_UNSUPPORTED;
+      }
+      if (this->DocumentFileName(fieldDescriptor, item.first, path) != STATUS_OK)
+      {
+        return STATUS_FAILED;
+      }
+      const bool isFloat = item.first == "Z" || ::Extension(path) == ".im";
+      if (item.first == "RGB" && layer[COLORS].FileName.empty())
+      {
+        layer[COLORS] = this->Request(path, false);
+      }
+      else if (item.first == "Z")
+      {
+        layer[DEPTH] = this->Request(path, true);
+      }
+      else if (item.first == "LUMINANCE")
+      {
+        layer[LUMINANCE] = this->Request(path, false);
+      }
+      else if (item.first == "VALUE")
+      {
+        // values encoded as colors are left to Python.
+        if (!isFloat)
+        {
+          return STATUS_UNSUPPORTED;
+        }
+        layer[VALUES] = this->Request(path, true);
+      }
+      else if (item.first != "RGB")
+      {
+        return STATUS_FAILED;
+      }
+    }
+    return STATUS_OK;
+  }
+
+  RasterRequest Request(const std::string& path, bool isFloat) const
+  {
+    RasterRequest request;
+    request.FileName = path;
+    request.Float = isFloat;
+    request.RGB = this->IsComposite();
+    request.Width = this->ImageWidth;
+    request.Height = this->ImageHeight;
+    return request;
+  }
+
+  // The file of a descriptor: "<name>=<value index>" for each parameter,
+  // dependees first, as FileStore._get_filename() does.
+  Status DocumentFileName(
+    const Descriptor& descriptor, const std::string& doctype, std::string& path) const
+  {
+    std::deque<std::string> pending;
+    for (const auto& item : descriptor)
+    {
+      pending.push_back(item.first);
+    }
+    std::vector<std::string> ordered;
+    size_t stalled = 0;
+    while (!pending.empty())
+    {
+      const std::string name = pending.front();
+      pending.pop_front();
+      const Json::Value& dependees = Member(this->Associations, name.c_str());
+      bool ready = true;
+      for (const std::string& dependee : dependees.getMemberNames())
+      {
+        ready = ready && std::find(ordered.begin(), ordered.end(), dependee) != ordered.end();
+      }
+      if (ready)
+      {
+        ordered.push_back(name);
+        stalled = 0;
+      }
+      else if (++stalled > pending.size())
+      {
+        return STATUS_FAILED;
+      }
+      else
+      {
+        pending.push_back(name);
+      }
+    }
+
+    std::string base;
+    for (const std::string& name : ordered)
+    {
+      const int index =
+        IndexOf(Member(Member(this->Parameters, name.c_str()), "values"), descriptor.at(name));
+      if (index < 0)
+      {
+        return STATUS_FAILED;
+      }
+      base += (base.empty() ? "" : "/") + name + "=" + std::to_string(index);
+    }
+
+    std::string extension = this->Extension;
+    if (doctype == "Z" ||
+      (doctype == "VALUE" &&
+        !vtksys::SystemTools::FileExists(Join(this->Directory, base + extension))))
+    {
+      extension = ".im";
+    }
+    path = Join(this->Directory, base + extension);
+    path.erase(std::remove(path.begin(), path.end(), '*'), path.end());
+    return STATUS_OK;
+  }
+
+  //----------------------------------------------------------------------------
+  Status GetRaster(int role, const RasterRequest& request, Raster& raster)
+  {
+    const std::string key = RasterKey(role, request);
+    if (this->Cache.Find(key, raster))
+    {
+      return STATUS_OK;
+    }
+    const Status status = ReadRaster(role, request, raster);
+    if (status == STATUS_OK)
+    {
+      this->Cache.Insert(key, raster);
+    }
+    return status;
+  }
+
+  // Builds the image of a layer, as cinemareader's layer2img() does.
+  Status Assemble(const LayerRequest& request, vtkSmartPointer<vtkImageData>& image)
+  {
+    Raster rasters[NUMBER_OF_ROLES];
+    for (int role = 0; role < NUMBER_OF_ROLES; ++role)
+    {
+      if (!request[role].FileName.empty())
+      {
+        const Status status = this->GetRaster(role, request[role], rasters[role]);
+        if (status != STATUS_OK)
+        {
+          return status;
+        }
+      }
+    }
+
+    image = vtkSmartPointer<vtkImageData>::New();
+    const Raster& scalars = rasters[VALUES].Array ? rasters[VALUES] : rasters[COLORS];
+    vtkIdType numberOfPoints = 0;
+    if (scalars.Array)
+    {
+      if (scalars.Width < 0 || scalars.Height < 0)
+      {
+        return STATUS_FAILED;
+      }
+      image->SetDimensions(scalars.Width, scalars.Height, 1);
+      image->GetPointData()->SetScalars(scalars.Array);
+      numberOfPoints = static_cast<vtkIdType>(scalars.Width) * scalars.Height;
+    }
+    if (!this->IsComposite())
+    {
+      return scalars.Array ? STATUS_OK : STATUS_FAILED;
+    }
+
+    vtkDataArray* depth = rasters[DEPTH].Array;
+    if (!depth || depth->GetNumberOfValues() != numberOfPoints)
+    {
+      return STATUS_FAILED;
+    }
+    image->GetPointData()->AddArray(depth);
+    if (vtkDataArray* luminance = rasters[LUMINANCE].Array)
+    {
+      if (numberOfPoints == 0 || luminance->GetNumberOfTuples() != numberOfPoints)
+      {
+        return STATUS_FAILED;
+      }
+      image->GetPointData()->AddArray(luminance);
+    }
+    return STATUS_OK;
+  }
+
+  //----------------------------------------------------------------------------
+  // Schedules the rasters of the neighbouring poses and time steps (or phi
+  // and theta for Spec-D stores) of `query` that are not cached yet.
+  void Prefetch(const Descriptor& query)
+  {
+    std::vector<RasterPrefetcher::Job> jobs;
+    if (this->PrefetchEnabled && this->Cache.GetCapacity() > 0)
+    {
+      std::set<std::string> scheduled;
+      for (const char* name : { "pose", "time", "phi", "theta" })
+      {
+        const Json::Value& values = Member(Member(this->Parameters, name), "values");
+        auto iter = query.find(name);
+        const bool byIndex = iter != query.end() && IsInteger(iter->second);
+        const int current = byIndex
+          ? iter->second.asInt()
+          : IndexOf(values,
+              iter != query.end() ? Single(iter->second)
+                                  : Member(Member(this->Parameters, name), "default"));
+        if (!values.isArray() || current < 0)
+        {
+          continue;
+        }
+        for (int neighbor : { current - 1, current + 1 })
+        {
+          if (neighbor < 0 || neighbor >= static_cast<int>(values.size()))
+          {
+            continue;
+          }
+          Descriptor next = query;
+          next[name] = byIndex ? Json::Value(neighbor) : Json::Value(Json::arrayValue);
+          if (!byIndex)
+          {
+            next[name].append(values[neighbor]);
+          }
+          std::vector<LayerRequest> layers;
+          if (this->Plan(next, layers) != STATUS_OK)
+          {
+            continue;
+          }
+          for (const LayerRequest& layer : layers)
+          {
+            for (int role = 0; role < NUMBER_OF_ROLES; ++role)
+            {
+              const std::string key = RasterKey(role, layer[role]);
+              if (!layer[role].FileName.empty() && scheduled.insert(key).second &&
+                !this->Cache.Contains(key))
+              {
+                jobs.push_back(RasterPrefetcher::Job{ role, layer[role] });
+              }
+            }
+          }
+        }
+      }
+    }
+    this->Prefetcher.Schedule(jobs);
+  }
+};
+
+//----------------------------------------------------------------------------
+vtkCinemaDatabaseIndex::vtkCinemaDatabaseIndex()
+  : Internals(new vtkCinemaDatabaseIndex::vtkInternals())
+{
+  this->Internals->Reset();
+}
+
+//----------------------------------------------------------------------------
+vtkCinemaDatabaseIndex::~vtkCinemaDatabaseIndex()
+{
+}
+
+//----------------------------------------------------------------------------
+vtkCinemaDatabaseIndex::LoadStatus vtkCinemaDatabaseIndex::Load(const std::string& fname)
+{
+  auto& internals = *this->Internals;
+  if (internals.IsLoaded() && internals.FileName == fname)
+  {
+    return LOADED;
+  }
+  internals.Reset();
+
+  // like cinema_python's FileStore, a path not ending with info.json is the
+  // directory of the store.
+  std::string path = fname;
+  bool table = EndsWith(path, "data.csv");
+  if (!table && !EndsWith(path, "info.json"))
+  {
+    path = Join(fname, "info.json");
+    if (!vtksys::SystemTools::FileExists(path) &&
+      vtksys::SystemTools::FileExists(Join(fname, "data.csv")))
+    {
+      path = Join(fname, "data.csv");
+      table = true;
+    }
+  }
+  internals.FileName = fname;
+  internals.Directory = vtksys::SystemTools::GetFilenamePath(path);
+  const LoadStatus status = table ? internals.LoadTable(path) : internals.LoadComposite(path);
+  if (status != LOADED)
+  {
+    internals.Reset();
+  }
+  return status;
+}
+
+//----------------------------------------------------------------------------
+bool vtkCinemaDatabaseIndex::IsLoaded() const
+{
+  return this->Internals->IsLoaded();
+}
+
+//----------------------------------------------------------------------------
+const std::string& vtkCinemaDatabaseIndex::GetFileName() const
+{
+  return this->Internals->FileName;
+}
+
+//----------------------------------------------------------------------------
+std::string vtkCinemaDatabaseIndex::GetSpec() const
+{
+  return this->Internals->Spec;
+}
+
+//----------------------------------------------------------------------------
+std::vector<std::string> vtkCinemaDatabaseIndex::GetPipelineObjects() const
+{
+  const auto& internals = *this->Internals;
+  std::vector<std::string> objects;
+  if (!internals.IsComposite())
+  {
+    if (internals.IsLoaded())
+    {
+      objects.push_back("Cinema");
+    }
+    return objects;
+  }
+
+  // upstream objects first.
+  const auto parents = internals.AllParents();
+  std::set<std::string> visited;
+  std::function<void(const std::string&)> add = [&](const std::string& object) {
+    if (!visited.insert(object).second)
+    {
+      return;
+    }
+    auto iter = parents.find(object);
+    if (iter != parents.end())
+    {
+      for (const std::string& parent : iter->second)
+      {
+        add(parent);
+      }
+    }
+    objects.push_back(object);
+  };
+  const Json::Value& values = Member(Member(internals.Parameters, "vis"), "values");
+  for (Json::ArrayIndex cc = 0; values.isArray() && cc < values.size(); ++cc)
+  {
+    add(PythonStr(values[cc]));
+  }
+  return objects;
+}
+
+//----------------------------------------------------------------------------
+std::vector<std::string> vtkCinemaDatabaseIndex::GetPipelineObjectParents(
+  const std::string& objectname) const
+{
+  const auto& internals = *this->Internals;
+  if (!internals.IsComposite())
+  {
+    return internals.IsLoaded() && objectname != "Cinema" ? std::vector<std::string>{ "Cinema" }
+                                                          : std::vector<std::string>();
+  }
+  const auto parents = internals.AllParents();
+  auto iter = parents.find(objectname);
+  return iter != parents.end() ? iter->second : std::vector<std::string>();
+}
+
+//----------------------------------------------------------------------------
+bool vtkCinemaDatabaseIndex::GetPipelineObjectVisibility(const std::string& objectname) const
+{
+  const auto& internals = *this->Internals;
+  if (!internals.IsComposite())
+  {
+    return internals.IsLoaded();
+  }
+  const Json::Value& pipeline = internals.Metadata["pipeline"];
+  for (Json::ArrayIndex cc = 0; pipeline.isArray() && cc < pipeline.size(); ++cc)
+  {
+    if (PythonStr(Member(pipeline[cc], "name")) == objectname)
+    {
+      const Json::Value& visibility = Member(pipeline[cc], "visibility");
+      return visibility.isNumeric() ? visibility.asDouble() == 1
+                                    : visibility.isBool() && visibility.asBool();
+    }
+  }
+  return false;
+}
+
+//----------------------------------------------------------------------------
+std::vector<std::string> vtkCinemaDatabaseIndex::GetControlParameters(
+  const std::string& objectname) const
+{
+  const auto& internals = *this->Internals;
+  if (!internals.IsComposite())
+  {
+    return internals.Columns;
+  }
+  std::string field;
+  std::vector<std::string> controls;
+  internals.ObjectParameters(Json::Value(objectname), field, controls);
+  if (std::find(controls.begin(), controls.end(), objectname) != controls.end())
+  {
+    return std::vector<std::string>{ objectname };
+  }
+  return std::vector<std::string>();
+}
+
+//----------------------------------------------------------------------------
+std::vector<std::string> vtkCinemaDatabaseIndex::GetControlParameterValues(
+  const std::string& parameter) const
+{
+  std::vector<std::string> values;
+  for (const Json::Value& value : this->Internals->SortedValues(parameter))
+  {
+    values.push_back(PythonStr(value));
+  }
+  return values;
+}
+
+//----------------------------------------------------------------------------
+std::vector<double> vtkCinemaDatabaseIndex::GetControlParameterValuesAsDouble(
+  const std::string& parameter) const
+{
+  std::vector<double> values;
+  for (const Json::Value& value : this->Internals->SortedValues(parameter))
+  {
+    if (value.isNumeric())
+    {
+      values.push_back(value.asDouble());
+    }
+  }
+  return values;
+}
+
+//----------------------------------------------------------------------------
+std::string vtkCinemaDatabaseIndex::GetFieldName(const std::string& objectname) const
+{
+  std::string field;
+  std::vector<std::string> controls;
+  if (this->Internals->IsComposite())
+  {
+    this->Internals->ObjectParameters(Json::Value(objectname), field, controls);
+  }
+  return field;
+}
+
+//----------------------------------------------------------------------------
+std::vector<std::string> vtkCinemaDatabaseIndex::GetFieldValues(
+  const std::string& objectname, const std::string& valuetype) const
+{
+  std::vector<std::string> values;
+  const std::string field = this->GetFieldName(objectname);
+  if (field.empty())
+  {
+    return values;
+  }
+  const Json::Value& param = Member(this->Internals->Parameters, field.c_str());
+  const Json::Value& names = Member(param, "values");
+  const Json::Value& types = Member(param, "types");
+  for (Json::ArrayIndex cc = 0;
+       names.isArray() && types.isArray() && cc < names.size() && cc < types.size(); ++cc)
+  {
+    if (PythonStr(types[cc]) == valuetype)
+    {
+      values.push_back(PythonStr(names[cc]));
+    }
+  }
+  return values;
+}
+
+//----------------------------------------------------------------------------
+bool vtkCinemaDatabaseIndex::GetFieldValueRange(
+  const std::string& objectname, const std::string& fieldvalue, double range[2]) const
+{
+  const std::string field = this->GetFieldName(objectname);
+  const Json::Value& ranges =
+    Member(Member(this->Internals->Parameters, field.c_str()), "valueRanges");
+  const Json::Value& valueRange = Member(ranges, fieldvalue.c_str());
+  if (field.empty() || !valueRange.isArray() || valueRange.size() != 2 ||
+    !valueRange[0].isNumeric() || !valueRange[1].isNumeric())
+  {
+    return false;
+  }
+  range[0] = valueRange[0].asDouble();
+  range[1] = valueRange[1].asDouble();
+  return true;
+}
+
+//----------------------------------------------------------------------------
+std::vector<std::string> vtkCinemaDatabaseIndex::GetTimeSteps() const
+{
+  std::vector<std::string> timesteps;
+  const Json::Value& values = Member(Member(this->Internals->Parameters, "time"), "values");
+  for (Json::ArrayIndex cc = 0; this->Internals->IsComposite() && values.isArray() &&
+       cc < values.size();
+       ++cc)
+  {
+    timesteps.push_back(PythonStr(values[cc]));
+  }
+  return timesteps;
+}
+
+//----------------------------------------------------------------------------
+std::vector<vtkSmartPointer<vtkCamera> > vtkCinemaDatabaseIndex::Cameras(
+  const std::string& timestep)
+{
+  auto& internals = *this->Internals;
+  if (!internals.IsComposite())
+  {
+    return std::vector<vtkSmartPointer<vtkCamera> >();
+  }
+  const std::vector<std::string> timesteps = this->GetTimeSteps();
+  const auto ts = std::find(timesteps.begin(), timesteps.end(), timestep);
+  if (ts == timesteps.end() && !timesteps.empty())
+  {
+    vtkGenericWarningMacro("Invalid Cinema time step '" << timestep << "'.");
+    return std::vector<vtkSmartPointer<vtkCamera> >();
+  }
+  const int index = ts == timesteps.end() ? 0 : static_cast<int>(ts - timesteps.begin());
+  auto cached = internals.CameraCache.find(index);
+  if (cached != internals.CameraCache.end())
+  {
+    return cached->second;
+  }
+
+  // the cameras of the poses, as camera_utils.convert_pose_to_camera().
+  const Json::Value& metadata = internals.Metadata;
+  double eye[3], at[3], up[3], nearfar[2], angle;
+  auto get = [&metadata, index](const char* key, int count, double* values) {
+    const Json::Value& item = Member(metadata, key);
+    const Json::Value& value = item.isArray() && index < static_cast<int>(item.size())
+      ? item[index]
+      : None();
+    for (int cc = 0; cc < count; ++cc)
+    {
+      const Json::Value& component = count == 1 ? value : (value.isArray() &&
+                                                              cc < static_cast<int>(value.size())
+                                                            ? value[cc]
+                                                            : None());
+      if (!component.isNumeric())
+      {
+        return false;
+      }
+      values[cc] = component.asDouble();
+    }
+    return true;
+  };
+  const Json::Value& poses = Member(Member(internals.Parameters, "pose"), "values");
+  if (!get("camera_eye", 3, eye) || !get("camera_at", 3, at) || !get("camera_up", 3, up) ||
+    !get("camera_nearfar", 2, nearfar) || !get("camera_angle", 1, &angle) || !poses.isArray())
+  {
+    vtkGenericWarningMacro("Cannot initialize the cameras of the Cinema store.");
+    return std::vector<vtkSmartPointer<vtkCamera> >();
+  }
+
+  double view[3][3];
+  vtkMath::Normalize(up);
+  vtkMath::Subtract(eye, at, view[2]);
+  vtkMath::Normalize(view[2]);
+  vtkMath::Cross(view[2], up, view[0]);
+  std::copy(up, up + 3, view[1]);
+  double viewT[3][3];
+  vtkMath::Transpose3x3(view, viewT);
+  double offset[3];
+  vtkMath::Subtract(eye, at, offset);
+
+  std::vector<vtkSmartPointer<vtkCamera> > cameras;
+  for (Json::ArrayIndex cc = 0; cc < poses.size(); ++cc)
+  {
+    double pose[3][3];
+    for (int row = 0; row < 3; ++row)
+    {
+      for (int col = 0; col < 3; ++col)
+      {
+        const Json::Value& rowValue =
+          poses[cc].isArray() && poses[cc].size() == 3 ? poses[cc][row] : None();
+        const Json::Value& value = rowValue.isArray() && rowValue.size() == 3
+          ? rowValue[col]
+          : None();
+        pose[row][col] = value.asDouble();
+      }
+    }
+    double poseInView[3][3], rotation[3][3];
+    vtkMath::Multiply3x3(viewT, pose, poseInView);
+    vtkMath::Multiply3x3(poseInView, view, rotation);
+    double position[3], viewUp[3];
+    vtkMath::Multiply3x3(rotation, offset, position);
+    vtkMath::Add(position, at, position);
+    vtkMath::Multiply3x3(rotation, up, viewUp);
+
+    vtkNew<vtkCamera> camera;
+    camera->SetPosition(position);
+    camera->SetFocalPoint(at);
+    camera->SetViewUp(viewUp);
+    camera->SetViewAngle(angle);
+    camera->SetClippingRange(nearfar[0], nearfar[1]);
+    cameras.push_back(camera.GetPointer());
+  }
+  internals.CameraCache[index] = cameras;
+  return cameras;
+}
+
+//----------------------------------------------------------------------------
+bool vtkCinemaDatabaseIndex::TranslateQuery(
+  const std::string& query, std::vector<vtkSmartPointer<vtkImageData> >& layers)
+{
+  auto& internals = *this->Internals;
+  layers.clear();
+  if (!internals.IsLoaded())
+  {
+    return true;
+  }
+
+  Descriptor parsed;
+  std::vector<LayerRequest> requests;
+  Status status =
+    QueryParser(query).Parse(parsed) ? internals.Plan(parsed, requests) : STATUS_FAILED;
+  for (size_t cc = 0; status == STATUS_OK && cc < requests.size(); ++cc)
+  {
+    vtkSmartPointer<vtkImageData> image;
+    status = internals.Assemble(requests[cc], image);
+    layers.push_back(image);
+  }
+  if (status != STATUS_OK)
+  {
+    layers.clear();
+    if (internals.IsComposite())
+    {
+      // Python reports the errors of the queries it cannot answer either.
+      return false;
+    }
+    vtkGenericWarningMacro("Failed to translate the Cinema query " << query);
+    return true;
+  }
+  internals.Prefetch(parsed);
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vtkCinemaDatabaseIndex::SetCacheSize(int size)
+{
+  if (size <= 0)
+  {
+    this->Internals->Prefetcher.Cancel();
+  }
+  this->Internals->Cache.SetCapacity(static_cast<size_t>(std::max(size, 0)));
+}
+
+//----------------------------------------------------------------------------
+int vtkCinemaDatabaseIndex::GetCacheSize() const
+{
+  return static_cast<int>(this->Internals->Cache.GetCapacity());
+}
+
+//----------------------------------------------------------------------------
+void vtkCinemaDatabaseIndex::SetPrefetch(bool prefetch)
+{
+  this->Internals->PrefetchEnabled = prefetch;
+  if (!prefetch)
+  {
+    this->Internals->Prefetcher.Cancel();
+  }
+}
+
+//----------------------------------------------------------------------------
+bool vtkCinemaDatabaseIndex::GetPrefetch() const
+{
+  return this->Internals->PrefetchEnabled;
+}
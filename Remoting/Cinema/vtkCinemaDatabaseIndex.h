@@ -0,0 +1,122 @@
+/*=========================================================================
+
+  Program:   Visualization Toolkit
+  Module:    vtkCinemaDatabaseIndex.h
+
+  Copyright (c) Ken Martin, Will Schroeder, Bill Lorensen
+  All rights reserved.
+  See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+/**
+ * @class vtkCinemaDatabaseIndex
+ * @brief C++ index of a Cinema store, used by vtkCinemaDatabase.
+ *
+ * vtkCinemaDatabaseIndex reads the `info.json` of a Spec-C
+ * ('composite-image-stack') store, or the `data.csv` of a Spec-D store, and
+ * answers the queries of vtkCinemaDatabase the way
+ * `cinema_python.adaptors.paraview.cinemareader` does, without Python.
+ * Queries resolve parameter values to file names through the in-memory
+ * parameter tables. Decoded rasters are kept in a least-recently-used cache,
+ * which a background thread fills with the rasters of the neighbouring
+ * camera poses and time steps of the last query.
+ *
+ * Stores or rasters it cannot read (Spec-A stores, older Spec-C file
+ * layouts, magnitude fields, `.npz` rasters) are reported as unsupported, so
+ * that vtkCinemaDatabase falls back to Python for them.
+ */
+
+#ifndef vtkCinemaDatabaseIndex_h
+#define vtkCinemaDatabaseIndex_h
+
+#include "vtkSmartPointer.h" // for vtkSmartPointer
+
+#include <memory> // for std::unique_ptr
+#include <string> // for std::string
+#include <vector> // for std::vector
+
+class vtkCamera;
+class vtkImageData;
+
+class vtkCinemaDatabaseIndex
+{
+public:
+  vtkCinemaDatabaseIndex();
+  ~vtkCinemaDatabaseIndex();
+
+  enum LoadStatus
+  {
+    LOADED,
+    UNSUPPORTED,
+    FAILED
+  };
+
+  /**
+   * Reads the index of the store. `fname` is an `info.json` or `data.csv`
+   * file, or the directory holding one. The store is not read again if it is
+   * already loaded.
+   */
+  LoadStatus Load(const std::string& fname);
+
+  bool IsLoaded() const;
+  const std::string& GetFileName() const;
+
+  /**
+   * "specC" or "specA" (Spec-D stores are parametric image stacks like
+   * Spec-A stores), or an empty string when nothing is loaded.
+   */
+  std::string GetSpec() const;
+
+  std::vector<std::string> GetPipelineObjects() const;
+  std::vector<std::string> GetPipelineObjectParents(const std::string& objectname) const;
+  bool GetPipelineObjectVisibility(const std::string& objectname) const;
+  std::vector<std::string> GetControlParameters(const std::string& objectname) const;
+  std::vector<std::string> GetControlParameterValues(const std::string& parameter) const;
+  std::vector<double> GetControlParameterValuesAsDouble(const std::string& parameter) const;
+  std::string GetFieldName(const std::string& objectname) const;
+  std::vector<std::string> GetFieldValues(
+    const std::string& objectname, const std::string& valuetype) const;
+  bool GetFieldValueRange(
+    const std::string& objectname, const std::string& fieldvalue, double range[2]) const;
+  std::vector<std::string> GetTimeSteps() const;
+  std::vector<vtkSmartPointer<vtkCamera> > Cameras(const std::string& timestep);
+
+  /**
+   * Fills `layers` with the layers for `query`, a Python dictionary literal.
+   * Returns false when the query needs rasters this class cannot decode, in
+   * which case the query should be answered by Python.
+   */
+  bool TranslateQuery(
+    const std::string& query, std::vector<vtkSmartPointer<vtkImageData> >& layers);
+
+  //@{
+  /**
+   * Maximum number of decoded rasters kept in memory.
+   */
+  void SetCacheSize(int size);
+  int GetCacheSize() const;
+  //@}
+
+  //@{
+  /**
+   * Whether the rasters of the neighbouring poses and time steps are decoded
+   * in the background after each query.
+   */
+  void SetPrefetch(bool prefetch);
+  bool GetPrefetch() const;
+  //@}
+
+private:
+  vtkCinemaDatabaseIndex(const vtkCinemaDatabaseIndex&) = delete;
+  void operator=(const vtkCinemaDatabaseIndex&) = delete;
+
+  class vtkInternals;
+  std::unique_ptr<vtkInternals> Internals;
+};
+
+#endif
+// VTK-HeaderTest-Exclude: vtkCinemaDatabaseIndex.h
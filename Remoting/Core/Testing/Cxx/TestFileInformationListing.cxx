@@ -0,0 +1,231 @@
+/*=========================================================================
+
+  Program:   ParaView
+  Module:    TestFileInformationListing.cxx
+
+  Copyright (c) Kitware, Inc.
+  All rights reserved.
+  See Copyright.txt or http://www.paraview.org/HTML/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// Checks that a directory listing delivered in pages groups the files like a
+// listing read at once, and that the cached listing of a directory is reused
+// until the directory changes.
+#include "vtkClientServerStream.h"
+#include "vtkCollection.h"
+#include "vtkLogger.h"
+#include "vtkNew.h"
+#include "vtkPVFileInformation.h"
+#include "vtkPVFileInformationHelper.h"
+#include "vtkPVLogger.h"
+#include "vtkTestUtilities.h"
+
+#include <vtksys/SystemTools.hxx>
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <time.h>
+
+namespace
+{
+const int NumberOfSequenceFiles = 500;
+
+// Describes the contents of a listing as "<type>:<name>:<number of children>"
+// sorted by name, to compare listings independently of their order.
+std::string Describe(vtkPVFileInformation* info)
+{
+  std::set<std::string> items;
+  vtkCollection* contents = info->GetContents();
+  for (int cc = 0; cc < contents->GetNumberOfItems(); cc++)
+  {
+    vtkPVFileInformation* item = vtkPVFileInformation::SafeDownCast(contents->GetItemAsObject(cc));
+    std::ostringstream str;
+    str << item->GetType() << ":" << item->GetName() << ":"
+        << item->GetContents()->GetNumberOfItems();
+    items.insert(str.str());
+  }
+  std::string description;
+  for (const std::string& item : items)
+  {
+    description += item + " ";
+  }
+  return description;
+}
+
+bool HasItem(vtkPVFileInformation* info, const char* name)
+{
+  vtkCollection* contents = info->GetContents();
+  for (int cc = 0; cc < contents->GetNumberOfItems(); cc++)
+  {
+    vtkPVFileInformation* item = vtkPVFileInformation::SafeDownCast(contents->GetItemAsObject(cc));
+    if (strcmp(item->GetName(), name) == 0)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Counts the listings served from the cache.
+void CountReuse(void* userData, const vtkLogger::Message& message)
+{
+  if (strstr(message.message, "reusing the listing of") != nullptr)
+  {
+    ++*static_cast<int*>(userData);
+  }
+}
+}
+
+int TestFileInformationListing(int argc, char* argv[])
+{
+  char* tempDir =
+    vtkTestUtilities::GetArgOrEnvOrDefault("-T", argc, argv, "VTK_TEMP_DIR", "Testing/Temporary");
+  if (!tempDir)
+  {
+    cerr << "Could not determine temporary directory.\n";
+    return EXIT_FAILURE;
+  }
+  const std::string dir = vtksys::SystemTools::CollapseFullPath(
+    std::string(tempDir) + "/TestFileInformationListing");
+  delete[] tempDir;
+
+  vtksys::SystemTools::RemoveADirectory(dir);
+  if (!vtksys::SystemTools::MakeDirectory(dir + "/subdir"))
+  {
+    cerr << "ERROR: cannot create " << dir << endl;
+    return EXIT_FAILURE;
+  }
+  for (int cc = 0; cc < NumberOfSequenceFiles; cc++)
+  {
+    std::ofstream(dir + "/sequence_" + std::to_string(cc) + ".vtk") << cc;
+  }
+  std::ofstream(dir + "/single.txt") << "single";
+  std::ofstream(dir + "/.hidden") << "hidden";
+
+  // a listing read during the second the directory was last changed is not
+  // reused. The change time of the directory cannot be set back, so wait for
+  // the next second.
+  vtksys::SystemTools::Stat_t status;
+  if (vtksys::SystemTools::Stat(dir, &status) == -1)
+  {
+    cerr << "ERROR: cannot stat " << dir << endl;
+    return EXIT_FAILURE;
+  }
+  while (time(nullptr) <= status.st_ctime)
+  {
+    vtksys::SystemTools::Delay(50);
+  }
+
+  vtkNew<vtkPVFileInformationHelper> helper;
+  helper->SetPath(dir.c_str());
+  helper->DirectoryListingOn();
+
+  // the whole listing at once.
+  vtkNew<vtkPVFileInformation> listing;
+  listing->CopyFromObject(helper);
+  if (!listing->GetDirectoryListingComplete())
+  {
+    cerr << "ERROR: unpaged listing is not complete." << endl;
+    return EXIT_FAILURE;
+  }
+  if (listing->GetContents()->GetNumberOfItems() != 4)
+  {
+    cerr << "ERROR: unexpected listing: " << Describe(listing) << endl;
+    return EXIT_FAILURE;
+  }
+  const std::string expected = Describe(listing);
+  std::ostringstream group;
+  group << vtkPVFileInformation::FILE_GROUP << ":";
+  if (expected.find(group.str()) == std::string::npos ||
+    expected.find(":" + std::to_string(NumberOfSequenceFiles) + " ") == std::string::npos)
+  {
+    cerr << "ERROR: sequence not grouped: " << expected << endl;
+    return EXIT_FAILURE;
+  }
+
+  // the directory did not change: the cached listing is reused.
+  int numberOfReuses = 0;
+  vtkLogger::AddCallback("TestFileInformationListing", CountReuse, &numberOfReuses,
+    vtkPVLogger::GetApplicationVerbosity());
+  listing->CopyFromObject(helper);
+  vtkLogger::RemoveCallback("TestFileInformationListing");
+  if (numberOfReuses != 1)
+  {
+    cerr << "ERROR: cached listing was not reused." << endl;
+    return EXIT_FAILURE;
+  }
+  if (Describe(listing) != expected)
+  {
+    cerr << "ERROR: listing changed: " << Describe(listing) << endl;
+    return EXIT_FAILURE;
+  }
+
+  // the same listing in pages, sent through streams.
+  helper->SetDirectoryListingPageSize(37);
+  vtkNew<vtkPVFileInformation> paged;
+  int numberOfPages = 0;
+  for (bool complete = false; !complete; numberOfPages++)
+  {
+    vtkNew<vtkPVFileInformation> page;
+    page->CopyFromObject(helper);
+    vtkClientServerStream stream;
+    page->CopyToStream(&stream);
+    vtkNew<vtkPVFileInformation> received;
+    received->CopyFromStream(&stream);
+    if (received->GetContents()->GetNumberOfItems() <= 0 &&
+      !received->GetDirectoryListingComplete())
+    {
+      cerr << "ERROR: empty page " << numberOfPages << endl;
+      return EXIT_FAILURE;
+    }
+    if (numberOfPages == 0)
+    {
+      paged->CopyFromStream(&stream);
+    }
+    else
+    {
+      paged->AddDirectoryListingPage(received);
+    }
+    complete = received->GetDirectoryListingComplete();
+    helper->SetDirectoryListingPageStart(received->GetDirectoryListingNextPageStart());
+  }
+  if (numberOfPages <= 1)
+  {
+    cerr << "ERROR: listing was not paged." << endl;
+    return EXIT_FAILURE;
+  }
+  if (Describe(paged) != expected)
+  {
+    cerr << "ERROR: paged listing differs: " << Describe(paged) << endl;
+    return EXIT_FAILURE;
+  }
+  helper->SetDirectoryListingPageSize(0);
+  helper->SetDirectoryListingPageStart(0);
+
+  // a new file shows in the next listing.
+  std::ofstream(dir + "/added.txt") << "added";
+  listing->CopyFromObject(helper);
+  if (!HasItem(listing, "added.txt"))
+  {
+    cerr << "ERROR: new file not listed: " << Describe(listing) << endl;
+    return EXIT_FAILURE;
+  }
+  vtksys::SystemTools::RemoveFile(dir + "/single.txt");
+  listing->CopyFromObject(helper);
+  if (HasItem(listing, "single.txt"))
+  {
+    cerr << "ERROR: removed file listed: " << Describe(listing) << endl;
+    return EXIT_FAILURE;
+  }
+
+  vtksys::SystemTools::RemoveADirectory(dir);
+  return EXIT_SUCCESS;
+}
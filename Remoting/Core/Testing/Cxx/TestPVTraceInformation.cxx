@@ -0,0 +1,168 @@
+/*=========================================================================
+
+  Program:   ParaView
+  Module:    TestPVTraceInformation.cxx
+
+  Copyright (c) Kitware, Inc.
+  All rights reserved.
+  See Copyright.txt or http://www.paraview.org/HTML/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+#include "vtkClientServerStream.h"
+#include "vtkNew.h"
+#include "vtkPVTraceInformation.h"
+#include "vtkPVTraceRecorder.h"
+
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+void Work(int iterations)
+{
+  for (int cc = 0; cc < iterations; ++cc)
+  {
+    vtkPVTraceScope scope(vtkPVTraceRecorder::PIPELINE, "work");
+    if (vtkPVTraceRecorder::IsEnabled())
+    {
+      const std::string name("dynamic \"name\"");
+      vtkPVTraceRecorder::Record(vtkPVTraceRecorder::OTHER, vtkPVTraceRecorder::BEGIN, name);
+      vtkPVTraceRecorder::Record(vtkPVTraceRecorder::OTHER, vtkPVTraceRecorder::END, name);
+    }
+  }
+}
+}
+
+int TestPVTraceInformation(int, char* [])
+{
+  vtkNew<vtkPVTraceRecorder> recorder;
+
+  // nothing is recorded while disabled.
+  Work(10);
+  vtkNew<vtkPVTraceInformation> info;
+  info->CopyFromObject(nullptr);
+  if (info->GetNumberOfProcesses() != 1)
+  {
+    cerr << "ERROR: expected a single process." << endl;
+    return EXIT_FAILURE;
+  }
+  if (info->GetNumberOfEvents(0) != 0)
+  {
+    cerr << "ERROR: events recorded while disabled." << endl;
+    return EXIT_FAILURE;
+  }
+
+  // record on a few threads.
+  recorder->SetEnabled(1);
+  std::vector<std::thread> threads;
+  for (int cc = 0; cc < 4; ++cc)
+  {
+    threads.emplace_back(Work, 100);
+  }
+  for (auto& thread : threads)
+  {
+    thread.join();
+  }
+  recorder->SetEnabled(0);
+
+  info->CopyFromObject(nullptr);
+  if (info->GetNumberOfEvents(0) != 4 * 100 * 4)
+  {
+    cerr << "ERROR: unexpected number of events: " << info->GetNumberOfEvents(0) << endl;
+    return EXIT_FAILURE;
+  }
+
+  // round trip through a stream, as done when gathering from the server.
+  vtkClientServerStream stream;
+  info->CopyToStream(&stream);
+  vtkNew<vtkPVTraceInformation> received;
+  received->CopyFromStream(&stream);
+  if (received->GetNumberOfProcesses() != 1 ||
+    received->GetNumberOfEvents(0) != info->GetNumberOfEvents(0))
+  {
+    cerr << "ERROR: stream round trip failed." << endl;
+    return EXIT_FAILURE;
+  }
+
+  // merging, as done when reducing from satellites.
+  received->AddInformation(info);
+  if (received->GetNumberOfProcesses() != 2)
+  {
+    cerr << "ERROR: AddInformation failed." << endl;
+    return EXIT_FAILURE;
+  }
+
+  std::ostringstream json;
+  if (!info->WriteChromeTrace(json))
+  {
+    cerr << "ERROR: failed to write trace." << endl;
+    return EXIT_FAILURE;
+  }
+  const std::string str = json.str();
+  if (str.find("\"traceEvents\"") == std::string::npos)
+  {
+    cerr << "ERROR: missing traceEvents." << endl;
+    return EXIT_FAILURE;
+  }
+  if (str.find("\"name\":\"work\",\"cat\":\"pipeline\",\"ph\":\"B\"") == std::string::npos)
+  {
+    cerr << "ERROR: missing begin event." << endl;
+    return EXIT_FAILURE;
+  }
+  if (str.find("dynamic \\\"name\\\"") == std::string::npos)
+  {
+    cerr << "ERROR: names are not escaped." << endl;
+    return EXIT_FAILURE;
+  }
+
+  // dropping events once the buffer is full.
+  recorder->ResetLog();
+  recorder->SetMaxEventsPerThread(10);
+  recorder->SetEnabled(1);
+  Work(10);
+  recorder->SetEnabled(0);
+  info->CopyFromObject(nullptr);
+  if (info->GetNumberOfEvents(0) != 10)
+  {
+    cerr << "ERROR: MaxEventsPerThread not honored." << endl;
+    return EXIT_FAILURE;
+  }
+  if (info->GetNumberOfDroppedEvents() != 30)
+  {
+    cerr << "ERROR: dropped events not counted." << endl;
+    return EXIT_FAILURE;
+  }
+
+  // threads recording one after the other reuse the same buffer, but keep
+  // their own ids and events.
+  recorder->ResetLog();
+  recorder->SetMaxEventsPerThread(1000);
+  recorder->SetEnabled(1);
+  for (int cc = 0; cc < 8; ++cc)
+  {
+    std::thread(Work, 1).join();
+  }
+  recorder->SetEnabled(0);
+  std::vector<vtkPVTraceRecorder::Event> events;
+  std::vector<std::string> names;
+  vtkPVTraceRecorder::GetEvents(events, names);
+  std::set<vtkTypeUInt32> threadIds;
+  for (const auto& event : events)
+  {
+    threadIds.insert(event.Thread);
+  }
+  if (events.size() != 8 * 4 || threadIds.size() != 8)
+  {
+    cerr << "ERROR: " << events.size() << " events on " << threadIds.size()
+         << " threads from threads recording in turn." << endl;
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -22,6 +22,7 @@
 #include "vtkNew.h"
 #include "vtkObjectFactory.h"
 #include "vtkPVFileInformationHelper.h"
+#include "vtkPVLogger.h"
 #include "vtkProcessModule.h"
 #include "vtkResourceFileLocator.h"
 #include "vtkSmartPointer.h"
@@ -50,9 +51,18 @@
 #endif
 
 #include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <set>
 #include <string>
+#include <thread>
 #include <time.h>
+#include <vector>
 #include <vtksys/RegularExpression.hxx>
 #include <vtksys/SystemTools.hxx>
 
@@ -362,6 +372,10 @@ vtkPVFileInformation::vtkPVFileInformation()
   this->FullPath = NULL;
   this->FastFileTypeDetection = 0;
   this->ReadDetailedFileInformation = false;
+  this->DirectoryListingPageSize = 0;
+  this->DirectoryListingPageStart = 0;
+  this->DirectoryListingComplete = true;
+  this->DirectoryListingNextPageStart = 0;
   this->Hidden = false;
   this->Extension = NULL;
   this->Size = 0;
@@ -414,6 +428,8 @@ void vtkPVFileInformation::CopyFromObject(vtkObject* object)
 
   this->FastFileTypeDetection = helper->GetFastFileTypeDetection();
   this->ReadDetailedFileInformation = helper->GetReadDetailedFileInformation();
+  this->DirectoryListingPageSize = helper->GetDirectoryListingPageSize();
+  this->DirectoryListingPageStart = helper->GetDirectoryListingPageStart();
 
   std::string working_directory = vtksys::SystemTools::GetCurrentWorkingDirectory().c_str();
   if (helper->GetWorkingDirectory() && helper->GetWorkingDirectory()[0])
@@ -830,86 +846,312 @@ support and glibc/Linux system headers:
 #define dirent dirent64
 #endif
 
+#if !defined(_WIN32)
+namespace
+{
 //-----------------------------------------------------------------------------
-void vtkPVFileInformation::GetDirectoryListing()
+// An entry of a directory, as returned by readdir.
+struct vtkPVFileListingEntry
 {
-#if defined(_WIN32)
+  std::string Name;
+  int Type = vtkPVFileInformation::INVALID; // INVALID when readdir could not tell.
+  bool HasStatus = false;                    // Set when the detailed information was read.
+  std::string Extension;
+  long long Size = 0;
+  time_t ModificationTime = 0;
+};
 
-  vtkErrorMacro("GetDirectoryListing() cannot be called on Windows systems.");
-  return;
+//-----------------------------------------------------------------------------
+// The entries of a directory. The entries are appended while the directory is
+// read, possibly by a background thread, and never change once read.
+class vtkPVFileListing
+{
+public:
+  vtkPVFileListing(const std::string& path, bool detailed,
+    const vtksys::SystemTools::Stat_t& status, time_t scanStartTime)
+    : Path(path)
+    , Detailed(detailed)
+    , DirectoryMTime(status.st_mtime)
+    , DirectoryCTime(status.st_ctime)
+    , DirectoryInode(status.st_ino)
+    , ScanStartTime(scanStartTime)
+  {
+  }
 
-#else
+  // Stops the background thread, if any, e.g. when the listing is dropped from
+  // the cache before the directory has been read.
+  ~vtkPVFileListing()
+  {
+    this->Cancelled = true;
+    if (this->ScanThread.joinable())
+    {
+      this->ScanThread.join();
+    }
+  }
 
-  vtkPVFileInformationSet info_set;
-  std::string prefix = this->FullPath;
-  vtkPVFileInformationAddTerminatingSlash(prefix);
+  const std::string Path;
+  const bool Detailed;
 
-  // Open the directory and make sure it exists.
-  DIR* dir = opendir(this->FullPath);
-  if (!dir)
+  // Returns whether this listing still describes the directory with the given
+  // status. Detailed listings are never reused, since the size and time of a
+  // file change without the directory being modified. A listing read during
+  // the second the directory was last modified is not reused either, since a
+  // later change during the same second would not show in its time stamps.
+  bool IsValid(const vtksys::SystemTools::Stat_t& status) const
   {
-    // Could add check of errno here.
-    return;
+    return !this->Detailed && status.st_mtime == this->DirectoryMTime &&
+      status.st_ctime == this->DirectoryCTime && status.st_ino == this->DirectoryInode &&
+      this->DirectoryMTime < this->ScanStartTime && this->DirectoryCTime < this->ScanStartTime;
   }
 
-  // Loop through the directory listing.
-  while (const dirent* d = readdir(dir))
+  // Reads the directory on a background thread, which is joined when the
+  // listing is destroyed.
+  void StartScan() { this->ScanThread = std::thread([this]() { this->Scan(); }); }
+
+  // Reads the directory. The entries are made available in batches, so that
+  // the first pages can be delivered before the directory has been read.
+  void Scan()
   {
-    // Skip the special directory entries.
-    if (strcmp(d->d_name, ".") == 0 || strcmp(d->d_name, "..") == 0)
-    {
-      continue;
-    }
-    vtkPVFileInformation* info = vtkPVFileInformation::New();
-    info->SetName(d->d_name);
-    info->SetFullPath((prefix + d->d_name).c_str());
-    info->Type = INVALID;
-    info->SetHiddenFlag();
+    std::string prefix = this->Path;
+    vtkPVFileInformationAddTerminatingSlash(prefix);
 
-    vtksys::SystemTools::Stat_t status;
-    int res;
-    if (this->ReadDetailedFileInformation)
+    std::vector<vtkPVFileListingEntry> batch;
+    DIR* dir = opendir(this->Path.c_str());
+    while (const dirent* d = (dir && !this->Cancelled) ? readdir(dir) : nullptr)
     {
-      // Recover status info
-      res = vtksys::SystemTools::Stat(info->FullPath, &status);
-      if (res != -1)
+      // Skip the special directory entries.
+      if (strcmp(d->d_name, ".") == 0 || strcmp(d->d_name, "..") == 0)
+      {
+        continue;
+      }
+      vtkPVFileListingEntry entry;
+      entry.Name = d->d_name;
+
+      vtksys::SystemTools::Stat_t status;
+      int res = -1;
+      if (this->Detailed)
       {
-        if (!S_ISDIR(status.st_mode))
+        // Recover status info
+        res = vtksys::SystemTools::Stat(prefix + entry.Name, &status);
+        if (res != -1)
         {
-          std::string::size_type pos = std::string(d->d_name).rfind('.');
-          if (pos != std::string::npos)
+          if (!S_ISDIR(status.st_mode))
           {
-            std::string ext = std::string(d->d_name).substr(pos + 1);
-            info->SetExtension(ext.c_str());
+            std::string::size_type pos = entry.Name.rfind('.');
+            if (pos != std::string::npos)
+            {
+              entry.Extension = entry.Name.substr(pos + 1);
+            }
           }
+          entry.HasStatus = true;
+          entry.Size = status.st_size;
+          entry.ModificationTime = status.st_mtime;
+          entry.Type = S_ISDIR(status.st_mode) ? vtkPVFileInformation::DIRECTORY
+                                               : vtkPVFileInformation::SINGLE_FILE;
         }
-        info->Size = status.st_size;
-        info->ModificationTime = status.st_mtime;
       }
-    }
 // fix to bug #09452 such that directories with trailing names can be
 // shown in the file dialog
 #if defined(__SVR4) && defined(__sun)
-    if (!this->ReadDetailedFileInformation)
+      if (!this->Detailed)
+      {
+        res = vtksys::SystemTools::Stat(prefix + entry.Name, &status);
+      }
+      if (res != -1 && status.st_mode & S_IFDIR)
+      {
+        entry.Type = vtkPVFileInformation::DIRECTORY;
+      }
+#else
+      // The type stored in the entry saves a stat per file. Links and file
+      // systems that do not fill d_type are left to DetectType().
+      if (res == -1 && d->d_type == DT_DIR)
+      {
+        entry.Type = vtkPVFileInformation::DIRECTORY;
+      }
+      else if (res == -1 && d->d_type == DT_REG)
+      {
+        entry.Type = vtkPVFileInformation::SINGLE_FILE;
+      }
+#endif
+      batch.push_back(std::move(entry));
+      if (batch.size() == 256)
+      {
+        this->Append(batch, false);
+      }
+    }
+    if (dir)
     {
-      res = vtksys::SystemTools::Stat(info->FullPath, &status);
+      closedir(dir);
     }
-    if (res != -1 && status.st_mode & S_IFDIR)
+    this->Append(batch, true);
+  }
+
+  // Waits until the entries [start, start + count) have been read, or the
+  // whole directory, and copies them to `entries`. Returns true if there are
+  // no entries after these.
+  bool GetEntries(size_t start, size_t count, std::vector<vtkPVFileListingEntry>& entries)
+  {
+    std::unique_lock<std::mutex> lock(this->Mutex);
+    const size_t end = count > std::numeric_limits<size_t>::max() - start
+      ? std::numeric_limits<size_t>::max()
+      : start + count;
+    this->EntriesRead.wait(
+      lock, [this, end]() { return this->Complete || this->Entries.size() >= end; });
+    const size_t first = std::min(start, this->Entries.size());
+    const size_t last = std::min(end, this->Entries.size());
+    entries.assign(this->Entries.begin() + first, this->Entries.begin() + last);
+    return this->Complete && last == this->Entries.size();
+  }
+
+private:
+  void Append(std::vector<vtkPVFileListingEntry>& batch, bool complete)
+  {
     {
-      info->Type = DIRECTORY;
+      std::lock_guard<std::mutex> lock(this->Mutex);
+      std::move(batch.begin(), batch.end(), std::back_inserter(this->Entries));
+      this->Complete = complete;
     }
-#else
-    if (d->d_type & DT_DIR)
+    batch.clear();
+    this->EntriesRead.notify_all();
+  }
+
+  const time_t DirectoryMTime;
+  const time_t DirectoryCTime;
+  const ino_t DirectoryInode;
+  const time_t ScanStartTime;
+
+  std::mutex Mutex;
+  std::condition_variable EntriesRead;
+  std::vector<vtkPVFileListingEntry> Entries;
+  bool Complete = false;
+  std::atomic<bool> Cancelled{ false };
+  std::thread ScanThread;
+};
+
+//-----------------------------------------------------------------------------
+// Listings of the most recently visited directories, so that navigating back
+// and forth in the file dialog does not read the same directories again.
+class vtkPVFileListingCache
+{
+public:
+  // Returns the listing of the directory `path`. A cached listing is returned
+  // if it is still valid or if `continuation` is set, i.e. when the following
+  // pages of a listing are requested. Otherwise the directory is read again,
+  // on a background thread when `background` is set.
+  static std::shared_ptr<vtkPVFileListing> GetListing(
+    const std::string& path, bool detailed, bool continuation, bool background)
+  {
+    // time the scan starts, taken before the directory status is read.
+    const time_t now = time(nullptr);
+    vtksys::SystemTools::Stat_t status;
+    if (vtksys::SystemTools::Stat(path, &status) == -1)
     {
-      info->Type = DIRECTORY;
+      return nullptr;
     }
+
+    static vtkPVFileListingCache cache;
+    std::shared_ptr<vtkPVFileListing> listing;
+    {
+      std::lock_guard<std::mutex> lock(cache.Mutex);
+      const std::string key = (detailed ? "d:" : "n:") + path;
+      auto iter = cache.Listings.find(key);
+      if (iter != cache.Listings.end() && (continuation || iter->second.first->IsValid(status)))
+      {
+        if (!continuation)
+        {
+          vtkVLogF(PARAVIEW_LOG_APPLICATION_VERBOSITY(), "reusing the listing of '%s'",
+            path.c_str());
+        }
+        iter->second.second = ++cache.Clock;
+        return iter->second.first;
+      }
+
+      listing = std::make_shared<vtkPVFileListing>(path, detailed, status, now);
+      cache.Listings[key] = std::make_pair(listing, ++cache.Clock);
+      if (cache.Listings.size() > MaximumNumberOfListings)
+      {
+        auto oldest = std::min_element(cache.Listings.begin(), cache.Listings.end(),
+          [](const ListingsType::value_type& a, const ListingsType::value_type& b) {
+            return a.second.second < b.second.second;
+          });
+        cache.Listings.erase(oldest);
+      }
+    }
+
+    if (background)
+    {
+      listing->StartScan();
+    }
+    else
+    {
+      listing->Scan();
+    }
+    return listing;
+  }
+
+private:
+  static const size_t MaximumNumberOfListings = 16;
+
+  // listings with the time they were last requested.
+  typedef std::map<std::string, std::pair<std::shared_ptr<vtkPVFileListing>, unsigned long> >
+    ListingsType;
+  ListingsType Listings;
+  unsigned long Clock = 0;
+  std::mutex Mutex;
+};
+}
 #endif
 
+//-----------------------------------------------------------------------------
+void vtkPVFileInformation::GetDirectoryListing()
+{
+#if defined(_WIN32)
+
+  vtkErrorMacro("GetDirectoryListing() cannot be called on Windows systems.");
+  return;
+
+#else
+
+  vtkPVFileInformationSet info_set;
+  std::string prefix = this->FullPath;
+  vtkPVFileInformationAddTerminatingSlash(prefix);
+
+  // Get the entries of the directory, or of the requested page, from the
+  // listing cache.
+  const bool paged = this->DirectoryListingPageSize > 0;
+  const size_t start = paged ? static_cast<size_t>(this->DirectoryListingPageStart) : 0;
+  const size_t count = paged ? static_cast<size_t>(this->DirectoryListingPageSize)
+                             : std::numeric_limits<size_t>::max();
+  std::shared_ptr<vtkPVFileListing> listing = vtkPVFileListingCache::GetListing(
+    this->FullPath, this->ReadDetailedFileInformation, start > 0, paged);
+  if (!listing)
+  {
+    return;
+  }
+  std::vector<vtkPVFileListingEntry> entries;
+  this->DirectoryListingComplete = listing->GetEntries(start, count, entries);
+  this->DirectoryListingNextPageStart = static_cast<int>(start + entries.size());
+
+  for (const vtkPVFileListingEntry& entry : entries)
+  {
+    vtkPVFileInformation* info = vtkPVFileInformation::New();
+    info->SetName(entry.Name.c_str());
+    info->SetFullPath((prefix + entry.Name).c_str());
+    info->Type = entry.Type;
+    info->SetHiddenFlag();
+    if (entry.HasStatus)
+    {
+      if (!entry.Extension.empty())
+      {
+        info->SetExtension(entry.Extension.c_str());
+      }
+      info->Size = entry.Size;
+      info->ModificationTime = entry.ModificationTime;
+    }
     info->FastFileTypeDetection = this->FastFileTypeDetection;
     info_set.insert(info);
     info->Delete();
   }
-  closedir(dir);
 
   this->OrganizeCollection(info_set);
 
@@ -940,6 +1182,44 @@ void vtkPVFileInformation::GetDirectoryListing()
 #endif
 }
 
+//-----------------------------------------------------------------------------
+void vtkPVFileInformation::AddDirectoryListingPage(vtkPVFileInformation* page)
+{
+  // Dissolve the groups of both listings and group their files again, since
+  // the files of a sequence may have been read in different pages.
+  vtkPVFileInformationSet info_set;
+  vtkCollection* listings[2] = { this->Contents, page->Contents };
+  for (vtkCollection* contents : listings)
+  {
+    vtkSmartPointer<vtkCollectionIterator> iter;
+    iter.TakeReference(contents->NewIterator());
+    for (iter->InitTraversal(); !iter->IsDoneWithTraversal(); iter->GoToNextItem())
+    {
+      vtkPVFileInformation* obj = vtkPVFileInformation::SafeDownCast(iter->GetCurrentObject());
+      if (obj->Type == FILE_GROUP || obj->Type == DIRECTORY_GROUP)
+      {
+        for (int cc = 0; cc < obj->Contents->GetNumberOfItems(); cc++)
+        {
+          info_set.insert(vtkPVFileInformation::SafeDownCast(obj->Contents->GetItemAsObject(cc)));
+        }
+      }
+      else
+      {
+        info_set.insert(obj);
+      }
+    }
+  }
+
+  this->Contents->RemoveAllItems();
+  this->OrganizeCollection(info_set);
+  for (vtkPVFileInformationSet::iterator iter = info_set.begin(); iter != info_set.end(); ++iter)
+  {
+    this->Contents->AddItem(*iter);
+  }
+  this->DirectoryListingComplete = page->DirectoryListingComplete;
+  this->DirectoryListingNextPageStart = page->DirectoryListingNextPageStart;
+}
+
 //-----------------------------------------------------------------------------
 void vtkPVFileInformation::SetHiddenFlag()
 {
@@ -1099,7 +1379,8 @@ void vtkPVFileInformation::CopyToStream(vtkClientServerStream* stream)
 {
   *stream << vtkClientServerStream::Reply << this->Name << this->FullPath << this->Type
           << this->Hidden << this->Contents->GetNumberOfItems() << this->Extension << this->Size
-          << this->ModificationTime;
+          << this->ModificationTime << this->DirectoryListingComplete
+          << this->DirectoryListingNextPageStart;
 
   vtkSmartPointer<vtkCollectionIterator> iter;
   iter.TakeReference(this->Contents->NewIterator());
@@ -1166,11 +1447,21 @@ void vtkPVFileInformation::CopyFromStream(const vtkClientServerStream* css)
     vtkErrorMacro("Error parsing File extension.");
     return;
   }
+  if (!css->GetArgument(0, 8, &this->DirectoryListingComplete))
+  {
+    vtkErrorMacro("Error parsing DirectoryListingComplete.");
+    return;
+  }
+  if (!css->GetArgument(0, 9, &this->DirectoryListingNextPageStart))
+  {
+    vtkErrorMacro("Error parsing DirectoryListingNextPageStart.");
+    return;
+  }
   for (int cc = 0; cc < num_of_children; cc++)
   {
     vtkPVFileInformation* child = vtkPVFileInformation::New();
     vtkClientServerStream childStream;
-    if (!css->GetArgument(0, 8 + cc, &childStream))
+    if (!css->GetArgument(0, 10 + cc, &childStream))
     {
       vtkErrorMacro("Error parsing child #" << cc);
       return;
@@ -1196,6 +1487,8 @@ void vtkPVFileInformation::Initialize()
 #else
   this->ModificationTime = time(NULL);
 #endif
+  this->DirectoryListingComplete = true;
+  this->DirectoryListingNextPageStart = 0;
 }
 
 //-----------------------------------------------------------------------------
@@ -129,6 +129,25 @@ public:
   vtkGetMacro(ModificationTime, time_t);
   //@}
 
+  //@{
+  /**
+   * When the listing was requested in pages (see
+   * vtkPVFileInformationHelper::SetDirectoryListingPageSize), returns whether
+   * this page was the last one and where the next page starts. Unpaged
+   * listings are always complete.
+   */
+  vtkGetMacro(DirectoryListingComplete, bool);
+  vtkGetMacro(DirectoryListingNextPageStart, int);
+  //@}
+
+  /**
+   * Adds the contents of the next page of a paged directory listing to the
+   * contents of this one. Files of a sequence may be spread over several
+   * pages: the contents are grouped again so that each FILE_GROUP and
+   * DIRECTORY_GROUP holds all the files of its sequence read so far.
+   */
+  void AddDirectoryListingPage(vtkPVFileInformation* page);
+
   /**
   * Returns the path to the base data directory path holding various files
   * packaged with ParaView.
@@ -176,6 +195,10 @@ protected:
   void SetHiddenFlag();
   int FastFileTypeDetection;
   bool ReadDetailedFileInformation;
+  int DirectoryListingPageSize;
+  int DirectoryListingPageStart;
+  bool DirectoryListingComplete;
+  int DirectoryListingNextPageStart;
 
 private:
   vtkPVFileInformation(const vtkPVFileInformation&) = delete;
@@ -139,6 +139,29 @@ public:
   vtkSetMacro(ReadDetailedFileInformation, bool);
   //@}
 
+  //@{
+  /**
+   * When positive, a directory listing is delivered in pages of at most this
+   * many directory entries. The directory is then read on a background thread
+   * and each request returns as soon as its page has been read, so that the
+   * first files can be shown before the whole directory has been scanned.
+   * Use vtkPVFileInformation::GetDirectoryListingComplete() and
+   * vtkPVFileInformation::GetDirectoryListingNextPageStart() to request the
+   * following pages. Defaults to 0 i.e. the whole listing is returned at once.
+   */
+  vtkGetMacro(DirectoryListingPageSize, int);
+  vtkSetClampMacro(DirectoryListingPageSize, int, 0, VTK_INT_MAX);
+  //@}
+
+  //@{
+  /**
+   * Index of the first directory entry of the requested page. Ignored unless
+   * DirectoryListingPageSize is positive. Defaults to 0.
+   */
+  vtkGetMacro(DirectoryListingPageStart, int);
+  vtkSetClampMacro(DirectoryListingPageStart, int, 0, VTK_INT_MAX);
+  //@}
+
 protected:
   vtkPVFileInformationHelper();
   ~vtkPVFileInformationHelper() override;
@@ -150,6 +173,8 @@ protected:
   int FastFileTypeDetection;
 
   bool ReadDetailedFileInformation;
+  int DirectoryListingPageSize;
+  int DirectoryListingPageStart;
   char* PathSeparator;
   vtkSetStringMacro(PathSeparator);
 
@@ -0,0 +1,331 @@
+/*=========================================================================
+
+  Program:   ParaView
+  Module:    vtkPVTraceInformation.cxx
+
+  Copyright (c) Kitware, Inc.
+  All rights reserved.
+  See Copyright.txt or http://www.paraview.org/HTML/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+#include "vtkPVTraceInformation.h"
+
+#include "vtkClientServerStream.h"
+#include "vtkMultiProcessController.h"
+#include "vtkObjectFactory.h"
+#include "vtkPVTraceRecorder.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace
+{
+const char* CategoryNames[] = { "pipeline", "rmi", "compositing", "data-delivery", "rendering",
+  "other" };
+
+std::string EscapeJSON(const std::string& str)
+{
+  std::string result;
+  result.reserve(str.size());
+  for (const char c : str)
+  {
+    switch (c)
+    {
+      case '"':
+        result += "\\\"";
+        break;
+      case '\\':
+        result += "\\\\";
+        break;
+      case '\n':
+        result += "\\n";
+        break;
+      case '\t':
+        result += "\\t";
+        break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20)
+        {
+          result += ' ';
+        }
+        else
+        {
+          result += c;
+        }
+    }
+  }
+  return result;
+}
+}
+
+class vtkPVTraceInformation::vtkInternals
+{
+public:
+  struct ProcessEvents
+  {
+    int Rank = 0;
+    vtkTypeInt64 DroppedEvents = 0;
+    std::vector<std::string> Names;
+    std::vector<vtkPVTraceRecorder::Event> Events;
+  };
+
+  std::vector<ProcessEvents> Processes;
+};
+
+vtkStandardNewMacro(vtkPVTraceInformation);
+//----------------------------------------------------------------------------
+vtkPVTraceInformation::vtkPVTraceInformation()
+  : Internals(new vtkPVTraceInformation::vtkInternals())
+{
+}
+
+//----------------------------------------------------------------------------
+vtkPVTraceInformation::~vtkPVTraceInformation()
+{
+}
+
+//----------------------------------------------------------------------------
+void vtkPVTraceInformation::CopyFromObject(vtkObject*)
+{
+  vtkInternals::ProcessEvents process;
+  vtkMultiProcessController* controller = vtkMultiProcessController::GetGlobalController();
+  process.Rank = controller ? controller->GetLocalProcessId() : 0;
+  process.DroppedEvents = vtkPVTraceRecorder::GetNumberOfDroppedEvents();
+  vtkPVTraceRecorder::GetEvents(process.Events, process.Names);
+
+  this->Internals->Processes.clear();
+  this->Internals->Processes.push_back(std::move(process));
+}
+
+//----------------------------------------------------------------------------
+void vtkPVTraceInformation::AddInformation(vtkPVInformation* info)
+{
+  vtkPVTraceInformation* other = vtkPVTraceInformation::SafeDownCast(info);
+  if (other)
+  {
+    auto& processes = this->Internals->Processes;
+    processes.insert(processes.end(), other->Internals->Processes.begin(),
+      other->Internals->Processes.end());
+  }
+}
+
+//----------------------------------------------------------------------------
+void vtkPVTraceInformation::CopyToStream(vtkClientServerStream* css)
+{
+  css->Reset();
+  *css << vtkClientServerStream::Reply
+       << static_cast<int>(this->Internals->Processes.size());
+  for (const auto& process : this->Internals->Processes)
+  {
+    const int numEvents = static_cast<int>(process.Events.size());
+    *css << process.Rank << static_cast<long long>(process.DroppedEvents)
+         << static_cast<int>(process.Names.size());
+    for (const auto& name : process.Names)
+    {
+      *css << name.c_str();
+    }
+
+    // events are sent as 4 arrays: times, name ids, threads and category/phase.
+    std::vector<long long> times(numEvents);
+    std::vector<unsigned int> names(numEvents);
+    std::vector<unsigned int> threads(numEvents);
+    std::vector<unsigned short> flags(numEvents);
+    for (int cc = 0; cc < numEvents; ++cc)
+    {
+      const auto& event = process.Events[cc];
+      times[cc] = event.Time;
+      names[cc] = event.Name;
+      threads[cc] = event.Thread;
+      flags[cc] = static_cast<unsigned short>((event.Category << 8) | event.Phase);
+    }
+    *css << numEvents;
+    if (numEvents > 0)
+    {
+      *css << vtkClientServerStream::InsertArray(times.data(), numEvents)
+           << vtkClientServerStream::InsertArray(names.data(), numEvents)
+           << vtkClientServerStream::InsertArray(threads.data(), numEvents)
+           << vtkClientServerStream::InsertArray(flags.data(), numEvents);
+    }
+  }
+  *css << vtkClientServerStream::End;
+}
+
+//----------------------------------------------------------------------------
+void vtkPVTraceInformation::CopyFromStream(const vtkClientServerStream* css)
+{
+  auto& processes = this->Internals->Processes;
+  processes.clear();
+
+  int argument = 0;
+  int numProcesses;
+  if (!css->GetArgument(0, argument++, &numProcesses))
+  {
+    vtkErrorMacro("Error parsing number of processes from message.");
+    return;
+  }
+
+  processes.resize(numProcesses);
+  for (auto& process : processes)
+  {
+    long long dropped;
+    int numNames;
+    if (!css->GetArgument(0, argument++, &process.Rank) ||
+      !css->GetArgument(0, argument++, &dropped) || !css->GetArgument(0, argument++, &numNames))
+    {
+      vtkErrorMacro("Error parsing process header from message.");
+      processes.clear();
+      return;
+    }
+    process.DroppedEvents = dropped;
+    process.Names.resize(numNames);
+    for (auto& name : process.Names)
+    {
+      if (!css->GetArgument(0, argument++, &name))
+      {
+        vtkErrorMacro("Error parsing event names from message.");
+        processes.clear();
+        return;
+      }
+    }
+
+    int numEvents;
+    if (!css->GetArgument(0, argument++, &numEvents))
+    {
+      vtkErrorMacro("Error parsing number of events from message.");
+      processes.clear();
+      return;
+    }
+    if (numEvents == 0)
+    {
+      continue;
+    }
+
+    std::vector<long long> times(numEvents);
+    std::vector<unsigned int> names(numEvents);
+    std::vector<unsigned int> threads(numEvents);
+    std::vector<unsigned short> flags(numEvents);
+    const vtkTypeUInt32 length = static_cast<vtkTypeUInt32>(numEvents);
+    if (!css->GetArgument(0, argument++, times.data(), length) ||
+      !css->GetArgument(0, argument++, names.data(), length) ||
+      !css->GetArgument(0, argument++, threads.data(), length) ||
+      !css->GetArgument(0, argument++, flags.data(), length))
+    {
+      vtkErrorMacro("Error parsing events from message.");
+      processes.clear();
+      return;
+    }
+    process.Events.resize(numEvents);
+    for (int cc = 0; cc < numEvents; ++cc)
+    {
+      auto& event = process.Events[cc];
+      event.Time = times[cc];
+      event.Name = names[cc];
+      event.Thread = threads[cc];
+      event.Category = static_cast<vtkTypeUInt8>((flags[cc] >> 8) & 0xff);
+      event.Phase = static_cast<vtkTypeUInt8>(flags[cc] & 0xff);
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+int vtkPVTraceInformation::GetNumberOfProcesses()
+{
+  return static_cast<int>(this->Internals->Processes.size());
+}
+
+//----------------------------------------------------------------------------
+int vtkPVTraceInformation::GetRank(int idx)
+{
+  return (idx >= 0 && idx < this->GetNumberOfProcesses()) ? this->Internals->Processes[idx].Rank
+                                                          : -1;
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkPVTraceInformation::GetNumberOfEvents(int idx)
+{
+  return (idx >= 0 && idx < this->GetNumberOfProcesses())
+    ? static_cast<vtkIdType>(this->Internals->Processes[idx].Events.size())
+    : 0;
+}
+
+//----------------------------------------------------------------------------
+vtkTypeInt64 vtkPVTraceInformation::GetNumberOfDroppedEvents()
+{
+  vtkTypeInt64 dropped = 0;
+  for (const auto& process : this->Internals->Processes)
+  {
+    dropped += process.DroppedEvents;
+  }
+  return dropped;
+}
+
+//----------------------------------------------------------------------------
+bool vtkPVTraceInformation::WriteChromeTrace(const char* filename)
+{
+  std::ofstream ofs(filename);
+  if (!ofs)
+  {
+    vtkErrorMacro("Failed to open '" << (filename ? filename : "(null)") << "' for writing.");
+    return false;
+  }
+  return this->WriteChromeTrace(ofs);
+}
+
+//----------------------------------------------------------------------------
+bool vtkPVTraceInformation::WriteChromeTrace(ostream& os)
+{
+  // times are written in microseconds relative to the first event.
+  vtkTypeInt64 origin = std::numeric_limits<vtkTypeInt64>::max();
+  for (const auto& process : this->Internals->Processes)
+  {
+    if (!process.Events.empty())
+    {
+      origin = std::min(origin, process.Events.front().Time);
+    }
+  }
+
+  const int numCategories = static_cast<int>(sizeof(CategoryNames) / sizeof(CategoryNames[0]));
+  os << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  bool first = true;
+  os << std::fixed << std::setprecision(3);
+  for (const auto& process : this->Internals->Processes)
+  {
+    os << (first ? "\n" : ",\n") << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":"
+       << process.Rank << ",\"args\":{\"name\":\"rank " << process.Rank << "\"}}";
+    first = false;
+
+    for (const auto& event : process.Events)
+    {
+      const std::string& name =
+        event.Name < process.Names.size() ? process.Names[event.Name] : std::string("unknown");
+      const char* category =
+        event.Category < numCategories ? CategoryNames[event.Category] : "other";
+      os << ",\n{\"name\":\"" << EscapeJSON(name) << "\",\"cat\":\"" << category
+         << "\",\"ph\":\"" << (event.Phase == vtkPVTraceRecorder::BEGIN ? "B" : "E")
+         << "\",\"ts\":" << (event.Time - origin) * 1.0e-3 << ",\"pid\":" << process.Rank
+         << ",\"tid\":" << event.Thread << "}";
+    }
+  }
+  os << "\n]}\n";
+  return !os.fail();
+}
+
+//----------------------------------------------------------------------------
+void vtkPVTraceInformation::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "NumberOfProcesses: " << this->GetNumberOfProcesses() << endl;
+  for (const auto& process : this->Internals->Processes)
+  {
+    os << indent.GetNextIndent() << "Rank " << process.Rank << ": " << process.Events.size()
+       << " events, " << process.DroppedEvents << " dropped" << endl;
+  }
+}
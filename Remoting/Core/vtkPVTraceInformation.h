@@ -0,0 +1,106 @@
+/*=========================================================================
+
+  Program:   ParaView
+  Module:    vtkPVTraceInformation.h
+
+  Copyright (c) Kitware, Inc.
+  All rights reserved.
+  See Copyright.txt or http://www.paraview.org/HTML/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+/**
+ * @class   vtkPVTraceInformation
+ * @brief   gathers the events recorded by vtkPVTraceRecorder on all ranks.
+ *
+ * vtkPVTraceInformation collects the binary events recorded by
+ * vtkPVTraceRecorder on each process, with the rank they come from, and can
+ * write them out as a Chrome trace-event JSON file, with one "process" per
+ * rank. Event times are already corrected for the clock offset of each rank
+ * relative to rank 0, see vtkPVTraceRecorder::SynchronizeClocks().
+ *
+ * This is a replacement for vtkPVTimerInformation when looking at the timings
+ * of many ranks.
+ *
+ * @sa vtkPVTraceRecorder
+ */
+
+#ifndef vtkPVTraceInformation_h
+#define vtkPVTraceInformation_h
+
+#include "vtkPVInformation.h"
+#include "vtkRemotingCoreModule.h" //needed for exports
+
+#include <memory> // for std::unique_ptr
+
+class VTKREMOTINGCORE_EXPORT vtkPVTraceInformation : public vtkPVInformation
+{
+public:
+  static vtkPVTraceInformation* New();
+  vtkTypeMacro(vtkPVTraceInformation, vtkPVInformation);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  /**
+   * Copies the events recorded on the local process. The object is ignored.
+   */
+  void CopyFromObject(vtkObject*) override;
+
+  /**
+   * Merge another information object.
+   */
+  void AddInformation(vtkPVInformation*) override;
+
+  //@{
+  /**
+   * Manage a serialized version of the information.
+   */
+  void CopyToStream(vtkClientServerStream*) override;
+  void CopyFromStream(const vtkClientServerStream*) override;
+  //@}
+
+  /**
+   * Returns the number of processes events were gathered from.
+   */
+  int GetNumberOfProcesses();
+
+  /**
+   * Returns the rank of the idx-th process.
+   */
+  int GetRank(int idx);
+
+  /**
+   * Returns the number of events gathered from the idx-th process.
+   */
+  vtkIdType GetNumberOfEvents(int idx);
+
+  /**
+   * Returns the total number of events dropped on all processes because their
+   * buffers were full.
+   */
+  vtkTypeInt64 GetNumberOfDroppedEvents();
+
+  //@{
+  /**
+   * Writes the events in the Chrome trace-event JSON format. Returns false on
+   * failure.
+   */
+  bool WriteChromeTrace(const char* filename);
+  bool WriteChromeTrace(ostream& os);
+  //@}
+
+protected:
+  vtkPVTraceInformation();
+  ~vtkPVTraceInformation() override;
+
+private:
+  vtkPVTraceInformation(const vtkPVTraceInformation&) = delete;
+  void operator=(const vtkPVTraceInformation&) = delete;
+
+  class vtkInternals;
+  std::unique_ptr<vtkInternals> Internals;
+};
+
+#endif
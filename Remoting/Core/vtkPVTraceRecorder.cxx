@@ -0,0 +1,324 @@
+/*=========================================================================
+
+  Program:   ParaView
+  Module:    vtkPVTraceRecorder.cxx
+
+  Copyright (c) Kitware, Inc.
+  All rights reserved.
+  See Copyright.txt or http://www.paraview.org/HTML/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+#include "vtkPVTraceRecorder.h"
+
+#include "vtkMultiProcessController.h"
+#include "vtkObjectFactory.h"
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace
+{
+// Buffer of events recorded by a single thread. The mutex is only contended
+// while the events are being copied by GetEvents() or cleared by ResetLog().
+struct ThreadBuffer
+{
+  std::mutex Mutex;
+  std::vector<vtkPVTraceRecorder::Event> Events;
+
+  // id of the thread currently recording in the buffer.
+  vtkTypeUInt32 Thread;
+
+  // ids of names recorded using the `const char*` API, keyed by pointer. Only
+  // accessed by the owning thread.
+  std::unordered_map<const void*, vtkTypeUInt32> LiteralNames;
+};
+
+struct Registry
+{
+  std::mutex Mutex;
+  // buffers are kept once their thread exits, since their events are still
+  // to be gathered, and are handed over to the next thread that records.
+  std::vector<std::unique_ptr<ThreadBuffer> > Buffers;
+  std::vector<ThreadBuffer*> FreeBuffers;
+  vtkTypeUInt32 NextThread = 0;
+
+  std::mutex NamesMutex;
+  std::vector<std::string> Names;
+  std::unordered_map<std::string, vtkTypeUInt32> NameIds;
+
+  std::atomic<int> MaxEventsPerThread{ 1000000 };
+  std::atomic<vtkTypeInt64> DroppedEvents{ 0 };
+  std::atomic<vtkTypeInt64> ClockOffset{ 0 };
+
+  vtkTypeUInt32 Intern(const std::string& name)
+  {
+    std::lock_guard<std::mutex> lock(this->NamesMutex);
+    auto iter = this->NameIds.find(name);
+    if (iter != this->NameIds.end())
+    {
+      return iter->second;
+    }
+    const vtkTypeUInt32 id = static_cast<vtkTypeUInt32>(this->Names.size());
+    this->Names.push_back(name);
+    this->NameIds.emplace(name, id);
+    return id;
+  }
+};
+
+Registry& GetRegistry()
+{
+  static Registry registry;
+  return registry;
+}
+
+// Gives the buffer of a thread back to the registry when the thread exits.
+struct ThreadBufferOwner
+{
+  ThreadBuffer* Buffer = nullptr;
+
+  ~ThreadBufferOwner()
+  {
+    if (this->Buffer)
+    {
+      Registry& registry = GetRegistry();
+      std::lock_guard<std::mutex> lock(registry.Mutex);
+      registry.FreeBuffers.push_back(this->Buffer);
+    }
+  }
+};
+
+ThreadBuffer* GetThreadBuffer()
+{
+  thread_local ThreadBufferOwner owner;
+  if (owner.Buffer == nullptr)
+  {
+    Registry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.Mutex);
+    if (registry.FreeBuffers.empty())
+    {
+      registry.Buffers.emplace_back(new ThreadBuffer());
+      owner.Buffer = registry.Buffers.back().get();
+    }
+    else
+    {
+      owner.Buffer = registry.FreeBuffers.back();
+      registry.FreeBuffers.pop_back();
+    }
+    // the events already in a recycled buffer keep the id of their thread.
+    owner.Buffer->Thread = registry.NextThread++;
+  }
+  return owner.Buffer;
+}
+
+void Push(ThreadBuffer* buffer, int category, int phase, vtkTypeUInt32 name)
+{
+  vtkPVTraceRecorder::Event event;
+  event.Time = vtkPVTraceRecorder::Now();
+  event.Name = name;
+  event.Thread = buffer->Thread;
+  event.Category = static_cast<vtkTypeUInt8>(category);
+  event.Phase = static_cast<vtkTypeUInt8>(phase);
+
+  Registry& registry = GetRegistry();
+  std::lock_guard<std::mutex> lock(buffer->Mutex);
+  if (buffer->Events.size() >= static_cast<size_t>(registry.MaxEventsPerThread.load()))
+  {
+    ++registry.DroppedEvents;
+    return;
+  }
+  buffer->Events.push_back(event);
+}
+
+// tag used by SynchronizeClocks().
+const int CLOCK_SYNC_TAG = 948302;
+}
+
+std::atomic<bool> vtkPVTraceRecorder::Enabled(false);
+
+vtkStandardNewMacro(vtkPVTraceRecorder);
+//----------------------------------------------------------------------------
+vtkPVTraceRecorder::vtkPVTraceRecorder()
+{
+}
+
+//----------------------------------------------------------------------------
+vtkPVTraceRecorder::~vtkPVTraceRecorder()
+{
+}
+
+//----------------------------------------------------------------------------
+void vtkPVTraceRecorder::SetEnabled(int enabled)
+{
+  if ((enabled != 0) == vtkPVTraceRecorder::IsEnabled())
+  {
+    return;
+  }
+  if (enabled)
+  {
+    vtkPVTraceRecorder::SynchronizeClocks(vtkMultiProcessController::GetGlobalController());
+  }
+  vtkPVTraceRecorder::Enabled.store(enabled != 0);
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+int vtkPVTraceRecorder::GetEnabled()
+{
+  return vtkPVTraceRecorder::IsEnabled() ? 1 : 0;
+}
+
+//----------------------------------------------------------------------------
+void vtkPVTraceRecorder::ResetLog()
+{
+  Registry& registry = GetRegistry();
+  std::lock_guard<std::mutex> lock(registry.Mutex);
+  for (auto& buffer : registry.Buffers)
+  {
+    std::lock_guard<std::mutex> bufferLock(buffer->Mutex);
+    buffer->Events.clear();
+  }
+  registry.DroppedEvents = 0;
+}
+
+//----------------------------------------------------------------------------
+void vtkPVTraceRecorder::SetMaxEventsPerThread(int value)
+{
+  GetRegistry().MaxEventsPerThread = std::max(value, 0);
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+int vtkPVTraceRecorder::GetMaxEventsPerThread()
+{
+  return GetRegistry().MaxEventsPerThread;
+}
+
+//----------------------------------------------------------------------------
+vtkTypeInt64 vtkPVTraceRecorder::Now()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch())
+    .count();
+}
+
+//----------------------------------------------------------------------------
+void vtkPVTraceRecorder::Record(int category, int phase, const char* name)
+{
+  ThreadBuffer* buffer = GetThreadBuffer();
+  auto iter = buffer->LiteralNames.find(name);
+  if (iter == buffer->LiteralNames.end())
+  {
+    iter = buffer->LiteralNames.emplace(name, GetRegistry().Intern(name)).first;
+  }
+  Push(buffer, category, phase, iter->second);
+}
+
+//----------------------------------------------------------------------------
+void vtkPVTraceRecorder::Record(int category, int phase, const std::string& name)
+{
+  Push(GetThreadBuffer(), category, phase, GetRegistry().Intern(name));
+}
+
+//----------------------------------------------------------------------------
+void vtkPVTraceRecorder::GetEvents(std::vector<Event>& events, std::vector<std::string>& names)
+{
+  Registry& registry = GetRegistry();
+  events.clear();
+  {
+    std::lock_guard<std::mutex> lock(registry.Mutex);
+    for (auto& buffer : registry.Buffers)
+    {
+      std::lock_guard<std::mutex> bufferLock(buffer->Mutex);
+      events.insert(events.end(), buffer->Events.begin(), buffer->Events.end());
+    }
+  }
+  {
+    std::lock_guard<std::mutex> lock(registry.NamesMutex);
+    names = registry.Names;
+  }
+
+  const vtkTypeInt64 offset = registry.ClockOffset;
+  for (auto& event : events)
+  {
+    event.Time += offset;
+  }
+  std::stable_sort(events.begin(), events.end(),
+    [](const Event& a, const Event& b) { return a.Time < b.Time; });
+}
+
+//----------------------------------------------------------------------------
+vtkTypeInt64 vtkPVTraceRecorder::GetNumberOfDroppedEvents()
+{
+  return GetRegistry().DroppedEvents;
+}
+
+//----------------------------------------------------------------------------
+void vtkPVTraceRecorder::SynchronizeClocks(vtkMultiProcessController* controller)
+{
+  Registry& registry = GetRegistry();
+  if (controller == nullptr || controller->GetNumberOfProcesses() <= 1)
+  {
+    registry.ClockOffset = 0;
+    return;
+  }
+
+  // Rank 0 exchanges time stamps with every other rank a few times and keeps
+  // the exchange with the shortest round trip, assuming the remote time stamp
+  // was taken half-way through it.
+  const int rounds = 8;
+  const int numProcs = controller->GetNumberOfProcesses();
+  if (controller->GetLocalProcessId() == 0)
+  {
+    for (int rank = 1; rank < numProcs; ++rank)
+    {
+      vtkTypeInt64 bestRoundTrip = std::numeric_limits<vtkTypeInt64>::max();
+      vtkTypeInt64 offset = 0;
+      for (int cc = 0; cc < rounds; ++cc)
+      {
+        const vtkTypeInt64 t0 = vtkPVTraceRecorder::Now();
+        vtkTypeInt64 remote = t0;
+        controller->Send(&remote, 1, rank, CLOCK_SYNC_TAG);
+        controller->Receive(&remote, 1, rank, CLOCK_SYNC_TAG);
+        const vtkTypeInt64 t1 = vtkPVTraceRecorder::Now();
+        if (t1 - t0 < bestRoundTrip)
+        {
+          bestRoundTrip = t1 - t0;
+          offset = t0 + (t1 - t0) / 2 - remote;
+        }
+      }
+      controller->Send(&offset, 1, rank, CLOCK_SYNC_TAG);
+    }
+    registry.ClockOffset = 0;
+  }
+  else
+  {
+    for (int cc = 0; cc < rounds; ++cc)
+    {
+      vtkTypeInt64 stamp;
+      controller->Receive(&stamp, 1, 0, CLOCK_SYNC_TAG);
+      stamp = vtkPVTraceRecorder::Now();
+      controller->Send(&stamp, 1, 0, CLOCK_SYNC_TAG);
+    }
+    vtkTypeInt64 offset = 0;
+    controller->Receive(&offset, 1, 0, CLOCK_SYNC_TAG);
+    registry.ClockOffset = offset;
+  }
+}
+
+//----------------------------------------------------------------------------
+void vtkPVTraceRecorder::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "Enabled: " << vtkPVTraceRecorder::IsEnabled() << endl;
+  os << indent << "MaxEventsPerThread: " << GetRegistry().MaxEventsPerThread << endl;
+  os << indent << "ClockOffset: " << GetRegistry().ClockOffset << endl;
+  os << indent << "DroppedEvents: " << GetRegistry().DroppedEvents << endl;
+}
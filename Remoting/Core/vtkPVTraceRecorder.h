@@ -0,0 +1,202 @@
+/*=========================================================================
+
+  Program:   ParaView
+  Module:    vtkPVTraceRecorder.h
+
+  Copyright (c) Kitware, Inc.
+  All rights reserved.
+  See Copyright.txt or http://www.paraview.org/HTML/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+/**
+ * @class   vtkPVTraceRecorder
+ * @brief   records timed events in a compact binary form.
+ *
+ * vtkPVTraceRecorder records begin/end events, with their thread and category,
+ * for the current process. Unlike vtkTimerLog, events are stored in binary
+ * form, in per-thread buffers, and are meant to be gathered from all ranks with
+ * vtkPVTraceInformation and written as a Chrome trace-event JSON file, which
+ * can be loaded in chrome://tracing or https://ui.perfetto.dev.
+ *
+ * Recording is a process wide setting, disabled by default. When disabled,
+ * recording an event costs a single atomic load. Code is instrumented using
+ * vtkPVTraceScope:
+ *
+ * @code{.cpp}
+ *   vtkPVTraceScope scope(vtkPVTraceRecorder::RENDERING, "still render");
+ * @endcode
+ *
+ * Instances of vtkPVTraceRecorder are only used to control the recorder on all
+ * processes through the "misc", "TraceRecorder" proxy. Enabling the recorder
+ * with SetEnabled() is a collective operation over the global controller: it
+ * estimates the offset of the local clock relative to rank 0's, which is then
+ * used to align the events recorded on all ranks.
+ *
+ * @sa vtkPVTraceInformation, vtkPVTraceScope
+ */
+
+#ifndef vtkPVTraceRecorder_h
+#define vtkPVTraceRecorder_h
+
+#include "vtkObject.h"
+#include "vtkRemotingCoreModule.h" //needed for exports
+
+#include <atomic> // for std::atomic
+#include <string> // for std::string
+#include <vector> // for std::vector
+
+class vtkMultiProcessController;
+
+class VTKREMOTINGCORE_EXPORT vtkPVTraceRecorder : public vtkObject
+{
+public:
+  static vtkPVTraceRecorder* New();
+  vtkTypeMacro(vtkPVTraceRecorder, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  enum Categories
+  {
+    PIPELINE = 0,
+    RMI,
+    COMPOSITING,
+    DATA_DELIVERY,
+    RENDERING,
+    OTHER,
+    NUMBER_OF_CATEGORIES
+  };
+
+  enum Phases
+  {
+    BEGIN = 0,
+    END = 1
+  };
+
+  /**
+   * A recorded event. `Time` is in nanoseconds on the recorder's clock; `Name`
+   * indexes the names returned by GetEvents(). `Thread` numbers the threads
+   * in the order they first recorded an event.
+   */
+  struct Event
+  {
+    vtkTypeInt64 Time;
+    vtkTypeUInt32 Name;
+    vtkTypeUInt32 Thread;
+    vtkTypeUInt8 Category;
+    vtkTypeUInt8 Phase;
+  };
+
+  //@{
+  /**
+   * Enables/disables recording on this process. Enabling is a collective
+   * operation on the global controller, see class documentation.
+   */
+  void SetEnabled(int enabled);
+  int GetEnabled();
+  //@}
+
+  /**
+   * Discards all recorded events on this process.
+   */
+  void ResetLog();
+
+  //@{
+  /**
+   * Maximum number of events kept per thread buffer. Events recorded once a
+   * thread's buffer is full are dropped. The buffer of a thread that exited
+   * is reused, with its events, by the next thread that records, so that
+   * short-lived threads do not add up. Default is 1000000.
+   */
+  void SetMaxEventsPerThread(int value);
+  int GetMaxEventsPerThread();
+  //@}
+
+  /**
+   * Returns true when recording is enabled. This is the only cost of
+   * instrumentation when recording is disabled.
+   */
+  static bool IsEnabled() { return vtkPVTraceRecorder::Enabled.load(std::memory_order_relaxed); }
+
+  //@{
+  /**
+   * Record an event. `name` must remain valid for the lifetime of the process,
+   * e.g. a string literal; use the std::string overload otherwise.
+   */
+  static void Record(int category, int phase, const char* name);
+  static void Record(int category, int phase, const std::string& name);
+  //@}
+
+  /**
+   * Returns a copy of the events recorded on this process, sorted by time, and
+   * the names they refer to. Times are corrected by the clock offset
+   * estimated when the recorder was enabled.
+   */
+  static void GetEvents(std::vector<Event>& events, std::vector<std::string>& names);
+
+  /**
+   * Returns the number of events dropped because a thread's buffer was full.
+   */
+  static vtkTypeInt64 GetNumberOfDroppedEvents();
+
+  /**
+   * Estimates the offset of the local clock relative to the clock on rank 0 of
+   * `controller` by exchanging time stamps. Collective operation. Called by
+   * SetEnabled().
+   */
+  static void SynchronizeClocks(vtkMultiProcessController* controller);
+
+  /**
+   * Returns the current time on the recorder's clock, in nanoseconds.
+   */
+  static vtkTypeInt64 Now();
+
+protected:
+  vtkPVTraceRecorder();
+  ~vtkPVTraceRecorder() override;
+
+private:
+  vtkPVTraceRecorder(const vtkPVTraceRecorder&) = delete;
+  void operator=(const vtkPVTraceRecorder&) = delete;
+
+  static std::atomic<bool> Enabled;
+};
+
+/**
+ * @class vtkPVTraceScope
+ * @brief records a begin event on construction and an end event on destruction.
+ */
+class vtkPVTraceScope
+{
+public:
+  vtkPVTraceScope(int category, const char* name)
+    : Category(category)
+    , Name(name)
+    , Active(vtkPVTraceRecorder::IsEnabled())
+  {
+    if (this->Active)
+    {
+      vtkPVTraceRecorder::Record(category, vtkPVTraceRecorder::BEGIN, name);
+    }
+  }
+
+  ~vtkPVTraceScope()
+  {
+    if (this->Active)
+    {
+      vtkPVTraceRecorder::Record(this->Category, vtkPVTraceRecorder::END, this->Name);
+    }
+  }
+
+private:
+  vtkPVTraceScope(const vtkPVTraceScope&) = delete;
+  void operator=(const vtkPVTraceScope&) = delete;
+
+  int Category;
+  const char* Name;
+  bool Active;
+};
+
+#endif
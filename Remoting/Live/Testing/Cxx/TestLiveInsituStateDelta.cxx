@@ -0,0 +1,323 @@
+/*=========================================================================
+
+  Program:   ParaView
+  Module:    TestLiveInsituStateDelta.cxx
+
+  Copyright (c) Kitware, Inc.
+  All rights reserved.
+  See Copyright.txt or http://www.paraview.org/HTML/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// Checks, with the Live and Insitu proxy managers in the same process, that
+// vtkLiveInsituStateDelta only sends the proxies that changed, that the
+// Insitu proxy manager gets the changes, and that the full state is sent
+// when Insitu does not have the last state sent or could not load it.
+#include "vtkInitializationHelper.h"
+#include "vtkLiveInsituStateDelta.h"
+#include "vtkLogger.h"
+#include "vtkMultiProcessStream.h"
+#include "vtkNew.h"
+#include "vtkPVOptions.h"
+#include "vtkPVXMLElement.h"
+#include "vtkPVXMLParser.h"
+#include "vtkProcessModule.h"
+#include "vtkSMInsituStateLoader.h"
+#include "vtkSMPropertyHelper.h"
+#include "vtkSMProxy.h"
+#include "vtkSMSession.h"
+#include "vtkSMSessionProxyManager.h"
+#include "vtkSMStateLoader.h"
+#include "vtkSmartPointer.h"
+
+#include <cstdlib>
+#include <sstream>
+#include <string>
+
+namespace
+{
+const int NumberOfSpheres = 200;
+
+std::string SaveState(vtkSMSessionProxyManager* pxm)
+{
+  vtkSmartPointer<vtkPVXMLElement> root;
+  root.TakeReference(pxm->SaveXMLState());
+  std::ostringstream xml;
+  root->PrintXML(xml, vtkIndent());
+  return xml.str();
+}
+
+// Copies `message` the way it goes through the socket.
+unsigned int Transfer(vtkMultiProcessStream& message, vtkMultiProcessStream& received)
+{
+  unsigned char* data = nullptr;
+  unsigned int size = 0;
+  message.GetRawData(data, size);
+  received.SetRawData(data, size);
+  delete[] data;
+  return size;
+}
+
+double GetRadius(vtkSMSessionProxyManager* pxm, const char* name)
+{
+  vtkSMProxy* proxy = pxm->GetProxy("sources", name);
+  return proxy ? vtkSMPropertyHelper(proxy, "Radius").GetAsDouble() : -1.0;
+}
+
+void SetRadius(vtkSMSessionProxyManager* pxm, const char* name, double radius)
+{
+  vtkSMProxy* proxy = pxm->GetProxy("sources", name);
+  vtkSMPropertyHelper(proxy, "Radius").Set(radius);
+  proxy->UpdateVTKObjects();
+}
+
+class vtkLoopback
+{
+public:
+  vtkSMSessionProxyManager* LivePxm;
+  vtkSMSessionProxyManager* InsituPxm;
+  vtkNew<vtkLiveInsituStateDelta> Live;
+  vtkNew<vtkLiveInsituStateDelta> Insitu;
+  unsigned int MessageSize = 0;
+
+  // What vtkLiveInsituLink does on both sides for one time step, returning
+  // the type of the message sent.
+  int Update(bool changed)
+  {
+    vtkMultiProcessStream message;
+    const int type =
+      this->Live->Encode(SaveState(this->LivePxm).c_str(), changed, this->Insitu->GetVersion(),
+        message);
+    vtkMultiProcessStream received;
+    this->MessageSize = Transfer(message, received);
+    this->Load(received);
+    return type;
+  }
+
+  // Encodes a change that never reaches Insitu.
+  void Lose()
+  {
+    vtkMultiProcessStream message;
+    this->Live->Encode(
+      SaveState(this->LivePxm).c_str(), true, this->Insitu->GetVersion(), message);
+  }
+
+  void Load(vtkMultiProcessStream& received)
+  {
+    vtkSmartPointer<vtkPVXMLElement> xmlState = this->Insitu->Decode(received);
+    if (xmlState)
+    {
+      vtkNew<vtkSMInsituStateLoader> loader;
+      loader->KeepIdMappingOn();
+      loader->SetSessionProxyManager(this->InsituPxm);
+      if (!this->InsituPxm->LoadXMLState(xmlState, loader))
+      {
+        this->Insitu->Invalidate();
+      }
+    }
+  }
+};
+
+bool TestLoopback(vtkSMSessionProxyManager* livePxm, vtkSMSessionProxyManager* insituPxm)
+{
+  // the simulation pipeline.
+  for (int cc = 0; cc < NumberOfSpheres; ++cc)
+  {
+    vtkSmartPointer<vtkSMProxy> sphere;
+    sphere.TakeReference(insituPxm->NewProxy("sources", "SphereSource"));
+    vtkSMPropertyHelper(sphere, "Radius").Set(1.0);
+    sphere->UpdateVTKObjects();
+    insituPxm->RegisterProxy("sources", ("Sphere" + std::to_string(cc)).c_str(), sphere);
+  }
+
+  // the simulation connects: Live loads its state.
+  {
+    vtkNew<vtkPVXMLParser> parser;
+    parser->Parse(SaveState(insituPxm).c_str());
+    vtkNew<vtkSMStateLoader> loader;
+    loader->SetSessionProxyManager(livePxm);
+    livePxm->LoadXMLState(parser->GetRootElement(), loader);
+  }
+  vtkLoopback link;
+  link.LivePxm = livePxm;
+  link.InsituPxm = insituPxm;
+  link.Live->Initialize();
+  link.Insitu->Initialize();
+
+  if (link.Update(false) != vtkLiveInsituStateDelta::NO_STATE)
+  {
+    vtkLog(ERROR, "unchanged state sent.");
+    return false;
+  }
+
+  // the first state is sent in full.
+  SetRadius(livePxm, "Sphere0", 2.0);
+  if (link.Update(true) != vtkLiveInsituStateDelta::FULL_STATE)
+  {
+    vtkLog(ERROR, "first state not full.");
+    return false;
+  }
+  if (GetRadius(insituPxm, "Sphere0") != 2.0)
+  {
+    vtkLog(ERROR, "full state not loaded.");
+    return false;
+  }
+  const unsigned int fullSize = link.MessageSize;
+  if (link.Insitu->GetVersion() != 1)
+  {
+    vtkLog(ERROR, "wrong version: " << link.Insitu->GetVersion());
+    return false;
+  }
+
+  // then only the proxies that changed.
+  SetRadius(livePxm, "Sphere5", 3.0);
+  if (link.Update(true) != vtkLiveInsituStateDelta::DELTA_STATE)
+  {
+    vtkLog(ERROR, "no delta sent.");
+    return false;
+  }
+  if (GetRadius(insituPxm, "Sphere5") != 3.0 || GetRadius(insituPxm, "Sphere0") != 2.0 ||
+    GetRadius(insituPxm, "Sphere6") != 1.0)
+  {
+    vtkLog(ERROR, "delta not loaded.");
+    return false;
+  }
+  if (link.MessageSize * 4 >= fullSize)
+  {
+    vtkLog(ERROR, "delta is not smaller than the full state.");
+    return false;
+  }
+
+  // new proxies are created.
+  {
+    vtkSmartPointer<vtkSMProxy> sphere;
+    sphere.TakeReference(livePxm->NewProxy("sources", "SphereSource"));
+    vtkSMPropertyHelper(sphere, "Radius").Set(4.0);
+    sphere->UpdateVTKObjects();
+    livePxm->RegisterProxy("sources", "NewSphere", sphere);
+  }
+  if (link.Update(true) != vtkLiveInsituStateDelta::DELTA_STATE)
+  {
+    vtkLog(ERROR, "no delta sent.");
+    return false;
+  }
+  if (GetRadius(insituPxm, "NewSphere") != 4.0)
+  {
+    vtkLog(ERROR, "new proxy not created.");
+    return false;
+  }
+
+  // a lost message: the next state is sent in full.
+  SetRadius(livePxm, "Sphere7", 5.0);
+  link.Lose();
+  SetRadius(livePxm, "Sphere8", 6.0);
+  if (link.Update(true) != vtkLiveInsituStateDelta::FULL_STATE)
+  {
+    vtkLog(ERROR, "full state not sent after a lost message.");
+    return false;
+  }
+  if (GetRadius(insituPxm, "Sphere7") != 5.0 || GetRadius(insituPxm, "Sphere8") != 6.0)
+  {
+    vtkLog(ERROR, "changes missing after a lost message.");
+    return false;
+  }
+
+  // a delta received twice is ignored, and the full state is sent again,
+  // even if nothing changed.
+  SetRadius(livePxm, "Sphere9", 7.0);
+  vtkMultiProcessStream message;
+  if (link.Live->Encode(SaveState(livePxm).c_str(), true, link.Insitu->GetVersion(), message) !=
+    vtkLiveInsituStateDelta::DELTA_STATE)
+  {
+    vtkLog(ERROR, "no delta sent.");
+    return false;
+  }
+  vtkMultiProcessStream received, duplicate;
+  Transfer(message, received);
+  Transfer(message, duplicate);
+  link.Load(received);
+  if (GetRadius(insituPxm, "Sphere9") != 7.0)
+  {
+    vtkLog(ERROR, "delta not loaded.");
+    return false;
+  }
+  link.Load(duplicate);
+  if (link.Insitu->GetVersion() != -1)
+  {
+    vtkLog(ERROR, "duplicate delta accepted.");
+    return false;
+  }
+  if (link.Update(false) != vtkLiveInsituStateDelta::FULL_STATE)
+  {
+    vtkLog(ERROR, "full state not sent after a version mismatch.");
+    return false;
+  }
+  if (link.Insitu->GetVersion() != link.Live->GetVersion())
+  {
+    vtkLog(ERROR, "versions differ.");
+    return false;
+  }
+  if (link.Update(false) != vtkLiveInsituStateDelta::NO_STATE)
+  {
+    vtkLog(ERROR, "unchanged state sent.");
+    return false;
+  }
+
+  // a delta that Insitu cannot load: the full state is sent again, even if
+  // nothing changed.
+  SetRadius(livePxm, "Sphere10", 8.0);
+  if (link.Live->Encode(SaveState(livePxm).c_str(), true, link.Insitu->GetVersion(), message) !=
+    vtkLiveInsituStateDelta::DELTA_STATE)
+  {
+    vtkLog(ERROR, "no delta sent.");
+    return false;
+  }
+  vtkMultiProcessStream unloadable;
+  unloadable << static_cast<int>(vtkLiveInsituStateDelta::DELTA_STATE)
+             << link.Insitu->GetVersion() << link.Live->GetVersion() << std::string("<NoState/>");
+  // the state loader reports the error.
+  vtkObject::GlobalWarningDisplayOff();
+  link.Load(unloadable);
+  vtkObject::GlobalWarningDisplayOn();
+  if (link.Insitu->GetVersion() != -1)
+  {
+    vtkLog(ERROR, "state not loaded but accepted.");
+    return false;
+  }
+  if (link.Update(false) != vtkLiveInsituStateDelta::FULL_STATE)
+  {
+    vtkLog(ERROR, "full state not sent after a state not loaded.");
+    return false;
+  }
+  if (GetRadius(insituPxm, "Sphere10") != 8.0)
+  {
+    vtkLog(ERROR, "changes missing after a state not loaded.");
+    return false;
+  }
+  if (link.Update(false) != vtkLiveInsituStateDelta::NO_STATE)
+  {
+    vtkLog(ERROR, "unchanged state sent.");
+    return false;
+  }
+  return true;
+}
+}
+
+int TestLiveInsituStateDelta(int argc, char* argv[])
+{
+  vtkNew<vtkPVOptions> options;
+  vtkInitializationHelper::Initialize(argc, argv, vtkProcessModule::PROCESS_CLIENT, options);
+
+  bool success;
+  {
+    vtkNew<vtkSMSession> live;
+    vtkNew<vtkSMSession> insitu;
+    success = TestLoopback(live->GetSessionProxyManager(), insitu->GetSessionProxyManager());
+  }
+
+  vtkInitializationHelper::Finalize();
+  return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -19,6 +19,7 @@
 #include "vtkCommand.h"
 #include "vtkCommunicationErrorCatcher.h"
 #include "vtkExtractsDeliveryHelper.h"
+#include "vtkLiveInsituStateDelta.h"
 #include "vtkLogger.h"
 #include "vtkMultiProcessStream.h"
 #include "vtkNetworkAccessManager.h"
@@ -28,7 +29,6 @@
 #include "vtkPVDataInformation.h"
 #include "vtkPVSessionBase.h"
 #include "vtkPVXMLElement.h"
-#include "vtkPVXMLParser.h"
 #include "vtkProcessModule.h"
 #include "vtkSMInsituStateLoader.h"
 #include "vtkSMMessage.h"
@@ -314,6 +314,9 @@ public:
   typedef std::map<Key, vtkSmartPointer<vtkTrivialProducer> > ExtractsMap;
   ExtractsMap Extracts;
   std::map<vtkIdType, std::string> LastSentDataInformationMap;
+
+  // States sent by LIVE, or received by INSITU.
+  vtkNew<vtkLiveInsituStateDelta> StateDelta;
 };
 
 vtkStandardNewMacro(vtkLiveInsituLink);
@@ -560,6 +563,7 @@ void vtkLiveInsituLink::InsituConnect(vtkMultiProcessController* proc0NodesContr
   assert(this->ExtractsDeliveryHelper.GetPointer() == NULL);
 
   this->Proc0NodesController = proc0NodesController;
+  this->Internals->StateDelta->Initialize();
 
   this->ExtractsDeliveryHelper = vtkSmartPointer<vtkExtractsDeliveryHelper>::New();
   this->ExtractsDeliveryHelper->SetProcessIsProducer(this->ProcessType == LIVE ? false : true);
@@ -815,9 +819,7 @@ void vtkLiveInsituLink::InsituUpdate(double time, vtkIdType timeStep)
   int myId = pm->GetPartitionId();
   int numProcs = pm->GetNumberOfLocalPartitions();
 
-  char* buffer = NULL;
-  int buffer_size = 0;
-
+  vtkMultiProcessStream stateMessage;
   vtkMultiProcessStream extractsPauseMessage;
   std::vector<vtkTypeUInt32> idMappingInStateLoading;
 
@@ -826,6 +828,8 @@ void vtkLiveInsituLink::InsituUpdate(double time, vtkIdType timeStep)
     // steps to perform:
     // 1. Check with LIVE root-node to see if it has new INSITU
     //    state updates. If so receive them and broadcast to all satellites.
+    //    LIVE sends the proxies changed since the version of the state we
+    //    have, or the full state if we do not have the last one it sent.
     // 2. Update the InsituProxyManager using the most recent XML state we
     //    have.
     if (this->Proc0NodesController)
@@ -835,14 +839,9 @@ void vtkLiveInsituLink::InsituUpdate(double time, vtkIdType timeStep)
 
       // Get status of the state. Did it change? If so receive the state and
       // broadcast it to satellites.
-      this->Proc0NodesController->Receive(&buffer_size, 1, 1, 8010);
-      if (buffer_size > 0)
-      {
-        vtkLiveInsituLinkDebugMacro(<< "receiving modified state from Vis");
-        buffer = new char[buffer_size + 1];
-        this->Proc0NodesController->Receive(buffer, buffer_size, 1, 8011);
-        buffer[buffer_size] = 0;
-      }
+      int version = this->Internals->StateDelta->GetVersion();
+      this->Proc0NodesController->Send(&version, 1, 1, 8009);
+      this->Proc0NodesController->Receive(stateMessage, 1, 8010);
 
       // Get the information about extracts. When the extracts have changed or
       // not is encoded in the stream itself.
@@ -851,24 +850,14 @@ void vtkLiveInsituLink::InsituUpdate(double time, vtkIdType timeStep)
 
     if (numProcs > 1)
     {
-      pm->GetGlobalController()->Broadcast(&buffer_size, 1, 0);
-      if (buffer_size > 0)
-      {
-        pm->GetGlobalController()->Broadcast(buffer, buffer_size, 0);
-      }
+      pm->GetGlobalController()->Broadcast(stateMessage, 0);
       pm->GetGlobalController()->Broadcast(extractsPauseMessage, 0);
     }
   }
   else
   {
     assert(numProcs > 1);
-    pm->GetGlobalController()->Broadcast(&buffer_size, 1, 0);
-    if (buffer_size > 0)
-    {
-      buffer = new char[buffer_size + 1];
-      pm->GetGlobalController()->Broadcast(buffer, buffer_size, 0);
-      buffer[buffer_size] = 0;
-    }
+    pm->GetGlobalController()->Broadcast(stateMessage, 0);
     pm->GetGlobalController()->Broadcast(extractsPauseMessage, 0);
   }
 
@@ -876,15 +865,10 @@ void vtkLiveInsituLink::InsituUpdate(double time, vtkIdType timeStep)
   // satellites).
 
   vtkSmartPointer<vtkPVXMLElement> xmlState;
-  if (buffer && buffer_size > 0)
+  if (!stateMessage.Empty())
   {
-    vtkNew<vtkPVXMLParser> parser;
-    if (parser->Parse(buffer))
-    {
-      xmlState = parser->GetRootElement();
-    }
+    xmlState = this->Internals->StateDelta->Decode(stateMessage);
   }
-  delete[] buffer;
 
   int drop_connection = catcher.GetErrorsRaised() ? 1 : 0;
   if (numProcs > 1)
@@ -903,7 +887,11 @@ void vtkLiveInsituLink::InsituUpdate(double time, vtkIdType timeStep)
     vtkNew<vtkSMInsituStateLoader> loader;
     loader->KeepIdMappingOn();
     loader->SetSessionProxyManager(this->InsituProxyManager);
-    this->InsituProxyManager->LoadXMLState(xmlState, loader.GetPointer());
+    if (!this->InsituProxyManager->LoadXMLState(xmlState, loader.GetPointer()))
+    {
+      // ask for the full state.
+      this->Internals->StateDelta->Invalidate();
+    }
     int mappingSize = 0;
     vtkTypeUInt32* inSituMapping = loader->GetMappingArray(mappingSize);
     // Save mapping outside that scope
@@ -1071,19 +1059,17 @@ void vtkLiveInsituLink::OnInsituUpdate(double time, vtkIdType timeStep)
     // 2. Send information about extracts to the INSITU root, if the
     //    requested extracts has changed.
 
-    int xml_state_size = 0;
-    if (this->InsituXMLStateChanged)
-    {
-      xml_state_size = static_cast<int>(strlen(this->InsituXMLState));
-    }
-    // xml_state_size of 0 indicates that there are not updates to the state.
+    // A NO_STATE message indicates that there are not updates to the state.
     // the CoProcessor simply uses the state it received most recently.
-    this->Proc0NodesController->Send(&xml_state_size, 1, 1, 8010);
-    if (xml_state_size > 0)
+    int insituVersion = -1;
+    this->Proc0NodesController->Receive(&insituVersion, 1, 1, 8009);
+    vtkMultiProcessStream stateMessage;
+    if (this->Internals->StateDelta->Encode(this->InsituXMLState, this->InsituXMLStateChanged,
+          insituVersion, stateMessage) != vtkLiveInsituStateDelta::NO_STATE)
     {
       vtkLiveInsituLinkDebugMacro(<< "Sending modified state to simulation.");
-      this->Proc0NodesController->Send(this->InsituXMLState, xml_state_size, 1, 8011);
     }
+    this->Proc0NodesController->Send(stateMessage, 1, 8010);
 
     vtkMultiProcessStream extractsPauseMessage;
     extractsPauseMessage << this->SimulationPaused;
@@ -32,6 +32,10 @@
  * instantiating vtkLiveInsituLink directly) and in the Live ParaView
  * application (by using a proxy that instantiates the
  * vtkLiveInsituLink).
+ *
+ * The coprocessing state edited on the Live side is sent to Insitu through
+ * vtkLiveInsituStateDelta, as the proxies that changed since the last state
+ * Insitu received.
  * @ingroup LiveInsitu
 */
 
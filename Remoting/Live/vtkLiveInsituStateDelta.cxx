@@ -0,0 +1,176 @@
+/*=========================================================================
+
+  Program:   ParaView
+  Module:    vtkLiveInsituStateDelta.cxx
+
+  Copyright (c) Kitware, Inc.
+  All rights reserved.
+  See Copyright.txt or http://www.paraview.org/HTML/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+#include "vtkLiveInsituStateDelta.h"
+
+#include "vtkMultiProcessStream.h"
+#include "vtkNew.h"
+#include "vtkObjectFactory.h"
+#include "vtkPVXMLElement.h"
+#include "vtkPVXMLParser.h"
+
+#include <cstring>
+#include <map>
+#include <sstream>
+#include <string>
+
+namespace
+{
+vtkPVXMLElement* FindServerManagerState(vtkPVXMLElement* root)
+{
+  if (root && root->GetName() && strcmp(root->GetName(), "ServerManagerState") == 0)
+  {
+    return root;
+  }
+  return root ? root->FindNestedElementByName("ServerManagerState") : nullptr;
+}
+
+std::string ToString(vtkPVXMLElement* element)
+{
+  std::ostringstream xml;
+  element->PrintXML(xml, vtkIndent());
+  return xml.str();
+}
+}
+
+class vtkLiveInsituStateDelta::vtkInternals
+{
+public:
+  // <Proxy/> elements of the last state encoded, by id. The state is not
+  // known to Insitu until Valid is set.
+  std::map<std::string, std::string> Proxies;
+  bool Valid = false;
+};
+
+vtkStandardNewMacro(vtkLiveInsituStateDelta);
+//----------------------------------------------------------------------------
+vtkLiveInsituStateDelta::vtkLiveInsituStateDelta()
+  : Version(0)
+  , Internals(new vtkInternals())
+{
+}
+
+//----------------------------------------------------------------------------
+vtkLiveInsituStateDelta::~vtkLiveInsituStateDelta()
+{
+  delete this->Internals;
+  this->Internals = NULL;
+}
+
+//----------------------------------------------------------------------------
+void vtkLiveInsituStateDelta::Initialize()
+{
+  this->Version = 0;
+  this->Internals->Proxies.clear();
+  this->Internals->Valid = false;
+}
+
+//----------------------------------------------------------------------------
+int vtkLiveInsituStateDelta::Encode(
+  const char* xmlState, bool changed, int remoteVersion, vtkMultiProcessStream& message)
+{
+  message.Reset();
+  if (!xmlState || (!changed && remoteVersion == this->Version))
+  {
+    message << static_cast<int>(NO_STATE);
+    return NO_STATE;
+  }
+
+  vtkNew<vtkPVXMLParser> parser;
+  vtkPVXMLElement* root =
+    parser->Parse(xmlState) ? FindServerManagerState(parser->GetRootElement()) : nullptr;
+  const bool delta = root && this->Internals->Valid && remoteVersion == this->Version;
+
+  // Keep the <Proxy/> elements that changed, and everything else.
+  std::map<std::string, std::string> proxies;
+  vtkNew<vtkPVXMLElement> deltaRoot;
+  for (unsigned int cc = 0, max = root ? root->GetNumberOfNestedElements() : 0; cc < max; ++cc)
+  {
+    vtkPVXMLElement* child = root->GetNestedElement(cc);
+    const char* id = child->GetAttribute("id");
+    if (id && child->GetName() && strcmp(child->GetName(), "Proxy") == 0)
+    {
+      std::string xml = ToString(child);
+      if (delta)
+      {
+        auto iter = this->Internals->Proxies.find(id);
+        if (iter == this->Internals->Proxies.end() || iter->second != xml)
+        {
+          deltaRoot->AddNestedElement(child, 0);
+        }
+      }
+      proxies[id] = std::move(xml);
+    }
+    else if (delta)
+    {
+      deltaRoot->AddNestedElement(child, 0);
+    }
+  }
+  this->Internals->Proxies.swap(proxies);
+  this->Internals->Valid = root != nullptr;
+
+  const int baseVersion = this->Version++;
+  if (delta)
+  {
+    root->CopyAttributesTo(deltaRoot);
+    message << static_cast<int>(DELTA_STATE) << baseVersion << this->Version
+            << ToString(deltaRoot);
+    return DELTA_STATE;
+  }
+  message << static_cast<int>(FULL_STATE) << this->Version << std::string(xmlState);
+  return FULL_STATE;
+}
+
+//----------------------------------------------------------------------------
+vtkSmartPointer<vtkPVXMLElement> vtkLiveInsituStateDelta::Decode(vtkMultiProcessStream& message)
+{
+  int type = NO_STATE;
+  message >> type;
+  if (type != FULL_STATE && type != DELTA_STATE)
+  {
+    return nullptr;
+  }
+
+  int baseVersion = this->Version;
+  int version = 0;
+  std::string xml;
+  if (type == DELTA_STATE)
+  {
+    message >> baseVersion;
+  }
+  message >> version >> xml;
+
+  vtkNew<vtkPVXMLParser> parser;
+  if (baseVersion != this->Version || !parser->Parse(xml.c_str()))
+  {
+    // ask for the full state.
+    this->Version = -1;
+    return nullptr;
+  }
+  this->Version = version;
+  return parser->GetRootElement();
+}
+
+//----------------------------------------------------------------------------
+void vtkLiveInsituStateDelta::Invalidate()
+{
+  this->Version = -1;
+}
+
+//----------------------------------------------------------------------------
+void vtkLiveInsituStateDelta::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "Version: " << this->Version << endl;
+}
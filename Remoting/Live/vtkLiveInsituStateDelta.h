@@ -0,0 +1,105 @@
+/*=========================================================================
+
+  Program:   ParaView
+  Module:    vtkLiveInsituStateDelta.h
+
+  Copyright (c) Kitware, Inc.
+  All rights reserved.
+  See Copyright.txt or http://www.paraview.org/HTML/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+/**
+ * @class   vtkLiveInsituStateDelta
+ * @brief   versioned state messages between Live and Insitu.
+ *
+ * vtkLiveInsituStateDelta encodes the coprocessing pipeline state that
+ * ParaView Live sends to Insitu, and decodes it on the Insitu processes.
+ * Each state sent gets a new version. When Insitu has the last state sent,
+ * the message only carries the `<Proxy/>` elements that changed since,
+ * along with the proxy collections and links that tell how proxies are
+ * registered. Otherwise, for instance when a message was lost or could not
+ * be loaded, the full state is sent.
+ *
+ * A partial state is loaded with vtkSMInsituStateLoader, which keeps the
+ * proxies whose element is not in the state as they are.
+ * @ingroup LiveInsitu
+*/
+
+#ifndef vtkLiveInsituStateDelta_h
+#define vtkLiveInsituStateDelta_h
+
+#include "vtkObject.h"
+#include "vtkRemotingLiveModule.h" //needed for exports
+#include "vtkSmartPointer.h"       // needed for smart pointer
+
+class vtkMultiProcessStream;
+class vtkPVXMLElement;
+
+class VTKREMOTINGLIVE_EXPORT vtkLiveInsituStateDelta : public vtkObject
+{
+public:
+  static vtkLiveInsituStateDelta* New();
+  vtkTypeMacro(vtkLiveInsituStateDelta, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  enum MessageTypes
+  {
+    NO_STATE = 0,
+    FULL_STATE = 1,
+    DELTA_STATE = 2
+  };
+
+  /**
+   * Forget the states sent or received, e.g. when a new connection is made.
+   */
+  void Initialize();
+
+  /**
+   * Version of the last state encoded (on Live) or decoded (on Insitu).
+   * It is 0 until a state is sent, and -1 on Insitu after a message that
+   * could not be used.
+   */
+  vtkGetMacro(Version, int);
+
+  /**
+   * Used on Insitu when the state returned by Decode() could not be loaded.
+   * Sets the version to -1 so that the next message is a full state.
+   */
+  void Invalidate();
+
+  /**
+   * Used on Live to encode `xmlState`, the full coprocessing state, for an
+   * Insitu process that has the state `remoteVersion`. `changed` tells if
+   * `xmlState` changed since the last call. Returns the type of the message
+   * written to `message`: NO_STATE if Insitu is up to date, DELTA_STATE if
+   * Insitu has the last state sent, FULL_STATE otherwise.
+   */
+  int Encode(const char* xmlState, bool changed, int remoteVersion, vtkMultiProcessStream& message);
+
+  /**
+   * Used on Insitu to decode a message written by Encode(). Returns the state
+   * to load, or nullptr if there is none or if the message does not apply to
+   * the state this process has, in which case the next message will be a
+   * full state.
+   */
+  vtkSmartPointer<vtkPVXMLElement> Decode(vtkMultiProcessStream& message);
+
+protected:
+  vtkLiveInsituStateDelta();
+  ~vtkLiveInsituStateDelta() override;
+
+  int Version;
+
+private:
+  vtkLiveInsituStateDelta(const vtkLiveInsituStateDelta&) = delete;
+  void operator=(const vtkLiveInsituStateDelta&) = delete;
+
+  class vtkInternals;
+  vtkInternals* Internals;
+};
+
+#endif
@@ -36,7 +36,9 @@ protected:
   ~vtkSMInsituStateLoader() override;
 
   /**
-   * Overridden to try to reuse existing proxies as much as possible.
+   * Overridden to try to reuse existing proxies as much as possible. A proxy
+   * that is registered but has no element in the state, as in the partial
+   * states sent by vtkLiveInsituStateDelta, is reused as it is.
    */
   vtkSMProxy* NewProxy(vtkTypeUInt32 id, vtkSMProxyLocator* locator) override;
 
@@ -0,0 +1,323 @@
+/*=========================================================================
+
+  Program:   ParaView
+  Module:    TestUndoStackMemory.cxx
+
+  Copyright (c) Kitware, Inc.
+  All rights reserved.
+  See Copyright.txt or http://www.paraview.org/HTML/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// Checks that the undo stack keeps the properties a change leaves untouched
+// once, that the changes of an undo set to a proxy are merged into one state,
+// that undo and redo restore the property values, and that the oldest undo
+// sets are dropped when the stack exceeds its memory limit. With --benchmark,
+// the push, undo and redo times are reported.
+#include "vtkInitializationHelper.h"
+#include "vtkNew.h"
+#include "vtkProcessModule.h"
+#include "vtkSMMessage.h"
+#include "vtkSMPropertyHelper.h"
+#include "vtkSMProxy.h"
+#include "vtkSMProxyManager.h"
+#include "vtkSMRemoteObjectUpdateUndoElement.h"
+#include "vtkSMSession.h"
+#include "vtkSMSessionProxyManager.h"
+#include "vtkSMUndoStack.h"
+#include "vtkSMUndoStackBuilder.h"
+#include "vtkSmartPointer.h"
+#include "vtkTimerLog.h"
+#include "vtkUndoSet.h"
+
+#include <cstdlib>
+#include <vector>
+#include <vtksys/CommandLineArguments.hxx>
+
+namespace
+{
+const int NumberOfPoints = 20000;
+const int NumberOfSets = 20;
+const int ChangedPointsSet = NumberOfSets / 2;
+
+std::vector<double> MakePoints(double offset)
+{
+  std::vector<double> points(3 * NumberOfPoints);
+  for (size_t cc = 0; cc < points.size(); ++cc)
+  {
+    points[cc] = offset + 0.25 * cc;
+  }
+  return points;
+}
+
+// Value of Closed and first coordinate of the points after `numberOfSets`
+// sets.
+int ExpectedClosed(int numberOfSets)
+{
+  return numberOfSets % 2;
+}
+double ExpectedOffset(int numberOfSets)
+{
+  return numberOfSets > ChangedPointsSet ? 1.0 : 0.0;
+}
+
+bool CheckValues(vtkSMProxy* proxy, int numberOfSets)
+{
+  vtkSMPropertyHelper points(proxy, "Points");
+  if (vtkSMPropertyHelper(proxy, "Closed").GetAsInt() != ExpectedClosed(numberOfSets))
+  {
+    cerr << "ERROR: wrong Closed after " << numberOfSets << " sets." << endl;
+    return false;
+  }
+  if (points.GetNumberOfElements() != 3 * NumberOfPoints ||
+    points.GetAsDouble(0) != ExpectedOffset(numberOfSets) ||
+    points.GetAsDouble(3 * NumberOfPoints - 1) !=
+      ExpectedOffset(numberOfSets) + 0.25 * (3 * NumberOfPoints - 1))
+  {
+    cerr << "ERROR: wrong Points after " << numberOfSets << " sets." << endl;
+    return false;
+  }
+  return true;
+}
+
+// Bytes the states of the undo sets would use as plain messages.
+vtkIdType GetMessagesSize(vtkSMUndoStack* stack)
+{
+  vtkIdType size = 0;
+  while (stack->CanUndo())
+  {
+    stack->PopUndoStack();
+  }
+  // Every set is now on the redo stack, the next one is the oldest.
+  for (unsigned int cc = 0, max = stack->GetNumberOfRedoSets(); cc < max; ++cc)
+  {
+    vtkUndoSet* set = stack->GetNextRedoSet();
+    for (int i = 0; i < set->GetNumberOfElements(); ++i)
+    {
+      vtkSMRemoteObjectUpdateUndoElement* elem =
+        vtkSMRemoteObjectUpdateUndoElement::SafeDownCast(set->GetElement(i));
+      vtkSMMessage state;
+      if (elem && elem->GetBeforeState(&state))
+      {
+        size += state.ByteSize();
+      }
+      if (elem && elem->GetAfterState(&state))
+      {
+        size += state.ByteSize();
+      }
+    }
+    stack->PopRedoStack();
+  }
+  return size;
+}
+
+// Pushes one set per offset, each setting the points.
+void PushPoints(vtkSMProxy* proxy, vtkSMUndoStackBuilder* builder, double first, double last)
+{
+  for (double offset = first; offset <= last; ++offset)
+  {
+    builder->Begin("Change");
+    vtkSMPropertyHelper(proxy, "Points").Set(&MakePoints(offset)[0], 3 * NumberOfPoints);
+    proxy->UpdateVTKObjects();
+    builder->EndAndPushToStack();
+  }
+}
+
+bool TestStack(vtkSMSessionProxyManager* pxm, vtkSMUndoStackBuilder* builder, bool benchmark)
+{
+  vtkNew<vtkSMUndoStack> stack;
+  stack->SetStackDepth(100);
+  builder->SetUndoStack(stack);
+
+  vtkSmartPointer<vtkSMProxy> proxy;
+  proxy.TakeReference(pxm->NewProxy("sources", "PolyLineSource"));
+  vtkSMPropertyHelper(proxy, "Points").Set(&MakePoints(0.0)[0], 3 * NumberOfPoints);
+  vtkSMPropertyHelper(proxy, "Closed").Set(0);
+  proxy->UpdateVTKObjects();
+
+  // each set toggles Closed three times; one of them also changes the points.
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  for (int cc = 0; cc < NumberOfSets; ++cc)
+  {
+    builder->Begin("Change");
+    for (int toggle = 0; toggle < 3; ++toggle)
+    {
+      vtkSMPropertyHelper(proxy, "Closed").Set((cc + toggle + 1) % 2);
+      proxy->UpdateVTKObjects();
+    }
+    if (cc == ChangedPointsSet)
+    {
+      vtkSMPropertyHelper(proxy, "Points").Set(&MakePoints(1.0)[0], 3 * NumberOfPoints);
+      proxy->UpdateVTKObjects();
+    }
+    builder->End();
+    builder->PushToStack();
+    if (stack->GetNextUndoSet()->GetNumberOfElements() != 1)
+    {
+      cerr << "ERROR: set " << cc << " has " << stack->GetNextUndoSet()->GetNumberOfElements()
+           << " elements instead of 1." << endl;
+      return false;
+    }
+  }
+  timer->StopTimer();
+  const double pushTime = timer->GetElapsedTime();
+  if (static_cast<int>(stack->GetNumberOfUndoSets()) != NumberOfSets)
+  {
+    cerr << "ERROR: sets missing." << endl;
+    return false;
+  }
+  if (!CheckValues(proxy, NumberOfSets))
+  {
+    return false;
+  }
+
+  // undo everything, then redo everything.
+  double undoTime = 0.0;
+  double redoTime = 0.0;
+  for (int cc = NumberOfSets - 1; cc >= 0; --cc)
+  {
+    timer->StartTimer();
+    const int status = stack->Undo();
+    proxy->UpdateVTKObjects();
+    timer->StopTimer();
+    undoTime += timer->GetElapsedTime();
+    if (!status)
+    {
+      cerr << "ERROR: undo failed." << endl;
+      return false;
+    }
+    if (!CheckValues(proxy, cc))
+    {
+      return false;
+    }
+  }
+  for (int cc = 1; cc <= NumberOfSets; ++cc)
+  {
+    timer->StartTimer();
+    const int status = stack->Redo();
+    proxy->UpdateVTKObjects();
+    timer->StopTimer();
+    redoTime += timer->GetElapsedTime();
+    if (!status)
+    {
+      cerr << "ERROR: redo failed." << endl;
+      return false;
+    }
+    if (!CheckValues(proxy, cc))
+    {
+      return false;
+    }
+  }
+
+  // the points only differ in two blocks, shared by all the states.
+  const vtkIdType memorySize = stack->GetMemorySize();
+  const vtkIdType messagesSize = GetMessagesSize(stack);
+  if (benchmark)
+  {
+    cout << NumberOfSets << " sets of " << NumberOfPoints << " points: " << memorySize
+         << " bytes instead of " << messagesSize << ", push " << pushTime << " s, undo "
+         << undoTime / NumberOfSets << " s, redo " << redoTime / NumberOfSets << " s per set"
+         << endl;
+  }
+  if (memorySize * 4 >= messagesSize)
+  {
+    cerr << "ERROR: states are not shared." << endl;
+    return false;
+  }
+  if (stack->GetMemorySize() != memorySize)
+  {
+    cerr << "ERROR: size changed by undo and redo." << endl;
+    return false;
+  }
+
+  // the oldest sets are dropped once the limit is reached; the last set,
+  // which is larger than the limit, is kept.
+  stack->SetMemoryLimit(memorySize);
+  builder->Begin("Change");
+  vtkSMPropertyHelper(proxy, "Points").Set(&MakePoints(2.0)[0], 3 * NumberOfPoints);
+  proxy->UpdateVTKObjects();
+  builder->EndAndPushToStack();
+  if (stack->GetNumberOfUndoSets() == 0 ||
+    static_cast<int>(stack->GetNumberOfUndoSets()) > ChangedPointsSet + 1)
+  {
+    cerr << "ERROR: wrong number of sets kept: " << stack->GetNumberOfUndoSets() << endl;
+    return false;
+  }
+  if (stack->GetMemorySize() > memorySize)
+  {
+    cerr << "ERROR: stack larger than its limit." << endl;
+    return false;
+  }
+  stack->SetMemoryLimit(1);
+  builder->Begin("Change");
+  vtkSMPropertyHelper(proxy, "Closed").Set(1);
+  proxy->UpdateVTKObjects();
+  builder->EndAndPushToStack();
+  if (stack->GetNumberOfUndoSets() != 1)
+  {
+    cerr << "ERROR: the last set was dropped." << endl;
+    return false;
+  }
+  if (!stack->Undo() || vtkSMPropertyHelper(proxy, "Closed").GetAsInt() != 0)
+  {
+    cerr << "ERROR: undo failed after dropping sets." << endl;
+    return false;
+  }
+  stack->Clear();
+  if (stack->GetMemorySize() != 0)
+  {
+    cerr << "ERROR: memory still used after clearing the stack." << endl;
+    return false;
+  }
+
+  // a set beyond the stack depth releases the points only it used: the
+  // stack then holds the same points as one that never had that set.
+  stack->SetMemoryLimit(0);
+  stack->SetStackDepth(2);
+  PushPoints(proxy, builder, 3.0, 5.0);
+  const vtkIdType depthSize = stack->GetMemorySize();
+  stack->Clear();
+  PushPoints(proxy, builder, 3.0, 4.0);
+  if (stack->GetNumberOfUndoSets() != 2 || stack->GetMemorySize() != depthSize)
+  {
+    cerr << "ERROR: the set beyond the stack depth still uses memory: " << depthSize
+         << " bytes instead of " << stack->GetMemorySize() << endl;
+    return false;
+  }
+
+  builder->SetUndoStack(nullptr);
+  return true;
+}
+}
+
+int TestUndoStackMemory(int argc, char* argv[])
+{
+  bool benchmark = false;
+  vtksys::CommandLineArguments arg;
+  arg.Initialize(argc, argv);
+  arg.AddBooleanArgument("--benchmark", &benchmark, "Report the push, undo and redo times.");
+  arg.StoreUnusedArguments(true);
+  if (!arg.Parse())
+  {
+    cerr << "ERROR: Problem parsing arguments." << endl;
+    return EXIT_FAILURE;
+  }
+
+  vtkInitializationHelper::Initialize(argv[0], vtkProcessModule::PROCESS_CLIENT);
+
+  bool success;
+  {
+    vtkNew<vtkSMSession> session;
+    vtkNew<vtkSMUndoStackBuilder> builder;
+    vtkSMProxyManager::GetProxyManager()->SetUndoStackBuilder(builder);
+    success = TestStack(session->GetSessionProxyManager(), builder, benchmark);
+    vtkSMProxyManager::GetProxyManager()->SetUndoStackBuilder(nullptr);
+  }
+
+  vtkInitializationHelper::Finalize();
+  return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
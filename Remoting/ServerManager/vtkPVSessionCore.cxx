@@ -29,6 +29,7 @@
 #include "vtkPVOptions.h"
 #include "vtkPVSession.h"
 #include "vtkPVSessionCoreInterpreterHelper.h"
+#include "vtkPVTraceRecorder.h"
 #include "vtkProcessModule.h"
 #include "vtkReservedRemoteObjectIds.h"
 #include "vtkSIProxy.h"
@@ -403,6 +404,7 @@ void vtkPVSessionCore::PushStateInternal(vtkSMMessage* message)
       << "----------------------------------------------------------------\n"
       << message->DebugString().c_str());
 
+  vtkPVTraceScope traceScope(vtkPVTraceRecorder::RMI, "PushState");
   vtkTypeUInt32 globalId = message->global_id();
 
   // Standard management of SIObject ---------------------------------------
@@ -630,6 +632,7 @@ void vtkPVSessionCore::ExecuteStreamInternal(
       << stream.StreamToString()
       << "----------------------------------------------------------------\n");
 
+  vtkPVTraceScope traceScope(vtkPVTraceRecorder::RMI, "ExecuteStream");
   this->Interpreter->ClearLastResult();
 
   int temp = this->Interpreter->GetGlobalWarningDisplay();
@@ -779,6 +782,7 @@ void vtkPVSessionCore::RegisterSIObjectInternal(vtkSMMessage* message)
 bool vtkPVSessionCore::GatherInformationInternal(
   vtkPVInformation* information, vtkTypeUInt32 globalid)
 {
+  vtkPVTraceScope traceScope(vtkPVTraceRecorder::RMI, "GatherInformation");
   if (globalid == 0)
   {
     information->CopyFromObject(NULL);
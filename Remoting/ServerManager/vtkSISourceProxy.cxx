@@ -27,6 +27,7 @@
 #include "vtkPVCompositeDataPipeline.h"
 #include "vtkPVLogger.h"
 #include "vtkPVPostFilter.h"
+#include "vtkPVTraceRecorder.h"
 #include "vtkPVXMLElement.h"
 #include "vtkPolyData.h"
 #include "vtkProcessModule.h"
@@ -301,6 +302,11 @@ void vtkSISourceProxy::MarkStartEvent()
     std::ostringstream filterName;
     filterName << "Execute " << this->GetLogNameOrDefault() << " id: " << this->GetGlobalID();
     vtkTimerLog::MarkStartEvent(filterName.str().c_str());
+    if (vtkPVTraceRecorder::IsEnabled())
+    {
+      vtkPVTraceRecorder::Record(
+        vtkPVTraceRecorder::PIPELINE, vtkPVTraceRecorder::BEGIN, filterName.str());
+    }
 
     vtkVLogStartScopeF(PARAVIEW_LOG_EXECUTION_VERBOSITY(), vtkLogIdentifier(this), "%s: execute",
       this->GetLogNameOrDefault());
@@ -317,6 +323,11 @@ void vtkSISourceProxy::MarkEndEvent()
     std::ostringstream filterName;
     filterName << "Execute " << this->GetLogNameOrDefault() << " id: " << this->GetGlobalID();
     vtkTimerLog::MarkEndEvent(filterName.str().c_str());
+    if (vtkPVTraceRecorder::IsEnabled())
+    {
+      vtkPVTraceRecorder::Record(
+        vtkPVTraceRecorder::PIPELINE, vtkPVTraceRecorder::END, filterName.str());
+    }
   }
 }
 
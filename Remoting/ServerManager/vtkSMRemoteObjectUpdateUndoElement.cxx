@@ -26,6 +26,134 @@
 
 #include <vtkNew.h>
 
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace
+{
+typedef std::shared_ptr<const std::string> BlockType;
+
+// Serialized properties, shared by all the undo elements. A block is freed
+// once no state uses it anymore.
+class vtkBlockPool
+{
+public:
+  BlockType Intern(std::string&& block)
+  {
+    const size_t hash = std::hash<std::string>()(block);
+    std::lock_guard<std::mutex> lock(this->Mutex);
+    auto range = this->Blocks.equal_range(hash);
+    for (auto iter = range.first; iter != range.second; ++iter)
+    {
+      BlockType shared = iter->second.lock();
+      if (shared && *shared == block)
+      {
+        return shared;
+      }
+    }
+    if (this->Blocks.size() >= this->SweepSize)
+    {
+      this->Sweep();
+    }
+    BlockType shared = std::make_shared<const std::string>(std::move(block));
+    this->Blocks.emplace(hash, shared);
+    return shared;
+  }
+
+private:
+  // Forget the blocks that were freed.
+  void Sweep()
+  {
+    for (auto iter = this->Blocks.begin(); iter != this->Blocks.end();)
+    {
+      iter = iter->second.expired() ? this->Blocks.erase(iter) : std::next(iter);
+    }
+    this->SweepSize = std::max<size_t>(1024, 2 * this->Blocks.size());
+  }
+
+  std::mutex Mutex;
+  std::unordered_multimap<size_t, std::weak_ptr<const std::string> > Blocks;
+  size_t SweepSize = 1024;
+};
+
+vtkBlockPool& GetBlockPool()
+{
+  static vtkBlockPool pool;
+  return pool;
+}
+
+// A vtkSMMessage serialized without its properties, followed by the shared
+// blocks of its properties.
+struct vtkCompactState
+{
+  bool Valid = false;
+  std::string Header;
+  std::vector<BlockType> Properties;
+
+  void Encode(const vtkSMMessage& state)
+  {
+    vtkSMMessage header;
+    header.CopyFrom(state);
+    header.ClearExtension(ProxyState::property);
+    this->Header = header.SerializePartialAsString();
+
+    const int size = state.ExtensionSize(ProxyState::property);
+    this->Properties.clear();
+    this->Properties.reserve(size);
+    for (int cc = 0; cc < size; ++cc)
+    {
+      this->Properties.push_back(GetBlockPool().Intern(
+        state.GetExtension(ProxyState::property, cc).SerializePartialAsString()));
+    }
+    this->Valid = true;
+  }
+
+  bool Decode(vtkSMMessage* state) const
+  {
+    state->Clear();
+    if (!this->Valid || !state->ParsePartialFromString(this->Header))
+    {
+      return false;
+    }
+    for (const BlockType& block : this->Properties)
+    {
+      state->AddExtension(ProxyState::property)->ParsePartialFromString(*block);
+    }
+    return true;
+  }
+
+  void Clear()
+  {
+    this->Valid = false;
+    this->Header.clear();
+    this->Properties.clear();
+  }
+
+  bool operator==(const vtkCompactState& other) const
+  {
+    // blocks are shared, so equal blocks have the same address.
+    return this->Valid == other.Valid && this->Header == other.Header &&
+      this->Properties == other.Properties;
+  }
+};
+}
+
+//*****************************************************************************
+class vtkSMRemoteObjectUpdateUndoElement::vtkInternals
+{
+public:
+  vtkTypeUInt32 GlobalId = 0;
+  vtkCompactState BeforeState;
+  vtkCompactState AfterState;
+};
+
+//*****************************************************************************
 vtkStandardNewMacro(vtkSMRemoteObjectUpdateUndoElement);
 vtkSetObjectImplementationMacro(
   vtkSMRemoteObjectUpdateUndoElement, ProxyLocator, vtkSMProxyLocator);
@@ -33,17 +161,15 @@ vtkSetObjectImplementationMacro(
 vtkSMRemoteObjectUpdateUndoElement::vtkSMRemoteObjectUpdateUndoElement()
 {
   this->ProxyLocator = NULL;
-  this->AfterState = new vtkSMMessage();
-  this->BeforeState = new vtkSMMessage();
+  this->Internals = new vtkInternals();
+  this->SetMergeable(true);
 }
 
 //-----------------------------------------------------------------------------
 vtkSMRemoteObjectUpdateUndoElement::~vtkSMRemoteObjectUpdateUndoElement()
 {
-  delete this->AfterState;
-  delete this->BeforeState;
-  this->AfterState = NULL;
-  this->BeforeState = NULL;
+  delete this->Internals;
+  this->Internals = NULL;
 
   this->SetProxyLocator(NULL);
 }
@@ -53,23 +179,26 @@ void vtkSMRemoteObjectUpdateUndoElement::PrintSelf(ostream& os, vtkIndent indent
 {
   this->Superclass::PrintSelf(os, indent);
   os << indent << "GlobalId: " << this->GetGlobalId() << endl;
+  vtkSMMessage state;
   os << indent << "Before state: " << endl;
-  if (this->BeforeState)
-    this->BeforeState->PrintDebugString();
+  if (this->GetBeforeState(&state))
+    os << state.DebugString().c_str();
   os << indent << "After state: " << endl;
-  if (this->AfterState)
-    this->AfterState->PrintDebugString();
+  if (this->GetAfterState(&state))
+    os << state.DebugString().c_str();
 }
 //-----------------------------------------------------------------------------
 int vtkSMRemoteObjectUpdateUndoElement::Undo()
 {
-  return this->UpdateState(this->BeforeState);
+  vtkSMMessage state;
+  return this->GetBeforeState(&state) ? this->UpdateState(&state) : 1;
 }
 
 //-----------------------------------------------------------------------------
 int vtkSMRemoteObjectUpdateUndoElement::Redo()
 {
-  return this->UpdateState(this->AfterState);
+  vtkSMMessage state;
+  return this->GetAfterState(&state) ? this->UpdateState(&state) : 1;
 }
 
 //-----------------------------------------------------------------------------
@@ -105,12 +234,14 @@ int vtkSMRemoteObjectUpdateUndoElement::UpdateState(const vtkSMMessage* state)
 void vtkSMRemoteObjectUpdateUndoElement::SetUndoRedoState(
   const vtkSMMessage* before, const vtkSMMessage* after)
 {
-  this->BeforeState->Clear();
-  this->AfterState->Clear();
+  this->Internals->GlobalId = 0;
+  this->Internals->BeforeState.Clear();
+  this->Internals->AfterState.Clear();
   if (before && after)
   {
-    this->BeforeState->CopyFrom(*before);
-    this->AfterState->CopyFrom(*after);
+    this->Internals->GlobalId = static_cast<vtkTypeUInt32>(before->global_id());
+    this->Internals->BeforeState.Encode(*before);
+    this->Internals->AfterState.Encode(*after);
   }
   else
   {
@@ -118,8 +249,50 @@ void vtkSMRemoteObjectUpdateUndoElement::SetUndoRedoState(
       << "At least one of the provided states is NULL.");
   }
 }
+
+//-----------------------------------------------------------------------------
+bool vtkSMRemoteObjectUpdateUndoElement::GetBeforeState(vtkSMMessage* state)
+{
+  return state && this->Internals->BeforeState.Decode(state);
+}
+
+//-----------------------------------------------------------------------------
+bool vtkSMRemoteObjectUpdateUndoElement::GetAfterState(vtkSMMessage* state)
+{
+  return state && this->Internals->AfterState.Decode(state);
+}
+
 //-----------------------------------------------------------------------------
 vtkTypeUInt32 vtkSMRemoteObjectUpdateUndoElement::GetGlobalId()
 {
-  return this->BeforeState->global_id();
+  return this->Internals->GlobalId;
+}
+
+//-----------------------------------------------------------------------------
+bool vtkSMRemoteObjectUpdateUndoElement::Merge(vtkUndoElement* new_element)
+{
+  vtkSMRemoteObjectUpdateUndoElement* other =
+    vtkSMRemoteObjectUpdateUndoElement::SafeDownCast(new_element);
+  if (!other || this->Session != other->Session || this->ProxyLocator != other->ProxyLocator ||
+    !this->Internals->AfterState.Valid || this->GetGlobalId() != other->GetGlobalId() ||
+    !(this->Internals->AfterState == other->Internals->BeforeState))
+  {
+    return false;
+  }
+  this->Internals->AfterState = other->Internals->AfterState;
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+void vtkSMRemoteObjectUpdateUndoElement::GetStateBlocks(std::map<const void*, size_t>& blocks)
+{
+  for (const vtkCompactState* state : { &this->Internals->BeforeState,
+         &this->Internals->AfterState })
+  {
+    blocks[&state->Header] = state->Header.size();
+    for (const BlockType& block : state->Properties)
+    {
+      blocks[block.get()] = block->size();
+    }
+  }
 }
@@ -19,6 +19,14 @@
  * This class keeps the before and after state of the RemoteObject in the
  * vtkSMMessage form. It works with any proxy and RemoteObject. It is a very
  * generic undoElement.
+ *
+ * The states are kept serialized. Each property of a proxy state is stored
+ * as its own buffer, and buffers with the same content are shared by all the
+ * elements, so that the properties a change leaves untouched cost nothing in
+ * either state nor in the following undo sets.
+ *
+ * Consecutive elements of an undo set that update the same remote object
+ * are merged, so that the object loads a single state on undo or redo.
 */
 
 #ifndef vtkSMRemoteObjectUpdateUndoElement_h
@@ -29,6 +37,9 @@
 #include "vtkSMUndoElement.h"
 #include "vtkWeakPointer.h" //  needed for vtkWeakPointer.
 
+#include <cstddef> // for size_t
+#include <map>     // for std::map
+
 class vtkSMProxyLocator;
 
 class VTKREMOTINGSERVERMANAGER_EXPORT vtkSMRemoteObjectUpdateUndoElement : public vtkSMUndoElement
@@ -60,12 +71,31 @@ public:
    */
   virtual void SetUndoRedoState(const vtkSMMessage* before, const vtkSMMessage* after);
 
-  // Current full state of the UndoElement
-  vtkSMMessage* BeforeState;
-  vtkSMMessage* AfterState;
+  //@{
+  /**
+   * Decode the state of the RemoteObject before or after the change into
+   * `state`. Returns false if no state was set.
+   */
+  bool GetBeforeState(vtkSMMessage* state);
+  bool GetAfterState(vtkSMMessage* state);
+  //@}
 
   virtual vtkTypeUInt32 GetGlobalId();
 
+  /**
+   * Merge `new_element` if it updates the same RemoteObject from the state
+   * this element leaves it in. This element then goes from its before state
+   * to the after state of `new_element`.
+   */
+  bool Merge(vtkUndoElement* new_element) override;
+
+  /**
+   * Add the address and size of the buffers holding the states to `blocks`.
+   * Buffers shared with other elements have the same address, so that the
+   * sizes in `blocks` add up to the memory used by all the elements given.
+   */
+  void GetStateBlocks(std::map<const void*, size_t>& blocks);
+
 protected:
   vtkSMRemoteObjectUpdateUndoElement();
   ~vtkSMRemoteObjectUpdateUndoElement() override;
@@ -78,6 +108,9 @@ protected:
 private:
   vtkSMRemoteObjectUpdateUndoElement(const vtkSMRemoteObjectUpdateUndoElement&) = delete;
   void operator=(const vtkSMRemoteObjectUpdateUndoElement&) = delete;
+
+  class vtkInternals;
+  vtkInternals* Internals;
 };
 
 #endif
@@ -1217,24 +1217,25 @@ int vtkSMSessionProxyManager::AreProxiesModified()
 }
 
 //---------------------------------------------------------------------------
-void vtkSMSessionProxyManager::LoadXMLState(
+bool vtkSMSessionProxyManager::LoadXMLState(
   const char* filename, vtkSMStateLoader* loader /*=NULL*/)
 {
   vtkPVXMLParser* parser = vtkPVXMLParser::New();
   parser->SetFileName(filename);
   parser->Parse();
 
-  this->LoadXMLState(parser->GetRootElement(), loader);
+  bool loaded = this->LoadXMLState(parser->GetRootElement(), loader);
   parser->Delete();
+  return loaded;
 }
 
 //---------------------------------------------------------------------------
-void vtkSMSessionProxyManager::LoadXMLState(
+bool vtkSMSessionProxyManager::LoadXMLState(
   vtkPVXMLElement* rootElement, vtkSMStateLoader* loader /*=NULL*/, bool keepOriginalIds /*=false*/)
 {
   if (!rootElement)
   {
-    return;
+    return false;
   }
 
   bool prev = this->InLoadXMLState;
@@ -1249,7 +1250,8 @@ void vtkSMSessionProxyManager::LoadXMLState(
   {
     spLoader = loader;
   }
-  if (spLoader->LoadState(rootElement, keepOriginalIds))
+  bool loaded = spLoader->LoadState(rootElement, keepOriginalIds) != 0;
+  if (loaded)
   {
     vtkSMProxyManager::LoadStateInformation info;
     info.RootElement = rootElement;
@@ -1257,6 +1259,7 @@ void vtkSMSessionProxyManager::LoadXMLState(
     this->InvokeEvent(vtkCommand::LoadStateEvent, &info);
   }
   this->InLoadXMLState = prev;
+  return loaded;
 }
 
 //---------------------------------------------------------------------------
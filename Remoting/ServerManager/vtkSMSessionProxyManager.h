@@ -414,10 +414,10 @@ public:
    * Loads the state of the server manager from XML.
    * If loader is not specified, a vtkSMStateLoader instance is used.
    * When loading XML state, `vtkSMSessionProxyManager::GetInLoadXMLState` will
-   * return true.
+   * return true. Returns false if the state could not be loaded.
    */
-  void LoadXMLState(const char* filename, vtkSMStateLoader* loader = NULL);
-  void LoadXMLState(
+  bool LoadXMLState(const char* filename, vtkSMStateLoader* loader = NULL);
+  bool LoadXMLState(
     vtkPVXMLElement* rootElement, vtkSMStateLoader* loader = NULL, bool keepOriginalIds = false);
   //@}
 
@@ -32,6 +32,7 @@
 #include "vtkUndoStackInternal.h"
 
 #include "vtkNew.h"
+#include <map>
 #include <set>
 #include <vtksys/RegularExpression.hxx>
 
@@ -64,13 +65,10 @@ public:
       if (elem)
       {
         elem->SetProxyLocator(this->UndoSetProxyLocator.GetPointer());
-        if (useBeforeState)
+        vtkSMMessage state;
+        if (useBeforeState ? elem->GetBeforeState(&state) : elem->GetAfterState(&state))
         {
-          this->UndoSetStateLocator->RegisterState(elem->BeforeState);
-        }
-        else
-        {
-          this->UndoSetStateLocator->RegisterState(elem->AfterState);
+          this->UndoSetStateLocator->RegisterState(&state);
         }
       }
     }
@@ -123,6 +121,76 @@ public:
       iter++;
     }
   }
+
+  // The state blocks of each undo set of the stacks, the number of sets
+  // using each block, and the total size of the blocks, kept updated as sets
+  // are pushed and dropped.
+  typedef std::map<const void*, size_t> BlocksType;
+  std::map<vtkUndoSet*, std::pair<vtkSmartPointer<vtkUndoSet>, BlocksType> > SetBlocks;
+  std::map<const void*, int> BlockUses;
+  vtkIdType MemorySize = 0;
+
+  void AddSet(vtkUndoSet* set)
+  {
+    if (this->SetBlocks.find(set) != this->SetBlocks.end())
+    {
+      return;
+    }
+    auto& setBlocks = this->SetBlocks[set];
+    setBlocks.first = set;
+    for (int cc = 0, max = set->GetNumberOfElements(); cc < max; ++cc)
+    {
+      vtkSMRemoteObjectUpdateUndoElement* elem =
+        vtkSMRemoteObjectUpdateUndoElement::SafeDownCast(set->GetElement(cc));
+      if (elem)
+      {
+        elem->GetStateBlocks(setBlocks.second);
+      }
+    }
+    for (const auto& block : setBlocks.second)
+    {
+      if (this->BlockUses[block.first]++ == 0)
+      {
+        this->MemorySize += static_cast<vtkIdType>(block.second);
+      }
+    }
+  }
+
+  void RemoveSet(vtkUndoSet* set)
+  {
+    auto iter = this->SetBlocks.find(set);
+    if (iter == this->SetBlocks.end())
+    {
+      return;
+    }
+    for (const auto& block : iter->second.second)
+    {
+      auto uses = this->BlockUses.find(block.first);
+      if (--uses->second == 0)
+      {
+        this->MemorySize -= static_cast<vtkIdType>(block.second);
+        this->BlockUses.erase(uses);
+      }
+    }
+    this->SetBlocks.erase(iter);
+  }
+
+  // Sets removed from the bottom of the undo stack, beyond the stack depth
+  // or the memory limit, come as call data.
+  void CallBackUndoStack(vtkObject* vtkNotUsed(src), unsigned long event, void* data)
+  {
+    switch (event)
+    {
+      case vtkUndoStack::UndoSetRemovedEvent:
+        this->RemoveSet(static_cast<vtkUndoSet*>(data));
+        break;
+      case vtkUndoStack::UndoSetClearedEvent:
+        this->SetBlocks.clear();
+        this->BlockUses.clear();
+        this->MemorySize = 0;
+        break;
+    }
+  }
 };
 //*****************************************************************************
 vtkStandardNewMacro(vtkSMUndoStack);
@@ -130,6 +198,11 @@ vtkStandardNewMacro(vtkSMUndoStack);
 vtkSMUndoStack::vtkSMUndoStack()
 {
   this->Internal = new vtkInternal();
+  this->MemoryLimit = 0;
+  this->AddObserver(vtkUndoStack::UndoSetRemovedEvent, this->Internal,
+    &vtkSMUndoStack::vtkInternal::CallBackUndoStack);
+  this->AddObserver(vtkUndoStack::UndoSetClearedEvent, this->Internal,
+    &vtkSMUndoStack::vtkInternal::CallBackUndoStack);
 }
 
 //-----------------------------------------------------------------------------
@@ -142,10 +215,39 @@ vtkSMUndoStack::~vtkSMUndoStack()
 //-----------------------------------------------------------------------------
 void vtkSMUndoStack::Push(const char* label, vtkUndoSet* changeSet)
 {
+  // The push clears the redo stack without an event.
+  for (const auto& elem : this->vtkUndoStack::Internal->RedoStack)
+  {
+    this->Internal->RemoveSet(elem.UndoSet);
+  }
   this->Superclass::Push(label, changeSet);
+
+  // The stack holds a copy of changeSet.
+  vtkUndoStackInternal::VectorOfElements& undoStack = this->vtkUndoStack::Internal->UndoStack;
+  this->Internal->AddSet(undoStack.back().UndoSet);
+  bool removed = false;
+  while (this->MemoryLimit > 0 && undoStack.size() > 1 &&
+    this->Internal->MemorySize > this->MemoryLimit)
+  {
+    vtkSmartPointer<vtkUndoSet> set = undoStack.begin()->UndoSet;
+    undoStack.erase(undoStack.begin());
+    this->InvokeEvent(vtkUndoStack::UndoSetRemovedEvent, set.GetPointer());
+    removed = true;
+  }
+  if (removed)
+  {
+    this->Modified();
+  }
+
   this->InvokeEvent(PushUndoSetEvent, changeSet);
 }
 
+//-----------------------------------------------------------------------------
+vtkIdType vtkSMUndoStack::GetMemorySize()
+{
+  return this->Internal->MemorySize;
+}
+
 //-----------------------------------------------------------------------------
 int vtkSMUndoStack::Undo()
 {
@@ -200,4 +302,5 @@ void vtkSMUndoStack::FillWithRemoteObjects(vtkUndoSet* undoSet, vtkCollection* c
 void vtkSMUndoStack::PrintSelf(ostream& os, vtkIndent indent)
 {
   this->Superclass::PrintSelf(os, indent);
+  os << indent << "MemoryLimit: " << this->MemoryLimit << endl;
 }
@@ -29,6 +29,10 @@
  * server. GUI can use this to push its own changes that is undoable across
  * connections.
  *
+ * Besides the stack depth, the memory used by the stack can be bounded with
+ * SetMemoryLimit(): the oldest undo sets are then dropped as soon as the
+ * states kept by the stack exceed the limit.
+ *
  * @sa
  * vtkSMUndoStackBuilder
 */
@@ -75,6 +79,23 @@ public:
    */
   int Redo() override;
 
+  //@{
+  /**
+   * Get/Set the maximum number of bytes used by the states of the undo and
+   * redo sets. When a set pushed makes the stack exceed this limit, the
+   * oldest undo sets are removed, keeping at least the set pushed.
+   * 0 means no limit, which is the default.
+   */
+  vtkSetClampMacro(MemoryLimit, vtkIdType, 0, VTK_ID_MAX);
+  vtkGetMacro(MemoryLimit, vtkIdType);
+  //@}
+
+  /**
+   * Returns the number of bytes used by the states of the undo and redo sets.
+   * States shared by several sets are counted once.
+   */
+  vtkIdType GetMemorySize();
+
   enum EventIds
   {
     PushUndoSetEvent = 1987,
@@ -95,6 +116,8 @@ protected:
   // is supposed to happen.
   void FillWithRemoteObjects(vtkUndoSet* undoSet, vtkCollection* collection);
 
+  vtkIdType MemoryLimit;
+
 private:
   vtkSMUndoStack(const vtkSMUndoStack&) = delete;
   void operator=(const vtkSMUndoStack&) = delete;
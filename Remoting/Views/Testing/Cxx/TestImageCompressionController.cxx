@@ -0,0 +1,239 @@
+/*=========================================================================
+
+Program:   ParaView
+Module:    TestImageCompressionController.cxx
+
+Copyright (c) Kitware, Inc.
+All rights reserved.
+See Copyright.txt or http://www.paraview.org/HTML/Copyright.html for details.
+
+This software is distributed WITHOUT ANY WARRANTY; without even
+the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// Sends images at every vtkPVImageCompressionController level through
+// vtkPVClientServerSynchronizedRenderers, between two vtkSocketControllers
+// connected over localhost. Checks that loss-less levels round trip exactly
+// and that the transfer time recorded by the server covers the time the
+// client took to receive the image. Also checks the levels the controller
+// selects for given encoding and link measurements.
+
+#include "vtkClientSocket.h"
+#include "vtkNew.h"
+#include "vtkObjectFactory.h"
+#include "vtkPVClientServerSynchronizedRenderers.h"
+#include "vtkPVImageCompressionController.h"
+#include "vtkServerSocket.h"
+#include "vtkSmartPointer.h"
+#include "vtkSocketCommunicator.h"
+#include "vtkSocketController.h"
+#include "vtkUnsignedCharArray.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+namespace
+{
+// Gives access to the image delivery of vtkPVClientServerSynchronizedRenderers.
+class ImageDelivery : public vtkPVClientServerSynchronizedRenderers
+{
+public:
+  static ImageDelivery* New();
+  vtkTypeMacro(ImageDelivery, vtkPVClientServerSynchronizedRenderers);
+
+  using vtkPVClientServerSynchronizedRenderers::ReceiveImage;
+  using vtkPVClientServerSynchronizedRenderers::SendImage;
+};
+vtkStandardNewMacro(ImageDelivery);
+
+// Connects `server` and `client` over localhost.
+bool Connect(vtkSocketController* server, vtkSocketController* client)
+{
+  vtkNew<vtkServerSocket> socket;
+  if (socket->CreateServer(0) != 0)
+  {
+    return false;
+  }
+  bool accepted = false;
+  std::thread accept([&]() {
+    vtkClientSocket* clientSocket = socket->WaitForConnection(10000);
+    auto comm = vtkSocketCommunicator::SafeDownCast(server->GetCommunicator());
+    if (clientSocket && comm)
+    {
+      comm->SetSocket(clientSocket);
+      accepted = comm->ServerSideHandshake() != 0;
+    }
+    if (clientSocket)
+    {
+      clientSocket->Delete();
+    }
+  });
+  const bool connected = client->ConnectTo("localhost", socket->GetServerPort()) != 0;
+  accept.join();
+  return accepted && connected;
+}
+
+vtkSmartPointer<vtkUnsignedCharArray> MakeImage(int width, int height, int frame)
+{
+  vtkSmartPointer<vtkUnsignedCharArray> image = vtkSmartPointer<vtkUnsignedCharArray>::New();
+  image->SetNumberOfComponents(4);
+  image->SetNumberOfTuples(static_cast<vtkIdType>(width) * height);
+  unsigned char* ptr = image->GetPointer(0);
+  for (int y = 0; y < height; ++y)
+  {
+    for (int x = 0; x < width; ++x, ptr += 4)
+    {
+      // background gradient with a moving disk, roughly what a render of a
+      // shaded object looks like to the compressors.
+      const int dx = x - (width / 2 + frame * 3);
+      const int dy = y - height / 2;
+      const bool inside = dx * dx + dy * dy < (width * width) / 16;
+      ptr[0] = static_cast<unsigned char>(inside ? 200 - (dx + dy) / 4 : x * 255 / width);
+      ptr[1] = static_cast<unsigned char>(inside ? 120 + (dx * dy) % 17 : y * 255 / height);
+      ptr[2] = static_cast<unsigned char>(inside ? 40 : 128);
+      ptr[3] = 255;
+    }
+  }
+  return image;
+}
+
+// Sends `image` from `server` to `client` at `level`. The client starts
+// receiving `delay` after the server starts sending.
+vtkSmartPointer<vtkUnsignedCharArray> Deliver(ImageDelivery* server, ImageDelivery* client,
+  vtkUnsignedCharArray* image, int width, int height, int level, std::chrono::milliseconds delay)
+{
+  std::atomic<bool> sending(false);
+  std::thread send([&]() {
+    sending = true;
+    server->SendImage(image, width, height, level);
+  });
+  while (!sending)
+  {
+    std::this_thread::yield();
+  }
+  std::this_thread::sleep_for(delay);
+
+  vtkSmartPointer<vtkUnsignedCharArray> received = vtkSmartPointer<vtkUnsignedCharArray>::New();
+  received->SetNumberOfComponents(4);
+  received->SetNumberOfTuples(image->GetNumberOfTuples());
+  client->ReceiveImage(received, width, height, level);
+  send.join();
+  return received;
+}
+
+bool TestDelivery()
+{
+  vtkNew<vtkSocketController> serverController;
+  vtkNew<vtkSocketController> clientController;
+  if (!Connect(serverController, clientController))
+  {
+    cerr << "ERROR: could not connect the socket controllers." << endl;
+    return false;
+  }
+
+  vtkNew<ImageDelivery> server;
+  vtkNew<ImageDelivery> client;
+  server->SetParallelController(serverController);
+  client->SetParallelController(clientController);
+  server->AdaptiveCompressionOn();
+
+  const int width = 256;
+  const int height = 256;
+  for (int level = 0; level < vtkPVImageCompressionController::GetNumberOfLevels(); ++level)
+  {
+    vtkSmartPointer<vtkUnsignedCharArray> image = MakeImage(width, height, level);
+    vtkSmartPointer<vtkUnsignedCharArray> received =
+      Deliver(server, client, image, width, height, level, std::chrono::milliseconds(0));
+    if (received->GetDataSize() != image->GetDataSize())
+    {
+      cerr << "ERROR: level " << level << " delivered " << received->GetDataSize()
+           << " bytes instead of " << image->GetDataSize() << "." << endl;
+      return false;
+    }
+    if (vtkPVImageCompressionController::GetLevelIsLossLess(level) &&
+      memcmp(received->GetPointer(0), image->GetPointer(0), image->GetDataSize()) != 0)
+    {
+      cerr << "ERROR: loss-less level " << level << " did not round trip." << endl;
+      return false;
+    }
+  }
+
+  // The client waits before receiving an uncompressed image. The server must
+  // record a transfer at least that long, whatever the load of the machine.
+  // Without waiting for the client, the transfer would be the copy into the
+  // socket buffers.
+  const std::chrono::milliseconds delay(400);
+  vtkPVImageCompressionController* controller = server->GetCompressionController();
+  controller->SetSmoothingFactor(1.0);
+  vtkSmartPointer<vtkUnsignedCharArray> image = MakeImage(width, height, 0);
+  Deliver(server, client, image, width, height, 0, delay);
+  const double maximumBandwidth = image->GetDataSize() / (0.5 * delay.count() / 1000.0);
+  if (controller->GetEstimatedBandwidth() > maximumBandwidth)
+  {
+    cerr << "ERROR: estimated " << controller->GetEstimatedBandwidth()
+         << " bytes/s while the client was not receiving." << endl;
+    return false;
+  }
+  return true;
+}
+
+bool TestSelection()
+{
+  const vtkIdType numberOfPixels = 512 * 512;
+  const vtkIdType numberOfBytes = 4 * numberOfPixels;
+  vtkNew<vtkPVImageCompressionController> controller;
+  controller->SetTargetFrameTime(0.05);
+  controller->SetSmoothingFactor(1.0);
+
+  // 1 GB/s: the raw image fits the target frame time.
+  controller->RecordTransfer(numberOfBytes, numberOfBytes / 1.0e9);
+  int level = controller->SelectLevel(false, numberOfPixels, numberOfBytes);
+  if (level != 0)
+  {
+    cerr << "ERROR: level " << level << " selected on a fast link." << endl;
+    return false;
+  }
+
+  // 1 MB/s: no level fits, the fastest one is lossy.
+  controller->RecordTransfer(numberOfBytes, numberOfBytes / 1.0e6);
+  level = controller->SelectLevel(false, numberOfPixels, numberOfBytes);
+  if (vtkPVImageCompressionController::GetLevelIsLossLess(level))
+  {
+    cerr << "ERROR: loss-less level " << level << " selected on a slow link." << endl;
+    return false;
+  }
+
+  // still renders stay loss-less, but compressed.
+  level = controller->SelectLevel(true, numberOfPixels, numberOfBytes);
+  if (level == 0 || !vtkPVImageCompressionController::GetLevelIsLossLess(level))
+  {
+    cerr << "ERROR: level " << level << " selected for a still render on a slow link." << endl;
+    return false;
+  }
+
+  // encoding slower than the transfer of the raw image rules the level out.
+  for (int cc = 1; cc < vtkPVImageCompressionController::GetNumberOfLevels(); ++cc)
+  {
+    controller->RecordEncode(cc, numberOfPixels, numberOfBytes, numberOfBytes / 10, 10.0);
+  }
+  level = controller->SelectLevel(false, numberOfPixels, numberOfBytes);
+  if (level != 0)
+  {
+    cerr << "ERROR: level " << level << " selected although encoding is slower." << endl;
+    return false;
+  }
+  return true;
+}
+}
+
+int TestImageCompressionController(int, char* [])
+{
+  if (!TestSelection() || !TestDelivery())
+  {
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,369 @@
+/*=========================================================================
+
+Program:   ParaView
+Module:    TestImageTileDeltaStreaming.cxx
+
+Copyright (c) Kitware, Inc.
+All rights reserved.
+See Copyright.txt or http://www.paraview.org/HTML/Copyright.html for details.
+
+This software is distributed WITHOUT ANY WARRANTY; without even
+the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// Replays a recorded camera path through the image compressors used for
+// client-server image delivery, with and without dirty-tile streaming
+// (vtkPVImageTileDelta), and reports the number of bytes transmitted and the
+// time spent encoding and decoding. Images must round trip exactly since the
+// compressors are used in loss-less mode.
+
+#include "vtkActor.h"
+#include "vtkCamera.h"
+#include "vtkCellArray.h"
+#include "vtkCompositeMultiProcessController.h"
+#include "vtkDummyController.h"
+#include "vtkImageCompressor.h"
+#include "vtkLZ4Compressor.h"
+#include "vtkNew.h"
+#include "vtkPVClientServerSynchronizedRenderers.h"
+#include "vtkPVImageTileDelta.h"
+#include "vtkPoints.h"
+#include "vtkPolyData.h"
+#include "vtkPolyDataMapper.h"
+#include "vtkProperty.h"
+#include "vtkRenderWindow.h"
+#include "vtkRenderer.h"
+#include "vtkSmartPointer.h"
+#include "vtkSocketController.h"
+#include "vtkSquirtCompressor.h"
+#include "vtkUnsignedCharArray.h"
+#include "vtkZlibImageCompressor.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <initializer_list>
+#include <vector>
+
+namespace
+{
+// A camera key frame: azimuth/elevation increments, in degrees, and dolly
+// factor applied for `Frames` frames. `MoveMarker` moves a small actor while
+// the camera holds still, as happens when probing or editing a widget.
+struct KeyFrame
+{
+  double Azimuth;
+  double Elevation;
+  double Dolly;
+  int Frames;
+  bool MoveMarker;
+};
+
+const KeyFrame CameraPath[] = {
+  { 0.0, 0.0, 1.0, 4, false }, // still renders
+  { 2.0, 0.0, 1.0, 20, false }, // orbit
+  { 0.0, 0.0, 1.0, 10, true },  // static camera, small change
+  { 0.0, 1.5, 1.0, 10, false }, // tilt
+  { 0.0, 0.0, 1.02, 10, false }, // zoom in
+  { 0.0, 0.0, 1.0, 10, true },  // static camera, small change
+};
+
+vtkSmartPointer<vtkPolyData> MakeSurface(int resolution)
+{
+  vtkNew<vtkPoints> points;
+  vtkNew<vtkCellArray> polys;
+  for (int j = 0; j <= resolution; ++j)
+  {
+    for (int i = 0; i <= resolution; ++i)
+    {
+      const double x = static_cast<double>(i) / resolution - 0.5;
+      const double y = static_cast<double>(j) / resolution - 0.5;
+      points->InsertNextPoint(x, y, 0.1 * std::sin(10 * x) * std::cos(10 * y));
+    }
+  }
+  for (int j = 0; j < resolution; ++j)
+  {
+    for (int i = 0; i < resolution; ++i)
+    {
+      const vtkIdType p0 = j * (resolution + 1) + i;
+      const vtkIdType quad[4] = { p0, p0 + 1, p0 + resolution + 2, p0 + resolution + 1 };
+      polys->InsertNextCell(4, quad);
+    }
+  }
+  vtkSmartPointer<vtkPolyData> pd = vtkSmartPointer<vtkPolyData>::New();
+  pd->SetPoints(points);
+  pd->SetPolys(polys);
+  return pd;
+}
+
+struct Result
+{
+  size_t Bytes = 0;
+  double Seconds = 0.0;
+  int Frames = 0;
+  int DirtyTiles = 0;
+  int TotalTiles = 0;
+  bool Exact = true;
+};
+
+// Sends `frames` from a "server" to a "client", each side with its own
+// compressor and vtkPVImageTileDelta, as vtkPVClientServerSynchronizedRenderers
+// does.
+Result Replay(const std::vector<vtkSmartPointer<vtkUnsignedCharArray> >& frames, int width,
+  int height, vtkImageCompressor* encoder, vtkImageCompressor* decoder, bool tiling)
+{
+  Result result;
+  vtkNew<vtkPVImageTileDelta> serverDelta;
+  vtkNew<vtkPVImageTileDelta> clientDelta;
+  vtkNew<vtkUnsignedCharArray> bitmap;
+  vtkNew<vtkUnsignedCharArray> tiles;
+  vtkNew<vtkUnsignedCharArray> received;
+  vtkNew<vtkUnsignedCharArray> decompressed;
+  vtkNew<vtkUnsignedCharArray> image;
+
+  encoder->SetLossLessMode(1);
+  decoder->SetLossLessMode(1);
+
+  const auto start = std::chrono::steady_clock::now();
+  for (const auto& frame : frames)
+  {
+    const int ncomps = frame->GetNumberOfComponents();
+    const bool delta = tiling && serverDelta->Encode(frame, width, height, bitmap, tiles);
+    vtkUnsignedCharArray* payload = delta ? tiles.GetPointer() : frame.GetPointer();
+    const int numDirty = delta ? serverDelta->GetNumberOfDirtyTiles() : 0;
+    const int tileSize = serverDelta->GetTileSize();
+
+    if (delta)
+    {
+      result.Bytes += static_cast<size_t>(bitmap->GetNumberOfTuples());
+    }
+    if (!delta || numDirty > 0)
+    {
+      const int resolution[2] = { delta ? tileSize : width,
+        delta ? tileSize * numDirty : height };
+      encoder->SetImageResolution(resolution[0], resolution[1]);
+      encoder->SetInput(payload);
+      encoder->Compress();
+      received->DeepCopy(encoder->GetOutput());
+      result.Bytes += static_cast<size_t>(received->GetNumberOfTuples()) *
+        received->GetNumberOfComponents();
+
+      decompressed->SetNumberOfComponents(ncomps);
+      decompressed->SetNumberOfTuples(static_cast<vtkIdType>(resolution[0]) * resolution[1]);
+      decoder->SetImageResolution(resolution[0], resolution[1]);
+      decoder->SetInput(received);
+      decoder->SetOutput(decompressed);
+      decoder->Decompress();
+    }
+    else
+    {
+      decompressed->Initialize();
+    }
+
+    if (delta)
+    {
+      clientDelta->SetTileSize(tileSize);
+      clientDelta->Decode(bitmap, decompressed, width, height, ncomps, image);
+      result.DirtyTiles += numDirty;
+    }
+    else
+    {
+      image->DeepCopy(decompressed);
+      if (tiling)
+      {
+        clientDelta->SetTileSize(tileSize);
+        clientDelta->SetReference(image, width, height);
+      }
+      result.DirtyTiles += serverDelta->GetNumberOfTiles(width, height);
+    }
+    result.TotalTiles += serverDelta->GetNumberOfTiles(width, height);
+
+    if (image->GetNumberOfTuples() != frame->GetNumberOfTuples() ||
+      memcmp(image->GetPointer(0), frame->GetPointer(0),
+        static_cast<size_t>(frame->GetNumberOfTuples()) * ncomps) != 0)
+    {
+      result.Exact = false;
+    }
+    ++result.Frames;
+  }
+  result.Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  return result;
+}
+
+// Checks which controllers vtkPVClientServerSynchronizedRenderers streams
+// dirty tiles over: a direct socket connection, or the active client of
+// pvserver's vtkCompositeMultiProcessController, whose id changes with it.
+bool TestImageClient()
+{
+  int clientId;
+  vtkNew<vtkDummyController> dummy;
+  if (vtkPVClientServerSynchronizedRenderers::GetImageClient(dummy, clientId) != nullptr ||
+    clientId != -1)
+  {
+    cerr << "ERROR: images cannot be streamed over a vtkDummyController." << endl;
+    return false;
+  }
+
+  vtkNew<vtkSocketController> socket;
+  if (vtkPVClientServerSynchronizedRenderers::GetImageClient(socket, clientId) != socket ||
+    clientId < 0)
+  {
+    cerr << "ERROR: a vtkSocketController is not its own image client." << endl;
+    return false;
+  }
+
+  vtkNew<vtkCompositeMultiProcessController> composite;
+  if (vtkPVClientServerSynchronizedRenderers::GetImageClient(composite, clientId) != nullptr)
+  {
+    cerr << "ERROR: a vtkCompositeMultiProcessController without clients has an image client."
+         << endl;
+    return false;
+  }
+
+  vtkNew<vtkSocketController> first;
+  vtkNew<vtkSocketController> second;
+  composite->RegisterController(first);
+  int firstId;
+  if (vtkPVClientServerSynchronizedRenderers::GetImageClient(composite, firstId) != first ||
+    firstId < 0)
+  {
+    cerr << "ERROR: the active client of a vtkCompositeMultiProcessController is not used."
+         << endl;
+    return false;
+  }
+  composite->RegisterController(second);
+  int secondId;
+  if (vtkPVClientServerSynchronizedRenderers::GetImageClient(composite, secondId) != second ||
+    secondId == firstId)
+  {
+    cerr << "ERROR: the image client id did not change with the active client." << endl;
+    return false;
+  }
+  composite->UnRegisterController(second);
+  composite->UnRegisterController(first);
+
+  // a client without the previous frame cannot patch it, and asks for a full
+  // frame instead.
+  vtkNew<vtkPVImageTileDelta> server;
+  vtkNew<vtkPVImageTileDelta> client;
+  vtkNew<vtkUnsignedCharArray> frame;
+  vtkNew<vtkUnsignedCharArray> bitmap;
+  vtkNew<vtkUnsignedCharArray> tiles;
+  vtkNew<vtkUnsignedCharArray> image;
+  frame->SetNumberOfComponents(4);
+  frame->SetNumberOfTuples(128 * 128);
+  frame->FillValue(0);
+  server->Encode(frame, 128, 128, bitmap, tiles);
+  frame->SetValue(0, 255);
+  if (!server->Encode(frame, 128, 128, bitmap, tiles) ||
+    client->Decode(bitmap, tiles, 128, 128, 4, image))
+  {
+    cerr << "ERROR: a delta was applied without the previous frame." << endl;
+    return false;
+  }
+  return true;
+}
+}
+
+int TestImageTileDeltaStreaming(int, char* [])
+{
+  const int width = 400;
+  const int height = 300;
+
+  // Render the camera path.
+  vtkNew<vtkPolyDataMapper> mapper;
+  mapper->SetInputData(MakeSurface(100));
+  vtkNew<vtkActor> actor;
+  actor->SetMapper(mapper);
+
+  vtkNew<vtkPolyDataMapper> markerMapper;
+  markerMapper->SetInputData(MakeSurface(2));
+  vtkNew<vtkActor> marker;
+  marker->SetMapper(markerMapper);
+  marker->SetScale(0.05);
+  marker->GetProperty()->SetColor(1, 0, 0);
+
+  vtkNew<vtkRenderer> renderer;
+  renderer->AddActor(actor);
+  renderer->AddActor(marker);
+  renderer->SetBackground(0.32, 0.34, 0.43);
+  vtkNew<vtkRenderWindow> window;
+  window->SetOffScreenRendering(1);
+  window->SetSize(width, height);
+  window->AddRenderer(renderer);
+  renderer->ResetCamera();
+  renderer->GetActiveCamera()->Elevation(-30);
+
+  std::vector<vtkSmartPointer<vtkUnsignedCharArray> > frames;
+  int markerStep = 0;
+  for (const KeyFrame& key : CameraPath)
+  {
+    for (int cc = 0; cc < key.Frames; ++cc)
+    {
+      vtkCamera* camera = renderer->GetActiveCamera();
+      camera->Azimuth(key.Azimuth);
+      camera->Elevation(key.Elevation);
+      camera->OrthogonalizeViewUp();
+      camera->Dolly(key.Dolly);
+      if (key.MoveMarker)
+      {
+        ++markerStep;
+        marker->SetPosition(0.01 * markerStep, 0.0, 0.15);
+      }
+      renderer->ResetCameraClippingRange();
+      window->Render();
+
+      vtkSmartPointer<vtkUnsignedCharArray> frame = vtkSmartPointer<vtkUnsignedCharArray>::New();
+      frame->SetNumberOfComponents(4);
+      frame->SetNumberOfTuples(static_cast<vtkIdType>(width) * height);
+      window->GetRGBACharPixelData(0, 0, width - 1, height - 1, 0, frame);
+      frames.push_back(frame);
+    }
+  }
+
+  struct Codec
+  {
+    const char* Name;
+    vtkSmartPointer<vtkImageCompressor> Encoder;
+    vtkSmartPointer<vtkImageCompressor> Decoder;
+  };
+  std::vector<Codec> codecs;
+  codecs.push_back({ "Squirt", vtkSmartPointer<vtkSquirtCompressor>::New(),
+    vtkSmartPointer<vtkSquirtCompressor>::New() });
+  codecs.push_back({ "zlib", vtkSmartPointer<vtkZlibImageCompressor>::New(),
+    vtkSmartPointer<vtkZlibImageCompressor>::New() });
+  codecs.push_back({ "LZ4", vtkSmartPointer<vtkLZ4Compressor>::New(),
+    vtkSmartPointer<vtkLZ4Compressor>::New() });
+
+  // frames per second achievable on a 100 Mbit/s link, ignoring latency.
+  const double linkBytesPerSecond = 100.0e6 / 8.0;
+
+  bool success = TestImageClient();
+  for (const Codec& codec : codecs)
+  {
+    Result full = Replay(frames, width, height, codec.Encoder, codec.Decoder, false);
+    Result tiled = Replay(frames, width, height, codec.Encoder, codec.Decoder, true);
+    for (const Result* result : { &full, &tiled })
+    {
+      const double transfer = result->Bytes / linkBytesPerSecond;
+      cout << codec.Name << (result == &full ? " (full frames)" : " (dirty tiles)") << ": "
+           << result->Bytes << " bytes, " << result->DirtyTiles << "/" << result->TotalTiles
+           << " tiles, codec " << (1000.0 * result->Seconds / result->Frames)
+           << " ms/frame, ~" << (result->Frames / (result->Seconds + transfer))
+           << " fps at 100 Mbit/s" << endl;
+      if (!result->Exact)
+      {
+        cerr << "ERROR: " << codec.Name << " did not round trip the images exactly." << endl;
+        success = false;
+      }
+    }
+    if (tiled.Bytes > full.Bytes)
+    {
+      cerr << "ERROR: " << codec.Name << " dirty-tile streaming sent more data ("
+           << tiled.Bytes << " > " << full.Bytes << ")." << endl;
+      success = false;
+    }
+  }
+  return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,242 @@
+/*=========================================================================
+
+  Program:   ParaView
+  Module:    TestProminentValuesInformation.cxx
+
+  Copyright (c) Kitware, Inc.
+  All rights reserved.
+  See Copyright.txt or http://www.paraview.org/HTML/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// Checks that vtkPVProminentValuesInformation finds the same distinct values
+// as vtkAbstractArray::GetProminentComponentValues(), that it gives up on
+// components with too many values unless forced, and that its values survive
+// streaming and merging.
+#include "vtkClientServerStream.h"
+#include "vtkDoubleArray.h"
+#include "vtkIntArray.h"
+#include "vtkNew.h"
+#include "vtkPVProminentValuesInformation.h"
+#include "vtkSmartPointer.h"
+#include "vtkStringArray.h"
+#include "vtkVariant.h"
+#include "vtkVariantArray.h"
+
+#include <cstdlib>
+#include <set>
+#include <vector>
+
+namespace
+{
+typedef std::set<std::vector<vtkVariant> > TuplesT;
+
+// The tuples of `values`, which has `tupleSize` values per tuple.
+TuplesT GetTuples(vtkAbstractArray* values, int tupleSize)
+{
+  TuplesT tuples;
+  for (vtkIdType cc = 0; values && cc + tupleSize <= values->GetNumberOfValues();
+       cc += tupleSize)
+  {
+    std::vector<vtkVariant> tuple;
+    for (int i = 0; i < tupleSize; ++i)
+    {
+      tuple.push_back(values->GetVariantValue(cc + i));
+    }
+    tuples.insert(tuple);
+  }
+  return tuples;
+}
+
+// The distinct values of `component` found by `info`.
+TuplesT GetTuples(vtkPVProminentValuesInformation* info, int component)
+{
+  vtkSmartPointer<vtkAbstractArray> values;
+  values.TakeReference(info->GetProminentComponentValues(component));
+  return GetTuples(values, component < 0 ? info->GetNumberOfComponents() : 1);
+}
+
+// The distinct values of `component` found by vtkAbstractArray.
+TuplesT GetReferenceTuples(vtkAbstractArray* array, int component)
+{
+  vtkNew<vtkVariantArray> values;
+  array->GetProminentComponentValues(component, values, 0., 0.);
+  return GetTuples(values, component < 0 ? array->GetNumberOfComponents() : 1);
+}
+
+void Collect(vtkPVProminentValuesInformation* info, vtkAbstractArray* array, bool force = false)
+{
+  info->Initialize();
+  info->SetFieldName(array->GetName());
+  info->SetFieldAssociation("POINTS");
+  info->SetNumberOfComponents(array->GetNumberOfComponents());
+  info->SetForce(force);
+  info->CopyDistinctValuesFromObject(array);
+}
+
+// `info` sent through a stream.
+void Transfer(vtkPVProminentValuesInformation* info, vtkPVProminentValuesInformation* received)
+{
+  vtkClientServerStream stream;
+  info->CopyToStream(&stream);
+  received->Initialize();
+  received->CopyFromStream(&stream);
+}
+}
+
+int TestProminentValuesInformation(int, char* [])
+{
+  // 2 components with 7 and 5 values, which make 35 distinct tuples.
+  const vtkIdType numTuples = 200000;
+  vtkNew<vtkIntArray> ints;
+  ints->SetName("ints");
+  ints->SetNumberOfComponents(2);
+  ints->SetNumberOfTuples(numTuples);
+  for (vtkIdType cc = 0; cc < numTuples; ++cc)
+  {
+    ints->SetTypedComponent(cc, 0, static_cast<int>(cc % 7) * 100);
+    ints->SetTypedComponent(cc, 1, -static_cast<int>(cc % 5));
+  }
+
+  vtkNew<vtkPVProminentValuesInformation> info;
+  Collect(info, ints);
+  const TuplesT reference[3] = { GetReferenceTuples(ints, -1), GetReferenceTuples(ints, 0),
+    GetReferenceTuples(ints, 1) };
+
+  if (!info->GetValid())
+  {
+    cerr << "ERROR: integer components were not found discrete." << endl;
+    return EXIT_FAILURE;
+  }
+  if (!GetTuples(info, -1).empty() || !reference[0].empty())
+  {
+    cerr << "ERROR: 35 tuples found discrete." << endl;
+    return EXIT_FAILURE;
+  }
+  if (GetTuples(info, 0).size() != 7 || GetTuples(info, 0) != reference[1])
+  {
+    cerr << "ERROR: wrong values for component 0." << endl;
+    return EXIT_FAILURE;
+  }
+  if (GetTuples(info, 1).size() != 5 || GetTuples(info, 1) != reference[2])
+  {
+    cerr << "ERROR: wrong values for component 1." << endl;
+    return EXIT_FAILURE;
+  }
+
+  vtkNew<vtkPVProminentValuesInformation> received;
+  Transfer(info, received);
+  if (!received->GetValid() || GetTuples(received, 0) != reference[1] ||
+    GetTuples(received, 1) != reference[2])
+  {
+    cerr << "ERROR: values changed through a stream." << endl;
+    return EXIT_FAILURE;
+  }
+
+  // too many values, unless forced.
+  vtkNew<vtkDoubleArray> doubles;
+  doubles->SetName("doubles");
+  doubles->SetNumberOfTuples(numTuples);
+  for (vtkIdType cc = 0; cc < numTuples; ++cc)
+  {
+    doubles->SetValue(cc, 0.5 * (cc % 1000));
+  }
+  Collect(info, doubles);
+  if (info->GetValid() || !GetTuples(info, 0).empty())
+  {
+    cerr << "ERROR: 1000 values found discrete." << endl;
+    return EXIT_FAILURE;
+  }
+  Collect(info, doubles, true);
+  if (!info->GetValid() || GetTuples(info, 0).size() != 1000)
+  {
+    cerr << "ERROR: forced values missing." << endl;
+    return EXIT_FAILURE;
+  }
+  doubles->SetMaxDiscreteValues(VTK_UNSIGNED_INT_MAX);
+  if (GetTuples(info, 0) != GetReferenceTuples(doubles, 0))
+  {
+    cerr << "ERROR: wrong forced values." << endl;
+    return EXIT_FAILURE;
+  }
+  Transfer(info, received);
+  if (GetTuples(received, 0) != GetTuples(info, 0))
+  {
+    cerr << "ERROR: forced values changed." << endl;
+    return EXIT_FAILURE;
+  }
+
+  // -0 is 0.
+  const double specials[] = { 0.0, -0.0, 1.5, 2.5, 1.5, -0.0 };
+  vtkNew<vtkDoubleArray> special;
+  special->SetName("special");
+  for (double value : specials)
+  {
+    special->InsertNextValue(value);
+  }
+  Collect(info, special);
+  if (!info->GetValid() || GetTuples(info, 0).size() != 3)
+  {
+    cerr << "ERROR: expected 3 special values, got " << GetTuples(info, 0).size() << endl;
+    return EXIT_FAILURE;
+  }
+
+  // merging the values of several blocks.
+  vtkNew<vtkIntArray> block0;
+  vtkNew<vtkIntArray> block1;
+  block0->SetName("block");
+  block1->SetName("block");
+  for (int cc = 0; cc < 20; ++cc)
+  {
+    block0->InsertNextValue(cc);
+    block1->InsertNextValue(cc + 10);
+  }
+  vtkNew<vtkPVProminentValuesInformation> merged;
+  Collect(info, block0);
+  Transfer(info, received);
+  merged->AddInformation(received);
+  Collect(info, block1);
+  Transfer(info, received);
+  merged->AddInformation(received);
+  if (!merged->GetValid() || GetTuples(merged, 0).size() != 30)
+  {
+    cerr << "ERROR: wrong merged values." << endl;
+    return EXIT_FAILURE;
+  }
+  for (int cc = 20; cc < 30; ++cc)
+  {
+    block1->InsertNextValue(cc + 10);
+  }
+  Collect(info, block1);
+  if (!info->GetValid())
+  {
+    cerr << "ERROR: 30 values not found discrete." << endl;
+    return EXIT_FAILURE;
+  }
+  merged->AddInformation(info);
+  if (merged->GetValid())
+  {
+    cerr << "ERROR: 40 merged values found discrete." << endl;
+    return EXIT_FAILURE;
+  }
+
+  // arrays of strings.
+  vtkNew<vtkStringArray> strings;
+  strings->SetName("strings");
+  for (int cc = 0; cc < 1000; ++cc)
+  {
+    strings->InsertNextValue(cc % 3 == 0 ? "a" : (cc % 3 == 1 ? "b" : "c"));
+  }
+  Collect(info, strings);
+  Transfer(info, received);
+  if (!received->GetValid() || GetTuples(received, 0) != GetReferenceTuples(strings, 0) ||
+    GetTuples(received, 0).size() != 3)
+  {
+    cerr << "ERROR: wrong string values." << endl;
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
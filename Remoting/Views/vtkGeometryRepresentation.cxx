@@ -148,6 +148,8 @@ vtkGeometryRepresentation::vtkGeometryRepresentation()
   this->MultiBlockMaker = vtkGeometryRepresentationMultiBlockMaker::New();
   this->Decimator = vtkGeometryRepresentation_detail::DecimationFilterType::New();
   this->LODOutlineFilter = vtkPVGeometryFilter::New();
+  this->LODPyramid = new vtkGeometryRepresentation_detail::LODPyramid();
+  this->LastLODFactor = 0.5;
 
   // connect progress bar
   this->GeometryFilter->AddObserver(vtkCommand::ProgressEvent, this,
@@ -211,6 +213,7 @@ vtkGeometryRepresentation::~vtkGeometryRepresentation()
   this->MultiBlockMaker->Delete();
   this->Decimator->Delete();
   this->LODOutlineFilter->Delete();
+  delete this->LODPyramid;
   this->Mapper->Delete();
   this->LODMapper->Delete();
   this->Actor->Delete();
@@ -345,6 +348,50 @@ int vtkGeometryRepresentation::ProcessViewRequest(
         // the rendering node as and when needed.
         vtkPVView::SetPieceLOD(inInfo, this, this->LODOutlineFilter->GetOutputDataObject(0));
       }
+      else if (data->GetNumberOfElements(vtkDataObject::POINT) > 0)
+      {
+        // Serve the precomputed level closest to the requested resolution. The
+        // levels are built when the geometry is produced, or here if they were
+        // discarded since. If the closest level is still being computed, serve
+        // the best one available (or the outline if there's none yet) and let
+        // the view know it should ask again.
+        if (inInfo->Has(vtkPVRenderView::LOD_RESOLUTION()))
+        {
+          this->LastLODFactor = inInfo->Get(vtkPVRenderView::LOD_RESOLUTION());
+        }
+
+        const double cacheKey = this->GetCacheKey();
+        if (!this->LODPyramid->Has(cacheKey))
+        {
+          this->LODPyramid->Build(cacheKey, data, this->LastLODFactor);
+        }
+        int level;
+        bool isBest;
+        vtkDataObject* lod =
+          this->LODPyramid->GetLevel(cacheKey, this->LastLODFactor, level, isBest);
+        if (lod == nullptr)
+        {
+          this->LODOutlineFilter->SetInputDataObject(data);
+          this->LODOutlineFilter->Update();
+          lod = this->LODOutlineFilter->GetOutputDataObject(0);
+        }
+
+        // The delivery manager keeps the LOD geometry until the full-resolution
+        // geometry changes, hence clear it explicitly when replacing it with a
+        // different level.
+        if (this->LODPyramid->GetServedLevel(cacheKey) != level ||
+          vtkPVView::GetPieceLOD(inInfo, this) == nullptr)
+        {
+          vtkPVView::ClearPieceLOD(inInfo, this);
+          vtkPVView::SetPieceLOD(inInfo, this, lod);
+          this->LODPyramid->SetServedLevel(cacheKey, level);
+        }
+
+        if (!isBest)
+        {
+          outInfo->Set(vtkPVRenderView::LOD_PENDING(), 1);
+        }
+      }
       else
       {
         if (inInfo->Has(vtkPVRenderView::LOD_RESOLUTION()))
@@ -453,6 +500,21 @@ int vtkGeometryRepresentation::RequestData(
 
   this->MultiBlockMaker->Modified();
   this->MultiBlockMaker->Update();
+
+  // The LOD levels for the previous geometry are stale. When the view caches
+  // geometry (e.g. for animation playback), the levels for the other
+  // cache-keys are kept. Start computing the levels for the new geometry in
+  // the background, so that they are ready when the user starts interacting.
+  vtkPVView* pvview = vtkPVView::SafeDownCast(this->GetView());
+  const bool useCache = this->GetForceUseCache() || (pvview != nullptr && pvview->GetUseCache());
+  this->LODPyramid->Invalidate(this->GetCacheKey(), useCache);
+  vtkDataObject* geometry = this->MultiBlockMaker->GetOutputDataObject(0);
+  if (!this->SuppressLOD && geometry != nullptr &&
+    geometry->GetNumberOfElements(vtkDataObject::POINT) > 0)
+  {
+    this->LODPyramid->Build(this->GetCacheKey(), geometry, this->LastLODFactor);
+  }
+
   return this->Superclass::RequestData(request, inputVector, outputVector);
 }
 
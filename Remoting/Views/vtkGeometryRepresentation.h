@@ -49,6 +49,7 @@ namespace vtkGeometryRepresentation_detail
 // This is defined to either vtkQuadricClustering or vtkmLevelOfDetail in the
 // implementation file:
 class DecimationFilterType;
+class LODPyramid;
 }
 
 class VTKREMOTINGVIEWS_EXPORT vtkGeometryRepresentation : public vtkPVDataRepresentation
@@ -407,6 +408,11 @@ protected:
   vtkGeometryRepresentation_detail::DecimationFilterType* Decimator;
   vtkPVGeometryFilter* LODOutlineFilter;
 
+  // Decimated levels of the geometry, computed in the background after each
+  // update. Used to serve REQUEST_UPDATE_LOD without decimating on demand.
+  vtkGeometryRepresentation_detail::LODPyramid* LODPyramid;
+  double LastLODFactor;
+
   vtkMapper* Mapper;
   vtkMapper* LODMapper;
   vtkPVLODActor* Actor;
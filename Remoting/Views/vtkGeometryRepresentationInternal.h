@@ -140,5 +140,345 @@ protected:
 vtkStandardNewMacro(DecimationFilterType)
 }
 #endif // VTKM_ENABLE_TBB
+
+#include "vtkCommand.h"
+#include "vtkCompositeDataIterator.h"
+#include "vtkCompositeDataSet.h"
+#include "vtkNew.h"
+#include "vtkSmartPointer.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace vtkGeometryRepresentation_detail
+{
+/**
+ * LODPyramid keeps several decimated versions of the full-resolution geometry
+ * of a vtkGeometryRepresentation. The levels are computed on a worker thread
+ * as soon as the full-resolution geometry is produced, so that
+ * REQUEST_UPDATE_LOD passes can be served without decimating on the calling
+ * thread. Levels are kept per cache-key, matching how vtkPVDataDeliveryManager
+ * caches the full-resolution geometry for each time step. Only the levels of
+ * the MAXIMUM_NUMBER_OF_KEYS most recently used keys are kept.
+ */
+class LODPyramid
+{
+public:
+  enum
+  {
+    /**
+     * Level index used to report that no decimated level is available yet.
+     */
+    NO_LEVEL = -1,
+
+    /**
+     * Number of cache-keys whose levels are kept. Interaction usually happens
+     * on a single time step, so the levels of a few keys are enough even when
+     * the view caches the geometry of every time step.
+     */
+    MAXIMUM_NUMBER_OF_KEYS = 4
+  };
+
+  LODPyramid() = default;
+  ~LODPyramid()
+  {
+    this->Clear();
+    this->Retired.clear();
+  }
+
+  /**
+   * LOD factors for the levels in the pyramid, from coarsest to finest.
+   */
+  static const std::array<double, 5>& GetLevelFactors()
+  {
+    static const std::array<double, 5> factors = { { 0.0, 0.25, 0.5, 0.75, 1.0 } };
+    return factors;
+  }
+
+  /**
+   * Returns the index of the level whose factor is closest to `factor`.
+   */
+  static int GetClosestLevel(double factor)
+  {
+    const auto& factors = LODPyramid::GetLevelFactors();
+    int closest = 0;
+    for (int cc = 1; cc < static_cast<int>(factors.size()); ++cc)
+    {
+      if (std::abs(factors[cc] - factor) < std::abs(factors[closest] - factor))
+      {
+        closest = cc;
+      }
+    }
+    return closest;
+  }
+
+  /**
+   * Discards the levels for the given cache-key, whose geometry has changed.
+   * When `keepOtherKeys` is false, levels for all other keys are discarded as
+   * well.
+   */
+  void Invalidate(double cacheKey, bool keepOtherKeys)
+  {
+    if (keepOtherKeys)
+    {
+      this->Remove(cacheKey);
+    }
+    else
+    {
+      this->Clear();
+    }
+  }
+
+  /**
+   * Starts building the levels for `data` under the given cache-key on a
+   * worker thread. Any previous levels for the same key are discarded, as are
+   * the levels of the least recently used key when MAXIMUM_NUMBER_OF_KEYS keys
+   * are already kept. Levels are built in order of their distance from
+   * `preferredFactor`.
+   */
+  void Build(double cacheKey, vtkDataObject* data, double preferredFactor)
+  {
+    this->Remove(cacheKey);
+    while (this->Entries.size() >= MAXIMUM_NUMBER_OF_KEYS)
+    {
+      auto oldest = std::min_element(this->Entries.begin(), this->Entries.end(),
+        [](const std::pair<const double, std::unique_ptr<Entry> >& a,
+          const std::pair<const double, std::unique_ptr<Entry> >& b) {
+          return a.second->LastUse < b.second->LastUse;
+        });
+      this->Remove(oldest->first);
+    }
+
+    std::unique_ptr<Entry> entry(new Entry());
+    entry->Levels.resize(LODPyramid::GetLevelFactors().size());
+    entry->LastUse = ++this->UseCount;
+
+    // The worker decimates a deep copy taken on the calling thread. Sharing
+    // points or arrays with the rendering pipeline would let the worker update
+    // their bounds and range caches while they are being rendered. The worker
+    // releases the copy once it is done.
+    entry->Input.TakeReference(data->NewInstance());
+    entry->Input->DeepCopy(data);
+
+    const auto& factors = LODPyramid::GetLevelFactors();
+    std::vector<int> order(factors.size());
+    for (int cc = 0; cc < static_cast<int>(order.size()); ++cc)
+    {
+      order[cc] = cc;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+      return std::abs(factors[a] - preferredFactor) < std::abs(factors[b] - preferredFactor);
+    });
+
+    Entry* self = entry.get();
+    entry->Worker = std::async(std::launch::async, [self, order]() {
+      vtkNew<DecimationFilterType> decimator;
+      decimator->AddObserver(vtkCommand::ProgressEvent, self, &Entry::AbortIfRequested);
+      for (int level : order)
+      {
+        decimator->SetLODFactor(LODPyramid::GetLevelFactors()[level]);
+        vtkSmartPointer<vtkDataObject> result =
+          LODPyramid::Decimate(decimator, self->Input, self->Abort);
+        if (result == nullptr)
+        {
+          break;
+        }
+
+        std::lock_guard<std::mutex> lock(self->Mutex);
+        self->Levels[level] = result;
+      }
+      self->Input = nullptr;
+    });
+    this->Entries[cacheKey] = std::move(entry);
+  }
+
+  /**
+   * Returns true if levels are being built (or have been built) for the key.
+   */
+  bool Has(double cacheKey) const { return this->Entries.find(cacheKey) != this->Entries.end(); }
+
+  /**
+   * Returns the available level closest to `factor` for the given key, or
+   * nullptr if no level is available yet. `level` is set to the index of the
+   * returned level (or NO_LEVEL) and `isBest` is set to true if that level is
+   * the one closest to `factor` among all levels, i.e., a better level will
+   * not become available later.
+   */
+  vtkDataObject* GetLevel(double cacheKey, double factor, int& level, bool& isBest)
+  {
+    level = NO_LEVEL;
+    isBest = false;
+    auto iter = this->Entries.find(cacheKey);
+    if (iter == this->Entries.end())
+    {
+      return nullptr;
+    }
+
+    const auto& factors = LODPyramid::GetLevelFactors();
+    Entry* entry = iter->second.get();
+    entry->LastUse = ++this->UseCount;
+    std::lock_guard<std::mutex> lock(entry->Mutex);
+    for (int cc = 0; cc < static_cast<int>(factors.size()); ++cc)
+    {
+      if (entry->Levels[cc] != nullptr &&
+        (level == NO_LEVEL || std::abs(factors[cc] - factor) < std::abs(factors[level] - factor)))
+      {
+        level = cc;
+      }
+    }
+    isBest = (level == LODPyramid::GetClosestLevel(factor));
+    return level != NO_LEVEL ? entry->Levels[level].GetPointer() : nullptr;
+  }
+
+  //@{
+  /**
+   * Keeps track of the level that was last handed to the view for the key so
+   * that the LOD geometry is only replaced when a better level is available.
+   */
+  int GetServedLevel(double cacheKey) const
+  {
+    auto iter = this->Entries.find(cacheKey);
+    return iter != this->Entries.end() ? iter->second->ServedLevel : NO_LEVEL;
+  }
+  void SetServedLevel(double cacheKey, int level)
+  {
+    auto iter = this->Entries.find(cacheKey);
+    if (iter != this->Entries.end())
+    {
+      iter->second->ServedLevel = level;
+    }
+  }
+  //@}
+
+  /**
+   * Discards the levels for the key. If the worker for the key is still
+   * running, it is asked to stop.
+   */
+  void Remove(double cacheKey)
+  {
+    auto iter = this->Entries.find(cacheKey);
+    if (iter != this->Entries.end())
+    {
+      this->Retire(std::move(iter->second));
+      this->Entries.erase(iter);
+    }
+  }
+
+  /**
+   * Discards all levels.
+   */
+  void Clear()
+  {
+    for (auto& item : this->Entries)
+    {
+      this->Retire(std::move(item.second));
+    }
+    this->Entries.clear();
+  }
+
+private:
+  struct Entry
+  {
+    std::mutex Mutex;
+    std::vector<vtkSmartPointer<vtkDataObject> > Levels; // guarded by Mutex
+    std::atomic<bool> Abort{ false };
+    int ServedLevel = NO_LEVEL;
+    unsigned long LastUse = 0;
+    vtkSmartPointer<vtkDataObject> Input; // only used by the worker once started
+    std::future<void> Worker;
+
+    // Stops the decimation of a block, for decimators that report progress.
+    void AbortIfRequested(vtkObject* caller, unsigned long, void*)
+    {
+      if (this->Abort)
+      {
+        vtkAlgorithm::SafeDownCast(caller)->SetAbortExecute(1);
+      }
+    }
+
+    // Wait for the worker since it references this entry.
+    ~Entry()
+    {
+      if (this->Worker.valid())
+      {
+        this->Worker.wait();
+      }
+    }
+  };
+
+  /**
+   * Decimates `input` block by block, checking `abort` before each block.
+   * Returns nullptr when aborted.
+   */
+  static vtkSmartPointer<vtkDataObject> Decimate(
+    DecimationFilterType* decimator, vtkDataObject* input, const std::atomic<bool>& abort)
+  {
+    vtkSmartPointer<vtkDataObject> result;
+    vtkCompositeDataSet* composite = vtkCompositeDataSet::SafeDownCast(input);
+    if (composite == nullptr)
+    {
+      if (abort)
+      {
+        return nullptr;
+      }
+      decimator->SetInputDataObject(input);
+      decimator->Update();
+      if (abort)
+      {
+        return nullptr;
+      }
+      vtkDataObject* output = decimator->GetOutputDataObject(0);
+      result.TakeReference(output->NewInstance());
+      result->ShallowCopy(output);
+      return result;
+    }
+
+    result.TakeReference(composite->NewInstance());
+    vtkCompositeDataSet* decimated = vtkCompositeDataSet::SafeDownCast(result);
+    decimated->CopyStructure(composite);
+    vtkSmartPointer<vtkCompositeDataIterator> iter;
+    iter.TakeReference(composite->NewIterator());
+    for (iter->InitTraversal(); !iter->IsDoneWithTraversal(); iter->GoToNextItem())
+    {
+      vtkSmartPointer<vtkDataObject> block =
+        LODPyramid::Decimate(decimator, iter->GetCurrentDataObject(), abort);
+      if (block == nullptr)
+      {
+        return nullptr;
+      }
+      decimated->SetDataSet(iter, block);
+    }
+    return result;
+  }
+
+  /**
+   * Aborts the entry's worker. The entry is kept alive until the worker is
+   * done so that discarding levels never waits for a decimation to finish.
+   */
+  void Retire(std::unique_ptr<Entry> entry)
+  {
+    entry->Abort = true;
+    this->Retired.push_back(std::move(entry));
+    this->Retired.erase(std::remove_if(this->Retired.begin(), this->Retired.end(),
+                          [](const std::unique_ptr<Entry>& retired) {
+                            return retired->Worker.wait_for(std::chrono::seconds(0)) ==
+                              std::future_status::ready;
+                          }),
+      this->Retired.end());
+  }
+
+  std::map<double, std::unique_ptr<Entry> > Entries;
+  std::vector<std::unique_ptr<Entry> > Retired;
+  unsigned long UseCount = 0;
+};
+}
 #endif // __VTK_WRAP__
 // VTK-HeaderTest-Exclude: vtkGeometryRepresentationInternal.h
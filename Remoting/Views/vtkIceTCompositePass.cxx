@@ -32,6 +32,7 @@
 #include "vtkOpenGLState.h"
 #include "vtkOrderedCompositingHelper.h"
 #include "vtkPVLogger.h"
+#include "vtkPVTraceRecorder.h"
 #include "vtkPixelBufferObject.h"
 #include "vtkRenderState.h"
 #include "vtkRenderWindow.h"
@@ -351,6 +352,7 @@ void vtkIceTCompositePass::CleanupContext(const vtkRenderState*)
 void vtkIceTCompositePass::Render(const vtkRenderState* render_state)
 {
   vtkVLogScopeF(PARAVIEW_LOG_RENDERING_VERBOSITY(), "%s: Render", vtkLogIdentifier(this));
+  vtkPVTraceScope traceScope(vtkPVTraceRecorder::COMPOSITING, "IceT composite");
   vtkOpenGLRenderUtilities::MarkDebugEvent("vtkIceTCompositePass::Render Start");
   this->IceTContext->SetController(this->Controller);
   if (!this->IceTContext->IsValid())
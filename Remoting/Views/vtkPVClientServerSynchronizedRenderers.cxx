@@ -15,12 +15,19 @@
 =========================================================================*/
 #include "vtkPVClientServerSynchronizedRenderers.h"
 
+#include "vtkCompositeMultiProcessController.h"
 #include "vtkLZ4Compressor.h"
 #include "vtkMultiProcessController.h"
 #include "vtkObjectFactory.h"
 #include "vtkOpenGLRenderer.h"
+#include "vtkNew.h"
 #include "vtkPVConfig.h"
+#include "vtkPVImageCompressionController.h"
+#include "vtkPVImageTileDelta.h"
+#include "vtkPVTraceRecorder.h"
+#include "vtkSocketController.h"
 #include "vtkSquirtCompressor.h"
+#include "vtkTimerLog.h"
 #include "vtkUnsignedCharArray.h"
 #include "vtkZlibImageCompressor.h"
 #if VTK_MODULE_ENABLE_ParaView_nvpipe
@@ -37,6 +44,14 @@ vtkPVClientServerSynchronizedRenderers::vtkPVClientServerSynchronizedRenderers()
   : Compressor(NULL)
   , LossLessCompression(true)
   , NVPipeSupport(false)
+  , DirtyTileStreaming(true)
+  , DirtyTileSize(64)
+  , AdaptiveCompression(false)
+  , TileDelta(vtkPVImageTileDelta::New())
+  , TileDeltaClientId(-1)
+  , FullFrameRequested(false)
+  , LastFrameLossy(false)
+  , CompressionController(vtkPVImageCompressionController::New())
 {
   this->ConfigureCompressor("vtkLZ4Compressor 0 3");
 }
@@ -45,6 +60,55 @@ vtkPVClientServerSynchronizedRenderers::vtkPVClientServerSynchronizedRenderers()
 vtkPVClientServerSynchronizedRenderers::~vtkPVClientServerSynchronizedRenderers()
 {
   this->SetCompressor(NULL);
+  this->TileDelta->Delete();
+  this->CompressionController->Delete();
+}
+
+//----------------------------------------------------------------------------
+vtkMultiProcessController* vtkPVClientServerSynchronizedRenderers::GetImageClient(
+  vtkMultiProcessController* controller, int& clientId)
+{
+  clientId = -1;
+  if (auto composite = vtkCompositeMultiProcessController::SafeDownCast(controller))
+  {
+    vtkMultiProcessController* active = composite->GetActiveController();
+    if (active != nullptr)
+    {
+      clientId = composite->GetActiveControllerID();
+    }
+    return active;
+  }
+  if (vtkSocketController::SafeDownCast(controller))
+  {
+    clientId = 0;
+    return controller;
+  }
+  return nullptr;
+}
+
+//----------------------------------------------------------------------------
+void vtkPVClientServerSynchronizedRenderers::MasterStartRender()
+{
+  this->Superclass::MasterStartRender();
+
+  // let the server know whether the last frame could not be patched, in which
+  // case it must not send a delta against it.
+  int request = this->FullFrameRequested ? 1 : 0;
+  this->ParallelController->Send(&request, 1, 1, 0x023431);
+  this->FullFrameRequested = false;
+}
+
+//----------------------------------------------------------------------------
+void vtkPVClientServerSynchronizedRenderers::SlaveStartRender()
+{
+  this->Superclass::SlaveStartRender();
+
+  int request = 0;
+  this->ParallelController->Receive(&request, 1, 1, 0x023431);
+  if (request != 0)
+  {
+    this->TileDelta->Reset();
+  }
 }
 
 //----------------------------------------------------------------------------
@@ -54,24 +118,56 @@ void vtkPVClientServerSynchronizedRenderers::MasterEndRender()
   assert(this->ParallelController->IsA("vtkSocketController") ||
     this->ParallelController->IsA("vtkCompositeMultiProcessController"));
 
+  vtkPVTraceScope traceScope(vtkPVTraceRecorder::COMPOSITING, "receive image from server");
   vtkRawImage& rawImage = this->Image;
 
-  int header[4];
-  this->ParallelController->Receive(header, 4, 1, 0x023430);
+  // header: valid, width, height, number of components, number of dirty tiles
+  // (-1 for a full frame), tile size (0 when the server is not tiling) and
+  // vtkPVImageCompressionController level (-1 for the configured compressor).
+  int header[7];
+  this->ParallelController->Receive(header, 7, 1, 0x023430);
   if (header[0] > 0)
   {
     rawImage.Resize(header[1], header[2], header[3]);
-    if (this->Compressor)
+    if (header[4] >= 0)
     {
-      vtkUnsignedCharArray* data = vtkUnsignedCharArray::New();
-      this->ParallelController->Receive(data, 1, 0x023430);
-      this->Compressor->SetImageResolution(header[1], header[2]);
-      this->Decompress(data, rawImage.GetRawPtr());
-      data->Delete();
+      const int tileSize = header[5];
+      vtkNew<vtkUnsignedCharArray> bitmap;
+      vtkNew<vtkUnsignedCharArray> tiles;
+      this->ParallelController->Receive(bitmap, 1, 0x023430);
+      if (header[4] > 0)
+      {
+        tiles->SetNumberOfComponents(header[3]);
+        tiles->SetNumberOfTuples(static_cast<vtkIdType>(tileSize) * tileSize * header[4]);
+        this->ReceiveImage(tiles, tileSize, tileSize * header[4], header[6]);
+      }
+      this->TileDelta->SetTileSize(tileSize);
+      if (!this->TileDelta->Decode(
+            bitmap, tiles, header[1], header[2], header[3], rawImage.GetRawPtr()))
+      {
+        // the frame cannot be rebuilt; drop it and have the server send the
+        // next one in full.
+        vtkWarningMacro("Could not patch the previous frame, requesting a full frame.");
+        this->TileDelta->Reset();
+        this->FullFrameRequested = true;
+        return;
+      }
     }
     else
     {
-      this->ParallelController->Receive(rawImage.GetRawPtr(), 1, 0x023430);
+      this->ReceiveImage(rawImage.GetRawPtr(), header[1], header[2], header[6]);
+
+      // keep the frame around only if the server is going to send deltas
+      // against it.
+      if (header[5] > 0)
+      {
+        this->TileDelta->SetTileSize(header[5]);
+        this->TileDelta->SetReference(rawImage.GetRawPtr(), header[1], header[2]);
+      }
+      else
+      {
+        this->TileDelta->Reset();
+      }
     }
     rawImage.MarkValid();
   }
@@ -83,28 +179,184 @@ void vtkPVClientServerSynchronizedRenderers::SlaveEndRender()
   assert(this->ParallelController->IsA("vtkSocketController") ||
     this->ParallelController->IsA("vtkCompositeMultiProcessController"));
 
+  vtkPVTraceScope traceScope(vtkPVTraceRecorder::COMPOSITING, "send image to client");
   vtkRawImage& rawImage = this->CaptureRenderedImage();
 
-  int header[4];
+  // With vtkCompositeMultiProcessController (pvserver), the client receiving
+  // the image may change from one frame to the next, and the new client does
+  // not have the previous frame.
+  int clientId;
+  vtkMultiProcessController* client =
+    vtkPVClientServerSynchronizedRenderers::GetImageClient(this->ParallelController, clientId);
+  if (clientId != this->TileDeltaClientId)
+  {
+    this->TileDelta->Reset();
+    this->TileDeltaClientId = clientId;
+  }
+  const bool tiling = this->DirtyTileStreaming && rawImage.IsValid() && client != nullptr;
+
+  vtkNew<vtkUnsignedCharArray> bitmap;
+  vtkNew<vtkUnsignedCharArray> tiles;
+  bool delta = false;
+  if (tiling)
+  {
+    this->TileDelta->SetTileSize(this->DirtyTileSize);
+    if (this->LastFrameLossy && this->LossLessCompression)
+    {
+      // the client only has a lossy version of the previous frame; unchanged
+      // tiles would never be corrected.
+      this->TileDelta->Reset();
+    }
+    delta = this->TileDelta->Encode(
+      rawImage.GetRawPtr(), rawImage.GetWidth(), rawImage.GetHeight(), bitmap, tiles);
+  }
+  else
+  {
+    this->TileDelta->Reset();
+  }
+
+  int header[7];
   header[0] = rawImage.IsValid() ? 1 : 0;
   header[1] = rawImage.GetWidth();
   header[2] = rawImage.GetHeight();
   header[3] = rawImage.IsValid() ? rawImage.GetRawPtr()->GetNumberOfComponents() : 0;
+  header[4] = delta ? this->TileDelta->GetNumberOfDirtyTiles() : -1;
+  header[5] = tiling ? this->TileDelta->GetTileSize() : 0;
+  header[6] = -1;
+
+  vtkUnsignedCharArray* image = rawImage.GetRawPtr();
+  int resolution[2] = { header[1], header[2] };
+  if (delta)
+  {
+    // the dirty tiles are packed into a single column of tiles.
+    image = tiles;
+    resolution[0] = header[5];
+    resolution[1] = header[5] * header[4];
+  }
+
+  if (this->AdaptiveCompression && rawImage.IsValid())
+  {
+    header[6] = this->CompressionController->SelectLevel(this->LossLessCompression,
+      static_cast<vtkIdType>(resolution[0]) * resolution[1], image->GetDataSize());
+    this->LastFrameLossy = !vtkPVImageCompressionController::GetLevelIsLossLess(header[6]);
+  }
+  else
+  {
+    this->LastFrameLossy = (this->Compressor != nullptr && !this->LossLessCompression);
+  }
 
   // send the image to the client.
-  this->ParallelController->Send(header, 4, 1, 0x023430);
+  this->ParallelController->Send(header, 7, 1, 0x023430);
+
+  if (!rawImage.IsValid())
+  {
+    return;
+  }
+
+  if (delta)
+  {
+    this->ParallelController->Send(bitmap, 1, 0x023430);
+    if (header[4] == 0)
+    {
+      // nothing changed.
+      return;
+    }
+  }
+  this->SendImage(image, resolution[0], resolution[1], header[6]);
+}
 
-  if (rawImage.IsValid())
+//----------------------------------------------------------------------------
+void vtkPVClientServerSynchronizedRenderers::SendImage(
+  vtkUnsignedCharArray* image, int width, int height, int level)
+{
+  if (level < 0)
   {
     if (this->Compressor)
     {
-      this->Compressor->SetImageResolution(header[1], header[2]);
-      this->ParallelController->Send(this->Compress(rawImage.GetRawPtr()), 1, 0x023430);
+      this->Compressor->SetImageResolution(width, height);
+      this->ParallelController->Send(this->Compress(image), 1, 0x023430);
     }
     else
     {
-      this->ParallelController->Send(rawImage.GetRawPtr(), 1, 0x023430);
+      this->ParallelController->Send(image, 1, 0x023430);
     }
+    return;
+  }
+
+  // adaptive compression: time the encoding and the transfer and let the
+  // controller adjust its estimates for the next frame. The client
+  // acknowledges the image once it has received it, so that the transfer time
+  // covers the delivery and not only the copy into the socket buffers.
+  vtkPVImageCompressionController* controller = this->CompressionController;
+  vtkImageCompressor* compressor = controller->GetCompressor(level);
+  const vtkIdType numberOfPixels = static_cast<vtkIdType>(width) * height;
+  vtkUnsignedCharArray* payload = image;
+
+  vtkNew<vtkTimerLog> timer;
+  if (compressor)
+  {
+    timer->StartTimer();
+    compressor->SetImageResolution(width, height);
+    compressor->SetInput(image);
+    if (compressor->Compress() == 0)
+    {
+      vtkErrorMacro("Image compression failed!");
+    }
+    else
+    {
+      payload = compressor->GetOutput();
+    }
+    timer->StopTimer();
+  }
+  controller->RecordEncode(level, numberOfPixels, image->GetDataSize(), payload->GetDataSize(),
+    compressor ? timer->GetElapsedTime() : 0.0);
+
+  timer->StartTimer();
+  this->ParallelController->Send(payload, 1, 0x023430);
+  char received = 0;
+  this->ParallelController->Receive(&received, 1, 1, 0x023432);
+  timer->StopTimer();
+  controller->RecordTransfer(payload->GetDataSize(), timer->GetElapsedTime());
+}
+
+//----------------------------------------------------------------------------
+void vtkPVClientServerSynchronizedRenderers::ReceiveImage(
+  vtkUnsignedCharArray* outputBuffer, int width, int height, int level)
+{
+  vtkImageCompressor* compressor =
+    level < 0 ? this->Compressor : this->CompressionController->GetCompressor(level);
+  // with adaptive compression, the server waits for the image to be received
+  // before it records the transfer time.
+  const char received = 1;
+  if (compressor == nullptr)
+  {
+    this->ParallelController->Receive(outputBuffer, 1, 0x023430);
+    if (level >= 0)
+    {
+      this->ParallelController->Send(&received, 1, 1, 0x023432);
+    }
+    return;
+  }
+
+  vtkNew<vtkUnsignedCharArray> data;
+  this->ParallelController->Receive(data, 1, 0x023430);
+  if (level >= 0)
+  {
+    this->ParallelController->Send(&received, 1, 1, 0x023432);
+  }
+  compressor->SetImageResolution(width, height);
+  if (level < 0)
+  {
+    this->Decompress(data, outputBuffer);
+    return;
+  }
+
+  // the level's configuration sets the compressor's loss-less mode.
+  compressor->SetInput(data);
+  compressor->SetOutput(outputBuffer);
+  if (compressor->Decompress() == 0)
+  {
+    vtkErrorMacro("Image de-compression failed!");
   }
 }
 
@@ -156,6 +408,19 @@ void vtkPVClientServerSynchronizedRenderers::ConfigureCompressor(const char* str
   std::istringstream iss(stream);
   std::string className;
   iss >> className;
+
+  // "vtkPVImageCompressionController <target frame time in ms>" lets the
+  // server pick the compressor for each frame. The configured compressor is
+  // left untouched.
+  if (className == "vtkPVImageCompressionController")
+  {
+    double targetMS = 50.0;
+    iss >> targetMS;
+    this->CompressionController->SetTargetFrameTime(targetMS / 1000.0);
+    this->SetAdaptiveCompression(true);
+    return;
+  }
+  this->SetAdaptiveCompression(false);
   // Allocate the desired compressor unless we have one in hand.
   if (this->Compressor == nullptr || !this->Compressor->IsA(className.c_str()))
   {
@@ -217,4 +482,9 @@ void vtkPVClientServerSynchronizedRenderers::ConfigureCompressor(const char* str
 void vtkPVClientServerSynchronizedRenderers::PrintSelf(ostream& os, vtkIndent indent)
 {
   this->Superclass::PrintSelf(os, indent);
+  os << indent << "DirtyTileStreaming: " << this->DirtyTileStreaming << endl;
+  os << indent << "DirtyTileSize: " << this->DirtyTileSize << endl;
+  os << indent << "AdaptiveCompression: " << this->AdaptiveCompression << endl;
+  os << indent << "CompressionController: " << endl;
+  this->CompressionController->PrintSelf(os, indent.GetNextIndent());
 }
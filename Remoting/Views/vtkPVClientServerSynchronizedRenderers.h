@@ -19,6 +19,21 @@
  * vtkPVClientServerSynchronizedRenderers is similar to
  * vtkClientServerSynchronizedRenderers except that it optionally uses image
  * compressors to compress the image before transmitting.
+ *
+ * When DirtyTileStreaming is enabled, the server keeps the previously
+ * transmitted frame and only sends the tiles that changed since, using
+ * vtkPVImageTileDelta. The client keeps its own copy of the last frame and
+ * patches it with the received tiles. Full frames are sent whenever the image
+ * size changes, when switching from lossy to loss-less compression, when the
+ * active client of a vtkCompositeMultiProcessController changes, and when the
+ * client fails to patch its copy of the previous frame.
+ *
+ * When AdaptiveCompression is enabled, the compressor and its settings are
+ * chosen for every frame by a vtkPVImageCompressionController, from the
+ * measured encoding time and link throughput, to fit a target frame time
+ * during interaction. Still renders are always compressed loss-lessly. The
+ * client then acknowledges each image, and the link throughput is measured
+ * from the time the server starts sending the image to the acknowledgement.
 */
 
 #ifndef vtkPVClientServerSynchronizedRenderers_h
@@ -28,6 +43,9 @@
 #include "vtkSynchronizedRenderers.h"
 
 class vtkImageCompressor;
+class vtkMultiProcessController;
+class vtkPVImageCompressionController;
+class vtkPVImageTileDelta;
 class vtkUnsignedCharArray;
 
 class VTKREMOTINGVIEWS_EXPORT vtkPVClientServerSynchronizedRenderers
@@ -55,10 +73,58 @@ public:
   /**
    * Set and configure a compressor from it's own configuration stream. This
    * is used by ParaView to configure the compressor from application wide
-   * user settings.
+   * user settings. The stream "vtkPVImageCompressionController <ms>" enables
+   * AdaptiveCompression with the given target frame time, in milliseconds.
    */
   virtual void ConfigureCompressor(const char* stream);
 
+  //@{
+  /**
+   * When enabled, only the tiles of the image that changed since the previous
+   * frame are transmitted. Default is true.
+   */
+  vtkSetMacro(DirtyTileStreaming, bool);
+  vtkGetMacro(DirtyTileStreaming, bool);
+  vtkBooleanMacro(DirtyTileStreaming, bool);
+  //@}
+
+  //@{
+  /**
+   * Size, in pixels, of the square tiles used when DirtyTileStreaming is
+   * enabled. The client adopts the tile size chosen by the server. Default is
+   * 64.
+   */
+  vtkSetClampMacro(DirtyTileSize, int, 8, 1024);
+  vtkGetMacro(DirtyTileSize, int);
+  //@}
+
+  //@{
+  /**
+   * When enabled, the server chooses the compressor for each frame using
+   * CompressionController instead of the configured compressor. Only
+   * meaningful on the server; the client follows what the server reports with
+   * each image. Default is false.
+   */
+  vtkSetMacro(AdaptiveCompression, bool);
+  vtkGetMacro(AdaptiveCompression, bool);
+  vtkBooleanMacro(AdaptiveCompression, bool);
+  //@}
+
+  /**
+   * Provides access to the controller used when AdaptiveCompression is
+   * enabled, e.g. to change its target frame time.
+   */
+  vtkGetObjectMacro(CompressionController, vtkPVImageCompressionController);
+
+  /**
+   * Returns the controller of the client the images are sent to: `controller`
+   * itself for a vtkSocketController, or the active controller of a
+   * vtkCompositeMultiProcessController, or nullptr. `clientId` is set to a
+   * value that changes whenever that client changes, or -1.
+   */
+  static vtkMultiProcessController* GetImageClient(
+    vtkMultiProcessController* controller, int& clientId);
+
 protected:
   vtkPVClientServerSynchronizedRenderers();
   ~vtkPVClientServerSynchronizedRenderers() override;
@@ -74,12 +140,41 @@ protected:
   vtkUnsignedCharArray* Compress(vtkUnsignedCharArray*);
   void Decompress(vtkUnsignedCharArray* input, vtkUnsignedCharArray* outputBuffer);
 
+  //@{
+  /**
+   * Send/receive an image compressed with the configured compressor, when
+   * `level` is negative, or with the vtkPVImageCompressionController level.
+   */
+  void SendImage(vtkUnsignedCharArray* image, int width, int height, int level);
+  void ReceiveImage(vtkUnsignedCharArray* outputBuffer, int width, int height, int level);
+  //@}
+
+  void MasterStartRender() override;
+  void SlaveStartRender() override;
   void MasterEndRender() override;
   void SlaveEndRender() override;
 
   vtkImageCompressor* Compressor;
   bool LossLessCompression;
   bool NVPipeSupport;
+  bool DirtyTileStreaming;
+  int DirtyTileSize;
+  bool AdaptiveCompression;
+
+  // Last frame, as seen by the other side of the connection.
+  vtkPVImageTileDelta* TileDelta;
+
+  // Client TileDelta's frame was sent to, see GetImageClient().
+  int TileDeltaClientId;
+
+  // Set on the client when a delta could not be applied.
+  bool FullFrameRequested;
+
+  // Set when the last frame was sent with lossy compression, in which case the
+  // client's copy of it is not exact and cannot be patched in loss-less mode.
+  bool LastFrameLossy;
+
+  vtkPVImageCompressionController* CompressionController;
 
 private:
   vtkPVClientServerSynchronizedRenderers(const vtkPVClientServerSynchronizedRenderers&) = delete;
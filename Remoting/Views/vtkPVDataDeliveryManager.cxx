@@ -21,6 +21,7 @@
 #include "vtkObjectFactory.h"
 #include "vtkPVDataRepresentation.h"
 #include "vtkPVLogger.h"
+#include "vtkPVTraceRecorder.h"
 #include "vtkPVView.h"
 #include "vtkSmartPointer.h"
 #include "vtkWeakPointer.h"
@@ -135,6 +136,18 @@ void vtkPVDataDeliveryManager::SetPiece(vtkPVDataRepresentation* repr, vtkDataOb
   }
 }
 
+//----------------------------------------------------------------------------
+void vtkPVDataDeliveryManager::ClearPiece(vtkPVDataRepresentation* repr, bool low_res, int port)
+{
+  vtkInternals::vtkItem* item =
+    this->Internals->GetItem(repr, low_res, port, /*create_if_needed=*/false);
+  const auto cacheKey = this->GetCacheKey(repr);
+  if (item && item->GetDataObject(cacheKey) != nullptr)
+  {
+    item->SetDataObject(nullptr, this->Internals, cacheKey);
+  }
+}
+
 //----------------------------------------------------------------------------
 vtkDataObject* vtkPVDataDeliveryManager::GetPiece(
   vtkPVDataRepresentation* repr, bool low_res, int port)
@@ -244,6 +257,8 @@ void vtkPVDataDeliveryManager::Deliver(int low_res, unsigned int size, unsigned
 
   vtkVLogScopeF(PARAVIEW_LOG_DATA_MOVEMENT_VERBOSITY(), "%s data migration",
     (low_res ? "low-resolution" : "full resolution"));
+  vtkPVTraceScope traceScope(vtkPVTraceRecorder::DATA_DELIVERY,
+    low_res ? "low-resolution data migration" : "full resolution data migration");
   for (unsigned int cc = 0; cc < size; cc += 2)
   {
     const unsigned int id = values[cc];
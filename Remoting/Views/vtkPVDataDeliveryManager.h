@@ -91,6 +91,13 @@ public:
   bool HasPiece(vtkPVDataRepresentation* repr, bool low_res = false, int port = 0);
   //@}
 
+  /**
+   * Discards the piece for the representation's current cache-key. Unlike
+   * `SetPiece(repr, nullptr, ...)`, this is done even if the representation's
+   * data has not changed since the piece was set.
+   */
+  void ClearPiece(vtkPVDataRepresentation* repr, bool low_res, int port = 0);
+
   /**
    * Returns the local data object set by calling `SetPiece` (or from the
    * cache). This is the data object pre-delivery.
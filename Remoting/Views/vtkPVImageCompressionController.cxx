@@ -0,0 +1,231 @@
+/*=========================================================================
+
+  Program:   ParaView
+  Module:    vtkPVImageCompressionController.cxx
+
+  Copyright (c) Kitware, Inc.
+  All rights reserved.
+  See Copyright.txt or http://www.paraview.org/HTML/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+#include "vtkPVImageCompressionController.h"
+
+#include "vtkLZ4Compressor.h"
+#include "vtkObjectFactory.h"
+#include "vtkSmartPointer.h"
+#include "vtkSquirtCompressor.h"
+#include "vtkZlibImageCompressor.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+struct LevelDescription
+{
+  const char* Configuration;
+  bool LossLess;
+  // initial guesses, replaced by measurements as frames are sent.
+  double SecondsPerMegaPixel;
+  double Ratio;
+};
+
+const LevelDescription Levels[] = {
+  { "NULL", true, 0.0, 1.0 },
+  { "vtkLZ4Compressor 1 0", true, 0.004, 0.45 },
+  { "vtkZlibImageCompressor 1 1 0 0", true, 0.015, 0.30 },
+  { "vtkZlibImageCompressor 1 6 0 0", true, 0.040, 0.25 },
+  { "vtkLZ4Compressor 0 3", false, 0.005, 0.25 },
+  { "vtkSquirtCompressor 0 3", false, 0.004, 0.20 },
+  { "vtkZlibImageCompressor 0 6 3 0", false, 0.030, 0.12 },
+  { "vtkSquirtCompressor 0 5", false, 0.004, 0.12 },
+  { "vtkZlibImageCompressor 0 9 5 0", false, 0.060, 0.06 },
+};
+
+const int NumberOfLevels = static_cast<int>(sizeof(Levels) / sizeof(Levels[0]));
+
+// 100 Mbit/s, until measured.
+const double DefaultBandwidth = 12.5e6;
+}
+
+class vtkPVImageCompressionController::vtkInternals
+{
+public:
+  struct LevelStatistics
+  {
+    double SecondsPerMegaPixel;
+    double Ratio;
+    vtkSmartPointer<vtkImageCompressor> Compressor;
+  };
+
+  LevelStatistics Statistics[NumberOfLevels];
+  double Bandwidth;
+
+  vtkInternals() { this->Reset(); }
+
+  void Reset()
+  {
+    for (int cc = 0; cc < NumberOfLevels; ++cc)
+    {
+      this->Statistics[cc].SecondsPerMegaPixel = Levels[cc].SecondsPerMegaPixel;
+      this->Statistics[cc].Ratio = Levels[cc].Ratio;
+    }
+    this->Bandwidth = DefaultBandwidth;
+  }
+};
+
+vtkStandardNewMacro(vtkPVImageCompressionController);
+//----------------------------------------------------------------------------
+vtkPVImageCompressionController::vtkPVImageCompressionController()
+  : TargetFrameTime(0.05)
+  , SmoothingFactor(0.25)
+  , Internals(new vtkPVImageCompressionController::vtkInternals())
+{
+}
+
+//----------------------------------------------------------------------------
+vtkPVImageCompressionController::~vtkPVImageCompressionController()
+{
+}
+
+//----------------------------------------------------------------------------
+int vtkPVImageCompressionController::GetNumberOfLevels()
+{
+  return NumberOfLevels;
+}
+
+//----------------------------------------------------------------------------
+const char* vtkPVImageCompressionController::GetLevelConfiguration(int level)
+{
+  return (level >= 0 && level < NumberOfLevels) ? Levels[level].Configuration : nullptr;
+}
+
+//----------------------------------------------------------------------------
+bool vtkPVImageCompressionController::GetLevelIsLossLess(int level)
+{
+  return (level >= 0 && level < NumberOfLevels) ? Levels[level].LossLess : false;
+}
+
+//----------------------------------------------------------------------------
+vtkImageCompressor* vtkPVImageCompressionController::GetCompressor(int level)
+{
+  if (level <= 0 || level >= NumberOfLevels)
+  {
+    return nullptr;
+  }
+
+  auto& stats = this->Internals->Statistics[level];
+  if (stats.Compressor == nullptr)
+  {
+    const char* config = Levels[level].Configuration;
+    if (strncmp(config, "vtkLZ4Compressor", 16) == 0)
+    {
+      stats.Compressor = vtkSmartPointer<vtkLZ4Compressor>::New();
+    }
+    else if (strncmp(config, "vtkSquirtCompressor", 19) == 0)
+    {
+      stats.Compressor = vtkSmartPointer<vtkSquirtCompressor>::New();
+    }
+    else
+    {
+      stats.Compressor = vtkSmartPointer<vtkZlibImageCompressor>::New();
+    }
+    if (!stats.Compressor->RestoreConfiguration(config))
+    {
+      vtkWarningMacro("Could not configure the compressor, invalid stream. " << config << ".");
+    }
+  }
+  return stats.Compressor;
+}
+
+//----------------------------------------------------------------------------
+double vtkPVImageCompressionController::PredictFrameTime(
+  int level, vtkIdType numberOfPixels, vtkIdType numberOfBytes) const
+{
+  const auto& stats = this->Internals->Statistics[level];
+  return stats.SecondsPerMegaPixel * numberOfPixels * 1.0e-6 +
+    stats.Ratio * numberOfBytes / this->Internals->Bandwidth;
+}
+
+//----------------------------------------------------------------------------
+int vtkPVImageCompressionController::SelectLevel(
+  bool lossLess, vtkIdType numberOfPixels, vtkIdType numberOfBytes)
+{
+  int fastest = 0;
+  double fastestTime = this->PredictFrameTime(0, numberOfPixels, numberOfBytes);
+  for (int level = 0; level < NumberOfLevels; ++level)
+  {
+    if (lossLess && !Levels[level].LossLess)
+    {
+      continue;
+    }
+    const double time = this->PredictFrameTime(level, numberOfPixels, numberOfBytes);
+    if (!lossLess && time <= this->TargetFrameTime)
+    {
+      // levels are sorted by decreasing quality; this is the best one that
+      // fits the budget.
+      return level;
+    }
+    if (time < fastestTime)
+    {
+      fastest = level;
+      fastestTime = time;
+    }
+  }
+  return fastest;
+}
+
+//----------------------------------------------------------------------------
+void vtkPVImageCompressionController::RecordEncode(int level, vtkIdType numberOfPixels,
+  vtkIdType rawBytes, vtkIdType compressedBytes, double seconds)
+{
+  if (level < 0 || level >= NumberOfLevels || numberOfPixels <= 0 || rawBytes <= 0)
+  {
+    return;
+  }
+  auto& stats = this->Internals->Statistics[level];
+  const double alpha = this->SmoothingFactor;
+  stats.SecondsPerMegaPixel =
+    (1.0 - alpha) * stats.SecondsPerMegaPixel + alpha * seconds * 1.0e6 / numberOfPixels;
+  stats.Ratio = (1.0 - alpha) * stats.Ratio +
+    alpha * static_cast<double>(compressedBytes) / static_cast<double>(rawBytes);
+}
+
+//----------------------------------------------------------------------------
+void vtkPVImageCompressionController::RecordTransfer(vtkIdType numberOfBytes, double seconds)
+{
+  // very small messages, or ones absorbed by the socket buffers, say nothing
+  // useful about the link.
+  if (numberOfBytes < 4096 || seconds <= 0.0)
+  {
+    return;
+  }
+  const double alpha = this->SmoothingFactor;
+  this->Internals->Bandwidth =
+    (1.0 - alpha) * this->Internals->Bandwidth + alpha * numberOfBytes / seconds;
+}
+
+//----------------------------------------------------------------------------
+double vtkPVImageCompressionController::GetEstimatedBandwidth() const
+{
+  return this->Internals->Bandwidth;
+}
+
+//----------------------------------------------------------------------------
+void vtkPVImageCompressionController::Reset()
+{
+  this->Internals->Reset();
+}
+
+//----------------------------------------------------------------------------
+void vtkPVImageCompressionController::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "TargetFrameTime: " << this->TargetFrameTime << endl;
+  os << indent << "SmoothingFactor: " << this->SmoothingFactor << endl;
+  os << indent << "EstimatedBandwidth: " << this->Internals->Bandwidth << endl;
+}
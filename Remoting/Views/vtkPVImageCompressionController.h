@@ -0,0 +1,160 @@
+/*=========================================================================
+
+  Program:   ParaView
+  Module:    vtkPVImageCompressionController.h
+
+  Copyright (c) Kitware, Inc.
+  All rights reserved.
+  See Copyright.txt or http://www.paraview.org/HTML/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+/**
+ * @class   vtkPVImageCompressionController
+ * @brief   picks the image compressor per frame from measured throughput.
+ *
+ * vtkPVImageCompressionController is used by
+ * vtkPVClientServerSynchronizedRenderers to choose, for every frame, how the
+ * image is compressed before being sent to the client. It has a fixed ladder
+ * of compression levels, from no compression at all to aggressive lossy
+ * compression:
+ *
+ * level | compressor                         | loss-less
+ * ------|------------------------------------|----------
+ *   0   | none                               | yes
+ *   1   | LZ4                                | yes
+ *   2   | zlib, level 1                      | yes
+ *   3   | zlib, level 6                      | yes
+ *   4   | LZ4, colour space reduction 3      | no
+ *   5   | Squirt, colour space reduction 3   | no
+ *   6   | zlib, level 6, colour reduction 3  | no
+ *   7   | Squirt, colour space reduction 5   | no
+ *   8   | zlib, level 9, colour reduction 5  | no
+ *
+ * For each level, the controller keeps running averages of the encoding time
+ * per pixel and of the compression ratio, as reported by RecordEncode(). It
+ * also keeps a running average of the link throughput reported by
+ * RecordTransfer(). SelectLevel() predicts the time needed to encode and send
+ * an image at each level and returns the first level, i.e. the one with the
+ * best quality, expected to fit in TargetFrameTime. If none does, the fastest
+ * level is returned. Lossy levels are only considered for interactive renders;
+ * still renders always use the fastest loss-less level.
+ *
+ * Both ends of the connection use the same ladder, hence only the level needs
+ * to be transmitted with each image; see GetCompressor().
+ *
+ * @sa vtkPVClientServerSynchronizedRenderers
+ */
+
+#ifndef vtkPVImageCompressionController_h
+#define vtkPVImageCompressionController_h
+
+#include "vtkObject.h"
+#include "vtkRemotingViewsModule.h" // needed for exports
+
+#include <memory> // for std::unique_ptr
+
+class vtkImageCompressor;
+
+class VTKREMOTINGVIEWS_EXPORT vtkPVImageCompressionController : public vtkObject
+{
+public:
+  static vtkPVImageCompressionController* New();
+  vtkTypeMacro(vtkPVImageCompressionController, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  //@{
+  /**
+   * Target time, in seconds, to encode and transmit an image during
+   * interaction. Default is 0.05s.
+   */
+  vtkSetClampMacro(TargetFrameTime, double, 0.001, 10.0);
+  vtkGetMacro(TargetFrameTime, double);
+  //@}
+
+  //@{
+  /**
+   * Weight of the latest measurement in the running averages. Default is 0.25.
+   */
+  vtkSetClampMacro(SmoothingFactor, double, 0.01, 1.0);
+  vtkGetMacro(SmoothingFactor, double);
+  //@}
+
+  /**
+   * Returns the number of levels in the ladder.
+   */
+  static int GetNumberOfLevels();
+
+  /**
+   * Returns the compressor configuration string for a level, as understood by
+   * vtkPVClientServerSynchronizedRenderers::ConfigureCompressor(). Level 0
+   * returns "NULL".
+   */
+  static const char* GetLevelConfiguration(int level);
+
+  /**
+   * Returns true if the level is loss-less.
+   */
+  static bool GetLevelIsLossLess(int level);
+
+  /**
+   * Returns the compressor to use for a level, configured from
+   * GetLevelConfiguration(). Returns nullptr for level 0 (no compression).
+   * Compressors are created on demand and reused.
+   */
+  vtkImageCompressor* GetCompressor(int level);
+
+  /**
+   * Returns the level to use for an image with the given number of pixels and
+   * bytes. When `lossLess` is true, only loss-less levels are considered.
+   */
+  int SelectLevel(bool lossLess, vtkIdType numberOfPixels, vtkIdType numberOfBytes);
+
+  /**
+   * Returns the predicted time, in seconds, to encode and transmit an image
+   * with the given number of pixels and bytes at a level.
+   */
+  double PredictFrameTime(int level, vtkIdType numberOfPixels, vtkIdType numberOfBytes) const;
+
+  /**
+   * Records the time taken to encode an image at a level and the resulting
+   * compressed size.
+   */
+  void RecordEncode(int level, vtkIdType numberOfPixels, vtkIdType rawBytes,
+    vtkIdType compressedBytes, double seconds);
+
+  /**
+   * Records the time taken to transmit a number of bytes, up to their receipt
+   * by the other end of the connection.
+   */
+  void RecordTransfer(vtkIdType numberOfBytes, double seconds);
+
+  /**
+   * Returns the current estimate of the link throughput, in bytes per second.
+   */
+  double GetEstimatedBandwidth() const;
+
+  /**
+   * Forgets all measurements.
+   */
+  void Reset();
+
+protected:
+  vtkPVImageCompressionController();
+  ~vtkPVImageCompressionController() override;
+
+  double TargetFrameTime;
+  double SmoothingFactor;
+
+private:
+  vtkPVImageCompressionController(const vtkPVImageCompressionController&) = delete;
+  void operator=(const vtkPVImageCompressionController&) = delete;
+
+  class vtkInternals;
+  std::unique_ptr<vtkInternals> Internals;
+};
+
+#endif
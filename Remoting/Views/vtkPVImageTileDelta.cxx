@@ -0,0 +1,260 @@
+/*=========================================================================
+
+  Program:   ParaView
+  Module:    vtkPVImageTileDelta.cxx
+
+  Copyright (c) Kitware, Inc.
+  All rights reserved.
+  See Copyright.txt or http://www.paraview.org/HTML/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+#include "vtkPVImageTileDelta.h"
+
+#include "vtkObjectFactory.h"
+#include "vtkUnsignedCharArray.h"
+
+#include <algorithm>
+#include <cstring>
+
+vtkStandardNewMacro(vtkPVImageTileDelta);
+//----------------------------------------------------------------------------
+vtkPVImageTileDelta::vtkPVImageTileDelta()
+  : TileSize(64)
+  , NumberOfDirtyTiles(0)
+  , Reference(vtkUnsignedCharArray::New())
+{
+  this->ReferenceSize[0] = this->ReferenceSize[1] = 0;
+}
+
+//----------------------------------------------------------------------------
+vtkPVImageTileDelta::~vtkPVImageTileDelta()
+{
+  this->Reference->Delete();
+}
+
+//----------------------------------------------------------------------------
+void vtkPVImageTileDelta::SetTileSize(int size)
+{
+  size = std::max(size, 8);
+  if (this->TileSize != size)
+  {
+    this->TileSize = size;
+    this->Reset();
+    this->Modified();
+  }
+}
+
+//----------------------------------------------------------------------------
+void vtkPVImageTileDelta::Reset()
+{
+  this->Reference->Initialize();
+  this->ReferenceSize[0] = this->ReferenceSize[1] = 0;
+  this->NumberOfDirtyTiles = 0;
+}
+
+//----------------------------------------------------------------------------
+int vtkPVImageTileDelta::GetNumberOfTiles(int width, int height) const
+{
+  const int ts = this->TileSize;
+  return ((width + ts - 1) / ts) * ((height + ts - 1) / ts);
+}
+
+//----------------------------------------------------------------------------
+int vtkPVImageTileDelta::GetBitmapSize(int width, int height) const
+{
+  return (this->GetNumberOfTiles(width, height) + 7) / 8;
+}
+
+//----------------------------------------------------------------------------
+bool vtkPVImageTileDelta::HasReference(int width, int height, int numberOfComponents) const
+{
+  return width > 0 && height > 0 && this->ReferenceSize[0] == width &&
+    this->ReferenceSize[1] == height &&
+    this->Reference->GetNumberOfComponents() == numberOfComponents &&
+    this->Reference->GetNumberOfTuples() == static_cast<vtkIdType>(width) * height;
+}
+
+//----------------------------------------------------------------------------
+void vtkPVImageTileDelta::SetReference(vtkUnsignedCharArray* image, int width, int height)
+{
+  if (image == nullptr ||
+    image->GetNumberOfTuples() != static_cast<vtkIdType>(width) * height)
+  {
+    this->Reset();
+    return;
+  }
+  this->Reference->DeepCopy(image);
+  this->ReferenceSize[0] = width;
+  this->ReferenceSize[1] = height;
+}
+
+//----------------------------------------------------------------------------
+bool vtkPVImageTileDelta::Encode(vtkUnsignedCharArray* image, int width, int height,
+  vtkUnsignedCharArray* bitmap, vtkUnsignedCharArray* tiles)
+{
+  const int ncomps = image->GetNumberOfComponents();
+  if (!this->HasReference(width, height, ncomps))
+  {
+    this->SetReference(image, width, height);
+    this->NumberOfDirtyTiles = 0;
+    return false;
+  }
+
+  const int ts = this->TileSize;
+  const int tilesX = (width + ts - 1) / ts;
+  const int tilesY = (height + ts - 1) / ts;
+  const size_t rowStride = static_cast<size_t>(width) * ncomps;
+  const unsigned char* src = image->GetPointer(0);
+  unsigned char* ref = this->Reference->GetPointer(0);
+
+  bitmap->SetNumberOfComponents(1);
+  bitmap->SetNumberOfTuples(this->GetBitmapSize(width, height));
+  unsigned char* bits = bitmap->GetPointer(0);
+  std::fill(bits, bits + bitmap->GetNumberOfTuples(), 0);
+
+  // First pass: flag the tiles that differ from the reference. Rows of a tile
+  // are compared until the first difference, so unchanged regions, which are
+  // the common case while interacting with a mostly static scene, cost a single
+  // memcmp per tile row.
+  int numDirty = 0;
+  for (int ty = 0, tile = 0; ty < tilesY; ++ty)
+  {
+    const int y0 = ty * ts;
+    const int y1 = std::min(y0 + ts, height);
+    for (int tx = 0; tx < tilesX; ++tx, ++tile)
+    {
+      const int x0 = tx * ts;
+      const size_t rowBytes = static_cast<size_t>(std::min(ts, width - x0)) * ncomps;
+      for (int y = y0; y < y1; ++y)
+      {
+        const size_t offset = y * rowStride + static_cast<size_t>(x0) * ncomps;
+        if (memcmp(src + offset, ref + offset, rowBytes) != 0)
+        {
+          bits[tile >> 3] |= static_cast<unsigned char>(1 << (tile & 0x7));
+          ++numDirty;
+          break;
+        }
+      }
+    }
+  }
+
+  if (numDirty == tilesX * tilesY)
+  {
+    // everything changed, e.g. the camera moved; sending the full image avoids
+    // the cost of packing and padding the tiles.
+    memcpy(ref, src, rowStride * height);
+    this->NumberOfDirtyTiles = numDirty;
+    return false;
+  }
+
+  // Second pass: pack the dirty tiles one below the other into a TileSize wide
+  // image and update the reference. Partial tiles on the right and top edges
+  // are zero padded.
+  tiles->SetNumberOfComponents(ncomps);
+  tiles->SetNumberOfTuples(static_cast<vtkIdType>(ts) * ts * numDirty);
+  unsigned char* packed = numDirty > 0 ? tiles->GetPointer(0) : nullptr;
+  const size_t packedRowBytes = static_cast<size_t>(ts) * ncomps;
+  for (int ty = 0, tile = 0; ty < tilesY && numDirty > 0; ++ty)
+  {
+    const int y0 = ty * ts;
+    const int y1 = std::min(y0 + ts, height);
+    for (int tx = 0; tx < tilesX; ++tx, ++tile)
+    {
+      if ((bits[tile >> 3] & (1 << (tile & 0x7))) == 0)
+      {
+        continue;
+      }
+      const int x0 = tx * ts;
+      const size_t rowBytes = static_cast<size_t>(std::min(ts, width - x0)) * ncomps;
+      for (int y = y0; y < y0 + ts; ++y, packed += packedRowBytes)
+      {
+        if (y < y1)
+        {
+          const size_t offset = y * rowStride + static_cast<size_t>(x0) * ncomps;
+          memcpy(packed, src + offset, rowBytes);
+          memcpy(ref + offset, src + offset, rowBytes);
+          std::fill(packed + rowBytes, packed + packedRowBytes, 0);
+        }
+        else
+        {
+          std::fill(packed, packed + packedRowBytes, 0);
+        }
+      }
+    }
+  }
+
+  this->NumberOfDirtyTiles = numDirty;
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkPVImageTileDelta::Decode(vtkUnsignedCharArray* bitmap, vtkUnsignedCharArray* tiles,
+  int width, int height, int ncomps, vtkUnsignedCharArray* image)
+{
+  this->NumberOfDirtyTiles = 0;
+  if (!this->HasReference(width, height, ncomps) ||
+    bitmap->GetNumberOfTuples() < this->GetBitmapSize(width, height))
+  {
+    vtkErrorMacro("Cannot decode image delta without a matching reference image.");
+    return false;
+  }
+
+  const int ts = this->TileSize;
+  const int tilesX = (width + ts - 1) / ts;
+  const int tilesY = (height + ts - 1) / ts;
+  const size_t rowStride = static_cast<size_t>(width) * ncomps;
+  const size_t packedRowBytes = static_cast<size_t>(ts) * ncomps;
+  const unsigned char* bits = bitmap->GetPointer(0);
+  unsigned char* ref = this->Reference->GetPointer(0);
+
+  const vtkIdType packedTuples = tiles ? tiles->GetNumberOfTuples() : 0;
+  const unsigned char* packed = packedTuples > 0 ? tiles->GetPointer(0) : nullptr;
+  const unsigned char* packedEnd =
+    packed ? packed + static_cast<size_t>(packedTuples) * ncomps : nullptr;
+  for (int ty = 0, tile = 0; ty < tilesY; ++ty)
+  {
+    const int y0 = ty * ts;
+    const int y1 = std::min(y0 + ts, height);
+    for (int tx = 0; tx < tilesX; ++tx, ++tile)
+    {
+      if ((bits[tile >> 3] & (1 << (tile & 0x7))) == 0)
+      {
+        continue;
+      }
+      if (packed == nullptr || packed + packedRowBytes * ts > packedEnd)
+      {
+        vtkErrorMacro("Image delta has fewer tiles than flagged in its bitmap.");
+        this->Reset();
+        return false;
+      }
+      const int x0 = tx * ts;
+      const size_t rowBytes = static_cast<size_t>(std::min(ts, width - x0)) * ncomps;
+      for (int y = y0; y < y1; ++y)
+      {
+        memcpy(ref + y * rowStride + static_cast<size_t>(x0) * ncomps,
+          packed + (y - y0) * packedRowBytes, rowBytes);
+      }
+      packed += packedRowBytes * ts;
+      ++this->NumberOfDirtyTiles;
+    }
+  }
+
+  image->SetNumberOfComponents(ncomps);
+  image->SetNumberOfTuples(static_cast<vtkIdType>(width) * height);
+  memcpy(image->GetPointer(0), ref, rowStride * height);
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vtkPVImageTileDelta::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "TileSize: " << this->TileSize << endl;
+  os << indent << "NumberOfDirtyTiles: " << this->NumberOfDirtyTiles << endl;
+  os << indent << "ReferenceSize: " << this->ReferenceSize[0] << ", " << this->ReferenceSize[1]
+     << endl;
+}
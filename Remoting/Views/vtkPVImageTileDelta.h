@@ -0,0 +1,124 @@
+/*=========================================================================
+
+  Program:   ParaView
+  Module:    vtkPVImageTileDelta.h
+
+  Copyright (c) Kitware, Inc.
+  All rights reserved.
+  See Copyright.txt or http://www.paraview.org/HTML/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+/**
+ * @class   vtkPVImageTileDelta
+ * @brief   helper to transmit only the changed tiles of successive images.
+ *
+ * vtkPVImageTileDelta keeps a reference image and splits images into square
+ * tiles of TileSize x TileSize pixels. On the sending side, Encode() compares
+ * an image with the reference, tile by tile, and produces a bitmap with one bit
+ * per tile, set for tiles that changed, along with the pixels of the changed
+ * tiles packed into an image that is TileSize pixels wide and
+ * `TileSize * GetNumberOfDirtyTiles()` pixels tall. Such packed image can be
+ * compressed with any vtkImageCompressor. On the receiving side, Decode()
+ * patches its own reference image with the packed tiles.
+ *
+ * The sender and the receiver each keep their own reference, hence both must
+ * see the same sequence of images: every image that is not sent as a delta
+ * must be passed to SetReference() on both sides.
+ *
+ * Images are expected as vtkUnsignedCharArray with one tuple per pixel, in
+ * row-major order, as used by vtkSynchronizedRenderers::vtkRawImage.
+ *
+ * @sa vtkPVClientServerSynchronizedRenderers
+ */
+
+#ifndef vtkPVImageTileDelta_h
+#define vtkPVImageTileDelta_h
+
+#include "vtkObject.h"
+#include "vtkRemotingViewsModule.h" // needed for exports
+
+class vtkUnsignedCharArray;
+
+class VTKREMOTINGVIEWS_EXPORT vtkPVImageTileDelta : public vtkObject
+{
+public:
+  static vtkPVImageTileDelta* New();
+  vtkTypeMacro(vtkPVImageTileDelta, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  //@{
+  /**
+   * Get/Set the size of the tiles, in pixels. Changing the tile size resets the
+   * reference image. Default is 64.
+   */
+  void SetTileSize(int size);
+  vtkGetMacro(TileSize, int);
+  //@}
+
+  /**
+   * Discards the reference image. The next call to Encode() will return false.
+   */
+  void Reset();
+
+  /**
+   * Replaces the reference image with a copy of `image`.
+   */
+  void SetReference(vtkUnsignedCharArray* image, int width, int height);
+
+  /**
+   * Compares `image` with the reference image and fills `bitmap` and `tiles`
+   * with the changed tiles, as described in the class documentation. The
+   * reference is updated to match `image`. Returns false, after replacing the
+   * reference with `image`, if there's no reference image with the same
+   * dimensions and number of components or if all tiles changed; in that case
+   * `image` must be sent in full.
+   */
+  bool Encode(vtkUnsignedCharArray* image, int width, int height, vtkUnsignedCharArray* bitmap,
+    vtkUnsignedCharArray* tiles);
+
+  /**
+   * Patches the reference image with the changed tiles described by `bitmap`
+   * and `tiles` and copies the result to `image`. Returns false if there's no
+   * reference image with the given dimensions and number of components.
+   */
+  bool Decode(vtkUnsignedCharArray* bitmap, vtkUnsignedCharArray* tiles, int width, int height,
+    int numberOfComponents, vtkUnsignedCharArray* image);
+
+  /**
+   * Returns the number of tiles changed in the last call to Encode() or
+   * Decode().
+   */
+  vtkGetMacro(NumberOfDirtyTiles, int);
+
+  /**
+   * Returns the number of tiles needed to cover an image of the given size.
+   */
+  int GetNumberOfTiles(int width, int height) const;
+
+  /**
+   * Returns the number of bytes needed for the bitmap of an image with the
+   * given size.
+   */
+  int GetBitmapSize(int width, int height) const;
+
+protected:
+  vtkPVImageTileDelta();
+  ~vtkPVImageTileDelta() override;
+
+  bool HasReference(int width, int height, int numberOfComponents) const;
+
+  int TileSize;
+  int NumberOfDirtyTiles;
+  int ReferenceSize[2];
+  vtkUnsignedCharArray* Reference;
+
+private:
+  vtkPVImageTileDelta(const vtkPVImageTileDelta&) = delete;
+  void operator=(const vtkPVImageTileDelta&) = delete;
+};
+
+#endif
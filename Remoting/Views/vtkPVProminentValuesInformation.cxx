@@ -16,11 +16,13 @@
 
 #include "vtkAbstractArray.h"
 #include "vtkAlgorithmOutput.h"
+#include "vtkArrayDispatch.h"
 #include "vtkCellData.h"
 #include "vtkClientServerStream.h"
 #include "vtkCompositeDataIterator.h"
 #include "vtkCompositeDataSet.h"
 #include "vtkDataArray.h"
+#include "vtkDataArrayAccessor.h"
 #include "vtkDataSet.h"
 #include "vtkDataSetAttributes.h"
 #include "vtkExecutive.h"
@@ -34,12 +36,20 @@
 #include "vtkPVDataRepresentation.h"
 #include "vtkPVPostFilter.h"
 #include "vtkPointData.h"
+#include "vtkSMPThreadLocal.h"
+#include "vtkSMPTools.h"
 #include "vtkStringArray.h"
 #include "vtkTable.h"
 #include "vtkVariant.h"
 #include "vtkVariantArray.h"
+#include "vtkVariantCast.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <limits>
 #include <map>
+#include <memory>
 #include <set>
 #include <sstream>
 #include <vector>
@@ -56,6 +66,369 @@ class vtkPVProminentValuesInformation::vtkInternalDistinctValues
 {
 };
 
+namespace
+{
+// Values are compared and hashed on their bit patterns, so -0. and 0. are
+// made the same value, and so are all NaNs.
+template <typename T>
+inline T vtkCanonicalValue(T value)
+{
+  return value;
+}
+inline float vtkCanonicalValue(float value)
+{
+  return value == 0.f ? 0.f : (value != value ? std::numeric_limits<float>::quiet_NaN() : value);
+}
+inline double vtkCanonicalValue(double value)
+{
+  return value == 0. ? 0. : (value != value ? std::numeric_limits<double>::quiet_NaN() : value);
+}
+
+/**
+ * An open-addressing hash set of the distinct tuples of TupleSize values an
+ * array component (or the array tuples) takes on. Once more than
+ * MaximumSize tuples were added, the set overflows: its values would not be
+ * reported, so it drops them and ignores further tuples.
+ */
+template <typename T>
+class vtkDistinctTupleSet
+{
+public:
+  void Initialize(int tupleSize, size_t maximumSize)
+  {
+    this->TupleSize = tupleSize;
+    this->MaximumSize = maximumSize;
+    this->Size = 0;
+    this->Overflow = false;
+    this->Keys.assign(16 * tupleSize, T());
+    this->Used.assign(16, 0);
+  }
+
+  size_t GetSize() const { return this->Size; }
+  bool GetOverflow() const { return this->Overflow; }
+
+  /**
+   * Adds a tuple of canonical values. Returns false once the set overflows.
+   */
+  bool Insert(const T* tuple)
+  {
+    if (this->Overflow)
+    {
+      return false;
+    }
+    const size_t mask = this->Used.size() - 1;
+    size_t slot = this->Hash(tuple) & mask;
+    for (; this->Used[slot]; slot = (slot + 1) & mask)
+    {
+      if (std::memcmp(tuple, &this->Keys[slot * this->TupleSize], this->TupleSize * sizeof(T)) == 0)
+      {
+        return true;
+      }
+    }
+    if (this->Size == this->MaximumSize)
+    {
+      this->SetOverflow();
+      return false;
+    }
+    std::copy(tuple, tuple + this->TupleSize, &this->Keys[slot * this->TupleSize]);
+    this->Used[slot] = 1;
+    if (2 * ++this->Size > this->Used.size())
+    {
+      this->Grow();
+    }
+    return true;
+  }
+
+  /**
+   * Adds the tuples of another set. Returns false once the set overflows.
+   */
+  bool Merge(const vtkDistinctTupleSet& other)
+  {
+    if (other.Overflow)
+    {
+      this->SetOverflow();
+    }
+    for (size_t slot = 0; slot < other.Used.size() && !this->Overflow; ++slot)
+    {
+      if (other.Used[slot])
+      {
+        this->Insert(&other.Keys[slot * other.TupleSize]);
+      }
+    }
+    return !this->Overflow;
+  }
+
+  /**
+   * Inserts the tuples, as vtkVariants, into `values`.
+   */
+  void GetValues(std::set<std::vector<vtkVariant> >& values) const
+  {
+    std::vector<vtkVariant> tuple(this->TupleSize);
+    for (size_t slot = 0; slot < this->Used.size(); ++slot)
+    {
+      if (this->Used[slot])
+      {
+        for (int i = 0; i < this->TupleSize; ++i)
+        {
+          tuple[i] = vtkVariant(this->Keys[slot * this->TupleSize + i]);
+        }
+        values.insert(tuple);
+      }
+    }
+  }
+
+private:
+  void SetOverflow()
+  {
+    this->Overflow = true;
+    this->Size = 0;
+    std::vector<T>().swap(this->Keys);
+    std::vector<unsigned char>().swap(this->Used);
+  }
+
+  size_t Hash(const T* tuple) const
+  {
+    vtkTypeUInt64 hash = 0;
+    for (int i = 0; i < this->TupleSize; ++i)
+    {
+      vtkTypeUInt64 bits = 0;
+      std::memcpy(&bits, tuple + i, sizeof(T));
+      hash = (hash ^ bits) * 0x9e3779b97f4a7c15ULL;
+    }
+    // mix the high bits into the low bits the slot is taken from.
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    return static_cast<size_t>(hash);
+  }
+
+  void Grow()
+  {
+    std::vector<T> keys(2 * this->Keys.size());
+    std::vector<unsigned char> used(2 * this->Used.size(), 0);
+    keys.swap(this->Keys);
+    used.swap(this->Used);
+    const size_t mask = this->Used.size() - 1;
+    for (size_t cc = 0; cc < used.size(); ++cc)
+    {
+      if (used[cc])
+      {
+        size_t slot = this->Hash(&keys[cc * this->TupleSize]) & mask;
+        while (this->Used[slot])
+        {
+          slot = (slot + 1) & mask;
+        }
+        std::copy(&keys[cc * this->TupleSize], &keys[cc * this->TupleSize] + this->TupleSize,
+          &this->Keys[slot * this->TupleSize]);
+        this->Used[slot] = 1;
+      }
+    }
+  }
+
+  int TupleSize = 1;
+  size_t MaximumSize = 0;
+  size_t Size = 0;
+  bool Overflow = false;
+  std::vector<T> Keys;
+  std::vector<unsigned char> Used;
+};
+
+// Collects, over ranges of tuples in parallel, the distinct values of each
+// component of an array and, for arrays with more than one component, of its
+// tuples. Sets are indexed by component + 1 in the latter case, so that the
+// tuples come first.
+template <typename ArrayT>
+class vtkDistinctValuesFunctor
+{
+public:
+  using ValueT = typename vtkDataArrayAccessor<ArrayT>::APIType;
+  using SetsT = std::vector<vtkDistinctTupleSet<ValueT> >;
+
+  vtkDistinctValuesFunctor(ArrayT* array, size_t maximumNumberOfValues)
+    : Array(array)
+    , NumberOfComponents(array->GetNumberOfComponents())
+    , FirstComponent(array->GetNumberOfComponents() > 1 ? -1 : 0)
+    , MaximumNumberOfValues(maximumNumberOfValues)
+    , Overflow(new std::atomic<bool>[array->GetNumberOfComponents() + 1])
+  {
+    this->InitializeSets(this->Sets);
+    for (size_t cc = 0; cc < this->Sets.size(); ++cc)
+    {
+      this->Overflow[cc] = false;
+    }
+  }
+
+  void Initialize()
+  {
+    this->InitializeSets(this->LocalSets.Local());
+    this->LocalTuple.Local().resize(this->NumberOfComponents);
+  }
+
+  void operator()(vtkIdType begin, vtkIdType end)
+  {
+    vtkDataArrayAccessor<ArrayT> accessor(this->Array);
+    SetsT& sets = this->LocalSets.Local();
+    ValueT* tuple = this->LocalTuple.Local().data();
+    for (int c = this->FirstComponent; c < this->NumberOfComponents; ++c)
+    {
+      const int index = c - this->FirstComponent;
+      // once any thread saw too many values, so would the merged set.
+      if (this->Overflow[index])
+      {
+        continue;
+      }
+      vtkDistinctTupleSet<ValueT>& set = sets[index];
+      for (vtkIdType t = begin; t < end; ++t)
+      {
+        if (c < 0)
+        {
+          for (int i = 0; i < this->NumberOfComponents; ++i)
+          {
+            tuple[i] = vtkCanonicalValue(accessor.Get(t, i));
+          }
+        }
+        else
+        {
+          tuple[0] = vtkCanonicalValue(accessor.Get(t, c));
+        }
+        if (!set.Insert(tuple))
+        {
+          this->Overflow[index] = true;
+          break;
+        }
+      }
+    }
+  }
+
+  void Reduce()
+  {
+    for (auto iter = this->LocalSets.begin(); iter != this->LocalSets.end(); ++iter)
+    {
+      for (size_t cc = 0; cc < this->Sets.size(); ++cc)
+      {
+        if (!this->Overflow[cc] && !this->Sets[cc].Merge((*iter)[cc]))
+        {
+          this->Overflow[cc] = true;
+        }
+      }
+    }
+  }
+
+  /**
+   * Returns the distinct values of component `c` (-1 for the tuples), or
+   * false when there are too many of them.
+   */
+  bool GetValues(int c, std::set<std::vector<vtkVariant> >& values) const
+  {
+    const vtkDistinctTupleSet<ValueT>& set = this->Sets[c - this->FirstComponent];
+    if (this->Overflow[c - this->FirstComponent] || set.GetOverflow())
+    {
+      return false;
+    }
+    set.GetValues(values);
+    return true;
+  }
+
+private:
+  void InitializeSets(SetsT& sets) const
+  {
+    sets.resize(this->NumberOfComponents - this->FirstComponent);
+    for (int c = this->FirstComponent; c < this->NumberOfComponents; ++c)
+    {
+      sets[c - this->FirstComponent].Initialize(
+        c < 0 ? this->NumberOfComponents : 1, this->MaximumNumberOfValues);
+    }
+  }
+
+  ArrayT* Array;
+  const int NumberOfComponents;
+  const int FirstComponent;
+  const size_t MaximumNumberOfValues;
+  std::unique_ptr<std::atomic<bool>[]> Overflow;
+  SetsT Sets;
+  vtkSMPThreadLocal<SetsT> LocalSets;
+  vtkSMPThreadLocal<std::vector<ValueT> > LocalTuple;
+};
+
+// Returns the type of the values of `distincts` if they are all numeric of the
+// same type, or VTK_VARIANT.
+int vtkGetCommonValueType(const std::set<std::vector<vtkVariant> >& distincts)
+{
+  int valueType = -1;
+  for (const auto& tuple : distincts)
+  {
+    for (const vtkVariant& value : tuple)
+    {
+      if (!value.IsNumeric() || (valueType >= 0 && value.GetType() != valueType))
+      {
+        return VTK_VARIANT;
+      }
+      valueType = value.GetType();
+    }
+  }
+  return valueType >= 0 ? valueType : VTK_VARIANT;
+}
+
+template <typename T>
+void vtkInsertValues(
+  vtkClientServerStream* css, const std::set<std::vector<vtkVariant> >& distincts)
+{
+  std::vector<T> values;
+  for (const auto& tuple : distincts)
+  {
+    for (const vtkVariant& value : tuple)
+    {
+      values.push_back(vtkVariantCast<T>(value));
+    }
+  }
+  *css << vtkClientServerStream::InsertArray(values.data(), static_cast<int>(values.size()));
+}
+
+template <typename T>
+bool vtkExtractValues(const vtkClientServerStream* css, int pos, unsigned numberOfTuples,
+  int tupleSize, std::set<std::vector<vtkVariant> >& distincts)
+{
+  const vtkTypeUInt32 length = static_cast<vtkTypeUInt32>(numberOfTuples * tupleSize);
+  std::vector<T> values(length);
+  if (!css->GetArgument(0, pos, values.data(), length))
+  {
+    return false;
+  }
+  std::vector<vtkVariant> tuple(tupleSize);
+  for (unsigned j = 0; j < numberOfTuples; ++j)
+  {
+    for (int k = 0; k < tupleSize; ++k)
+    {
+      tuple[k] = vtkVariant(values[j * tupleSize + k]);
+    }
+    distincts.insert(tuple);
+  }
+  return true;
+}
+
+struct vtkDistinctValuesWorker
+{
+  size_t MaximumNumberOfValues;
+  std::map<int, std::set<std::vector<vtkVariant> > > Values;
+
+  template <typename ArrayT>
+  void operator()(ArrayT* array)
+  {
+    vtkDistinctValuesFunctor<ArrayT> functor(array, this->MaximumNumberOfValues);
+    vtkSMPTools::For(0, array->GetNumberOfTuples(), functor);
+    const int nc = array->GetNumberOfComponents();
+    for (int c = (nc > 1 ? -1 : 0); c < nc; ++c)
+    {
+      std::set<std::vector<vtkVariant> > values;
+      if (functor.GetValues(c, values))
+      {
+        this->Values[c].swap(values);
+      }
+    }
+  }
+};
+}
+
 vtkStandardNewMacro(vtkPVProminentValuesInformation);
 
 //----------------------------------------------------------------------------
@@ -331,22 +704,43 @@ void vtkPVProminentValuesInformation::CopyDistinctValuesFromObject(vtkAbstractAr
     this->DistinctValues = new vtkInternalDistinctValues;
   }
   int nc = this->GetNumberOfComponents();
+  const size_t maxDiscreteValues =
+    this->Force ? std::numeric_limits<size_t>::max() : array->GetMaxDiscreteValues();
+
+  // Numeric arrays are inspected by a typed hash set per component, filled in
+  // parallel; the values are only converted to vtkVariant once distinct.
+  vtkDistinctValuesWorker worker;
+  worker.MaximumNumberOfValues = maxDiscreteValues;
+  vtkDataArray* dataArray = vtkDataArray::SafeDownCast(array);
+  if (dataArray && dataArray->GetNumberOfComponents() == nc &&
+    vtkArrayDispatch::Dispatch::Execute(dataArray, worker))
+  {
+    for (int c = (nc > 1 ? -1 : 0); c < nc; ++c)
+    {
+      std::set<std::vector<vtkVariant> >& compDistincts((*this->DistinctValues)[c]);
+      compDistincts.swap(worker.Values[c]);
+      // no values means there were too many of them to be prominent, in
+      // which case this information is invalid
+      this->Valid = !compDistincts.empty();
+    }
+    return;
+  }
+
   vtkNew<vtkVariantArray> cvalues;
   std::vector<vtkVariant> tuple;
-  // bool tooManyValues;
   for (int c = (nc > 1 ? -1 : 0); c < nc; ++c)
   {
     int tupleSize = c < 0 ? nc : 1;
     tuple.resize(tupleSize);
     std::set<std::vector<vtkVariant> >& compDistincts((*this->DistinctValues)[c]);
     cvalues->Initialize();
-    unsigned int maxDiscreteValues = array->GetMaxDiscreteValues();
+    unsigned int arrayMaxDiscreteValues = array->GetMaxDiscreteValues();
     if (this->Force)
     {
       array->SetMaxDiscreteValues(VTK_UNSIGNED_INT_MAX);
     }
     array->GetProminentComponentValues(c, cvalues.GetPointer(), 0., 0.);
-    array->SetMaxDiscreteValues(maxDiscreteValues);
+    array->SetMaxDiscreteValues(arrayMaxDiscreteValues);
     vtkIdType nt = cvalues->GetNumberOfTuples();
     if (nt > 0)
     {
@@ -357,14 +751,6 @@ void vtkPVProminentValuesInformation::CopyDistinctValuesFromObject(vtkAbstractAr
           tuple[i] = cvalues->GetValue(i + t * tupleSize);
         }
         compDistincts.insert(tuple);
-        /*
-        if (compDistincts.insert(tuple).second)
-          {
-          if ((tooManyValues =
-            compDistincts.size() > vtkAbstractArray::MAX_DISCRETE_VALUES))
-            break;
-          }
-          */
       }
       this->Valid = true;
     }
@@ -427,15 +813,22 @@ void vtkPVProminentValuesInformation::CopyToStream(vtkClientServerStream* css)
     for (cit = this->DistinctValues->begin(); cit != this->DistinctValues->end(); ++cit)
     {
       unsigned nuv = static_cast<unsigned>(cit->second.size());
-      *css << cit->first << nuv;
-      vtkInternalDistinctValues::mapped_type::iterator eit;
-      for (eit = cit->second.begin(); eit != cit->second.end(); ++eit)
+      int valueType = ::vtkGetCommonValueType(cit->second);
+      *css << cit->first << nuv << valueType;
+      switch (valueType)
       {
-        std::vector<vtkVariant>::const_iterator vit;
-        for (vit = eit->begin(); vit != eit->end(); ++vit)
-        {
-          *css << *vit;
-        }
+        // values of a single numeric type are sent as one array.
+        vtkTemplateMacro(::vtkInsertValues<VTK_TT>(css, cit->second));
+        default:
+          vtkInternalDistinctValues::mapped_type::iterator eit;
+          for (eit = cit->second.begin(); eit != cit->second.end(); ++eit)
+          {
+            std::vector<vtkVariant>::const_iterator vit;
+            for (vit = eit->begin(); vit != eit->end(); ++vit)
+            {
+              *css << *vit;
+            }
+          }
       }
     }
   }
@@ -533,21 +926,40 @@ void vtkPVProminentValuesInformation::CopyFromStream(const vtkClientServerStream
         vtkErrorMacro("Error decoding the number of unique values for component " << i);
         return;
       }
+      int valueType;
+      if (!css->GetArgument(0, pos++, &valueType))
+      {
+        vtkErrorMacro("Error decoding the type of unique values for component " << i);
+        return;
+      }
       int tupleSize = (component < 0 ? this->NumberOfComponents : 1);
-      std::vector<vtkVariant> tuple;
-      tuple.resize(tupleSize);
-      for (unsigned j = 0; j < nuv; ++j)
+      std::set<std::vector<vtkVariant> >& compDistincts((*this->DistinctValues)[component]);
+      bool decoded = true;
+      switch (valueType)
       {
-        for (int k = 0; k < tupleSize; ++k)
-        {
-          if (!css->GetArgument(0, pos, &tuple[k]))
+        vtkTemplateMacro(
+          decoded = ::vtkExtractValues<VTK_TT>(css, pos++, nuv, tupleSize, compDistincts));
+        default:
+          std::vector<vtkVariant> tuple;
+          tuple.resize(tupleSize);
+          for (unsigned j = 0; j < nuv; ++j)
           {
-            vtkErrorMacro("Error decoding the " << k << "-th entry of the " << j
-                                                << "-th unique tuple for component " << i);
-            return;
+            for (int k = 0; k < tupleSize; ++k)
+            {
+              if (!css->GetArgument(0, pos++, &tuple[k]))
+              {
+                vtkErrorMacro("Error decoding the " << k << "-th entry of the " << j
+                                                    << "-th unique tuple for component " << i);
+                return;
+              }
+            }
+            compDistincts.insert(tuple);
           }
-        }
-        (*this->DistinctValues)[component].insert(tuple);
+      }
+      if (!decoded)
+      {
+        vtkErrorMacro("Error decoding the unique values for component " << i);
+        return;
       }
     }
   }
@@ -589,7 +1001,7 @@ void vtkPVProminentValuesInformation::AddDistinctValues(vtkPVProminentValuesInfo
     return;
   }
 
-  for (int i = 0; i <= this->NumberOfComponents; ++i)
+  for (int i = (this->NumberOfComponents > 1 ? -1 : 0); i < this->NumberOfComponents; ++i)
   {
     vtkInternalDistinctValues::iterator bit = info->DistinctValues->find(i);
     vtkInternalDistinctValues::mapped_type::iterator
@@ -26,7 +26,10 @@
  * given confidence that dictates the number of samples required), then
  * the prominent values are also made available.
  *
- * This class uses vtkAbstractArray::GetProminentComponentValues().
+ * Numeric arrays are inspected by a typed hash set per component (and for
+ * the tuples), filled in parallel with vtkSMPTools, which stops collecting a
+ * component's values as soon as there are too many of them. Other arrays use
+ * vtkAbstractArray::GetProminentComponentValues().
 */
 
 #ifndef vtkPVProminentValuesInformation_h
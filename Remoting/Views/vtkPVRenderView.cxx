@@ -69,6 +69,7 @@
 #include "vtkPVSession.h"
 #include "vtkPVStreamingMacros.h"
 #include "vtkPVSynchronizedRenderer.h"
+#include "vtkPVTraceRecorder.h"
 #include "vtkPVTrackballMultiRotate.h"
 #include "vtkPVTrackballRoll.h"
 #include "vtkPVTrackballRotate.h"
@@ -310,6 +311,7 @@ void vtkUpdateTrackballZoomManipulators(
 vtkStandardNewMacro(vtkPVRenderView);
 vtkInformationKeyMacro(vtkPVRenderView, USE_LOD, Integer);
 vtkInformationKeyMacro(vtkPVRenderView, USE_OUTLINE_FOR_LOD, Integer);
+vtkInformationKeyMacro(vtkPVRenderView, LOD_PENDING, Integer);
 vtkInformationKeyMacro(vtkPVRenderView, LOD_RESOLUTION, Double);
 vtkInformationKeyMacro(vtkPVRenderView, NEED_ORDERED_COMPOSITING, Integer);
 vtkInformationKeyMacro(vtkPVRenderView, RENDER_EMPTY_IMAGES, Integer);
@@ -359,6 +361,7 @@ vtkPVRenderView::vtkPVRenderView()
   this->LODRenderingThreshold = 0;
   this->LODResolution = 0.5;
   this->UseOutlineForLODRendering = false;
+  this->LODPending = false;
   this->UseLightKit = false;
   this->Interactor = 0;
   this->InteractorStyle = 0;
@@ -1243,6 +1246,7 @@ void vtkPVRenderView::Update()
   vtkVLogScopeF(PARAVIEW_LOG_RENDERING_VERBOSITY(), "%s: Update", this->GetLogName().c_str());
 
   vtkTimerLog::MarkStartEvent("RenderView::Update");
+  vtkPVTraceScope traceScope(vtkPVTraceRecorder::PIPELINE, "RenderView::Update");
 
   // reset flags that representations set in REQUEST_UPDATE() pass.
   this->DistributedRenderingRequired = false;
@@ -1351,6 +1355,21 @@ void vtkPVRenderView::UpdateLOD()
   this->CallProcessViewRequest(
     vtkPVView::REQUEST_UPDATE_LOD(), this->RequestInformation, this->ReplyInformationVector);
 
+  // Check if any representation provided provisional LOD geometry.
+  vtkTypeUInt64 lpending = 0;
+  int num_reprs = this->ReplyInformationVector->GetNumberOfInformationObjects();
+  for (int cc = 0; cc < num_reprs; cc++)
+  {
+    vtkInformation* info = this->ReplyInformationVector->GetInformationObject(cc);
+    if (info->Has(LOD_PENDING()) && (info->Get(LOD_PENDING()) != 0))
+    {
+      lpending = 1;
+    }
+  }
+  vtkTypeUInt64 gpending;
+  this->AllReduce(lpending, gpending, vtkCommunicator::MAX_OP);
+  this->LODPending = (gpending != 0);
+
   const vtkTypeUInt64 lsize = this->GetDeliveryManager()->GetVisibleDataSize(/*low_res*/ true);
   vtkTypeUInt64 gsize;
   this->AllReduce(lsize, gsize, vtkCommunicator::SUM_OP);
@@ -1377,6 +1396,7 @@ void vtkPVRenderView::StillRender()
   vtkVLogScopeF(PARAVIEW_LOG_RENDERING_VERBOSITY(), "%s: StillRender", this->GetLogName().c_str());
 
   vtkTimerLog::MarkStartEvent("Still Render");
+  vtkPVTraceScope traceScope(vtkPVTraceRecorder::RENDERING, "Still Render");
   this->GetRenderWindow()->SetDesiredUpdateRate(0.002);
 
   this->Internals->PreRender(this->RenderView);
@@ -1393,6 +1413,7 @@ void vtkPVRenderView::InteractiveRender()
     PARAVIEW_LOG_RENDERING_VERBOSITY(), "%s: InteractiveRender", this->GetLogName().c_str());
 
   vtkTimerLog::MarkStartEvent("Interactive Render");
+  vtkPVTraceScope traceScope(vtkPVTraceRecorder::RENDERING, "Interactive Render");
   this->GetRenderWindow()->SetDesiredUpdateRate(5.0);
 
   this->Internals->OSPRayCount = 0;
@@ -317,6 +317,13 @@ public:
    */
   static vtkInformationIntegerKey* USE_OUTLINE_FOR_LOD();
 
+  /**
+   * Representations set this key in the REQUEST_UPDATE_LOD() pass when the LOD
+   * geometry they provided is provisional, e.g. because a better level is
+   * still being computed in the background.
+   */
+  static vtkInformationIntegerKey* LOD_PENDING();
+
   /**
    * Representation can publish this key in their REQUEST_INFORMATION()
    * pass to indicate that the representation needs to disable
@@ -716,6 +723,13 @@ public:
    */
   virtual void UpdateLOD();
 
+  /**
+   * Returns true if any representation provided provisional LOD geometry in the
+   * most recent call to UpdateLOD(). In that case, UpdateLOD() should be
+   * called again before subsequent interactive renders.
+   */
+  vtkGetMacro(LODPending, bool);
+
   //@{
   /**
    * Returns whether the view will use LOD rendering for the next
@@ -1171,6 +1185,7 @@ protected:
   bool UsedLODForLastRender;
   bool UseLODForInteractiveRender;
   bool UseOutlineForLODRendering;
+  bool LODPending;
   bool UseDistributedRenderingForRender;
   bool UseDistributedRenderingForLODRender;
 
@@ -978,6 +978,15 @@ vtkDataObject* vtkPVView::GetDeliveredPieceLOD(
   return nullptr;
 }
 
+//-----------------------------------------------------------------------------
+void vtkPVView::ClearPieceLOD(vtkInformation* info, vtkPVDataRepresentation* repr, int port)
+{
+  if (auto dm = vtkPVView::GetDeliveryManager(info))
+  {
+    dm->ClearPiece(repr, true, port);
+  }
+}
+
 //----------------------------------------------------------------------------
 void vtkPVView::Deliver(int use_lod, unsigned int size, unsigned int* representation_ids)
 {
@@ -267,6 +267,12 @@ public:
   static vtkDataObject* GetDeliveredPieceLOD(
     vtkInformation* info, vtkPVDataRepresentation* repr, int port = 0);
 
+  /**
+   * Discards the LOD piece so that a subsequent SetPieceLOD() replaces it even
+   * if the representation's data has not changed since it was set.
+   */
+  static void ClearPieceLOD(vtkInformation* info, vtkPVDataRepresentation* repr, int port = 0);
+
   /**
    * Called on all processes to request data-delivery for the list of
    * representations. Note this method has to be called on all processes or it
@@ -173,7 +173,11 @@ void vtkSMRenderViewProxy::Update()
 //-----------------------------------------------------------------------------
 void vtkSMRenderViewProxy::UpdateLOD()
 {
-  if (this->ObjectsCreated && this->NeedsUpdateLOD)
+  // Representations may still be computing LOD geometry in the background, in
+  // which case we keep asking for LOD updates until they are done.
+  vtkPVRenderView* view = vtkPVRenderView::SafeDownCast(this->GetClientSideObject());
+  const bool lodPending = this->ObjectsCreated && view && view->GetLODPending();
+  if (this->ObjectsCreated && (this->NeedsUpdateLOD || lodPending))
   {
     vtkClientServerStream stream;
     stream << vtkClientServerStream::Invoke << VTKOBJECT(this) << "UpdateLOD"
@@ -0,0 +1,389 @@
+/*=========================================================================
+
+  Program:   ParaView
+  Module:    TestConnectedComponentLabeler.cxx
+
+  Copyright (c) Kitware, Inc.
+  All rights reserved.
+  See Copyright.txt or http://www.paraview.org/HTML/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// Labels a synthetic structured field with vtkConnectedComponentLabeler and
+// runs vtkAMRConnectivity on a synthetic AMR field, on one thread and on all
+// threads, and checks the results against a flood fill and known fragment
+// counts. Pass "--benchmark" to also report the timings.
+#include "vtkAMRConnectivity.h"
+#include "vtkCellData.h"
+#include "vtkConnectedComponentLabeler.h"
+#include "vtkDataSetAttributes.h"
+#include "vtkDoubleArray.h"
+#include "vtkDummyController.h"
+#include "vtkFieldData.h"
+#include "vtkIdTypeArray.h"
+#include "vtkIntArray.h"
+#include "vtkNew.h"
+#include "vtkNonOverlappingAMR.h"
+#include "vtkSMPTools.h"
+#include "vtkTimerLog.h"
+#include "vtkUniformGrid.h"
+#include "vtkUnsignedCharArray.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <set>
+#include <vector>
+
+#include <vtksys/CommandLineArguments.hxx>
+
+namespace
+{
+// Breadth first flood fill of the 26-connected components, the way the
+// connectivity filters labeled blocks before. Components are numbered in the
+// order of their first cell, as vtkConnectedComponentLabeler does.
+vtkIdType FloodFill(const int dims[3], const std::vector<unsigned char>& mask,
+  std::vector<vtkIdType>& labels)
+{
+  const vtkIdType numCells = static_cast<vtkIdType>(dims[0]) * dims[1] * dims[2];
+  labels.assign(numCells, 0);
+  std::vector<vtkIdType> todo;
+  vtkIdType numLabels = 0;
+  for (vtkIdType seed = 0; seed < numCells; ++seed)
+  {
+    if (!mask[seed] || labels[seed] != 0)
+    {
+      continue;
+    }
+    labels[seed] = ++numLabels;
+    todo.assign(1, seed);
+    while (!todo.empty())
+    {
+      const vtkIdType cellId = todo.back();
+      todo.pop_back();
+      const int i = cellId % dims[0];
+      const int j = (cellId / dims[0]) % dims[1];
+      const int k = cellId / (static_cast<vtkIdType>(dims[0]) * dims[1]);
+      for (int dk = -1; dk <= 1; ++dk)
+      {
+        for (int dj = -1; dj <= 1; ++dj)
+        {
+          for (int di = -1; di <= 1; ++di)
+          {
+            const int ni = i + di, nj = j + dj, nk = k + dk;
+            if (ni < 0 || nj < 0 || nk < 0 || ni >= dims[0] || nj >= dims[1] || nk >= dims[2])
+            {
+              continue;
+            }
+            const vtkIdType neighbor = ni + dims[0] * (nj + static_cast<vtkIdType>(dims[1]) * nk);
+            if (mask[neighbor] && labels[neighbor] == 0)
+            {
+              labels[neighbor] = numLabels;
+              todo.push_back(neighbor);
+            }
+          }
+        }
+      }
+    }
+  }
+  return numLabels;
+}
+
+const int BlockSize = 16;
+const int BlocksX = 4;
+const int BlocksY = 3;
+const int BlocksZ = 3;
+
+// Global cell (x, y, z) of the AMR field is inside a fragment: a rod along x
+// that crosses block boundaries in y and z, a cube in every block and a box
+// across the boundary of each pair of blocks along x.
+bool IsInside(int x, int y, int z)
+{
+  const int bx = x / BlockSize, lx = x % BlockSize;
+  const int ly = y % BlockSize, lz = z % BlockSize;
+  if (x < 0 || y < 0 || z < 0 || x >= BlocksX * BlockSize || y >= BlocksY * BlockSize ||
+    z >= BlocksZ * BlockSize)
+  {
+    return false;
+  }
+  if (y >= 14 && y <= 17 && z >= 14 && z <= 17)
+  {
+    return true;
+  }
+  if (lx >= 4 && lx <= 6 && ly >= 4 && ly <= 6 && lz >= 4 && lz <= 6)
+  {
+    return true;
+  }
+  if (y >= 40 && y <= 41 && z >= 40 && z <= 41 && bx + 1 < BlocksX)
+  {
+    return (bx % 2 == 0 && lx >= 12) || (bx % 2 == 1 && lx <= 3);
+  }
+  return false;
+}
+
+// A block with one layer of ghost cells, as vtkAMRDualGridHelper expects.
+vtkUniformGrid* NewBlock(int bx, int by, int bz)
+{
+  vtkUniformGrid* grid = vtkUniformGrid::New();
+  grid->SetOrigin(bx * BlockSize - 1, by * BlockSize - 1, bz * BlockSize - 1);
+  grid->SetSpacing(1.0, 1.0, 1.0);
+  grid->SetDimensions(BlockSize + 3, BlockSize + 3, BlockSize + 3);
+
+  const int size = BlockSize + 2;
+  vtkNew<vtkDoubleArray> fraction;
+  fraction->SetName("Fraction");
+  fraction->SetNumberOfTuples(size * size * size);
+  vtkNew<vtkUnsignedCharArray> ghosts;
+  ghosts->SetName(vtkDataSetAttributes::GhostArrayName());
+  ghosts->SetNumberOfTuples(size * size * size);
+  vtkIdType cellId = 0;
+  for (int k = 0; k < size; ++k)
+  {
+    for (int j = 0; j < size; ++j)
+    {
+      for (int i = 0; i < size; ++i, ++cellId)
+      {
+        const bool ghost = i == 0 || j == 0 || k == 0 || i == size - 1 || j == size - 1 ||
+          k == size - 1;
+        const bool inside =
+          IsInside(bx * BlockSize + i - 1, by * BlockSize + j - 1, bz * BlockSize + k - 1);
+        fraction->SetValue(cellId, inside ? 1.0 : 0.0);
+        ghosts->SetValue(cellId, ghost ? vtkDataSetAttributes::DUPLICATECELL : 0);
+      }
+    }
+  }
+  grid->GetCellData()->AddArray(fraction);
+  grid->GetCellData()->AddArray(ghosts);
+  return grid;
+}
+
+vtkNonOverlappingAMR* NewAMR()
+{
+  const int numBlocks = BlocksX * BlocksY * BlocksZ;
+  vtkNonOverlappingAMR* amr = vtkNonOverlappingAMR::New();
+  amr->Initialize(1, &numBlocks);
+  int blockIdx = 0;
+  for (int bz = 0; bz < BlocksZ; ++bz)
+  {
+    for (int by = 0; by < BlocksY; ++by)
+    {
+      for (int bx = 0; bx < BlocksX; ++bx, ++blockIdx)
+      {
+        vtkUniformGrid* grid = NewBlock(bx, by, bz);
+        amr->SetDataSet(0, blockIdx, grid);
+        grid->Delete();
+      }
+    }
+  }
+
+  // global meta data, so vtkAMRDualGridHelper does not have to guess which
+  // blocks have ghost cells.
+  vtkNew<vtkDoubleArray> bounds;
+  bounds->SetName("GlobalBounds");
+  bounds->SetNumberOfTuples(6);
+  vtkNew<vtkIntArray> boxSize;
+  boxSize->SetName("GlobalBoxSize");
+  boxSize->SetNumberOfTuples(3);
+  vtkNew<vtkIntArray> minLevel;
+  minLevel->SetName("MinLevel");
+  minLevel->SetNumberOfTuples(1);
+  minLevel->SetValue(0, 0);
+  vtkNew<vtkDoubleArray> minLevelSpacing;
+  minLevelSpacing->SetName("MinLevelSpacing");
+  minLevelSpacing->SetNumberOfTuples(3);
+  const int blocks[3] = { BlocksX, BlocksY, BlocksZ };
+  for (int cc = 0; cc < 3; ++cc)
+  {
+    bounds->SetValue(2 * cc, 0.0);
+    bounds->SetValue(2 * cc + 1, blocks[cc] * BlockSize);
+    boxSize->SetValue(cc, BlockSize + 2);
+    minLevelSpacing->SetValue(cc, 1.0);
+  }
+  amr->GetFieldData()->AddArray(bounds);
+  amr->GetFieldData()->AddArray(boxSize);
+  amr->GetFieldData()->AddArray(minLevel);
+  amr->GetFieldData()->AddArray(minLevelSpacing);
+  return amr;
+}
+
+// Returns the number of distinct regions in the non ghost cells of the output
+// and appends the region ids to `regions`.
+vtkIdType CountRegions(vtkNonOverlappingAMR* amr, std::vector<vtkIdType>& regions)
+{
+  std::set<vtkIdType> ids;
+  for (unsigned int blockIdx = 0; blockIdx < amr->GetNumberOfDataSets(0); ++blockIdx)
+  {
+    vtkUniformGrid* grid = amr->GetDataSet(0, blockIdx);
+    vtkIdTypeArray* regionIds =
+      vtkIdTypeArray::SafeDownCast(grid->GetCellData()->GetArray("RegionId-Fraction"));
+    vtkUnsignedCharArray* ghosts = grid->GetCellGhostArray();
+    if (!regionIds || !ghosts)
+    {
+      return -1;
+    }
+    for (vtkIdType cellId = 0; cellId < regionIds->GetNumberOfTuples(); ++cellId)
+    {
+      if ((ghosts->GetValue(cellId) & vtkDataSetAttributes::DUPLICATECELL) == 0)
+      {
+        regions.push_back(regionIds->GetValue(cellId));
+        if (regionIds->GetValue(cellId) > 0)
+        {
+          ids.insert(regionIds->GetValue(cellId));
+        }
+      }
+    }
+  }
+  return static_cast<vtkIdType>(ids.size());
+}
+}
+
+int TestConnectedComponentLabeler(int argc, char* argv[])
+{
+  bool benchmark = false;
+  vtksys::CommandLineArguments arg;
+  arg.Initialize(argc, argv);
+  arg.AddBooleanArgument("--benchmark", &benchmark, "Report the timings.");
+  arg.StoreUnusedArguments(true);
+  if (!arg.Parse())
+  {
+    cerr << "ERROR: Problem parsing arguments." << endl;
+    return EXIT_FAILURE;
+  }
+
+  vtkNew<vtkDummyController> controller;
+  vtkMultiProcessController::SetGlobalController(controller);
+
+  const int numThreads = vtkSMPTools::GetEstimatedNumberOfThreads();
+  vtkNew<vtkTimerLog> timer;
+
+  // structured field: blobs of a product of sines.
+  const int dims[3] = { 160, 160, 160 };
+  const vtkIdType numCells = static_cast<vtkIdType>(dims[0]) * dims[1] * dims[2];
+  std::vector<unsigned char> mask(numCells);
+  for (vtkIdType cellId = 0; cellId < numCells; ++cellId)
+  {
+    const int i = cellId % dims[0];
+    const int j = (cellId / dims[0]) % dims[1];
+    const int k = cellId / (dims[0] * dims[1]);
+    mask[cellId] = std::sin(0.21 * i) * std::sin(0.17 * j + 0.4) * std::sin(0.23 * k + 1.1) > 0.3;
+  }
+
+  std::vector<vtkIdType> expected;
+  timer->StartTimer();
+  const vtkIdType expectedCount = FloodFill(dims, mask, expected);
+  timer->StopTimer();
+  const double floodFillTime = timer->GetElapsedTime();
+
+  vtkNew<vtkConnectedComponentLabeler> labeler;
+  std::vector<vtkIdType> labels(numCells);
+  double labelTimes[2];
+  const int threads[2] = { 1, numThreads };
+  for (int cc = 0; cc < 2; ++cc)
+  {
+    vtkSMPTools::Initialize(threads[cc]);
+    std::fill(labels.begin(), labels.end(), -1);
+    timer->StartTimer();
+    const vtkIdType count = labeler->LabelBlock(dims, mask.data(), labels.data());
+    timer->StopTimer();
+    labelTimes[cc] = timer->GetElapsedTime();
+    if (count != expectedCount)
+    {
+      cerr << "ERROR: expected " << expectedCount << " components, got " << count << " on "
+           << threads[cc] << " threads." << endl;
+      return EXIT_FAILURE;
+    }
+    if (labels != expected)
+    {
+      cerr << "ERROR: labels differ from the flood fill on " << threads[cc] << " threads." << endl;
+      return EXIT_FAILURE;
+    }
+  }
+  if (benchmark)
+  {
+    cout << "structured " << dims[0] << "x" << dims[1] << "x" << dims[2] << ", " << expectedCount
+         << " components: flood fill " << floodFillTime << " s, labeler 1 thread "
+         << labelTimes[0] << " s, " << numThreads << " threads " << labelTimes[1]
+         << " s, speedup " << floodFillTime / labelTimes[1] << " (vs flood fill) "
+         << labelTimes[0] / labelTimes[1] << " (vs 1 thread)" << endl;
+  }
+
+  // equivalences and their numbering.
+  labeler->AddEquivalence(7, 3);
+  labeler->AddEquivalence(9, 7);
+  labeler->AddEquivalence(5, 2);
+  if (labeler->GetRepresentative(9) != 3 || labeler->GetRepresentative(5) != 2 ||
+    labeler->GetRepresentative(4) != 4)
+  {
+    cerr << "ERROR: wrong representatives." << endl;
+    return EXIT_FAILURE;
+  }
+  std::vector<int> setIds;
+  if (labeler->ResolveEquivalences(10, setIds) != 7)
+  {
+    cerr << "ERROR: wrong number of sets." << endl;
+    return EXIT_FAILURE;
+  }
+  if (setIds[9] != 3 || setIds[7] != 3 || setIds[5] != 2 || setIds[6] != 5)
+  {
+    cerr << "ERROR: wrong set ids." << endl;
+    return EXIT_FAILURE;
+  }
+  labeler->MergeAcrossProcesses(controller, std::vector<int>());
+  if (labeler->GetRepresentative(9) != 3)
+  {
+    cerr << "ERROR: merge changed a representative." << endl;
+    return EXIT_FAILURE;
+  }
+
+  // AMR field.
+  const vtkIdType expectedFragments = 1 + BlocksX * BlocksY * BlocksZ + BlocksX / 2;
+  std::vector<vtkIdType> regions[2];
+  double amrTimes[2];
+  for (int cc = 0; cc < 2; ++cc)
+  {
+    vtkSMPTools::Initialize(threads[cc]);
+    vtkNonOverlappingAMR* amr = NewAMR();
+    vtkNew<vtkAMRConnectivity> connectivity;
+    connectivity->SetInputData(amr);
+    connectivity->AddInputVolumeArrayToProcess("Fraction");
+    connectivity->SetVolumeFractionSurfaceValue(0.5);
+    connectivity->SetResolveBlocks(true);
+    amr->Delete();
+    timer->StartTimer();
+    connectivity->Update();
+    timer->StopTimer();
+    amrTimes[cc] = timer->GetElapsedTime();
+
+    vtkNonOverlappingAMR* output =
+      vtkNonOverlappingAMR::SafeDownCast(connectivity->GetOutputDataObject(0));
+    if (!output)
+    {
+      cerr << "ERROR: missing AMR output." << endl;
+      return EXIT_FAILURE;
+    }
+    const vtkIdType count = CountRegions(output, regions[cc]);
+    if (count != expectedFragments)
+    {
+      cerr << "ERROR: expected " << expectedFragments << " AMR fragments, got " << count << " on "
+           << threads[cc] << " threads." << endl;
+      return EXIT_FAILURE;
+    }
+  }
+  if (regions[0] != regions[1])
+  {
+    cerr << "ERROR: AMR regions depend on the number of threads." << endl;
+    return EXIT_FAILURE;
+  }
+  if (benchmark)
+  {
+    cout << "AMR " << BlocksX * BlocksY * BlocksZ << " blocks of " << BlockSize << "^3, "
+         << expectedFragments << " fragments: 1 thread " << amrTimes[0] << " s, " << numThreads
+         << " threads " << amrTimes[1] << " s, speedup " << amrTimes[0] / amrTimes[1] << endl;
+  }
+
+  vtkSMPTools::Initialize(numThreads);
+  vtkMultiProcessController::SetGlobalController(nullptr);
+  return EXIT_SUCCESS;
+}
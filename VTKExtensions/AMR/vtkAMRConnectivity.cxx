@@ -23,6 +23,7 @@
 #include "vtkCell.h"
 #include "vtkCellData.h"
 #include "vtkCompositeDataIterator.h"
+#include "vtkConnectedComponentLabeler.h"
 #include "vtkDataArray.h"
 #include "vtkDataObject.h"
 #include "vtkDataSet.h"
@@ -32,6 +33,7 @@
 #include "vtkIntArray.h"
 #include "vtkMultiProcessController.h"
 #include "vtkNonOverlappingAMR.h"
+#include "vtkSMPTools.h"
 #include "vtkSmartPointer.h"
 #include "vtkTimerLog.h"
 #include "vtkUniformGrid.h"
@@ -43,148 +45,13 @@
 #endif
 
 #include <list>
-#include <map>
+#include <vector>
 
 vtkStandardNewMacro(vtkAMRConnectivity);
 
-class vtkAMRConnectivityEquivalence
-{
-public:
-  vtkAMRConnectivityEquivalence()
-  {
-    set_to_min_id = vtkSmartPointer<vtkIntArray>::New();
-    set_to_min_id->SetNumberOfComponents(1);
-    set_to_min_id->SetNumberOfTuples(0);
-  }
-
-  ~vtkAMRConnectivityEquivalence() {}
-
-  int AddEquivalence(int id1, int id2)
-  {
-    int min_id;
-    if (id1 < id2)
-    {
-      min_id = id1;
-    }
-    else
-    {
-      min_id = id2;
-    }
-
-    std::map<int, int>::iterator iter;
-
-    iter = id_to_set.find(id1);
-    int set1 = (iter == id_to_set.end() ? -1 : iter->second);
-    iter = id_to_set.find(id2);
-    int set2 = (iter == id_to_set.end() ? -1 : iter->second);
-
-    if (set1 >= 0 && set_to_min_id->GetValue(set1) < 0)
-    {
-      set1 = -1;
-    }
-    if (set2 >= 0 && set_to_min_id->GetValue(set2) < 0)
-    {
-      set2 = -1;
-    }
-
-    if (set1 >= 0 && set2 >= 0 && set1 == set2)
-    {
-      return 0;
-    }
-    else if (set1 >= 0 && set2 >= 0)
-    {
-      // merge sets
-      int min_set, max_set;
-      if (set1 < set2)
-      {
-        min_set = set1;
-        max_set = set2;
-      }
-      else
-      {
-        min_set = set2;
-        max_set = set1;
-      }
-      for (iter = id_to_set.begin(); iter != id_to_set.end(); iter++)
-      {
-        if (iter->second == max_set)
-        {
-          id_to_set[iter->first] = min_set;
-        }
-      }
-      int max_set_min = set_to_min_id->GetValue(max_set);
-      int min_set_min = set_to_min_id->GetValue(min_set);
-      // pick the smallest of the two mins to represent the set.
-      if (max_set_min < min_set_min)
-      {
-        set_to_min_id->SetValue(min_set, max_set_min);
-      }
-      set_to_min_id->SetValue(max_set, -1);
-    }
-    else if (set1 >= 0)
-    {
-      id_to_set[id2] = set1;
-      if (id2 < set_to_min_id->GetValue(set1))
-      {
-        set_to_min_id->SetValue(set1, id2);
-      }
-    }
-    else if (set2 >= 0)
-    {
-      id_to_set[id1] = set2;
-      if (id1 < set_to_min_id->GetValue(set2))
-      {
-        set_to_min_id->SetValue(set2, id1);
-      }
-    }
-    else
-    {
-      // find an empty set.
-      int first_empty = -1;
-      for (int i = 0; i < set_to_min_id->GetNumberOfTuples(); i++)
-      {
-        if (set_to_min_id->GetValue(i) < 0)
-        {
-          first_empty = i;
-          break;
-        }
-      }
-      if (first_empty < 0)
-      {
-        first_empty = set_to_min_id->InsertNextValue(-1);
-      }
-
-      id_to_set[id1] = first_empty;
-      id_to_set[id2] = first_empty;
-      set_to_min_id->SetValue(first_empty, min_id);
-      // return zero here because its not values we've previously cared about.
-    }
-    return 1;
-  }
-
-  int GetMinimumSetId(int id)
-  {
-    std::map<int, int>::iterator iter = id_to_set.find(id);
-    if (iter == id_to_set.end())
-    {
-      // vtkErrorWithObjectMacro (id_to_set, << "ID out of range " << id << " (expected 0 <= x < "
-      // << id_to_set->GetNumberOfTuples () << ")");
-      return -1;
-    }
-    int set = id_to_set[id];
-    return (set >= 0 ? set_to_min_id->GetValue(set) : -1);
-  }
-
-private:
-  std::map<int, int> id_to_set;
-  vtkSmartPointer<vtkIntArray> set_to_min_id;
-};
-
 #if VTK_MODULE_ENABLE_VTK_ParallelMPI
 
 static const int BOUNDARY_TAG = 857089;
-static const int EQUIV_SIZE_TAG = 748957;
-static const int EQUIV_TAG = 357345;
 
 //-----------------------------------------------------------------------------
 // Simple containers for managing asynchronous communication.
@@ -240,13 +107,14 @@ vtkAMRConnectivity::vtkAMRConnectivity()
 {
   this->VolumeFractionSurfaceValue = 0.5;
   this->Helper = 0;
-  this->Equivalence = 0;
+  this->Labeler = vtkConnectedComponentLabeler::New();
   this->ResolveBlocks = 1;
   this->PropagateGhosts = 0;
 }
 
 vtkAMRConnectivity::~vtkAMRConnectivity()
 {
+  this->Labeler->Delete();
 }
 
 void vtkAMRConnectivity::PrintSelf(ostream& os, vtkIndent indent)
@@ -348,6 +216,7 @@ int vtkAMRConnectivity::DoRequestData(vtkNonOverlappingAMR* volume, const char*
   vtkTimerLog::MarkStartEvent("Initial fragment seeding");
 
   // Find the block local fragments
+  std::vector<unsigned char> mask;
   vtkCompositeDataIterator* iter = volume->NewIterator();
   for (iter->InitTraversal(); !iter->IsDoneWithTraversal(); iter->GoToNextItem())
   {
@@ -362,10 +231,6 @@ int vtkAMRConnectivity::DoRequestData(vtkNonOverlappingAMR* volume, const char*
     regionId->SetName(this->RegionName.c_str());
     regionId->SetNumberOfComponents(1);
     regionId->SetNumberOfTuples(grid->GetNumberOfCells());
-    for (int i = 0; i < grid->GetNumberOfCells(); i++)
-    {
-      regionId->SetTuple1(i, 0);
-    }
     grid->GetCellData()->AddArray(regionId);
 
     vtkDataArray* volArray = grid->GetCellData()->GetArray(volumeName);
@@ -385,27 +250,34 @@ int vtkAMRConnectivity::DoRequestData(vtkNonOverlappingAMR* volume, const char*
     // within each block find all fragments
     int extents[6];
     grid->GetExtent(extents);
+    int dims[3] = { extents[1] - extents[0], extents[3] - extents[2], extents[5] - extents[4] };
+    vtkIdType numCells = grid->GetNumberOfCells();
+    mask.resize(numCells);
+    double surfaceValue = this->VolumeFractionSurfaceValue;
+    vtkSMPTools::For(0, numCells, [&](vtkIdType begin, vtkIdType end) {
+      for (vtkIdType cellId = begin; cellId < end; ++cellId)
+      {
+        mask[cellId] = volArray->GetComponent(cellId, 0) > surfaceValue &&
+          (ghostArray->GetValue(cellId) & vtkDataSetAttributes::DUPLICATECELL) == 0;
+      }
+    });
 
-    for (int i = extents[0]; i < extents[1]; i++)
-    {
-      for (int j = extents[2]; j < extents[3]; j++)
+    vtkIdType* regionIds = regionId->GetPointer(0);
+    vtkIdType numRegions = this->Labeler->LabelBlock(dims, mask.data(), regionIds);
+
+    // offset the block labels (1 to numRegions) so the region ids remain
+    // globally unique
+    vtkIdType firstRegionId = this->NextRegionId;
+    vtkSMPTools::For(0, numCells, [&](vtkIdType begin, vtkIdType end) {
+      for (vtkIdType cellId = begin; cellId < end; ++cellId)
       {
-        for (int k = extents[4]; k < extents[5]; k++)
+        if (regionIds[cellId] > 0)
         {
-          int ijk[3] = { i, j, k };
-          vtkIdType cellId = grid->ComputeCellId(ijk);
-          if (regionId->GetTuple1(cellId) == 0 &&
-            volArray->GetTuple1(cellId) > this->VolumeFractionSurfaceValue &&
-            (ghostArray->GetValue(cellId) & vtkDataSetAttributes::DUPLICATECELL) == 0)
-          {
-            // wave propagation sets the region id as it propagates
-            this->WavePropagation(cellId, grid, regionId, volArray, ghostArray);
-            // increment this way so the region id remains globally unique
-            this->NextRegionId += numProcs;
-          }
+          regionIds[cellId] = firstRegionId + (regionIds[cellId] - 1) * numProcs;
         }
       }
-    }
+    });
+    this->NextRegionId += numRegions * numProcs;
   }
 
   vtkTimerLog::MarkEndEvent("Initial fragment seeding");
@@ -418,25 +290,6 @@ int vtkAMRConnectivity::DoRequestData(vtkNonOverlappingAMR* volume, const char*
     this->BoundaryArrays.resize(numProcs);
     this->ReceiveList.resize(numProcs);
     this->ValidNeighbor.resize(numProcs);
-    this->NeighborList.resize(this->Helper->GetNumberOfLevels());
-    for (int level = 0; level < this->Helper->GetNumberOfLevels(); level++)
-    {
-      int maxId = 0;
-      for (int blockId = 0; blockId < this->Helper->GetNumberOfBlocksInLevel(level); blockId++)
-      {
-        vtkAMRDualGridHelperBlock* block = this->Helper->GetBlock(level, blockId);
-        if (block->BlockId > maxId)
-        {
-          maxId = block->BlockId;
-        }
-      }
-      this->NeighborList[level].resize(maxId + 1);
-      for (int blockId = 0; blockId < maxId; blockId++)
-      {
-        this->NeighborList[level][blockId].resize(0);
-      }
-    }
-
     for (int level = 0; level < this->Helper->GetNumberOfLevels(); level++)
     {
       for (int blockId = 0; blockId < this->Helper->GetNumberOfBlocksInLevel(level); blockId++)
@@ -488,9 +341,7 @@ int vtkAMRConnectivity::DoRequestData(vtkNonOverlappingAMR* volume, const char*
     }
 #endif
     // Process all boundaries at the neighbors to find the equivalence pairs at the boundaries
-    this->Equivalence = new vtkAMRConnectivityEquivalence;
-
-    // Initialize equivalence with all regions independent
+    this->Labeler->ClearEquivalences();
     for (size_t i = 0; i < this->BoundaryArrays.size(); i++)
     {
       for (size_t j = 0; j < this->BoundaryArrays[i].size(); j++)
@@ -505,110 +356,45 @@ int vtkAMRConnectivity::DoRequestData(vtkNonOverlappingAMR* volume, const char*
     vtkTimerLog::MarkEndEvent("Computing boundary regions");
 
     vtkTimerLog::MarkStartEvent("Transferring equivalence");
-    this->EquivPairs.resize(numProcs);
-    while (true)
+    std::vector<int> neighbors;
+    for (int i = 0; i < numProcs; i++)
     {
-      int sets_changed = 0;
-      // Relabel all fragment IDs with the equivalence set number
-      // (set numbers start with 1 and 0 is considered "no set" or "no fragment")
-      for (int level = 0; level < this->Helper->GetNumberOfLevels(); level++)
+      if (i != myProc && this->ValidNeighbor[i])
       {
-        for (int blockId = 0; blockId < this->Helper->GetNumberOfBlocksInLevel(level); blockId++)
-        {
-          vtkAMRDualGridHelperBlock* block = this->Helper->GetBlock(level, blockId);
-          if (block->ProcessId != myProc)
-          {
-            continue;
-          }
-          vtkUniformGrid* grid = volume->GetDataSet(block->Level, block->BlockId);
-          vtkIdTypeArray* regionIdArray =
-            vtkIdTypeArray::SafeDownCast(grid->GetCellData()->GetArray(this->RegionName.c_str()));
-          if (regionIdArray == 0)
-          {
-            vtkErrorMacro("block Image doesn't not contain the regionId just added");
-            return 0;
-          }
-          for (int i = 0; i < regionIdArray->GetNumberOfTuples(); i++)
-          {
-            vtkIdType regionId = regionIdArray->GetTuple1(i);
-            if (regionId > 0)
-            {
-              int setId = this->Equivalence->GetMinimumSetId(regionId);
-              if (setId > 0 && setId != regionId)
-              {
-                regionIdArray->SetTuple1(i, setId);
-                sets_changed = 1;
-                for (size_t p = 0; p < this->NeighborList[block->Level][block->BlockId].size(); p++)
-                {
-                  int n = this->NeighborList[block->Level][block->BlockId][p];
-                  if (this->EquivPairs[n] == 0)
-                  {
-                    this->EquivPairs[n] = vtkSmartPointer<vtkIntArray>::New();
-                    this->EquivPairs[n]->SetNumberOfComponents(1);
-                    this->EquivPairs[n]->SetNumberOfTuples(0);
-                  }
-                  int contained = 0;
-                  for (int e = 0; e < this->EquivPairs[n]->GetNumberOfTuples(); e += 2)
-                  {
-                    int v1 = this->EquivPairs[n]->GetValue(e);
-                    int v2 = this->EquivPairs[n]->GetValue(e + 1);
-                    if ((v1 == regionId && v2 == setId) || (v2 == regionId && v1 == setId))
-                    {
-                      contained = 1;
-                    }
-                  }
-                  if (contained == 0)
-                  {
-                    this->EquivPairs[n]->InsertNextValue(regionId);
-                    this->EquivPairs[n]->InsertNextValue(setId);
-                  }
-                }
-              }
-            }
-            else
-            {
-              regionIdArray->SetTuple1(i, 0);
-            }
-          }
-        }
-      }
-#if VTK_MODULE_ENABLE_VTK_ParallelMPI
-      if (numProcs > 1)
-      {
-        int out;
-        controller->AllReduce(&sets_changed, &out, 1, vtkCommunicator::MAX_OP);
-        sets_changed = out;
-      }
-#endif
-      if (sets_changed == 0)
-      {
-        break;
+        neighbors.push_back(i);
       }
-#if VTK_MODULE_ENABLE_VTK_ParallelMPI
-      if (numProcs > 1 && !this->ExchangeEquivPairs(mpiController))
+    }
+    this->Labeler->MergeAcrossProcesses(controller, neighbors);
+    this->ValidNeighbor.clear();
+    vtkTimerLog::MarkEndEvent("Transferring equivalence");
+
+    // Relabel all fragment IDs with the smallest id of their equivalence set
+    // (0 is considered "no fragment")
+    vtkTimerLog::MarkStartEvent("Relabeling regions");
+    const vtkConnectedComponentLabeler* labeler = this->Labeler;
+    for (iter->InitTraversal(); !iter->IsDoneWithTraversal(); iter->GoToNextItem())
+    {
+      vtkUniformGrid* grid = vtkUniformGrid::SafeDownCast(iter->GetCurrentDataObject());
+      vtkIdTypeArray* regionIdArray =
+        vtkIdTypeArray::SafeDownCast(grid->GetCellData()->GetArray(this->RegionName.c_str()));
+      if (regionIdArray == 0)
       {
+        vtkErrorMacro("block Image doesn't not contain the regionId just added");
         return 0;
       }
-#endif
-      // clear out the pairs after sending them.
-      for (int i = 0; i < numProcs; i++)
-      {
-        if (this->EquivPairs[i] != 0)
+      vtkIdType* regionIds = regionIdArray->GetPointer(0);
+      vtkSMPTools::For(0, regionIdArray->GetNumberOfTuples(), [&](vtkIdType begin, vtkIdType end) {
+        for (vtkIdType cellId = begin; cellId < end; ++cellId)
         {
-          this->EquivPairs[i]->SetNumberOfTuples(0);
+          if (regionIds[cellId] > 0)
+          {
+            regionIds[cellId] = labeler->GetRepresentative(regionIds[cellId]);
+          }
         }
-      }
+      });
     }
-
-    // clean up EquivPairs for the last time this update
-    this->EquivPairs.clear();
-    ValidNeighbor.clear();
-    NeighborList.clear();
-
-    vtkTimerLog::MarkEndEvent("Transferring equivalence");
-
-    delete this->Equivalence;
-    this->Equivalence = 0;
+    this->Labeler->ClearEquivalences();
+    vtkTimerLog::MarkEndEvent("Relabeling regions");
   }
 
   if (PropagateGhosts)
@@ -662,47 +448,6 @@ int vtkAMRConnectivity::DoRequestData(vtkNonOverlappingAMR* volume, const char*
   return 1;
 }
 
-//----------------------------------------------------------------------------
-int vtkAMRConnectivity::WavePropagation(vtkIdType cellIdStart, vtkUniformGrid* grid,
-  vtkIdTypeArray* regionId, vtkDataArray* volArray, vtkUnsignedCharArray* ghostArray)
-{
-  vtkSmartPointer<vtkIdList> todoList = vtkIdList::New();
-  todoList->SetNumberOfIds(0);
-  todoList->InsertNextId(cellIdStart);
-
-  vtkSmartPointer<vtkIdList> ptIds = vtkIdList::New();
-  vtkSmartPointer<vtkIdList> cellIds = vtkIdList::New();
-
-  while (todoList->GetNumberOfIds() > 0)
-  {
-    vtkIdType cellId = todoList->GetId(0);
-    todoList->DeleteId(cellId);
-    regionId->SetTuple1(cellId, this->NextRegionId);
-
-    grid->GetCellPoints(cellId, ptIds);
-    for (int i = 0; i < ptIds->GetNumberOfIds(); i++)
-    {
-      cellIds->SetNumberOfIds(0);
-      grid->GetPointCells(ptIds->GetId(i), cellIds);
-      for (int j = 0; j < cellIds->GetNumberOfIds(); j++)
-      {
-        vtkIdType neighbor = cellIds->GetId(j);
-        if (neighbor == cellId || todoList->IsId(neighbor) >= 0)
-        {
-          continue;
-        }
-        if (regionId->GetTuple1(neighbor) == 0 &&
-          volArray->GetTuple1(neighbor) > this->VolumeFractionSurfaceValue &&
-          (ghostArray->GetValue(neighbor) & vtkDataSetAttributes::DUPLICATECELL) == 0)
-        {
-          todoList->InsertNextId(neighbor);
-        }
-      }
-    }
-  }
-  return 1;
-}
-
 //----------------------------------------------------------------------------
 vtkAMRDualGridHelperBlock* vtkAMRConnectivity::GetBlockNeighbor(
   vtkAMRDualGridHelperBlock* block, int dir)
@@ -756,35 +501,9 @@ void vtkAMRConnectivity::ProcessBoundaryAtBlock(vtkNonOverlappingAMR* volume,
 
   if (block->ProcessId != neighbor->ProcessId)
   {
-    int levelId, blockId, processId;
-    if (neighbor->ProcessId != myProc)
-    {
-      levelId = block->Level;
-      blockId = block->BlockId;
-      processId = neighbor->ProcessId;
-    }
-    else /* if (block->ProcessId != myProc) */
-    {
-      levelId = neighbor->Level;
-      blockId = neighbor->BlockId;
-      processId = block->ProcessId;
-    }
-
-    // Add this neighbor to this block's neighbor list.
-    bool contained = false;
-    for (size_t i = 0; i < this->NeighborList[levelId][blockId].size(); i++)
-    {
-      if (this->NeighborList[levelId][blockId][i] == processId)
-      {
-        contained = true;
-        break;
-      }
-    }
-    if (!contained)
-    {
-      this->NeighborList[levelId][blockId].push_back(processId);
-      this->ValidNeighbor[processId] = true;
-    }
+    // Regions of this block and of the other process may be equivalent.
+    int processId = neighbor->ProcessId != myProc ? neighbor->ProcessId : block->ProcessId;
+    this->ValidNeighbor[processId] = true;
   }
 
   if (block->ProcessId == myProc)
@@ -1043,144 +762,6 @@ int vtkAMRConnectivity::ExchangeBoundaries(vtkMPIController* controller)
   return 1;
 }
 
-int vtkAMRConnectivity::ExchangeEquivPairs(vtkMPIController* controller)
-{
-  if (controller == 0)
-  {
-    vtkErrorMacro("vtkAMRConnectivity only works parallel in MPI environment");
-    return 0;
-  }
-#if VTK_MODULE_ENABLE_VTK_ParallelMPI
-  int myProc = controller->GetLocalProcessId();
-  int numProcs = controller->GetNumberOfProcesses();
-
-  vtkAMRConnectivityCommRequestList receiveList;
-  for (size_t i = 0; i < static_cast<unsigned int>(numProcs); i++)
-  {
-    if (i == static_cast<unsigned int>(myProc) || !this->ValidNeighbor[i])
-    {
-      continue;
-    }
-
-    vtkSmartPointer<vtkIntArray> array = vtkSmartPointer<vtkIntArray>::New();
-    array->SetNumberOfComponents(1);
-    array->SetNumberOfTuples(1);
-
-    vtkAMRConnectivityCommRequest request;
-    request.SendProcess = static_cast<int>(i);
-    request.ReceiveProcess = myProc;
-    request.Buffer = array;
-
-    controller->NoBlockReceive(
-      array->GetPointer(0), 1, static_cast<int>(i), EQUIV_SIZE_TAG, request.Request);
-
-    this->ReceiveList[i].clear();
-    receiveList.push_back(request);
-  }
-
-  vtkAMRConnectivityCommRequestList sendList;
-  for (size_t i = 0; i < static_cast<unsigned int>(numProcs); i++)
-  {
-    if (i == static_cast<unsigned int>(myProc) || !this->ValidNeighbor[i])
-    {
-      continue;
-    }
-
-    vtkSmartPointer<vtkIntArray> array = vtkSmartPointer<vtkIntArray>::New();
-    array->SetNumberOfComponents(1);
-    array->SetNumberOfTuples(1);
-    int size = this->EquivPairs[i] == 0 ? 0 : this->EquivPairs[i]->GetNumberOfTuples();
-    array->SetTuple1(0, size);
-
-    vtkAMRConnectivityCommRequest request;
-    request.SendProcess = myProc;
-    request.ReceiveProcess = static_cast<int>(i);
-    request.Buffer = array;
-
-    controller->NoBlockSend(
-      array->GetPointer(0), 1, static_cast<int>(i), EQUIV_SIZE_TAG, request.Request);
-
-    sendList.push_back(request);
-  }
-
-  std::vector<int> receive_sizes(numProcs);
-  for (int i = 0; i < numProcs; i++)
-  {
-    receive_sizes[i] = 0;
-  }
-
-  while (!receiveList.empty())
-  {
-    vtkAMRConnectivityCommRequest request = receiveList.WaitAny();
-    vtkSmartPointer<vtkIntArray> array = request.Buffer;
-    receive_sizes[request.SendProcess] = array->GetTuple1(0);
-  }
-
-  receiveList.clear();
-  sendList.WaitAll();
-  sendList.clear();
-
-  for (size_t i = 0; i < static_cast<unsigned int>(numProcs); i++)
-  {
-    if (i == static_cast<unsigned int>(myProc) || receive_sizes[i] == 0)
-    {
-      continue;
-    }
-
-    vtkSmartPointer<vtkIntArray> array = vtkSmartPointer<vtkIntArray>::New();
-    array->SetNumberOfComponents(1);
-    array->SetNumberOfTuples(receive_sizes[i]);
-
-    vtkAMRConnectivityCommRequest request;
-    request.SendProcess = static_cast<int>(i);
-    request.ReceiveProcess = myProc;
-    request.Buffer = array;
-
-    controller->NoBlockReceive(
-      array->GetPointer(0), receive_sizes[i], static_cast<int>(i), EQUIV_TAG, request.Request);
-
-    this->ReceiveList[i].clear();
-    receiveList.push_back(request);
-  }
-
-  for (size_t i = 0; i < static_cast<unsigned int>(numProcs); i++)
-  {
-    if (i == static_cast<unsigned int>(myProc) || this->EquivPairs[i] == 0 ||
-      this->EquivPairs[i]->GetNumberOfTuples() == 0)
-    {
-      continue;
-    }
-
-    vtkAMRConnectivityCommRequest request;
-    request.SendProcess = myProc;
-    request.ReceiveProcess = static_cast<int>(i);
-    request.Buffer = this->EquivPairs[i];
-
-    controller->NoBlockSend(this->EquivPairs[i]->GetPointer(0),
-      this->EquivPairs[i]->GetNumberOfTuples(), static_cast<int>(i), EQUIV_TAG, request.Request);
-
-    sendList.push_back(request);
-  }
-
-  while (!receiveList.empty())
-  {
-    vtkAMRConnectivityCommRequest request = receiveList.WaitAny();
-    vtkSmartPointer<vtkIntArray> array = request.Buffer;
-    for (int i = 0; i < array->GetNumberOfTuples(); i += 2)
-    {
-      int v1 = array->GetValue(i);
-      int v2 = array->GetValue(i + 1);
-      this->Equivalence->AddEquivalence(v1, v2);
-    }
-  }
-
-  receiveList.clear();
-  sendList.WaitAll();
-  sendList.clear();
-#endif
-  return 1;
-}
-
 //----------------------------------------------------------------------------
 void vtkAMRConnectivity::ProcessBoundaryAtNeighbor(
   vtkNonOverlappingAMR* volume, vtkIdTypeArray* array)
@@ -1298,7 +879,7 @@ void vtkAMRConnectivity::ProcessBoundaryAtNeighbor(
           int blockRegion = array->GetTuple1(index);
           if (neighborRegion != 0 && blockRegion != 0)
           {
-            this->Equivalence->AddEquivalence(neighborRegion, blockRegion);
+            this->Labeler->AddEquivalence(neighborRegion, blockRegion);
           }
         }
         index++;
@@ -1319,7 +900,7 @@ void vtkAMRConnectivity::ProcessBoundaryAtNeighbor(
           int blockRegion = array->GetTuple1(index);
           if (neighborRegion != 0 && blockRegion != 0)
           {
-            this->Equivalence->AddEquivalence(neighborRegion, blockRegion);
+            this->Labeler->AddEquivalence(neighborRegion, blockRegion);
           }
           index++;
         }
@@ -16,9 +16,11 @@
  * @class   vtkAMRConnectivity
  * @brief   Identify fragments in the grid
  *
+ * Cells with a volume fraction above VolumeFractionSurfaceValue are labeled
+ * per block with vtkConnectedComponentLabeler, then regions of neighboring
+ * blocks that touch are merged, across processes if needed.
  *
- *
- * .SEE vtkAMRConnectivity
+ * .SEE vtkConnectedComponentLabeler
 */
 
 #ifndef vtkAMRConnectivity_h
@@ -31,14 +33,11 @@
 #include <vector>                        // STL required.
 
 class vtkNonOverlappingAMR;
-class vtkUniformGrid;
 class vtkIdTypeArray;
-class vtkIntArray;
 class vtkAMRDualGridHelper;
 class vtkAMRDualGridHelperBlock;
-class vtkAMRConnectivityEquivalence;
+class vtkConnectedComponentLabeler;
 class vtkMPIController;
-class vtkUnsignedCharArray;
 
 class VTKPVVTKEXTENSIONSAMR_EXPORT vtkAMRConnectivity : public vtkMultiBlockDataSetAlgorithm
 {
@@ -85,7 +84,7 @@ protected:
 
   double VolumeFractionSurfaceValue;
   vtkAMRDualGridHelper* Helper;
-  vtkAMRConnectivityEquivalence* Equivalence;
+  vtkConnectedComponentLabeler* Labeler;
 
   bool ResolveBlocks;
   bool PropagateGhosts;
@@ -99,8 +98,6 @@ protected:
   std::vector<std::vector<int> > ReceiveList;
 
   std::vector<bool> ValidNeighbor;
-  std::vector<std::vector<std::vector<int> > > NeighborList;
-  std::vector<vtkSmartPointer<vtkIntArray> > EquivPairs;
 
   int FillInputPortInformation(int port, vtkInformation* info) override;
   int FillOutputPortInformation(int port, vtkInformation* info) override;
@@ -108,14 +105,11 @@ protected:
   int RequestData(vtkInformation*, vtkInformationVector**, vtkInformationVector*) override;
 
   int DoRequestData(vtkNonOverlappingAMR*, const char*);
-  int WavePropagation(vtkIdType cellIdStart, vtkUniformGrid* grid, vtkIdTypeArray* regionId,
-    vtkDataArray* volArray, vtkUnsignedCharArray* ghostArray);
 
   vtkAMRDualGridHelperBlock* GetBlockNeighbor(vtkAMRDualGridHelperBlock* block, int dir);
   void ProcessBoundaryAtBlock(vtkNonOverlappingAMR* volume, vtkAMRDualGridHelperBlock* block,
     vtkAMRDualGridHelperBlock* neighbor, int dir);
   int ExchangeBoundaries(vtkMPIController* controller);
-  int ExchangeEquivPairs(vtkMPIController* controller);
   void ProcessBoundaryAtNeighbor(vtkNonOverlappingAMR* volume, vtkIdTypeArray* array);
 
 private:
@@ -0,0 +1,442 @@
+/*=========================================================================
+
+  Program:   ParaView
+  Module:    vtkConnectedComponentLabeler.cxx
+
+  Copyright (c) Kitware, Inc.
+  All rights reserved.
+  See Copyright.txt or http://www.paraview.org/HTML/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+#include "vtkConnectedComponentLabeler.h"
+
+#include "vtkCommunicator.h"
+#include "vtkMultiProcessController.h"
+#include "vtkObjectFactory.h"
+#include "vtkSMPTools.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <unordered_map>
+#include <utility>
+
+namespace
+{
+const int MERGE_SIZE_TAG = 482901;
+const int MERGE_TAG = 482902;
+
+//-----------------------------------------------------------------------------
+// Lock-free union-find over the cells of a block. A root is always linked to a
+// smaller root, so parents never increase and the root of a component is its
+// first cell.
+class vtkAtomicUnionFind
+{
+public:
+  void Allocate(vtkIdType size)
+  {
+    if (size > this->Capacity)
+    {
+      this->Parents.reset(new std::atomic<vtkIdType>[size]);
+      this->Capacity = size;
+    }
+  }
+
+  void MakeSet(vtkIdType id) { this->Parents[id].store(id, std::memory_order_relaxed); }
+
+  bool IsRoot(vtkIdType id) const { return this->Parents[id].load() == id; }
+
+  vtkIdType Find(vtkIdType id)
+  {
+    vtkIdType parent = this->Parents[id].load();
+    while (parent != id)
+    {
+      // path halving. Losing the race to another thread only means that the
+      // path is not shortened.
+      vtkIdType grandParent = this->Parents[parent].load();
+      if (grandParent != parent)
+      {
+        this->Parents[id].compare_exchange_weak(parent, grandParent);
+      }
+      id = grandParent;
+      parent = this->Parents[id].load();
+    }
+    return id;
+  }
+
+  void Union(vtkIdType id1, vtkIdType id2)
+  {
+    while (true)
+    {
+      id1 = this->Find(id1);
+      id2 = this->Find(id2);
+      if (id1 == id2)
+      {
+        return;
+      }
+      if (id1 < id2)
+      {
+        std::swap(id1, id2);
+      }
+      // fails if another thread linked id1 in the meantime, try again from
+      // the new roots.
+      vtkIdType expected = id1;
+      if (this->Parents[id1].compare_exchange_strong(expected, id2))
+      {
+        return;
+      }
+    }
+  }
+
+private:
+  std::unique_ptr<std::atomic<vtkIdType>[]> Parents;
+  vtkIdType Capacity = 0;
+};
+}
+
+//-----------------------------------------------------------------------------
+class vtkConnectedComponentLabeler::vtkInternals
+{
+public:
+  vtkAtomicUnionFind Cells;
+
+  // sparse union-find for the equivalences between component ids.
+  std::unordered_map<vtkIdType, vtkIdType> Parents;
+
+  vtkIdType FindRoot(vtkIdType id)
+  {
+    vtkIdType root = id;
+    auto iter = this->Parents.find(root);
+    while (iter != this->Parents.end() && iter->second != root)
+    {
+      root = iter->second;
+      iter = this->Parents.find(root);
+    }
+    while (id != root)
+    {
+      iter = this->Parents.find(id);
+      id = iter->second;
+      iter->second = root;
+    }
+    return root;
+  }
+
+  // points every id to its representative.
+  void Flatten()
+  {
+    for (auto& item : this->Parents)
+    {
+      item.second = this->FindRoot(item.second);
+    }
+  }
+};
+
+vtkStandardNewMacro(vtkConnectedComponentLabeler);
+//-----------------------------------------------------------------------------
+vtkConnectedComponentLabeler::vtkConnectedComponentLabeler()
+  : Internals(new vtkConnectedComponentLabeler::vtkInternals())
+{
+  this->Connectivity = POINT_CONNECTIVITY;
+}
+
+//-----------------------------------------------------------------------------
+vtkConnectedComponentLabeler::~vtkConnectedComponentLabeler()
+{
+}
+
+//-----------------------------------------------------------------------------
+vtkIdType vtkConnectedComponentLabeler::LabelBlock(
+  const int dims[3], const unsigned char* mask, vtkIdType* labels)
+{
+  const vtkIdType nx = std::max(dims[0], 1);
+  const vtkIdType ny = std::max(dims[1], 1);
+  const vtkIdType nz = std::max(dims[2], 1);
+  const vtkIdType numRows = ny * nz;
+
+  // offsets of the neighbors that are scanned before a cell.
+  int offsets[13][3];
+  int numOffsets = 0;
+  for (int dk = -1; dk <= 0; ++dk)
+  {
+    for (int dj = -1; dj <= 1; ++dj)
+    {
+      for (int di = -1; di <= 1; ++di)
+      {
+        const bool before = dk < 0 || (dk == 0 && (dj < 0 || (dj == 0 && di < 0)));
+        const int distance = std::abs(di) + std::abs(dj) + std::abs(dk);
+        if (before && (this->Connectivity == POINT_CONNECTIVITY || distance == 1))
+        {
+          offsets[numOffsets][0] = di;
+          offsets[numOffsets][1] = dj;
+          offsets[numOffsets][2] = dk;
+          ++numOffsets;
+        }
+      }
+    }
+  }
+
+  vtkAtomicUnionFind& cells = this->Internals->Cells;
+  cells.Allocate(nx * numRows);
+
+  // rows of cells (fixed j and k) are the unit of work in all passes.
+  vtkSMPTools::For(0, numRows, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType cellId = begin * nx; cellId < end * nx; ++cellId)
+    {
+      cells.MakeSet(cellId);
+    }
+  });
+
+  // first pass: join each cell with the neighbors scanned before it.
+  vtkSMPTools::For(0, numRows, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType row = begin; row < end; ++row)
+    {
+      const vtkIdType j = row % ny;
+      const vtkIdType k = row / ny;
+      for (vtkIdType i = 0; i < nx; ++i)
+      {
+        const vtkIdType cellId = row * nx + i;
+        if (!mask[cellId])
+        {
+          continue;
+        }
+        for (int cc = 0; cc < numOffsets; ++cc)
+        {
+          const vtkIdType ni = i + offsets[cc][0];
+          const vtkIdType nj = j + offsets[cc][1];
+          const vtkIdType nk = k + offsets[cc][2];
+          if (ni < 0 || ni >= nx || nj < 0 || nj >= ny || nk < 0)
+          {
+            continue;
+          }
+          const vtkIdType neighborId = ni + nx * (nj + ny * nk);
+          if (mask[neighborId])
+          {
+            cells.Union(cellId, neighborId);
+          }
+        }
+      }
+    }
+  });
+
+  // second pass: number the roots, in cell order, then label the other cells
+  // with the label of their root.
+  std::vector<vtkIdType> rowOffsets(numRows + 1, 0);
+  vtkSMPTools::For(0, numRows, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType row = begin; row < end; ++row)
+    {
+      vtkIdType count = 0;
+      for (vtkIdType cellId = row * nx; cellId < (row + 1) * nx; ++cellId)
+      {
+        count += (mask[cellId] && cells.IsRoot(cellId)) ? 1 : 0;
+      }
+      rowOffsets[row + 1] = count;
+    }
+  });
+  for (vtkIdType row = 0; row < numRows; ++row)
+  {
+    rowOffsets[row + 1] += rowOffsets[row];
+  }
+
+  vtkSMPTools::For(0, numRows, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType row = begin; row < end; ++row)
+    {
+      vtkIdType label = rowOffsets[row];
+      for (vtkIdType cellId = row * nx; cellId < (row + 1) * nx; ++cellId)
+      {
+        if (mask[cellId] && cells.IsRoot(cellId))
+        {
+          labels[cellId] = ++label;
+        }
+      }
+    }
+  });
+
+  vtkSMPTools::For(0, numRows, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType cellId = begin * nx; cellId < end * nx; ++cellId)
+    {
+      if (!mask[cellId])
+      {
+        labels[cellId] = 0;
+      }
+      else if (!cells.IsRoot(cellId))
+      {
+        labels[cellId] = labels[cells.Find(cellId)];
+      }
+    }
+  });
+
+  return rowOffsets[numRows];
+}
+
+//-----------------------------------------------------------------------------
+void vtkConnectedComponentLabeler::AddEquivalence(vtkIdType id1, vtkIdType id2)
+{
+  auto& parents = this->Internals->Parents;
+  parents.emplace(id1, id1);
+  parents.emplace(id2, id2);
+  vtkIdType root1 = this->Internals->FindRoot(id1);
+  vtkIdType root2 = this->Internals->FindRoot(id2);
+  if (root1 < root2)
+  {
+    parents[root2] = root1;
+  }
+  else if (root2 < root1)
+  {
+    parents[root1] = root2;
+  }
+}
+
+//-----------------------------------------------------------------------------
+vtkIdType vtkConnectedComponentLabeler::GetRepresentative(vtkIdType id) const
+{
+  const auto& parents = this->Internals->Parents;
+  auto iter = parents.find(id);
+  while (iter != parents.end() && iter->second != id)
+  {
+    id = iter->second;
+    iter = parents.find(id);
+  }
+  return id;
+}
+
+//-----------------------------------------------------------------------------
+vtkIdType vtkConnectedComponentLabeler::GetNumberOfEquivalentIds() const
+{
+  return static_cast<vtkIdType>(this->Internals->Parents.size());
+}
+
+//-----------------------------------------------------------------------------
+void vtkConnectedComponentLabeler::ClearEquivalences()
+{
+  this->Internals->Parents.clear();
+}
+
+//-----------------------------------------------------------------------------
+void vtkConnectedComponentLabeler::MergeAcrossProcesses(
+  vtkMultiProcessController* controller, const std::vector<int>& neighbors)
+{
+  this->Internals->Flatten();
+  if (controller == nullptr || controller->GetNumberOfProcesses() <= 1)
+  {
+    return;
+  }
+
+  const int myProc = controller->GetLocalProcessId();
+  std::vector<int> sortedNeighbors(neighbors);
+  std::sort(sortedNeighbors.begin(), sortedNeighbors.end());
+  sortedNeighbors.erase(
+    std::unique(sortedNeighbors.begin(), sortedNeighbors.end()), sortedNeighbors.end());
+
+  // Each round sends the (id, representative) pairs that changed since the
+  // previous round to all neighbors, until no process has anything to send.
+  // Representatives only decrease, so this ends after at most as many rounds
+  // as the longest chain of processes a fragment spans.
+  std::unordered_map<vtkIdType, vtkIdType> sent;
+  std::vector<vtkIdType> changes;
+  std::vector<vtkIdType> received;
+  while (true)
+  {
+    changes.clear();
+    for (const auto& item : this->Internals->Parents)
+    {
+      if (item.first == item.second)
+      {
+        continue;
+      }
+      auto iter = sent.find(item.first);
+      if (iter == sent.end() || iter->second != item.second)
+      {
+        changes.push_back(item.first);
+        changes.push_back(item.second);
+        sent[item.first] = item.second;
+      }
+    }
+
+    int localChanged = changes.empty() ? 0 : 1;
+    int changed = 0;
+    controller->AllReduce(&localChanged, &changed, 1, vtkCommunicator::MAX_OP);
+    if (!changed)
+    {
+      break;
+    }
+
+    // Blocking pairwise exchange. Neighbors are visited in increasing order
+    // and the lower rank of each pair sends first, which cannot deadlock.
+    vtkIdType sendSize = static_cast<vtkIdType>(changes.size());
+    for (int neighbor : sortedNeighbors)
+    {
+      if (neighbor == myProc)
+      {
+        continue;
+      }
+      vtkIdType receiveSize = 0;
+      if (myProc < neighbor)
+      {
+        controller->Send(&sendSize, 1, neighbor, MERGE_SIZE_TAG);
+        controller->Receive(&receiveSize, 1, neighbor, MERGE_SIZE_TAG);
+      }
+      else
+      {
+        controller->Receive(&receiveSize, 1, neighbor, MERGE_SIZE_TAG);
+        controller->Send(&sendSize, 1, neighbor, MERGE_SIZE_TAG);
+      }
+
+      received.resize(receiveSize);
+      if (myProc < neighbor)
+      {
+        if (sendSize > 0)
+        {
+          controller->Send(changes.data(), sendSize, neighbor, MERGE_TAG);
+        }
+        if (receiveSize > 0)
+        {
+          controller->Receive(received.data(), receiveSize, neighbor, MERGE_TAG);
+        }
+      }
+      else
+      {
+        if (receiveSize > 0)
+        {
+          controller->Receive(received.data(), receiveSize, neighbor, MERGE_TAG);
+        }
+        if (sendSize > 0)
+        {
+          controller->Send(changes.data(), sendSize, neighbor, MERGE_TAG);
+        }
+      }
+
+      for (vtkIdType cc = 0; cc + 1 < receiveSize; cc += 2)
+      {
+        this->AddEquivalence(received[cc], received[cc + 1]);
+      }
+    }
+    this->Internals->Flatten();
+  }
+}
+
+//-----------------------------------------------------------------------------
+int vtkConnectedComponentLabeler::ResolveEquivalences(
+  vtkIdType numberOfIds, std::vector<int>& setIds)
+{
+  setIds.resize(numberOfIds);
+  int count = 0;
+  for (vtkIdType id = 0; id < numberOfIds; ++id)
+  {
+    // the representative is the smallest id of the set, it is already numbered.
+    const vtkIdType root = this->Internals->FindRoot(id);
+    setIds[id] = (root == id) ? count++ : setIds[root];
+  }
+  return count;
+}
+
+//-----------------------------------------------------------------------------
+void vtkConnectedComponentLabeler::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "Connectivity: " << this->Connectivity << endl;
+  os << indent << "NumberOfEquivalentIds: " << this->GetNumberOfEquivalentIds() << endl;
+}
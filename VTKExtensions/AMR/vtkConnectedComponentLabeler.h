@@ -0,0 +1,129 @@
+/*=========================================================================
+
+  Program:   ParaView
+  Module:    vtkConnectedComponentLabeler.h
+
+  Copyright (c) Kitware, Inc.
+  All rights reserved.
+  See Copyright.txt or http://www.paraview.org/HTML/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+/**
+ * @class   vtkConnectedComponentLabeler
+ * @brief   connected-component kernel shared by the fragment filters.
+ *
+ * vtkConnectedComponentLabeler provides the pieces that the connectivity
+ * filters (vtkAMRConnectivity, vtkGridConnectivity) need to label fragments:
+ *
+ * \li LabelBlock() labels the connected cells of a structured block. It is a
+ * two-pass scan threaded with vtkSMPTools: the first pass joins each cell to
+ * its already scanned neighbors in a lock-free union-find, the second numbers
+ * the components. Labels do not depend on the number of threads.
+ * \li AddEquivalence() / GetRepresentative() keep track of component ids that
+ * belong to the same fragment, e.g. ids of different blocks that touch. The
+ * representative of a set of ids is its smallest id.
+ * \li MergeAcrossProcesses() makes the equivalences consistent across ranks by
+ * exchanging them with neighboring ranks only.
+ * \li ResolveEquivalences() numbers the sets of a dense range of ids.
+ */
+
+#ifndef vtkConnectedComponentLabeler_h
+#define vtkConnectedComponentLabeler_h
+
+#include "vtkObject.h"
+#include "vtkPVVTKExtensionsAMRModule.h" //needed for exports
+
+#include <memory> // for std::unique_ptr
+#include <vector> // for std::vector
+
+class vtkMultiProcessController;
+
+class VTKPVVTKEXTENSIONSAMR_EXPORT vtkConnectedComponentLabeler : public vtkObject
+{
+public:
+  static vtkConnectedComponentLabeler* New();
+  vtkTypeMacro(vtkConnectedComponentLabeler, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  enum ConnectivityModes
+  {
+    FACE_CONNECTIVITY = 6,
+    POINT_CONNECTIVITY = 26
+  };
+
+  //@{
+  /**
+   * Cells connected by LabelBlock(): cells that share a face or cells that
+   * share a point. Default is POINT_CONNECTIVITY.
+   */
+  vtkSetMacro(Connectivity, int);
+  vtkGetMacro(Connectivity, int);
+  //@}
+
+  /**
+   * Labels the connected cells of a block of `dims` cells, with x varying
+   * fastest. Cells with a non zero `mask` are labeled. On return, `labels` is
+   * 0 for cells that are not labeled and 1 to N for the N components, numbered
+   * in the order of their first cell. Returns N.
+   */
+  vtkIdType LabelBlock(const int dims[3], const unsigned char* mask, vtkIdType* labels);
+
+  /**
+   * Makes two ids equivalent. Ids must be positive or null.
+   */
+  void AddEquivalence(vtkIdType id1, vtkIdType id2);
+
+  /**
+   * Returns the smallest id equivalent to `id`, `id` itself if it was never
+   * made equivalent to another one. Does not modify the object, so it may be
+   * called from several threads once all equivalences are added.
+   */
+  vtkIdType GetRepresentative(vtkIdType id) const;
+
+  /**
+   * Returns the number of ids that were passed to AddEquivalence().
+   */
+  vtkIdType GetNumberOfEquivalentIds() const;
+
+  /**
+   * Removes all equivalences.
+   */
+  void ClearEquivalences();
+
+  /**
+   * Merges the equivalences of all processes of `controller`. On return, any
+   * process that knows an id returns the same representative for it, taking
+   * into account the equivalences added on all processes. `neighbors` are the
+   * processes that may know the same ids as this one, it must be symmetric.
+   * Equivalences are only exchanged with neighbors, over as many rounds as it
+   * takes for them to reach all processes. Collective operation.
+   */
+  void MergeAcrossProcesses(
+    vtkMultiProcessController* controller, const std::vector<int>& neighbors);
+
+  /**
+   * Numbers the sets formed by ids 0 to `numberOfIds` - 1 consecutively, in
+   * the order of their smallest id, and stores the number of each id in
+   * `setIds`. Returns the number of sets.
+   */
+  int ResolveEquivalences(vtkIdType numberOfIds, std::vector<int>& setIds);
+
+protected:
+  vtkConnectedComponentLabeler();
+  ~vtkConnectedComponentLabeler() override;
+
+  int Connectivity;
+
+private:
+  vtkConnectedComponentLabeler(const vtkConnectedComponentLabeler&) = delete;
+  void operator=(const vtkConnectedComponentLabeler&) = delete;
+
+  class vtkInternals;
+  std::unique_ptr<vtkInternals> Internals;
+};
+
+#endif
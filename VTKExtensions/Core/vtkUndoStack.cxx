@@ -51,8 +51,9 @@ void vtkUndoStack::Push(const char* label, vtkUndoSet* changeSet)
   while (this->Internal->UndoStack.size() >= static_cast<unsigned int>(this->StackDepth) &&
     this->StackDepth > 0)
   {
+    vtkSmartPointer<vtkUndoSet> removed = this->Internal->UndoStack.begin()->UndoSet;
     this->Internal->UndoStack.erase(this->Internal->UndoStack.begin());
-    this->InvokeEvent(vtkUndoStack::UndoSetRemovedEvent);
+    this->InvokeEvent(vtkUndoStack::UndoSetRemovedEvent, removed.GetPointer());
   }
   this->Internal->UndoStack.push_back(vtkUndoStackInternal::Element(label, changeSet));
   this->Modified();
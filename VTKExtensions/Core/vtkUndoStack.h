@@ -27,6 +27,10 @@
  * When a vtkUndoSet is pushed on the undo stack, the redo stack is
  * cleared.
  *
+ * When a push exceeds the stack depth, the oldest undo set is removed and
+ * UndoSetRemovedEvent is fired with that set as call data. Clear() fires
+ * UndoSetClearedEvent.
+ *
  * Each undo set are assigned user-readable labels providing information about
  * the operation(s) that will be undone/redone.
  *
@@ -69,6 +69,7 @@ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "CosmoToolsMacros.h"
 
 // VTK includes
+#include "vtkAOSDataArrayTemplate.h"
 #include "vtkCellType.h"
 #include "vtkDemandDrivenPipeline.h"
 #include "vtkDoubleArray.h"
@@ -82,6 +83,8 @@ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "vtkObjectFactory.h"
 #include "vtkPointData.h"
 #include "vtkPoints.h"
+#include "vtkSMPTools.h"
+#include "vtkSOADataArrayTemplate.h"
 #include "vtkSmartPointer.h"
 #include "vtkStreamingDemandDrivenPipeline.h"
 #include "vtkUnsignedCharArray.h"
@@ -105,12 +108,30 @@ namespace HaloFinderInternals
 class ParticleData
 {
 public:
-  // Input particle data
+  // Storage for the input particle data that cannot be used in place
   std::vector<POSVEL_T> xx, yy, zz, vx, vy, vz, mass, potential;
   std::vector<ID_T> tag;
   std::vector<STATUS_T> status;
   std::vector<MASK_T> mask;
 
+  // Particle arrays handed to the halo-finder. Each of these points either
+  // to the vectors above or directly into an input array whose memory layout
+  // already matches what the halo-finder expects.
+  vtkIdType NumberOfParticles;
+  POSVEL_T* X;
+  POSVEL_T* Y;
+  POSVEL_T* Z;
+  POSVEL_T* VX;
+  POSVEL_T* VY;
+  POSVEL_T* VZ;
+  POSVEL_T* Mass;
+  ID_T* Tag;
+
+  // Input arrays that are used in place, held to keep the memory alive.
+  std::vector<vtkSmartPointer<vtkDataArray> > InPlaceArrays;
+
+  ParticleData() { this->ResetViews(); }
+
   /**
    * @brief Resizes
    * @param numParticles
@@ -146,6 +167,20 @@ public:
     this->status.clear();
     this->potential.clear();
     this->mask.clear();
+    this->ResetViews();
+  }
+
+  /**
+   * @brief Resets the particle views & releases the in-place input arrays.
+   */
+  void ResetViews()
+  {
+    this->NumberOfParticles = 0;
+    this->X = this->Y = this->Z = nullptr;
+    this->VX = this->VY = this->VZ = nullptr;
+    this->Mass = nullptr;
+    this->Tag = nullptr;
+    this->InPlaceArrays.clear();
   }
 };
 
@@ -185,6 +220,133 @@ public:
     this->ExtractedHalos.clear();
   }
 };
+
+/**
+ * @brief Returns a pointer to the contiguous values of the given component if
+ * the array stores that component as a contiguous run of POSVEL_T, i.e., an
+ * AOS array with a single component or an SOA array. Returns nullptr if the
+ * values must be copied.
+ */
+static POSVEL_T* GetInPlaceComponent(vtkDataArray* array, int comp)
+{
+  if (auto soa = vtkArrayDownCast<vtkSOADataArrayTemplate<POSVEL_T> >(array))
+  {
+    return soa->GetComponentArrayPointer(comp);
+  }
+  auto aos = vtkArrayDownCast<vtkAOSDataArrayTemplate<POSVEL_T> >(array);
+  if (aos != nullptr && aos->GetNumberOfComponents() == 1)
+  {
+    return aos->GetPointer(0);
+  }
+  return nullptr;
+}
+
+/**
+ * @brief Returns a pointer to the particle tags if the array can be used in
+ * place, i.e., it stores single-component integers of the same width as ID_T.
+ */
+static ID_T* GetInPlaceTags(vtkDataArray* array)
+{
+  if (array->GetNumberOfComponents() != 1)
+  {
+    return nullptr;
+  }
+  if (auto aos = vtkArrayDownCast<vtkAOSDataArrayTemplate<ID_T> >(array))
+  {
+    return aos->GetPointer(0);
+  }
+  // vtkIdType and ID_T may be distinct types with the same representation,
+  // e.g., long long and int64_t (long) on LP64 platforms.
+  vtkIdTypeArray* ids = vtkIdTypeArray::SafeDownCast(array);
+  if (ids != nullptr && sizeof(vtkIdType) == sizeof(ID_T))
+  {
+    return reinterpret_cast<ID_T*>(ids->GetPointer(0));
+  }
+  return nullptr;
+}
+
+/**
+ * @brief Functor that computes the SOD halos of a list of FOF halos.
+ *
+ * SOD halos are independent of each other and only read the shared chaining
+ * mesh and particle arrays, hence they are computed concurrently with
+ * vtkSMPTools. Each SOD halo writes its properties to its own tuple of the
+ * pre-sized output arrays.
+ */
+class SODHaloFunctor
+{
+public:
+  // Inputs
+  cosmotk::ChainingMesh* ChainMesh;
+  ParticleData* Particles;
+  HaloData* Halos;
+  const int* HaloCount;
+  const std::vector<vtkIdType>* SODCandidates; // halo-center index
+  const double* Centers;
+
+  // SOD parameters
+  int SODBins;
+  float RL;
+  int NP;
+  float RhoC;
+  float SODMass;
+  float MinRadiusFactor;
+  float MaxRadiusFactor;
+
+  // Outputs
+  double* Position;
+  double* CenterOfMass;
+  double* Mass;
+  double* Velocity;
+  double* Dispersion;
+  double* Radius;
+
+  void operator()(vtkIdType begin, vtkIdType end)
+  {
+    for (vtkIdType candidate = begin; candidate < end; ++candidate)
+    {
+      const vtkIdType i = (*this->SODCandidates)[candidate];
+      const int internalHaloIdx = this->Halos->ExtractedHalos[i];
+
+      cosmotk::SODHalo sod;
+      sod.setParameters(this->ChainMesh, this->SODBins, this->RL, this->NP, this->RhoC,
+        this->SODMass, this->RhoC, this->MinRadiusFactor, this->MaxRadiusFactor);
+      sod.setParticles(this->Particles->NumberOfParticles, this->Particles->X, this->Particles->Y,
+        this->Particles->Z, this->Particles->VX, this->Particles->VY, this->Particles->VZ,
+        this->Particles->Mass, this->Particles->Tag);
+
+      const double* center = this->Centers + 3 * i;
+      sod.createSODHalo(this->HaloCount[internalHaloIdx], center[0], center[1], center[2],
+        this->Halos->fofXVel[internalHaloIdx], this->Halos->fofYVel[internalHaloIdx],
+        this->Halos->fofZVel[internalHaloIdx], this->Halos->fofMass[internalHaloIdx]);
+
+      if (sod.SODHaloSize() > 0)
+      {
+        POSVEL_T pos[3];
+        POSVEL_T cofmass[3];
+        POSVEL_T mass;
+        POSVEL_T vel[3];
+        POSVEL_T disp;
+
+        sod.SODAverageLocation(pos);
+        sod.SODCenterOfMass(cofmass);
+        sod.SODMass(&mass);
+        sod.SODAverageVelocity(vel);
+        sod.SODVelocityDispersion(&disp);
+
+        for (int dim = 0; dim < 3; ++dim)
+        {
+          this->Position[3 * i + dim] = pos[dim];
+          this->CenterOfMass[3 * i + dim] = cofmass[dim];
+          this->Velocity[3 * i + dim] = vel[dim];
+        }
+        this->Mass[i] = mass;
+        this->Dispersion[i] = disp;
+        this->Radius[i] = sod.SODRadius();
+      }
+    } // END for all SOD candidates in range
+  }
+};
 }
 
 vtkStandardNewMacro(vtkPLANLHaloFinder);
@@ -364,73 +526,59 @@ void vtkPLANLHaloFinder::ComputeSODHalos(
   assert("pre: missing SODAverageVelocity" && PD->HasArray("SODAverageVelocity"));
   assert("pre: missing SODVelocityDispersion" && PD->HasArray("SODVelocityDispersion"));
   assert("pre: missing SODRadius" && PD->HasArray("SODRadius"));
-  vtkDoubleArray* sodPos = vtkDoubleArray::SafeDownCast(PD->GetArray("SODAveragePosition"));
-  vtkDoubleArray* sodCofMass = vtkDoubleArray::SafeDownCast(PD->GetArray("SODCenterOfMass"));
-  vtkDoubleArray* sodMass = vtkDoubleArray::SafeDownCast(PD->GetArray("SODMass"));
-  vtkDoubleArray* sodVelocity = vtkDoubleArray::SafeDownCast(PD->GetArray("SODAverageVelocity"));
-  vtkDoubleArray* sodDispersion =
-    vtkDoubleArray::SafeDownCast(PD->GetArray("SODVelocityDispersion"));
-  vtkDoubleArray* sodRadius = vtkDoubleArray::SafeDownCast(PD->GetArray("SODRadius"));
+  double* sodPos = static_cast<double*>(PD->GetArray("SODAveragePosition")->GetVoidPointer(0));
+  double* sodCofMass = static_cast<double*>(PD->GetArray("SODCenterOfMass")->GetVoidPointer(0));
+  double* sodMass = static_cast<double*>(PD->GetArray("SODMass")->GetVoidPointer(0));
+  double* sodVelocity =
+    static_cast<double*>(PD->GetArray("SODAverageVelocity")->GetVoidPointer(0));
+  double* sodDispersion =
+    static_cast<double*>(PD->GetArray("SODVelocityDispersion")->GetVoidPointer(0));
+  double* sodRadius = static_cast<double*>(PD->GetArray("SODRadius")->GetVoidPointer(0));
 
   // STEP 1: Construct the ChainingMesh
-  cosmotk::ChainingMesh* chainMesh = new cosmotk::ChainingMesh(this->RL, this->Overlap,
-    cosmotk::CHAIN_SIZE, this->Particles->xx.size(), &this->Particles->xx[0],
-    &this->Particles->yy[0], &this->Particles->zz[0]);
-
-  // STEP 2: Loop through all halos and compute SOD halos
+  cosmotk::ChainingMesh* chainMesh =
+    new cosmotk::ChainingMesh(this->RL, this->Overlap, cosmotk::CHAIN_SIZE,
+      this->Particles->NumberOfParticles, this->Particles->X, this->Particles->Y, this->Particles->Z);
+
+  // STEP 2: Select the halos that are large enough to build an SOD halo
+  int* haloCount = this->HaloFinder->getHaloCount();
+  std::vector<vtkIdType> sodCandidates;
+  sodCandidates.reserve(this->Halos->ExtractedHalos.size());
   for (unsigned int i = 0; i < this->Halos->ExtractedHalos.size(); ++i)
   {
     int internalHaloIdx = this->Halos->ExtractedHalos[i];
-    int haloSize = this->HaloFinder->getHaloCount()[internalHaloIdx];
-
-    double haloMass = this->Halos->fofMass[internalHaloIdx];
-
-    if ((haloMass < this->MinFOFMass) || (haloSize < this->MinFOFSize))
+    if ((this->Halos->fofMass[internalHaloIdx] >= this->MinFOFMass) &&
+      (haloCount[internalHaloIdx] >= this->MinFOFSize))
     {
-      continue;
+      sodCandidates.push_back(i);
     }
-
-    cosmotk::SODHalo* sod = new cosmotk::SODHalo();
-    sod->setParameters(chainMesh, this->SODBins, this->RL, this->NP, this->RhoC, this->SODMass,
-      this->RhoC, this->MinRadiusFactor, this->MaxRadiusFactor);
-    sod->setParticles(this->Particles->xx.size(), &(this->Particles->xx[0]),
-      &(this->Particles->yy[0]), &(this->Particles->zz[0]), &(this->Particles->vx[0]),
-      &(this->Particles->vy[0]), &(this->Particles->vz[0]), &(this->Particles->mass[0]),
-      &(this->Particles->tag[0]));
-
-    double center[3];
-    fofHaloCenters->GetPoint(i, center);
-    sod->createSODHalo(this->HaloFinder->getHaloCount()[internalHaloIdx], center[0], center[1],
-      center[2], this->Halos->fofXVel[internalHaloIdx], this->Halos->fofYVel[internalHaloIdx],
-      this->Halos->fofZVel[internalHaloIdx], this->Halos->fofMass[internalHaloIdx]);
-
-    if (sod->SODHaloSize() > 0)
-    {
-      POSVEL_T pos[3];
-      POSVEL_T cofmass[3];
-      POSVEL_T mass;
-      POSVEL_T vel[3];
-      POSVEL_T disp;
-      POSVEL_T radius = sod->SODRadius();
-
-      sod->SODAverageLocation(pos);
-      sod->SODCenterOfMass(cofmass);
-      sod->SODMass(&mass);
-      sod->SODAverageVelocity(vel);
-      sod->SODVelocityDispersion(&disp);
-
-      sodPos->SetTuple3(i, pos[0], pos[1], pos[2]);
-      sodCofMass->SetTuple3(i, cofmass[0], cofmass[1], cofmass[2]);
-      sodMass->SetValue(i, mass);
-      sodVelocity->SetTuple3(i, vel[0], vel[1], vel[2]);
-      sodDispersion->SetValue(i, disp);
-      sodRadius->SetValue(i, radius);
-    }
-
-    delete sod;
   } // END for all halos within the PMIN threshold
 
-  // STEP 3: De-allocate Chain mesh
+  // STEP 3: Compute the SOD halos concurrently. The cost of a halo varies
+  // widely with its size, so use the smallest grain for load-balancing.
+  HaloFinderInternals::SODHaloFunctor sodFunctor;
+  sodFunctor.ChainMesh = chainMesh;
+  sodFunctor.Particles = this->Particles;
+  sodFunctor.Halos = this->Halos;
+  sodFunctor.HaloCount = haloCount;
+  sodFunctor.SODCandidates = &sodCandidates;
+  sodFunctor.Centers = static_cast<double*>(fofHaloCenters->GetPoints()->GetVoidPointer(0));
+  sodFunctor.SODBins = this->SODBins;
+  sodFunctor.RL = this->RL;
+  sodFunctor.NP = this->NP;
+  sodFunctor.RhoC = this->RhoC;
+  sodFunctor.SODMass = this->SODMass;
+  sodFunctor.MinRadiusFactor = this->MinRadiusFactor;
+  sodFunctor.MaxRadiusFactor = this->MaxRadiusFactor;
+  sodFunctor.Position = sodPos;
+  sodFunctor.CenterOfMass = sodCofMass;
+  sodFunctor.Mass = sodMass;
+  sodFunctor.Velocity = sodVelocity;
+  sodFunctor.Dispersion = sodDispersion;
+  sodFunctor.Radius = sodRadius;
+  vtkSMPTools::For(0, static_cast<vtkIdType>(sodCandidates.size()), 1, sodFunctor);
+
+  // STEP 4: De-allocate Chain mesh
   delete chainMesh;
 }
 
@@ -503,19 +651,16 @@ void vtkPLANLHaloFinder::VectorizeData(vtkUnstructuredGrid* particles)
 {
   assert("pre: input particles mesh is NULL" && (particles != NULL));
 
-  // TODO: VTK data arrays must match what POSVEL_T & ID_T are.
-
   vtkPoints* points = particles->GetPoints();
   assert("pre: points should not be NULL!" && (points != NULL));
 
-  vtkFloatArray* velocity =
-    vtkFloatArray::SafeDownCast(particles->GetPointData()->GetArray("velocity"));
+  vtkDataArray* velocity = particles->GetPointData()->GetArray("velocity");
   assert("pre: velocity should not be NULL!" && (velocity != NULL));
 
-  vtkFloatArray* pmass = vtkFloatArray::SafeDownCast(particles->GetPointData()->GetArray("mass"));
+  vtkDataArray* pmass = particles->GetPointData()->GetArray("mass");
   assert("pre: pmass should not be NULL!" && (pmass != NULL));
 
-  vtkIdTypeArray* uid = vtkIdTypeArray::SafeDownCast(particles->GetPointData()->GetArray("tag"));
+  vtkDataArray* uid = particles->GetPointData()->GetArray("tag");
   assert("pre: uid should not be NULL!" && (uid != NULL));
 
   vtkIntArray* owner = vtkIntArray::SafeDownCast(particles->GetPointData()->GetArray("ghost"));
@@ -528,28 +673,109 @@ void vtkPLANLHaloFinder::VectorizeData(vtkUnstructuredGrid* particles)
   int* haloTagPtr = static_cast<int*>(haloTag->GetVoidPointer(0));
 
   vtkIdType numParticles = points->GetNumberOfPoints();
-  this->Particles->Resize(numParticles);
+  HaloFinderInternals::ParticleData* pd = this->Particles;
+  pd->NumberOfParticles = numParticles;
+
+  // STEP 0: Use the input arrays in place where the layout allows it. The
+  // halo-finder only reads positions, velocities, masses & tags. The status
+  // vector is modified by the halo-finder and is therefore always copied.
+  pd->X = HaloFinderInternals::GetInPlaceComponent(points->GetData(), 0);
+  pd->Y = HaloFinderInternals::GetInPlaceComponent(points->GetData(), 1);
+  pd->Z = HaloFinderInternals::GetInPlaceComponent(points->GetData(), 2);
+  bool copyPositions = (pd->X == nullptr);
+  if (!copyPositions)
+  {
+    pd->InPlaceArrays.push_back(points->GetData());
+  }
+
+  pd->VX = HaloFinderInternals::GetInPlaceComponent(velocity, 0);
+  pd->VY = HaloFinderInternals::GetInPlaceComponent(velocity, 1);
+  pd->VZ = HaloFinderInternals::GetInPlaceComponent(velocity, 2);
+  bool copyVelocity = (pd->VX == nullptr);
+  if (!copyVelocity)
+  {
+    pd->InPlaceArrays.push_back(velocity);
+  }
+
+  pd->Mass = HaloFinderInternals::GetInPlaceComponent(pmass, 0);
+  bool copyMass = (pd->Mass == nullptr);
+  if (!copyMass)
+  {
+    pd->InPlaceArrays.push_back(pmass);
+  }
+
+  pd->Tag = HaloFinderInternals::GetInPlaceTags(uid);
+  bool copyTags = (pd->Tag == nullptr);
+  if (!copyTags)
+  {
+    pd->InPlaceArrays.push_back(uid);
+  }
+
+  // STEP 1: Copy whatever could not be used in place
+  if (copyPositions)
+  {
+    pd->xx.resize(numParticles);
+    pd->yy.resize(numParticles);
+    pd->zz.resize(numParticles);
+    pd->X = pd->xx.data();
+    pd->Y = pd->yy.data();
+    pd->Z = pd->zz.data();
+  }
+  if (copyVelocity)
+  {
+    pd->vx.resize(numParticles);
+    pd->vy.resize(numParticles);
+    pd->vz.resize(numParticles);
+    pd->VX = pd->vx.data();
+    pd->VY = pd->vy.data();
+    pd->VZ = pd->vz.data();
+  }
+  if (copyMass)
+  {
+    pd->mass.resize(numParticles);
+    pd->Mass = pd->mass.data();
+  }
+  if (copyTags)
+  {
+    pd->tag.resize(numParticles);
+    pd->Tag = pd->tag.data();
+  }
+  pd->status.resize(numParticles);
 
   for (vtkIdType idx = 0; idx < numParticles; ++idx)
   {
     // Extract position vector
-    this->Particles->xx[idx] = points->GetPoint(idx)[0];
-    this->Particles->yy[idx] = points->GetPoint(idx)[1];
-    this->Particles->zz[idx] = points->GetPoint(idx)[2];
+    if (copyPositions)
+    {
+      double pnt[3];
+      points->GetPoint(idx, pnt);
+      pd->xx[idx] = pnt[0];
+      pd->yy[idx] = pnt[1];
+      pd->zz[idx] = pnt[2];
+    }
 
     // Extract velocity vector
-    this->Particles->vx[idx] = velocity->GetComponent(idx, 0);
-    this->Particles->vy[idx] = velocity->GetComponent(idx, 1);
-    this->Particles->vz[idx] = velocity->GetComponent(idx, 2);
+    if (copyVelocity)
+    {
+      pd->vx[idx] = velocity->GetComponent(idx, 0);
+      pd->vy[idx] = velocity->GetComponent(idx, 1);
+      pd->vz[idx] = velocity->GetComponent(idx, 2);
+    }
 
     // Extract the mass
-    this->Particles->mass[idx] = pmass->GetValue(idx);
+    if (copyMass)
+    {
+      pd->mass[idx] = pmass->GetComponent(idx, 0);
+    }
 
     // Extract global particle ID information & also setup global-to-local map
-    this->Particles->tag[idx] = uid->GetValue(idx);
+    if (copyTags)
+    {
+      pd->tag[idx] = static_cast<ID_T>(uid->GetComponent(idx, 0));
+    }
 
     // Extract status
-    this->Particles->status[idx] = owner->GetValue(idx);
+    pd->status[idx] = owner->GetValue(idx);
 
     // Initialize all halo IDs to -1, i.e., all particles are not in halos
     haloTagPtr[idx] = -1;
@@ -580,10 +806,10 @@ void vtkPLANLHaloFinder::ComputeFOFHalos(
 
   // STEP 2: Initialize halo-finder parameters
   this->HaloFinder->setParameters("", this->RL, this->Overlap, this->NP, this->PMin, this->BB);
-  this->HaloFinder->setParticles(this->Particles->xx.size(), &this->Particles->xx[0],
-    &this->Particles->yy[0], &this->Particles->zz[0], &this->Particles->vx[0],
-    &this->Particles->vy[0], &this->Particles->vz[0], &this->Particles->potential[0],
-    &this->Particles->tag[0], &this->Particles->mask[0], &this->Particles->status[0]);
+  this->HaloFinder->setParticles(this->Particles->NumberOfParticles, this->Particles->X,
+    this->Particles->Y, this->Particles->Z, this->Particles->VX, this->Particles->VY,
+    this->Particles->VZ, &this->Particles->potential[0], this->Particles->Tag,
+    &this->Particles->mask[0], &this->Particles->status[0]);
 
   // STEP 3: Execute the halo-finder
   this->HaloFinder->executeHaloFinder();
@@ -665,10 +891,10 @@ void vtkPLANLHaloFinder::MarkHaloParticlesAndGetCenter(const unsigned int halo,
   cosmotk::FOFHaloProperties* fof = new cosmotk::FOFHaloProperties();
   fof->setHalos(numberOfHalos, fofHalos, fofHaloCount, fofHaloList);
   fof->setParameters("", this->RL, this->Overlap, this->BB);
-  fof->setParticles(this->Particles->xx.size(), &this->Particles->xx[0], &this->Particles->yy[0],
-    &this->Particles->zz[0], &this->Particles->vx[0], &this->Particles->vy[0],
-    &this->Particles->vz[0], &this->Particles->mass[0], &this->Particles->potential[0],
-    &this->Particles->tag[0], &this->Particles->mask[0], &this->Particles->status[0]);
+  fof->setParticles(this->Particles->NumberOfParticles, this->Particles->X, this->Particles->Y,
+    this->Particles->Z, this->Particles->VX, this->Particles->VY, this->Particles->VZ,
+    this->Particles->Mass, &this->Particles->potential[0], this->Particles->Tag,
+    &this->Particles->mask[0], &this->Particles->status[0]);
 
   // STEP 2: Get the particle halo information for the given halo with the given
   // internal halo idx. The halo finder find halos in [0, N]. However, we
@@ -833,10 +1059,10 @@ void vtkPLANLHaloFinder::ComputeFOFHaloProperties()
   cosmotk::FOFHaloProperties* fof = new cosmotk::FOFHaloProperties();
   fof->setHalos(numberOfHalos, fofHalos, fofHaloCount, fofHaloList);
   fof->setParameters("", this->RL, this->Overlap, this->BB);
-  fof->setParticles(this->Particles->xx.size(), &this->Particles->xx[0], &this->Particles->yy[0],
-    &this->Particles->zz[0], &this->Particles->vx[0], &this->Particles->vy[0],
-    &this->Particles->vz[0], &this->Particles->mass[0], &this->Particles->potential[0],
-    &this->Particles->tag[0], &this->Particles->mask[0], &this->Particles->status[0]);
+  fof->setParticles(this->Particles->NumberOfParticles, this->Particles->X, this->Particles->Y,
+    this->Particles->Z, this->Particles->VX, this->Particles->VY, this->Particles->VZ,
+    this->Particles->Mass, &this->Particles->potential[0], this->Particles->Tag,
+    &this->Particles->mask[0], &this->Particles->status[0]);
 
   // Compute average halo position if that's what will be used as the halo
   // center position
@@ -886,6 +1112,7 @@ void vtkPLANLHaloFinder::ResetHaloFinderInternals()
   this->Particles->tag.resize(0);
   this->Particles->status.resize(0);
   this->Particles->mask.resize(0);
+  this->Particles->ResetViews();
 
   // computed FOF properties
   this->Halos->fofMass.resize(0);
@@ -264,13 +264,17 @@ protected:
   void ComputeFOFHalos(vtkUnstructuredGrid* particles, vtkUnstructuredGrid* haloCenters);
 
   /**
-   * Given pre-computed FOF halos, this method computes the SOD halos.
+   * Given pre-computed FOF halos, this method computes the SOD halos. The SOD
+   * halos are independent of each other and are computed concurrently using
+   * vtkSMPTools.
    */
   void ComputeSODHalos(vtkUnstructuredGrid* particles, vtkUnstructuredGrid* haloCenters);
 
   /**
    * Vectorize the data since the halo-finder expects the data as different
-   * vectors.
+   * vectors. Arrays whose layout already matches, i.e., SOA points/velocities
+   * and single-component mass/tag arrays of the halo-finder's value types,
+   * are used in place without copying.
    */
   void VectorizeData(vtkUnstructuredGrid* particles);
 
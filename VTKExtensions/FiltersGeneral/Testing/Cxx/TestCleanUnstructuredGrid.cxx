@@ -0,0 +1,320 @@
+/*=========================================================================
+
+  Program:   ParaView
+  Module:    TestCleanUnstructuredGrid.cxx
+
+  Copyright (c) Kitware, Inc.
+  All rights reserved.
+  See Copyright.txt or http://www.paraview.org/HTML/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// Checks that vtkCleanUnstructuredGrid merges the points of several blocks
+// with vtkSMPTools the way it does with its locator, on one thread as on all
+// of them, and that a locator that was set is used. The blocks hold a patch
+// of finer cells, crowding a bin. With --benchmark, the times are reported.
+#include "vtkCellArray.h"
+#include "vtkCellType.h"
+#include "vtkCleanUnstructuredGrid.h"
+#include "vtkDataArray.h"
+#include "vtkIdList.h"
+#include "vtkIdTypeArray.h"
+#include "vtkMergePoints.h"
+#include "vtkNew.h"
+#include "vtkObjectFactory.h"
+#include "vtkPointData.h"
+#include "vtkPoints.h"
+#include "vtkSMPTools.h"
+#include "vtkSmartPointer.h"
+#include "vtkTimerLog.h"
+#include "vtkUnstructuredGrid.h"
+
+#include <vtksys/CommandLineArguments.hxx>
+
+#include <cstdlib>
+
+namespace
+{
+const int BlockCells = 40;
+const int NumberOfBlocks = 8;
+const int PatchCells = 20;
+const vtkIdType PatchLattice = 1000000000;
+
+// Counts the points inserted in it.
+class vtkCountingMergePoints : public vtkMergePoints
+{
+public:
+  static vtkCountingMergePoints* New();
+  vtkTypeMacro(vtkCountingMergePoints, vtkMergePoints);
+
+  int InsertUniquePoint(const double x[3], vtkIdType& ptId) override
+  {
+    ++this->NumberOfInsertions;
+    return this->Superclass::InsertUniquePoint(x, ptId);
+  }
+
+  vtkIdType NumberOfInsertions = 0;
+};
+vtkStandardNewMacro(vtkCountingMergePoints);
+
+// Inserts `numCells`^3 hexahedra of side `spacing` from `origin`, with their
+// own points, moved by less than `jitter` each. A point has its index in a
+// lattice of `row` points along x, from `start`, as "lattice" point data.
+void InsertHexahedra(vtkPoints* points, vtkIdTypeArray* lattice, vtkCellArray* cells,
+  const double origin[3], double spacing, int numCells, double jitter, vtkIdType start,
+  vtkIdType row)
+{
+  const int n = numCells + 1;
+  const vtkIdType first = points->GetNumberOfPoints();
+  for (int k = 0; k < n; ++k)
+  {
+    for (int j = 0; j < n; ++j)
+    {
+      for (int i = 0; i < n; ++i)
+      {
+        const vtkIdType id = points->GetNumberOfPoints();
+        const double offset = jitter * (static_cast<int>((id * 7919) % 13) - 6) / 6.0;
+        points->InsertNextPoint(origin[0] + i * spacing + offset,
+          origin[1] + j * spacing - offset, origin[2] + k * spacing + offset);
+        lattice->InsertNextValue(start + (static_cast<vtkIdType>(k) * n + j) * row + i);
+      }
+    }
+  }
+  for (int k = 0; k < numCells; ++k)
+  {
+    for (int j = 0; j < numCells; ++j)
+    {
+      for (int i = 0; i < numCells; ++i)
+      {
+        const vtkIdType p = first + (static_cast<vtkIdType>(k) * n + j) * n + i;
+        const vtkIdType hex[8] = { p, p + 1, p + n + 1, p + n, p + n * n, p + n * n + 1,
+          p + n * n + n + 1, p + n * n + n };
+        cells->InsertNextCell(8, hex);
+      }
+    }
+  }
+}
+
+// `NumberOfBlocks` blocks of hexahedra along x, each with its own points, as
+// appended blocks are before cleaning, then twice a patch of `PatchCells`^3
+// hexahedra of side 2e-3 within a cell of the first block. Points are moved
+// by less than `jitter` each.
+vtkSmartPointer<vtkUnstructuredGrid> MakeBlocks(double jitter)
+{
+  vtkNew<vtkPoints> points;
+  points->SetDataTypeToDouble();
+  vtkNew<vtkIdTypeArray> lattice;
+  lattice->SetName("lattice");
+  vtkNew<vtkCellArray> cells;
+  for (int b = 0; b < NumberOfBlocks; ++b)
+  {
+    const double origin[3] = { static_cast<double>(b * BlockCells), 0.0, 0.0 };
+    InsertHexahedra(points, lattice, cells, origin, 1.0, BlockCells, jitter, b * BlockCells,
+      NumberOfBlocks * BlockCells + 1);
+  }
+  const double patchOrigin[3] = { 0.3, 0.3, 0.3 };
+  for (int copy = 0; copy < 2; ++copy)
+  {
+    InsertHexahedra(
+      points, lattice, cells, patchOrigin, 2e-3, PatchCells, jitter, PatchLattice, PatchCells + 1);
+  }
+  vtkSmartPointer<vtkUnstructuredGrid> grid = vtkSmartPointer<vtkUnstructuredGrid>::New();
+  grid->SetPoints(points);
+  grid->SetCells(VTK_HEXAHEDRON, cells);
+  grid->GetPointData()->AddArray(lattice);
+  return grid;
+}
+
+vtkSmartPointer<vtkUnstructuredGrid> Clean(
+  vtkUnstructuredGrid* input, double tolerance, bool useLocator, double& time)
+{
+  vtkNew<vtkCleanUnstructuredGrid> clean;
+  clean->SetInputData(input);
+  clean->ToleranceIsAbsoluteOn();
+  clean->SetAbsoluteTolerance(tolerance);
+  clean->SetUseLocator(useLocator);
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  clean->Update();
+  timer->StopTimer();
+  time = timer->GetElapsedTime();
+  return clean->GetOutput();
+}
+
+// Whether `a` and `b` have the same points, in the same order, the same
+// "lattice" values and the same cells.
+bool AreSame(vtkUnstructuredGrid* a, vtkUnstructuredGrid* b)
+{
+  if (a->GetNumberOfPoints() != b->GetNumberOfPoints() ||
+    a->GetNumberOfCells() != b->GetNumberOfCells())
+  {
+    return false;
+  }
+  vtkDataArray* latticeA = a->GetPointData()->GetArray("lattice");
+  vtkDataArray* latticeB = b->GetPointData()->GetArray("lattice");
+  if (!latticeA || !latticeB)
+  {
+    return false;
+  }
+  double xa[3], xb[3];
+  for (vtkIdType id = 0; id < a->GetNumberOfPoints(); ++id)
+  {
+    a->GetPoint(id, xa);
+    b->GetPoint(id, xb);
+    if (xa[0] != xb[0] || xa[1] != xb[1] || xa[2] != xb[2] ||
+      latticeA->GetTuple1(id) != latticeB->GetTuple1(id))
+    {
+      return false;
+    }
+  }
+  vtkNew<vtkIdList> idsA;
+  vtkNew<vtkIdList> idsB;
+  for (vtkIdType id = 0; id < a->GetNumberOfCells(); ++id)
+  {
+    a->GetCellPoints(id, idsA);
+    b->GetCellPoints(id, idsB);
+    if (a->GetCellType(id) != b->GetCellType(id) ||
+      idsA->GetNumberOfIds() != idsB->GetNumberOfIds())
+    {
+      return false;
+    }
+    for (vtkIdType i = 0; i < idsA->GetNumberOfIds(); ++i)
+    {
+      if (idsA->GetId(i) != idsB->GetId(i))
+      {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+}
+
+int TestCleanUnstructuredGrid(int argc, char* argv[])
+{
+  bool benchmark = false;
+  vtksys::CommandLineArguments arg;
+  arg.Initialize(argc, argv);
+  arg.AddBooleanArgument("--benchmark", &benchmark, "Report the merging times.");
+  arg.StoreUnusedArguments(true);
+  if (!arg.Parse())
+  {
+    cerr << "ERROR: Problem parsing arguments." << endl;
+    return EXIT_FAILURE;
+  }
+
+  const vtkIdType numLatticePoints = (static_cast<vtkIdType>(NumberOfBlocks) * BlockCells + 1) *
+      (BlockCells + 1) * (BlockCells + 1) +
+    static_cast<vtkIdType>(PatchCells + 1) * (PatchCells + 1) * (PatchCells + 1);
+
+  // coincident points.
+  vtkSmartPointer<vtkUnstructuredGrid> blocks = MakeBlocks(0.0);
+  double smpTime, locatorTime;
+  vtkSmartPointer<vtkUnstructuredGrid> smp = Clean(blocks, 0.0, false, smpTime);
+  vtkSmartPointer<vtkUnstructuredGrid> locator = Clean(blocks, 0.0, true, locatorTime);
+  if (benchmark)
+  {
+    cout << blocks->GetNumberOfPoints() << " points, zero tolerance: " << smpTime
+         << " s, locator " << locatorTime << " s" << endl;
+  }
+  if (smp->GetNumberOfPoints() != numLatticePoints)
+  {
+    cerr << "ERROR: expected " << numLatticePoints << " points, got " << smp->GetNumberOfPoints()
+         << endl;
+    return EXIT_FAILURE;
+  }
+  if (!AreSame(smp, locator))
+  {
+    cerr << "ERROR: zero tolerance output differs from the locator's." << endl;
+    return EXIT_FAILURE;
+  }
+
+  // nearby points.
+  blocks = MakeBlocks(1e-4);
+  smp = Clean(blocks, 0.0, false, smpTime);
+  if (smp->GetNumberOfPoints() <= numLatticePoints)
+  {
+    cerr << "ERROR: nearby points were merged with a zero tolerance." << endl;
+    return EXIT_FAILURE;
+  }
+  if (!AreSame(smp, Clean(blocks, 0.0, true, locatorTime)))
+  {
+    cerr << "ERROR: zero tolerance output with nearby points differs from the locator's." << endl;
+    return EXIT_FAILURE;
+  }
+  smp = Clean(blocks, 1e-3, false, smpTime);
+  locator = Clean(blocks, 1e-3, true, locatorTime);
+  if (benchmark)
+  {
+    cout << blocks->GetNumberOfPoints() << " points, 1e-3 tolerance: " << smpTime
+         << " s, locator " << locatorTime << " s" << endl;
+  }
+  if (smp->GetNumberOfPoints() != numLatticePoints)
+  {
+    cerr << "ERROR: expected " << numLatticePoints << " points, got " << smp->GetNumberOfPoints()
+         << endl;
+    return EXIT_FAILURE;
+  }
+  if (!AreSame(smp, locator))
+  {
+    cerr << "ERROR: 1e-3 tolerance output differs from the locator's." << endl;
+    return EXIT_FAILURE;
+  }
+
+  // the same output on one thread as on all of them.
+  const int numThreads = vtkSMPTools::GetEstimatedNumberOfThreads();
+  const double tolerances[2] = { 0.0, 1e-3 };
+  for (double tolerance : tolerances)
+  {
+    vtkSmartPointer<vtkUnstructuredGrid> outputs[2];
+    double times[2];
+    const int threads[2] = { 1, numThreads };
+    for (int cc = 0; cc < 2; ++cc)
+    {
+      vtkSMPTools::Initialize(threads[cc]);
+      outputs[cc] = Clean(blocks, tolerance, false, times[cc]);
+    }
+    vtkSMPTools::Initialize(numThreads);
+    if (benchmark)
+    {
+      cout << "tolerance " << tolerance << ": " << times[0] << " s on 1 thread, " << times[1]
+           << " s on " << numThreads << endl;
+    }
+    if (!AreSame(outputs[0], outputs[1]))
+    {
+      cerr << "ERROR: tolerance " << tolerance << " output on 1 thread differs from the one on "
+           << numThreads << "." << endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  // a locator that was set is used, and a default one is not kept.
+  vtkNew<vtkCountingMergePoints> counting;
+  vtkNew<vtkCleanUnstructuredGrid> clean;
+  clean->SetInputData(blocks);
+  clean->SetLocator(counting);
+  clean->Update();
+  if (counting->NumberOfInsertions != blocks->GetNumberOfPoints())
+  {
+    cerr << "ERROR: " << counting->NumberOfInsertions
+         << " points inserted in the locator that was set." << endl;
+    return EXIT_FAILURE;
+  }
+  if (!AreSame(clean->GetOutput(), Clean(blocks, 0.0, false, smpTime)))
+  {
+    cerr << "ERROR: output with the locator that was set differs from the smp one." << endl;
+    return EXIT_FAILURE;
+  }
+  clean->SetLocator(nullptr);
+  clean->UseLocatorOn();
+  clean->Update();
+  if (clean->GetLocator() != nullptr)
+  {
+    cerr << "ERROR: default locator kept." << endl;
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,247 @@
+/*=========================================================================
+
+  Program:   Visualization Toolkit
+  Module:    TestExtractScatterPlot.cxx
+
+  Copyright (c) Ken Martin, Will Schroeder, Bill Lorensen
+  All rights reserved.
+  See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+
+#include "vtkCellData.h"
+#include "vtkDoubleArray.h"
+#include "vtkExtractScatterPlot.h"
+#include "vtkFloatArray.h"
+#include "vtkPointData.h"
+#include "vtkPolyData.h"
+#include "vtkSmartPointer.h"
+#include "vtkSphereSource.h"
+#include "vtkTimerLog.h"
+#include "vtkUnsignedLongArray.h"
+
+#include <vtksys/CommandLineArguments.hxx>
+
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+namespace
+{
+/// The counts of the bins found by a linear search of the extents, as
+/// vtkExtractScatterPlot used to do.
+std::vector<unsigned long> SearchBins(vtkDataArray* x_array, int x_component, vtkDataArray* y_array,
+  int y_component, vtkDoubleArray* x_bin_extents, vtkDoubleArray* y_bin_extents)
+{
+  const int x_bin_count = x_bin_extents->GetNumberOfTuples() - 1;
+  const int y_bin_count = y_bin_extents->GetNumberOfTuples() - 1;
+  std::vector<unsigned long> counts(x_bin_count * y_bin_count, 0);
+  for (vtkIdType i = 0; i != x_array->GetNumberOfTuples(); ++i)
+  {
+    const double x = x_array->GetComponent(i, x_component);
+    const double y = y_array->GetComponent(i, y_component);
+    for (int j = 0; j != x_bin_count; ++j)
+    {
+      if (x_bin_extents->GetValue(j) <= x && x < x_bin_extents->GetValue(j + 1))
+      {
+        for (int k = 0; k != y_bin_count; ++k)
+        {
+          if (y_bin_extents->GetValue(k) <= y && y < y_bin_extents->GetValue(k + 1))
+          {
+            ++counts[j * y_bin_count + k];
+            break;
+          }
+        }
+        break;
+      }
+    }
+  }
+  return counts;
+}
+
+/// Bins `x_array` against `y_array` and compares the counts to SearchBins().
+/// With `benchmark`, the times taken by both are reported.
+bool CompareBins(vtkDataArray* x_array, int x_component, vtkDataArray* y_array, int y_component,
+  int x_bin_count, int y_bin_count, bool benchmark)
+{
+  vtkSmartPointer<vtkPolyData> input = vtkSmartPointer<vtkPolyData>::New();
+  input->GetPointData()->AddArray(x_array);
+  input->GetPointData()->AddArray(y_array);
+
+  vtkSmartPointer<vtkExtractScatterPlot> extraction = vtkSmartPointer<vtkExtractScatterPlot>::New();
+  extraction->SetInputData(input);
+  extraction->SetInputArrayToProcess(
+    0, 0, 0, vtkDataObject::FIELD_ASSOCIATION_POINTS, x_array->GetName());
+  extraction->SetInputArrayToProcess(
+    1, 0, 0, vtkDataObject::FIELD_ASSOCIATION_POINTS, y_array->GetName());
+  extraction->SetXComponent(x_component);
+  extraction->SetYComponent(y_component);
+  extraction->SetXBinCount(x_bin_count);
+  extraction->SetYBinCount(y_bin_count);
+
+  vtkSmartPointer<vtkTimerLog> timer = vtkSmartPointer<vtkTimerLog>::New();
+  timer->StartTimer();
+  extraction->Update();
+  timer->StopTimer();
+  const double bin_time = timer->GetElapsedTime();
+
+  vtkCellData* const cell_data = extraction->GetOutput()->GetCellData();
+  vtkDoubleArray* const x_bin_extents =
+    vtkDoubleArray::SafeDownCast(cell_data->GetArray("x_bin_extents"));
+  vtkDoubleArray* const y_bin_extents =
+    vtkDoubleArray::SafeDownCast(cell_data->GetArray("y_bin_extents"));
+  vtkUnsignedLongArray* const bin_values =
+    vtkUnsignedLongArray::SafeDownCast(cell_data->GetArray("bin_values"));
+  if (!x_bin_extents || !y_bin_extents || !bin_values ||
+    x_bin_extents->GetNumberOfTuples() != x_bin_count + 1 ||
+    y_bin_extents->GetNumberOfTuples() != y_bin_count + 1 ||
+    bin_values->GetNumberOfTuples() != x_bin_count ||
+    bin_values->GetNumberOfComponents() != y_bin_count)
+  {
+    cerr << "ERROR: wrong output arrays." << endl;
+    return false;
+  }
+
+  timer->StartTimer();
+  const std::vector<unsigned long> counts =
+    SearchBins(x_array, x_component, y_array, y_component, x_bin_extents, y_bin_extents);
+  timer->StopTimer();
+  if (benchmark)
+  {
+    cout << x_array->GetNumberOfTuples() << " values, " << x_bin_count << "x" << y_bin_count
+         << " bins: " << bin_time << " s, search " << timer->GetElapsedTime() << " s" << endl;
+  }
+
+  for (int i = 0; i != x_bin_count * y_bin_count; ++i)
+  {
+    if (bin_values->GetValue(i) != counts[i])
+    {
+      cerr << "ERROR: bin " << i << " has " << bin_values->GetValue(i) << " values instead of "
+           << counts[i] << endl;
+      return false;
+    }
+  }
+  return true;
+}
+}
+
+/// Test the output of the vtkExtractHistogram filter in a simple serial case
+int TestExtractScatterPlot(int argc, char* argv[])
+{
+  bool benchmark = false;
+  vtksys::CommandLineArguments arg;
+  arg.Initialize(argc, argv);
+  arg.AddBooleanArgument("--benchmark", &benchmark, "Report the binning times.");
+  arg.StoreUnusedArguments(true);
+  if (!arg.Parse())
+  {
+    cerr << "ERROR: Problem parsing arguments." << endl;
+    return EXIT_FAILURE;
+  }
+
+  vtkSmartPointer<vtkSphereSource> sphere = vtkSmartPointer<vtkSphereSource>::New();
+
+  vtkSmartPointer<vtkExtractScatterPlot> extraction = vtkSmartPointer<vtkExtractScatterPlot>::New();
+
+  const int bin_count = 3;
+
+  extraction->SetInputConnection(sphere->GetOutputPort());
+  extraction->SetInputArrayToProcess(
+    0, 0, 0, vtkDataSet::FIELD_ASSOCIATION_POINTS_THEN_CELLS, "Normals");
+  extraction->SetInputArrayToProcess(
+    1, 0, 0, vtkDataSet::FIELD_ASSOCIATION_POINTS_THEN_CELLS, "Normals");
+  extraction->SetXComponent(0);
+  extraction->SetYComponent(1);
+  extraction->SetXBinCount(bin_count);
+  extraction->SetYBinCount(bin_count);
+  extraction->Update();
+
+  vtkPolyData* const scatter_plot = extraction->GetOutput();
+
+  vtkDoubleArray* const x_bin_extents =
+    vtkDoubleArray::SafeDownCast(scatter_plot->GetCellData()->GetArray("x_bin_extents"));
+  if (!x_bin_extents)
+  {
+    return 1;
+  }
+  if (x_bin_extents->GetNumberOfComponents() != 1)
+  {
+    return 1;
+  }
+  if (x_bin_extents->GetNumberOfTuples() != bin_count + 1)
+  {
+    return 1;
+  }
+
+  vtkDoubleArray* const y_bin_extents =
+    vtkDoubleArray::SafeDownCast(scatter_plot->GetCellData()->GetArray("y_bin_extents"));
+  if (!y_bin_extents)
+  {
+    return 1;
+  }
+  if (y_bin_extents->GetNumberOfComponents() != 1)
+  {
+    return 1;
+  }
+  if (y_bin_extents->GetNumberOfTuples() != bin_count + 1)
+  {
+    return 1;
+  }
+
+  vtkUnsignedLongArray* const bin_values =
+    vtkUnsignedLongArray::SafeDownCast(scatter_plot->GetCellData()->GetArray("bin_values"));
+  if (!bin_values)
+  {
+    return 1;
+  }
+  if (bin_values->GetNumberOfComponents() != bin_count)
+  {
+    return 1;
+  }
+  if (bin_values->GetNumberOfTuples() != bin_count)
+  {
+    return 1;
+  }
+
+  int count = 0;
+  for (int i = 0; i != bin_count; ++i)
+  {
+    for (int j = 0; j != bin_count; ++j)
+    {
+      count += static_cast<int>(bin_values->GetComponent(i, j));
+    }
+  }
+
+  if (count != 50)
+    return 1;
+
+  // values of the same type, values of different types, values on the bin
+  // boundaries and a constant component.
+  const vtkIdType value_count = 1000000;
+  vtkSmartPointer<vtkDoubleArray> doubles = vtkSmartPointer<vtkDoubleArray>::New();
+  doubles->SetName("doubles");
+  doubles->SetNumberOfComponents(3);
+  doubles->SetNumberOfTuples(value_count);
+  vtkSmartPointer<vtkFloatArray> floats = vtkSmartPointer<vtkFloatArray>::New();
+  floats->SetName("floats");
+  floats->SetNumberOfTuples(value_count);
+  for (vtkIdType i = 0; i != value_count; ++i)
+  {
+    doubles->SetTypedComponent(i, 0, std::sin(0.001 * i) * std::cos(0.0007 * i));
+    doubles->SetTypedComponent(i, 1, static_cast<double>(i % 101) / 10);
+    doubles->SetTypedComponent(i, 2, 4.0);
+    floats->SetValue(i, static_cast<float>(std::exp(std::sin(0.0003 * i))));
+  }
+  if (!CompareBins(doubles, 0, doubles, 1, 100, 100, benchmark) ||
+    !CompareBins(doubles, 1, floats, 0, 7, 300, benchmark) ||
+    !CompareBins(floats, 0, doubles, 2, 50, 3, benchmark))
+  {
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,160 @@
+/*=========================================================================
+
+  Program:   ParaView
+  Module:    TestExtractScatterPlotMPI.cxx
+
+  Copyright (c) Kitware, Inc.
+  All rights reserved.
+  See Copyright.txt or http://www.paraview.org/HTML/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// Runs vtkExtractScatterPlot on values split over the ranks, the last rank
+// having no arrays, and checks that every rank gets the extents of the filter
+// run on all the values in one process, and that the first rank gets its
+// counts while the other ranks get zero counts.
+#include "vtkCellData.h"
+#include "vtkDoubleArray.h"
+#include "vtkExtractScatterPlot.h"
+#include "vtkFloatArray.h"
+#include "vtkMPIController.h"
+#include "vtkNew.h"
+#include "vtkPointData.h"
+#include "vtkPolyData.h"
+#include "vtkSmartPointer.h"
+#include "vtkUnsignedLongArray.h"
+
+#include <cmath>
+#include <cstdlib>
+
+namespace
+{
+const vtkIdType NumberOfValues = 100000;
+const int XBinCount = 30;
+const int YBinCount = 20;
+
+/// The values of indices [begin, end), of different types, some on the bin
+/// boundaries.
+vtkSmartPointer<vtkPolyData> MakeInput(vtkIdType begin, vtkIdType end)
+{
+  vtkNew<vtkDoubleArray> xs;
+  xs->SetName("x");
+  xs->SetNumberOfTuples(end - begin);
+  vtkNew<vtkFloatArray> ys;
+  ys->SetName("y");
+  ys->SetNumberOfTuples(end - begin);
+  for (vtkIdType i = begin; i < end; ++i)
+  {
+    xs->SetValue(i - begin, std::sin(0.001 * i) * std::cos(0.0007 * i));
+    ys->SetValue(i - begin, static_cast<float>(i % 101) / 10);
+  }
+  vtkSmartPointer<vtkPolyData> input = vtkSmartPointer<vtkPolyData>::New();
+  input->GetPointData()->AddArray(xs);
+  input->GetPointData()->AddArray(ys);
+  return input;
+}
+
+void Extract(vtkExtractScatterPlot* extraction, vtkPolyData* input)
+{
+  extraction->SetInputData(input);
+  extraction->SetInputArrayToProcess(0, 0, 0, vtkDataObject::FIELD_ASSOCIATION_POINTS, "x");
+  extraction->SetInputArrayToProcess(1, 0, 0, vtkDataObject::FIELD_ASSOCIATION_POINTS, "y");
+  extraction->SetXComponent(0);
+  extraction->SetYComponent(0);
+  extraction->SetXBinCount(XBinCount);
+  extraction->SetYBinCount(YBinCount);
+  extraction->Update();
+}
+
+bool CompareExtents(vtkCellData* parallel, vtkCellData* serial, const char* name)
+{
+  vtkDataArray* parallelExtents = parallel->GetArray(name);
+  vtkDataArray* serialExtents = serial->GetArray(name);
+  if (!parallelExtents || !serialExtents ||
+    parallelExtents->GetNumberOfTuples() != serialExtents->GetNumberOfTuples())
+  {
+    cerr << "ERROR: wrong " << name << " array." << endl;
+    return false;
+  }
+  for (vtkIdType i = 0; i < serialExtents->GetNumberOfTuples(); ++i)
+  {
+    if (parallelExtents->GetTuple1(i) != serialExtents->GetTuple1(i))
+    {
+      cerr << "ERROR: " << name << " " << i << " is " << parallelExtents->GetTuple1(i)
+           << " instead of " << serialExtents->GetTuple1(i) << endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+bool CheckRank(vtkMultiProcessController* controller)
+{
+  const int rank = controller->GetLocalProcessId();
+  const int numProcs = controller->GetNumberOfProcesses();
+
+  // the last rank has no arrays, unless it is the only one.
+  const int numValueRanks = numProcs > 1 ? numProcs - 1 : 1;
+  vtkSmartPointer<vtkPolyData> local = rank < numValueRanks
+    ? MakeInput(NumberOfValues * rank / numValueRanks, NumberOfValues * (rank + 1) / numValueRanks)
+    : vtkSmartPointer<vtkPolyData>::New();
+  vtkNew<vtkExtractScatterPlot> parallel;
+  parallel->SetController(controller);
+  Extract(parallel, local);
+
+  vtkSmartPointer<vtkPolyData> all = MakeInput(0, NumberOfValues);
+  vtkNew<vtkExtractScatterPlot> serial;
+  serial->SetController(nullptr);
+  Extract(serial, all);
+
+  vtkCellData* parallelData = parallel->GetOutput()->GetCellData();
+  vtkCellData* serialData = serial->GetOutput()->GetCellData();
+  if (!CompareExtents(parallelData, serialData, "x_bin_extents") ||
+    !CompareExtents(parallelData, serialData, "y_bin_extents"))
+  {
+    return false;
+  }
+
+  vtkUnsignedLongArray* parallelValues =
+    vtkUnsignedLongArray::SafeDownCast(parallelData->GetArray("bin_values"));
+  vtkUnsignedLongArray* serialValues =
+    vtkUnsignedLongArray::SafeDownCast(serialData->GetArray("bin_values"));
+  if (!parallelValues || !serialValues ||
+    parallelValues->GetNumberOfValues() != serialValues->GetNumberOfValues())
+  {
+    cerr << "ERROR: wrong bin_values array." << endl;
+    return false;
+  }
+  for (vtkIdType i = 0; i < serialValues->GetNumberOfValues(); ++i)
+  {
+    const unsigned long expected = rank == 0 ? serialValues->GetValue(i) : 0;
+    if (parallelValues->GetValue(i) != expected)
+    {
+      cerr << "ERROR: bin " << i << " has " << parallelValues->GetValue(i) << " values instead of "
+           << expected << endl;
+      return false;
+    }
+  }
+  return true;
+}
+}
+
+int TestExtractScatterPlotMPI(int argc, char* argv[])
+{
+  vtkMPIController* contr = vtkMPIController::New();
+  contr->Initialize(&argc, &argv);
+  vtkMultiProcessController::SetGlobalController(contr);
+
+  // Every rank must pass.
+  int success = CheckRank(contr) ? 1 : 0;
+  int all_success;
+  contr->AllReduce(&success, &all_success, 1, vtkCommunicator::MIN_OP);
+
+  vtkMultiProcessController::SetGlobalController(nullptr);
+  contr->Finalize();
+  contr->Delete();
+  return all_success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,238 @@
+/*=========================================================================
+
+  Program:   ParaView
+  Module:    TestPlotEdgesMPI.cxx
+
+  Copyright (c) Kitware, Inc.
+  All rights reserved.
+  See Copyright.txt or http://www.paraview.org/HTML/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// Runs vtkPlotEdges on lines split over the ranks and checks that the curves
+// output by all the ranks are the curves of a serial run on all the lines.
+// The lines are a grid of horizontal and vertical lines, some of them split
+// between two ranks, and pairs of V shapes of different ranks touching at
+// their tips, where no rank has an extremity.
+#include "vtkCellArray.h"
+#include "vtkCharArray.h"
+#include "vtkMPIController.h"
+#include "vtkMultiBlockDataSet.h"
+#include "vtkNew.h"
+#include "vtkPlotEdges.h"
+#include "vtkPoints.h"
+#include "vtkPolyData.h"
+#include "vtkSmartPointer.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+const int NumberOfRows = 5;
+const int NumberOfColumns = 6;
+const int GridWidth = 6 * NumberOfColumns;
+const int GridHeight = 4 * NumberOfRows;
+const int SplitY = GridHeight / 2 + 1; // not on a horizontal line
+const int NumberOfTips = 4;
+const int ArmLength = 5;
+
+// Adds the lines between consecutive points of a polyline, if it belongs to
+// `rank`, or all of them if `rank` is -1.
+void AddPolyline(vtkPolyData* lines, const std::vector<std::array<int, 2> >& polyline,
+  int owner, int rank)
+{
+  if (rank != -1 && owner != rank)
+  {
+    return;
+  }
+  vtkPoints* points = lines->GetPoints();
+  for (size_t i = 0; i + 1 < polyline.size(); ++i)
+  {
+    const vtkIdType ids[2] = { points->InsertNextPoint(polyline[i][0], polyline[i][1], 0),
+      points->InsertNextPoint(polyline[i + 1][0], polyline[i + 1][1], 0) };
+    lines->GetLines()->InsertNextCell(2, ids);
+  }
+}
+
+// The lines of `rank` among `numProcs` ranks, or all of them if `rank` is -1.
+vtkSmartPointer<vtkPolyData> MakeLines(int rank, int numProcs)
+{
+  vtkSmartPointer<vtkPolyData> lines = vtkSmartPointer<vtkPolyData>::New();
+  vtkNew<vtkPoints> points;
+  lines->SetPoints(points);
+  vtkNew<vtkCellArray> cells;
+  lines->SetLines(cells);
+
+  // horizontal lines, each on one rank.
+  for (int row = 0; row < NumberOfRows; ++row)
+  {
+    std::vector<std::array<int, 2> > polyline;
+    for (int x = 0; x <= GridWidth; ++x)
+    {
+      polyline.push_back({ { x, 4 * row + 2 } });
+    }
+    AddPolyline(lines, polyline, row % numProcs, rank);
+  }
+
+  // vertical lines, each split between two ranks.
+  for (int column = 0; column < NumberOfColumns; ++column)
+  {
+    std::vector<std::array<int, 2> > bottom, top;
+    for (int y = 0; y <= GridHeight; ++y)
+    {
+      (y <= SplitY ? bottom : top).push_back({ { 6 * column + 3, y } });
+    }
+    top.insert(top.begin(), bottom.back());
+    AddPolyline(lines, bottom, (column + 1) % numProcs, rank);
+    AddPolyline(lines, top, (column + 2) % numProcs, rank);
+  }
+
+  // a ">" and a "<" touching at their tips, on different ranks: the curves
+  // are the two diagonals through the tips.
+  for (int tip = 0; tip < NumberOfTips; ++tip)
+  {
+    const int tipX = GridWidth + 10 + 4 * ArmLength * tip;
+    const int tipY = GridHeight / 2;
+    std::vector<std::array<int, 2> > left, right;
+    for (int t = -ArmLength; t <= ArmLength; ++t)
+    {
+      const int offset = t < 0 ? -t : t;
+      left.push_back({ { tipX - offset, tipY + t } });
+      right.push_back({ { tipX + offset, tipY + t } });
+    }
+    AddPolyline(lines, left, tip % numProcs, rank);
+    AddPolyline(lines, right, (tip + 1) % numProcs, rank);
+  }
+  return lines;
+}
+
+// The points of the curves of the blocks, one curve per line, in the
+// direction where they are the smallest.
+std::vector<std::string> GetCurves(vtkMultiBlockDataSet* output)
+{
+  std::vector<std::string> curves;
+  for (unsigned int block = 0; block < output->GetNumberOfBlocks(); ++block)
+  {
+    vtkPolyData* curve = vtkPolyData::SafeDownCast(output->GetBlock(block));
+    if (!curve)
+    {
+      continue;
+    }
+    std::vector<std::string> points;
+    for (vtkIdType i = 0; i < curve->GetNumberOfPoints(); ++i)
+    {
+      double point[3];
+      curve->GetPoint(i, point);
+      std::ostringstream stream;
+      stream << "(" << point[0] << " " << point[1] << ")";
+      points.push_back(stream.str());
+    }
+    std::string forward, backward;
+    for (size_t i = 0; i < points.size(); ++i)
+    {
+      forward += points[i];
+      backward += points[points.size() - 1 - i];
+    }
+    curves.push_back(std::min(forward, backward));
+  }
+  return curves;
+}
+
+bool CheckRank(vtkMPIController* controller)
+{
+  const int rank = controller->GetLocalProcessId();
+  const int numProcs = controller->GetNumberOfProcesses();
+
+  // vtkPlotEdges runs in serial without a global controller.
+  vtkSmartPointer<vtkPolyData> all = MakeLines(-1, numProcs);
+  vtkNew<vtkPlotEdges> serial;
+  serial->SetInputData(all);
+  vtkMultiProcessController::SetGlobalController(nullptr);
+  serial->Update();
+  vtkMultiProcessController::SetGlobalController(controller);
+
+  vtkSmartPointer<vtkPolyData> local = MakeLines(rank, numProcs);
+  vtkNew<vtkPlotEdges> parallel;
+  parallel->SetInputData(local);
+  parallel->Update();
+
+  // every block is set on one rank.
+  vtkMultiBlockDataSet* output = parallel->GetOutput();
+  std::vector<std::string> localCurves = GetCurves(output);
+  int numLocalBlocks = static_cast<int>(localCurves.size());
+  int numBlocks = 0;
+  controller->AllReduce(&numLocalBlocks, &numBlocks, 1, vtkCommunicator::SUM_OP);
+  if (numBlocks != static_cast<int>(output->GetNumberOfBlocks()))
+  {
+    cerr << "ERROR: " << numBlocks << " blocks set instead of " << output->GetNumberOfBlocks()
+         << "." << endl;
+    return false;
+  }
+
+  std::string localText;
+  for (const std::string& curve : localCurves)
+  {
+    localText += curve + "\n";
+  }
+  vtkNew<vtkCharArray> sent;
+  sent->SetNumberOfValues(static_cast<vtkIdType>(localText.size()));
+  std::copy(localText.begin(), localText.end(), sent->GetPointer(0));
+  vtkNew<vtkCharArray> received;
+  controller->GatherV(sent, received, 0);
+  if (rank != 0)
+  {
+    return true;
+  }
+
+  std::vector<std::string> parallelCurves;
+  std::istringstream text(received->GetNumberOfValues() > 0
+      ? std::string(received->GetPointer(0), received->GetNumberOfValues())
+      : std::string());
+  for (std::string curve; std::getline(text, curve);)
+  {
+    parallelCurves.push_back(curve);
+  }
+  std::vector<std::string> serialCurves = GetCurves(serial->GetOutput());
+  std::sort(parallelCurves.begin(), parallelCurves.end());
+  std::sort(serialCurves.begin(), serialCurves.end());
+  const size_t expectedCurves = NumberOfRows + NumberOfColumns + 2 * NumberOfTips;
+  if (serialCurves.size() != expectedCurves)
+  {
+    cerr << "ERROR: " << serialCurves.size() << " curves in serial instead of " << expectedCurves
+         << "." << endl;
+    return false;
+  }
+  if (parallelCurves != serialCurves)
+  {
+    cerr << "ERROR: " << parallelCurves.size() << " curves in parallel differ from the "
+         << serialCurves.size() << " serial curves." << endl;
+    return false;
+  }
+  return true;
+}
+}
+
+int TestPlotEdgesMPI(int argc, char* argv[])
+{
+  vtkMPIController* contr = vtkMPIController::New();
+  contr->Initialize(&argc, &argv);
+  vtkMultiProcessController::SetGlobalController(contr);
+
+  // Every rank must pass.
+  int success = CheckRank(contr) ? 1 : 0;
+  int all_success;
+  contr->AllReduce(&success, &all_success, 1, vtkCommunicator::MIN_OP);
+
+  vtkMultiProcessController::SetGlobalController(nullptr);
+  contr->Finalize();
+  contr->Delete();
+  return all_success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
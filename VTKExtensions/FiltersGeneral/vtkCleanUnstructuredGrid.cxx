@@ -14,22 +14,620 @@ PURPOSE.  See the above copyright notice for more information.
 =========================================================================*/
 #include "vtkCleanUnstructuredGrid.h"
 
+#include "vtkArrayDispatch.h"
 #include "vtkCell.h"
+#include "vtkCellArray.h"
 #include "vtkCellData.h"
 #include "vtkCollection.h"
+#include "vtkDataArrayAccessor.h"
 #include "vtkDataSet.h"
+#include "vtkIdList.h"
 #include "vtkIncrementalPointLocator.h"
 #include "vtkInformation.h"
 #include "vtkInformationVector.h"
 #include "vtkIntArray.h"
+#include "vtkMath.h"
 #include "vtkMergePoints.h"
+#include "vtkNew.h"
 #include "vtkObjectFactory.h"
 #include "vtkPointData.h"
 #include "vtkPointSet.h"
 #include "vtkPoints.h"
 #include "vtkRectilinearGrid.h"
+#include "vtkSMPTools.h"
 #include "vtkUnstructuredGrid.h"
 
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+// Bins holding more points than this are divided further when merging
+// points within a tolerance.
+const vtkIdType MaxPointsPerBin = 64;
+
+// Uniform bins over the bounds of the points, about one point per bin, and no
+// smaller than `minBinSize` along any axis. Degenerate axes have a single bin.
+class vtkCleanBins
+{
+public:
+  vtkCleanBins() = default;
+
+  vtkCleanBins(const double bounds[6], vtkIdType numPoints, double minBinSize)
+  {
+    int numAxes = 0;
+    double volume = 1.0;
+    for (int a = 0; a < 3; ++a)
+    {
+      const double length = bounds[2 * a + 1] - bounds[2 * a];
+      if (length > 0)
+      {
+        ++numAxes;
+        volume *= length;
+      }
+    }
+    double size = numAxes ? std::pow(volume / std::max(numPoints, vtkIdType(1)), 1.0 / numAxes) : 0;
+    size = std::max(size, minBinSize);
+    for (int a = 0; a < 3; ++a)
+    {
+      const double length = bounds[2 * a + 1] - bounds[2 * a];
+      this->Origin[a] = bounds[2 * a];
+      this->Divisions[a] = 1;
+      if (length > 0 && size > 0)
+      {
+        this->Divisions[a] =
+          static_cast<vtkIdType>(std::min(std::max(std::floor(length / size), 1.0), 1048576.0));
+      }
+      this->Scale[a] = length > 0 ? this->Divisions[a] / length : 0;
+    }
+  }
+
+  vtkIdType GetNumberOfBins() const
+  {
+    return this->Divisions[0] * this->Divisions[1] * this->Divisions[2];
+  }
+
+  void GetIndex(const double x[3], vtkIdType ijk[3]) const
+  {
+    for (int a = 0; a < 3; ++a)
+    {
+      const double index = std::floor((x[a] - this->Origin[a]) * this->Scale[a]);
+      ijk[a] = static_cast<vtkIdType>(
+        std::min(std::max(index, 0.0), static_cast<double>(this->Divisions[a] - 1)));
+    }
+  }
+
+  vtkIdType GetKey(const vtkIdType ijk[3]) const
+  {
+    return (ijk[0] * this->Divisions[1] + ijk[1]) * this->Divisions[2] + ijk[2];
+  }
+
+  // The bin of `x`, or -1 when `x` is not finite.
+  vtkIdType GetKey(const double x[3]) const
+  {
+    if (!vtkMath::IsFinite(x[0]) || !vtkMath::IsFinite(x[1]) || !vtkMath::IsFinite(x[2]))
+    {
+      return -1;
+    }
+    vtkIdType ijk[3];
+    this->GetIndex(x, ijk);
+    return this->GetKey(ijk);
+  }
+
+  double Origin[3];
+  double Scale[3];
+  vtkIdType Divisions[3];
+};
+
+struct vtkCleanBinnedPoint
+{
+  vtkIdType Key;
+  vtkIdType Id;
+};
+
+// The bins a crowded bin is divided into, over the bounds of its points, and
+// where each of them starts in the sorted points.
+struct vtkCleanSubBins
+{
+  vtkCleanBins Bins;
+  std::vector<vtkIdType> Starts;
+};
+
+/**
+ * Maps every point to the point it is merged with, which is the point itself
+ * for the points that are kept. Points that are not finite are always kept.
+ */
+template <typename ArrayT>
+class vtkCleanPointMerger
+{
+public:
+  vtkCleanPointMerger(ArrayT* points, const vtkCleanBins& bins, double tolerance, vtkIdType* map)
+    : Points(points)
+    , Bins(bins)
+    , Tolerance(tolerance)
+    , Tolerance2(tolerance * tolerance)
+    , PointMap(map)
+    , Sorted(points->GetNumberOfTuples())
+  {
+  }
+
+  void GetPoint(vtkIdType id, double x[3]) const
+  {
+    vtkDataArrayAccessor<ArrayT> points(this->Points);
+    for (int c = 0; c < 3; ++c)
+    {
+      x[c] = static_cast<double>(points.Get(id, c));
+    }
+  }
+
+  // Sorts the points by bin, then by coordinates if `byCoordinates`, then by id.
+  void Sort(bool byCoordinates)
+  {
+    vtkSMPTools::For(0, this->Points->GetNumberOfTuples(), [&](vtkIdType begin, vtkIdType end) {
+      double x[3];
+      for (vtkIdType id = begin; id < end; ++id)
+      {
+        this->GetPoint(id, x);
+        this->Sorted[id].Key = this->Bins.GetKey(x);
+        this->Sorted[id].Id = id;
+      }
+    });
+    vtkSMPTools::Sort(this->Sorted.begin(), this->Sorted.end(),
+      [this, byCoordinates](const vtkCleanBinnedPoint& a, const vtkCleanBinnedPoint& b) {
+        if (a.Key != b.Key)
+        {
+          return a.Key < b.Key;
+        }
+        if (byCoordinates && a.Key >= 0)
+        {
+          double xa[3], xb[3];
+          this->GetPoint(a.Id, xa);
+          this->GetPoint(b.Id, xb);
+          for (int c = 0; c < 3; ++c)
+          {
+            if (xa[c] != xb[c])
+            {
+              return xa[c] < xb[c];
+            }
+          }
+        }
+        return a.Id < b.Id;
+      });
+  }
+
+  bool IsCoincident(const vtkCleanBinnedPoint& a, const vtkCleanBinnedPoint& b) const
+  {
+    if (a.Key != b.Key || a.Key < 0)
+    {
+      return false;
+    }
+    double xa[3], xb[3];
+    this->GetPoint(a.Id, xa);
+    this->GetPoint(b.Id, xb);
+    return xa[0] == xb[0] && xa[1] == xb[1] && xa[2] == xb[2];
+  }
+
+  /**
+   * Coincident points are consecutive once sorted, with the smallest id
+   * first. A thread finishes the run it is in at the end of its range, and
+   * skips the run it is in at the beginning of its range.
+   */
+  void MergeCoincident()
+  {
+    this->Sort(true);
+    const vtkIdType numPoints = static_cast<vtkIdType>(this->Sorted.size());
+    vtkSMPTools::For(0, numPoints, [&](vtkIdType begin, vtkIdType end) {
+      vtkIdType cc = begin;
+      while (cc < end && cc > 0 && this->IsCoincident(this->Sorted[cc - 1], this->Sorted[cc]))
+      {
+        ++cc;
+      }
+      while (cc < end)
+      {
+        const vtkIdType kept = this->Sorted[cc].Id;
+        do
+        {
+          this->PointMap[this->Sorted[cc].Id] = kept;
+          ++cc;
+        } while (cc < numPoints && this->IsCoincident(this->Sorted[cc - 1], this->Sorted[cc]));
+      }
+    });
+  }
+
+  /**
+   * Calls `f` with the ranges of `Sorted` holding the points of the bins
+   * around `x`, until `f` returns true. Returns whether it did. Only the
+   * sub-bins within the tolerance of `x` are visited in a crowded bin, which
+   * caps the points to scan there. Ids are sorted within a range.
+   */
+  template <typename F>
+  bool VisitNeighbourBins(const double x[3], F f) const
+  {
+    vtkIdType ijk[3], n[3];
+    this->Bins.GetIndex(x, ijk);
+    vtkIdType lo[3], hi[3];
+    for (int a = 0; a < 3; ++a)
+    {
+      lo[a] = std::max(ijk[a] - 1, vtkIdType(0));
+      hi[a] = std::min(ijk[a] + 1, this->Bins.Divisions[a] - 1);
+    }
+    for (n[0] = lo[0]; n[0] <= hi[0]; ++n[0])
+    {
+      for (n[1] = lo[1]; n[1] <= hi[1]; ++n[1])
+      {
+        for (n[2] = lo[2]; n[2] <= hi[2]; ++n[2])
+        {
+          const vtkIdType key = this->Bins.GetKey(n);
+          const vtkCleanSubBins* subBins = this->GetSubBins(key);
+          const bool done = subBins ? this->VisitSubBins(*subBins, x, f)
+                                    : f(this->BinStarts[key], this->BinStarts[key + 1]);
+          if (done)
+          {
+            return true;
+          }
+        }
+      }
+    }
+    return false;
+  }
+
+  const vtkCleanSubBins* GetSubBins(vtkIdType key) const
+  {
+    if (this->BinStarts[key + 1] - this->BinStarts[key] <= MaxPointsPerBin)
+    {
+      return nullptr;
+    }
+    auto crowded = std::lower_bound(this->CrowdedBins.begin(), this->CrowdedBins.end(), key);
+    return &this->SubBins[crowded - this->CrowdedBins.begin()];
+  }
+
+  template <typename F>
+  bool VisitSubBins(const vtkCleanSubBins& subBins, const double x[3], F f) const
+  {
+    // Indices are clamped to the sub-bins, so the box around `x` still
+    // covers the points within the tolerance when `x` is outside them.
+    double corner[3];
+    vtkIdType lo[3], hi[3], n[3];
+    for (int a = 0; a < 3; ++a)
+    {
+      corner[a] = x[a] - this->Tolerance;
+    }
+    subBins.Bins.GetIndex(corner, lo);
+    for (int a = 0; a < 3; ++a)
+    {
+      corner[a] = x[a] + this->Tolerance;
+    }
+    subBins.Bins.GetIndex(corner, hi);
+    for (n[0] = lo[0]; n[0] <= hi[0]; ++n[0])
+    {
+      for (n[1] = lo[1]; n[1] <= hi[1]; ++n[1])
+      {
+        for (n[2] = lo[2]; n[2] <= hi[2]; ++n[2])
+        {
+          const vtkIdType key = subBins.Bins.GetKey(n);
+          if (f(subBins.Starts[key], subBins.Starts[key + 1]))
+          {
+            return true;
+          }
+        }
+      }
+    }
+    return false;
+  }
+
+  bool IsWithinTolerance(const double x[3], vtkIdType id) const
+  {
+    double y[3];
+    this->GetPoint(id, y);
+    return vtkMath::Distance2BetweenPoints(x, y) <= this->Tolerance2;
+  }
+
+  /**
+   * Divides the bins holding more than MaxPointsPerBin points into bins of
+   * about one point each over the bounds of their points, but no smaller
+   * than the tolerance. Their points are sorted by sub-bin, then by id.
+   */
+  void DivideCrowdedBins()
+  {
+    const vtkIdType numBins = this->Bins.GetNumberOfBins();
+    for (vtkIdType key = 0; key < numBins; ++key)
+    {
+      if (this->BinStarts[key + 1] - this->BinStarts[key] > MaxPointsPerBin)
+      {
+        this->CrowdedBins.push_back(key);
+      }
+    }
+    this->SubBins.resize(this->CrowdedBins.size());
+
+    auto keyLess = [](const vtkCleanBinnedPoint& p, vtkIdType key) { return p.Key < key; };
+    vtkSMPTools::For(0, static_cast<vtkIdType>(this->CrowdedBins.size()), 1,
+      [&](vtkIdType begin, vtkIdType end) {
+        double x[3];
+        for (vtkIdType cc = begin; cc < end; ++cc)
+        {
+          const vtkIdType key = this->CrowdedBins[cc];
+          auto first = this->Sorted.begin() + this->BinStarts[key];
+          auto last = this->Sorted.begin() + this->BinStarts[key + 1];
+          double bounds[6] = { VTK_DOUBLE_MAX, VTK_DOUBLE_MIN, VTK_DOUBLE_MAX, VTK_DOUBLE_MIN,
+            VTK_DOUBLE_MAX, VTK_DOUBLE_MIN };
+          for (auto it = first; it != last; ++it)
+          {
+            this->GetPoint(it->Id, x);
+            for (int a = 0; a < 3; ++a)
+            {
+              bounds[2 * a] = std::min(bounds[2 * a], x[a]);
+              bounds[2 * a + 1] = std::max(bounds[2 * a + 1], x[a]);
+            }
+          }
+
+          vtkCleanSubBins& subBins = this->SubBins[cc];
+          subBins.Bins = vtkCleanBins(bounds, last - first, this->Tolerance);
+          for (auto it = first; it != last; ++it)
+          {
+            this->GetPoint(it->Id, x);
+            it->Key = subBins.Bins.GetKey(x);
+          }
+          std::sort(first, last, [](const vtkCleanBinnedPoint& a, const vtkCleanBinnedPoint& b) {
+            return a.Key != b.Key ? a.Key < b.Key : a.Id < b.Id;
+          });
+          const vtkIdType numSubBins = subBins.Bins.GetNumberOfBins();
+          subBins.Starts.resize(numSubBins + 1);
+          for (vtkIdType subKey = 0; subKey <= numSubBins; ++subKey)
+          {
+            subBins.Starts[subKey] =
+              std::lower_bound(first, last, subKey, keyLess) - this->Sorted.begin();
+          }
+        }
+      });
+  }
+
+  /**
+   * Points with no earlier point within the tolerance are kept, which is
+   * decided in parallel. The other points are merged in id order with the
+   * first earlier kept point within the tolerance, if any. Both scan a bin
+   * in id order and stop at the first point that decides it.
+   */
+  void MergeNearby()
+  {
+    this->Sort(false);
+    const vtkIdType numPoints = static_cast<vtkIdType>(this->Sorted.size());
+    const vtkIdType numBins = this->Bins.GetNumberOfBins();
+    this->BinStarts.resize(numBins + 1);
+    auto keyLess = [](const vtkCleanBinnedPoint& p, vtkIdType key) { return p.Key < key; };
+    vtkSMPTools::For(0, numBins + 1, [&](vtkIdType begin, vtkIdType end) {
+      for (vtkIdType key = begin; key < end; ++key)
+      {
+        this->BinStarts[key] =
+          std::lower_bound(this->Sorted.begin(), this->Sorted.end(), key, keyLess) -
+          this->Sorted.begin();
+      }
+    });
+    this->DivideCrowdedBins();
+
+    vtkSMPTools::For(0, numPoints, [&](vtkIdType begin, vtkIdType end) {
+      double x[3];
+      for (vtkIdType id = begin; id < end; ++id)
+      {
+        this->GetPoint(id, x);
+        auto hasEarlierNearby = [&](vtkIdType first, vtkIdType last) {
+          for (vtkIdType cc = first; cc < last && this->Sorted[cc].Id < id; ++cc)
+          {
+            if (this->IsWithinTolerance(x, this->Sorted[cc].Id))
+            {
+              return true;
+            }
+          }
+          return false;
+        };
+        const bool merged =
+          this->Bins.GetKey(x) >= 0 && this->VisitNeighbourBins(x, hasEarlierNearby);
+        this->PointMap[id] = merged ? -1 : id;
+      }
+    });
+
+    double x[3];
+    for (vtkIdType id = 0; id < numPoints; ++id)
+    {
+      if (this->PointMap[id] < 0)
+      {
+        this->GetPoint(id, x);
+        vtkIdType kept = id;
+        this->VisitNeighbourBins(x, [&](vtkIdType first, vtkIdType last) {
+          for (vtkIdType cc = first; cc < last && this->Sorted[cc].Id < kept; ++cc)
+          {
+            const vtkIdType other = this->Sorted[cc].Id;
+            if (this->PointMap[other] == other && this->IsWithinTolerance(x, other))
+            {
+              kept = other;
+              break;
+            }
+          }
+          return false;
+        });
+        this->PointMap[id] = kept;
+      }
+    }
+  }
+
+  ArrayT* Points;
+  const vtkCleanBins& Bins;
+  const double Tolerance;
+  const double Tolerance2;
+  vtkIdType* PointMap;
+  std::vector<vtkCleanBinnedPoint> Sorted;
+  std::vector<vtkIdType> BinStarts;
+  // The bins holding more than MaxPointsPerBin points, in order, and what
+  // they are divided into.
+  std::vector<vtkIdType> CrowdedBins;
+  std::vector<vtkCleanSubBins> SubBins;
+};
+
+struct vtkCleanMergeWorker
+{
+  const vtkCleanBins* Bins;
+  double Tolerance;
+  vtkIdType* PointMap;
+
+  template <typename ArrayT>
+  void operator()(ArrayT* points)
+  {
+    vtkCleanPointMerger<ArrayT> merger(points, *this->Bins, this->Tolerance, this->PointMap);
+    if (this->Tolerance > 0)
+    {
+      merger.MergeNearby();
+    }
+    else
+    {
+      merger.MergeCoincident();
+    }
+  }
+};
+
+struct vtkCleanCopyPointsWorker
+{
+  const vtkIdType* OutputToInput;
+
+  template <typename InArrayT, typename OutArrayT>
+  void operator()(InArrayT* inPoints, OutArrayT* outPoints)
+  {
+    using OutValueT = typename vtkDataArrayAccessor<OutArrayT>::APIType;
+    vtkSMPTools::For(0, outPoints->GetNumberOfTuples(), [&](vtkIdType begin, vtkIdType end) {
+      vtkDataArrayAccessor<InArrayT> in(inPoints);
+      vtkDataArrayAccessor<OutArrayT> out(outPoints);
+      for (vtkIdType id = begin; id < end; ++id)
+      {
+        for (int c = 0; c < 3; ++c)
+        {
+          out.Set(id, c, static_cast<OutValueT>(in.Get(this->OutputToInput[id], c)));
+        }
+      }
+    });
+  }
+};
+
+struct vtkCleanRemapConnectivity
+{
+  template <typename CellStateT>
+  void operator()(CellStateT& state, const vtkIdType* pointMap)
+  {
+    using ValueT = typename CellStateT::ValueType;
+    ValueT* ids = state.GetConnectivity()->GetPointer(0);
+    vtkSMPTools::For(0, state.GetConnectivity()->GetNumberOfValues(),
+      [&](vtkIdType begin, vtkIdType end) {
+        for (vtkIdType cc = begin; cc < end; ++cc)
+        {
+          ids[cc] = static_cast<ValueT>(pointMap[ids[cc]]);
+        }
+      });
+  }
+};
+
+/**
+ * Numbers the kept points in id order and maps every point to the new id of
+ * the point it is merged with. Fills `outputToInput` with the ids of the kept
+ * points. The points are numbered in chunks that do not depend on the number
+ * of threads.
+ */
+void vtkCleanNumberPoints(std::vector<vtkIdType>& pointMap, std::vector<vtkIdType>& outputToInput)
+{
+  const vtkIdType numPoints = static_cast<vtkIdType>(pointMap.size());
+  const vtkIdType chunkSize = 65536;
+  const vtkIdType numChunks = (numPoints + chunkSize - 1) / chunkSize;
+  std::vector<vtkIdType> chunkStarts(numChunks + 1, 0);
+  vtkSMPTools::For(0, numChunks, 1, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType chunk = begin; chunk < end; ++chunk)
+    {
+      const vtkIdType last = std::min((chunk + 1) * chunkSize, numPoints);
+      for (vtkIdType id = chunk * chunkSize; id < last; ++id)
+      {
+        chunkStarts[chunk + 1] += pointMap[id] == id ? 1 : 0;
+      }
+    }
+  });
+  for (vtkIdType chunk = 0; chunk < numChunks; ++chunk)
+  {
+    chunkStarts[chunk + 1] += chunkStarts[chunk];
+  }
+
+  std::vector<vtkIdType> newIds(numPoints);
+  outputToInput.resize(chunkStarts[numChunks]);
+  vtkSMPTools::For(0, numChunks, 1, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType chunk = begin; chunk < end; ++chunk)
+    {
+      vtkIdType newId = chunkStarts[chunk];
+      const vtkIdType last = std::min((chunk + 1) * chunkSize, numPoints);
+      for (vtkIdType id = chunk * chunkSize; id < last; ++id)
+      {
+        if (pointMap[id] == id)
+        {
+          newIds[id] = newId;
+          outputToInput[newId++] = id;
+        }
+      }
+    }
+  });
+  vtkSMPTools::For(0, numPoints, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType id = begin; id < end; ++id)
+    {
+      pointMap[id] = newIds[pointMap[id]];
+    }
+  });
+}
+
+/**
+ * Merges the points of `input` with vtkSMPTools into `newPts` and `outPD`,
+ * and fills `pointMap`. Returns false when `input` has no points array or
+ * infinite bounds, which the locator handles instead.
+ */
+bool vtkCleanMergePoints(vtkDataSet* input, double tol, vtkPoints* newPts, vtkPointData* outPD,
+  std::vector<vtkIdType>& pointMap)
+{
+  vtkPointSet* ps = vtkPointSet::SafeDownCast(input);
+  vtkDataArray* inPoints = ps && ps->GetPoints() ? ps->GetPoints()->GetData() : nullptr;
+  double bounds[6];
+  input->GetBounds(bounds);
+  if (!inPoints || inPoints->GetNumberOfComponents() != 3 ||
+    !std::all_of(bounds, bounds + 6, [](double b) { return vtkMath::IsFinite(b); }))
+  {
+    return false;
+  }
+
+  const vtkCleanBins bins(bounds, input->GetNumberOfPoints(), tol);
+  vtkCleanMergeWorker merge{ &bins, tol, pointMap.data() };
+  if (!vtkArrayDispatch::DispatchByValueType<vtkArrayDispatch::Reals>::Execute(inPoints, merge))
+  {
+    merge(inPoints);
+  }
+
+  std::vector<vtkIdType> outputToInput;
+  vtkCleanNumberPoints(pointMap, outputToInput);
+  const vtkIdType numNewPts = static_cast<vtkIdType>(outputToInput.size());
+
+  newPts->SetNumberOfPoints(numNewPts);
+  vtkCleanCopyPointsWorker copy{ outputToInput.data() };
+  using Dispatcher =
+    vtkArrayDispatch::Dispatch2ByValueType<vtkArrayDispatch::Reals, vtkArrayDispatch::Reals>;
+  if (!Dispatcher::Execute(inPoints, newPts->GetData(), copy))
+  {
+    copy(inPoints, newPts->GetData());
+  }
+
+  vtkNew<vtkIdList> fromIds;
+  vtkNew<vtkIdList> toIds;
+  fromIds->SetNumberOfIds(numNewPts);
+  toIds->SetNumberOfIds(numNewPts);
+  std::copy(outputToInput.begin(), outputToInput.end(), fromIds->GetPointer(0));
+  for (vtkIdType id = 0; id < numNewPts; ++id)
+  {
+    toIds->SetId(id, id);
+  }
+  outPD->CopyAllocate(input->GetPointData(), numNewPts);
+  outPD->CopyData(input->GetPointData(), fromIds, toIds);
+  return true;
+}
+}
+
 vtkStandardNewMacro(vtkCleanUnstructuredGrid);
 vtkCxxSetObjectMacro(vtkCleanUnstructuredGrid, Locator, vtkIncrementalPointLocator);
 
@@ -43,6 +641,7 @@ vtkCleanUnstructuredGrid::~vtkCleanUnstructuredGrid()
 void vtkCleanUnstructuredGrid::PrintSelf(ostream& os, vtkIndent indent)
 {
   this->Superclass::PrintSelf(os, indent);
+  os << indent << "UseLocator: " << this->UseLocator << endl;
 }
 
 //----------------------------------------------------------------------------
@@ -103,44 +702,67 @@ int vtkCleanUnstructuredGrid::RequestData(vtkInformation* vtkNotUsed(request),
   vtkIdType num = input->GetNumberOfPoints();
   vtkIdType id;
   vtkIdType newId;
-  vtkIdType* ptMap = new vtkIdType[num];
+  std::vector<vtkIdType> ptMap(num);
   double pt[3];
 
-  this->CreateDefaultLocator(input);
-  if (this->ToleranceIsAbsolute)
-  {
-    this->Locator->SetTolerance(this->AbsoluteTolerance);
-  }
-  else
-  {
-    this->Locator->SetTolerance(this->Tolerance * input->GetLength());
-  }
-  double bounds[6];
-  input->GetBounds(bounds);
-  this->Locator->InitPointInsertion(newPts, bounds);
-
+  const double tol =
+    this->ToleranceIsAbsolute ? this->AbsoluteTolerance : this->Tolerance * input->GetLength();
   vtkIdType progressStep = num / 100;
   if (progressStep == 0)
   {
     progressStep = 1;
   }
-  for (id = 0; id < num; ++id)
+  if (!this->UseLocator && !this->Locator &&
+    vtkCleanMergePoints(input, tol, newPts, output->GetPointData(), ptMap))
   {
-    if (id % progressStep == 0)
+    this->UpdateProgress(0.8);
+  }
+  else
+  {
+    // a default locator is not kept, so that the next execution does not take
+    // it for one that was set.
+    const bool defaultLocator = this->Locator == nullptr;
+    this->CreateDefaultLocator(input);
+    this->Locator->SetTolerance(tol);
+    double bounds[6];
+    input->GetBounds(bounds);
+    this->Locator->InitPointInsertion(newPts, bounds);
+
+    for (id = 0; id < num; ++id)
     {
-      this->UpdateProgress(0.8 * ((float)id / num));
+      if (id % progressStep == 0)
+      {
+        this->UpdateProgress(0.8 * ((float)id / num));
+      }
+      input->GetPoint(id, pt);
+      if (this->Locator->InsertUniquePoint(pt, newId))
+      {
+        output->GetPointData()->CopyData(input->GetPointData(), id, newId);
+      }
+      ptMap[id] = newId;
     }
-    input->GetPoint(id, pt);
-    if (this->Locator->InsertUniquePoint(pt, newId))
+    if (defaultLocator)
     {
-      output->GetPointData()->CopyData(input->GetPointData(), id, newId);
+      this->Locator->UnRegister(this);
+      this->Locator = nullptr;
     }
-    ptMap[id] = newId;
   }
   output->SetPoints(newPts);
   newPts->Delete();
 
-  // Now copy the cells.
+  // Now copy the cells. Without polyhedra, the cells of an unstructured grid
+  // are copied at once and their point ids are remapped in parallel.
+  vtkUnstructuredGrid* inputGrid = vtkUnstructuredGrid::SafeDownCast(input);
+  if (inputGrid && !inputGrid->GetFaces())
+  {
+    vtkNew<vtkCellArray> cells;
+    cells->DeepCopy(inputGrid->GetCells());
+    cells->Visit(vtkCleanRemapConnectivity{}, ptMap.data());
+    output->SetCells(inputGrid->GetCellTypesArray(), cells);
+    output->Squeeze();
+    return 1;
+  }
+
   vtkIdList* cellPoints = vtkIdList::New();
   num = input->GetNumberOfCells();
   output->Allocate(num);
@@ -151,10 +773,10 @@ int vtkCleanUnstructuredGrid::RequestData(vtkInformation* vtkNotUsed(request),
       this->UpdateProgress(0.8 + 0.2 * ((float)id / num));
     }
     // special handling for polyhedron cells
-    if (vtkUnstructuredGrid::SafeDownCast(input) && input->GetCellType(id) == VTK_POLYHEDRON)
+    if (inputGrid && input->GetCellType(id) == VTK_POLYHEDRON)
     {
-      vtkUnstructuredGrid::SafeDownCast(input)->GetFaceStream(id, cellPoints);
-      vtkUnstructuredGrid::ConvertFaceStreamPointIds(cellPoints, ptMap);
+      inputGrid->GetFaceStream(id, cellPoints);
+      vtkUnstructuredGrid::ConvertFaceStreamPointIds(cellPoints, ptMap.data());
     }
     else
     {
@@ -169,7 +791,6 @@ int vtkCleanUnstructuredGrid::RequestData(vtkInformation* vtkNotUsed(request),
     output->InsertNextCell(input->GetCellType(id), cellPoints);
   }
 
-  delete[] ptMap;
   cellPoints->Delete();
   output->Squeeze();
 
@@ -23,6 +23,17 @@
  * merge duplicate points (with coincident coordinates) using the vtkMergePoints object
  * to merge points.
  *
+ * Points of a vtkPointSet are merged with vtkSMPTools unless UseLocator is on
+ * or a Locator was set.
+ * The points are sorted by spatial bin. Coincident points are then merged as
+ * runs of the sorted points, and points within a positive tolerance are found
+ * in the neighbouring bins. Bins crowded with points are divided further, down
+ * to the tolerance, so a search only scans the points near it. A point is
+ * merged with the earliest kept point that matches it, so the output does not
+ * depend on the number of threads. With a zero tolerance, the output is the
+ * same as with vtkMergePoints. With a positive tolerance, vtkPointLocator
+ * takes the first matching point it finds instead.
+ *
  * @sa
  * vtkCleanPolyData
 */
@@ -62,8 +73,10 @@ public:
 
   //@{
   /**
-   * Set/Get a spatial locator for speeding the search process. By
-   * default an instance of vtkMergePoints is used.
+   * Set/Get a spatial locator for speeding the search process. When set, the
+   * points are inserted one at a time in it. Otherwise, a vtkMergePoints, or a
+   * vtkPointLocator with a positive tolerance, is created when the points are
+   * not merged with vtkSMPTools.
    */
   virtual void SetLocator(vtkIncrementalPointLocator* locator);
   vtkGetObjectMacro(Locator, vtkIncrementalPointLocator);
@@ -75,6 +88,17 @@ public:
   // Release locator
   void ReleaseLocator() { this->SetLocator(nullptr); }
 
+  //@{
+  /**
+   * Set/Get whether points are inserted one at a time in the Locator, instead
+   * of being merged with vtkSMPTools. The Locator is always used when it was
+   * set, and for inputs that are not vtkPointSet. Default is false.
+   */
+  vtkSetMacro(UseLocator, bool);
+  vtkGetMacro(UseLocator, bool);
+  vtkBooleanMacro(UseLocator, bool);
+  //@}
+
   //@{
   /**
    * Set/get the desired precision for the output types. See the documentation
@@ -96,6 +120,7 @@ protected:
   double Tolerance = 0.0;
   double AbsoluteTolerance = 1.0;
   vtkIncrementalPointLocator* Locator = nullptr;
+  bool UseLocator = false;
   int OutputPointsPrecision = vtkAlgorithm::DEFAULT_PRECISION;
 
   int RequestData(vtkInformation*, vtkInformationVector**, vtkInformationVector*) override;
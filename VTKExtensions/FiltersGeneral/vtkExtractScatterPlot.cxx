@@ -14,36 +14,179 @@
 =========================================================================*/
 
 #include "vtkExtractScatterPlot.h"
+#include "vtkArrayDispatch.h"
 #include "vtkCellData.h"
+#include "vtkDataArrayAccessor.h"
 #include "vtkDoubleArray.h"
 #include "vtkInformation.h"
 #include "vtkInformationVector.h"
 #include "vtkMath.h"
+#include "vtkMultiProcessController.h"
+#include "vtkNew.h"
 #include "vtkObjectFactory.h"
 #include "vtkPointData.h"
 #include "vtkPolyData.h"
+#include "vtkSMPThreadLocal.h"
+#include "vtkSMPTools.h"
 #include "vtkStreamingDemandDrivenPipeline.h"
 #include "vtkUnsignedLongArray.h"
 
 #include "vtkIOStream.h"
 
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+// Uniform bins over a range. The first and last extents are offset by
+// epsilon so that the extrema fall in the first and last bins.
+class vtkScatterPlotAxis
+{
+public:
+  vtkScatterPlotAxis(const double range[2], int count)
+    : Minimum(range[0])
+    , Delta((range[1] - range[0]) / count)
+    , Count(count)
+    , Extents(count + 1)
+  {
+    this->Extents[0] = range[0] - VTK_DBL_EPSILON;
+    for (int i = 1; i < count; ++i)
+    {
+      this->Extents[i] = range[0] + (i * this->Delta);
+    }
+    this->Extents[count] = range[1] + VTK_DBL_EPSILON;
+  }
+
+  /**
+   * Returns the bin `i` such that Extents[i] <= value < Extents[i + 1], or -1.
+   * The bin is computed, then moved by the extents comparisons so that values
+   * on a boundary fall in the same bin as with a search.
+   */
+  int Find(double value) const
+  {
+    if (!(this->Extents[0] <= value && value < this->Extents[this->Count]))
+    {
+      return -1;
+    }
+    int i = this->Count - 1;
+    if (this->Delta > 0)
+    {
+      const double bin = (value - this->Minimum) / this->Delta;
+      i = bin < this->Count ? static_cast<int>(std::max(bin, 0.0)) : this->Count - 1;
+    }
+    while (value < this->Extents[i])
+    {
+      --i;
+    }
+    while (value >= this->Extents[i + 1])
+    {
+      ++i;
+    }
+    return i;
+  }
+
+  const double Minimum;
+  const double Delta;
+  const int Count;
+  std::vector<double> Extents;
+};
+
+template <typename XArrayT, typename YArrayT>
+class vtkScatterPlotFunctor
+{
+public:
+  vtkScatterPlotFunctor(XArrayT* xArray, int xComponent, const vtkScatterPlotAxis& xAxis,
+    YArrayT* yArray, int yComponent, const vtkScatterPlotAxis& yAxis)
+    : XArray(xArray)
+    , YArray(yArray)
+    , XComponent(xComponent)
+    , YComponent(yComponent)
+    , XAxis(xAxis)
+    , YAxis(yAxis)
+    , Counts(static_cast<size_t>(xAxis.Count) * yAxis.Count, 0)
+  {
+  }
+
+  void Initialize() { this->LocalCounts.Local().assign(this->Counts.size(), 0); }
+
+  void operator()(vtkIdType begin, vtkIdType end)
+  {
+    vtkDataArrayAccessor<XArrayT> x(this->XArray);
+    vtkDataArrayAccessor<YArrayT> y(this->YArray);
+    vtkTypeUInt64* counts = this->LocalCounts.Local().data();
+    for (vtkIdType t = begin; t < end; ++t)
+    {
+      const int i = this->XAxis.Find(static_cast<double>(x.Get(t, this->XComponent)));
+      const int j = i < 0 ? -1 : this->YAxis.Find(static_cast<double>(y.Get(t, this->YComponent)));
+      if (j >= 0)
+      {
+        ++counts[static_cast<size_t>(i) * this->YAxis.Count + j];
+      }
+    }
+  }
+
+  void Reduce()
+  {
+    for (auto iter = this->LocalCounts.begin(); iter != this->LocalCounts.end(); ++iter)
+    {
+      for (size_t cc = 0; cc < this->Counts.size(); ++cc)
+      {
+        this->Counts[cc] += (*iter)[cc];
+      }
+    }
+  }
+
+  XArrayT* XArray;
+  YArrayT* YArray;
+  const int XComponent;
+  const int YComponent;
+  const vtkScatterPlotAxis& XAxis;
+  const vtkScatterPlotAxis& YAxis;
+  // x bin major, as in "bin_values".
+  std::vector<vtkTypeUInt64> Counts;
+  vtkSMPThreadLocal<std::vector<vtkTypeUInt64> > LocalCounts;
+};
+
+struct vtkScatterPlotWorker
+{
+  int XComponent;
+  int YComponent;
+  const vtkScatterPlotAxis* XAxis;
+  const vtkScatterPlotAxis* YAxis;
+  std::vector<vtkTypeUInt64> Counts;
+
+  template <typename XArrayT, typename YArrayT>
+  void operator()(XArrayT* xArray, YArrayT* yArray)
+  {
+    vtkScatterPlotFunctor<XArrayT, YArrayT> functor(
+      xArray, this->XComponent, *this->XAxis, yArray, this->YComponent, *this->YAxis);
+    vtkSMPTools::For(0, xArray->GetNumberOfTuples(), functor);
+    this->Counts.swap(functor.Counts);
+  }
+};
+}
+
 vtkStandardNewMacro(vtkExtractScatterPlot);
+vtkCxxSetObjectMacro(vtkExtractScatterPlot, Controller, vtkMultiProcessController);
 
 vtkExtractScatterPlot::vtkExtractScatterPlot()
   : XComponent(0)
   , YComponent(0)
   , XBinCount(10)
   , YBinCount(10)
+  , Controller(NULL)
 {
   this->SetInputArrayToProcess(
     0, 0, 0, vtkDataObject::FIELD_ASSOCIATION_POINTS_THEN_CELLS, vtkDataSetAttributes::SCALARS);
 
   this->SetInputArrayToProcess(
     1, 0, 0, vtkDataObject::FIELD_ASSOCIATION_POINTS_THEN_CELLS, vtkDataSetAttributes::SCALARS);
+  this->SetController(vtkMultiProcessController::GetGlobalController());
 }
 
 vtkExtractScatterPlot::~vtkExtractScatterPlot()
 {
+  this->SetController(NULL);
 }
 
 void vtkExtractScatterPlot::PrintSelf(ostream& os, vtkIndent indent)
@@ -54,6 +197,7 @@ void vtkExtractScatterPlot::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << "YComponent: " << this->YComponent << "\n";
   os << indent << "XBinCount: " << this->XBinCount << "\n";
   os << indent << "YBinCount: " << this->YBinCount << "\n";
+  os << indent << "Controller: " << this->Controller << "\n";
 }
 
 int vtkExtractScatterPlot::FillInputPortInformation(int port, vtkInformation* info)
@@ -67,7 +211,7 @@ int vtkExtractScatterPlot::FillInputPortInformation(int port, vtkInformation* in
 int vtkExtractScatterPlot::RequestData(vtkInformation* /*request*/,
   vtkInformationVector** inputVector, vtkInformationVector* outputVector)
 {
-  int i, j;
+  int i;
 
   vtkDebugMacro(<< "Executing vtkExtractScatterPlot filter");
 
@@ -90,7 +234,7 @@ int vtkExtractScatterPlot::RequestData(vtkInformation* /*request*/,
 
   vtkDoubleArray* const y_bin_extents = vtkDoubleArray::New();
   y_bin_extents->SetNumberOfComponents(1);
-  y_bin_extents->SetNumberOfTuples(this->XBinCount + 1);
+  y_bin_extents->SetNumberOfTuples(this->YBinCount + 1);
   y_bin_extents->SetName("y_bin_extents");
   for (i = 0; i != this->YBinCount + 1; ++i)
   {
@@ -99,101 +243,81 @@ int vtkExtractScatterPlot::RequestData(vtkInformation* /*request*/,
   output_data->GetCellData()->AddArray(y_bin_extents);
   y_bin_extents->Delete();
 
-  // Find the field to process, if we can't find anything, we return an
-  // empty dataset
-  vtkDataArray* const x_data_array = this->GetInputArrayToProcess(0, inputVector);
-  if (!x_data_array)
+  // Find the fields to process. If we can't find anything, if a requested
+  // component is out-of-range for the input, or if both fields do not have the
+  // same number of tuples, this process has no values to bin.
+  vtkDataArray* x_data_array = this->GetInputArrayToProcess(0, inputVector);
+  vtkDataArray* y_data_array = this->GetInputArrayToProcess(1, inputVector);
+  if (!x_data_array || !y_data_array ||
+    this->XComponent >= x_data_array->GetNumberOfComponents() ||
+    this->YComponent >= y_data_array->GetNumberOfComponents() ||
+    x_data_array->GetNumberOfTuples() != y_data_array->GetNumberOfTuples())
   {
-    return 1;
-  }
-  // If the requested component is out-of-range for the input, we return an
-  // empty dataset
-  if (this->XComponent < 0 || this->XComponent >= x_data_array->GetNumberOfComponents())
-  {
-    return 1;
+    x_data_array = y_data_array = NULL;
   }
 
-  // Find the field to process, if we can't find anything, we return an
-  // empty dataset
-  vtkDataArray* const y_data_array = this->GetInputArrayToProcess(1, inputVector);
-  if (!y_data_array)
+  // Calculate the extents of each bin, based on the range of values in the
+  // input of all processes.
+  double x_range[2] = { VTK_DOUBLE_MAX, -VTK_DOUBLE_MAX };
+  double y_range[2] = { VTK_DOUBLE_MAX, -VTK_DOUBLE_MAX };
+  if (x_data_array)
   {
-    return 1;
+    x_data_array->GetRange(x_range, this->XComponent);
+    y_data_array->GetRange(y_range, this->YComponent);
   }
-  // If the requested component is out-of-range for the input, we return an
-  // empty dataset
-  if (this->YComponent < 0 || this->YComponent >= y_data_array->GetNumberOfComponents())
+  const bool parallel = this->Controller && this->Controller->GetNumberOfProcesses() > 1;
+  if (parallel)
   {
-    return 1;
+    // the minima of the ranges and of their negated maxima, and whether any
+    // process has values.
+    double local[5] = { x_range[0], y_range[0], -x_range[1], -y_range[1],
+      x_data_array ? 0.0 : 1.0 };
+    double global[5];
+    this->Controller->AllReduce(local, global, 5, vtkCommunicator::MIN_OP);
+    if (global[4] != 0.0)
+    {
+      return 1;
+    }
+    x_range[0] = global[0];
+    y_range[0] = global[1];
+    x_range[1] = -global[2];
+    y_range[1] = -global[3];
   }
-
-  // Both fields better have the same number of tuples!
-  if (x_data_array->GetNumberOfTuples() != y_data_array->GetNumberOfTuples())
+  else if (!x_data_array)
   {
     return 1;
   }
 
-  // Calculate the extents of each bin, based on the range of values in the
-  // input ...  we offset the first and last values in each range by
-  // epsilon to ensure that extrema don't fall "outside" the first or last
-  // bins due to errors in floating-point precision.
-  double x_range[2];
-  x_data_array->GetRange(x_range, this->XComponent);
-  const double x_bin_delta = (x_range[1] - x_range[0]) / this->XBinCount;
-
-  x_bin_extents->SetValue(0, x_range[0] - VTK_DBL_EPSILON);
-  for (i = 1; i < this->XBinCount; ++i)
-  {
-    x_bin_extents->SetValue(i, x_range[0] + (i * x_bin_delta));
-  }
-  x_bin_extents->SetValue(this->XBinCount, x_range[1] + VTK_DBL_EPSILON);
-
-  double y_range[2];
-  y_data_array->GetRange(y_range, this->YComponent);
-  const double y_bin_delta = (y_range[1] - y_range[0]) / this->YBinCount;
+  const vtkScatterPlotAxis x_axis(x_range, this->XBinCount);
+  const vtkScatterPlotAxis y_axis(y_range, this->YBinCount);
+  std::copy(x_axis.Extents.begin(), x_axis.Extents.end(), x_bin_extents->GetPointer(0));
+  std::copy(y_axis.Extents.begin(), y_axis.Extents.end(), y_bin_extents->GetPointer(0));
 
-  y_bin_extents->SetValue(0, y_range[0] - VTK_DBL_EPSILON);
-  for (i = 1; i < this->YBinCount; ++i)
+  // Insert values into bins ...
+  vtkScatterPlotWorker worker;
+  worker.XComponent = this->XComponent;
+  worker.YComponent = this->YComponent;
+  worker.XAxis = &x_axis;
+  worker.YAxis = &y_axis;
+  if (x_data_array &&
+    !vtkArrayDispatch::Dispatch2SameValueType::Execute(x_data_array, y_data_array, worker))
   {
-    y_bin_extents->SetValue(i, y_range[0] + (i * y_bin_delta));
+    worker(x_data_array, y_data_array);
   }
-  y_bin_extents->SetValue(this->YBinCount, y_range[1] + VTK_DBL_EPSILON);
+  worker.Counts.resize(static_cast<size_t>(this->XBinCount) * this->YBinCount, 0);
 
-  // Insert values into bins ...
   vtkUnsignedLongArray* const bin_values = vtkUnsignedLongArray::New();
   bin_values->SetNumberOfComponents(this->YBinCount);
   bin_values->SetNumberOfTuples(this->XBinCount);
   bin_values->SetName("bin_values");
+  std::copy(worker.Counts.begin(), worker.Counts.end(), bin_values->GetPointer(0));
 
-  for (i = 0; i != this->XBinCount; ++i)
+  if (parallel)
   {
-    for (j = 0; j != this->YBinCount; ++j)
-    {
-      bin_values->SetComponent(i, j, 0);
-    }
-  }
-
-  const int value_count = x_data_array->GetNumberOfTuples();
-  for (i = 0; i != value_count; ++i)
-  {
-    const double x = x_data_array->GetComponent(i, this->XComponent);
-    const double y = y_data_array->GetComponent(i, this->YComponent);
-
-    for (j = 0; j != this->XBinCount; ++j)
-    {
-      if (x_bin_extents->GetValue(j) <= x && x < x_bin_extents->GetValue(j + 1))
-      {
-        for (int k = 0; k != this->YBinCount; ++k)
-        {
-          if (y_bin_extents->GetValue(k) <= y && y < y_bin_extents->GetValue(k + 1))
-          {
-            bin_values->SetComponent(j, k, bin_values->GetComponent(j, k) + 1);
-            break;
-          }
-        }
-        break;
-      }
-    }
+    vtkNew<vtkUnsignedLongArray> local_values;
+    local_values->DeepCopy(bin_values);
+    bin_values->FillValue(0);
+    this->Controller->Reduce(local_values, bin_values, vtkCommunicator::SUM_OP, 0);
   }
 
   output_data->GetCellData()->AddArray(bin_values);
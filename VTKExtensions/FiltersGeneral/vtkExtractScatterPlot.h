@@ -24,6 +24,12 @@
  * between bins along each dimension.  It will also contain a
  * vtkUnsignedLongArray named "bin_values" which contains the value for
  * each bin.
+ *
+ * The bins are uniform over the range of each component. Values are binned
+ * by index arithmetic on the typed arrays, over ranges of tuples in
+ * parallel with vtkSMPTools. With a controller of more than one process,
+ * the ranges and the counts are those of all processes; the counts are
+ * reduced to the first process, and the other processes output zero counts.
 */
 
 #ifndef vtkExtractScatterPlot_h
@@ -32,6 +38,8 @@
 #include "vtkPVVTKExtensionsFiltersGeneralModule.h" //needed for exports
 #include "vtkPolyDataAlgorithm.h"
 
+class vtkMultiProcessController;
+
 class VTKPVVTKEXTENSIONSFILTERSGENERAL_EXPORT vtkExtractScatterPlot : public vtkPolyDataAlgorithm
 {
 public:
@@ -73,6 +81,15 @@ public:
   vtkGetMacro(YBinCount, int);
   //@}
 
+  //@{
+  /**
+   * Controller used to combine the ranges and counts of all processes.
+   * Defaults to the global controller.
+   */
+  virtual void SetController(vtkMultiProcessController*);
+  vtkGetObjectMacro(Controller, vtkMultiProcessController);
+  //@}
+
 private:
   vtkExtractScatterPlot();
   vtkExtractScatterPlot(const vtkExtractScatterPlot&) = delete;
@@ -87,6 +104,7 @@ private:
   int YComponent;
   int XBinCount;
   int YBinCount;
+  vtkMultiProcessController* Controller;
 };
 
 #endif
@@ -20,10 +20,10 @@
 #include "vtkCompositeDataIterator.h"
 #include "vtkCompositeDataPipeline.h"
 #include "vtkCompositeDataSet.h"
+#include "vtkConnectedComponentLabeler.h"
 #include "vtkDataObject.h"
 #include "vtkDataSet.h"
 #include "vtkDoubleArray.h"
-#include "vtkEquivalenceSet.h"
 #include "vtkIdList.h"
 #include "vtkIdTypeArray.h"
 #include "vtkInformation.h"
@@ -452,7 +452,8 @@ vtkGridConnectivityFace* vtkGridConnectivityFaceHash::AddFace(
 //-----------------------------------------------------------------------------
 vtkGridConnectivity::vtkGridConnectivity()
 {
-  this->EquivalenceSet = 0;
+  this->Equivalences = 0;
+  this->NumberOfFragmentSets = 0;
   this->FragmentVolumes = 0;
   this->FaceHash = 0;
   this->Controller = vtkMultiProcessController::GetGlobalController();
@@ -506,12 +507,12 @@ int vtkGridConnectivity::CheckInput(vtkUnstructuredGrid* input)
 // Partial fragments are connected cells that are discovered by a simple
 // pass through the cells (looking at neighbors).  I expect that the number
 // of partial fragments will be close to the number of final fragments.
-// The equivalence set will be used to merge partial fragments that touch.
+// The equivalences will be used to merge partial fragments that touch.
 // This method also integrates arrays for partial fragments.
 template <class T>
 void vtkGridConnectivityExecuteProcess(vtkGridConnectivity* self, vtkUnstructuredGrid* inputs[],
   int numberOfInputs, int processId, vtkGridConnectivityFaceHash* faceHash,
-  vtkEquivalenceSet* equivalenceSet, T* globalPtIdPtr)
+  vtkConnectedComponentLabeler* equivalences, T* globalPtIdPtr)
 {
   // Essentially a count of the fragment ids we have used so far.
   // We start counting from 1 so 0 can be a special value used to remove faces.
@@ -604,7 +605,7 @@ void vtkGridConnectivityExecuteProcess(vtkGridConnectivity* self, vtkUnstructure
               {
                 // This cell connects two fragments, we need
                 // to make the fragment ids equivalent.
-                equivalenceSet->AddEquivalence(minFragmentId, face->FragmentId);
+                equivalences->AddEquivalence(minFragmentId, face->FragmentId);
               }
               // Keep track of the smallest fragment id to use for this cell.
               if (minFragmentId > face->FragmentId)
@@ -634,13 +635,11 @@ void vtkGridConnectivityExecuteProcess(vtkGridConnectivity* self, vtkUnstructure
         // Is this the start of a new fragment?
         if (minFragmentId == nextFragmentId)
         { // Cell has no neighbors (traversed yet). New fragment id.
-          // Make sure the equivalence set has the correct number of members.
-          equivalenceSet->AddEquivalence(nextFragmentId, nextFragmentId);
           nextFragmentId++;
         }
-        // I do not think that the equivalence set has a more up to date id,
+        // I do not think that the equivalences have a more up to date id,
         // but it cannot hurt to check/
-        minFragmentId = equivalenceSet->GetEquivalentSetId(minFragmentId);
+        minFragmentId = static_cast<int>(equivalences->GetRepresentative(minFragmentId));
         // Label the faces with the fragment id we computed.
         for (int kk = 0; kk < numNewFaces; ++kk)
         {
@@ -856,9 +855,9 @@ int vtkGridConnectivity::RequestData(
     }
   }
 
-  // The equivalenceSet keeps track of fragment ids and which
+  // The equivalences keep track of fragment ids and which
   // fragment ids need to be combined into a single fragment.
-  this->EquivalenceSet = vtkEquivalenceSet::New();
+  this->Equivalences = vtkConnectedComponentLabeler::New();
   // Create the integration arrays that hold the volume and
   // integrated values for each attribute.  The arrays
   // are initialized to 0 and indexed by fragment id.
@@ -870,7 +869,7 @@ int vtkGridConnectivity::RequestData(
   switch (this->GlobalPointIdType)
   {
     vtkTemplateMacro(vtkGridConnectivityExecuteProcess(this, inputs, numberOfInputs,
-      this->ProcessId, this->FaceHash, this->EquivalenceSet, static_cast<VTK_TT*>(0)));
+      this->ProcessId, this->FaceHash, this->Equivalences, static_cast<VTK_TT*>(0)));
     default:
       vtkErrorMacro("ExecuteProcess: Unknown input ScalarType");
       return 0;
@@ -896,8 +895,9 @@ int vtkGridConnectivity::RequestData(
     delete this->FaceHash;
   }
   this->FaceHash = 0;
-  this->EquivalenceSet->Delete();
-  this->EquivalenceSet = 0;
+  this->Equivalences->Delete();
+  this->Equivalences = 0;
+  this->FragmentSetIds.clear();
 
   return 1;
 }
@@ -1174,6 +1174,9 @@ void vtkGridConnectivity::IntegrateCellVolume(
 // faces and arrays.  At the end of this method, process 0 has face hash,
 // equivalence set and arrays merged from all processes, and resolved.
 // Every thing looks like it was generated locally (single arrays...).
+// The other processes get the merged equivalence set, and the set of each
+// global fragment id, so that they can resolve the fragment ids of their
+// own faces.
 // Faces in the root process hash have a processId and marshalId to indicate
 // the source process.  This is important because only the source process has
 // the inputs used to create the surface geometry.  The marshalId is the index
@@ -1204,7 +1207,7 @@ void vtkGridConnectivity::CollectFacesAndArraysToRootProcess(
     numFaces = this->FaceHash->GetNumberOfFaces();
     // Number of fragments.  I assuem this is the
     // resolved number of fragments, but it will little difference.
-    vtkIdType numFragments = this->EquivalenceSet->GetNumberOfResolvedSets();
+    vtkIdType numFragments = this->NumberOfFragmentSets;
     msg1[0] = numFragments;
     msg1[1] = numFaces;
     this->Controller->Send(msg1, 2, 0, 890831);
@@ -1252,7 +1255,7 @@ void vtkGridConnectivity::CollectFacesAndArraysToRootProcess(
     // Build up a map to make each processes fragment
     int numProcs = this->Controller->GetNumberOfProcesses();
     fragmentIdMap[0] = 0;
-    fragmentIdMap[1] = this->EquivalenceSet->GetNumberOfMembers();
+    fragmentIdMap[1] = this->FragmentVolumes->GetNumberOfTuples();
     fragmentNumFaces[0] = 0;
     for (int procIdx = 1; procIdx < numProcs; ++procIdx)
     { // loop over every process.
@@ -1289,7 +1292,7 @@ void vtkGridConnectivity::CollectFacesAndArraysToRootProcess(
             // It is valid until we create another face. (recycle bin)
             // This cell connects two fragments, we need
             // to make the fragment ids equivalent.
-            this->EquivalenceSet->AddEquivalence(fragmentId, face->FragmentId);
+            this->Equivalences->AddEquivalence(fragmentId, face->FragmentId);
           }
           else
           { // Face is new.  Add our cell info.
@@ -1363,11 +1366,37 @@ void vtkGridConnectivity::CollectFacesAndArraysToRootProcess(
     }   // end loop over processes
   }     // end if process 0.
 
-  if (this->Controller->GetLocalProcessId() == 0)
+  // Process 0 found the equivalences between the fragments of different
+  // processes. Share them so that every process can number the fragments of
+  // its faces the same way process 0 does.
+  int numProcs = this->Controller->GetNumberOfProcesses();
+  int myProcId = this->Controller->GetLocalProcessId();
+  this->Controller->Broadcast(fragmentIdMap, numProcs + 1, 0);
+  std::vector<int> neighbors;
+  if (myProcId == 0)
+  {
+    for (int procIdx = 1; procIdx < numProcs; ++procIdx)
+    {
+      neighbors.push_back(procIdx);
+    }
+  }
+  else
+  {
+    // The local equivalences were resolved above, in local fragment ids.
+    this->Equivalences->ClearEquivalences();
+    neighbors.push_back(0);
+  }
+  this->Equivalences->MergeAcrossProcesses(this->Controller, neighbors);
+
+  if (myProcId == 0)
   {
     // Resolve all the fragments, faces and arrays for all processes.
     this->ResolveEquivalentFragments();
   }
+  else
+  {
+    this->Equivalences->ResolveEquivalences(fragmentIdMap[numProcs], this->FragmentSetIds);
+  }
 }
 
 //----------------------------------------------------------------------------
@@ -1380,8 +1409,8 @@ void vtkGridConnectivity::CollectFacesAndArraysToRootProcess(
 // The algorithm is:  Collect number of faces to process 0.
 // Create a map from process fragment ids to global fragment ids.
 // Collect face hashes to process 0 and merge into 1.
-// Send a mask/fragmentIdArray indexed by original process fragment id
-// back to originating process.
+// Send a mask indexed by original process face index back to originating
+// process, which resolves the fragment ids of the faces left in the mask.
 // The only issue I ran into is returning triangles to their original
 // process.  I am going to create a mask/fragment array to return.
 // The hash has to remember the original process face index to
@@ -1404,13 +1433,14 @@ void vtkGridConnectivity::ResolveProcessesFaces()
   { // Remote process
     // Now receive the triangles that survived the resolution process.
     numFaces = this->FaceHash->GetNumberOfFaces();
-    int* fragmentIds = new int[numFaces];
-    int* fragmentIdPtr = fragmentIds;
     if (numFaces)
     {
-      this->Controller->Receive(fragmentIds, numFaces, 0, 234301);
+      std::vector<unsigned char> faceMask(numFaces);
+      this->Controller->Receive(faceMask.data(), numFaces, 0, 234301);
       // Get rid of faces shared by multiple processe and
       // set the resolved fragment ids.
+      int fragmentIdOffset = fragmentIdMap[this->Controller->GetLocalProcessId()];
+      unsigned char* faceMaskPtr = faceMask.data();
       this->FaceHash->InitTraversal();
       vtkGridConnectivityFace* face;
       while ((face = this->FaceHash->GetNextFace()))
@@ -1419,9 +1449,9 @@ void vtkGridConnectivity::ResolveProcessesFaces()
         // we are in the middle of traversing the hash.
         // It would not work the way the iterator is implemented.
         // The invalid fragment id (value 0) will be enough to skip faces.
-        face->FragmentId = *fragmentIdPtr++;
+        face->FragmentId =
+          *faceMaskPtr++ ? this->GetFragmentSetId(face->FragmentId + fragmentIdOffset) : 0;
       }
-      delete[] fragmentIds;
       vtkIdType numFragments;
       this->Controller->Receive(&numFragments, 1, 0, 909034);
       this->FragmentVolumes->SetNumberOfTuples(numFragments);
@@ -1457,24 +1487,21 @@ void vtkGridConnectivity::ResolveProcessesFaces()
       numFaces = fragmentNumFaces[procIdx];
       if (numFaces)
       { // just in case new or MPI does not like 0 length arrays.
-        // Construct the mask / message
-        int* faceMask = new int[numFaces];
-        // Initialize the mask to "empty set".
-        // I am going to index the final fragments starting at 1
-        // so I can use 0 as the special "remove face" value.
-        memset(faceMask, 0, numFaces * sizeof(int));
+        // Construct the mask / message. The remote process numbers the
+        // fragments of its faces itself, it only needs to know which faces
+        // are left in the hash.
+        std::vector<unsigned char> faceMask(numFaces, 0);
         // Loop over the faces in the hash.
         this->FaceHash->InitTraversal();
         while ((face = this->FaceHash->GetNextFace()) != 0)
         {
           if (face->ProcessId == procIdx)
           {
-            faceMask[face->MarshalId] = face->FragmentId;
+            faceMask[face->MarshalId] = 1;
           } // end if face belongs to process.
         }   // endloop face in hash
         // Send the mask to the remote process.
-        this->Controller->Send(faceMask, numFaces, procIdx, 234301);
-        delete[] faceMask;
+        this->Controller->Send(faceMask.data(), numFaces, procIdx, 234301);
 
         // We need to send the volume array to the remote processes too.
         vtkIdType numFragments = this->FragmentVolumes->GetNumberOfTuples();
@@ -1529,7 +1556,8 @@ void vtkGridConnectivity::ResolveProcessesFaces()
 // volume array is indexed by the resolved fragments.
 void vtkGridConnectivity::ResolveEquivalentFragments()
 {
-  this->EquivalenceSet->ResolveEquivalences();
+  this->NumberOfFragmentSets = this->Equivalences->ResolveEquivalences(
+    this->FragmentVolumes->GetNumberOfTuples(), this->FragmentSetIds);
   this->ResolveIntegrationArrays();
   this->ResolveFaceFragmentIds();
 }
@@ -1545,29 +1573,24 @@ void vtkGridConnectivity::ResolveEquivalentFragments()
 // Merge intermediate fragment volume array to get final values.
 void vtkGridConnectivity::ResolveIntegrationArrays()
 {
-  if (!this->EquivalenceSet->Resolved)
+  int numMembers = static_cast<int>(this->FragmentSetIds.size());
+  if (numMembers != this->FragmentVolumes->GetNumberOfTuples())
   {
     vtkErrorMacro("Equivalences not resolved.");
     return;
   }
 
   vtkDoubleArray* newVolumes = vtkDoubleArray::New();
-  int numSets = this->EquivalenceSet->GetNumberOfResolvedSets();
+  int numSets = this->NumberOfFragmentSets;
   newVolumes->SetNumberOfTuples(numSets);
   // Initialize all values to 0 to start sumation.
   memset(newVolumes->GetPointer(0), 0, numSets * sizeof(double));
   // Loop over all the partial fragments summing volumes.
-  int numMembers = this->EquivalenceSet->GetNumberOfMembers();
-  if (this->FragmentVolumes->GetNumberOfTuples() < numMembers)
-  {
-    vtkErrorMacro("More partial fragments than volume entries.");
-    return;
-  }
   double* partialVolumePtr = this->FragmentVolumes->GetPointer(0);
   double* finalVolumePtr = newVolumes->GetPointer(0);
   for (int ii = 0; ii < numMembers; ++ii)
   {
-    int setId = this->EquivalenceSet->GetEquivalentSetId(ii);
+    int setId = this->FragmentSetIds[ii];
     finalVolumePtr[setId] += *partialVolumePtr;
     // update to the next fragment volume
     ++partialVolumePtr;
@@ -1579,14 +1602,14 @@ void vtkGridConnectivity::ResolveIntegrationArrays()
   this->FragmentVolumes = newVolumes;
 
   // we now need to update all the cell integration arrays
-  // do not update when the EquivalenceSet matches an item to itself
+  // do not update when the equivalences match an item to itself
   int numArrays = static_cast<int>(this->CellAttributesIntegration.size());
   for (int j = 0; j < numArrays; ++j)
   {
     vtkDoubleArray* da = this->CellAttributesIntegration[j];
     for (int i = 0; i < da->GetNumberOfTuples(); ++i)
     {
-      int setId = this->EquivalenceSet->GetEquivalentSetId(i);
+      int setId = this->GetFragmentSetId(i);
       if (i != setId)
       {
         double* oldIntegrationPtr = da->GetPointer(i);
@@ -1605,7 +1628,7 @@ void vtkGridConnectivity::ResolveIntegrationArrays()
     vtkDoubleArray* da = this->PointAttributesIntegration[j];
     for (int i = 0; i < da->GetNumberOfTuples(); ++i)
     {
-      int setId = this->EquivalenceSet->GetEquivalentSetId(i);
+      int setId = this->GetFragmentSetId(i);
       if (i != setId)
       {
         for (int k = 0; k < da->GetNumberOfComponents(); ++k)
@@ -1622,6 +1645,17 @@ void vtkGridConnectivity::ResolveIntegrationArrays()
   }
 }
 
+//----------------------------------------------------------------------------
+// Partial fragments beyond the resolved range are their own set.
+int vtkGridConnectivity::GetFragmentSetId(int fragmentId)
+{
+  if (fragmentId < 0 || fragmentId >= static_cast<int>(this->FragmentSetIds.size()))
+  {
+    return fragmentId;
+  }
+  return this->FragmentSetIds[fragmentId];
+}
+
 //----------------------------------------------------------------------------
 // This method expects that the equivalence set has been resolved,
 // but the faces in the has still have partial fragment ids.
@@ -1633,7 +1667,7 @@ void vtkGridConnectivity::ResolveFaceFragmentIds()
   this->FaceHash->InitTraversal();
   while ((face = this->FaceHash->GetNextFace()))
   {
-    face->FragmentId = this->EquivalenceSet->GetEquivalentSetId(face->FragmentId);
+    face->FragmentId = this->GetFragmentSetId(face->FragmentId);
   }
 }
 
@@ -41,7 +41,7 @@ class vtkInformation;
 class vtkInformationVector;
 class vtkMultiProcessController;
 class vtkGridConnectivityFaceHash;
-class vtkEquivalenceSet;
+class vtkConnectedComponentLabeler;
 class vtkUnstructuredGrid;
 class vtkPolyData;
 
@@ -86,7 +86,12 @@ protected:
 
   void InitializeIntegrationArrays(vtkUnstructuredGrid** inputs, int numberOfInputs);
 
-  vtkEquivalenceSet* EquivalenceSet;
+  // Equivalences between partial fragment ids, and the resolved set of each
+  // partial fragment once ResolveEquivalentFragments() was called.
+  vtkConnectedComponentLabeler* Equivalences;
+  std::vector<int> FragmentSetIds;
+  int NumberOfFragmentSets;
+  int GetFragmentSetId(int fragmentId);
   vtkDoubleArray* FragmentVolumes;
 
   std::vector<vtkSmartPointer<vtkDoubleArray> > CellAttributesIntegration;
@@ -17,15 +17,12 @@
 #include "vtkCellArray.h"
 #include "vtkCellData.h"
 #include "vtkCleanPolyData.h"
-#include "vtkCollection.h"
-#include "vtkCollectionIterator.h"
 #include "vtkCompositeDataIterator.h"
 #include "vtkDoubleArray.h"
 #include "vtkIdList.h"
 #include "vtkInformation.h"
 #include "vtkInformationVector.h"
 #include "vtkMath.h"
-#include "vtkMergePoints.h"
 #include "vtkMultiBlockDataSet.h"
 #include "vtkObjectFactory.h"
 #include "vtkPointData.h"
@@ -34,35 +31,36 @@
 #include "vtkSmartPointer.h"
 #include "vtkType.h"
 
-#include "vtkAppendCompositeDataLeaves.h"
 #include "vtkAppendPolyData.h"
 #include "vtkMultiProcessController.h"
 #include "vtkReductionFilter.h"
 #include "vtkStreamingDemandDrivenPipeline.h"
 
+#include <algorithm>
+#include <array>
+#include <map>
+#include <queue>
+#include <unordered_map>
+#include <utility>
+
 #define MY_MAX(x, y) ((x) < (y) ? (y) : (x))
 
-class vtkPlotEdges::Segment : public vtkObject
+class vtkPlotEdges::Segment
 {
-  vtkTypeMacro(Segment, vtkObject);
-  static Segment* New();
-  void PrintSelf(ostream& os, vtkIndent indent) override;
+public:
+  Segment();
 
-  vtkSetObjectMacro(PolyData, vtkPolyData);
-  vtkGetObjectMacro(PolyData, vtkPolyData);
+  void PrintSelf(ostream& os, vtkIndent indent) const;
 
-  void AddPoint(vtkIdType cellId, vtkIdType pointId);
-  void InsertSegment(vtkIdType pos, Segment* segment);
+  void AddPoint(vtkIdType pointId);
+  void InsertSegment(vtkIdType pos, const Segment& segment);
 
-  // vtkIdList* GetPointIdList();
-  vtkGetObjectMacro(PointIdList, vtkIdList);
-  unsigned int GetCountPointIds() { return this->PointIdList->GetNumberOfIds(); }
+  vtkIdType GetCountPointIds() const { return static_cast<vtkIdType>(this->PointIds.size()); }
 
   double GetLength() const;
-  vtkGetObjectMacro(ArcLengths, vtkDoubleArray);
 
-  vtkGetMacro(StartId, vtkIdType);
-  vtkGetMacro(EndId, vtkIdType);
+  vtkIdType GetStartId() const { return this->StartId; }
+  vtkIdType GetEndId() const { return this->EndId; }
 
   double* GetStartPoint(double* point) const;
   double* GetEndPoint(double* point) const;
@@ -71,97 +69,129 @@ class vtkPlotEdges::Segment : public vtkObject
   const double* GetEndDirection() const;
   double* GetDirection(vtkIdType pointId, double* direction) const;
 
-protected:
-  Segment();
-  ~Segment() override;
+  vtkPolyData* PolyData;
 
-  void ComputeDirection(vtkIdType pointIndex, bool increment, double* direction) const;
+  std::vector<vtkIdType> PointIds;
+  std::vector<double> ArcLengths;
 
-  vtkPolyData* PolyData;
+  // Incremented each time a segment is inserted, which changes the scores of
+  // the connections with this segment.
+  unsigned int Version;
+  // Set once the segment was inserted in another one.
+  bool Merged;
+
+protected:
+  void ComputeDirection(vtkIdType pointIndex, bool increment, double* direction) const;
+  void ResetDirections();
 
   vtkIdType StartId;
   vtkIdType EndId;
 
-  vtkIdList* PointIdList;
-  vtkDoubleArray* ArcLengths;
-
   mutable double StartDirection[3];
   mutable double EndDirection[3];
-
-private:
-  Segment(const vtkObject&) = delete;
-  void operator=(const Segment&) = delete;
 };
 
-class vtkPlotEdges::Node : public vtkObject
+class vtkPlotEdges::Node
 {
-  vtkTypeMacro(Node, vtkObject);
-  static Node* New();
-
-  vtkSetObjectMacro(PolyData, vtkPolyData);
-  vtkGetObjectMacro(PolyData, vtkPolyData);
-
-  vtkSetMacro(PointId, vtkIdType);
-  vtkGetMacro(PointId, vtkIdType);
-
-  void AddSegment(Segment* segment);
-  vtkGetObjectMacro(Segments, vtkCollection);
+public:
+  Node(vtkPolyData* polyData, vtkIdType pointId);
 
-  double ComputeConnectionScore(Segment* segment1, Segment* segment2);
+  void AddSegment(int segment) { this->Segments.push_back(segment); }
+  // Removes the first occurrence of the segment.
+  void RemoveSegment(int segment);
+  void ReplaceSegment(int segment, int newSegment);
+  int GetNumberOfSegments() const;
 
-protected:
-  Node();
-  ~Node() override;
+  double ComputeConnectionScore(const Segment& segment1, const Segment& segment2) const;
 
   vtkPolyData* PolyData;
   vtkIdType PointId;
-  vtkCollection* Segments;
 
-private:
-  Node(const vtkObject&) = delete;
-  void operator=(const Node&) = delete;
-};
+  // Segments ending at the node, or -1 once removed. Segments ending twice at
+  // the node are listed twice.
+  std::vector<int> Segments;
 
-vtkStandardNewMacro(vtkPlotEdges::Segment);
+  // Next node at the same point, or -1.
+  int Next;
+  // Set once the segments of the node were connected.
+  bool Processed;
+};
 
-vtkPlotEdges::Segment::Segment()
+// Segments and nodes of the lines of a polydata.
+class vtkPlotEdges::Graph
 {
-  this->PolyData = NULL;
+public:
+  // Merges the points of `input` and builds the links to its cells.
+  void Initialize(vtkPolyData* input);
 
-  this->StartId = -1;
-  this->EndId = -1;
+  int AddSegment();
+  int AddNode(vtkIdType pointId);
+  // Returns the first node created at the point, or -1.
+  int GetNodeAtPoint(vtkIdType pointId) const;
 
-  this->PointIdList = vtkIdList::New();
+  bool IsShared(vtkIdType pointId) const
+  {
+    return !this->SharedPoints.empty() && this->SharedPoints[pointId];
+  }
 
-  this->ArcLengths = vtkDoubleArray::New();
-  this->ArcLengths->SetName("arc_length");
-  this->ArcLengths->SetNumberOfComponents(1);
+  vtkSmartPointer<vtkPolyData> PolyData;
+  std::vector<Segment> Segments;
+  std::vector<Node> Nodes;
+  std::unordered_map<vtkIdType, int> NodeAtPoint;
 
-  this->StartDirection[0] = 0.;
-  this->StartDirection[1] = 0.;
-  this->StartDirection[2] = 0.;
-  this->EndDirection[0] = 0.;
-  this->EndDirection[1] = 0.;
-  this->EndDirection[2] = 0.;
-}
+  // Points also used by the lines of other processes. Segments are cut at
+  // these points, and their segments are connected on the first process.
+  std::vector<char> SharedPoints;
+};
+
+namespace
+{
+// Tag of the points that FindSharedPoints exchanges.
+const int SHARED_POINTS_TAG = 28710;
 
-vtkPlotEdges::Segment::~Segment()
+// A connection between the segments of 2 slots of a node.
+struct vtkSegmentPair
 {
-  if (this->PolyData)
+  double Score;
+  size_t SlotA;
+  size_t SlotB;
+  int SegmentA;
+  int SegmentB;
+  unsigned int VersionA;
+  unsigned int VersionB;
+
+  // Among pairs of equal scores, the pair with the first slots wins, as with
+  // a search over all the pairs.
+  bool operator<(const vtkSegmentPair& other) const
   {
-    this->PolyData->Delete();
+    if (this->Score != other.Score)
+    {
+      return this->Score < other.Score;
+    }
+    return std::make_pair(this->SlotA, this->SlotB) > std::make_pair(other.SlotA, other.SlotB);
   }
-  this->PointIdList->Delete();
-  this->ArcLengths->Delete();
+};
 }
 
-void vtkPlotEdges::Segment::PrintSelf(ostream& os, vtkIndent indent)
+vtkPlotEdges::Segment::Segment()
+{
+  this->PolyData = NULL;
+
+  this->Version = 0;
+  this->Merged = false;
+
+  this->StartId = -1;
+  this->EndId = -1;
+
+  this->ResetDirections();
+}
+
+void vtkPlotEdges::Segment::PrintSelf(ostream& os, vtkIndent indent) const
 {
-  this->Superclass::PrintSelf(os, indent);
   os << indent << "vtkPolyData: " << this->PolyData << endl;
   os << indent << "StartId: " << this->StartId << endl;
   os << indent << "EndId: " << this->EndId << endl;
-  os << indent << "Num Points" << this->PointIdList->GetNumberOfIds() << endl;
+  os << indent << "Num Points" << this->PointIds.size() << endl;
   os << indent << "Length" << this->GetLength() << endl;
   const double* direction = this->GetStartDirection();
   os << indent << "StartDirection: " << direction[0] << "," << direction[1] << "," << direction[2]
@@ -173,23 +203,18 @@ void vtkPlotEdges::Segment::PrintSelf(ostream& os, vtkIndent indent)
 
 double vtkPlotEdges::Segment::GetLength() const
 {
-  // return m_Length;
-  if (this->ArcLengths->GetMaxId() != -1)
-  {
-    return this->ArcLengths->GetValue(this->ArcLengths->GetMaxId());
-  }
-  return 0.;
+  return this->ArcLengths.empty() ? 0. : this->ArcLengths.back();
 }
 
 double* vtkPlotEdges::Segment::GetStartPoint(double* point) const
 {
-  const_cast<vtkPolyData*>(this->PolyData)->GetPoint(this->StartId, point);
+  this->PolyData->GetPoint(this->StartId, point);
   return point;
 }
 
 double* vtkPlotEdges::Segment::GetEndPoint(double* point) const
 {
-  const_cast<vtkPolyData*>(this->PolyData)->GetPoint(this->EndId, point);
+  this->PolyData->GetPoint(this->EndId, point);
   return point;
 }
 
@@ -200,7 +225,6 @@ const double* vtkPlotEdges::Segment::GetStartDirection() const
   {
     this->ComputeDirection(0, true, this->StartDirection);
   }
-  this->ComputeDirection(0, true, this->StartDirection);
   return this->StartDirection;
 }
 
@@ -208,9 +232,8 @@ const double* vtkPlotEdges::Segment::GetEndDirection() const
 {
   if (this->EndDirection[0] == 0. && this->EndDirection[1] == 0. && this->EndDirection[2] == 0.)
   {
-    this->ComputeDirection(this->PointIdList->GetNumberOfIds() - 1, false, this->EndDirection);
+    this->ComputeDirection(this->GetCountPointIds() - 1, false, this->EndDirection);
   }
-  this->ComputeDirection(this->PointIdList->GetNumberOfIds() - 1, false, this->EndDirection);
   return this->EndDirection;
 }
 
@@ -227,8 +250,10 @@ double* vtkPlotEdges::Segment::GetDirection(vtkIdType pointId, double* direction
   else
   {
     // warning, if the segment makes a loop, points may be listed
-    // more than once. this->PointIdList->GetId returns the first corresponding point
-    this->ComputeDirection(this->PointIdList->IsId(pointId), true, direction);
+    // more than once. the first corresponding point is used.
+    auto iter = std::find(this->PointIds.begin(), this->PointIds.end(), pointId);
+    this->ComputeDirection(
+      iter == this->PointIds.end() ? -1 : iter - this->PointIds.begin(), true, direction);
   }
   return direction;
 }
@@ -240,33 +265,25 @@ void vtkPlotEdges::Segment::ComputeDirection(
   direction[1] = 0.;
   direction[2] = 0.;
 
+  const vtkIdType numPoints = this->GetCountPointIds();
+
   // Point1
-  // vtkIdType pointIndex = this->PointIdList->IsId(pointId);
-  vtkIdType pointId = this->PointIdList->GetId(pointIndex);
-  if (pointIndex == -1 || pointId == -1)
+  if (pointIndex < 0 || pointIndex >= numPoints)
   {
-    cerr << "Given point " << pointId << " doesn't exist." << endl;
+    cerr << "Given point " << pointIndex << " doesn't exist." << endl;
     return;
   }
-  // cerr<< "DIR: pointId:" << pointId << " pointIndex: " << pointIndex << endl;
-
   double point1[3];
-
-  this->PolyData->GetPoint(pointId, point1);
-  // cerr<< "DIR: point1:" << point1[0] << "," << point1[1] << "," << point1[2] << endl;
+  this->PolyData->GetPoint(this->PointIds[pointIndex], point1);
 
   // Point2
   double point2[3];
   pointIndex += increment ? 1 : -1;
-  pointId = this->PointIdList->GetId(pointIndex);
-  // cerr<< "DIR: pointId:" << pointId << " pointIndex: " << pointIndex << endl;
-  if (pointIndex == -1 || pointIndex >= this->PointIdList->GetNumberOfIds())
+  if (pointIndex < 0 || pointIndex >= numPoints)
   { // not enough points to compute the direction
-    cerr << " NOT REALLY an error. please erase this line" << pointIndex << endl;
     return;
   }
-  this->PolyData->GetPoint(pointId, point2);
-  // cerr<< "DIR: point2:" << point2[0] << "," << point2[1] << "," << point2[2] << endl;
+  this->PolyData->GetPoint(this->PointIds[pointIndex], point2);
 
   // vector21
   double vector21[3];
@@ -275,10 +292,9 @@ void vtkPlotEdges::Segment::ComputeDirection(
   vector21[2] = point1[2] - point2[2];
 
   double length = vtkMath::Norm(vector21);
-  double averageLength = this->GetLength() / this->PointIdList->GetNumberOfIds();
+  double averageLength = this->GetLength() / numPoints;
   while (averageLength > length)
   {
-    // cerr<< "DIR: length: " << length << " average:" << averageLength << endl;
     direction[0] += vector21[0];
     direction[1] += vector21[1];
     direction[2] += vector21[2];
@@ -287,15 +303,12 @@ void vtkPlotEdges::Segment::ComputeDirection(
     // Go to next vector
     memcpy(point1, point2, 3 * sizeof(double));
     pointIndex += increment ? 1 : -1;
-    pointId = this->PointIdList->GetId(pointIndex);
-    if (pointIndex == -1 || pointIndex > this->PointIdList->GetNumberOfIds())
+    if (pointIndex < 0 || pointIndex >= numPoints)
     {
       cerr << "error. it is not logically possible to get this case." << endl;
       return;
     }
-    this->PolyData->GetPoint(pointId, point2);
-    // cerr<< "DIR: point1:" << point1[0] << "," << point1[1] << "," << point1[2] << endl;
-    // cerr<< "DIR: point2:" << point2[0] << "," << point2[1] << "," << point2[2] << endl;
+    this->PolyData->GetPoint(this->PointIds[pointIndex], point2);
     vector21[0] = point1[0] - point2[0];
     vector21[1] = point1[1] - point2[1];
     vector21[2] = point1[2] - point2[2];
@@ -307,10 +320,19 @@ void vtkPlotEdges::Segment::ComputeDirection(
     direction[1] += vector21[1] * (averageLength / length);
     direction[2] += vector21[2] * (averageLength / length);
   }
-  // cerr<< "DIR: direction:" << direction[0] << "," << direction[1] << "," << direction[2] << endl;
 }
 
-void vtkPlotEdges::Segment::AddPoint(vtkIdType vtkNotUsed(cellId), vtkIdType pointId)
+void vtkPlotEdges::Segment::ResetDirections()
+{
+  this->StartDirection[0] = 0.;
+  this->StartDirection[1] = 0.;
+  this->StartDirection[2] = 0.;
+  this->EndDirection[0] = 0.;
+  this->EndDirection[1] = 0.;
+  this->EndDirection[2] = 0.;
+}
+
+void vtkPlotEdges::Segment::AddPoint(vtkIdType pointId)
 {
   if (this->StartId == -1)
   {
@@ -319,169 +341,129 @@ void vtkPlotEdges::Segment::AddPoint(vtkIdType vtkNotUsed(cellId), vtkIdType poi
 
   double newPoint[3], currentPoint[3];
 
+  this->PolyData->GetPoint(pointId, newPoint);
   if (this->EndId != -1)
   {
-    this->PolyData->GetPoint(pointId, newPoint);
     this->PolyData->GetPoint(this->EndId, currentPoint);
   }
   else
   {
-    this->PolyData->GetPoint(pointId, newPoint);
     memcpy(currentPoint, newPoint, 3 * sizeof(double));
   }
 
   this->EndId = pointId;
-  this->PointIdList->InsertNextId(pointId);
-
-  double length = sqrt(vtkMath::Distance2BetweenPoints(currentPoint, newPoint));
-  // double length = vtkMath::Norm(direction);
+  this->PointIds.push_back(pointId);
+  this->ArcLengths.push_back(
+    this->GetLength() + sqrt(vtkMath::Distance2BetweenPoints(currentPoint, newPoint)));
 
-  if (this->ArcLengths->GetMaxId() != -1)
-  {
-    length += this->ArcLengths->GetValue(this->ArcLengths->GetMaxId());
-  }
-  this->ArcLengths->InsertNextValue(length);
-
-  // reset directions
-  this->StartDirection[0] = 0.;
-  this->StartDirection[1] = 0.;
-  this->StartDirection[2] = 0.;
-  this->EndDirection[0] = 0.;
-  this->EndDirection[1] = 0.;
-  this->EndDirection[2] = 0.;
-
-  /*
-    cerr <<  __FUNCTION__
-    << " pt:" << pointId << "(" << newPoint[0] << "," << newPoint[1]
-    << "," << newPoint[2] << ")" << " new length: " << m_Length
-    << " startDirection:(" << this->StartDirection[0]
-    << "," << this->StartDirection[1] << "," << this->StartDirection[2] << ")"
-    << " endDirection:(" << this->EndDirection[0]
-    << "," << this->EndDirection[1]
-    << "," << this->EndDirection[2] << ")" << endl;
-  */
+  this->ResetDirections();
 }
 
-void vtkPlotEdges::Segment::InsertSegment(vtkIdType pos, Segment* segment)
+void vtkPlotEdges::Segment::InsertSegment(vtkIdType pos, const Segment& segment)
 {
-  if (segment->PolyData != this->PolyData)
-  {
-    cerr << __FUNCTION__ << " can't mix segments with different vtkPolyData." << endl;
-    return;
-  }
-  // GetLength() can change during InsertSegment, we save the result here.
-  double length = this->GetLength();
-  // cerr << __FUNCTION__ << this->PointIdList->GetNumberOfIds() << " points with "
-  //          << segment->this->PointIdList->GetNumberOfIds() << endl;
+  // GetLength() can change during InsertSegment, we save the results here.
+  const double length = this->GetLength();
+  const double segmentLength = segment.GetLength();
+  const vtkIdType segmentNumPoints = segment.GetCountPointIds();
 
   // What is the point in common between the 2 segments.
   // that point has to be updated with the other segment extremity.
   if (this->StartId == pos)
   {
-    vtkIdList* unionList = vtkIdList::New();
-    vtkDoubleArray* arcLengths = vtkDoubleArray::New();
-    arcLengths->SetName(this->ArcLengths->GetName());
-    arcLengths->SetNumberOfComponents(1);
+    std::vector<vtkIdType> pointIds;
+    std::vector<double> arcLengths;
+    pointIds.reserve(segmentNumPoints + this->PointIds.size() - 1);
+    arcLengths.reserve(pointIds.capacity());
 
     // the segment is concatenated at the beginning.
-    if (segment->StartId == pos)
+    if (segment.StartId == pos)
     {
       // the list must be invertly copied
-      this->StartId = segment->EndId;
-      for (vtkIdType i = segment->PointIdList->GetNumberOfIds() - 1; i != -1; --i)
+      this->StartId = segment.EndId;
+      for (vtkIdType i = segmentNumPoints - 1; i != -1; --i)
       {
-        unionList->InsertNextId(segment->PointIdList->GetId(i));
-        arcLengths->InsertNextValue(segment->GetLength() - segment->ArcLengths->GetValue(i));
+        pointIds.push_back(segment.PointIds[i]);
+        arcLengths.push_back(segmentLength - segment.ArcLengths[i]);
       }
     }
     else
     {
-      this->StartId = segment->StartId;
-      for (vtkIdType i = 0; i < segment->PointIdList->GetNumberOfIds(); ++i)
-      {
-        unionList->InsertNextId(segment->PointIdList->GetId(i));
-        arcLengths->InsertNextValue(segment->ArcLengths->GetValue(i));
-      }
+      this->StartId = segment.StartId;
+      pointIds = segment.PointIds;
+      arcLengths = segment.ArcLengths;
     }
 
     // copy the point list
-    for (vtkIdType i = 1; i < this->PointIdList->GetNumberOfIds(); ++i)
+    for (size_t i = 1; i < this->PointIds.size(); ++i)
     {
-      unionList->InsertNextId(this->PointIdList->GetId(i));
-      arcLengths->InsertNextValue(this->ArcLengths->GetValue(i) + segment->GetLength());
+      pointIds.push_back(this->PointIds[i]);
+      arcLengths.push_back(this->ArcLengths[i] + segmentLength);
     }
 
-    this->PointIdList->DeepCopy(unionList);
-    this->ArcLengths->DeepCopy(arcLengths);
-
-    unionList->Delete();
-    arcLengths->Delete();
+    this->PointIds.swap(pointIds);
+    this->ArcLengths.swap(arcLengths);
   }
   else
   {
     // the segment is concatenated at the end.
-    if (segment->StartId == pos)
+    if (segment.StartId == pos)
     {
-      this->EndId = segment->EndId;
-      for (vtkIdType i = 1; i < segment->PointIdList->GetNumberOfIds(); ++i)
+      this->EndId = segment.EndId;
+      for (vtkIdType i = 1; i < segmentNumPoints; ++i)
       {
-        this->PointIdList->InsertNextId(segment->PointIdList->GetId(i));
-        this->ArcLengths->InsertNextValue(segment->ArcLengths->GetValue(i) + length);
+        this->PointIds.push_back(segment.PointIds[i]);
+        this->ArcLengths.push_back(segment.ArcLengths[i] + length);
       }
     }
     else
     {
-      this->EndId = segment->StartId;
-      for (vtkIdType i = segment->PointIdList->GetNumberOfIds() - 2; i != -1; --i)
+      this->EndId = segment.StartId;
+      for (vtkIdType i = segmentNumPoints - 2; i != -1; --i)
       {
-        this->PointIdList->InsertNextId(segment->PointIdList->GetId(i));
-        this->ArcLengths->InsertNextValue(
-          segment->GetLength() - segment->ArcLengths->GetValue(i) + length);
+        this->PointIds.push_back(segment.PointIds[i]);
+        this->ArcLengths.push_back(segmentLength - segment.ArcLengths[i] + length);
       }
     }
   }
-  // cerr << __FUNCTION__ << "startID: " << this->StartId
-  //          << " endId: " << this->EndId << endl;
-  this->StartDirection[0] = 0.;
-  this->StartDirection[1] = 0.;
-  this->StartDirection[2] = 0.;
-  this->EndDirection[0] = 0.;
-  this->EndDirection[1] = 0.;
-  this->EndDirection[2] = 0.;
-
-  // cerr << __FUNCTION__ << "end." << endl;
+  ++this->Version;
+  this->ResetDirections();
 }
 
-vtkStandardNewMacro(vtkPlotEdges::Node);
-
-vtkPlotEdges::Node::Node()
+vtkPlotEdges::Node::Node(vtkPolyData* polyData, vtkIdType pointId)
+  : PolyData(polyData)
+  , PointId(pointId)
+  , Next(-1)
+  , Processed(false)
 {
-  this->PolyData = NULL;
-  this->PointId = -1;
-  this->Segments = vtkCollection::New();
 }
 
-vtkPlotEdges::Node::~Node()
+void vtkPlotEdges::Node::RemoveSegment(int segment)
 {
-  if (this->PolyData)
+  auto iter = std::find(this->Segments.begin(), this->Segments.end(), segment);
+  if (iter != this->Segments.end())
   {
-    this->PolyData->Delete();
+    *iter = -1;
   }
-  this->Segments->Delete();
 }
 
-void vtkPlotEdges::Node::AddSegment(Segment* segment)
+void vtkPlotEdges::Node::ReplaceSegment(int segment, int newSegment)
 {
-  this->Segments->AddItem(segment);
+  std::replace(this->Segments.begin(), this->Segments.end(), segment, newSegment);
 }
 
-double vtkPlotEdges::Node::ComputeConnectionScore(Segment* segment1, Segment* segment2)
+int vtkPlotEdges::Node::GetNumberOfSegments() const
 {
-  if (segment1 == segment2)
+  return static_cast<int>(
+    this->Segments.size() - std::count(this->Segments.begin(), this->Segments.end(), -1));
+}
+
+double vtkPlotEdges::Node::ComputeConnectionScore(
+  const Segment& segment1, const Segment& segment2) const
+{
+  if (&segment1 == &segment2)
   {
     return -1.;
   }
-  //  return segment1->GetLength() + segment2->GetLength();
 
   //        (a.b + 1)     1 -  | ||a||-||b|| |
   // Score =  -------  *(     ----------------- )
@@ -490,9 +472,8 @@ double vtkPlotEdges::Node::ComputeConnectionScore(Segment* segment1, Segment* se
   // identique point frequency
   // add a penalty if the 2 extremities are the same
   double segment1Direction[3], segment2Direction[3];
-  segment1->GetDirection(this->PointId, segment1Direction);
-  segment2->GetDirection(this->PointId, segment2Direction);
-  // cerr << __FUNCTION__ << " normalize" << endl;
+  segment1.GetDirection(this->PointId, segment1Direction);
+  segment2.GetDirection(this->PointId, segment2Direction);
   double segment1DirectionNorm = vtkMath::Normalize(segment1Direction);
   double segment2DirectionNorm = vtkMath::Normalize(segment2Direction);
 
@@ -505,20 +486,21 @@ double vtkPlotEdges::Node::ComputeConnectionScore(Segment* segment1, Segment* se
 
   double start1[3], end1[3];
   double start2[3], end2[3];
-  if (segment1->GetCountPointIds() <= 3 && ((segment1->GetStartId() == segment2->GetStartId() &&
-                                              segment1->GetEndId() == segment2->GetEndId()) ||
-                                             (segment1->GetStartId() == segment2->GetEndId() &&
-                                               segment1->GetEndId() == segment2->GetStartId())))
+  if (segment1.GetCountPointIds() <= 3 &&
+    ((segment1.GetStartId() == segment2.GetStartId() &&
+       segment1.GetEndId() == segment2.GetEndId()) ||
+        (segment1.GetStartId() == segment2.GetEndId() &&
+          segment1.GetEndId() == segment2.GetStartId())))
   {
     penaltyScore = 0.4;
   }
   else
   {
-    segment1->GetStartPoint(start1);
-    segment1->GetEndPoint(end1);
-    segment2->GetStartPoint(start2);
-    segment2->GetEndPoint(end2);
-    if (segment1->GetCountPointIds() <= 3 &&
+    segment1.GetStartPoint(start1);
+    segment1.GetEndPoint(end1);
+    segment2.GetStartPoint(start2);
+    segment2.GetEndPoint(end2);
+    if (segment1.GetCountPointIds() <= 3 &&
       ((vtkMath::Distance2BetweenPoints(start1, start2) < 0.00001 &&
          vtkMath::Distance2BetweenPoints(end1, end2) < 0.00001) ||
           (vtkMath::Distance2BetweenPoints(start1, end2) < 0.00001 &&
@@ -531,6 +513,55 @@ double vtkPlotEdges::Node::ComputeConnectionScore(Segment* segment1, Segment* se
   return angleScore * pointFrequencyScore * penaltyScore;
 }
 
+void vtkPlotEdges::Graph::Initialize(vtkPolyData* input)
+{
+  vtkSmartPointer<vtkCleanPolyData> cleanPolyData = vtkSmartPointer<vtkCleanPolyData>::New();
+  cleanPolyData->SetInputData(input);
+  // set the tolerance at 0 to use vtkMergePoints (faster)
+  cleanPolyData->SetTolerance(0.0);
+  cleanPolyData->Update();
+
+  this->PolyData = cleanPolyData->GetOutput();
+  if (this->PolyData->GetNumberOfPoints() > 0)
+  {
+    this->PolyData->BuildLinks();
+  }
+  this->Segments.clear();
+  this->Nodes.clear();
+  this->NodeAtPoint.clear();
+  this->SharedPoints.clear();
+}
+
+int vtkPlotEdges::Graph::AddSegment()
+{
+  this->Segments.push_back(Segment());
+  this->Segments.back().PolyData = this->PolyData;
+  return static_cast<int>(this->Segments.size()) - 1;
+}
+
+int vtkPlotEdges::Graph::AddNode(vtkIdType pointId)
+{
+  const int node = static_cast<int>(this->Nodes.size());
+  this->Nodes.push_back(Node(this->PolyData, pointId));
+  auto inserted = this->NodeAtPoint.insert(std::make_pair(pointId, node));
+  if (!inserted.second)
+  {
+    int last = inserted.first->second;
+    while (this->Nodes[last].Next != -1)
+    {
+      last = this->Nodes[last].Next;
+    }
+    this->Nodes[last].Next = node;
+  }
+  return node;
+}
+
+int vtkPlotEdges::Graph::GetNodeAtPoint(vtkIdType pointId) const
+{
+  auto iter = this->NodeAtPoint.find(pointId);
+  return iter == this->NodeAtPoint.end() ? -1 : iter->second;
+}
+
 vtkStandardNewMacro(vtkPlotEdges);
 
 // Construct object with MaximumLength set to 1000.
@@ -554,7 +585,6 @@ int vtkPlotEdges::FillInputPortInformation(int port, vtkInformation* info)
   }
   return 0;
 }
-
 int vtkPlotEdges::RequestData(vtkInformation* vtkNotUsed(request),
   vtkInformationVector** inputVector, vtkInformationVector* outputVector)
 {
@@ -615,32 +645,86 @@ int vtkPlotEdges::RequestData(vtkInformation* vtkNotUsed(request),
 
 void vtkPlotEdges::Process(vtkPolyData* input, vtkMultiBlockDataSet* outputMultiBlock)
 {
+  vtkMultiProcessController* controller = vtkMultiProcessController::GetGlobalController();
+  const bool parallel = controller && controller->GetNumberOfProcesses() > 1;
+
+  // vtkPlotEdges cannot handle ghost-cells at all. Remove all ghost cells
+  // BUG #12422.
   vtkSmartPointer<vtkPolyData> inputPolyData = vtkSmartPointer<vtkPolyData>::New();
-  ReducePolyData(input, inputPolyData);
+  inputPolyData->ShallowCopy(input);
+  inputPolyData->RemoveGhostCells();
 
-  vtkMultiProcessController* controller = vtkMultiProcessController::GetGlobalController();
+  Graph graph;
+  graph.Initialize(inputPolyData);
+  if (parallel)
+  {
+    vtkPlotEdges::FindSharedPoints(controller, graph);
+  }
+  this->ExtractSegments(graph);
+  this->ConnectSegmentsWithNodes(graph);
 
-  if (controller->GetLocalProcessId() > 0)
+  std::vector<int> segments;
+  std::vector<int> sharedSegments;
+  for (size_t i = 0; i < graph.Segments.size(); ++i)
   {
-    int number_of_blocks = 0;
-    controller->Broadcast(&number_of_blocks, 1, 0);
-    // to ensure structure matches on all processes.
-    outputMultiBlock->SetNumberOfBlocks(number_of_blocks);
-    return;
+    const Segment& segment = graph.Segments[i];
+    if (!segment.Merged)
+    {
+      const bool shared =
+        graph.IsShared(segment.GetStartId()) || graph.IsShared(segment.GetEndId());
+      (shared ? sharedSegments : segments).push_back(static_cast<int>(i));
+    }
   }
 
-  vtkCollection* segments = vtkCollection::New();
-  vtkCollection* nodes = vtkCollection::New();
+  if (!parallel)
+  {
+    outputMultiBlock->SetNumberOfBlocks(static_cast<unsigned int>(segments.size()));
+    this->SaveToMultiBlockDataSet(graph, segments, outputMultiBlock, 0);
+    return;
+  }
 
-  this->ExtractSegments(inputPolyData, segments, nodes);
-  this->ConnectSegmentsWithNodes(segments, nodes);
-  this->SaveToMultiBlockDataSet(segments, outputMultiBlock);
+  // The segments ending on a shared point are connected on the first process.
+  vtkSmartPointer<vtkPolyData> sharedPolyData = vtkSmartPointer<vtkPolyData>::New();
+  vtkPlotEdges::SaveToPolyData(graph, sharedSegments, sharedPolyData);
+  vtkSmartPointer<vtkPolyData> gatheredPolyData = vtkSmartPointer<vtkPolyData>::New();
+  vtkPlotEdges::ReducePolyData(sharedPolyData, gatheredPolyData);
 
-  segments->Delete();
-  nodes->Delete();
+  Graph sharedGraph;
+  std::vector<int> connectedSegments;
+  if (controller->GetLocalProcessId() == 0)
+  {
+    sharedGraph.Initialize(gatheredPolyData);
+    this->ExtractSegments(sharedGraph);
+    this->ConnectSegmentsWithNodes(sharedGraph);
+    for (size_t i = 0; i < sharedGraph.Segments.size(); ++i)
+    {
+      if (!sharedGraph.Segments[i].Merged)
+      {
+        connectedSegments.push_back(static_cast<int>(i));
+      }
+    }
+  }
 
-  int number_of_blocks = outputMultiBlock->GetNumberOfBlocks();
-  controller->Broadcast(&number_of_blocks, 1, 0);
+  // The blocks of a process follow those of the previous processes, and the
+  // segments connected on the first process come last. The structure matches
+  // on all processes, each block being set on a single process.
+  const int numProcs = controller->GetNumberOfProcesses();
+  const int myId = controller->GetLocalProcessId();
+  const int counts[2] = { static_cast<int>(segments.size()),
+    static_cast<int>(connectedSegments.size()) };
+  std::vector<int> allCounts(2 * numProcs);
+  controller->AllGather(counts, allCounts.data(), 2);
+  unsigned int firstBlock = 0;
+  unsigned int numberOfBlocks = 0;
+  for (int i = 0; i < numProcs; ++i)
+  {
+    firstBlock += i < myId ? allCounts[2 * i] : 0;
+    numberOfBlocks += allCounts[2 * i] + allCounts[2 * i + 1];
+  }
+  outputMultiBlock->SetNumberOfBlocks(numberOfBlocks);
+  this->SaveToMultiBlockDataSet(graph, segments, outputMultiBlock, firstBlock);
+  this->SaveToMultiBlockDataSet(
+    sharedGraph, connectedSegments, outputMultiBlock, numberOfBlocks - allCounts[1]);
 }
 
 void vtkPlotEdges::ReducePolyData(vtkPolyData* polyData, vtkPolyData* output)
@@ -661,10 +745,93 @@ void vtkPlotEdges::ReducePolyData(vtkPolyData* polyData, vtkPolyData* output)
   md->Update();
 
   output->ShallowCopy(vtkPolyData::SafeDownCast(md->GetOutputDataObject(0)));
+}
 
-  // vtkPlotEdges cannot handle ghost-cells at all. Remove all ghost cells
-  // BUG #12422.
-  output->RemoveGhostCells();
+void vtkPlotEdges::FindSharedPoints(vtkMultiProcessController* controller, Graph& graph)
+{
+  vtkPolyData* polyData = graph.PolyData;
+  const vtkIdType numPts = polyData->GetNumberOfPoints();
+
+  std::map<std::array<double, 3>, vtkIdType> pointIds;
+  double bounds[6] = { VTK_DOUBLE_MAX, -VTK_DOUBLE_MAX, VTK_DOUBLE_MAX, -VTK_DOUBLE_MAX,
+    VTK_DOUBLE_MAX, -VTK_DOUBLE_MAX };
+  for (vtkIdType pointId = 0; pointId < numPts; ++pointId)
+  {
+    vtkIdType numPtCells;
+    vtkIdType* cellIds;
+    polyData->GetPointCells(pointId, numPtCells, cellIds);
+    if (numPtCells == 0)
+    {
+      continue;
+    }
+    std::array<double, 3> point;
+    polyData->GetPoint(pointId, point.data());
+    pointIds.insert(std::make_pair(point, pointId));
+    for (int c = 0; c < 3; ++c)
+    {
+      bounds[2 * c] = std::min(bounds[2 * c], point[c]);
+      bounds[2 * c + 1] = std::max(bounds[2 * c + 1], point[c]);
+    }
+  }
+  const int numProcs = controller->GetNumberOfProcesses();
+  const int myId = controller->GetLocalProcessId();
+  std::vector<double> allBounds(6 * numProcs);
+  controller->AllGather(bounds, allBounds.data(), 6);
+
+  // A point can only be shared with the processes whose bounds contain it,
+  // so two processes only exchange the points in each other's bounds, and
+  // only when their bounds overlap, which both of them know. Each process
+  // visits the others in order, the lower one of a pair sending first, so
+  // the exchanges cannot wait on each other.
+  graph.SharedPoints.assign(numPts, 0);
+  for (int proc = 0; proc < numProcs; ++proc)
+  {
+    const double* procBounds = &allBounds[6 * proc];
+    bool overlap = proc != myId;
+    for (int c = 0; c < 3 && overlap; ++c)
+    {
+      overlap = bounds[2 * c] <= procBounds[2 * c + 1] && procBounds[2 * c] <= bounds[2 * c + 1];
+    }
+    if (!overlap)
+    {
+      continue;
+    }
+
+    vtkSmartPointer<vtkDoubleArray> sent = vtkSmartPointer<vtkDoubleArray>::New();
+    for (const auto& pointId : pointIds)
+    {
+      const std::array<double, 3>& point = pointId.first;
+      if (procBounds[0] <= point[0] && point[0] <= procBounds[1] && procBounds[2] <= point[1] &&
+        point[1] <= procBounds[3] && procBounds[4] <= point[2] && point[2] <= procBounds[5])
+      {
+        sent->InsertNextValue(point[0]);
+        sent->InsertNextValue(point[1]);
+        sent->InsertNextValue(point[2]);
+      }
+    }
+    vtkSmartPointer<vtkDoubleArray> received = vtkSmartPointer<vtkDoubleArray>::New();
+    if (myId < proc)
+    {
+      controller->Send(sent, proc, SHARED_POINTS_TAG);
+      controller->Receive(received, proc, SHARED_POINTS_TAG);
+    }
+    else
+    {
+      controller->Receive(received, proc, SHARED_POINTS_TAG);
+      controller->Send(sent, proc, SHARED_POINTS_TAG);
+    }
+
+    // The points of the other process that this one has too are shared.
+    for (vtkIdType i = 0, max = received->GetNumberOfValues() / 3; i < max; ++i)
+    {
+      const double* value = received->GetPointer(3 * i);
+      auto iter = pointIds.find({ { value[0], value[1], value[2] } });
+      if (iter != pointIds.end())
+      {
+        graph.SharedPoints[iter->second] = 1;
+      }
+    }
+  }
 }
 
 void vtkPlotEdges::PrintSelf(ostream& os, vtkIndent indent)
@@ -672,28 +839,15 @@ void vtkPlotEdges::PrintSelf(ostream& os, vtkIndent indent)
   this->Superclass::PrintSelf(os, indent);
 }
 
-void vtkPlotEdges::ExtractSegments(
-  vtkPolyData* input, vtkCollection* segments, vtkCollection* nodes)
+void vtkPlotEdges::ExtractSegments(Graph& graph)
 {
-  vtkSmartPointer<vtkCleanPolyData> cleanPolyData = vtkSmartPointer<vtkCleanPolyData>::New();
-  cleanPolyData->SetInputData(input);
-  // set the tolerance at 0 to use vtkMergePoints (faster)
-  cleanPolyData->SetTolerance(0.0);
-  cleanPolyData->Update();
-
-  vtkPolyData* polyData = cleanPolyData->GetOutput();
-  polyData->BuildLinks();
-
-  //   cerr << "Input PolyData nb points:"
-  //             << polyData->GetNumberOfPoints() << " nb cells:"
-  //             << polyData->GetNumberOfCells() << endl;
+  vtkPolyData* polyData = graph.PolyData;
 
   int abort = 0;
   vtkIdType numCells = polyData->GetNumberOfCells();
   vtkIdType progressInterval = numCells / 20 + 1;
 
-  char* visitedCells = new char[numCells];
-  memset(visitedCells, 0, numCells * sizeof(char));
+  std::vector<char> visitedCells(numCells, 0);
 
   for (vtkIdType cellId = 0; cellId < numCells && !abort; cellId++)
   {
@@ -734,47 +888,33 @@ void vtkPlotEdges::ExtractSegments(
 
     // As the point may be in many cells, we need to create a node.
     // The nodes will be merged later in ConnectSegmentsWithNodes
-    Node* node = NULL;
-    if (numPtCells > 1)
+    int node = -1;
+    if (numPtCells > 1 || graph.IsShared(cellPts[0]))
     {
-      node = Node::New();
-      node->SetPolyData(polyData);
-      node->SetPointId(cellPts[0]);
-      nodes->AddItem(node);
-      node->Delete();
+      node = graph.AddNode(cellPts[0]);
     }
 
     // Track the branchs from the point. The cell defines a direction
     for (vtkIdType i = 0; i < numPtCells; ++i)
     {
-      this->ExtractSegmentsFromExtremity(
-        polyData, segments, nodes, visitedCells, cellIds[i], cellPts[0], node);
+      this->ExtractSegmentsFromExtremity(graph, visitedCells.data(), cellIds[i], cellPts[0], node);
     }
   }
-  // we don't need the visited array array
-  delete[] visitedCells;
-  visitedCells = NULL;
 }
 
-void vtkPlotEdges::ExtractSegmentsFromExtremity(vtkPolyData* polyData, vtkCollection* segments,
-  vtkCollection* nodes, char* visitedCells, vtkIdType cellId, vtkIdType pointId, Node* node)
+void vtkPlotEdges::ExtractSegmentsFromExtremity(
+  Graph& graph, char* visitedCells, vtkIdType cellId, vtkIdType pointId, int node)
 {
-  // cerr<< __FUNCTION__ << " cell: " << cellId << " point: " << node->GetPointId() << endl;
+  vtkPolyData* polyData = graph.PolyData;
   if (visitedCells[cellId])
   {
-    // cerr << "Cell already visited: " << cellId << endl;
-    // cerr << "End" << __FUNCTION__ << endl;
     return;
   }
   if (polyData->GetCellType(cellId) != VTK_LINE && polyData->GetCellType(cellId) != VTK_POLY_LINE)
   {
-    // cerr << "!!!!!!!!!Cell not a line: " << cellId << endl;
-    // cerr << "End" << __FUNCTION__ << endl;
     return;
   }
 
-  // vtkIdType pointId = node->GetPointId();
-
   // Get all the points from the cell
   vtkIdType numCellPts;
   const vtkIdType* cellPts;
@@ -784,33 +924,24 @@ void vtkPlotEdges::ExtractSegmentsFromExtremity(vtkPolyData* polyData, vtkCollec
   if (numCellPts != 2)
   {
     cerr << "!!!!!!!The cell " << cellId << " has " << numCellPts << " points" << endl;
-    // cerr << "End" << __FUNCTION__ << endl;
     return;
   }
 
   // Get the next point
   vtkIdType pointId2 = (cellPts[0] == pointId) ? cellPts[1] : cellPts[0];
 
-  double p[3];
-  polyData->GetPoint(pointId2, p);
-
-  // Create a new segment from the point.
-  Segment* segment = Segment::New();
-  segment->SetPolyData(polyData);
-  segment->AddPoint(cellId, pointId);
-  segment->AddPoint(cellId, pointId2);
+  // Create a new segment from the point. Segments are referred to by index,
+  // as creating segments in the recursion below moves them.
+  const int segment = graph.AddSegment();
+  graph.Segments[segment].AddPoint(pointId);
+  graph.Segments[segment].AddPoint(pointId2);
 
   // if the pointId is at a node, add the segment to it
-  // maybe node shall not be given as a parameter but
-  // get using vtkPlotEdges::GetNodeAtPoint()
-  if (node)
+  if (node != -1)
   {
-    node->AddSegment(segment);
+    graph.Nodes[node].AddSegment(segment);
   }
 
-  segments->AddItem(segment);
-  segment->Delete();
-
   visitedCells[cellId] = 1;
 
   // Get all the cells associated with the point2
@@ -820,32 +951,24 @@ void vtkPlotEdges::ExtractSegmentsFromExtremity(vtkPolyData* polyData, vtkCollec
   polyData->GetPointCells(pointId2, numPtCells, cellIds);
   while (numPtCells != 1) // 1 is the end of a segment
   {
-    if (numPtCells > 2)
+    // segments are also cut where they leave the lines of this process.
+    if (numPtCells > 2 || graph.IsShared(pointId2))
     {
-      // cerr << "At point " << pointId2 << " found a node of "
-      //          << numPtCells << " cells " << endl;
       // we are at a tree branch node
-      Node* node2 = vtkPlotEdges::GetNodeAtPoint(nodes, pointId2);
-      if (!node2)
+      int node2 = graph.GetNodeAtPoint(pointId2);
+      if (node2 == -1)
       {
-        node2 = Node::New();
-        node2->SetPolyData(polyData);
-        node2->SetPointId(pointId2);
-        nodes->AddItem(node2);
-        node2->Delete();
+        node2 = graph.AddNode(pointId2);
       }
-      node2->AddSegment(segment);
+      graph.Nodes[node2].AddSegment(segment);
 
       for (vtkIdType i = 0; i < numPtCells; ++i)
       {
-        // cerr << "At point " << pointId2
-        //          << ", get the node branch of cell "
-        //          << cellIds[i] << endl;
         if (!visitedCells[cellIds[i]] && (polyData->GetCellType(cellIds[i]) == VTK_LINE ||
                                            polyData->GetCellType(cellIds[i]) == VTK_POLY_LINE))
         {
           vtkPlotEdges::ExtractSegmentsFromExtremity(
-            polyData, segments, nodes, visitedCells, cellIds[i], pointId2, node2);
+            graph, visitedCells, cellIds[i], pointId2, node2);
         }
       }
       // we were at the extremity of a branch, like if numptCells == 1
@@ -855,7 +978,6 @@ void vtkPlotEdges::ExtractSegmentsFromExtremity(vtkPolyData* polyData, vtkCollec
     {
       // get the next cell
       vtkIdType cellId2 = (cellIds[0] == cellId) ? cellIds[1] : cellIds[0];
-      // cerr<< "Next Cell is " << cellId2 << endl;
       if (visitedCells[cellId2])
       {
         break;
@@ -880,10 +1002,9 @@ void vtkPlotEdges::ExtractSegmentsFromExtremity(vtkPolyData* polyData, vtkCollec
       }
       // get the next point
       vtkIdType pointId3 = (cell2Pts[0] == pointId2) ? cell2Pts[1] : cell2Pts[0];
-      segment->AddPoint(cellId2, pointId3);
+      graph.Segments[segment].AddPoint(pointId3);
 
       // go one step forward
-      // cerr<< "Next Point is " << pointId3 << endl;
       visitedCells[cellId2] = 1;
       cellId = cellId2;
       pointId2 = pointId3;
@@ -891,180 +1012,149 @@ void vtkPlotEdges::ExtractSegmentsFromExtremity(vtkPolyData* polyData, vtkCollec
       polyData->GetPointCells(pointId2, numPtCells, cellIds);
     }
   }
-  // cerr << "End" << __FUNCTION__ << endl;
 }
 
-void vtkPlotEdges::ConnectSegmentsWithNodes(vtkCollection* segments, vtkCollection* nodes)
+void vtkPlotEdges::ConnectSegmentsWithNodes(Graph& graph)
 {
-  Node* node = NULL;
-  // cerr << __FUNCTION__ << ": " << nodes->GetNumberOfItems()
-  //          << " nodes." << endl;
-  vtkCollectionIterator* nodeIt = nodes->NewIterator();
+  // The segments at a shared point are connected once all of them are known,
+  // on the first process.
+
   // do a first pass with straightforward nodes(2 branches)
-  nodeIt->GoToFirstItem();
-  while (!nodeIt->IsDoneWithTraversal())
+  for (size_t i = 0; i < graph.Nodes.size(); ++i)
   {
-    node = Node::SafeDownCast(nodeIt->GetCurrentObject());
-    if (node->GetSegments()->GetNumberOfItems() == 2)
-    {
-      Segment* segmentA = Segment::SafeDownCast(node->GetSegments()->GetItemAsObject(0));
-      Segment* segmentB = Segment::SafeDownCast(node->GetSegments()->GetItemAsObject(1));
-      // double point[3];
-      // node->GetPolyData()->GetPoint(node->GetPointId(), point);
-      // cerr << "Node at point " << node->GetPointId()
-      //          << "(" << point[0] << "," << point[1] << "," << point[2]
-      //          << ") has only 2 segments:(" << segmentA
-      //          << ") and(" << segmentB << endl;
-      vtkPlotEdges::MergeSegments(segments, nodes, node, segmentA, segmentB);
-      nodeIt->GoToNextItem();
-      nodes->RemoveItem(node);
-    }
-    else
+    Node& node = graph.Nodes[i];
+    if (!graph.IsShared(node.PointId) && node.GetNumberOfSegments() == 2)
     {
-      nodeIt->GoToNextItem();
+      int segments[2];
+      std::remove_copy(node.Segments.begin(), node.Segments.end(), segments, -1);
+      vtkPlotEdges::MergeSegments(graph, static_cast<int>(i), segments[0], segments[1]);
+      node.Processed = true;
     }
   }
 
   // do a second pass with the other nodes
-  nodeIt->GoToFirstItem();
-  while (!nodeIt->IsDoneWithTraversal())
+  for (size_t i = 0; i < graph.Nodes.size(); ++i)
   {
-    node = Node::SafeDownCast(nodeIt->GetCurrentObject());
-    double point[3];
-    node->GetPolyData()->GetPoint(node->GetPointId(), point);
-    // cerr << "Connect node(" << node
-    //        << ") at point: " << node->GetPointId()
-    //        << "(" << point[0] << ","
-    //        << point[1] << "," << point[2] << ")" <<endl;
-
-    while (node->GetSegments()->GetNumberOfItems() > 1)
+    Node& node = graph.Nodes[i];
+    if (!node.Processed && !graph.IsShared(node.PointId))
     {
-      // cerr << node->GetSegments()->GetNumberOfItems()
-      //           << " segments" << endl;
+      vtkPlotEdges::ConnectBestSegments(graph, static_cast<int>(i));
+      node.Processed = true;
+    }
+  }
+}
 
-      vtkCollectionIterator* it = node->GetSegments()->NewIterator();
-      vtkCollectionIterator* it2 = node->GetSegments()->NewIterator();
+void vtkPlotEdges::ConnectBestSegments(Graph& graph, int node)
+{
+  // The scores of the pairs of segments only change when a segment is
+  // inserted, so they are kept in a priority queue, and the pairs of the
+  // segments that changed are discarded when they come out of it.
+  std::priority_queue<vtkSegmentPair> pairs;
+  auto push = [&graph, &pairs, node](size_t slotA, size_t slotB) {
+    const Node& n = graph.Nodes[node];
+    const Segment& segmentA = graph.Segments[n.Segments[slotA]];
+    const Segment& segmentB = graph.Segments[n.Segments[slotB]];
+    const double score = n.ComputeConnectionScore(segmentA, segmentB);
+    // a NaN score is never the best one.
+    if (score == score)
+    {
+      pairs.push(vtkSegmentPair{ score, slotA, slotB, n.Segments[slotA], n.Segments[slotB],
+        segmentA.Version, segmentB.Version });
+    }
+  };
 
-      Segment* segmentI = NULL;
-      Segment* segmentJ = NULL;
-      Segment* segmentA = NULL;
-      Segment* segmentB = NULL;
+  const std::vector<int>& slots = graph.Nodes[node].Segments;
+  for (size_t i = 0; i < slots.size(); ++i)
+  {
+    for (size_t j = 0; j < slots.size() && slots[i] != -1; ++j)
+    {
+      if (slots[j] != -1)
+      {
+        push(i, j);
+      }
+    }
+  }
 
-      double old_score = -2.;
-      double score = 0;
+  while (graph.Nodes[node].GetNumberOfSegments() > 1 && !pairs.empty())
+  {
+    const vtkSegmentPair best = pairs.top();
+    pairs.pop();
+    if (slots[best.SlotA] != best.SegmentA || slots[best.SlotB] != best.SegmentB ||
+      graph.Segments[best.SegmentA].Version != best.VersionA ||
+      graph.Segments[best.SegmentB].Version != best.VersionB)
+    {
+      continue;
+    }
+    vtkPlotEdges::MergeSegments(graph, node, best.SegmentA, best.SegmentB);
 
-      for (it->GoToFirstItem(); (segmentI = Segment::SafeDownCast(it->GetCurrentObject()));
-           it->GoToNextItem())
+    // the merged segment may still end at the node.
+    for (size_t i = 0; i < slots.size() && best.SegmentA != best.SegmentB; ++i)
+    {
+      if (slots[i] != best.SegmentA)
       {
-        for (it2->GoToFirstItem(); (segmentJ = Segment::SafeDownCast(it2->GetCurrentObject()));
-             it2->GoToNextItem())
+        continue;
+      }
+      for (size_t j = 0; j < slots.size(); ++j)
+      {
+        if (slots[j] != -1)
         {
-          score = node->ComputeConnectionScore(segmentI, segmentJ);
-
-          if (score > old_score)
+          push(i, j);
+          if (j != i)
           {
-            segmentA = segmentI;
-            segmentB = segmentJ;
-            old_score = score;
-
-            // cerr << "Score of " << score
-            //          << " between segmentI:"<< endl;
-            // segmentI->Print(cerr);
-            // cerr << "and segmentJ:" << endl;
-            // segmentJ->Print(cerr);
+            push(j, i);
           }
         }
       }
-      vtkPlotEdges::MergeSegments(segments, nodes, node, segmentA, segmentB);
-
-      it->Delete();
-      it2->Delete();
     }
-
-    nodes->RemoveItem(node);
-    nodeIt->GoToFirstItem();
   }
-  nodeIt->Delete();
 }
 
-void vtkPlotEdges::MergeSegments(
-  vtkCollection* segments, vtkCollection* nodes, Node* node, Segment* segmentA, Segment* segmentB)
+void vtkPlotEdges::MergeSegments(Graph& graph, int node, int segmentA, int segmentB)
 {
+  Node& n = graph.Nodes[node];
   if (segmentA == segmentB)
   {
-    node->GetSegments()->RemoveItem(segmentA);
-    node->GetSegments()->RemoveItem(segmentB);
+    n.RemoveSegment(segmentA);
+    n.RemoveSegment(segmentB);
     return;
   }
 
-  // cerr << "Merge segment(" << segmentA << ") "
-  //             << segmentA->GetStartId() << "-("
-  //             << segmentA->GetCountPointIds() << ")-"
-  //             << segmentA->GetEndId()
-  //             << " with segment(" << segmentB << ") "
-  //             << segmentB->GetStartId() << "-("
-  //             << segmentB->GetCountPointIds() << ")-"
-  //             << segmentB->GetEndId() << endl;
-  //   double point[3];
-  //   cerr << "Score" << node->ComputeConnectionScore(segmentA, segmentB)
-  //             << " Direction 1:" << segmentA->GetDirection(node->GetPointId(),point)[0]
-  //             << "," << segmentA->GetDirection(node->GetPointId(),point)[1]
-  //             << "," << segmentA->GetDirection(node->GetPointId(),point)[2]
-  //             << endl
-  //             << " Direction 2:" << segmentB->GetDirection(node->GetPointId(),point)[0]
-  //             << "," << segmentB->GetDirection(node->GetPointId(),point)[1]
-  //             << "," << segmentB->GetDirection(node->GetPointId(),point)[2]
-  //             << endl;
-
-  segmentA->InsertSegment(node->GetPointId(), segmentB);
-  node->GetSegments()->RemoveItem(segmentA);
-  node->GetSegments()->RemoveItem(segmentB);
-
-  // replace segmentB by segmentA in other nodes
-  vtkCollectionIterator* nodeIt = nodes->NewIterator();
-  for (nodeIt->GoToFirstItem(); !nodeIt->IsDoneWithTraversal(); nodeIt->GoToNextItem())
-  {
-    Node* node2 = Node::SafeDownCast(nodeIt->GetCurrentObject());
-    int segmentBPos = node2->GetSegments()->IsItemPresent(segmentB);
-    if (segmentBPos)
-    {
-      node2->GetSegments()->ReplaceItem(segmentBPos - 1, segmentA);
-    }
-  }
-  nodeIt->Delete();
-  segments->RemoveItem(segmentB);
-}
+  Segment& a = graph.Segments[segmentA];
+  Segment& b = graph.Segments[segmentB];
+  const vtkIdType extremities[2] = { b.GetStartId(), b.GetEndId() };
+  a.InsertSegment(n.PointId, b);
+  n.RemoveSegment(segmentA);
+  n.RemoveSegment(segmentB);
 
-vtkPlotEdges::Node* vtkPlotEdges::GetNodeAtPoint(vtkCollection* nodes, vtkIdType pointId)
-{
-  vtkCollectionIterator* it = nodes->NewIterator();
-  Node* res = NULL;
-  for (it->GoToFirstItem(); !it->IsDoneWithTraversal(); it->GoToNextItem())
+  // replace segmentB by segmentA in the nodes at its extremities, the only
+  // ones it can still be in.
+  for (vtkIdType pointId : extremities)
   {
-    Node* node = Node::SafeDownCast(it->GetCurrentObject());
-    if (node->GetPointId() == pointId)
+    for (int node2 = graph.GetNodeAtPoint(pointId); node2 != -1; node2 = graph.Nodes[node2].Next)
     {
-      res = node;
-      break;
+      if (!graph.Nodes[node2].Processed)
+      {
+        graph.Nodes[node2].ReplaceSegment(segmentB, segmentA);
+      }
     }
   }
-  it->Delete();
-  return res;
+  b.Merged = true;
+  std::vector<vtkIdType>().swap(b.PointIds);
+  std::vector<double>().swap(b.ArcLengths);
 }
 
-void vtkPlotEdges::SaveToMultiBlockDataSet(vtkCollection* segments, vtkMultiBlockDataSet* output)
+void vtkPlotEdges::SaveToMultiBlockDataSet(const Graph& graph, const std::vector<int>& segments,
+  vtkMultiBlockDataSet* output, unsigned int firstBlock)
 {
   // copy into dataset
   //
-  segments->InitTraversal();
-  Segment* segment = NULL;
-  for (segment = Segment::SafeDownCast(segments->GetNextItemAsObject()); segment;
-       segment = Segment::SafeDownCast(segments->GetNextItemAsObject()))
+  vtkPolyData* polyData = graph.PolyData;
+  for (size_t s = 0; s < segments.size(); ++s)
   {
-    vtkPolyData* polyData = const_cast<vtkPolyData*>(segment->GetPolyData());
+    const Segment& segment = graph.Segments[segments[s]];
 
     vtkSmartPointer<vtkPolyData> pd = vtkSmartPointer<vtkPolyData>::New();
-    output->SetBlock(output->GetNumberOfBlocks(), pd);
+    output->SetBlock(firstBlock + static_cast<unsigned int>(s), pd);
 
     vtkSmartPointer<vtkCellArray> ca = vtkSmartPointer<vtkCellArray>::New();
 
@@ -1091,15 +1181,16 @@ void vtkPlotEdges::SaveToMultiBlockDataSet(vtkCollection* segments, vtkMultiBloc
     }
 
     vtkIdType pointId;
-    vtkIdType numCells = segment->GetPointIdList()->GetNumberOfIds();
+    vtkIdType numCells = segment.GetCountPointIds();
     for (vtkIdType i = 0; i < numCells; ++i)
     {
       cells->InsertNextId(i);
-      pointId = segment->GetPointIdList()->GetId(i);
+      pointId = segment.PointIds[i];
       pts->InsertPoint(i, polyData->GetPoint(pointId));
       for (int j = 0; j < numArray; j++)
       {
-        pd->GetPointData()->GetArray(j)->InsertNextTuple(pointId, srcPointData->GetArray(j));
+        pd->GetPointData()->GetAbstractArray(j)->InsertNextTuple(
+          pointId, srcPointData->GetAbstractArray(j));
       }
     }
 
@@ -1107,39 +1198,57 @@ void vtkPlotEdges::SaveToMultiBlockDataSet(vtkCollection* segments, vtkMultiBloc
     pd->SetPoints(pts);
     pd->InsertNextCell(VTK_POLY_LINE, cells);
 
-    vtkDataArray* arcLength = segment->GetArcLengths();
+    vtkSmartPointer<vtkDoubleArray> arcLength = vtkSmartPointer<vtkDoubleArray>::New();
+    arcLength->SetName("arc_length");
+    arcLength->SetNumberOfValues(numCells);
+    std::copy(segment.ArcLengths.begin(), segment.ArcLengths.end(), arcLength->GetPointer(0));
     if (pd->GetPointData()->HasArray("arc_length"))
     {
       arcLength->SetName("PlotEdges arc_length");
     }
     pd->GetPointData()->AddArray(arcLength);
+  }
+}
 
-    /*
-      cerr << "Add PolyLine of " <<
-      segment->GetPointIdList()->GetNumberOfIds() << " points" << endl;
-      for (vtkIdType i=0; i < segment->GetPointIdList()->GetNumberOfIds(); ++i)
-      {
-      cerr << segment->GetPointIdList()->GetId(i) << " " ;
-      }
-      cerr << endl;
-
-      cerr << "ArcLengths " <<
-      segment->GetArcLengths()->GetMaxId() << " points" << endl;
-      for (vtkIdType i=0; i < segment->GetArcLengths()->GetMaxId(); ++i)
+void vtkPlotEdges::SaveToPolyData(
+  const Graph& graph, const std::vector<int>& segments, vtkPolyData* output)
+{
+  // the segments as lines, to be extracted again once gathered.
+  vtkPolyData* polyData = graph.PolyData;
+  if (!polyData->GetPoints())
+  {
+    return;
+  }
+  vtkSmartPointer<vtkPoints> pts = vtkSmartPointer<vtkPoints>::New();
+  pts->SetDataType(polyData->GetPoints()->GetDataType());
+  vtkSmartPointer<vtkCellArray> lines = vtkSmartPointer<vtkCellArray>::New();
+  vtkPointData* outPointData = output->GetPointData();
+  outPointData->CopyAllocate(polyData->GetPointData());
+  for (int s : segments)
+  {
+    const Segment& segment = graph.Segments[s];
+    for (vtkIdType i = 0; i < segment.GetCountPointIds(); ++i)
+    {
+      const vtkIdType pointId = pts->InsertNextPoint(polyData->GetPoint(segment.PointIds[i]));
+      outPointData->CopyData(polyData->GetPointData(), segment.PointIds[i], pointId);
+      if (i > 0)
       {
-      cerr << segment->GetArcLengths()->GetValue(i) << " " ;
+        const vtkIdType line[2] = { pointId - 1, pointId };
+        lines->InsertNextCell(2, line);
       }
-      cerr << endl;
-    */
+    }
   }
+  output->SetPoints(pts);
+  output->SetLines(lines);
 }
 
-void vtkPlotEdges::PrintSegments(vtkCollection* segments)
+void vtkPlotEdges::PrintSegments(const Graph& graph)
 {
-  vtkSmartPointer<vtkCollectionIterator> it = segments->NewIterator();
-  for (it->GoToFirstItem(); !it->IsDoneWithTraversal(); it->GoToNextItem())
+  for (const Segment& segment : graph.Segments)
   {
-    Segment* segment = Segment::SafeDownCast(it->GetCurrentObject());
-    segment->Print(cerr);
+    if (!segment.Merged)
+    {
+      segment.PrintSelf(cerr, vtkIndent());
+    }
   }
 }
@@ -14,7 +14,19 @@
 =========================================================================*/
 /**
  * @class   vtkPlotEdges
+ * @brief   joins the line cells of a polydata into one polyline per curve.
  *
+ * vtkPlotEdges chains the VTK_LINE cells of its input into segments between
+ * the points where lines branch. At each branch point, the segments are
+ * joined two by two, best connection first, and each resulting curve is
+ * output as a polyline block with an "arc_length" point array.
+ *
+ * In parallel, each process chains its own lines. The processes exchange only
+ * the coordinates of their segment extremities, and of the points inside
+ * their segments that are in the bounds of the lines of another process, to
+ * find the points they share. Only the curves that end on a shared point are
+ * sent to the first process, which joins them there. The other curves stay on
+ * the process that owns them.
 */
 
 #ifndef vtkPlotEdges_h
@@ -23,10 +35,10 @@
 #include "vtkMultiBlockDataSetAlgorithm.h"
 #include "vtkPVVTKExtensionsFiltersGeneralModule.h" //needed for exports
 
-class Node;
-class Segment;
+#include <vector> // for std::vector
+
+class vtkMultiProcessController;
 class vtkPolyData;
-class vtkCollection;
 class vtkMultiBlockDataSet;
 
 class VTKPVVTKEXTENSIONSFILTERSGENERAL_EXPORT vtkPlotEdges : public vtkMultiBlockDataSetAlgorithm
@@ -43,6 +55,7 @@ protected:
 
   class Node;
   class Segment;
+  class Graph;
 
   int FillInputPortInformation(int port, vtkInformation* info) override;
   // Usual data generation method
@@ -50,16 +63,19 @@ protected:
 
   void Process(vtkPolyData* input, vtkMultiBlockDataSet* output);
   static void ReducePolyData(vtkPolyData* polyData, vtkPolyData* output);
-
-  void ExtractSegments(vtkPolyData* polyData, vtkCollection* segments, vtkCollection* nodes);
-  static void ExtractSegmentsFromExtremity(vtkPolyData* polyData, vtkCollection* segments,
-    vtkCollection* nodes, char* visitedCells, vtkIdType cellId, vtkIdType pointId, Node* node);
-  static void ConnectSegmentsWithNodes(vtkCollection* segments, vtkCollection* nodes);
-  static void SaveToMultiBlockDataSet(vtkCollection* segments, vtkMultiBlockDataSet* output);
-  static void MergeSegments(vtkCollection* segments, vtkCollection* nodes, Node* node,
-    Segment* segmentA, Segment* segmentB);
-  static vtkPlotEdges::Node* GetNodeAtPoint(vtkCollection* nodes, vtkIdType pointId);
-  static void PrintSegments(vtkCollection* segments);
+  static void FindSharedPoints(vtkMultiProcessController* controller, Graph& graph);
+
+  void ExtractSegments(Graph& graph);
+  static void ExtractSegmentsFromExtremity(
+    Graph& graph, char* visitedCells, vtkIdType cellId, vtkIdType pointId, int node);
+  static void ConnectSegmentsWithNodes(Graph& graph);
+  static void ConnectBestSegments(Graph& graph, int node);
+  static void SaveToMultiBlockDataSet(const Graph& graph, const std::vector<int>& segments,
+    vtkMultiBlockDataSet* output, unsigned int firstBlock);
+  static void SaveToPolyData(const Graph& graph, const std::vector<int>& segments,
+    vtkPolyData* output);
+  static void MergeSegments(Graph& graph, int node, int segmentA, int segmentB);
+  static void PrintSegments(const Graph& graph);
 
 private:
   vtkPlotEdges(const vtkPlotEdges&) = delete;
@@ -0,0 +1,249 @@
+/*=========================================================================
+
+  Program:   ParaView
+  Module:    TestMaterialInterfaceFilterScaling.cxx
+
+  Copyright (c) Kitware, Inc.
+  All rights reserved.
+  See Copyright.txt or http://www.paraview.org/HTML/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// Runs vtkMaterialInterfaceFilter on a synthetic AMR volume fraction whose
+// size grows with the number of ranks (weak scaling). The data has a rod
+// that crosses every rank, fragments split between pairs of ranks, and
+// fragments contained in a single block, so that the fragment count, the
+// volumes and the reduced attributes are known exactly.
+#include "vtkCellData.h"
+#include "vtkDataArray.h"
+#include "vtkDoubleArray.h"
+#include "vtkFieldData.h"
+#include "vtkMPIController.h"
+#include "vtkMaterialInterfaceFilter.h"
+#include "vtkMultiBlockDataSet.h"
+#include "vtkMultiPieceDataSet.h"
+#include "vtkNew.h"
+#include "vtkNonOverlappingAMR.h"
+#include "vtkPointData.h"
+#include "vtkPolyData.h"
+#include "vtkUniformGrid.h"
+#include "vtkUnsignedCharArray.h"
+
+#include <cmath>
+#include <cstdlib>
+
+namespace
+{
+const int BlockSize = 8;
+const int BlocksY = 3;
+const int BlocksZ = 3;
+
+// Global cell (x, y, z) is inside the material. The domain has blocksX x 3 x 3
+// blocks of 8^3 cells.
+bool IsInside(int x, int y, int z, int blocksX)
+{
+  const int bx = x / BlockSize, lx = x % BlockSize;
+  const int ly = y % BlockSize, lz = z % BlockSize;
+  // a rod along x, crossing block boundaries in y and z.
+  if (y >= 6 && y <= 9 && z >= 6 && z <= 9)
+  {
+    return true;
+  }
+  // a cube in every block.
+  if (lx >= 3 && lx <= 4 && ly >= 3 && ly <= 4 && lz >= 3 && lz <= 4)
+  {
+    return true;
+  }
+  // a box across the boundary of each pair of blocks along x.
+  if (y >= 22 && y <= 23 && z >= 22 && z <= 23 && bx + 1 < blocksX)
+  {
+    return (bx % 2 == 0 && lx >= 6) || (bx % 2 == 1 && lx <= 1);
+  }
+  return false;
+}
+
+vtkUniformGrid* NewBlock(int bx, int by, int bz, int blocksX)
+{
+  vtkUniformGrid* grid = vtkUniformGrid::New();
+  grid->SetOrigin(bx * BlockSize, by * BlockSize, bz * BlockSize);
+  grid->SetSpacing(1.0, 1.0, 1.0);
+  grid->SetDimensions(BlockSize + 1, BlockSize + 1, BlockSize + 1);
+
+  const int numCells = BlockSize * BlockSize * BlockSize;
+  vtkNew<vtkUnsignedCharArray> fraction;
+  fraction->SetName("Material");
+  fraction->SetNumberOfTuples(numCells);
+  vtkNew<vtkDoubleArray> ones;
+  ones->SetName("Ones");
+  ones->SetNumberOfTuples(numCells);
+  ones->FillComponent(0, 1.0);
+  vtkIdType cellId = 0;
+  for (int z = 0; z < BlockSize; ++z)
+  {
+    for (int y = 0; y < BlockSize; ++y)
+    {
+      for (int x = 0; x < BlockSize; ++x)
+      {
+        const bool inside = IsInside(
+          bx * BlockSize + x, by * BlockSize + y, bz * BlockSize + z, blocksX);
+        fraction->SetValue(cellId++, inside ? 255 : 0);
+      }
+    }
+  }
+  grid->GetCellData()->AddArray(fraction);
+  grid->GetCellData()->AddArray(ones);
+  return grid;
+}
+}
+
+int TestMaterialInterfaceFilterScaling(int argc, char* argv[])
+{
+  vtkMPIController* contr = vtkMPIController::New();
+  contr->Initialize(&argc, &argv);
+  vtkMultiProcessController::SetGlobalController(contr);
+
+  const int rank = contr->GetLocalProcessId();
+  const int numRanks = contr->GetNumberOfProcesses();
+  int success = 1;
+
+  // Two slabs of blocks per rank, assigned round robin along x so that
+  // neighboring slabs are always on different ranks.
+  const int blocksX = 2 * numRanks;
+  const int numBlocks = blocksX * BlocksY * BlocksZ;
+  vtkNew<vtkNonOverlappingAMR> amr;
+  amr->Initialize(1, &numBlocks);
+  int blockIdx = 0;
+  for (int bz = 0; bz < BlocksZ; ++bz)
+  {
+    for (int by = 0; by < BlocksY; ++by)
+    {
+      for (int bx = 0; bx < blocksX; ++bx, ++blockIdx)
+      {
+        if (bx % numRanks == rank)
+        {
+          vtkUniformGrid* grid = NewBlock(bx, by, bz, blocksX);
+          amr->SetDataSet(0, blockIdx, grid);
+          grid->Delete();
+        }
+      }
+    }
+  }
+
+  vtkNew<vtkMaterialInterfaceFilter> filter;
+  filter->SetInputData(amr);
+  filter->SelectMaterialArray("Material");
+  filter->SelectSummationArray("Ones");
+  filter->SelectVolumeWtdAvgArray("Ones");
+
+  filter->Update();
+
+  // rod + one cube per block + one box per pair of slabs.
+  const int expectedFragments = 1 + numBlocks + blocksX / 2;
+  const double expectedVolume = blocksX * BlockSize * 4 * 4 + numBlocks * 2 * 2 * 2 +
+    (blocksX / 2) * 4 * 2 * 2;
+
+  // Each fragment is output by a single rank.
+  auto fragments = vtkMultiPieceDataSet::SafeDownCast(
+    vtkMultiBlockDataSet::SafeDownCast(filter->GetOutputDataObject(0))->GetBlock(0));
+  if (fragments == nullptr)
+  {
+    cerr << "ERROR: rank " << rank << ": missing fragments." << endl;
+    success = 0;
+  }
+  int localFragments = 0;
+  int badIds = 0;
+  for (unsigned int piece = 0; fragments && piece < fragments->GetNumberOfPieces(); ++piece)
+  {
+    vtkPolyData* fragment = vtkPolyData::SafeDownCast(fragments->GetPiece(piece));
+    if (fragment)
+    {
+      ++localFragments;
+      vtkDataArray* id = fragment->GetFieldData()->GetArray("Id");
+      badIds += (id == nullptr || id->GetTuple1(0) != piece) ? 1 : 0;
+    }
+  }
+  int totals[2] = { localFragments, badIds };
+  int globalTotals[2];
+  contr->AllReduce(totals, globalTotals, 2, vtkCommunicator::SUM_OP);
+  if (globalTotals[0] != expectedFragments)
+  {
+    cerr << "ERROR: rank " << rank << ": expected " << expectedFragments << " fragments, got "
+         << globalTotals[0] << endl;
+    success = 0;
+  }
+  if (globalTotals[1] != 0)
+  {
+    cerr << "ERROR: rank " << rank << ": " << globalTotals[1] << " fragments have the wrong id."
+         << endl;
+    success = 0;
+  }
+
+  // Resolved attributes are reported on rank 0.
+  if (rank == 0)
+  {
+    auto centers = vtkPolyData::SafeDownCast(
+      vtkMultiBlockDataSet::SafeDownCast(filter->GetOutputDataObject(1))->GetBlock(0));
+    vtkDataArray* volumes = centers ? centers->GetPointData()->GetArray("Volume") : nullptr;
+    vtkDataArray* sums = centers ? centers->GetPointData()->GetArray("Summation-Ones") : nullptr;
+    vtkDataArray* averages =
+      centers ? centers->GetPointData()->GetArray("VolumeWeightedAverage-Ones") : nullptr;
+    if (!volumes || !sums || !averages)
+    {
+      cerr << "ERROR: rank " << rank << ": missing fragment attributes." << endl;
+      success = 0;
+    }
+    if (volumes && sums && averages)
+    {
+      if (volumes->GetNumberOfTuples() != expectedFragments)
+      {
+        cerr << "ERROR: rank " << rank << ": expected " << expectedFragments
+             << " resolved fragments, got " << volumes->GetNumberOfTuples() << endl;
+        success = 0;
+      }
+      double totalVolume = 0.0;
+      double totalSum = 0.0;
+      for (vtkIdType cc = 0; cc < volumes->GetNumberOfTuples(); ++cc)
+      {
+        totalVolume += volumes->GetTuple1(cc);
+        totalSum += sums->GetTuple1(cc);
+        if (std::abs(averages->GetTuple1(cc) - 1.0) >= 1e-6)
+        {
+          cerr << "ERROR: rank " << rank << ": wrong volume weighted average for fragment " << cc
+               << ": " << averages->GetTuple1(cc) << endl;
+          success = 0;
+        }
+      }
+      if (std::abs(totalVolume - expectedVolume) >= 1e-6 * expectedVolume)
+      {
+        cerr << "ERROR: rank " << rank << ": expected a volume of " << expectedVolume << ", got "
+             << totalVolume << endl;
+        success = 0;
+      }
+      if (std::abs(totalSum - expectedVolume) >= 1e-6 * expectedVolume)
+      {
+        cerr << "ERROR: rank " << rank << ": expected a sum of " << expectedVolume << ", got "
+             << totalSum << endl;
+        success = 0;
+      }
+      // the rod, which crosses all ranks, is the largest fragment.
+      const double rodVolume = blocksX * BlockSize * 4 * 4;
+      if (std::abs(volumes->GetRange(0)[1] - rodVolume) >= 1e-6 * rodVolume)
+      {
+        cerr << "ERROR: rank " << rank << ": expected the rod to have a volume of " << rodVolume
+             << ", got " << volumes->GetRange(0)[1] << endl;
+        success = 0;
+      }
+    }
+  }
+
+  int allSuccess = 0;
+  contr->AllReduce(&success, &allSuccess, 1, vtkCommunicator::LOGICAL_AND_OP);
+
+  vtkMultiProcessController::SetGlobalController(nullptr);
+  contr->Finalize();
+  contr->Delete();
+  return allSuccess ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -80,6 +80,9 @@ using std::vector;
 #include <string>
 using std::string;
 #include "algorithm"
+#include <functional>
+#include <map>
+#include <utility>
 // ansi c
 #include <ctime>
 #include <math.h>
@@ -267,6 +270,9 @@ public:
   // You cannot add anymore equivalences after this is called.
   int ResolveEquivalences();
 
+  // Replaces the set ids of a resolved set by map[setId].
+  void RenumberSets(const int* map);
+
   void DeepCopy(vtkMaterialInterfaceEquivalenceSet* in);
 
   // Needed for sending the set over MPI.
@@ -464,6 +470,37 @@ int vtkMaterialInterfaceEquivalenceSet::ResolveEquivalences()
   return count;
 }
 
+//----------------------------------------------------------------------------
+void vtkMaterialInterfaceEquivalenceSet::RenumberSets(const int* map)
+{
+  if (!this->Resolved)
+  {
+    vtkGenericWarningMacro("Set must be resolved before its sets are renumbered.");
+    return;
+  }
+
+  int numIds = this->EquivalenceArray->GetNumberOfTuples();
+  for (int ii = 0; ii < numIds; ++ii)
+  {
+    this->EquivalenceArray->SetValue(ii, map[this->EquivalenceArray->GetValue(ii)]);
+  }
+}
+
+//============================================================================
+// Equivalences between our fragments and fragments of other processes,
+// found by comparing ghost blocks with the blocks they were copied from.
+// They are used to resolve fragment ids across processes with a label
+// propagation between neighboring processes, so that no process has to hold
+// the equivalences of all the others.
+class vtkMaterialInterfaceGhostEquivalences
+{
+public:
+  // For each neighboring process, pairs of (local set id, global id of a
+  // fragment of the neighbor). Processes are neighbors when one of them
+  // sent a ghost block to the other, even if no equivalence was found.
+  std::map<int, vector<std::pair<int, int> > > Neighbors;
+};
+
 //============================================================================
 // Helper object to clip hexahedra with implicit half sphere.
 class vtkMaterialInterfaceFilterHalfSphere
@@ -6361,7 +6398,9 @@ void vtkMaterialInterfaceFilter::ResolveLocalFragmentGeometry()
   this->Progress += this->ProgressResolutionInc;
   this->UpdateProgress(this->Progress);
 
+#ifdef vtkMaterialInterfaceFilterDEBUG
   const int myProcId = this->Controller->GetLocalProcessId();
+#endif
 
   /// Resolve id's, create local structural information
   /// and merge split local geometry
@@ -6372,8 +6411,6 @@ void vtkMaterialInterfaceFilter::ResolveLocalFragmentGeometry()
   // its entry is 0. And local pieces of the same fragment have been
   // merged. As we go, build a list of what we own, so we won't
   // have to search for what we have.
-  const int localToGlobal = this->LocalToGlobalOffsets[myProcId];
-
   vector<int>& resolvedFragmentIds = this->ResolvedFragmentIds[this->MaterialId];
 
   vtkMultiPieceDataSet* resolvedFragments =
@@ -6385,7 +6422,7 @@ void vtkMaterialInterfaceFilter::ResolveLocalFragmentGeometry()
   for (int localId = 0; localId < nFragmentPieces; ++localId)
   {
     // find out this guy's global id within this material
-    int globalId = this->EquivalenceSet->GetEquivalentSetId(localId + localToGlobal);
+    int globalId = this->EquivalenceSet->GetEquivalentSetId(localId);
 
     // If we have a mesh that is yet unused then
     // we copy, but if not, it's a local piece that has been
@@ -7454,427 +7491,6 @@ int vtkMaterialInterfaceFilter::GatherGeometricAttributes(const int recipientPro
   return 1;
 }
 
-//----------------------------------------------------------------------------
-// Collect all of  integrated attribute arrays from all
-// other processes. Need to pass in containers that are
-// initialized with empty arrays.
-//
-// Buffers are allocated. when unpacked the attribute arrays
-// are not copied from the buffer rather they point to
-// the appropriate location in the buffer. The buffers should
-// be deleted by caller after arrays are not needed.
-//
-// return 0 on error.
-int vtkMaterialInterfaceFilter::CollectIntegratedAttributes(
-  vector<vtkMaterialInterfaceCommBuffer>& buffers, vector<vtkDoubleArray*>& volumes,
-  vector<vtkDoubleArray*>& clipDepthMaxs, vector<vtkDoubleArray*>& clipDepthMins,
-  vector<vtkDoubleArray*>& moments, vector<vector<vtkDoubleArray*> >& volumeWtdAvgs,
-  vector<vector<vtkDoubleArray*> >& massWtdAvgs, vector<vector<vtkDoubleArray*> >& sums)
-{
-  const int myProcId = this->Controller->GetLocalProcessId();
-  const int nProcs = this->Controller->GetNumberOfProcesses();
-  const int msgBase = 200000;
-
-  // size buffer's header's
-  // here we work with a single block(material)
-  vtkMaterialInterfaceCommBuffer::SizeHeader(buffers, 1);
-
-  // receive & unpack
-  for (int procId = 0; procId < nProcs; ++procId)
-  {
-    // skip mine
-    if (procId == myProcId)
-    {
-      continue;
-    }
-    int thisMsgId = msgBase;
-    // receive buffer's header
-    this->Controller->Receive(
-      buffers[procId].GetHeader(), buffers[procId].GetHeaderSize(), procId, thisMsgId);
-    ++thisMsgId;
-    // size attribute's buffer from incoming header
-    buffers[procId].SizeBuffer();
-    // receive attribute's data
-    this->Controller->Receive(
-      buffers[procId].GetBuffer(), buffers[procId].GetBufferSize(), procId, thisMsgId);
-    ++thisMsgId;
-    // unpack attribute data
-    // We will point into the comm buffer rather than copy
-    const unsigned int nToUnpack = buffers[procId].GetNumberOfTuples(0);
-    // volume
-    buffers[procId].UnPack(volumes[procId], 1, nToUnpack, false);
-    if (this->ClipWithPlane)
-    {
-      buffers[procId].UnPack(clipDepthMaxs[procId], 1, nToUnpack, false);
-      buffers[procId].UnPack(clipDepthMins[procId], 1, nToUnpack, false);
-    }
-    // moments
-    if (this->ComputeMoments)
-    {
-      buffers[procId].UnPack(moments[procId], 4, nToUnpack, false);
-    }
-    // volume weighted averages
-    for (int i = 0; i < this->NVolumeWtdAvgs; ++i)
-    {
-      const unsigned int nCompsAvg = this->FragmentVolumeWtdAvgs[i]->GetNumberOfComponents();
-      buffers[procId].UnPack(volumeWtdAvgs[procId][i], nCompsAvg, nToUnpack, false);
-    }
-    // mass weighted averages
-    for (int i = 0; i < this->NMassWtdAvgs; ++i)
-    {
-      const unsigned int nCompsAvg = this->FragmentMassWtdAvgs[i]->GetNumberOfComponents();
-      buffers[procId].UnPack(massWtdAvgs[procId][i], nCompsAvg, nToUnpack, false);
-    }
-    // sums
-    for (int i = 0; i < this->NToSum; ++i)
-    {
-      const unsigned int nCompsSum = this->FragmentSums[i]->GetNumberOfComponents();
-      buffers[procId].UnPack(sums[procId][i], nCompsSum, nToUnpack, false);
-    }
-  }
-
-  return 1;
-}
-//----------------------------------------------------------------------------
-// Replaces our own interated attributes with those received
-// from another process.
-//
-// return 0 on error.
-int vtkMaterialInterfaceFilter::ReceiveIntegratedAttributes(const int sourceProcId)
-{
-  const int msgBase = 200000;
-
-  // prepare the comm buffer to receive attribute data
-  // pertaining to a single block(material)
-  vtkMaterialInterfaceCommBuffer buffer;
-  buffer.SizeHeader(1);
-
-  int thisMsgId = msgBase;
-  // receive buffer's header
-  this->Controller->Receive(buffer.GetHeader(), buffer.GetHeaderSize(), sourceProcId, thisMsgId);
-  ++thisMsgId;
-  // size buffer via on incoming header
-  buffer.SizeBuffer();
-  // receive attribute's data
-  this->Controller->Receive(buffer.GetBuffer(), buffer.GetBufferSize(), sourceProcId, thisMsgId);
-  ++thisMsgId;
-
-  // unpack attribute data, with an explicit copy
-  // into a local array
-  const unsigned int nToUnPack = buffer.GetNumberOfTuples(0);
-  // volume
-  ReNewVtkArrayPointer(this->FragmentVolumes, this->FragmentVolumes->GetName());
-  buffer.UnPack(this->FragmentVolumes, 1, nToUnPack, true);
-  // Clip Depth
-  if (this->ClipWithPlane)
-  {
-    ReNewVtkArrayPointer(this->ClipDepthMaximums, this->ClipDepthMaximums->GetName());
-    buffer.UnPack(this->ClipDepthMaximums, 1, nToUnPack, true);
-    ReNewVtkArrayPointer(this->ClipDepthMinimums, this->ClipDepthMinimums->GetName());
-    buffer.UnPack(this->ClipDepthMinimums, 1, nToUnPack, true);
-  }
-  // moments
-  if (this->ComputeMoments)
-  {
-    ReNewVtkArrayPointer(this->FragmentMoments, this->FragmentMoments->GetName());
-    buffer.UnPack(this->FragmentMoments, 4, nToUnPack, true);
-  }
-  // volume weighted averages
-  for (int i = 0; i < this->NVolumeWtdAvgs; ++i)
-  {
-    int nCompsVWAvg = this->FragmentVolumeWtdAvgs[i]->GetNumberOfComponents();
-    ReNewVtkArrayPointer(this->FragmentVolumeWtdAvgs[i], this->FragmentVolumeWtdAvgs[i]->GetName());
-    buffer.UnPack(this->FragmentVolumeWtdAvgs[i], nCompsVWAvg, nToUnPack, true);
-  }
-  // mass weighted averages
-  for (int i = 0; i < this->NMassWtdAvgs; ++i)
-  {
-    int nCompsMWAvg = this->FragmentMassWtdAvgs[i]->GetNumberOfComponents();
-    ReNewVtkArrayPointer(this->FragmentMassWtdAvgs[i], this->FragmentMassWtdAvgs[i]->GetName());
-    buffer.UnPack(this->FragmentMassWtdAvgs[i], nCompsMWAvg, nToUnPack, true);
-  }
-  // sums
-  for (int i = 0; i < this->NToSum; ++i)
-  {
-    int nCompsSum = this->FragmentSums[i]->GetNumberOfComponents();
-    ReNewVtkArrayPointer(this->FragmentSums[i], this->FragmentSums[i]->GetName());
-    buffer.UnPack(this->FragmentSums[i], nCompsSum, nToUnPack, true);
-  }
-
-  return 1;
-}
-
-//----------------------------------------------------------------------------
-// Send my integrated attributes to another process.
-//
-// return 0 on error.
-int vtkMaterialInterfaceFilter::SendIntegratedAttributes(const int recipientProcId)
-{
-  const int myProcId = this->Controller->GetLocalProcessId();
-  const int msgBase = 200000;
-
-  // estimate buffer size (in bytes)
-  const vtkIdType nToSend = this->FragmentVolumes->GetNumberOfTuples();
-  unsigned int totalNumberOfComps = 1 + (this->ComputeMoments ? 4 : 0); // volume + moments
-  if (this->ClipWithPlane)
-  {
-    totalNumberOfComps += this->ClipDepthMaximums->GetNumberOfComponents();
-    totalNumberOfComps += this->ClipDepthMinimums->GetNumberOfComponents();
-  }
-  for (int i = 0; i < this->NVolumeWtdAvgs; ++i) // + volume weighted averages
-  {
-    totalNumberOfComps += this->FragmentVolumeWtdAvgs[i]->GetNumberOfComponents();
-  }
-  for (int i = 0; i < this->NMassWtdAvgs; ++i) // + mass weighted averages
-  {
-    totalNumberOfComps += this->FragmentMassWtdAvgs[i]->GetNumberOfComponents();
-  }
-  for (int i = 0; i < this->NToSum; ++i) // + sums
-  {
-    totalNumberOfComps += this->FragmentSums[i]->GetNumberOfComponents();
-  }
-  const vtkIdType bufferSize = nToSend * totalNumberOfComps * sizeof(double);
-
-  // prepare a comm buffer
-  // Will use only a single block(material) of attribute data
-  // We size the buffer, and set the number of fragments.
-  vtkMaterialInterfaceCommBuffer buffer;
-  buffer.Initialize(myProcId, 1, bufferSize);
-  buffer.SetNumberOfTuples(0, nToSend);
-
-  // pack attributes into the buffer
-  // volume
-  buffer.Pack(this->FragmentVolumes);
-  if (this->ClipWithPlane)
-  {
-    buffer.Pack(this->ClipDepthMaximums);
-    buffer.Pack(this->ClipDepthMinimums);
-  }
-  // moments
-  if (this->ComputeMoments)
-  {
-    buffer.Pack(this->FragmentMoments);
-  }
-  // volume weighted averages
-  for (int i = 0; i < this->NVolumeWtdAvgs; ++i)
-  {
-    buffer.Pack(this->FragmentVolumeWtdAvgs[i]);
-  }
-  // mass weighted averages
-  for (int i = 0; i < this->NMassWtdAvgs; ++i)
-  {
-    buffer.Pack(this->FragmentMassWtdAvgs[i]);
-  }
-  // sums
-  for (int i = 0; i < this->NToSum; ++i)
-  {
-    buffer.Pack(this->FragmentSums[i]);
-  }
-
-  // send the buffer in two parts, first the header, followed by
-  // the attribute data
-  int thisMsgId = msgBase;
-  // buffer's header
-  this->Controller->Send(buffer.GetHeader(), buffer.GetHeaderSize(), recipientProcId, thisMsgId);
-  ++thisMsgId;
-  // packed attributes
-  this->Controller->Send(buffer.GetBuffer(), buffer.GetBufferSize(), recipientProcId, thisMsgId);
-  ++thisMsgId;
-
-  return 1;
-}
-
-//----------------------------------------------------------------------------
-// Send my integrated attribute arrays to all other processes.
-//
-// return 0 on error.
-int vtkMaterialInterfaceFilter::BroadcastIntegratedAttributes(const int sourceProcId)
-{
-#ifdef vtkMaterialInterfaceFilterDEBUG
-  ostringstream progressMesg;
-  progressMesg << "vtkMaterialInterfaceFilter::BroadcastIntegratedAttributes("
-               << ") , Material " << this->MaterialId;
-  this->SetProgressText(progressMesg.str().c_str());
-#endif
-  this->Progress += this->ProgressResolutionInc;
-  this->UpdateProgress(this->Progress);
-
-  const int myProcId = this->Controller->GetLocalProcessId();
-  const int nProcs = this->Controller->GetNumberOfProcesses();
-
-  // anything to do?
-  if (nProcs == 1)
-  {
-    return 1;
-  }
-
-  // send mine to all
-  if (myProcId == sourceProcId)
-  {
-    for (int procId = 0; procId < nProcs; ++procId)
-    {
-      // skip me
-      if (procId == sourceProcId)
-      {
-        continue;
-      }
-      this->SendIntegratedAttributes(procId);
-    }
-  }
-  // receive from source
-  else
-  {
-    this->ReceiveIntegratedAttributes(sourceProcId);
-  }
-
-  return 1;
-}
-
-//----------------------------------------------------------------------------
-// Create some buffers to hold the other processes attribute arrays.
-// Copy our current data into these arrays as well.
-//
-// return 0 on error.
-int vtkMaterialInterfaceFilter::PrepareToCollectIntegratedAttributes(
-  vector<vtkMaterialInterfaceCommBuffer>& buffers, vector<vtkDoubleArray*>& volumes,
-  vector<vtkDoubleArray*>& clipDepthMaxs, vector<vtkDoubleArray*>& clipDepthMins,
-  vector<vtkDoubleArray*>& moments, vector<vector<vtkDoubleArray*> >& volumeWtdAvgs,
-  vector<vector<vtkDoubleArray*> >& massWtdAvgs, vector<vector<vtkDoubleArray*> >& sums)
-{
-  const int myProcId = this->Controller->GetLocalProcessId();
-  const int nProcs = this->Controller->GetNumberOfProcesses();
-
-  // set up for collect
-  // buffers
-  buffers.resize(nProcs);
-  // volumes
-  ResizeVectorOfVtkPointers(volumes, nProcs);
-  volumes[myProcId]->Delete();
-  volumes[myProcId] = this->FragmentVolumes;
-  // ClipDepths
-  if (this->ClipWithPlane)
-  {
-    ResizeVectorOfVtkPointers(clipDepthMaxs, nProcs);
-    clipDepthMaxs[myProcId]->Delete();
-    clipDepthMaxs[myProcId] = this->ClipDepthMaximums;
-    ResizeVectorOfVtkPointers(clipDepthMins, nProcs);
-    clipDepthMins[myProcId]->Delete();
-    clipDepthMins[myProcId] = this->ClipDepthMinimums;
-  }
-  // moments
-  if (this->ComputeMoments)
-  {
-    ResizeVectorOfVtkPointers(moments, nProcs);
-    moments[myProcId]->Delete();
-    moments[myProcId] = this->FragmentMoments;
-  }
-  // volume weighted averages
-  if (this->NVolumeWtdAvgs > 0)
-  {
-    volumeWtdAvgs.resize(nProcs);
-    for (int procId = 0; procId < nProcs; ++procId)
-    {
-      if (procId == myProcId)
-      {
-        volumeWtdAvgs[procId] = this->FragmentVolumeWtdAvgs;
-      }
-      else
-      {
-        ResizeVectorOfVtkPointers(volumeWtdAvgs[procId], this->NVolumeWtdAvgs);
-      }
-    }
-  }
-  // mass weighted averages
-  if (this->NMassWtdAvgs > 0)
-  {
-    massWtdAvgs.resize(nProcs);
-    for (int procId = 0; procId < nProcs; ++procId)
-    {
-      if (procId == myProcId)
-      {
-        massWtdAvgs[procId] = this->FragmentMassWtdAvgs;
-      }
-      else
-      {
-        ResizeVectorOfVtkPointers(massWtdAvgs[procId], this->NMassWtdAvgs);
-      }
-    }
-  }
-  // sums
-  if (this->NToSum > 0)
-  {
-    sums.resize(nProcs);
-    for (int procId = 0; procId < nProcs; ++procId)
-    {
-      if (procId == myProcId)
-      {
-        sums[procId] = this->FragmentSums;
-      }
-      else
-      {
-        ResizeVectorOfVtkPointers(sums[procId], this->NToSum);
-      }
-    }
-  }
-  return 1;
-}
-
-//----------------------------------------------------------------------------
-// Create some buffers to hold the other processes attribute arrays.
-// Copy our current data into these arrays as well.
-//
-// return 0 on error.
-int vtkMaterialInterfaceFilter::CleanUpAfterCollectIntegratedAttributes(
-  vector<vtkMaterialInterfaceCommBuffer>& buffers, vector<vtkDoubleArray*>& volumes,
-  vector<vtkDoubleArray*>& clipDepthMaxs, vector<vtkDoubleArray*>& clipDepthMins,
-  vector<vtkDoubleArray*>& moments, vector<vector<vtkDoubleArray*> >& volumeWtdAvgs,
-  vector<vector<vtkDoubleArray*> >& massWtdAvgs, vector<vector<vtkDoubleArray*> >& sums)
-{
-  const int nProcs = this->Controller->GetNumberOfProcesses();
-
-  // volumes
-  ClearVectorOfVtkPointers(volumes);
-  // clip depths
-  if (this->ClipWithPlane)
-  {
-    ClearVectorOfVtkPointers(clipDepthMaxs);
-    ClearVectorOfVtkPointers(clipDepthMins);
-  }
-  // moments
-  if (this->ComputeMoments)
-  {
-    ClearVectorOfVtkPointers(moments);
-  }
-  // volume weighted averages
-  if (this->NVolumeWtdAvgs > 0)
-  {
-    for (int procId = 0; procId < nProcs; ++procId)
-    {
-      ClearVectorOfVtkPointers(volumeWtdAvgs[procId]);
-    }
-  }
-  // mass weighted averages
-  if (this->NMassWtdAvgs > 0)
-  {
-    for (int procId = 0; procId < nProcs; ++procId)
-    {
-      ClearVectorOfVtkPointers(massWtdAvgs[procId]);
-    }
-  }
-  // sums
-  if (this->NToSum > 0)
-  {
-    for (int procId = 0; procId < nProcs; ++procId)
-    {
-      ClearVectorOfVtkPointers(sums[procId]);
-    }
-  }
-  // buffers
-  buffers.clear();
-
-  return 1;
-}
-
 //----------------------------------------------------------------------------
 // Make new arrays to hold the resolved integarted attributes,
 // and initialize to zero.
@@ -7948,195 +7564,156 @@ int vtkMaterialInterfaceFilter::PrepareToResolveIntegratedAttributes()
 }
 
 //----------------------------------------------------------------------------
-// This is a gather operation that includes requisite calculations
-// to finish integrations. The integrated arrays on the controlling
-// process are resolved, but other procs are not updated.
+namespace
+{
+// Adds the tuples of an unresolved attribute array to the tuples of the
+// resolved array given by the equivalence set. When weights are given,
+// tuples are divided by the weight of the resolved fragment.
+void AccumulateResolvedAttribute(vtkMaterialInterfaceEquivalenceSet* set, int nUnresolved,
+  vtkDoubleArray* unresolved, vtkDoubleArray* resolved, const double* pWt = 0, int nCompsWt = 1)
+{
+  const int nComps = resolved->GetNumberOfComponents();
+  const double* pUnresolved = unresolved->GetPointer(0);
+  double* pResolved = resolved->GetPointer(0);
+  for (int i = 0; i < nUnresolved; ++i)
+  {
+    int resId = set->GetEquivalentSetId(i);
+    int resIdx = nComps * resId;
+    double wt = pWt ? pWt[nCompsWt * resId] : 1.0;
+    for (int q = 0; q < nComps; ++q)
+    {
+      pResolved[resIdx + q] += pUnresolved[q] / wt;
+    }
+    pUnresolved += nComps;
+  }
+}
+
+// Sums the arrays over all processes, in place. This is done with a single
+// reduction.
+void AllReduceResolvedAttributes(
+  vtkMultiProcessController* controller, const vector<vtkDoubleArray*>& arrays)
+{
+  vector<double> local;
+  for (vtkDoubleArray* array : arrays)
+  {
+    const double* pArray = array->GetPointer(0);
+    local.insert(local.end(), pArray, pArray + array->GetDataSize());
+  }
+  if (local.empty())
+  {
+    return;
+  }
+  vector<double> global(local.size());
+  controller->AllReduce(
+    local.data(), global.data(), static_cast<vtkIdType>(local.size()), vtkCommunicator::SUM_OP);
+  const double* pGlobal = global.data();
+  for (vtkDoubleArray* array : arrays)
+  {
+    std::copy(pGlobal, pGlobal + array->GetDataSize(), array->GetPointer(0));
+    pGlobal += array->GetDataSize();
+  }
+}
+};
+
+//----------------------------------------------------------------------------
+// Sum/finalize the integrated attributes of fragments which are split
+// over multiple processes. Each process accumulates its own pieces into
+// arrays indexed by resolved fragment id, and these are summed over all
+// processes, so that all processes end up with the resolved attributes.
 //
 // return 0 on error.
-int vtkMaterialInterfaceFilter::ResolveIntegratedAttributes(const int controllingProcId)
+int vtkMaterialInterfaceFilter::ResolveIntegratedAttributes()
 {
+#ifdef vtkMaterialInterfaceFilterDEBUG
+  ostringstream progressMesg;
+  progressMesg << "vtkMaterialInterfaceFilter::ResolveIntegratedAttributes("
+               << ") , Material " << this->MaterialId;
+  this->SetProgressText(progressMesg.str().c_str());
+#endif
+  this->Progress += this->ProgressResolutionInc;
+  this->UpdateProgress(this->Progress);
+
   const int myProcId = this->Controller->GetLocalProcessId();
-  const int nProcs = this->Controller->GetNumberOfProcesses();
+  const int nUnresolved = this->NumberOfRawFragmentsInProcess[myProcId];
+
+  // hold on to our unresolved attributes while new arrays
+  // are made for the resolved ones.
+  vtkDoubleArray* volumes = this->FragmentVolumes;
+  vtkDoubleArray* clipDepthMaxs = this->ClipDepthMaximums;
+  vtkDoubleArray* clipDepthMins = this->ClipDepthMinimums;
+  vtkDoubleArray* moments = this->FragmentMoments;
+  vector<vtkDoubleArray*> volumeWtdAvgs = this->FragmentVolumeWtdAvgs;
+  vector<vtkDoubleArray*> massWtdAvgs = this->FragmentMassWtdAvgs;
+  vector<vtkDoubleArray*> sums = this->FragmentSums;
+  this->PrepareToResolveIntegratedAttributes();
+
+  // First pass we'll resolve attributes which
+  // are needed to resolve other attributes (eg weights)
+  vector<vtkDoubleArray*> resolved;
+  AccumulateResolvedAttribute(this->EquivalenceSet, nUnresolved, volumes, this->FragmentVolumes);
+  resolved.push_back(this->FragmentVolumes);
+  if (this->ClipWithPlane)
+  {
+    AccumulateResolvedAttribute(
+      this->EquivalenceSet, nUnresolved, clipDepthMaxs, this->ClipDepthMaximums);
+    AccumulateResolvedAttribute(
+      this->EquivalenceSet, nUnresolved, clipDepthMins, this->ClipDepthMinimums);
+    resolved.push_back(this->ClipDepthMaximums);
+    resolved.push_back(this->ClipDepthMinimums);
+  }
+  if (this->ComputeMoments)
+  {
+    AccumulateResolvedAttribute(this->EquivalenceSet, nUnresolved, moments, this->FragmentMoments);
+    resolved.push_back(this->FragmentMoments);
+  }
+  // sums do not depend on the weights, resolve them in this pass.
+  for (int k = 0; k < this->NToSum; ++k)
+  {
+    AccumulateResolvedAttribute(this->EquivalenceSet, nUnresolved, sums[k], this->FragmentSums[k]);
+    resolved.push_back(this->FragmentSums[k]);
+  }
+  AllReduceResolvedAttributes(this->Controller, resolved);
 
-  // controller gathers and resolves
-  if (myProcId == controllingProcId)
+  // Second pass, resolve attributes which depend on
+  // other attributes (eg weighted averages)
+  resolved.clear();
+  // volume weighted averages
+  for (int k = 0; k < this->NVolumeWtdAvgs; ++k)
   {
-    vector<vtkMaterialInterfaceCommBuffer> buffers;
-    vector<vtkDoubleArray*> volumes;
-    vector<vtkDoubleArray*> clipDepthMaxs;
-    vector<vtkDoubleArray*> clipDepthMins;
-    vector<vtkDoubleArray*> moments;
-    vector<vector<vtkDoubleArray*> > volumeWtdAvgs;
-    vector<vector<vtkDoubleArray*> > massWtdAvgs;
-    vector<vector<vtkDoubleArray*> > sums;
-    // prepare collect buffers
-    this->PrepareToCollectIntegratedAttributes(
-      buffers, volumes, clipDepthMaxs, clipDepthMins, moments, volumeWtdAvgs, massWtdAvgs, sums);
-    // collect
-    this->CollectIntegratedAttributes(
-      buffers, volumes, clipDepthMaxs, clipDepthMins, moments, volumeWtdAvgs, massWtdAvgs, sums);
-
-    // prepare for resolution
-    this->PrepareToResolveIntegratedAttributes();
-    // resolve attributes
-    // First pass we'll resolve attributes which
-    // are needed to resolve other attributes (eg weights)
-    int procBaseEqSetId = 0;
-    for (int procId = 0; procId < nProcs; ++procId)
+    AccumulateResolvedAttribute(this->EquivalenceSet, nUnresolved, volumeWtdAvgs[k],
+      this->FragmentVolumeWtdAvgs[k], this->FragmentVolumes->GetPointer(0), 1);
+    resolved.push_back(this->FragmentVolumeWtdAvgs[k]);
+  }
+  // mass weighted averages (Mx,My,Mz,Mass)
+  if (this->ComputeMoments)
+  {
+    for (int k = 0; k < this->NMassWtdAvgs; ++k)
     {
-      int eqSetId;
-      double* pResolved;
-      const double* pUnresolved;
-      int nUnresolved = this->NumberOfRawFragmentsInProcess[procId];
-
-      // volume
-      pUnresolved = volumes[procId]->GetPointer(0);
-      pResolved = this->FragmentVolumes->GetPointer(0);
-      eqSetId = procBaseEqSetId;
-      for (int i = 0; i < nUnresolved; ++i)
-      {
-        int resIdx = this->EquivalenceSet->GetEquivalentSetId(eqSetId);
-        pResolved[resIdx] += pUnresolved[0];
-        ++pUnresolved;
-        ++eqSetId;
-      }
-      // clip depth
-      if (this->ClipWithPlane)
-      {
-        pUnresolved = clipDepthMaxs[procId]->GetPointer(0);
-        pResolved = this->ClipDepthMaximums->GetPointer(0);
-        eqSetId = procBaseEqSetId;
-        for (int i = 0; i < nUnresolved; ++i)
-        {
-          int resIdx = this->EquivalenceSet->GetEquivalentSetId(eqSetId);
-          pResolved[resIdx] += pUnresolved[0];
-          ++pUnresolved;
-          ++eqSetId;
-        }
-        pUnresolved = clipDepthMins[procId]->GetPointer(0);
-        pResolved = this->ClipDepthMinimums->GetPointer(0);
-        eqSetId = procBaseEqSetId;
-        for (int i = 0; i < nUnresolved; ++i)
-        {
-          int resIdx = this->EquivalenceSet->GetEquivalentSetId(eqSetId);
-          pResolved[resIdx] += pUnresolved[0];
-          ++pUnresolved;
-          ++eqSetId;
-        }
-      }
-      // moments
-      if (this->ComputeMoments)
-      {
-        pUnresolved = moments[procId]->GetPointer(0);
-        pResolved = this->FragmentMoments->GetPointer(0);
-        eqSetId = procBaseEqSetId;
-        for (int i = 0; i < nUnresolved; ++i)
-        {
-          int resIdx = 4 * this->EquivalenceSet->GetEquivalentSetId(eqSetId);
-          for (int q = 0; q < 4; ++q)
-          {
-            pResolved[resIdx + q] += pUnresolved[q];
-          }
-          pUnresolved += 4;
-          ++eqSetId;
-        }
-      }
-      procBaseEqSetId += nUnresolved;
+      AccumulateResolvedAttribute(this->EquivalenceSet, nUnresolved, massWtdAvgs[k],
+        this->FragmentMassWtdAvgs[k], this->FragmentMoments->GetPointer(0) + 3, 4);
+      resolved.push_back(this->FragmentMassWtdAvgs[k]);
     }
+  }
+  AllReduceResolvedAttributes(this->Controller, resolved);
 
-    // Second pass, resolve attributes which depend on
-    // other attributes (eg weighted averages)
-    procBaseEqSetId = 0;
-    for (int procId = 0; procId < nProcs; ++procId)
-    {
-      int eqSetId;
-      double* pResolved;
-      const double* pUnresolved;
-      int nUnresolved = this->NumberOfRawFragmentsInProcess[procId];
-      // volume weighted averages
-      double* pWt;  // these have to do with weights
-      int nCompsWt; //
-      int wtComp;   //
-      for (int k = 0; k < this->NVolumeWtdAvgs; ++k)
-      {
-        pUnresolved = volumeWtdAvgs[procId][k]->GetPointer(0);
-        pResolved = this->FragmentVolumeWtdAvgs[k]->GetPointer(0);
-        int nComps = this->FragmentVolumeWtdAvgs[k]->GetNumberOfComponents();
-        pWt = this->FragmentVolumes->GetPointer(0);
-        nCompsWt = 1;
-        wtComp = 0;
-        eqSetId = procBaseEqSetId;
-        for (int i = 0; i < nUnresolved; ++i)
-        {
-          int resId = this->EquivalenceSet->GetEquivalentSetId(eqSetId);
-          int resIdx = nComps * resId;
-          int wtIdx = nCompsWt * resId;
-          for (int q = 0; q < nComps; ++q)
-          {
-            pResolved[resIdx + q] += pUnresolved[q] / pWt[wtIdx];
-          }
-          pUnresolved += nComps;
-          ++eqSetId;
-        }
-      }
-      // mass weighted averages (Mx,My,Mz,Mass)
-      if (this->ComputeMoments)
-      {
-        for (int k = 0; k < this->NMassWtdAvgs; ++k)
-        {
-          pUnresolved = massWtdAvgs[procId][k]->GetPointer(0);
-          pResolved = this->FragmentMassWtdAvgs[k]->GetPointer(0);
-          int nComps = this->FragmentMassWtdAvgs[k]->GetNumberOfComponents();
-          nCompsWt = 4;
-          wtComp = 3;
-          pWt = this->FragmentMoments->GetPointer(0) + wtComp;
-          eqSetId = procBaseEqSetId;
-          for (int i = 0; i < nUnresolved; ++i)
-          {
-            int resId = this->EquivalenceSet->GetEquivalentSetId(eqSetId);
-            int resIdx = nComps * resId;
-            int wtIdx = nCompsWt * resId;
-            for (int q = 0; q < nComps; ++q)
-            {
-              pResolved[resIdx + q] += pUnresolved[q] / pWt[wtIdx];
-            }
-            pUnresolved += nComps;
-            ++eqSetId;
-          }
-        }
-      }
-      // sums
-      for (int k = 0; k < this->NToSum; ++k)
-      {
-        pUnresolved = sums[procId][k]->GetPointer(0);
-        pResolved = this->FragmentSums[k]->GetPointer(0);
-        int nComps = this->FragmentSums[k]->GetNumberOfComponents();
-        eqSetId = procBaseEqSetId;
-        for (int i = 0; i < nUnresolved; ++i)
-        {
-          int resIdx = nComps * this->EquivalenceSet->GetEquivalentSetId(eqSetId);
-          for (int q = 0; q < nComps; ++q)
-          {
-            pResolved[resIdx + q] += pUnresolved[q];
-          }
-          pUnresolved += nComps;
-          ++eqSetId;
-        }
-      }
-      procBaseEqSetId += nUnresolved;
-    }
-    // clean up
-    this->CleanUpAfterCollectIntegratedAttributes(
-      buffers, volumes, clipDepthMaxs, clipDepthMins, moments, volumeWtdAvgs, massWtdAvgs, sums);
+  // clean up
+  volumes->Delete();
+  if (this->ClipWithPlane)
+  {
+    clipDepthMaxs->Delete();
+    clipDepthMins->Delete();
   }
-  // others send unresolved integrated attributes
-  else
+  if (this->ComputeMoments)
   {
-    this->SendIntegratedAttributes(controllingProcId);
+    moments->Delete();
   }
+  ClearVectorOfVtkPointers(volumeWtdAvgs);
+  ClearVectorOfVtkPointers(massWtdAvgs);
+  ClearVectorOfVtkPointers(sums);
 
   return 1;
 }
+
 //----------------------------------------------------------------------------
 // Free memory that we won't be needing.which has been
 // allocated on our behalf.
@@ -8227,8 +7804,7 @@ void vtkMaterialInterfaceFilter::ResolveEquivalences()
 
   // Accumulate contributions from fragemnts who were
   // previously split.
-  this->ResolveIntegratedAttributes(0);
-  this->BroadcastIntegratedAttributes(0);
+  this->ResolveIntegratedAttributes();
 #ifdef vtkMaterialInterfaceFilterDEBUG
   cerr << "[" << __LINE__ << "] " << myProcId
        << " memory commitment after ResolveIntegratedAttributes is:" << endl
@@ -8264,6 +7840,8 @@ void vtkMaterialInterfaceFilter::ResolveEquivalences()
 //----------------------------------------------------------------------------
 // This also fills in the arrays NumberOfRawFragments and LocalToGlobalOffsets
 // as a side effect. (also NumberOfResolvedFragments).
+//
+// On return the set maps local fragment ids to resolved (global) fragment ids.
 void vtkMaterialInterfaceFilter::GatherEquivalenceSets(vtkMaterialInterfaceEquivalenceSet* set)
 {
 #ifdef vtkMaterialInterfaceFilterDEBUG
@@ -8276,28 +7854,10 @@ void vtkMaterialInterfaceFilter::GatherEquivalenceSets(vtkMaterialInterfaceEquiv
   this->UpdateProgress(this->Progress);
 
   const int numProcs = this->Controller->GetNumberOfProcesses();
-  const int myProcId = this->Controller->GetLocalProcessId();
   const int numLocalMembers = set->GetNumberOfMembers();
 
   // Find a mapping between local fragment id and the global fragment ids.
-  if (myProcId == 0)
-  {
-    this->NumberOfRawFragmentsInProcess[0] = numLocalMembers;
-    for (int ii = 1; ii < numProcs; ++ii)
-    {
-      this->Controller->Receive(this->NumberOfRawFragmentsInProcess + ii, 1, ii, 875034);
-    }
-    // Now send the results back to all processes.
-    for (int ii = 1; ii < numProcs; ++ii)
-    {
-      this->Controller->Send(this->NumberOfRawFragmentsInProcess, numProcs, ii, 875035);
-    }
-  }
-  else
-  {
-    this->Controller->Send(&numLocalMembers, 1, 0, 875034);
-    this->Controller->Receive(this->NumberOfRawFragmentsInProcess, numProcs, 0, 875035);
-  }
+  this->Controller->AllGather(&numLocalMembers, this->NumberOfRawFragmentsInProcess, 1);
   // Compute offsets.
   int totalNumberOfIds = 0;
   for (int ii = 0; ii < numProcs; ++ii)
@@ -8308,117 +7868,240 @@ void vtkMaterialInterfaceFilter::GatherEquivalenceSets(vtkMaterialInterfaceEquiv
   }
   this->TotalNumberOfRawFragments = totalNumberOfIds;
 
-  // Change the set to a global set.
-  vtkMaterialInterfaceEquivalenceSet* globalSet = new vtkMaterialInterfaceEquivalenceSet;
-  // This just initializes the set so that every set has one member.
-  //  Every id is equivalent to itself and no others.
-  if (totalNumberOfIds > 0)
-  { // This crashes if there no fragemnts extracted.
-    globalSet->AddEquivalence(totalNumberOfIds - 1, totalNumberOfIds - 1);
-  }
-  // Add the equivalences from our process.
-  int myOffset = this->LocalToGlobalOffsets[myProcId];
-  int memberSetId;
-  for (int ii = 0; ii < numLocalMembers; ++ii)
-  {
-    memberSetId = set->GetEquivalentSetId(ii);
-    // This will be inefficient until I make the scheduled improvemnt to the
-    // add method (Ordered multilevel tree instead of a one level tree).
-    globalSet->AddEquivalence(ii + myOffset, memberSetId + myOffset);
-  }
+  // Resolve the equivalences within our process first. Local sets are
+  // numbered in the order of their smallest member.
+  set->ResolveEquivalences();
 
-  // cerr << myProcId << " Input set: " << endl;
-  // set->Print();
-  // cerr << myProcId << " global set: " << endl;
-  // globalSet->Print();
-
-  // Now add equivalents between processes.
+  // Now find equivalents between processes.
   // Send all the ghost blocks to the process that owns the block.
-  // Compare ids and add the equivalences.
-  this->ShareGhostEquivalences(globalSet, this->LocalToGlobalOffsets);
-
-  // cerr << "Global after ghost: " << myProcId << endl;
-  // globalSet->Print();
+  // Compare ids and keep the equivalences.
+  vtkMaterialInterfaceGhostEquivalences ghostEquivalences;
+  this->ShareGhostEquivalences(set, ghostEquivalences, this->LocalToGlobalOffsets);
 
-  // Merge all of the processes global sets.
-  // Clean the global set so that the resulting set ids are sequential.
-  this->MergeGhostEquivalenceSets(globalSet);
-
-  // cerr << "Global after merge: " << myProcId << endl;
-  // globalSet->Print();
+  // Merge the sets of all the processes, and renumber the resulting
+  // sets so that ids are sequential.
+  this->MergeGhostEquivalenceSets(set, ghostEquivalences);
 
   // free what do not need
-  globalSet->Squeeze();
+  set->Squeeze();
+}
 
-  // Copy the equivalences to the local set for returning our results.
-  // The ids will be the global ids so the GetId method will work.
-  set->DeepCopy(globalSet);
+//----------------------------------------------------------------------------
+// Sends buffers[neighbor] to each neighbor and receives the neighbor's
+// buffer in place. Neighbors are visited in increasing order and the lower
+// rank of a pair sends first, so that all processes go through the pairs in
+// the same order and blocking sends cannot deadlock.
+void vtkMaterialInterfaceFilter::ExchangeWithNeighbors(
+  vtkMaterialInterfaceGhostEquivalences& ghostEquivalences, std::map<int, vector<int> >& buffers)
+{
+  const int myProcId = this->Controller->GetLocalProcessId();
 
-  delete globalSet;
+  vector<int> received;
+  for (auto& neighbor : ghostEquivalences.Neighbors)
+  {
+    const int otherProc = neighbor.first;
+    vector<int>& buffer = buffers[otherProc];
+    int sendSize = static_cast<int>(buffer.size());
+    int recvSize = 0;
+    if (myProcId < otherProc)
+    {
+      this->Controller->Send(&sendSize, 1, otherProc, 342320);
+      this->Controller->Receive(&recvSize, 1, otherProc, 342320);
+    }
+    else
+    {
+      this->Controller->Receive(&recvSize, 1, otherProc, 342320);
+      this->Controller->Send(&sendSize, 1, otherProc, 342320);
+    }
+    received.resize(recvSize);
+    if (myProcId < otherProc)
+    {
+      if (sendSize > 0)
+      {
+        this->Controller->Send(buffer.data(), sendSize, otherProc, 342321);
+      }
+      if (recvSize > 0)
+      {
+        this->Controller->Receive(received.data(), recvSize, otherProc, 342321);
+      }
+    }
+    else
+    {
+      if (recvSize > 0)
+      {
+        this->Controller->Receive(received.data(), recvSize, otherProc, 342321);
+      }
+      if (sendSize > 0)
+      {
+        this->Controller->Send(buffer.data(), sendSize, otherProc, 342321);
+      }
+    }
+    buffer.swap(received);
+  }
 }
 
 //----------------------------------------------------------------------------
+// Resolves the equivalences between processes with a bulk synchronous label
+// propagation. Every local set is labeled with the global id of its smallest
+// member. Each round, processes send the labels that changed to the
+// neighbors that share equivalences with them, and keep the smallest label
+// they received, until no label changes. A merged set is then numbered by
+// the process owning its smallest member, and these numbers are propagated
+// the same way. This yields the same numbering as merging all the sets on a
+// single process, without any process holding more than its own fragments.
 void vtkMaterialInterfaceFilter::MergeGhostEquivalenceSets(
-  vtkMaterialInterfaceEquivalenceSet* globalSet)
+  vtkMaterialInterfaceEquivalenceSet* set, vtkMaterialInterfaceGhostEquivalences& ghostEquivalences)
 {
+  const int numProcs = this->Controller->GetNumberOfProcesses();
   const int myProcId = this->Controller->GetLocalProcessId();
-  int* buf = globalSet->GetPointer();
-  const int numIds = globalSet->GetNumberOfMembers();
-
-  // At this point all the sets are global and have the same number of ids.
-  // Send all the sets to process 0 to be merged.
-  if (myProcId > 0)
-  {
-    this->Controller->Send(buf, numIds, 0, 342320);
-    // Now receive the final equivalences.
-    this->Controller->Receive(&this->NumberOfResolvedFragments, 1, 0, 342321);
-    // Domain has numIds,  range has NumberOfResolvedFragments
-    this->Controller->Receive(buf, numIds, 0, 342322);
-    // We have to mark the set as resolved because the set being
-    // received has been resolved.  If we do not do this then
-    // We cannot get the proper set id.  Using the pointer
-    // here is a bad api.  TODO: Fix the API and make "Resolved" private.
-    globalSet->Resolved = 1;
-    return;
-  }
+  const int myOffset = this->LocalToGlobalOffsets[myProcId];
+  const int numLocalMembers = set->GetNumberOfMembers();
 
-  // Only process 0 from here out.
+  // Number of local sets and the smallest member of each.
+  int numLocalSets = 0;
+  vector<int> smallestMembers;
+  for (int ii = 0; ii < numLocalMembers; ++ii)
+  {
+    if (set->GetEquivalentSetId(ii) == numLocalSets)
+    {
+      smallestMembers.push_back(ii);
+      ++numLocalSets;
+    }
+  }
 
-  int numProcs = this->Controller->GetNumberOfProcesses();
-  int* tmp;
-  tmp = new int[numIds];
-  for (int ii = 1; ii < numProcs; ++ii)
+  // Make the equivalences symmetric: each neighbor tells us which of its
+  // sets are equivalent to which of our fragments.
+  std::map<int, vector<int> > buffers;
+  for (auto& neighbor : ghostEquivalences.Neighbors)
+  {
+    vector<std::pair<int, int> >& pairs = neighbor.second;
+    std::sort(pairs.begin(), pairs.end());
+    pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+    vector<int>& buffer = buffers[neighbor.first];
+    for (const auto& pair : pairs)
+    {
+      buffer.push_back(pair.second);
+      buffer.push_back(smallestMembers[pair.first] + myOffset);
+    }
+  }
+  this->ExchangeWithNeighbors(ghostEquivalences, buffers);
+  for (auto& neighbor : ghostEquivalences.Neighbors)
   {
-    this->Controller->Receive(tmp, numIds, ii, 342320);
-    // Merge the values.
-    for (int jj = 0; jj < numIds; ++jj)
+    vector<std::pair<int, int> >& pairs = neighbor.second;
+    const vector<int>& buffer = buffers[neighbor.first];
+    for (size_t ii = 0; ii < buffer.size(); ii += 2)
+    {
+      pairs.push_back(std::make_pair(set->GetEquivalentSetId(buffer[ii] - myOffset), buffer[ii + 1]));
+    }
+    std::sort(pairs.begin(), pairs.end());
+    pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+  }
+
+  // Sends values[setId] of the sets flagged in `send` over all their
+  // equivalences, and calls `update(setId, value)` for each value received.
+  // Returns true when a set was updated on any process.
+  vector<int> values(numLocalSets);
+  vector<char> send(numLocalSets);
+  vector<char> updated(numLocalSets);
+  auto propagate = [&](const std::function<bool(int, int)>& update) {
+    for (auto& neighbor : ghostEquivalences.Neighbors)
+    {
+      vector<int>& buffer = buffers[neighbor.first];
+      buffer.clear();
+      for (const auto& pair : neighbor.second)
+      {
+        if (send[pair.first])
+        {
+          buffer.push_back(pair.second);
+          buffer.push_back(values[pair.first]);
+        }
+      }
+    }
+    this->ExchangeWithNeighbors(ghostEquivalences, buffers);
+
+    std::fill(updated.begin(), updated.end(), 0);
+    int localUpdate = 0;
+    for (const auto& neighbor : ghostEquivalences.Neighbors)
     {
-      if (tmp[jj] != jj)
-      { // TODO: Make sure this is efficient.  Avoid n^2.
-        globalSet->AddEquivalence(jj, tmp[jj]);
+      const vector<int>& buffer = buffers[neighbor.first];
+      for (size_t ii = 0; ii < buffer.size(); ii += 2)
+      {
+        const int setId = set->GetEquivalentSetId(buffer[ii] - myOffset);
+        if (update(setId, buffer[ii + 1]))
+        {
+          updated[setId] = 1;
+          localUpdate = 1;
+        }
       }
     }
+    send.swap(updated);
+    int globalUpdate = 0;
+    this->Controller->AllReduce(&localUpdate, &globalUpdate, 1, vtkCommunicator::MAX_OP);
+    return globalUpdate != 0;
+  };
+
+  // Propagate the smallest global id of each merged set.
+  for (int ii = 0; ii < numLocalSets; ++ii)
+  {
+    values[ii] = smallestMembers[ii] + myOffset;
+  }
+  std::fill(send.begin(), send.end(), 1);
+  while (propagate([&](int setId, int label) {
+    if (label < values[setId])
+    {
+      values[setId] = label;
+      return true;
+    }
+    return false;
+  }))
+  {
   }
-  delete[] tmp;
 
-  // Make the set ids sequential.
-  this->NumberOfResolvedFragments = globalSet->ResolveEquivalences();
+  // The process holding the smallest member of a merged set numbers it.
+  // Numbering sets in the order of their smallest member matches the
+  // numbering of vtkMaterialInterfaceEquivalenceSet::ResolveEquivalences.
+  int numOwnedSets = 0;
+  for (int ii = 0; ii < numLocalSets; ++ii)
+  {
+    send[ii] = (values[ii] == smallestMembers[ii] + myOffset);
+    numOwnedSets += send[ii];
+  }
+  vector<int> numOwnedSetsInProcess(numProcs);
+  this->Controller->AllGather(&numOwnedSets, numOwnedSetsInProcess.data(), 1);
+  int nextId = 0;
+  this->NumberOfResolvedFragments = 0;
+  for (int ii = 0; ii < numProcs; ++ii)
+  {
+    nextId += (ii < myProcId) ? numOwnedSetsInProcess[ii] : 0;
+    this->NumberOfResolvedFragments += numOwnedSetsInProcess[ii];
+  }
+  for (int ii = 0; ii < numLocalSets; ++ii)
+  {
+    values[ii] = send[ii] ? nextId++ : -1;
+  }
+
+  // Propagate the numbers to the other parts of the merged sets.
+  while (propagate([&](int setId, int resolvedId) {
+    if (values[setId] < 0)
+    {
+      values[setId] = resolvedId;
+      return true;
+    }
+    return false;
+  }))
+  {
+  }
 
-  // The pointers should still be valid.
-  // The array should not resize here.
-  // Number of resolved fragemnts will be smaller
-  // than TotalNumberOfRawFragments
-  for (int ii = 1; ii < numProcs; ++ii)
+  // Map local fragment ids to resolved ids.
+  if (numLocalSets > 0)
   {
-    this->Controller->Send(&this->NumberOfResolvedFragments, 1, ii, 342321);
-    // Domain has numIds,  range has NumberOfResolvedFragments
-    this->Controller->Send(buf, numIds, ii, 342322);
+    set->RenumberSets(values.data());
   }
 }
 
 //----------------------------------------------------------------------------
-void vtkMaterialInterfaceFilter::ShareGhostEquivalences(
-  vtkMaterialInterfaceEquivalenceSet* globalSet, int* procOffsets)
+void vtkMaterialInterfaceFilter::ShareGhostEquivalences(vtkMaterialInterfaceEquivalenceSet* set,
+  vtkMaterialInterfaceGhostEquivalences& ghostEquivalences, int* procOffsets)
 {
   const int numProcs = this->Controller->GetNumberOfProcesses();
   const int myProcId = this->Controller->GetLocalProcessId();
@@ -8429,7 +8112,7 @@ void vtkMaterialInterfaceFilter::ShareGhostEquivalences(
   {
     if (otherProc == myProcId)
     {
-      this->ReceiveGhostFragmentIds(globalSet, procOffsets);
+      this->ReceiveGhostFragmentIds(set, ghostEquivalences, procOffsets);
     }
     else
     {
@@ -8455,6 +8138,8 @@ void vtkMaterialInterfaceFilter::ShareGhostEquivalences(
           this->Controller->Send(framentIds,
             (ext[1] - ext[0] + 1) * (ext[3] - ext[2] + 1) * (ext[5] - ext[4] + 1), otherProc,
             722266);
+          // otherProc will send us the equivalences it finds.
+          ghostEquivalences.Neighbors[otherProc];
         } // End if ghost  block owned by other process.
       }   // End loop over all blocks.
       // Send the message that indicates we have nothing more to send.
@@ -8468,8 +8153,8 @@ void vtkMaterialInterfaceFilter::ShareGhostEquivalences(
 //----------------------------------------------------------------------------
 // Receive all the gost blocks from remote processes and
 // find the equivalences.
-void vtkMaterialInterfaceFilter::ReceiveGhostFragmentIds(
-  vtkMaterialInterfaceEquivalenceSet* globalSet, int* procOffsets)
+void vtkMaterialInterfaceFilter::ReceiveGhostFragmentIds(vtkMaterialInterfaceEquivalenceSet* set,
+  vtkMaterialInterfaceGhostEquivalences& ghostEquivalences, int* procOffsets)
 {
   int msg[8];
   int otherProc;
@@ -8480,8 +8165,6 @@ void vtkMaterialInterfaceFilter::ReceiveGhostFragmentIds(
   int dataSize;
   int* remoteExt;
   int localId, remoteId;
-  const int myProcId = this->Controller->GetLocalProcessId();
-  int localOffset = procOffsets[myProcId];
   int remoteOffset;
 
   // We do not receive requests from our own process.
@@ -8522,6 +8205,7 @@ void vtkMaterialInterfaceFilter::ReceiveGhostFragmentIds(
       // We have our block, and the remote fragmentIds.
       // Now for the equivalences.
       // Loop through all of the voxels.
+      vector<std::pair<int, int> >& pairs = ghostEquivalences.Neighbors[otherProc];
       int* remoteFragmentIds = buf;
       int* localFragmentIds = block->GetFragmentIdPointer();
       int localExt[6];
@@ -8540,12 +8224,18 @@ void vtkMaterialInterfaceFilter::ReceiveGhostFragmentIds(
           px = py;
           for (int ix = remoteExt[0]; ix <= remoteExt[1]; ++ix)
           {
-            // Convert local fragment ids to global ids.
+            // Keep our set id and the remote global id.
             localId = *px;
             remoteId = *remoteFragmentIds;
             if (localId >= 0 && remoteId >= 0)
             {
-              globalSet->AddEquivalence(localId + localOffset, remoteId + remoteOffset);
+              // Neighboring voxels mostly give the same pair, duplicates
+              // are removed later.
+              std::pair<int, int> pair(set->GetEquivalentSetId(localId), remoteId + remoteOffset);
+              if (pairs.empty() || pairs.back() != pair)
+              {
+                pairs.push_back(pair);
+              }
             }
             ++remoteFragmentIds;
             ++px;
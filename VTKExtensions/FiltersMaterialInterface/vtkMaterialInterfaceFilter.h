@@ -37,6 +37,7 @@
 
 #include "vtkMultiBlockDataSetAlgorithm.h"
 #include "vtkPVVTKExtensionsFiltersMaterialInterfaceModule.h" //needed for exports
+#include <map>                                                // needed for map
 #include <string>                                             // needed for string
 #include <vector>                                             // needed for vector
 
@@ -62,6 +63,7 @@ class vtkMaterialInterfaceLevel;
 class vtkMaterialInterfaceFilterBlock;
 class vtkMaterialInterfaceFilterIterator;
 class vtkMaterialInterfaceEquivalenceSet;
+class vtkMaterialInterfaceGhostEquivalences;
 class vtkMaterialInterfaceFilterRingBuffer;
 class vtkMaterialInterfacePieceLoading;
 class vtkMaterialInterfaceCommBuffer;
@@ -393,44 +395,22 @@ protected:
   //
   void ResolveEquivalences();
   void GatherEquivalenceSets(vtkMaterialInterfaceEquivalenceSet* set);
-  void ShareGhostEquivalences(vtkMaterialInterfaceEquivalenceSet* globalSet, int* procOffsets);
-  void ReceiveGhostFragmentIds(vtkMaterialInterfaceEquivalenceSet* globalSet, int* procOffset);
-  void MergeGhostEquivalenceSets(vtkMaterialInterfaceEquivalenceSet* globalSet);
+  void ShareGhostEquivalences(vtkMaterialInterfaceEquivalenceSet* set,
+    vtkMaterialInterfaceGhostEquivalences& ghostEquivalences, int* procOffsets);
+  void ReceiveGhostFragmentIds(vtkMaterialInterfaceEquivalenceSet* set,
+    vtkMaterialInterfaceGhostEquivalences& ghostEquivalences, int* procOffsets);
+  void MergeGhostEquivalenceSets(vtkMaterialInterfaceEquivalenceSet* set,
+    vtkMaterialInterfaceGhostEquivalences& ghostEquivalences);
+  // Swap buffers with the processes that share ghost equivalences with us.
+  void ExchangeWithNeighbors(vtkMaterialInterfaceGhostEquivalences& ghostEquivalences,
+    std::map<int, std::vector<int> >& buffers);
 
   // Sum/finalize attribute's contribution for those
   // which are split over multiple processes.
-  int ResolveIntegratedAttributes(const int controllingProcId);
+  int ResolveIntegratedAttributes();
   // Initialize our attribute arrays to ho9ld resolved attributes
   int PrepareToResolveIntegratedAttributes();
 
-  // Send my integrated attributes to another process.
-  int SendIntegratedAttributes(const int recipientProcId);
-  // Receive integrated attributes from another process.
-  int ReceiveIntegratedAttributes(const int sourceProcId);
-  // Size buffers etc...
-  int PrepareToCollectIntegratedAttributes(std::vector<vtkMaterialInterfaceCommBuffer>& buffers,
-    std::vector<vtkDoubleArray*>& volumes, std::vector<vtkDoubleArray*>& clipDepthMaxs,
-    std::vector<vtkDoubleArray*>& clipDepthMins, std::vector<vtkDoubleArray*>& moments,
-    std::vector<std::vector<vtkDoubleArray*> >& volumeWtdAvgs,
-    std::vector<std::vector<vtkDoubleArray*> >& massWtdAvgs,
-    std::vector<std::vector<vtkDoubleArray*> >& sums);
-  // Free resources.
-  int CleanUpAfterCollectIntegratedAttributes(std::vector<vtkMaterialInterfaceCommBuffer>& buffers,
-    std::vector<vtkDoubleArray*>& volumes, std::vector<vtkDoubleArray*>& clipDepthMaxs,
-    std::vector<vtkDoubleArray*>& clipDepthMins, std::vector<vtkDoubleArray*>& moments,
-    std::vector<std::vector<vtkDoubleArray*> >& volumeWtdAvgs,
-    std::vector<std::vector<vtkDoubleArray*> >& massWtdAvgs,
-    std::vector<std::vector<vtkDoubleArray*> >& sums);
-  // Receive all integrated attribute arrays from all other
-  // processes.
-  int CollectIntegratedAttributes(std::vector<vtkMaterialInterfaceCommBuffer>& buffers,
-    std::vector<vtkDoubleArray*>& volumes, std::vector<vtkDoubleArray*>& clipDepthMaxs,
-    std::vector<vtkDoubleArray*>& clipDepthMins, std::vector<vtkDoubleArray*>& moments,
-    std::vector<std::vector<vtkDoubleArray*> >& volumeWtdAvgs,
-    std::vector<std::vector<vtkDoubleArray*> >& massWtdAvgs,
-    std::vector<std::vector<vtkDoubleArray*> >& sums);
-  // Send my integrated attributes to all other processes.
-  int BroadcastIntegratedAttributes(const int sourceProcessId);
   // Send my geometric attribuites to a controller.
   int SendGeometricAttributes(const int controllingProcId);
   // size buffers & new containers
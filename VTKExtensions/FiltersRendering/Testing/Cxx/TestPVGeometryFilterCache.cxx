@@ -0,0 +1,272 @@
+/*=========================================================================
+
+  Program:   ParaView
+  Module:    TestPVGeometryFilterCache.cxx
+
+  Copyright (c) Kitware, Inc.
+  All rights reserved.
+  See Copyright.txt or http://www.paraview.org/HTML/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// Checks that vtkPVGeometryFilter reuses the surface of an unstructured grid
+// whose mesh did not change, and that executing the blocks of a multiblock
+// dataset concurrently gives the same result as executing them in turn.
+#include "vtkCellArray.h"
+#include "vtkCellData.h"
+#include "vtkDoubleArray.h"
+#include "vtkMultiBlockDataSet.h"
+#include "vtkNew.h"
+#include "vtkPVGeometryFilter.h"
+#include "vtkPointData.h"
+#include "vtkPoints.h"
+#include "vtkPolyData.h"
+#include "vtkSmartPointer.h"
+#include "vtkUnstructuredGrid.h"
+
+#include <cstdlib>
+
+namespace
+{
+// A grid of n^3 hexahedra with a point and a cell array.
+void MakeGrid(vtkUnstructuredGrid* grid, int n, double offset)
+{
+  vtkNew<vtkPoints> points;
+  for (int k = 0; k <= n; ++k)
+  {
+    for (int j = 0; j <= n; ++j)
+    {
+      for (int i = 0; i <= n; ++i)
+      {
+        points->InsertNextPoint(i + offset, j, k);
+      }
+    }
+  }
+  grid->SetPoints(points);
+  grid->Allocate(n * n * n);
+  const vtkIdType np = n + 1;
+  for (int k = 0; k < n; ++k)
+  {
+    for (int j = 0; j < n; ++j)
+    {
+      for (int i = 0; i < n; ++i)
+      {
+        const vtkIdType p = i + np * (j + np * k);
+        const vtkIdType ids[8] = { p, p + 1, p + 1 + np, p + np, p + np * np, p + 1 + np * np,
+          p + 1 + np + np * np, p + np + np * np };
+        grid->InsertNextCell(VTK_HEXAHEDRON, 8, ids);
+      }
+    }
+  }
+
+  vtkNew<vtkDoubleArray> pointField;
+  pointField->SetName("PointField");
+  pointField->SetNumberOfTuples(grid->GetNumberOfPoints());
+  pointField->FillValue(0.0);
+  grid->GetPointData()->AddArray(pointField);
+  vtkNew<vtkDoubleArray> cellField;
+  cellField->SetName("CellField");
+  cellField->SetNumberOfTuples(grid->GetNumberOfCells());
+  cellField->FillValue(0.0);
+  grid->GetCellData()->AddArray(cellField);
+}
+
+// Sets the fields of `grid` to `time` plus the original id.
+void SetTime(vtkUnstructuredGrid* grid, double time)
+{
+  vtkDoubleArray* pointField =
+    vtkDoubleArray::SafeDownCast(grid->GetPointData()->GetArray("PointField"));
+  for (vtkIdType cc = 0; cc < pointField->GetNumberOfTuples(); ++cc)
+  {
+    pointField->SetValue(cc, time + cc);
+  }
+  pointField->Modified();
+  vtkDoubleArray* cellField =
+    vtkDoubleArray::SafeDownCast(grid->GetCellData()->GetArray("CellField"));
+  for (vtkIdType cc = 0; cc < cellField->GetNumberOfTuples(); ++cc)
+  {
+    cellField->SetValue(cc, time + cc);
+  }
+  cellField->Modified();
+}
+
+// Returns true if the fields of `surface` match `time` at the original ids.
+bool CheckFields(vtkPolyData* surface, double time)
+{
+  vtkDataArray* pointField = surface->GetPointData()->GetArray("PointField");
+  vtkDataArray* pointIds = surface->GetPointData()->GetArray("vtkOriginalPointIds");
+  vtkDataArray* cellField = surface->GetCellData()->GetArray("CellField");
+  vtkDataArray* cellIds = surface->GetCellData()->GetArray("vtkOriginalCellIds");
+  if (!pointField || !pointIds || !cellField || !cellIds ||
+    pointField->GetNumberOfTuples() != surface->GetNumberOfPoints() ||
+    cellField->GetNumberOfTuples() != surface->GetNumberOfCells())
+  {
+    return false;
+  }
+  for (vtkIdType cc = 0; cc < surface->GetNumberOfPoints(); ++cc)
+  {
+    if (pointField->GetComponent(cc, 0) != time + pointIds->GetComponent(cc, 0))
+    {
+      return false;
+    }
+  }
+  for (vtkIdType cc = 0; cc < surface->GetNumberOfCells(); ++cc)
+  {
+    if (cellField->GetComponent(cc, 0) != time + cellIds->GetComponent(cc, 0))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+}
+
+int TestPVGeometryFilterCache(int, char* [])
+{
+  const int n = 40;
+  vtkNew<vtkUnstructuredGrid> grid;
+  MakeGrid(grid, n, 0.0);
+
+  vtkNew<vtkPVGeometryFilter> filter;
+  filter->SetUseOutline(0);
+  filter->SetInputData(grid);
+
+  // first execution extracts the surface.
+  SetTime(grid, 0.0);
+  filter->Update();
+  vtkPolyData* surface = vtkPolyData::SafeDownCast(filter->GetOutputDataObject(0));
+  if (surface->GetNumberOfCells() != 6 * n * n)
+  {
+    cerr << "ERROR: wrong number of surface cells: " << surface->GetNumberOfCells() << endl;
+    return EXIT_FAILURE;
+  }
+  if (!CheckFields(surface, 0.0))
+  {
+    cerr << "ERROR: wrong fields on the extracted surface." << endl;
+    return EXIT_FAILURE;
+  }
+  // keep a reference, so that a new array cannot have the same address.
+  vtkSmartPointer<vtkCellArray> polys = surface->GetPolys();
+
+  // only the fields change: the surface is reused.
+  SetTime(grid, 10.0);
+  filter->Update();
+  surface = vtkPolyData::SafeDownCast(filter->GetOutputDataObject(0));
+  if (surface->GetPolys() != polys)
+  {
+    cerr << "ERROR: surface was not reused." << endl;
+    return EXIT_FAILURE;
+  }
+  if (!CheckFields(surface, 10.0))
+  {
+    cerr << "ERROR: wrong fields on the reused surface." << endl;
+    return EXIT_FAILURE;
+  }
+
+  // the points move: the surface is extracted again.
+  grid->GetPoints()->SetPoint(0, -1.0, -1.0, -1.0);
+  grid->GetPoints()->Modified();
+  filter->Update();
+  surface = vtkPolyData::SafeDownCast(filter->GetOutputDataObject(0));
+  if (surface->GetPolys() == polys)
+  {
+    cerr << "ERROR: surface reused after the points changed." << endl;
+    return EXIT_FAILURE;
+  }
+  if (!CheckFields(surface, 10.0))
+  {
+    cerr << "ERROR: wrong fields after the points changed." << endl;
+    return EXIT_FAILURE;
+  }
+
+  // strips are requested: the surface is extracted again.
+  polys = surface->GetPolys();
+  filter->SetUseStrips(1);
+  SetTime(grid, 15.0);
+  filter->Update();
+  surface = vtkPolyData::SafeDownCast(filter->GetOutputDataObject(0));
+  if (surface->GetPolys() == polys)
+  {
+    cerr << "ERROR: surface reused after strips were requested." << endl;
+    return EXIT_FAILURE;
+  }
+  if (!CheckFields(surface, 15.0))
+  {
+    cerr << "ERROR: wrong fields after strips were requested." << endl;
+    return EXIT_FAILURE;
+  }
+  filter->SetUseStrips(0);
+
+  // no cache: the surface is extracted every time.
+  filter->CacheSurfacesOff();
+  polys = surface->GetPolys();
+  SetTime(grid, 20.0);
+  filter->Update();
+  surface = vtkPolyData::SafeDownCast(filter->GetOutputDataObject(0));
+  if (surface->GetPolys() == polys)
+  {
+    cerr << "ERROR: surface reused while caching is off." << endl;
+    return EXIT_FAILURE;
+  }
+  if (!CheckFields(surface, 20.0))
+  {
+    cerr << "ERROR: wrong fields while caching is off." << endl;
+    return EXIT_FAILURE;
+  }
+
+  // blocks executed concurrently or in turn.
+  const unsigned int numBlocks = 8;
+  vtkNew<vtkMultiBlockDataSet> mb;
+  mb->SetNumberOfBlocks(numBlocks);
+  for (unsigned int cc = 0; cc < numBlocks; ++cc)
+  {
+    vtkNew<vtkUnstructuredGrid> block;
+    MakeGrid(block, 10 + cc, 20.0 * cc);
+    SetTime(block, cc);
+    mb->SetBlock(cc, block);
+  }
+  vtkNew<vtkPVGeometryFilter> serial;
+  serial->SetUseOutline(0);
+  serial->ExecuteBlocksConcurrentlyOff();
+  serial->SetInputData(mb);
+  serial->Update();
+  vtkNew<vtkPVGeometryFilter> concurrent;
+  concurrent->SetUseOutline(0);
+  concurrent->SetInputData(mb);
+  concurrent->Update();
+  vtkMultiBlockDataSet* serialOutput =
+    vtkMultiBlockDataSet::SafeDownCast(serial->GetOutputDataObject(0));
+  vtkMultiBlockDataSet* concurrentOutput =
+    vtkMultiBlockDataSet::SafeDownCast(concurrent->GetOutputDataObject(0));
+  if (!serialOutput || !concurrentOutput)
+  {
+    cerr << "ERROR: missing multiblock outputs." << endl;
+    return EXIT_FAILURE;
+  }
+  for (unsigned int cc = 0; cc < numBlocks; ++cc)
+  {
+    vtkPolyData* expected = vtkPolyData::SafeDownCast(serialOutput->GetBlock(cc));
+    vtkPolyData* block = vtkPolyData::SafeDownCast(concurrentOutput->GetBlock(cc));
+    if (!expected || !block)
+    {
+      cerr << "ERROR: missing block " << cc << endl;
+      return EXIT_FAILURE;
+    }
+    if (block->GetNumberOfPoints() != expected->GetNumberOfPoints() ||
+      block->GetNumberOfCells() != expected->GetNumberOfCells() ||
+      block->GetNumberOfCells() != static_cast<vtkIdType>(6 * (10 + cc) * (10 + cc)))
+    {
+      cerr << "ERROR: blocks " << cc << " differ." << endl;
+      return EXIT_FAILURE;
+    }
+    if (!CheckFields(block, cc))
+    {
+      cerr << "ERROR: wrong fields on block " << cc << endl;
+      return EXIT_FAILURE;
+    }
+  }
+  return EXIT_SUCCESS;
+}
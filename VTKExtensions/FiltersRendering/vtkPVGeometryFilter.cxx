@@ -40,6 +40,8 @@
 #include "vtkHierarchicalBoxDataSet.h"
 #include "vtkHyperTreeGrid.h"
 #include "vtkHyperTreeGridGeometry.h"
+#include "vtkIdList.h"
+#include "vtkIdTypeArray.h"
 #include "vtkImageData.h"
 #include "vtkInformation.h"
 #include "vtkInformationIntegerVectorKey.h"
@@ -54,10 +56,13 @@
 #include "vtkPVRecoverGeometryWireframe.h"
 #include "vtkPVTrivialProducer.h"
 #include "vtkPointData.h"
+#include "vtkPoints.h"
 #include "vtkPolyData.h"
 #include "vtkPolygon.h"
 #include "vtkRectilinearGrid.h"
 #include "vtkRectilinearGridOutlineFilter.h"
+#include "vtkSMPThreadLocalObject.h"
+#include "vtkSMPTools.h"
 #include "vtkSelectionNode.h"
 #include "vtkSmartPointer.h"
 #include "vtkStreamingDemandDrivenPipeline.h"
@@ -150,6 +155,225 @@ public:
   int Commutative() override { return 1; }
 };
 
+//----------------------------------------------------------------------------
+// The external surface of an unstructured grid, kept with what it was
+// extracted from so that it can be reused while the mesh does not change.
+class vtkPVGeometryFilter::SurfaceCache
+{
+public:
+  bool IsValid(vtkUnstructuredGrid* input, int nonlinearSubdivisionLevel, int useStrips) const
+  {
+    return this->Surface != nullptr &&
+      this->NonlinearSubdivisionLevel == nonlinearSubdivisionLevel &&
+      this->UseStrips == useStrips &&
+      this->Points.IsValid(input->GetPoints()) && this->Cells.IsValid(input->GetCells()) &&
+      this->CellTypes.IsValid(input->GetCellTypesArray()) &&
+      this->Faces.IsValid(input->GetFaces()) &&
+      this->Ghosts.IsValid(input->GetCellData()->GetArray(vtkDataSetAttributes::GhostArrayName()));
+  }
+
+  // Keeps the surface extracted in `output`, which must have the
+  // vtkOriginalPointIds and vtkOriginalCellIds arrays. These arrays are removed
+  // from `output` unless requested.
+  void Store(vtkUnstructuredGrid* input, vtkPolyData* output, int nonlinearSubdivisionLevel,
+    int useStrips, bool passThroughPointIds, bool passThroughCellIds)
+  {
+    this->Clear();
+    vtkPointData* outPD = output->GetPointData();
+    vtkCellData* outCD = output->GetCellData();
+    vtkIdTypeArray* pointIds = vtkIdTypeArray::SafeDownCast(outPD->GetArray("vtkOriginalPointIds"));
+    vtkIdTypeArray* cellIds = vtkIdTypeArray::SafeDownCast(outCD->GetArray("vtkOriginalCellIds"));
+
+    // Points created by the surface filter (e.g. when subdividing nonlinear
+    // cells) cannot be passed by id, such surfaces are not cached.
+    if (pointIds && cellIds && SurfaceCache::IsMap(pointIds) && SurfaceCache::IsMap(cellIds))
+    {
+      this->Surface = vtkSmartPointer<vtkPolyData>::New();
+      this->Surface->CopyStructure(output);
+      this->OriginalPointIds = pointIds;
+      this->OriginalCellIds = cellIds;
+      SurfaceCache::MakeIdLists(pointIds, this->PointIds, this->OutputPointIds);
+      SurfaceCache::MakeIdLists(cellIds, this->CellIds, this->OutputCellIds);
+      this->NonlinearSubdivisionLevel = nonlinearSubdivisionLevel;
+      this->UseStrips = useStrips;
+      this->Points.Set(input->GetPoints());
+      this->Cells.Set(input->GetCells());
+      this->CellTypes.Set(input->GetCellTypesArray());
+      this->Faces.Set(input->GetFaces());
+      this->Ghosts.Set(input->GetCellData()->GetArray(vtkDataSetAttributes::GhostArrayName()));
+    }
+
+    if (!passThroughPointIds)
+    {
+      outPD->RemoveArray("vtkOriginalPointIds");
+    }
+    if (!passThroughCellIds)
+    {
+      outCD->RemoveArray("vtkOriginalCellIds");
+    }
+  }
+
+  // Fills `output` with the cached surface and the attributes of `input`.
+  void Restore(vtkUnstructuredGrid* input, vtkPolyData* output, bool passThroughPointIds,
+    bool passThroughCellIds)
+  {
+    output->CopyStructure(this->Surface);
+
+    vtkPointData* outPD = output->GetPointData();
+    outPD->CopyGlobalIdsOn();
+    outPD->CopyAllocate(input->GetPointData(), this->PointIds->GetNumberOfIds());
+    outPD->CopyData(input->GetPointData(), this->PointIds, this->OutputPointIds);
+    if (passThroughPointIds)
+    {
+      outPD->AddArray(this->OriginalPointIds);
+    }
+
+    vtkCellData* outCD = output->GetCellData();
+    outCD->CopyGlobalIdsOn();
+    outCD->CopyAllocate(input->GetCellData(), this->CellIds->GetNumberOfIds());
+    outCD->CopyData(input->GetCellData(), this->CellIds, this->OutputCellIds);
+    if (passThroughCellIds)
+    {
+      outCD->AddArray(this->OriginalCellIds);
+    }
+  }
+
+  void Clear()
+  {
+    this->Surface = nullptr;
+    this->OriginalPointIds = nullptr;
+    this->OriginalCellIds = nullptr;
+    this->PointIds = nullptr;
+    this->OutputPointIds = nullptr;
+    this->CellIds = nullptr;
+    this->OutputCellIds = nullptr;
+    this->Points.Set(nullptr);
+    this->Cells.Set(nullptr);
+    this->CellTypes.Set(nullptr);
+    this->Faces.Set(nullptr);
+    this->Ghosts.Set(nullptr);
+  }
+
+private:
+  // An object of the input mesh and its modification time. The object is
+  // referenced so that a new object cannot be mistaken for it.
+  struct MeshPart
+  {
+    vtkSmartPointer<vtkObject> Object;
+    vtkMTimeType MTime = 0;
+
+    void Set(vtkObject* object)
+    {
+      this->Object = object;
+      this->MTime = object ? object->GetMTime() : 0;
+    }
+    bool IsValid(vtkObject* object) const
+    {
+      return this->Object == object && (!object || object->GetMTime() == this->MTime);
+    }
+  };
+
+  static bool IsMap(vtkIdTypeArray* ids)
+  {
+    const vtkIdType* ptr = ids->GetPointer(0);
+    return std::find_if(ptr, ptr + ids->GetNumberOfTuples(), [](vtkIdType id) { return id < 0; }) ==
+      ptr + ids->GetNumberOfTuples();
+  }
+
+  static void MakeIdLists(
+    vtkIdTypeArray* ids, vtkSmartPointer<vtkIdList>& from, vtkSmartPointer<vtkIdList>& to)
+  {
+    const vtkIdType numIds = ids->GetNumberOfTuples();
+    from = vtkSmartPointer<vtkIdList>::New();
+    from->SetNumberOfIds(numIds);
+    std::copy(ids->GetPointer(0), ids->GetPointer(0) + numIds, from->GetPointer(0));
+    to = vtkSmartPointer<vtkIdList>::New();
+    to->SetNumberOfIds(numIds);
+    for (vtkIdType cc = 0; cc < numIds; ++cc)
+    {
+      to->SetId(cc, cc);
+    }
+  }
+
+  vtkSmartPointer<vtkPolyData> Surface;
+  vtkSmartPointer<vtkIdTypeArray> OriginalPointIds;
+  vtkSmartPointer<vtkIdTypeArray> OriginalCellIds;
+  vtkSmartPointer<vtkIdList> PointIds;
+  vtkSmartPointer<vtkIdList> OutputPointIds;
+  vtkSmartPointer<vtkIdList> CellIds;
+  vtkSmartPointer<vtkIdList> OutputCellIds;
+  int NonlinearSubdivisionLevel = 0;
+  int UseStrips = 0;
+  MeshPart Points;
+  MeshPart Cells;
+  MeshPart CellTypes;
+  MeshPart Faces;
+  MeshPart Ghosts;
+};
+
+//----------------------------------------------------------------------------
+class vtkPVGeometryFilter::vtkInternals
+{
+public:
+  // Surface caches, indexed by the flat index of the block (0 for a dataset).
+  std::map<unsigned int, vtkPVGeometryFilter::SurfaceCache> SurfaceCaches;
+
+  // Forgets about the blocks that are not in `indices`.
+  void PruneSurfaceCaches(const std::set<unsigned int>& indices)
+  {
+    for (auto iter = this->SurfaceCaches.begin(); iter != this->SurfaceCaches.end();)
+    {
+      if (indices.find(iter->first) == indices.end())
+      {
+        iter = this->SurfaceCaches.erase(iter);
+      }
+      else
+      {
+        ++iter;
+      }
+    }
+  }
+};
+
+//----------------------------------------------------------------------------
+// Executes blocks of a composite dataset concurrently. Each thread uses its
+// own vtkPVGeometryFilter, with the settings of the filter being executed,
+// since the internal filters cannot be shared.
+class vtkPVGeometryFilter::ExecuteBlocksFunctor
+{
+public:
+  vtkPVGeometryFilter* Self;
+  const std::vector<vtkDataObject*>* Blocks;
+  const std::vector<vtkPVGeometryFilter::SurfaceCache*>* Caches;
+  std::vector<vtkSmartPointer<vtkPolyData> >* Outputs;
+  const int* WholeExtent;
+  vtkSMPThreadLocalObject<vtkPVGeometryFilter> Workers;
+
+  void Initialize() { this->Self->CopyBlockSettings(this->Workers.Local()); }
+
+  void operator()(vtkIdType begin, vtkIdType end)
+  {
+    vtkPVGeometryFilter* worker = this->Workers.Local();
+    for (vtkIdType cc = begin; cc < end; ++cc)
+    {
+      vtkNew<vtkPolyData> output;
+      worker->CurrentSurfaceCache = (*this->Caches)[cc];
+      worker->ExecuteBlock((*this->Blocks)[cc], output, 0, 0, 1, 0, this->WholeExtent);
+      worker->CleanupOutputData(output, 0);
+      worker->CurrentSurfaceCache = nullptr;
+      (*this->Outputs)[cc] = output.Get();
+    }
+  }
+
+  void Reduce()
+  {
+    for (auto iter = this->Workers.begin(); iter != this->Workers.end(); ++iter)
+    {
+      this->Self->OutlineFlag = this->Self->OutlineFlag || (*iter)->OutlineFlag;
+    }
+  }
+};
+
 //----------------------------------------------------------------------------
 vtkPVGeometryFilter::vtkPVGeometryFilter()
 {
@@ -195,6 +419,11 @@ vtkPVGeometryFilter::vtkPVGeometryFilter()
 
   this->HideInternalAMRFaces = true;
   this->UseNonOverlappingAMRMetaDataForOutlines = true;
+
+  this->CacheSurfaces = true;
+  this->ExecuteBlocksConcurrently = true;
+  this->Internals = new vtkInternals();
+  this->CurrentSurfaceCache = nullptr;
 }
 
 //----------------------------------------------------------------------------
@@ -232,6 +461,24 @@ vtkPVGeometryFilter::~vtkPVGeometryFilter()
   }
   this->OutlineSource->Delete();
   this->SetController(0);
+  delete this->Internals;
+}
+
+//----------------------------------------------------------------------------
+void vtkPVGeometryFilter::CopyBlockSettings(vtkPVGeometryFilter* worker)
+{
+  worker->SetController(this->Controller);
+  worker->UseOutline = this->UseOutline;
+  worker->GenerateFeatureEdges = this->GenerateFeatureEdges;
+  worker->GenerateCellNormals = this->GenerateCellNormals;
+  worker->GenerateProcessIds = this->GenerateProcessIds;
+  worker->Triangulate = this->Triangulate;
+  worker->UseStrips = this->UseStrips;
+  worker->DataSetSurfaceFilter->SetUseStrips(this->UseStrips);
+  worker->SetNonlinearSubdivisionLevel(this->NonlinearSubdivisionLevel);
+  worker->SetPassThroughCellIds(this->PassThroughCellIds);
+  worker->SetPassThroughPointIds(this->PassThroughPointIds);
+  worker->OutlineFlag = 0;
 }
 
 //----------------------------------------------------------------------------
@@ -579,7 +826,11 @@ int vtkPVGeometryFilter::RequestData(
   }
   int* wholeExtent =
     vtkStreamingDemandDrivenPipeline::GetWholeExtent(inputVector[0]->GetInformationObject(0));
+  this->Internals->PruneSurfaceCaches(
+    this->CacheSurfaces ? std::set<unsigned int>{ 0 } : std::set<unsigned int>());
+  this->CurrentSurfaceCache = this->CacheSurfaces ? &this->Internals->SurfaceCaches[0] : nullptr;
   this->ExecuteBlock(input, output, 1, procid, numProcs, 0, wholeExtent);
+  this->CurrentSurfaceCache = nullptr;
   this->CleanupOutputData(output, 1);
   return 1;
 }
@@ -937,45 +1188,81 @@ int vtkPVGeometryFilter::RequestDataObjectTree(
   inIter->VisitOnlyLeavesOn();
   inIter->SkipEmptyNodesOn();
 
-  // get a block count for progress scaling.
-  unsigned int totNumBlocks = 0;
+  // collect the blocks first, they may be executed concurrently.
+  std::vector<vtkDataObject*> blocks;
+  std::vector<unsigned int> flatIndices;
   for (inIter->InitTraversal(); !inIter->IsDoneWithTraversal(); inIter->GoToNextItem())
   {
-    ++totNumBlocks;
+    if (vtkDataObject* block = inIter->GetCurrentDataObject())
+    {
+      blocks.push_back(block);
+      flatIndices.push_back(inIter->GetCurrentFlatIndex());
+    }
+  }
+  const unsigned int totNumBlocks = static_cast<unsigned int>(blocks.size());
+
+  // the caches are created up front since the map cannot be modified
+  // concurrently.
+  std::vector<SurfaceCache*> caches(blocks.size(), nullptr);
+  this->Internals->PruneSurfaceCaches(
+    this->CacheSurfaces ? std::set<unsigned int>(flatIndices.begin(), flatIndices.end())
+                        : std::set<unsigned int>());
+  if (this->CacheSurfaces)
+  {
+    for (size_t cc = 0; cc < blocks.size(); ++cc)
+    {
+      caches[cc] = &this->Internals->SurfaceCaches[flatIndices[cc]];
+    }
   }
 
   int* wholeExtent =
     vtkStreamingDemandDrivenPipeline::GetWholeExtent(inputVector[0]->GetInformationObject(0));
-  int numInputs = 0;
+  std::vector<vtkSmartPointer<vtkPolyData> > outputs(blocks.size());
+  if (this->ExecuteBlocksConcurrently && blocks.size() > 1 &&
+    vtkSMPTools::GetEstimatedNumberOfThreads() > 1)
+  {
+    ExecuteBlocksFunctor functor;
+    functor.Self = this;
+    functor.Blocks = &blocks;
+    functor.Caches = &caches;
+    functor.Outputs = &outputs;
+    functor.WholeExtent = wholeExtent;
+    this->OutlineFlag = 0;
+    vtkSMPTools::For(0, static_cast<vtkIdType>(blocks.size()), 1, functor);
+    this->UpdateProgress(1.0);
+  }
+  else
+  {
+    for (size_t cc = 0; cc < blocks.size(); ++cc)
+    {
+      outputs[cc] = vtkSmartPointer<vtkPolyData>::New();
+      this->CurrentSurfaceCache = caches[cc];
+      this->ExecuteBlock(blocks[cc], outputs[cc], 0, 0, 1, 0, wholeExtent);
+      this->CurrentSurfaceCache = nullptr;
+      this->CleanupOutputData(outputs[cc], 0);
+      this->UpdateProgress(static_cast<float>(cc + 1) / totNumBlocks);
+    }
+  }
+
+  size_t blockIdx = 0;
   for (inIter->InitTraversal(); !inIter->IsDoneWithTraversal(); inIter->GoToNextItem())
   {
-    vtkDataObject* block = inIter->GetCurrentDataObject();
-    if (!block)
+    if (!inIter->GetCurrentDataObject())
     {
       continue;
     }
 
-    vtkPolyData* tmpOut = vtkPolyData::New();
-    this->ExecuteBlock(block, tmpOut, 0, 0, 1, 0, wholeExtent);
-    this->CleanupOutputData(tmpOut, 0);
     // skip empty nodes.
+    vtkPolyData* tmpOut = outputs[blockIdx++];
     if (tmpOut->GetNumberOfPoints() > 0)
     {
       output->SetDataSet(inIter, tmpOut);
-      tmpOut->FastDelete();
 
       const unsigned int current_flat_index = inIter->GetCurrentFlatIndex();
       this->AddCompositeIndex(tmpOut, current_flat_index);
     }
-    else
-    {
-      tmpOut->Delete();
-      tmpOut = NULL;
-    }
-
-    numInputs++;
-    this->UpdateProgress(static_cast<float>(numInputs) / totNumBlocks);
   }
+  outputs.clear();
   vtkTimerLog::MarkEndEvent("vtkPVGeometryFilter::ExecuteCompositeDataSet");
 
   // Merge multi-pieces to avoid efficiency setbacks since multipieces can have
@@ -1391,6 +1678,16 @@ void vtkPVGeometryFilter::UnstructuredGridExecute(
   {
     this->OutlineFlag = 0;
 
+    // The surface of a vtkUnstructuredGrid may be reused when its mesh did not
+    // change. Surfaces that are triangulated or subdivided are not cached.
+    vtkUnstructuredGrid* ugrid = vtkUnstructuredGrid::SafeDownCast(input);
+    SurfaceCache* cache = (ugrid && !this->Triangulate) ? this->CurrentSurfaceCache : nullptr;
+    if (cache && cache->IsValid(ugrid, this->NonlinearSubdivisionLevel, this->UseStrips))
+    {
+      cache->Restore(ugrid, output, this->PassThroughPointIds != 0, this->PassThroughCellIds != 0);
+      return;
+    }
+
     bool handleSubdivision = (this->Triangulate != 0) && (input->GetNumberOfCells() > 0);
     if (!handleSubdivision && (this->NonlinearSubdivisionLevel > 0))
     {
@@ -1472,9 +1769,27 @@ void vtkPVGeometryFilter::UnstructuredGridExecute(
       }
     }
 
+    if (cache)
+    {
+      cache->Clear();
+    }
     if (input->GetNumberOfCells() > 0)
     {
+      // the original ids are needed to reuse the surface.
+      const bool storeSurface = cache && !handleSubdivision;
+      if (storeSurface)
+      {
+        this->DataSetSurfaceFilter->PassThroughPointIdsOn();
+        this->DataSetSurfaceFilter->PassThroughCellIdsOn();
+      }
       this->DataSetSurfaceFilter->UnstructuredGridExecute(input, output);
+      if (storeSurface)
+      {
+        this->DataSetSurfaceFilter->SetPassThroughPointIds(this->PassThroughPointIds);
+        this->DataSetSurfaceFilter->SetPassThroughCellIds(this->PassThroughCellIds);
+        cache->Store(ugrid, output, this->NonlinearSubdivisionLevel, this->UseStrips,
+          this->PassThroughPointIds != 0, this->PassThroughCellIds != 0);
+      }
     }
 
     if (this->Triangulate && (output->GetNumberOfPolys() > 0))
@@ -1781,6 +2096,8 @@ void vtkPVGeometryFilter::PrintSelf(ostream& os, vtkIndent indent)
 
   os << indent << "PassThroughCellIds: " << (this->PassThroughCellIds ? "On\n" : "Off\n");
   os << indent << "PassThroughPointIds: " << (this->PassThroughPointIds ? "On\n" : "Off\n");
+  os << indent << "CacheSurfaces: " << this->CacheSurfaces << endl;
+  os << indent << "ExecuteBlocksConcurrently: " << this->ExecuteBlocksConcurrently << endl;
 }
 
 //----------------------------------------------------------------------------
@@ -207,6 +207,30 @@ public:
   vtkBooleanMacro(UseNonOverlappingAMRMetaDataForOutlines, bool);
   //@}
 
+  //@{
+  /**
+   * When set to true (default), the external surface extracted from an
+   * unstructured grid is kept and reused on the next execution if the points,
+   * cells and ghost cells of the grid, the NonlinearSubdivisionLevel and the
+   * UseStrips setting have not been modified, e.g. for a static mesh with time
+   * varying fields. Only the point and cell data are then passed again, through
+   * the cached original point and cell ids.
+   */
+  vtkSetMacro(CacheSurfaces, bool);
+  vtkGetMacro(CacheSurfaces, bool);
+  vtkBooleanMacro(CacheSurfaces, bool);
+  //@}
+
+  //@{
+  /**
+   * When set to true (default), the blocks of a multiblock dataset are
+   * processed concurrently using vtkSMPTools.
+   */
+  vtkSetMacro(ExecuteBlocksConcurrently, bool);
+  vtkGetMacro(ExecuteBlocksConcurrently, bool);
+  vtkBooleanMacro(ExecuteBlocksConcurrently, bool);
+  //@}
+
   // These keys are put in the output composite-data metadata for multipieces
   // since this filter merges multipieces together.
   static vtkInformationIntegerVectorKey* POINT_OFFSETS();
@@ -331,6 +355,8 @@ protected:
   bool HideInternalAMRFaces;
   bool UseNonOverlappingAMRMetaDataForOutlines;
   bool GenerateFeatureEdges;
+  bool CacheSurfaces;
+  bool ExecuteBlocksConcurrently;
 
 private:
   vtkPVGeometryFilter(const vtkPVGeometryFilter&) = delete;
@@ -348,6 +374,19 @@ private:
   void AddHierarchicalIndex(vtkPolyData* pd, unsigned int level, unsigned int index);
   class BoundsReductionOperation;
   //@}
+
+  /**
+   * Copies the settings that affect the geometry of a block to \c worker.
+   */
+  void CopyBlockSettings(vtkPVGeometryFilter* worker);
+
+  class ExecuteBlocksFunctor;
+  class SurfaceCache;
+  class vtkInternals;
+  vtkInternals* Internals;
+
+  // Cache of the block being executed, nullptr if surfaces are not cached.
+  SurfaceCache* CurrentSurfaceCache;
 };
 
 #endif
@@ -0,0 +1,298 @@
+/*=========================================================================
+
+  Program:   ParaView
+  Module:    TestCSVWriterFormatting.cxx
+
+  Copyright (c) Kitware, Inc.
+  All rights reserved.
+  See Copyright.txt or http://www.paraview.org/HTML/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// Checks that vtkCSVWriter writes the same bytes as formatting every value
+// with an ostream, for all precisions and notations. Pass "--benchmark" to
+// also report the throughput of both, and "--rows N" to use a larger table,
+// e.g. the 10M rows x 20 columns case.
+#include "vtkCSVWriter.h"
+#include "vtkCharArray.h"
+#include "vtkDoubleArray.h"
+#include "vtkFloatArray.h"
+#include "vtkIdTypeArray.h"
+#include "vtkIntArray.h"
+#include "vtkLongLongArray.h"
+#include "vtkMath.h"
+#include "vtkNew.h"
+#include "vtkSMPTools.h"
+#include "vtkStringArray.h"
+#include "vtkTable.h"
+#include "vtkTestUtilities.h"
+#include "vtkTimerLog.h"
+#include "vtkUnsignedCharArray.h"
+#include "vtkUnsignedLongLongArray.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <string>
+
+#include <vtksys/CommandLineArguments.hxx>
+
+namespace
+{
+// Writes a value the way vtkCSVWriter used to, with an ostream.
+template <class T>
+void WriteValue(ostream& os, T value)
+{
+  os << value;
+}
+void WriteValue(ostream& os, char value)
+{
+  os << static_cast<int>(value);
+}
+void WriteValue(ostream& os, unsigned char value)
+{
+  os << static_cast<int>(value);
+}
+
+// The reference: the table formatted one value at a time by an ostream.
+std::string Reference(vtkTable* table, bool scientific, int precision)
+{
+  std::ostringstream os;
+  for (vtkIdType col = 0; col < table->GetNumberOfColumns(); ++col)
+  {
+    vtkAbstractArray* array = table->GetColumn(col);
+    for (int comp = 0; comp < array->GetNumberOfComponents(); ++comp)
+    {
+      os << (col + comp > 0 ? "," : "") << "\"" << array->GetName();
+      if (array->GetNumberOfComponents() > 1)
+      {
+        os << ":" << comp;
+      }
+      os << "\"";
+    }
+  }
+  os << "\n";
+  if (scientific)
+  {
+    os << std::scientific;
+  }
+  os << std::setprecision(precision);
+
+  for (vtkIdType row = 0; row < table->GetNumberOfRows(); ++row)
+  {
+    bool first = true;
+    for (vtkIdType col = 0; col < table->GetNumberOfColumns(); ++col)
+    {
+      vtkAbstractArray* array = table->GetColumn(col);
+      for (int comp = 0; comp < array->GetNumberOfComponents(); ++comp)
+      {
+        os << (first ? "" : ",");
+        first = false;
+        const vtkIdType idx = row * array->GetNumberOfComponents() + comp;
+        if (auto strings = vtkStringArray::SafeDownCast(array))
+        {
+          os << "\"" << strings->GetValue(idx) << "\"";
+        }
+        else
+        {
+          switch (array->GetDataType())
+          {
+            vtkTemplateMacro(
+              WriteValue(os, static_cast<VTK_TT*>(array->GetVoidPointer(0))[idx]));
+          }
+        }
+      }
+    }
+    os << "\n";
+  }
+  return os.str();
+}
+
+std::string ReadFile(const std::string& fname)
+{
+  std::ifstream ifs(fname.c_str(), ios::in | ios::binary);
+  std::ostringstream contents;
+  contents << ifs.rdbuf();
+  return contents.str();
+}
+
+// A table with all the special cases: extreme values, nan, inf, chars,
+// strings and multi-component arrays.
+void MakeMixedTable(vtkTable* table)
+{
+  const vtkIdType numRows = 50000;
+  vtkNew<vtkDoubleArray> doubles;
+  doubles->SetName("double");
+  doubles->SetNumberOfTuples(numRows);
+  vtkNew<vtkFloatArray> floats;
+  floats->SetName("float");
+  floats->SetNumberOfComponents(3);
+  floats->SetNumberOfTuples(numRows);
+  vtkNew<vtkIntArray> ints;
+  ints->SetName("int");
+  ints->SetNumberOfTuples(numRows);
+  vtkNew<vtkIdTypeArray> ids;
+  ids->SetName("id");
+  ids->SetNumberOfTuples(numRows);
+  vtkNew<vtkLongLongArray> longs;
+  longs->SetName("longlong");
+  longs->SetNumberOfTuples(numRows);
+  vtkNew<vtkUnsignedLongLongArray> ulongs;
+  ulongs->SetName("ulonglong");
+  ulongs->SetNumberOfTuples(numRows);
+  vtkNew<vtkCharArray> chars;
+  chars->SetName("char");
+  chars->SetNumberOfTuples(numRows);
+  vtkNew<vtkUnsignedCharArray> uchars;
+  uchars->SetName("uchar");
+  uchars->SetNumberOfTuples(numRows);
+  vtkNew<vtkStringArray> strings;
+  strings->SetName("string");
+  strings->SetNumberOfTuples(numRows);
+
+  const double specials[] = { 0.0, -0.0, vtkMath::Nan(), vtkMath::Inf(), vtkMath::NegInf(),
+    std::numeric_limits<double>::max(), std::numeric_limits<double>::min(),
+    std::numeric_limits<double>::denorm_min(), 1e-5, 99999.5, 123456789.0, -0.5 };
+  const int numSpecials = static_cast<int>(sizeof(specials) / sizeof(specials[0]));
+  for (vtkIdType row = 0; row < numRows; ++row)
+  {
+    const double value = row < numSpecials ? specials[row]
+                                           : std::sin(0.37 * row) * std::pow(10.0, row % 41 - 20);
+    doubles->SetValue(row, value);
+    for (int comp = 0; comp < 3; ++comp)
+    {
+      floats->SetTypedComponent(row, comp, static_cast<float>(value * (comp + 1)));
+    }
+    ints->SetValue(row, row % 2 ? static_cast<int>(-row * 7919) : std::numeric_limits<int>::min());
+    ids->SetValue(row, row * 1000003);
+    longs->SetValue(row, row % 3 ? -row : std::numeric_limits<long long>::min());
+    ulongs->SetValue(row, std::numeric_limits<unsigned long long>::max() - row);
+    chars->SetValue(row, static_cast<char>(row % 256 - 128));
+    uchars->SetValue(row, static_cast<unsigned char>(row % 256));
+    strings->SetValue(row, "row " + std::to_string(row));
+  }
+  table->AddColumn(doubles);
+  table->AddColumn(floats);
+  table->AddColumn(ints);
+  table->AddColumn(ids);
+  table->AddColumn(longs);
+  table->AddColumn(ulongs);
+  table->AddColumn(chars);
+  table->AddColumn(uchars);
+  table->AddColumn(strings);
+}
+}
+
+int TestCSVWriterFormatting(int argc, char* argv[])
+{
+  char* tempDir =
+    vtkTestUtilities::GetArgOrEnvOrDefault("-T", argc, argv, "VTK_TEMP_DIR", "Testing/Temporary");
+  if (!tempDir)
+  {
+    cerr << "Could not determine temporary directory.\n";
+    return EXIT_FAILURE;
+  }
+  const std::string fname = std::string(tempDir) + "/TestCSVWriterFormatting.csv";
+  delete[] tempDir;
+
+  bool benchmark = false;
+  int numRows = 200000;
+  vtksys::CommandLineArguments arg;
+  arg.Initialize(argc, argv);
+  typedef vtksys::CommandLineArguments argT;
+  arg.AddBooleanArgument("--benchmark", &benchmark, "Report the throughput.");
+  arg.AddArgument("--rows", argT::SPACE_ARGUMENT, &numRows, "Number of rows of the large table.");
+  arg.StoreUnusedArguments(true);
+  if (!arg.Parse())
+  {
+    cerr << "ERROR: Problem parsing arguments." << endl;
+    return EXIT_FAILURE;
+  }
+
+  vtkNew<vtkCSVWriter> writer;
+  writer->SetController(nullptr);
+  writer->SetFileName(fname.c_str());
+
+  // same bytes as an ostream.
+  vtkNew<vtkTable> mixed;
+  MakeMixedTable(mixed);
+  writer->SetInputDataObject(mixed);
+  const int precisions[] = { 0, 1, 5, 17, 40 };
+  for (int scientific = 0; scientific < 2; ++scientific)
+  {
+    for (int precision : precisions)
+    {
+      writer->SetUseScientificNotation(scientific != 0);
+      writer->SetPrecision(precision);
+      writer->Write();
+      if (ReadFile(fname) != Reference(mixed, scientific != 0, precision))
+      {
+        cerr << "ERROR: output differs from an ostream with precision " << precision
+             << (scientific ? " (scientific)" : "") << endl;
+        return EXIT_FAILURE;
+      }
+    }
+  }
+
+  // throughput on a large table of doubles.
+  const int numColumns = 20;
+  vtkNew<vtkTable> table;
+  for (int col = 0; col < numColumns; ++col)
+  {
+    vtkNew<vtkDoubleArray> column;
+    column->SetName(("column" + std::to_string(col)).c_str());
+    column->SetNumberOfTuples(numRows);
+    for (vtkIdType row = 0; row < numRows; ++row)
+    {
+      column->SetValue(row, std::sin(0.001 * row + col) * (col + 1) * 1000.0);
+    }
+    table->AddColumn(column);
+  }
+  writer->SetInputDataObject(table);
+  writer->SetUseScientificNotation(true);
+  writer->SetPrecision(5);
+
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  const std::string reference = Reference(table, true, 5);
+  {
+    std::ofstream ofs(fname.c_str(), ios::out | ios::binary);
+    ofs.write(reference.data(), static_cast<std::streamsize>(reference.size()));
+  }
+  timer->StopTimer();
+  const double referenceTime = timer->GetElapsedTime();
+
+  const int numThreads = vtkSMPTools::GetEstimatedNumberOfThreads();
+  const int threads[2] = { 1, numThreads };
+  double times[2];
+  for (int cc = 0; cc < 2; ++cc)
+  {
+    vtkSMPTools::Initialize(threads[cc]);
+    timer->StartTimer();
+    writer->Write();
+    timer->StopTimer();
+    times[cc] = timer->GetElapsedTime();
+    if (ReadFile(fname) != reference)
+    {
+      cerr << "ERROR: large table differs on " << threads[cc] << " threads." << endl;
+      return EXIT_FAILURE;
+    }
+  }
+  vtkSMPTools::Initialize(numThreads);
+
+  if (benchmark)
+  {
+    const double megabytes = reference.size() / (1024.0 * 1024.0);
+    cout << numRows << " rows x " << numColumns << " columns, " << megabytes
+         << " MB: ostream " << megabytes / referenceTime << " MB/s, writer 1 thread "
+         << megabytes / times[0] << " MB/s, " << numThreads << " threads "
+         << megabytes / times[1] << " MB/s" << endl;
+  }
+  return EXIT_SUCCESS;
+}
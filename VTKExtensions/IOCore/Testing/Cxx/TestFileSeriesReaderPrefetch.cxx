@@ -0,0 +1,329 @@
+/*=========================================================================
+
+  Program:   ParaView
+  Module:    TestFileSeriesReaderPrefetch.cxx
+
+  Copyright (c) Kitware, Inc.
+  All rights reserved.
+  See Copyright.txt or http://www.paraview.org/HTML/Copyright.html for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// Checks that vtkFileSeriesReader, with Prefetch on, reads the next time step
+// in the background, in the direction the time goes, that it still returns
+// the requested time step when the time jumps, and that the prefetched time
+// steps follow the settings of the reader. The readers log the time steps
+// they read, the test waits on the log instead of timing the reads.
+#include "vtkClientServerInterpreter.h"
+#include "vtkClientServerInterpreterInitializer.h"
+#include "vtkClientServerStream.h"
+#include "vtkFieldData.h"
+#include "vtkFileSeriesReader.h"
+#include "vtkFloatArray.h"
+#include "vtkIntArray.h"
+#include "vtkNew.h"
+#include "vtkObjectFactory.h"
+#include "vtkPointData.h"
+#include "vtkPoints.h"
+#include "vtkPolyData.h"
+#include "vtkTestUtilities.h"
+#include "vtkXMLPolyDataReader.h"
+#include "vtkXMLPolyDataWriter.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace
+{
+const int NumberOfFiles = 10;
+
+// The time steps read by the reader given to vtkFileSeriesReader, in the
+// foreground, and by the reader it creates to read ahead, in the background.
+struct ReadLog
+{
+  std::mutex Mutex;
+  std::condition_variable Condition;
+  std::vector<int> Foreground;
+  std::vector<int> Background;
+};
+ReadLog Reads;
+vtkObject* ForegroundReader = nullptr;
+}
+
+// A vtkXMLPolyDataReader that logs the time steps it reads.
+class vtkLoggingXMLPolyDataReader : public vtkXMLPolyDataReader
+{
+public:
+  static vtkLoggingXMLPolyDataReader* New();
+  vtkTypeMacro(vtkLoggingXMLPolyDataReader, vtkXMLPolyDataReader);
+
+protected:
+  vtkLoggingXMLPolyDataReader() = default;
+  ~vtkLoggingXMLPolyDataReader() override = default;
+
+  int RequestData(vtkInformation* request, vtkInformationVector** inputVector,
+    vtkInformationVector* outputVector) override
+  {
+    const int result = this->Superclass::RequestData(request, inputVector, outputVector);
+    vtkDataObject* output = vtkDataObject::GetData(outputVector);
+    vtkIntArray* step =
+      output ? vtkIntArray::SafeDownCast(output->GetFieldData()->GetArray("Step")) : nullptr;
+    {
+      std::lock_guard<std::mutex> lock(Reads.Mutex);
+      (this == ForegroundReader ? Reads.Foreground : Reads.Background)
+        .push_back(step ? step->GetValue(0) : -1);
+    }
+    Reads.Condition.notify_all();
+    return result;
+  }
+
+private:
+  vtkLoggingXMLPolyDataReader(const vtkLoggingXMLPolyDataReader&) = delete;
+  void operator=(const vtkLoggingXMLPolyDataReader&) = delete;
+};
+vtkStandardNewMacro(vtkLoggingXMLPolyDataReader);
+
+namespace
+{
+// Client-server wrapping of vtkLoggingXMLPolyDataReader::SetFileName, which is
+// how vtkFileSeriesReader sets the file names of its readers.
+int vtkLoggingXMLPolyDataReaderCommand(vtkClientServerInterpreter*, vtkObjectBase* ob,
+  const char* method, const vtkClientServerStream& msg, vtkClientServerStream& result, void*)
+{
+  const char* fileName = nullptr;
+  vtkLoggingXMLPolyDataReader* reader = vtkLoggingXMLPolyDataReader::SafeDownCast(ob);
+  if (reader && strcmp(method, "SetFileName") == 0 && msg.GetArgument(0, 2, &fileName))
+  {
+    reader->SetFileName(fileName);
+    result.Reset();
+    return 1;
+  }
+  result.Reset();
+  result << vtkClientServerStream::Error << "unexpected method" << vtkClientServerStream::End;
+  return 0;
+}
+
+void ClearReads()
+{
+  std::lock_guard<std::mutex> lock(Reads.Mutex);
+  Reads.Foreground.clear();
+  Reads.Background.clear();
+}
+
+std::vector<int> GetForegroundReads()
+{
+  std::lock_guard<std::mutex> lock(Reads.Mutex);
+  return Reads.Foreground;
+}
+
+std::vector<int> GetBackgroundReads()
+{
+  std::lock_guard<std::mutex> lock(Reads.Mutex);
+  return Reads.Background;
+}
+
+// Waits for the `count`th time step read in the background and returns it,
+// or -1 if it is not read within a minute, which only happens when no time
+// step is being read ahead.
+int WaitForBackgroundRead(size_t count)
+{
+  std::unique_lock<std::mutex> lock(Reads.Mutex);
+  if (!Reads.Condition.wait_for(lock, std::chrono::minutes(1),
+        [count]() { return Reads.Background.size() >= count; }))
+  {
+    return -1;
+  }
+  return Reads.Background[count - 1];
+}
+
+// Writes a polydata with point arrays "A" and "B" and a "Step" field holding
+// step.
+bool WriteStep(const std::string& fileName, int step)
+{
+  vtkNew<vtkPolyData> polyData;
+  vtkNew<vtkPoints> points;
+  vtkNew<vtkFloatArray> a;
+  vtkNew<vtkFloatArray> b;
+  a->SetName("A");
+  b->SetName("B");
+  for (int cc = 0; cc < 100; cc++)
+  {
+    points->InsertNextPoint(cc, step, 0);
+    a->InsertNextValue(cc);
+    b->InsertNextValue(step);
+  }
+  polyData->SetPoints(points);
+  polyData->GetPointData()->AddArray(a);
+  polyData->GetPointData()->AddArray(b);
+  vtkNew<vtkIntArray> stepArray;
+  stepArray->SetName("Step");
+  stepArray->InsertNextValue(step);
+  polyData->GetFieldData()->AddArray(stepArray);
+
+  vtkNew<vtkXMLPolyDataWriter> writer;
+  writer->SetInputData(polyData);
+  writer->SetFileName(fileName.c_str());
+  return writer->Write() != 0;
+}
+
+int GetStep(vtkFileSeriesReader* series)
+{
+  vtkDataObject* output = series->GetOutputDataObject(0);
+  vtkIntArray* step =
+    output ? vtkIntArray::SafeDownCast(output->GetFieldData()->GetArray("Step")) : nullptr;
+  return step ? step->GetValue(0) : -1;
+}
+
+bool HasPointArray(vtkFileSeriesReader* series, const char* name)
+{
+  vtkPolyData* output = vtkPolyData::SafeDownCast(series->GetOutputDataObject(0));
+  return output && output->GetPointData()->GetArray(name) != nullptr;
+}
+
+// Requests the given time steps and returns whether the right ones were
+// read. When `readAhead` is given, also checks that readAhead[cc] is read in
+// the background after steps[cc] is requested, unless it is -1.
+bool Play(vtkFileSeriesReader* series, const std::vector<int>& steps,
+  const std::vector<int>& readAhead = std::vector<int>())
+{
+  for (size_t cc = 0; cc < steps.size(); cc++)
+  {
+    size_t numberOfBackgroundReads;
+    {
+      std::lock_guard<std::mutex> lock(Reads.Mutex);
+      numberOfBackgroundReads = Reads.Background.size();
+    }
+    series->UpdateTimeStep(steps[cc]);
+    if (GetStep(series) != steps[cc])
+    {
+      cerr << "ERROR: Read step " << GetStep(series) << " instead of " << steps[cc] << "." << endl;
+      return false;
+    }
+    if (!readAhead.empty() && readAhead[cc] >= 0)
+    {
+      const int step = WaitForBackgroundRead(numberOfBackgroundReads + 1);
+      if (step != readAhead[cc])
+      {
+        cerr << "ERROR: Read step " << step << " ahead of step " << steps[cc] << " instead of "
+             << readAhead[cc] << "." << endl;
+        return false;
+      }
+    }
+  }
+  return true;
+}
+}
+
+int TestFileSeriesReaderPrefetch(int argc, char* argv[])
+{
+  char* tempDir =
+    vtkTestUtilities::GetArgOrEnvOrDefault("-T", argc, argv, "VTK_TEMP_DIR", "Testing/Temporary");
+  if (!tempDir)
+  {
+    cerr << "ERROR: Could not determine temporary directory." << endl;
+    return EXIT_FAILURE;
+  }
+  const std::string prefix = std::string(tempDir) + "/TestFileSeriesReaderPrefetch_";
+  delete[] tempDir;
+
+  vtkClientServerInterpreterInitializer::GetGlobalInterpreter()->AddCommandFunction(
+    "vtkLoggingXMLPolyDataReader", vtkLoggingXMLPolyDataReaderCommand);
+
+  vtkNew<vtkLoggingXMLPolyDataReader> reader;
+  ForegroundReader = reader;
+  vtkNew<vtkFileSeriesReader> series;
+  series->SetReader(reader);
+  series->SetFileNameMethod("SetFileName");
+  for (int cc = 0; cc < NumberOfFiles; cc++)
+  {
+    const std::string fileName = prefix + std::to_string(cc) + ".vtp";
+    if (!WriteStep(fileName, cc))
+    {
+      cerr << "ERROR: Could not write '" << fileName << "'." << endl;
+      return EXIT_FAILURE;
+    }
+    series->AddFileName(fileName.c_str());
+  }
+
+  std::vector<int> forward, nextSteps;
+  for (int cc = 0; cc < NumberOfFiles; cc++)
+  {
+    forward.push_back(cc);
+    nextSteps.push_back(cc + 1 < NumberOfFiles ? cc + 1 : -1);
+  }
+
+  // every time step is read when requested.
+  if (!Play(series, forward) || GetForegroundReads() != forward ||
+    !GetBackgroundReads().empty())
+  {
+    cerr << "ERROR: Wrong time steps read without prefetching." << endl;
+    return EXIT_FAILURE;
+  }
+
+  // the next time step is read ahead, and used when requested.
+  ClearReads();
+  series->PrefetchOn();
+  if (!Play(series, forward, nextSteps) || GetForegroundReads() != std::vector<int>{ 0 } ||
+    GetBackgroundReads().size() != forward.size() - 1)
+  {
+    cerr << "ERROR: Wrong time steps read with prefetching." << endl;
+    return EXIT_FAILURE;
+  }
+
+  // the time steps are read ahead backward once the time goes backward.
+  ClearReads();
+  if (!Play(series, { 3, 2, 1, 0 }, { 2, 1, 0, -1 }) ||
+    GetForegroundReads() != std::vector<int>{ 3 })
+  {
+    cerr << "ERROR: Wrong time steps read when going backward." << endl;
+    return EXIT_FAILURE;
+  }
+
+  // the prefetched time step is not used once the reader is modified, and
+  // the time step prefetched after the modification uses the new selection.
+  ClearReads();
+  if (!Play(series, { 5 }, { 6 }))
+  {
+    return EXIT_FAILURE;
+  }
+  reader->SetPointArrayStatus("B", 0);
+  if (!Play(series, { 6 }, { 7 }) || GetForegroundReads() != std::vector<int>{ 5, 6 })
+  {
+    cerr << "ERROR: Prefetched time step used after the reader was modified." << endl;
+    return EXIT_FAILURE;
+  }
+  if (!HasPointArray(series, "A") || HasPointArray(series, "B"))
+  {
+    cerr << "ERROR: Wrong point arrays after deselecting 'B'." << endl;
+    return EXIT_FAILURE;
+  }
+  if (!Play(series, { 7 }) || GetForegroundReads() != std::vector<int>{ 5, 6 })
+  {
+    cerr << "ERROR: Time step 7 was not prefetched." << endl;
+    return EXIT_FAILURE;
+  }
+  if (!HasPointArray(series, "A") || HasPointArray(series, "B"))
+  {
+    cerr << "ERROR: Prefetched time step does not follow the array selection of the reader."
+         << endl;
+    return EXIT_FAILURE;
+  }
+
+  // the time jumps while a time step may still be read ahead.
+  if (!Play(series, { 3, 2, 1, 7, 8, 0, 9, 9, 4 }))
+  {
+    cerr << "ERROR: Wrong time step when the time jumps." << endl;
+    return EXIT_FAILURE;
+  }
+
+  series->PrefetchOff();
+  return EXIT_SUCCESS;
+}
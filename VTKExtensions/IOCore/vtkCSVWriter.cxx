@@ -28,14 +28,20 @@
 #include "vtkPointData.h"
 #include "vtkPointSet.h"
 #include "vtkPolyData.h"
+#include "vtkSMPTools.h"
 #include "vtkSmartPointer.h"
 #include "vtkStreamingDemandDrivenPipeline.h"
 #include "vtkTable.h"
 
 #include "vtksys/FStream.hxx"
 
+#include <algorithm>
+#include <clocale>
+#include <cstdio>
+#include <iomanip>
 #include <numeric>
 #include <sstream>
+#include <type_traits>
 #include <vector>
 
 vtkStandardNewMacro(vtkCSVWriter);
@@ -96,10 +102,146 @@ int vtkCSVWriter::ProcessRequest(
 
 namespace
 {
+//-----------------------------------------------------------------------------
+// Formats values in a string the way an ostream set up with the writer's
+// precision and notation does, without the cost of the stream: numbers are
+// formatted with snprintf, which is what the standard library stream uses,
+// so the output is identical. Types without a fast path go through a stream.
+class vtkCSVWriterBuffer
+{
+public:
+  vtkCSVWriterBuffer(bool scientific, int precision)
+    : Precision(precision)
+    , Format(scientific ? "%.*e" : "%.*g")
+    , Number(static_cast<size_t>(std::min(precision, 1 << 20)) + 32)
+  {
+    // snprintf honors the C locale, streams use the classic locale.
+    const char* point = std::localeconv()->decimal_point;
+    this->DecimalPoint = (point && point[0]) ? point[0] : '.';
+    if (scientific)
+    {
+      this->Fallback << std::scientific;
+    }
+    this->Fallback << std::setprecision(precision);
+  }
+
+  std::string& GetData() { return this->Data; }
+
+  vtkCSVWriterBuffer& operator<<(const char* str)
+  {
+    this->Data.append(str);
+    return *this;
+  }
+  vtkCSVWriterBuffer& operator<<(char* str)
+  {
+    this->Data.append(str);
+    return *this;
+  }
+  vtkCSVWriterBuffer& operator<<(const std::string& str)
+  {
+    this->Data.append(str);
+    return *this;
+  }
+  vtkCSVWriterBuffer& operator<<(char c)
+  {
+    this->Data.push_back(c);
+    return *this;
+  }
+  vtkCSVWriterBuffer& operator<<(signed char c)
+  {
+    this->Data.push_back(static_cast<char>(c));
+    return *this;
+  }
+  vtkCSVWriterBuffer& operator<<(unsigned char c)
+  {
+    this->Data.push_back(static_cast<char>(c));
+    return *this;
+  }
+  vtkCSVWriterBuffer& operator<<(bool b)
+  {
+    this->Data.push_back(b ? '1' : '0');
+    return *this;
+  }
+  template <class T>
+  vtkCSVWriterBuffer& operator<<(const T& value)
+  {
+    this->Append(value, std::is_integral<T>(), std::is_floating_point<T>());
+    return *this;
+  }
+
+private:
+  template <class T>
+  void Append(T value, std::true_type, std::false_type)
+  {
+    char digits[24];
+    char* end = digits + sizeof(digits);
+    char* begin = end;
+    const bool negative = vtkCSVWriterBuffer::IsNegative(value, std::is_signed<T>());
+    do
+    {
+      const int digit = static_cast<int>(value % 10);
+      *--begin = static_cast<char>('0' + (negative ? -digit : digit));
+      value /= 10;
+    } while (value != 0);
+    if (negative)
+    {
+      *--begin = '-';
+    }
+    this->Data.append(begin, end);
+  }
+
+  template <class T>
+  static bool IsNegative(T value, std::true_type)
+  {
+    return value < 0;
+  }
+  template <class T>
+  static bool IsNegative(T, std::false_type)
+  {
+    return false;
+  }
+
+  template <class T>
+  void Append(T value, std::false_type, std::true_type)
+  {
+    int length = std::snprintf(this->Number.data(), this->Number.size(), this->Format,
+      this->Precision, static_cast<double>(value));
+    if (length >= static_cast<int>(this->Number.size()))
+    {
+      this->Number.resize(length + 1);
+      length = std::snprintf(this->Number.data(), this->Number.size(), this->Format,
+        this->Precision, static_cast<double>(value));
+    }
+    if (length > 0)
+    {
+      if (this->DecimalPoint != '.')
+      {
+        std::replace(this->Number.begin(), this->Number.begin() + length, this->DecimalPoint, '.');
+      }
+      this->Data.append(this->Number.data(), length);
+    }
+  }
+
+  template <class T>
+  void Append(const T& value, std::false_type, std::false_type)
+  {
+    this->Fallback.str(std::string());
+    this->Fallback << value;
+    this->Data.append(this->Fallback.str());
+  }
+
+  std::string Data;
+  int Precision;
+  const char* Format;
+  std::vector<char> Number;
+  char DecimalPoint;
+  std::ostringstream Fallback;
+};
+
 //-----------------------------------------------------------------------------
 template <class iterT>
-void vtkCSVWriterGetDataString(
-  iterT* iter, vtkIdType tupleIndex, ostream& stream, vtkCSVWriter* writer, bool* first)
+void vtkCSVWriterGetDataString(iterT* iter, vtkIdType tupleIndex, vtkCSVWriterBuffer& stream,
+  vtkCSVWriter* writer, bool* first)
 {
   int numComps = iter->GetNumberOfComponents();
   vtkIdType index = tupleIndex * numComps;
@@ -120,7 +262,7 @@ void vtkCSVWriterGetDataString(
 //-----------------------------------------------------------------------------
 template <>
 void vtkCSVWriterGetDataString(vtkArrayIteratorTemplate<vtkStdString>* iter, vtkIdType tupleIndex,
-  ostream& stream, vtkCSVWriter* writer, bool* first)
+  vtkCSVWriterBuffer& stream, vtkCSVWriter* writer, bool* first)
 {
   int numComps = iter->GetNumberOfComponents();
   vtkIdType index = tupleIndex * numComps;
@@ -141,7 +283,7 @@ void vtkCSVWriterGetDataString(vtkArrayIteratorTemplate<vtkStdString>* iter, vtk
 //-----------------------------------------------------------------------------
 template <>
 void vtkCSVWriterGetDataString(vtkArrayIteratorTemplate<char>* iter, vtkIdType tupleIndex,
-  ostream& stream, vtkCSVWriter* writer, bool* first)
+  vtkCSVWriterBuffer& stream, vtkCSVWriter* writer, bool* first)
 {
   int numComps = iter->GetNumberOfComponents();
   vtkIdType index = tupleIndex * numComps;
@@ -161,8 +303,8 @@ void vtkCSVWriterGetDataString(vtkArrayIteratorTemplate<char>* iter, vtkIdType t
 
 //-----------------------------------------------------------------------------
 template <>
-void vtkCSVWriterGetDataString(vtkArrayIteratorTemplate<unsigned char>* iter, vtkIdType tupleIndex,
-  ostream& stream, vtkCSVWriter* writer, bool* first)
+void vtkCSVWriterGetDataString(vtkArrayIteratorTemplate<unsigned char>* iter,
+  vtkIdType tupleIndex, vtkCSVWriterBuffer& stream, vtkCSVWriter* writer, bool* first)
 {
   int numComps = iter->GetNumberOfComponents();
   vtkIdType index = tupleIndex * numComps;
@@ -258,14 +400,6 @@ public:
       }
     }
     this->Stream << "\n";
-
-    // push the floating point precision/notation type.
-    if (self->GetUseScientificNotation())
-    {
-      this->Stream << std::scientific;
-    }
-
-    this->Stream << std::setprecision(self->GetPrecision());
   }
 
   void WriteData(vtkTable* table, vtkCSVWriter* self)
@@ -288,14 +422,47 @@ public:
       iter->FastDelete();
     }
 
-    const auto num_tuples = dsa->GetNumberOfTuples();
-    for (vtkIdType cc = 0; cc < num_tuples; ++cc)
+    // Rows are formatted concurrently in chunks, each chunk in its own buffer,
+    // and the buffers are written in order. Chunks are processed in batches to
+    // bound the memory used by the buffers.
+    const vtkIdType num_tuples = dsa->GetNumberOfTuples();
+    const vtkIdType chunk_size = 8192;
+    const vtkIdType num_chunks = (num_tuples + chunk_size - 1) / chunk_size;
+    const vtkIdType batch_size = 4 * std::max(vtkSMPTools::GetEstimatedNumberOfThreads(), 1);
+    std::vector<std::string> buffers(std::min(batch_size, num_chunks));
+    for (vtkIdType batch = 0; batch < num_chunks; batch += batch_size)
+    {
+      const vtkIdType batch_end = std::min(batch + batch_size, num_chunks);
+      vtkSMPTools::For(batch, batch_end, 1, [&](vtkIdType begin, vtkIdType end) {
+        vtkCSVWriterBuffer stream(self->GetUseScientificNotation(), self->GetPrecision());
+        for (vtkIdType chunk = begin; chunk < end; ++chunk)
+        {
+          std::string& data = stream.GetData();
+          data.swap(buffers[chunk - batch]);
+          data.clear();
+          this->WriteRows(columnsIters, chunk * chunk_size,
+            std::min((chunk + 1) * chunk_size, num_tuples), stream, self);
+          data.swap(buffers[chunk - batch]);
+        }
+      });
+      for (vtkIdType chunk = batch; chunk < batch_end; ++chunk)
+      {
+        const std::string& data = buffers[chunk - batch];
+        this->Stream.write(data.data(), static_cast<std::streamsize>(data.size()));
+      }
+    }
+  }
+
+  void WriteRows(const std::vector<vtkSmartPointer<vtkArrayIterator> >& columnsIters,
+    vtkIdType begin, vtkIdType end, vtkCSVWriterBuffer& stream, vtkCSVWriter* self)
+  {
+    for (vtkIdType cc = begin; cc < end; ++cc)
     {
       bool first_column = true;
       if (!vtkMath::IsNan(this->Time))
       {
         // add a time column.
-        this->Stream << this->Time;
+        stream << this->Time;
         first_column = false;
       }
 
@@ -304,10 +471,10 @@ public:
         switch (iter->GetDataType())
         {
           vtkArrayIteratorTemplateMacro(vtkCSVWriterGetDataString(
-            static_cast<VTK_TT*>(iter.GetPointer()), cc, this->Stream, self, &first_column));
+            static_cast<VTK_TT*>(iter.GetPointer()), cc, stream, self, &first_column));
         }
       }
-      this->Stream << "\n";
+      stream << "\n";
     }
   }
 
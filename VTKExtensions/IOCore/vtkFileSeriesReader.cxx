@@ -27,6 +27,8 @@
 #include "vtkClientServerInterpreter.h"
 #include "vtkClientServerInterpreterInitializer.h"
 #include "vtkClientServerStream.h"
+#include "vtkDataArraySelection.h"
+#include "vtkDataObject.h"
 #include "vtkGenericDataObjectReader.h"
 #include "vtkInformation.h"
 #include "vtkInformationIntegerKey.h"
@@ -37,6 +39,7 @@
 #include "vtkStreamingDemandDrivenPipeline.h"
 #include "vtkStringArray.h"
 #include "vtkTypeTraits.h"
+#include "vtkXMLReader.h"
 
 #include "vtksys/FStream.hxx"
 #include "vtksys/SystemTools.hxx"
@@ -45,7 +48,9 @@
 #define VTK_CREATE(type, name) vtkSmartPointer<type> name = vtkSmartPointer<type>::New()
 
 #include <algorithm>
+#include <chrono>
 #include <ctype.h> // for isprint().
+#include <future>
 #include <map>
 #include <set>
 #include <string>
@@ -360,6 +365,61 @@ private:
 };
 }
 
+//=============================================================================
+// A time step as requested from the reader.
+struct vtkFileSeriesReaderTimeStep
+{
+  int Index = -1;
+  std::string FileName;
+  bool HasTime = false;
+  double Time = 0.0;
+  int Piece = -1;
+  int NumberOfPieces = 1;
+  int GhostLevels = 0;
+  bool HasExtent = false;
+  int Extent[6] = { 0, -1, 0, -1, 0, -1 };
+  // MTime of the meta-reader, which includes the changes of its reader but
+  // not of its file name, when the time step was read.
+  vtkMTimeType MTime = 0;
+
+  void Set(int index, const char* fileName, vtkInformation* outInfo)
+  {
+    this->Index = index;
+    this->FileName = fileName ? fileName : "";
+    this->HasTime = outInfo->Has(vtkStreamingDemandDrivenPipeline::UPDATE_TIME_STEP()) != 0;
+    this->Time =
+      this->HasTime ? outInfo->Get(vtkStreamingDemandDrivenPipeline::UPDATE_TIME_STEP()) : 0.0;
+    if (outInfo->Has(vtkStreamingDemandDrivenPipeline::UPDATE_PIECE_NUMBER()))
+    {
+      this->Piece = outInfo->Get(vtkStreamingDemandDrivenPipeline::UPDATE_PIECE_NUMBER());
+    }
+    if (outInfo->Has(vtkStreamingDemandDrivenPipeline::UPDATE_NUMBER_OF_PIECES()))
+    {
+      this->NumberOfPieces =
+        outInfo->Get(vtkStreamingDemandDrivenPipeline::UPDATE_NUMBER_OF_PIECES());
+    }
+    if (outInfo->Has(vtkStreamingDemandDrivenPipeline::UPDATE_NUMBER_OF_GHOST_LEVELS()))
+    {
+      this->GhostLevels =
+        outInfo->Get(vtkStreamingDemandDrivenPipeline::UPDATE_NUMBER_OF_GHOST_LEVELS());
+    }
+    this->HasExtent = outInfo->Has(vtkStreamingDemandDrivenPipeline::UPDATE_EXTENT()) != 0;
+    if (this->HasExtent)
+    {
+      outInfo->Get(vtkStreamingDemandDrivenPipeline::UPDATE_EXTENT(), this->Extent);
+    }
+  }
+
+  bool IsSameRequest(const vtkFileSeriesReaderTimeStep& other) const
+  {
+    return this->Index == other.Index && this->FileName == other.FileName &&
+      this->HasTime == other.HasTime && this->Time == other.Time && this->Piece == other.Piece &&
+      this->NumberOfPieces == other.NumberOfPieces && this->GhostLevels == other.GhostLevels &&
+      this->HasExtent == other.HasExtent &&
+      (!this->HasExtent || std::equal(this->Extent, this->Extent + 6, other.Extent));
+  }
+};
+
 //=============================================================================
 struct vtkFileSeriesReaderInternals
 {
@@ -368,6 +428,20 @@ struct vtkFileSeriesReaderInternals
   std::vector<double> TimeValues;
   bool FileNameIsSet;
   vtkFileSeriesReaderTimeRanges* TimeRanges;
+
+  // The reader of the time steps read in the background, and the time step
+  // being read, or read, by it.
+  vtkSmartPointer<vtkXMLReader> PrefetchReader;
+  vtkFileSeriesReaderTimeStep Prefetched;
+  std::future<int> Reading;
+
+  // The last time step requested and the direction of the last time change.
+  vtkFileSeriesReaderTimeStep Last;
+  int Direction = 1;
+
+  // Waits for the time step being prefetched, if any, and returns whether it
+  // was read.
+  int WaitForPrefetch() { return this->Reading.valid() ? this->Reading.get() : 0; }
 };
 
 //=============================================================================
@@ -384,11 +458,14 @@ vtkFileSeriesReader::vtkFileSeriesReader()
   this->UseJsonMetaFile = false;
 
   this->IgnoreReaderTime = false;
+  this->Prefetch = false;
 }
 
 //-----------------------------------------------------------------------------
 vtkFileSeriesReader::~vtkFileSeriesReader()
 {
+  // The time step being read must not outlive its reader.
+  this->Internal->WaitForPrefetch();
   delete this->Internal->TimeRanges;
   delete this->Internal;
 }
@@ -702,9 +779,18 @@ int vtkFileSeriesReader::RequestData(
   // readers (e.g. the Exodus reader) reuse this array to get time indices.
   // Just in case, restore the vector.
   vtkInformation* outInfo = outputVector->GetInformationObject(requestFromPort);
+  std::vector<double> timeSteps;
+  if (this->Prefetch && outInfo->Has(vtkStreamingDemandDrivenPipeline::TIME_STEPS()))
+  {
+    double* steps = outInfo->Get(vtkStreamingDemandDrivenPipeline::TIME_STEPS());
+    int numSteps = outInfo->Length(vtkStreamingDemandDrivenPipeline::TIME_STEPS());
+    timeSteps.assign(steps, steps + numSteps);
+  }
   this->Internal->TimeRanges->GetInputTimeInfo(this->_FileIndex, outInfo);
 
-  int retVal = this->Reader->ProcessRequest(request, inputVector, outputVector);
+  int retVal = this->UsePrefetchedTimeStep(outInfo)
+    ? 1
+    : this->Reader->ProcessRequest(request, inputVector, outputVector);
 
   if (this->GetNumberOfFileNames() > 0)
   {
@@ -712,9 +798,126 @@ int vtkFileSeriesReader::RequestData(
     this->Internal->TimeRanges->GetAggregateTimeInfo(outInfo);
   }
 
+  if (retVal && this->Prefetch)
+  {
+    this->PrefetchNextTimeStep(outInfo, timeSteps);
+  }
+
   return retVal;
 }
 
+//-----------------------------------------------------------------------------
+bool vtkFileSeriesReader::UsePrefetchedTimeStep(vtkInformation* outInfo)
+{
+  vtkFileSeriesReaderInternals* internal = this->Internal;
+  if (!this->Prefetch || !internal->Reading.valid())
+  {
+    return false;
+  }
+
+  vtkFileSeriesReaderTimeStep requested;
+  requested.Set(this->_FileIndex, this->GetCurrentFileName(), outInfo);
+  if (!requested.IsSameRequest(internal->Prefetched))
+  {
+    // The time jumped, the time step being prefetched is not the one needed.
+    return false;
+  }
+
+  // Wait for the time step if it is still being read. It is not used if the
+  // meta-reader or its reader were modified since, e.g. arrays were selected.
+  // BeforeFileNameMTime is the MTime at the start of this request, before
+  // the file name of the reader was changed.
+  if (!internal->WaitForPrefetch() || internal->Prefetched.MTime != this->BeforeFileNameMTime)
+  {
+    return false;
+  }
+
+  vtkDataObject* prefetched = internal->PrefetchReader->GetOutputDataObject(0);
+  vtkDataObject* output = vtkDataObject::GetData(outInfo);
+  if (!prefetched || !output || !output->IsA(prefetched->GetClassName()))
+  {
+    return false;
+  }
+  // The next time step is read in the same data object as soon as this one
+  // is returned, it cannot be shared with the output.
+  output->DeepCopy(prefetched);
+  output->GetInformation()->CopyEntry(
+    prefetched->GetInformation(), vtkDataObject::DATA_TIME_STEP());
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+void vtkFileSeriesReader::PrefetchNextTimeStep(
+  vtkInformation* outInfo, const std::vector<double>& timeSteps)
+{
+  vtkFileSeriesReaderInternals* internal = this->Internal;
+  vtkFileSeriesReaderTimeStep current;
+  current.Set(this->_FileIndex, this->GetCurrentFileName(), outInfo);
+
+  // Follow the direction of the last time change, forward at first.
+  if (current.HasTime && internal->Last.HasTime && current.Time != internal->Last.Time)
+  {
+    internal->Direction = current.Time > internal->Last.Time ? 1 : -1;
+  }
+  internal->Last = current;
+  vtkXMLReader* reader = vtkXMLReader::SafeDownCast(this->Reader);
+  if (!current.HasTime || timeSteps.empty() || this->GetNumberOfOutputPorts() != 1 || !reader)
+  {
+    return;
+  }
+
+  if (internal->Reading.valid())
+  {
+    // A time step that was not requested is still being read. Do not wait
+    // for it, prefetch again after the next request.
+    if (internal->Reading.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+    {
+      return;
+    }
+    internal->Reading.get();
+  }
+
+  // The current time step is the last one at or before the requested time.
+  const int numberOfSteps = static_cast<int>(timeSteps.size());
+  const auto after = std::upper_bound(timeSteps.begin(), timeSteps.end(), current.Time);
+  const int step = std::max(static_cast<int>(after - timeSteps.begin()) - 1, 0);
+  const int nextStep = step + internal->Direction;
+  if (nextStep < 0 || nextStep >= numberOfSteps)
+  {
+    return;
+  }
+
+  vtkFileSeriesReaderTimeStep next = current;
+  next.Time = timeSteps[nextStep];
+  next.Index = internal->TimeRanges->GetIndexForTime(next.Time);
+  if (next.Index < 0 || next.Index >= static_cast<int>(this->GetNumberOfFileNames()))
+  {
+    return;
+  }
+  next.FileName = this->GetFileName(next.Index);
+
+  // No time step is being read: the prefetch reader can be created, or
+  // configured like the reader.
+  if (!internal->PrefetchReader || !internal->PrefetchReader->IsA(reader->GetClassName()))
+  {
+    internal->PrefetchReader.TakeReference(vtkXMLReader::SafeDownCast(reader->NewInstance()));
+  }
+  vtkXMLReader* prefetchReader = internal->PrefetchReader;
+  prefetchReader->GetPointDataArraySelection()->CopySelections(
+    reader->GetPointDataArraySelection());
+  prefetchReader->GetCellDataArraySelection()->CopySelections(reader->GetCellDataArraySelection());
+  prefetchReader->GetColumnArraySelection()->CopySelections(reader->GetColumnArraySelection());
+  prefetchReader->SetActiveTimeDataArrayName(reader->GetActiveTimeDataArrayName());
+  this->ReaderSetFileName(prefetchReader, next.FileName.c_str());
+  next.MTime = this->BeforeFileNameMTime;
+  internal->Prefetched = next;
+
+  internal->Reading = std::async(std::launch::async, [prefetchReader, next]() {
+    return prefetchReader->UpdateTimeStep(next.Time, next.Piece, next.NumberOfPieces,
+      next.GhostLevels, next.HasExtent ? next.Extent : nullptr);
+  });
+}
+
 //-----------------------------------------------------------------------------
 int vtkFileSeriesReader::RequestInformationForInput(
   int index, vtkInformation* request, vtkInformationVector* outputVector)
@@ -962,6 +1165,7 @@ void vtkFileSeriesReader::PrintSelf(ostream& os, vtkIndent indent)
      << endl;
   os << indent << "UseMetaFile: " << this->UseMetaFile << endl;
   os << indent << "IgnoreReaderTime: " << this->IgnoreReaderTime << endl;
+  os << indent << "Prefetch: " << this->Prefetch << endl;
 }
 
 //-----------------------------------------------------------------------------
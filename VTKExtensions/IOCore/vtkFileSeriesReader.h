@@ -153,6 +153,22 @@ public:
   vtkBooleanMacro(IgnoreReaderTime, bool);
   //@}
 
+  //@{
+  /**
+   * If true, the next time step is read on a background thread while the
+   * current one is processed, e.g. when playing an animation. After a time
+   * step has been read, the following one in the direction of the last time
+   * change is read by a second reader, created from Reader, and it is copied
+   * to the output without reading if it is the next one requested. Only one
+   * time step is read ahead. Prefetching is only done when Reader is a
+   * vtkXMLReader, whose array selections and time array are copied to the
+   * second reader. False by default.
+   */
+  vtkGetMacro(Prefetch, bool);
+  vtkSetMacro(Prefetch, bool);
+  vtkBooleanMacro(Prefetch, bool);
+  //@}
+
   // Expose number of files, first filename and current file number as
   // information keys for potential use in the internal reader
   static vtkInformationIntegerKey* FILE_SERIES_NUMBER_OF_FILES();
@@ -235,6 +251,20 @@ protected:
 
   int ChooseInput(vtkInformation*);
 
+  /**
+   * Copies the prefetched time step to the output if it is the one requested
+   * in outInfo. Returns false otherwise.
+   */
+  bool UsePrefetchedTimeStep(vtkInformation* outInfo);
+
+  /**
+   * Starts reading, in the background, the time step following the one
+   * requested in outInfo among timeSteps.
+   */
+  void PrefetchNextTimeStep(vtkInformation* outInfo, const std::vector<double>& timeSteps);
+
+  bool Prefetch;
+
 private:
   vtkFileSeriesReader(const vtkFileSeriesReader&) = delete;
   void operator=(const vtkFileSeriesReader&) = delete;
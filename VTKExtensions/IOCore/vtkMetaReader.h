@@ -107,6 +107,7 @@ protected:
   vtkGetMacro(_FileIndex, vtkIdType);
 
   void ReaderSetFileName(const char* filename);
+  void ReaderSetFileName(vtkAlgorithm* reader, const char* filename);
   int ReaderCanReadFile(const char* filename);
 
   /**
@@ -184,6 +184,32 @@ def get_logs() :
             alog.lines = timerInfo.GetLog(i).split('\n');
             logs.append(alog)
 
+def enable_trace(enable=True) :
+    """
+    Enables the binary event recorder on all processes. Unlike the timer logs,
+    the recorded events can be exported with dump_trace() as a Chrome
+    trace-event file, with one track per rank and thread.
+    """
+    pxm = paraview.servermanager.ProxyManager()
+    recorder = pxm.NewProxy("misc", "TraceRecorder")
+    recorder.GetProperty("Enable").SetElements1(1 if enable else 0)
+    recorder.UpdateVTKObjects()
+
+def dump_trace( filename ) :
+    """
+    Gathers the events recorded on all server processes since enable_trace()
+    and writes them to filename in the Chrome trace-event JSON format, which
+    can be opened in chrome://tracing or https://ui.perfetto.dev.
+    """
+    pm = paraview.servermanager.vtkProcessModule.GetProcessModule()
+    if pm == None:
+        return False
+
+    session = paraview.servermanager.ActiveConnection.Session
+    traceInfo = paraview.servermanager.vtkPVTraceInformation()
+    session.GatherInformation(session.SERVERS, traceInfo, 0)
+    return traceInfo.WriteChromeTrace(filename)
+
 def print_logs() :
     """
     Print logs on the root node by gathering logs across all the nodes